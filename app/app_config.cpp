@@ -28,6 +28,12 @@ AppConfig load_config(const std::string& path)
       cfg.preferred_gpu = toml::find_or(vulkan, "preferred_gpu", std::string{});
       cfg.present_mode = toml::find_or(vulkan, "present_mode", std::string{ "mailbox" });
       cfg.swapchain_images = toml::find_or<uint32_t>(vulkan, "swapchain_images", 0);
+      cfg.target_frame_ms = toml::find_or<float>(vulkan, "target_frame_ms", 0.0f);
+      cfg.on_demand = toml::find_or<bool>(vulkan, "on_demand", false);
+      cfg.refine_frames = toml::find_or<uint32_t>(vulkan, "refine_frames", 32);
+      cfg.compact_formats = toml::find_or<bool>(vulkan, "compact_formats", true);
+      cfg.async_post_fx = toml::find_or<bool>(vulkan, "async_post_fx", false);
+      cfg.ray_tracing = toml::find_or<bool>(vulkan, "ray_tracing", false);
     }
 
     // [window]
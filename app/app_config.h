@@ -16,6 +16,12 @@ struct AppConfig
   std::string present_mode{ "mailbox" }; // "immediate", "mailbox", "fifo", "fifo_relaxed"
   uint32_t swapchain_images{ 0 };        // 0 = driver default
   uint32_t frames_in_flight{ 0 };        // offscreen ring depth (0 = swapchain count). Lower = less VRAM at high MSAA.
+  float target_frame_ms{ 0.0f };         // dynamic resolution GPU frame-time target (0 = off, full resolution)
+  bool on_demand{ false };               // render only when something changed (idle = no submissions)
+  uint32_t refine_frames{ 32 };          // on-demand: frames still rendered after the last change (TAA convergence)
+  bool compact_formats{ true };          // B10G11R11 HDR / D16 shadows where supported (false = RGBA16F / D32F, for A/B captures)
+  bool async_post_fx{ false };           // run the post-FX chain on a dedicated compute queue (when the GPU has one)
+  bool ray_tracing{ false };             // enable ray tracing (ray-query shadows/reflections in pbr.frag when supported)
 
   // [window]
   std::string window_title{ "vkwave" };
@@ -45,6 +51,11 @@ struct AppConfig
   uint64_t max_frames{ 0 };      // 0 = unlimited, >0 = exit after N frames
   uint64_t screenshot_frame{ 0 }; // 0 = disabled, >0 = auto-capture at frame N (headless verification)
   std::string screenshot_path;    // output PNG path for the auto-capture (empty = timestamped name)
+  uint32_t turntable_views{ 0 };  // >0 = capture an N-view turntable (multiview batches) and exit
+  bool batch{ false };            // render model_paths x hdr_paths (x turntable_views) offline and exit
+  std::string batch_dir;          // output directory for the batch (empty = working directory)
+  std::string reference_path;     // non-empty = path trace the framed view on the CPU to this .hdr and exit
+  uint32_t reference_spp{ 64 };   // samples per pixel of the reference image
   int debug_mode{ -1 };           // -1 = GUI-controlled; >=0 forces PBR debug view (0=Final..7=Clearcoat)
   bool shader_debug{ false };     // emit NonSemantic debug info (real variable names in RenderDoc)
   bool shader_optimize{ false };  // enable SPIR-V optimizer
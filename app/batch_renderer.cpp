@@ -0,0 +1,92 @@
+#include "batch_renderer.h"
+#include "engine.h"
+#include "png_encoder_pool.h"
+#include "scene.h"
+#include "turntable.h"
+
+#include <spdlog/fmt/fmt.h>
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Output name component for an asset path ("" = the built-in fallback).
+static std::string asset_stem(const std::string& path, const char* fallback)
+{
+  return path.empty() ? std::string(fallback) : std::filesystem::path(path).stem().string();
+}
+
+bool render_batch(Engine& app, Scene& scene)
+{
+  const auto& config = app.config;
+  const auto start = std::chrono::steady_clock::now();
+
+  std::vector<std::string> models = config.model_paths;
+  if (models.empty())
+    models.push_back(config.model_path);
+  std::vector<std::string> environments = config.hdr_paths;
+  if (environments.empty())
+    environments.push_back(config.hdr_path);
+
+  const uint32_t views = std::max(config.turntable_views, 1u);
+  std::vector<float> azimuths(views);
+  for (uint32_t i = 0; i < views; ++i)
+    azimuths[i] = 360.0f * static_cast<float>(i) / static_cast<float>(views);
+
+  const std::filesystem::path out_dir = config.batch_dir.empty() ? "." : config.batch_dir;
+  std::filesystem::create_directories(out_dir);
+
+  TurntableRenderer renderer(app, scene);
+  if (!renderer.valid())
+    return false;
+
+  // Bake every environment once up front. Activating one swaps it into
+  // SceneData::ibl; the startup IBL, which the graph's descriptors still
+  // reference, is swapped back out afterwards.
+  auto startup_ibl = std::move(scene.data.ibl);
+  std::vector<std::unique_ptr<vkwave::IBL>> ibls;
+  for (const auto& env : environments)
+  {
+    scene.data.load_ibl(*app.device, env);
+    ibls.push_back(std::move(scene.data.ibl));
+  }
+  scene.data.ibl = std::move(startup_ibl);
+
+  PngEncoderPool encoder;
+  spdlog::info("Batch: {} models x {} environments x {} views ({} per multiview batch, "
+    "{} encoder threads) -> {}", models.size(), environments.size(), views,
+    renderer.batch_size(), encoder.thread_count(), out_dir.string());
+
+  std::string loaded = config.model_path;
+  for (size_t m = 0; m < models.size(); ++m)
+  {
+    // The encoders are still busy with the previous model's images here.
+    if (models[m] != loaded)
+    {
+      scene.switch_model(models[m]);
+      loaded = models[m];
+    }
+
+    for (size_t e = 0; e < environments.size(); ++e)
+    {
+      std::swap(scene.data.ibl, ibls[e]);
+      renderer.bind_scene();
+      renderer.render(azimuths,
+        (out_dir / fmt::format("{}_{}", asset_stem(models[m], "cube"),
+          asset_stem(environments[e], "neutral"))).string(),
+        encoder);
+      std::swap(scene.data.ibl, ibls[e]);
+    }
+  }
+  encoder.wait();
+
+  const double seconds = std::chrono::duration<double>(
+    std::chrono::steady_clock::now() - start).count();
+  spdlog::info("Batch: {} images in {:.1f} s",
+    models.size() * environments.size() * views, seconds);
+  return true;
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+struct Engine;
+struct Scene;
+
+/// Offline batch: every model in config.model_paths × every environment in
+/// config.hdr_paths × config.turntable_views cameras (1 = the framed view),
+/// written to config.batch_dir as `<model>_<environment>_NNN.png`.
+///
+/// One process, one device: shaders are compiled and pipelines built once,
+/// each environment is baked once and kept resident for the whole batch, and
+/// per model only the asset loads. Cameras are rendered in multiview batches
+/// (TurntableRenderer). PNG encoding runs on a PngEncoderPool, so it overlaps
+/// loading and rendering the next model.
+///
+/// Call instead of the frame loop, after Scene::build_pipeline(). Returns
+/// false if nothing could be rendered (no multiview).
+bool render_batch(Engine& app, Scene& scene);
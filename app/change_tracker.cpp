@@ -0,0 +1,19 @@
+#include "change_tracker.h"
+
+#include <vkwave/core/camera.h>
+
+bool ChangeTracker::should_render(const vkwave::Camera& camera, bool busy)
+{
+  if (camera.revision() != m_camera_revision)
+  {
+    m_camera_revision = camera.revision();
+    m_quiet_frames = 0;
+  }
+  if (busy)
+    m_quiet_frames = 0;
+
+  if (!active())
+    return false;
+  ++m_quiet_frames;
+  return true;
+}
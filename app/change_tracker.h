@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+
+namespace vkwave { class Camera; }
+
+/// Render-on-demand bookkeeping: decides whether the next frame can change
+/// anything on screen.
+///
+/// Sources of change:
+/// - touch(): input events, resizes, window exposes (GLFW callbacks in main.cpp)
+/// - the camera revision (orbit, dolly, model switch re-framing, ...)
+/// - `busy`: state that must keep frames coming (a held ImGui widget, a
+///   pending screenshot, time-driven content)
+///
+/// After the last change, refine_frames more frames are rendered so temporal
+/// accumulation (TAA history, ImGui hover state) converges, then the loop may
+/// stop submitting: the swapchain keeps showing the last presented image.
+struct ChangeTracker
+{
+  uint32_t refine_frames{ 32 };
+
+  /// Something outside the tracked state changed.
+  void touch() { m_quiet_frames = 0; }
+
+  /// True if the coming frame should be rendered. Counts it as rendered.
+  [[nodiscard]] bool should_render(const vkwave::Camera& camera, bool busy);
+
+  /// True while refining or rendering changes (i.e. not idle).
+  [[nodiscard]] bool active() const { return m_quiet_frames < refine_frames; }
+
+private:
+  uint64_t m_camera_revision{ UINT64_MAX };
+  uint32_t m_quiet_frames{ 0 }; // frames rendered since the last change
+};
@@ -23,6 +23,16 @@ bool parse_cli(int argc, char** argv, AppConfig& config, std::string& config_pat
     parser, "N", "Auto-capture a PNG at frame N then keep running (use with --max-frames)", {"screenshot"});
   args::ValueFlag<std::string> screenshot_out(
     parser, "path", "Output path for --screenshot (default: timestamped name)", {"screenshot-out"});
+  args::ValueFlag<uint32_t> turntable_flag(
+    parser, "N", "Capture an N-view turntable (<prefix>_NNN.png, prefix from --screenshot-out or \"turntable\") and exit", {"turntable"});
+  args::Flag batch_flag(
+    parser, "batch", "Render every model x environment (x --turntable views) to PNGs and exit", {"batch"});
+  args::ValueFlag<std::string> batch_out(
+    parser, "dir", "Output directory for --batch (default: working directory)", {"batch-out"});
+  args::ValueFlag<std::string> reference_flag(
+    parser, "path", "Path trace the framed view on the CPU (ground truth) to a Radiance .hdr and exit", {"reference"});
+  args::ValueFlag<uint32_t> reference_spp_flag(
+    parser, "N", "Samples per pixel for --reference (default: 64)", {"reference-spp"});
   args::ValueFlag<int> debug_mode(
     parser, "N", "Force PBR debug view (0=Final 1=Normals 2=BaseColor 3=Metallic 4=Roughness 5=AO 6=Emissive 7=Clearcoat)", {"debug-mode"});
   args::ValueFlag<float> azimuth_flag(
@@ -39,6 +49,16 @@ bool parse_cli(int argc, char** argv, AppConfig& config, std::string& config_pat
     parser, "borderless", "Run borderless windowed-fullscreen (desktop resolution)", {"borderless"});
   args::ValueFlag<uint32_t> frames_in_flight_flag(
     parser, "N", "Offscreen frames-in-flight / ring depth (0 = swapchain count). Lower cuts VRAM at high MSAA.", {"frames-in-flight"});
+  args::ValueFlag<float> target_ms_flag(
+    parser, "ms", "Dynamic resolution: scale the render resolution to hold this GPU frame time (0 = off)", {"target-ms"});
+  args::Flag on_demand_flag(
+    parser, "on-demand", "Render only when the camera, input or UI changed; idle otherwise", {"on-demand"});
+  args::Flag wide_formats_flag(
+    parser, "wide-formats", "Render to RGBA16F HDR / D32F shadow targets instead of the compact formats (A/B captures)", {"wide-formats"});
+  args::Flag async_post_fx_flag(
+    parser, "async-post-fx", "Run the post-FX chain on a dedicated compute queue when the GPU has one", {"async-post-fx"});
+  args::Flag ray_tracing_flag(
+    parser, "ray-tracing", "Enable ray tracing: ray-query shadows and reflections when the GPU supports them", {"ray-tracing"});
 
   try
   {
@@ -75,6 +95,16 @@ bool parse_cli(int argc, char** argv, AppConfig& config, std::string& config_pat
     config.screenshot_frame = args::get(screenshot_frame);
   if (screenshot_out)
     config.screenshot_path = args::get(screenshot_out);
+  if (turntable_flag)
+    config.turntable_views = args::get(turntable_flag);
+  if (batch_flag)
+    config.batch = true;
+  if (batch_out)
+    config.batch_dir = args::get(batch_out);
+  if (reference_flag)
+    config.reference_path = args::get(reference_flag);
+  if (reference_spp_flag)
+    config.reference_spp = args::get(reference_spp_flag);
   if (debug_mode)
     config.debug_mode = args::get(debug_mode);
   if (azimuth_flag)
@@ -91,6 +121,16 @@ bool parse_cli(int argc, char** argv, AppConfig& config, std::string& config_pat
     config.window_mode = "windowed_fullscreen";
   if (frames_in_flight_flag)
     config.frames_in_flight = args::get(frames_in_flight_flag);
+  if (target_ms_flag)
+    config.target_frame_ms = args::get(target_ms_flag);
+  if (on_demand_flag)
+    config.on_demand = true;
+  if (wide_formats_flag)
+    config.compact_formats = false;
+  if (async_post_fx_flag)
+    config.async_post_fx = true;
+  if (ray_tracing_flag)
+    config.ray_tracing = true;
 
   return true;
 }
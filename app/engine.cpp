@@ -26,7 +26,7 @@ Engine::Engine(const AppConfig& cfg)
   instance.init();
 
   surface.emplace(instance.instance(), window.get());
-  device.emplace(create_device(cfg.preferred_gpu));
+  device.emplace(create_device(cfg.preferred_gpu, cfg.ray_tracing));
   swapchain.emplace(*device, surface->get(), window.width(), window.height(), false,
     parse_present_mode(cfg.present_mode), cfg.swapchain_images);
   graph.emplace(*device);
@@ -34,6 +34,8 @@ Engine::Engine(const AppConfig& cfg)
   // the main lever on GPU memory at high MSAA/resolution. 0 = use swapchain count.
   if (cfg.frames_in_flight > 0)
     graph->set_offscreen_depth(cfg.frames_in_flight);
+  // Per-group GPU timestamps: shown in the UI and drive dynamic resolution.
+  graph->set_gpu_timing(true);
 }
 
 Engine::~Engine()
@@ -79,7 +81,8 @@ bool Engine::handle_resize()
       return true;  // Still minimized — skip frame
   }
 
-  graph->drain();
+  // No drain: the old swapchain and everything size-dependent go to the
+  // device deletion queue while the frames in flight finish.
   swapchain->recreate(w, h);
   graph->resize(*swapchain);
 
@@ -98,7 +101,7 @@ vkwave::ShaderCompiler& Engine::shader_compiler()
   return *m_shader_compiler;
 }
 
-vkwave::Device Engine::create_device(const std::string& preferred_gpu)
+vkwave::Device Engine::create_device(const std::string& preferred_gpu, bool ray_tracing)
 {
   static const char* extensions[] = {
     VK_KHR_SWAPCHAIN_EXTENSION_NAME
@@ -111,7 +114,16 @@ vkwave::Device Engine::create_device(const std::string& preferred_gpu)
   auto physical_device = vkwave::Device::pick_best_physical_device(
     instance, surface->get(), required_features, ext_span, preferred_gpu);
 
+  // Compact HDR targets (B10G11R11) are written by compute as storage images,
+  // and so is the swapchain by the compute composite (no format qualifier).
+  vk::PhysicalDeviceFeatures optional_features{};
+  optional_features.shaderStorageImageExtendedFormats = VK_TRUE;
+  optional_features.shaderStorageImageWriteWithoutFormat = VK_TRUE;
+  // HiZ indirect draws select their primitive's instance transform by
+  // firstInstance; without it the scene skips occlusion culling.
+  optional_features.drawIndirectFirstInstance = VK_TRUE;
+
   return vkwave::Device(
     instance, surface->get(), false, physical_device, ext_span,
-    required_features, {}, false);
+    required_features, optional_features, ray_tracing);
 }
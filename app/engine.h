@@ -39,6 +39,7 @@ struct Engine
   double update_fps();
 
   void poll() { vkwave::Window::poll(); }
+  void wait_events(double timeout_seconds) { vkwave::Window::wait(timeout_seconds); }
   [[nodiscard]] bool should_close() const { return window.should_close(); }
   [[nodiscard]] bool frame_limit_reached() const
   {
@@ -52,7 +53,7 @@ struct Engine
   Engine& operator=(const Engine&) = delete;
 
 private:
-  vkwave::Device create_device(const std::string& preferred_gpu);
+  vkwave::Device create_device(const std::string& preferred_gpu, bool ray_tracing);
   std::shared_ptr<vkwave::ShaderCompiler> m_shader_compiler;
 
   std::chrono::steady_clock::time_point m_fps_time{ std::chrono::steady_clock::now() };
@@ -1,8 +1,13 @@
+#include "batch_renderer.h"
+#include "change_tracker.h"
 #include "engine.h"
 #include "input.h"
+#include "reference_renderer.h"
 #include "scene.h"
 #include "screenshot.h"
+#include "turntable.h"
 
+#include <vkwave/core/format_select.h>
 #include <vkwave/core/renderdoc.h>
 #include <vkwave/pipeline/shader_compiler.h>
 
@@ -25,6 +30,7 @@ struct Callbacks
 {
   Engine* app;
   Input* input;
+  ChangeTracker* changes;
 };
 
 // ---------------------------------------------------------------------------
@@ -91,12 +97,14 @@ int main(int argc, char** argv)
   // Bind RenderDoc to our Vulkan instance so user-defined captures aren't empty.
   vkwave::RenderDoc::set_vulkan_instance(app.instance.instance());
   Input input;
+  ChangeTracker changes;
+  changes.refine_frames = config.refine_frames;
 
   g_window = app.window.get();
 
   // Register GLFW callbacks BEFORE Scene construction so ImGui
   // (init with install_callbacks=true) chains to them automatically.
-  Callbacks ctx{&app, &input};
+  Callbacks ctx{&app, &input, &changes};
   app.window.set_user_ptr(&ctx);
 
   app.window.set_resize_callback([](GLFWwindow* w, int /*width*/, int /*height*/) {
@@ -105,23 +113,42 @@ int main(int argc, char** argv)
     auto* c = static_cast<Callbacks*>(glfwGetWindowUserPointer(w));
     c->app->window.set_resize_pending(
       static_cast<uint32_t>(fb_w), static_cast<uint32_t>(fb_h));
+    c->changes->touch();
   });
 
   glfwSetCursorPosCallback(app.window.get(), [](GLFWwindow* w, double xpos, double ypos) {
     auto* c = static_cast<Callbacks*>(glfwGetWindowUserPointer(w));
     c->input->on_cursor_pos(w, xpos, ypos);
+    c->changes->touch();
   });
 
   glfwSetScrollCallback(app.window.get(), [](GLFWwindow* w, double /*xoffset*/, double yoffset) {
     auto* c = static_cast<Callbacks*>(glfwGetWindowUserPointer(w));
     c->input->on_scroll(w, yoffset);
+    c->changes->touch();
+  });
+
+  // Remaining input only matters to ImGui (which chains to these), but any of
+  // it can change the UI: wake the on-demand loop. Exposes need a re-present.
+  glfwSetMouseButtonCallback(app.window.get(), [](GLFWwindow* w, int, int, int) {
+    static_cast<Callbacks*>(glfwGetWindowUserPointer(w))->changes->touch();
+  });
+  glfwSetKeyCallback(app.window.get(), [](GLFWwindow* w, int, int, int, int) {
+    static_cast<Callbacks*>(glfwGetWindowUserPointer(w))->changes->touch();
+  });
+  glfwSetCharCallback(app.window.get(), [](GLFWwindow* w, unsigned int) {
+    static_cast<Callbacks*>(glfwGetWindowUserPointer(w))->changes->touch();
+  });
+  glfwSetWindowRefreshCallback(app.window.get(), [](GLFWwindow* w) {
+    static_cast<Callbacks*>(glfwGetWindowUserPointer(w))->changes->touch();
   });
 
   Scene scene(app);
 
   // Populate scene data -- explicit, not hidden in a constructor
   scene.data.create_fallback_textures(*app.device);
-  scene.data.load_model(*app.device, app.config.model_path);
+  scene.data.load_model(*app.device, app.config.model_path,
+    !app.config.reference_path.empty());
   // Apply default_hdr_index: override hdr_path from hdr_paths if index is valid
   if (app.config.default_hdr_index >= 0
     && app.config.default_hdr_index < static_cast<int>(app.config.hdr_paths.size()))
@@ -165,6 +192,13 @@ int main(int argc, char** argv)
   // Optional texture LOD bias (for headless mipmapping A/B captures)
   scene.pbr_ctx.mip_bias = app.config.mip_bias;
 
+  // Optional dynamic resolution (GPU frame-time target)
+  if (app.config.target_frame_ms > 0.0f)
+  {
+    scene.dynamic_resolution = true;
+    scene.resolution.settings().target_ms = app.config.target_frame_ms;
+  }
+
   // Fit camera to loaded model bounds
   if (scene.data.gltf_scene.bounds.valid())
   {
@@ -200,14 +234,41 @@ int main(int argc, char** argv)
     static_cast<float>(app.swapchain->extent().width) /
     static_cast<float>(app.swapchain->extent().height));
 
+  // CPU ground truth of the framed view; needs no render pipeline.
+  if (!app.config.reference_path.empty())
+    return render_reference(app, scene) ? EXIT_SUCCESS : EXIT_FAILURE;
+
   // Build rendering pipeline from populated data
   scene.build_pipeline();
   input.bind(scene.data.camera);
 
+  // Offline captures: multiview batches straight to PNG, no frame loop.
+  if (app.config.batch)
+  {
+    const bool ok = render_batch(app, scene);
+    app.graph->drain();
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+  }
+  if (app.config.turntable_views > 0)
+  {
+    const std::string prefix = app.config.screenshot_path.empty()
+      ? std::string("turntable") : app.config.screenshot_path;
+    const bool ok = capture_turntable(app, scene, app.config.turntable_views, prefix);
+    app.graph->drain();
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+  }
+
   spdlog::info("Swapchain images: {}", app.swapchain->image_count());
   spdlog::info("Present mode: {}", vk::to_string(app.swapchain->present_mode()));
   spdlog::info("Display refresh rate: {} Hz", app.window.refresh_rate());
 
+  // Render on demand. Bounded runs (--max-frames, --screenshot) count frames,
+  // so they always render continuously.
+  const bool on_demand = app.config.on_demand &&
+    app.config.max_frames == 0 && app.config.screenshot_frame == 0;
+  if (on_demand)
+    spdlog::info("Render on demand ({} refinement frames)", changes.refine_frames);
+
   while (!app.should_close() && !app.frame_limit_reached())
   {
     app.poll();
@@ -218,6 +279,15 @@ int main(int argc, char** argv)
       continue;
     }
 
+    // Nothing changed and refinement is done: submit nothing, the swapchain
+    // keeps showing the last presented image. The timeout bounds the latency of
+    // a SIGINT/SIGTERM close, which posts no event.
+    if (on_demand && !changes.should_render(scene.data.camera, scene.busy()))
+    {
+      app.wait_events(0.25);
+      continue;
+    }
+
     double avg_fps = app.update_fps();
     scene.update(*app.graph);
     scene.draw_ui(app, avg_fps);
@@ -234,7 +304,8 @@ int main(int argc, char** argv)
     if (scene.screenshot_requested && !scene.screenshot_in_flight && !scene.screenshot_compressing)
     {
       auto extent = app.swapchain->extent();
-      vk::DeviceSize needed = static_cast<vk::DeviceSize>(extent.width) * extent.height * 8;
+      vk::DeviceSize needed = static_cast<vk::DeviceSize>(extent.width) * extent.height
+        * vkwave::texel_size(scene.pipeline->hdr_format);
       scene.ensure_screenshot_readback(needed);
 
       if (!scene.screenshot_fence)
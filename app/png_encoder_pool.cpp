@@ -0,0 +1,71 @@
+#include "png_encoder_pool.h"
+#include "screenshot.h"
+
+#include <algorithm>
+
+PngEncoderPool::PngEncoderPool(uint32_t threads)
+{
+  if (threads == 0)
+    threads = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+  // Two images per worker in flight: enough to keep them fed while the render
+  // thread copies the next batch out.
+  m_max_queued = 2 * static_cast<size_t>(threads);
+  m_workers.reserve(threads);
+  for (uint32_t i = 0; i < threads; ++i)
+    m_workers.emplace_back([this] { run(); });
+}
+
+PngEncoderPool::~PngEncoderPool()
+{
+  {
+    std::lock_guard lock(m_mutex);
+    m_stop = true;
+  }
+  m_changed.notify_all();
+  for (auto& t : m_workers)
+    t.join();
+}
+
+void PngEncoderPool::submit(std::vector<uint8_t> pixels, vk::Format format,
+                            vk::Extent2D extent, std::string filename)
+{
+  {
+    std::unique_lock lock(m_mutex);
+    m_changed.wait(lock, [this] { return m_jobs.size() < m_max_queued; });
+    m_jobs.push_back({ std::move(pixels), format, extent, std::move(filename) });
+  }
+  m_changed.notify_all();
+}
+
+void PngEncoderPool::wait()
+{
+  std::unique_lock lock(m_mutex);
+  m_changed.wait(lock, [this] { return m_jobs.empty() && m_busy == 0; });
+}
+
+void PngEncoderPool::run()
+{
+  for (;;)
+  {
+    Job job;
+    {
+      std::unique_lock lock(m_mutex);
+      m_changed.wait(lock, [this] { return m_stop || !m_jobs.empty(); });
+      // Drain the queue before honouring a stop.
+      if (m_jobs.empty())
+        return;
+      job = std::move(m_jobs.front());
+      m_jobs.pop_front();
+      ++m_busy;
+    }
+    m_changed.notify_all(); // a queue slot freed up
+
+    write_screenshot(encode_png(job.pixels.data(), job.format, job.extent), job.filename);
+
+    {
+      std::lock_guard lock(m_mutex);
+      --m_busy;
+    }
+    m_changed.notify_all();
+  }
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/// Worker threads that tonemap, PNG-compress and write captured images.
+///
+/// For the offline captures (turntable, batch): the render thread copies each
+/// image out of the readback buffer and submit()s it, then goes on loading and
+/// rendering while the workers encode. The queue is bounded, so submit() blocks
+/// once the workers fall behind instead of buffering whole batches of HDR
+/// images.
+class PngEncoderPool
+{
+public:
+  /// @param threads worker count (0 = hardware concurrency - 1, at least 1)
+  explicit PngEncoderPool(uint32_t threads = 0);
+  /// Finishes every queued image, then joins the workers.
+  ~PngEncoderPool();
+
+  PngEncoderPool(const PngEncoderPool&) = delete;
+  PngEncoderPool& operator=(const PngEncoderPool&) = delete;
+
+  /// Queue `pixels` (extent in `format`, as copied from the GPU) for
+  /// encoding to `filename`. Blocks while the queue is full.
+  void submit(std::vector<uint8_t> pixels, vk::Format format,
+              vk::Extent2D extent, std::string filename);
+
+  /// Block until every submitted image is written.
+  void wait();
+
+  [[nodiscard]] uint32_t thread_count() const
+  {
+    return static_cast<uint32_t>(m_workers.size());
+  }
+
+private:
+  struct Job
+  {
+    std::vector<uint8_t> pixels;
+    vk::Format format;
+    vk::Extent2D extent;
+    std::string filename;
+  };
+
+  void run();
+
+  std::vector<std::thread> m_workers;
+  std::deque<Job> m_jobs;
+  std::mutex m_mutex;
+  std::condition_variable m_changed;
+  size_t m_max_queued{ 0 };
+  uint32_t m_busy{ 0 }; // workers encoding a job taken off the queue
+  bool m_stop{ false };
+};
@@ -0,0 +1,61 @@
+#include "reference_renderer.h"
+#include "engine.h"
+#include "scene.h"
+
+#include <vkwave/loaders/ibl.h>
+#include <vkwave/pipeline/path_tracer.h>
+
+#include <spdlog/spdlog.h>
+
+#include <stb_image_write.h>
+
+#include <filesystem>
+
+bool render_reference(Engine& app, Scene& scene)
+{
+  const auto& gltf = scene.data.gltf_scene;
+  if (gltf.indices.empty())
+  {
+    spdlog::error("Reference: no glTF scene geometry to trace");
+    return false;
+  }
+
+  vkwave::PathTracer tracer(gltf.vertices, gltf.indices, gltf.primitives, gltf.materials);
+
+  vkwave::EquirectImage environment;
+  const auto& hdr_path = app.config.hdr_path;
+  if (!hdr_path.empty() && std::filesystem::exists(hdr_path))
+  {
+    environment = vkwave::load_equirect_hdr(hdr_path);
+    tracer.set_environment(&environment);
+  }
+  else
+  {
+    spdlog::warn("Reference: no HDR environment -- escaping rays are black");
+  }
+
+  vkwave::PathTracer::Settings settings;
+  settings.samples_per_pixel = app.config.reference_spp;
+  settings.environment_intensity = scene.data.ibl ? scene.data.ibl->intensity() : 1.0f;
+  settings.sun_direction = scene.pbr_ctx.light_direction;
+  settings.sun_radiance = scene.pbr_ctx.light_color * scene.pbr_ctx.light_intensity;
+
+  const auto extent = app.swapchain->extent();
+  const auto image = tracer.render(scene.data.camera, extent.width, extent.height, settings);
+
+  const auto& stats = tracer.stats();
+  spdlog::info("Reference: BVH {:.1f} ms, render {:.1f} ms, {} rays ({:.2f} Mrays/s), "
+               "{} tiles, {} steals, {} threads",
+    stats.build_ms, stats.render_ms, stats.rays, stats.mrays_per_second(),
+    stats.tiles, stats.steals, stats.threads);
+
+  const auto& path = app.config.reference_path;
+  if (!stbi_write_hdr(path.c_str(), static_cast<int>(extent.width),
+        static_cast<int>(extent.height), 4, image.data()))
+  {
+    spdlog::error("Reference: failed to write {}", path);
+    return false;
+  }
+  spdlog::info("Reference: wrote {}", path);
+  return true;
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+struct Engine;
+struct Scene;
+
+/// CPU ground truth: the scene's framed view path traced by
+/// vkwave::PathTracer at the swapchain extent and config.reference_spp
+/// samples per pixel, written as a linear Radiance .hdr to
+/// config.reference_path (diff it against a raster capture of the same view).
+///
+/// Lit like the raster path: config.hdr_path's equirect at the IBL intensity
+/// plus PBRContext's directional light. Logs the BVH build and traversal
+/// throughput, so it doubles as a benchmark.
+///
+/// Call instead of the frame loop, before Scene::build_pipeline(), with the
+/// model loaded with keep_geometry. Returns false if there is no glTF scene
+/// to trace or the image could not be written.
+bool render_reference(Engine& app, Scene& scene);
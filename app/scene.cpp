@@ -3,8 +3,20 @@
 #include "screenshot.h"
 #include "transmission.h"
 
+#include <vkwave/core/format_select.h>
 #include <vkwave/core/renderdoc.h>
 #include <vkwave/core/swapchain.h>
+#include <vkwave/core/temporal_aa.h>
+#include <vkwave/pipeline/ambient_occlusion.h>
+#include <vkwave/pipeline/clustered_lights.h>
+#include <vkwave/pipeline/compute_composite.h>
+#include <vkwave/pipeline/hiz_culler.h>
+#include <vkwave/pipeline/mip_downsampler.h>
+#include <vkwave/pipeline/post_fx.h>
+#include <vkwave/pipeline/post_fx_passes.h>
+#include <vkwave/pipeline/scene_ray_tracer.h>
+#include <vkwave/pipeline/shadow_cascades.h>
+#include <vkwave/pipeline/temporal_aa.h>
 
 #include <vulkan/vulkan_to_string.hpp>
 
@@ -13,6 +25,9 @@
 #include <spdlog/spdlog.h>
 
 #include <algorithm>
+#include <array>
+#include <cfloat>
+#include <cmath>
 #include <filesystem>
 
 #include <glm/gtc/matrix_transform.hpp>
@@ -48,6 +63,7 @@ void Scene::wire_pbr_context()
 {
   pbr_ctx.group = &pipeline->pbr_group();
   pbr_ctx.mesh = data.active_mesh();
+  pbr_ctx.instance_transforms = pipeline->instance_buffer();
   pbr_ctx.has_transparent = false;
 
   if (data.has_multi_material())
@@ -78,6 +94,12 @@ void Scene::wire_pbr_context()
   blend_pass.ctx = &pbr_ctx;
   composite_pass.group = &pipeline->composite_group();
 
+  // Blended primitives go to the OIT group when it is present (single-sample);
+  // otherwise BlendPass sorts them into the pbr group.
+  oit_pass.ctx = &pbr_ctx;
+  oit_pass.group = pipeline->oit_group();
+  pbr_ctx.weighted_oit = (oit_pass.group != nullptr);
+
   // Transmission shares the scene context; its group is present only for glass.
   transmission_pass.ctx = &pbr_ctx;
   transmission_pass.group = pipeline->transmission_group();
@@ -90,10 +112,74 @@ void Scene::wire_pbr_context()
 
 void Scene::wire_record_callbacks()
 {
+  // Before the scene render pass: redraw the shadow cascades that moved, cull
+  // this frame's lights into the slot's froxel lists, then HiZ phase 0 — cull against last frame's pyramid and
+  // point the opaque draws at this slot's indirect commands. With culling
+  // off/unavailable the context keeps direct draws.
+  pipeline->pbr_group().set_pre_record_fn(
+    [this](vk::CommandBuffer cmd, uint32_t slot_index) {
+      // Stream the slot's instance transforms if the scene graph moved, and
+      // build or refit the TLAS before anything in the frame traces it.
+      pipeline->record_instances(cmd, slot_index);
+      pbr_ctx.instance_transforms_offset = pipeline->instance_offset(slot_index);
+
+      // Ray-traced shadows need no cascades.
+      const bool ray_query = pipeline->ray_query();
+      pbr_ctx.ray_traced_shadows = ray_query && shadows && ray_traced_shadows;
+      pbr_ctx.ray_traced_reflections = ray_query && ray_traced_reflections;
+      ++pbr_ctx.frame_index;
+
+      // Per scene frame, not per display frame (Scene Rate): the motion vectors
+      // reproject against the scene frame rendered last, and the jitter
+      // sequence advances only when a jittered frame is drawn.
+      pbr_ctx.prev_view_projection = rendered_view_projection;
+      rendered_view_projection = pbr_ctx.unjittered_view_projection;
+      ++taa_frame;
+
+      pbr_ctx.shadow = nullptr;
+      if (shadows && !pbr_ctx.ray_traced_shadows)
+      {
+        auto& cascades = pipeline->shadow_cascades();
+        cascades.update(data.camera, pbr_ctx.light_direction);
+        cascades.record(cmd, pbr_ctx, pbr_pass.model);
+        pbr_ctx.shadow = &cascades.uniforms();
+      }
+
+      auto& lights = pipeline->clustered_lights();
+      lights.update(slot_index, gpu_lights, pbr_ctx.view,
+        data.camera.projection_matrix(), pbr_ctx.z_near, pbr_ctx.z_far);
+      lights.record(cmd, slot_index);
+      pbr_ctx.light_count = lights.light_count(slot_index);
+
+      // Shade with the AO resolved in the scene frame before, once there is one.
+      auto* ao = pipeline->ambient_occlusion();
+      pbr_ctx.screen_space_ao = ambient_occlusion && ao && ao->history_ready();
+      pipeline->bind_ao(slot_index, data);
+
+      pbr_ctx.draw_commands = VK_NULL_HANDLE;
+      oit_pass.draw_commands = VK_NULL_HANDLE;
+      // The culler's bounds are the rest pose: no occlusion culling while the
+      // instances move.
+      auto* hiz = pipeline->hiz_culler();
+      if (!occlusion_culling || animate_instances || !hiz || hiz->primitive_count() == 0)
+        return;
+      hiz->record_phase0(cmd, slot_index, pbr_ctx.view_projection,
+        pipeline->pbr_group().render_extent());
+      pbr_ctx.draw_commands = hiz->draw_buffer(slot_index);
+      pbr_ctx.draw_commands_offset = hiz->draw_offset(0);
+      // The OIT group draws later from the same commands, after both phases.
+      oit_pass.draw_commands = pbr_ctx.draw_commands;
+      oit_pass.draw_commands_offset[0] = hiz->draw_offset(0);
+      oit_pass.draw_commands_offset[1] = hiz->draw_offset(1);
+    });
+
+  // With HiZ active, blended primitives are drawn after the disocclusion pass
+  // (post-record) so they composite over the complete opaque result.
   pipeline->pbr_group().set_record_fn(
     [this](vk::CommandBuffer cmd, uint32_t /*frame_index*/) {
       pbr_pass.record(cmd);
-      blend_pass.record(cmd);
+      if (!pbr_ctx.draw_commands)
+        blend_pass.record(cmd);
     });
 
   // Screenshot copy: capture the HDR into the readback buffer and arm the
@@ -106,14 +192,17 @@ void Scene::wire_record_callbacks()
     if (!screenshot_readback)
       return; // buffer not yet allocated — will be ready next frame
 
-    auto extent = group.extent();
-    vk::DeviceSize needed = static_cast<vk::DeviceSize>(extent.width) * extent.height * 8;
+    // Only the rendered region (smaller under dynamic resolution).
+    auto extent = group.render_extent();
+    vk::DeviceSize needed = static_cast<vk::DeviceSize>(extent.width) * extent.height
+      * vkwave::texel_size(pipeline->hdr_format);
     if (screenshot_readback->size() < needed)
       return; // buffer too small — will grow next frame
 
     auto slot = m_engine->graph->last_offscreen_slot();
     auto hdr_image = m_engine->graph->resources().color_image(pipeline->hdr_handle, slot);
-    record_hdr_screenshot_copy(cmd, hdr_image, extent, screenshot_readback->buffer());
+    record_hdr_screenshot_copy(cmd, hdr_image, extent, pipeline->hdr_format,
+      screenshot_readback->buffer());
 
     // Arm the fence — only this copy is serialized, frames keep pipelining
     screenshot_fence->reset();
@@ -122,48 +211,107 @@ void Scene::wire_record_callbacks()
     screenshot_requested = false;
     screenshot_in_flight = true;
     screenshot_extent = extent;
-    screenshot_format = ScenePipeline::kHdrFormat;
+    screenshot_format = pipeline->hdr_format;
+  };
+
+  // Transmission snapshot: the HDR behind the glass plus its mip chain (one
+  // compute dispatch) for the refraction pass's roughness blur — or just a
+  // mip-0 copy without quad subgroup ops. Only when the transmission group is
+  // present to consume it (the snapshot resource may exist at MSAA with no
+  // group). Taken by the last group before the glass.
+  auto record_snapshot = [this](vk::CommandBuffer cmd, vkwave::ExecutionGroup& group) {
+    if (!pipeline->transmission_group() || !pipeline->snapshot_handle)
+      return;
+    auto slot = m_engine->graph->last_offscreen_slot();
+    auto& pool = m_engine->graph->resources();
+    if (auto* mips = pipeline->snapshot_downsampler())
+      mips->record(cmd, slot, group.render_extent());
+    else
+      record_transmission_snapshot_copy(cmd,
+        pool.color_image(pipeline->hdr_handle, slot),
+        pool.color_image(*pipeline->snapshot_handle, slot),
+        group.render_extent());
   };
 
   const bool has_transmission = (pipeline->transmission_group() != nullptr);
+  const bool has_oit = (pipeline->oit_group() != nullptr);
 
-  // PBR post-record: snapshot copy (glass), then the screenshot copy *only* when
-  // there is no transmission pass (otherwise the screenshot runs after glass).
+  // PBR post-record: screen-space AO from the finished opaque depth, then the
+  // snapshot copy (glass) unless the OIT group takes it, then the screenshot
+  // copy *only* when pbr is the last HDR writer (otherwise the screenshot runs
+  // after the transparent / glass layers).
   // Runs after endRenderPass(), before cmd.end(), same command buffer — no extra
   // vkQueueSubmit.
   pipeline->pbr_group().set_post_record_fn(
-    [this, record_screenshot, has_transmission](vk::CommandBuffer cmd, uint32_t /*slot_index*/) {
-      // Transmission snapshot: copy the opaque HDR into the per-slot snapshot the
-      // refraction pass samples. Only when the transmission group is present to
-      // consume it (the snapshot resource may exist at MSAA with no group).
-      if (pipeline->transmission_group() && pipeline->snapshot_handle)
+    [this, record_screenshot, record_snapshot, has_transmission, has_oit](
+      vk::CommandBuffer cmd, uint32_t slot_index) {
+      // HiZ phase 1: build this frame's pyramid from the opaque depth, re-test
+      // the phase-0 occlusion rejects, and draw the disoccluded ones (then the
+      // blended ones) in a LOAD pass over the same attachments.
+      if (pbr_ctx.draw_commands)
       {
-        auto slot = m_engine->graph->last_offscreen_slot();
-        auto& pool = m_engine->graph->resources();
-        record_transmission_snapshot_copy(cmd,
-          pool.color_image(pipeline->hdr_handle, slot),
-          pool.color_image(*pipeline->snapshot_handle, slot),
-          pipeline->pbr_group().extent());
+        auto* hiz = pipeline->hiz_culler();
+        hiz->record_phase1(cmd, slot_index);
+        pbr_ctx.draw_commands_offset = hiz->draw_offset(1);
+        pipeline->pbr_group().begin_renderpass(
+          cmd, slot_index, pipeline->disocclusion_renderpass);
+        pbr_pass.record(cmd);
+        blend_pass.record(cmd);
+        pipeline->pbr_group().end_renderpass(cmd, slot_index);
+        pbr_ctx.draw_commands = VK_NULL_HANDLE;
       }
 
+      // After every opaque draw (both HiZ phases): the next frame shades with it.
+      auto* ao = pipeline->ambient_occlusion();
+      if (ambient_occlusion && ao)
+        ao->record(cmd, slot_index, pipeline->pbr_group().render_extent(),
+          data.camera.jittered_projection_matrix());
+
+      // The ray traced preview overwrites the opaque HDR with the same jitter,
+      // so TAA resolves it like the raster frames.
+      auto* tracer = pipeline->ray_tracer();
+      if (ray_traced_preview && tracer)
+        tracer->record(cmd, slot_index, pipeline->pbr_group().render_extent(),
+          pipeline->tlas_handle(),
+          { glm::inverse(pbr_ctx.view_projection), glm::vec4(pbr_ctx.cam_position, 1.0f) });
+
+      if (has_oit)
+        return;
+      record_snapshot(cmd, pipeline->pbr_group());
       if (!has_transmission)
         record_screenshot(cmd, pipeline->pbr_group());
     });
 
+  // OIT group (present for blended materials at 1x): accumulates every
+  // transparent layer in one unsorted pass, then resolves them over the opaque
+  // HDR in place, so the snapshot, TAA and screenshots all see them.
+  if (auto* oit = pipeline->oit_group())
+  {
+    oit->set_record_fn(
+      [this](vk::CommandBuffer cmd, uint32_t /*frame_index*/) {
+        oit_pass.record(cmd);
+      });
+    oit->set_post_record_fn(
+      [this, record_screenshot, record_snapshot, has_transmission](
+        vk::CommandBuffer cmd, uint32_t /*slot_index*/) {
+        auto* group = pipeline->oit_group();
+        pipeline->oit_resolve()->record(
+          cmd, m_engine->graph->last_offscreen_slot(), group->render_extent());
+        record_snapshot(cmd, *group);
+        if (!has_transmission)
+          record_screenshot(cmd, *group);
+      });
+  }
+
   // Transmission group (present only for glass scenes): draws refractive
   // primitives into the HDR target in its own submission. Its post-record holds
   // the screenshot copy so a captured glass scene includes the transmission.
   if (auto* tr = pipeline->transmission_group())
   {
+    // The snapshot is bound per slot at frame-resource creation
+    // (ScenePipeline::bind_snapshot), so recording writes no descriptors.
     tr->set_record_fn(
-      [this](vk::CommandBuffer cmd, uint32_t frame_index) {
-        // Rebind this slot's snapshot (the opaque scene behind the glass) before
-        // drawing — per-slot, like composite rebinds the HDR each frame.
-        auto slot = m_engine->graph->last_offscreen_slot();
-        pipeline->transmission_group()->write_image_descriptor(
-          0, "snapshotTex", frame_index,
-          m_engine->graph->resources().color_view(*pipeline->snapshot_handle, slot),
-          pipeline->hdr_sampler);
+      [this](vk::CommandBuffer cmd, uint32_t /*frame_index*/) {
         transmission_pass.record(cmd);
       });
     tr->set_post_record_fn(
@@ -172,13 +320,56 @@ void Scene::wire_record_callbacks()
       });
   }
 
+  // Post-FX group: bloom / aberration / vignette over the finished HDR, in
+  // place, before the composite. Compute only (it may be on the async compute
+  // queue). With TAA the chain runs after the resolve instead (composite
+  // pre-record): aberration and vignette are screen-locked and must not be
+  // reprojected with the TAA history. Screenshots stay the scene HDR before it.
+  pipeline->post_fx_group().set_record_fn(
+    [this](vk::CommandBuffer cmd, uint32_t slot_index) {
+      if (taa && pipeline->temporal_aa())
+        return;
+      pipeline->post_fx().record(cmd, slot_index, m_engine->graph->render_extent());
+    });
+
+  // Composite pre-record: the TAA resolve of the finished HDR (after glass), in
+  // the composite submission so it sees every offscreen pass of the frame, then
+  // the post-FX chain on the resolved output (left as the next frame's history;
+  // the chain writes the slot's HDR, which the resolve has consumed). A frame
+  // without a new HDR (the scene groups were gated off) keeps the output
+  // resolved and post-processed when that HDR was rendered.
+  pipeline->composite_group().set_pre_record_fn(
+    [this](vk::CommandBuffer cmd, uint32_t /*frame_index*/) {
+      auto* resolve = pipeline->temporal_aa();
+      if (!taa || !resolve)
+        return;
+      const auto slot = hdr_slot();
+      if (slot != m_engine->graph->last_offscreen_slot())
+        return;
+      resolve->record(cmd, slot, m_engine->graph->render_extent(), data.camera.jitter());
+      // The resolve upscaled: its output covers the whole target.
+      pipeline->post_fx().record(cmd, slot, m_engine->graph->resources().extent(),
+        resolve->output_view());
+    });
+
   pipeline->composite_group().set_record_fn(
     [this](vk::CommandBuffer cmd, uint32_t frame_index) {
-      auto slot = m_engine->graph->last_offscreen_slot();
+      auto slot = hdr_slot();
+      auto* resolve = pipeline->temporal_aa();
+      const vk::ImageView hdr =
+        (taa && resolve && resolve->resolved() && !pipeline->post_fx().wrote_source(slot))
+        ? resolve->output_view()
+        : m_engine->graph->resources().color_view(pipeline->hdr_handle, slot);
+      // Compute composite: the group records no render pass (frame_index is
+      // the swapchain image).
+      if (auto* compute = pipeline->compute_composite())
+      {
+        compute->record(cmd, frame_index, hdr, pipeline->hdr_sampler,
+          composite_pass.uv_scale, m_engine->graph->delta_time());
+        return;
+      }
       pipeline->composite_group().write_image_descriptor(
-        0, "hdrImage", frame_index,
-        m_engine->graph->resources().color_view(pipeline->hdr_handle, slot),
-        pipeline->hdr_sampler);
+        0, "hdrImage", frame_index, hdr, pipeline->hdr_sampler);
       composite_pass.record(cmd);
     });
 
@@ -196,8 +387,15 @@ void Scene::wire_record_callbacks()
 
 void Scene::switch_model(const std::string& model_path)
 {
-  m_engine->graph->drain();
+  // No drain: the old model's buffers and textures, and the descriptor sets
+  // replaced below, are destroyed through the device deletion queue once the
+  // frames in flight have finished with them.
   data.load_model(*m_engine->device, model_path);
+  rest_transforms.clear(); // the old model's
+  if (animate_instances)
+    set_instance_animation(true); // the new model's rest pose
+  pipeline->update_instances(data);
+  pipeline->update_ray_tracing(data);
 
   // Fit camera to new model bounds
   if (data.gltf_scene.bounds.valid())
@@ -207,16 +405,20 @@ void Scene::switch_model(const std::string& model_path)
     data.camera.reset_camera(bounds);
   }
 
-  // If the new model crosses the glass boundary (transmission present <-> absent)
-  // the *pass set* changes — structurally rebuild the graph (adds/removes the
-  // transmission pass + snapshot) and re-wire callbacks. Otherwise the structure
-  // is unchanged, so the lighter descriptor-only rebuild suffices.
-  const bool want_transmission =
-    data.has_transmission() &&
-    pipeline->msaa_samples == vk::SampleCountFlagBits::e1;
-  if (want_transmission != pipeline->has_transmission_pass())
+  // Keep the scattered lights inside the new model's bounds
+  data.scatter_lights(static_cast<uint32_t>(data.scattered_lights.size()));
+
+  // If the new model crosses the glass or blend boundary (transmission / OIT
+  // present <-> absent) the *pass set* changes — structurally rebuild the graph
+  // (adds/removes the pass and its targets) and re-wire callbacks. Otherwise the
+  // structure is unchanged, so the lighter descriptor-only rebuild suffices.
+  const bool single_sample = pipeline->msaa_samples == vk::SampleCountFlagBits::e1;
+  const bool want_transmission = data.has_transmission() && single_sample;
+  const bool want_oit = data.has_blend() && single_sample;
+  if (want_transmission != pipeline->has_transmission_pass() ||
+      want_oit != pipeline->has_oit_pass())
   {
-    pipeline->rebuild_graph(data);   // drains internally
+    pipeline->rebuild_graph(data);
     wire_pbr_context();
     wire_record_callbacks();
   }
@@ -224,20 +426,27 @@ void Scene::switch_model(const std::string& model_path)
   {
     wire_pbr_context();
     pipeline->rebuild_pbr_descriptors(data);
+    pipeline->update_hiz_primitives(data);
+    if (auto* resolve = pipeline->temporal_aa())
+      resolve->reset_history(); // camera cut
+    if (auto* ao = pipeline->ambient_occlusion())
+      ao->reset_history();
   }
+  pipeline->update_shadow_casters(data);
 }
 
 void Scene::switch_ibl(const std::string& hdr_path)
 {
-  m_engine->graph->drain();
-
+  // No drain: the old maps outlive the frames that sample them (deletion
+  // queue), and the groups get fresh descriptor sets instead of rewriting the
+  // ones in flight.
   const bool capture = capture_next_ibl_reload && vkwave::RenderDoc::is_attached();
   capture_next_ibl_reload = false;
   if (capture)
     vkwave::RenderDoc::begin_capture();
 
   data.load_ibl(*m_engine->device, hdr_path);
-  pipeline->write_ibl_descriptors(data);
+  pipeline->rebuild_pbr_descriptors(data);
 
   if (capture)
   {
@@ -250,7 +459,6 @@ void Scene::switch_ibl(const std::string& hdr_path)
 
 void Scene::rebuild_pipeline(vk::SampleCountFlagBits new_samples)
 {
-  m_engine->graph->drain();
   pipeline->rebuild_for_msaa(new_samples, data);
   wire_pbr_context();
   wire_record_callbacks();
@@ -261,6 +469,46 @@ void Scene::resize(const vkwave::Swapchain& swapchain)
   pipeline->resize(swapchain, data);
 }
 
+uint32_t Scene::hdr_slot() const
+{
+  // The last group writing the HDR (post-FX, after every scene group); its
+  // latest submission is complete for the composite (dependency wait), even
+  // when it ran on an earlier frame.
+  return pipeline->post_fx_group().latest_slot();
+}
+
+bool Scene::busy() const
+{
+  // Auto-exposure adapts over wall-clock time, well past a fixed number of
+  // refinement frames after a model switch, camera cut or IBL change.
+  auto* compute = pipeline->compute_composite();
+  return ImGui::IsAnyItemActive() ||
+    screenshot_requested || screenshot_in_flight || screenshot_compressing ||
+    (compute && compute->adapting()) || animate_instances;
+}
+
+void Scene::set_instance_animation(bool enabled)
+{
+  auto& primitives = data.gltf_scene.primitives;
+  animate_instances = enabled && data.has_multi_material();
+  if (animate_instances)
+  {
+    rest_transforms.clear();
+    for (const auto& prim : primitives)
+      rest_transforms.push_back(prim.modelMatrix);
+    return;
+  }
+  if (rest_transforms.size() == primitives.size())
+  {
+    for (size_t i = 0; i < primitives.size(); ++i)
+      primitives[i].modelMatrix = rest_transforms[i];
+    pipeline->move_instances(data);
+  }
+  rest_transforms.clear();
+  if (auto* hiz = pipeline->hiz_culler())
+    hiz->reset_history(); // its last pyramid is of a moved scene
+}
+
 // ---------------------------------------------------------------------------
 // Screenshot readback buffer (grow-only, persistent)
 // ---------------------------------------------------------------------------
@@ -286,9 +534,75 @@ void Scene::update(vkwave::RenderGraph& graph)
   data.camera.set_aspect_ratio(
     static_cast<float>(graph.offscreen_group(0).extent().width) /
     static_cast<float>(graph.offscreen_group(0).extent().height));
-  pbr_ctx.view_projection = data.camera.view_projection_matrix();
+
+  // Dynamic resolution: steer the render scale from the measured GPU time.
+  // Applied every frame, so it also survives group rebuilds (which reset the
+  // groups' render extents).
+  graph.set_render_scale(dynamic_resolution
+    ? resolution.update(graph.gpu_frame_time_ms()) : 1.0f);
+
+  // Multi-rate: the scene groups may run below the display rate; the composite
+  // keeps presenting their latest HDR. Glass renders into the pbr HDR and
+  // post-FX works on it, so they share the gating. Applied every frame, so
+  // rebuilt groups pick it up.
+  const auto gating = scene_hz > 0.0f ? vkwave::GatingMode::wall_clock : vkwave::GatingMode::always;
+  pipeline->pbr_group().set_gating(gating, scene_hz);
+  if (auto* oit = pipeline->oit_group())
+    oit->set_gating(gating, scene_hz);
+  if (auto* tr = pipeline->transmission_group())
+    tr->set_gating(gating, scene_hz);
+  pipeline->post_fx_group().set_gating(gating, scene_hz);
+  const auto target = graph.resources().extent();
+  const auto rendered = graph.render_extent();
+
+  // Temporal AA: shift the projection by a per-frame sub-pixel offset (sized to
+  // this frame's render extent). The pbr pre-record keeps the unjittered
+  // matrix of the scene frame before for the motion vectors.
+  const bool temporal = taa && pipeline->temporal_aa();
+  data.camera.set_jitter(temporal
+    ? vkwave::taa_jitter(taa_frame, rendered) : glm::vec2(0.0f));
+  pbr_ctx.unjittered_view_projection = data.camera.view_projection_matrix();
+  pbr_ctx.view_projection = data.camera.jittered_view_projection_matrix();
   pbr_ctx.cam_position = data.camera.position();
   pbr_ctx.time = graph.elapsed_time();
+
+  pbr_ctx.view = data.camera.view_matrix();
+  pbr_ctx.z_near = data.camera.near_plane();
+  pbr_ctx.z_far = data.camera.far_plane();
+  data.gather_lights(gpu_lights);
+
+  // A larger instance set reallocated the TLAS: the sets still hold the old
+  // handle. Rebuilt here, before the frame records.
+  if (pipeline->tlas_descriptors_stale())
+    pipeline->rebuild_pbr_descriptors(data);
+
+  // Instance animation: bob every primitive about its rest transform.
+  if (animate_instances)
+  {
+    auto& primitives = data.gltf_scene.primitives;
+    const auto& bounds = data.gltf_scene.bounds;
+    const float amplitude = bounds.valid() ? 0.02f * glm::length(bounds.max - bounds.min) : 0.0f;
+    for (size_t i = 0; i < primitives.size(); ++i)
+    {
+      const float phase = 2.0f * graph.elapsed_time() + 0.7f * static_cast<float>(i);
+      primitives[i].modelMatrix = glm::translate(glm::mat4(1.0f),
+        glm::vec3(0.0f, amplitude * std::sin(phase), 0.0f)) * rest_transforms[i];
+    }
+    pipeline->move_instances(data);
+  }
+
+  // The TAA output (and the post-FX chain's copy of it) is always target-sized:
+  // the resolve already did the upscale.
+  composite_pass.uv_scale = temporal ? glm::vec2(1.0f) : glm::vec2(
+    static_cast<float>(rendered.width) / static_cast<float>(std::max(target.width, 1u)),
+    static_cast<float>(rendered.height) / static_cast<float>(std::max(target.height, 1u)));
+
+  // The compute composite shares the fragment composite's controls.
+  if (auto* compute = pipeline->compute_composite())
+  {
+    compute->settings().exposure = composite_pass.exposure;
+    compute->settings().tonemap_mode = composite_pass.tonemap_mode;
+  }
 }
 
 // ---------------------------------------------------------------------------
@@ -299,7 +613,7 @@ void Scene::draw_ui(Engine& app, double avg_fps)
 {
   pipeline->imgui->new_frame();
   ImGui::Begin("vkwave");
-  ImGui::Text("%.0f fps", avg_fps);
+  ImGui::Text("%.0f fps, GPU %.2f ms", avg_fps, app.graph->gpu_frame_time_ms());
   ImGui::Separator();
 
   // Display settings
@@ -330,7 +644,6 @@ void Scene::draw_ui(Engine& app, double avg_fps)
         {
           if (entry.mode != current_mode)
           {
-            app.graph->drain();
             app.swapchain->set_preferred_present_mode(entry.mode);
             app.swapchain->recreate(app.window.width(), app.window.height());
             app.graph->resize(*app.swapchain);
@@ -394,7 +707,8 @@ void Scene::draw_ui(Engine& app, double avg_fps)
   // PBR debug modes
   const char* debug_modes[] = {
     "Final", "Normals", "Base Color", "Metallic",
-    "Roughness", "AO", "Emissive", "Clearcoat", "Anisotropy"
+    "Roughness", "AO", "Emissive", "Clearcoat", "Anisotropy",
+    "Shadow Cascades"
   };
   ImGui::Combo("Debug Mode", &pbr_ctx.debug_mode, debug_modes, IM_ARRAYSIZE(debug_modes));
 
@@ -405,7 +719,168 @@ void Scene::draw_ui(Engine& app, double avg_fps)
     "ACES + Boost", "Khronos PBR Neutral"
   };
   ImGui::Combo("Tonemap", &composite_pass.tonemap_mode, tonemap_modes, IM_ARRAYSIZE(tonemap_modes));
-  ImGui::SliderFloat("Exposure", &composite_pass.exposure, 0.1f, 5.0f);
+  if (auto* compute = pipeline->compute_composite())
+  {
+    // Histogram-driven exposure; the slider is then a compensation on top.
+    auto& settings = compute->settings();
+    ImGui::Checkbox("Auto Exposure", &settings.auto_exposure);
+    ImGui::SliderFloat("Exposure", &composite_pass.exposure, 0.1f, 5.0f);
+    if (settings.auto_exposure)
+    {
+      ImGui::SliderFloat("Adaptation (1/s)", &settings.adaptation_speed, 0.1f, 10.0f);
+      const auto& stats = compute->statistics();
+      ImGui::Text("Exposure %.3f, avg luminance %.4f", stats.exposure,
+        std::exp2(stats.averageLog2));
+      std::array<float, vkwave::kExposureHistogramBins> bins{};
+      for (size_t i = 1; i < bins.size(); ++i) // bin 0 is black
+        bins[i] = static_cast<float>(stats.histogram[i]);
+      ImGui::PlotHistogram("##luminance", bins.data(), static_cast<int>(bins.size()), 0,
+        "log2 luminance", 0.0f, FLT_MAX, ImVec2(0.0f, 60.0f));
+    }
+  }
+  else
+    ImGui::SliderFloat("Exposure", &composite_pass.exposure, 0.1f, 5.0f);
+
+  // Dynamic resolution
+  ImGui::Separator();
+  if (ImGui::Checkbox("Dynamic Resolution", &dynamic_resolution))
+    resolution.reset();
+  if (dynamic_resolution)
+  {
+    auto& settings = resolution.settings();
+    ImGui::SliderFloat("Target (ms)", &settings.target_ms, 2.0f, 50.0f);
+    ImGui::SliderFloat("Min Scale", &settings.min_scale, 0.25f, 1.0f);
+  }
+  const auto rendered = app.graph->render_extent();
+  ImGui::Text("Render %ux%u (%.0f%%)", rendered.width, rendered.height,
+    app.graph->render_scale() * 100.0f);
+
+  // Multi-rate: render the scene below the display rate (0 = every frame).
+  ImGui::SliderFloat("Scene Rate (Hz)", &scene_hz, 0.0f, 120.0f, "%.0f");
+
+  // Temporal AA: the single-sample alternative to MSAA (needs motion vectors).
+  ImGui::Separator();
+  if (auto* resolve = pipeline->temporal_aa())
+  {
+    if (ImGui::Checkbox("Temporal AA", &taa))
+    {
+      resolve->reset_history();
+      // Resolve (or stop resolving) the scene now, not at the next Scene
+      // Rate tick: gated frames present the output of the latest resolve.
+      pipeline->pbr_group().request_submit();
+    }
+    if (taa)
+    {
+      float feedback = resolve->feedback();
+      if (ImGui::SliderFloat("TAA Feedback", &feedback, 0.02f, 0.5f))
+        resolve->set_feedback(feedback);
+    }
+  }
+  else
+  {
+    ImGui::BeginDisabled();
+    bool dummy = false;
+    ImGui::Checkbox("Temporal AA (MSAA off only)", &dummy);
+    ImGui::EndDisabled();
+  }
+
+  // Screen-space AO: same single-sample requirement (depth + motion vectors).
+  if (auto* ao = pipeline->ambient_occlusion())
+  {
+    if (ImGui::Checkbox("Ambient Occlusion (GTAO)", &ambient_occlusion))
+      ao->reset_history();
+    if (ambient_occlusion)
+    {
+      auto& settings = ao->settings();
+      ImGui::SameLine();
+      ImGui::Text("%.3f / %.2f ms%s", ao->gpu_time_ms(), settings.budget_ms,
+        ao->gpu_time_ms() > settings.budget_ms ? " (over budget)" : "");
+      ImGui::SliderFloat("AO Radius", &settings.radius, 0.05f, 2.0f);
+      ImGui::SliderFloat("AO Intensity", &settings.intensity, 0.5f, 3.0f);
+      ImGui::SliderFloat("AO Feedback", &settings.feedback, 0.05f, 1.0f);
+    }
+  }
+  else
+  {
+    ImGui::BeginDisabled();
+    bool dummy = false;
+    ImGui::Checkbox("Ambient Occlusion (MSAA off only)", &dummy);
+    ImGui::EndDisabled();
+  }
+
+  // Ray-query reflections: the specular IBL occluded where the scene is in the way.
+  if (pipeline->ray_query())
+  {
+    ImGui::Checkbox("Ray-Traced Reflections", &ray_traced_reflections);
+    if (ray_traced_reflections)
+      ImGui::SliderFloat("Reflection Roughness Cutoff", &pbr_ctx.reflection_roughness_cutoff,
+        0.05f, 1.0f);
+  }
+  else
+  {
+    ImGui::BeginDisabled();
+    bool dummy = false;
+    ImGui::Checkbox("Ray-Traced Reflections (needs --ray-tracing + ray query)", &dummy);
+    ImGui::EndDisabled();
+  }
+
+  // Primary rays through the ray tracing pipeline in place of the raster HDR.
+  if (pipeline->ray_tracer())
+  {
+    if (ImGui::Checkbox("Ray-Traced Preview", &ray_traced_preview))
+    {
+      // The history is of the other renderer; show the switch now even when
+      // the scene is idle.
+      if (auto* resolve = pipeline->temporal_aa())
+        resolve->reset_history();
+      pipeline->pbr_group().request_submit();
+    }
+  }
+
+  // Moves every instance each frame (TLAS refits, streamed instance transforms).
+  if (data.has_multi_material())
+  {
+    bool animate = animate_instances;
+    if (ImGui::Checkbox("Animate Instances", &animate))
+      set_instance_animation(animate);
+    if (animate_instances && pipeline->ray_query())
+      ImGui::Text("TLAS refits since rebuild: %u", pipeline->tlas_refits());
+  }
+
+  // Post-FX chain: per-pass toggles, settings and GPU time.
+  ImGui::Separator();
+  // With TAA the chain follows the resolve on the graphics queue.
+  const bool async_post_fx = pipeline->async_post_fx() && !(taa && pipeline->temporal_aa());
+  ImGui::Text("Post FX%s", async_post_fx ? " (async compute)" : "");
+  {
+    // Passes by chain index, in ScenePipeline's order.
+    auto& chain = pipeline->post_fx();
+    auto pass_toggle = [&chain](const char* label, size_t index) {
+      auto& pass = *chain.passes()[index];
+      bool enabled = pass.enabled();
+      if (ImGui::Checkbox(label, &enabled))
+        pass.set_enabled(enabled);
+      ImGui::SameLine();
+      ImGui::Text("%.3f ms", chain.gpu_time_ms(index));
+      return enabled;
+    };
+    if (pass_toggle("Bloom", 0))
+    {
+      auto& settings = pipeline->bloom().settings();
+      ImGui::SliderFloat("Bloom Intensity", &settings.intensity, 0.0f, 1.0f);
+      ImGui::SliderFloat("Bloom Threshold", &settings.threshold, 0.0f, 8.0f);
+      ImGui::SliderFloat("Bloom Knee", &settings.knee, 0.0f, 2.0f);
+    }
+    if (pass_toggle("Chromatic Aberration", 1))
+      ImGui::SliderFloat("Aberration", &pipeline->chromatic_aberration().settings().strength,
+        0.0f, 0.05f, "%.4f");
+    if (pass_toggle("Vignette", 2))
+    {
+      auto& settings = pipeline->vignette().settings();
+      ImGui::SliderFloat("Vignette Intensity", &settings.intensity, 0.0f, 1.0f);
+      ImGui::SliderFloat("Vignette Radius", &settings.radius, 0.0f, 0.95f);
+    }
+  }
 
   // IBL environment
   if (!app.config.hdr_paths.empty())
@@ -488,6 +963,44 @@ void Scene::draw_ui(Engine& app, double avg_fps)
   ImGui::SliderFloat3("Direction", &pbr_ctx.light_direction.x, -1.0f, 1.0f);
   ImGui::SliderFloat("Intensity", &pbr_ctx.light_intensity, 0.0f, 10.0f);
   ImGui::ColorEdit3("Light Color", &pbr_ctx.light_color.x);
+  ImGui::Checkbox("Shadows", &shadows);
+  if (shadows && pipeline->ray_query() &&
+      ImGui::Checkbox("Ray-Traced Shadows", &ray_traced_shadows))
+    pipeline->shadow_cascades().invalidate(); // cached cascades went stale meanwhile
+  if (shadows && pipeline->ray_query() && ray_traced_shadows)
+  {
+    // 0 = hard; the sun's disc (~0.27 deg) and up soften the penumbrae.
+    float degrees = glm::degrees(pbr_ctx.sun_angular_radius);
+    if (ImGui::SliderFloat("Sun Radius (deg)", &degrees, 0.0f, 5.0f))
+      pbr_ctx.sun_angular_radius = glm::radians(degrees);
+  }
+  else if (shadows)
+  {
+    auto& cascades = pipeline->shadow_cascades();
+    auto& settings = cascades.settings();
+    if (ImGui::Checkbox("Cache Far Cascades", &settings.cache_far_cascades))
+      cascades.invalidate();
+    if (ImGui::SliderFloat("Split Lambda", &settings.split_lambda, 0.0f, 1.0f))
+      cascades.invalidate();
+    if (ImGui::SliderFloat("Depth Bias", &settings.depth_bias_constant, 0.0f, 8.0f))
+      cascades.invalidate();
+    if (ImGui::SliderFloat("Slope Bias", &settings.depth_bias_slope, 0.0f, 8.0f))
+      cascades.invalidate();
+    ImGui::SliderFloat("Normal Offset", &settings.normal_offset, 0.0f, 4.0f);
+    ImGui::SliderFloat("PCF Radius", &settings.pcf_radius, 0.0f, 2.0f);
+    ImGui::Text("Cascades drawn: %u / %u", cascades.rendered_last_frame(),
+      vkwave::ShadowCascade::Count);
+  }
+
+  // Clustered point/spot lights: glTF KHR_lights_punctual + scattered ones
+  ImGui::Separator();
+  ImGui::Text("Point Lights (clustered)");
+  int scattered = static_cast<int>(data.scattered_lights.size());
+  if (ImGui::SliderInt("Scattered", &scattered, 0,
+        static_cast<int>(vkwave::LightCluster::MaxLights)))
+    data.scatter_lights(static_cast<uint32_t>(scattered));
+  ImGui::Text("%zu glTF, %zu total", data.gltf_scene.point_lights.size()
+    + data.gltf_scene.spot_lights.size(), gpu_lights.size());
 
   // Feature toggles
   ImGui::Separator();
@@ -516,6 +1029,20 @@ void Scene::draw_ui(Engine& app, double avg_fps)
 
   ImGui::Checkbox("Anisotropy", &pbr_ctx.enable_anisotropy);
 
+  // GPU occlusion culling (single-sample only: the pyramid samples the depth).
+  if (auto* hiz = pipeline->hiz_culler())
+  {
+    if (ImGui::Checkbox("Occlusion Culling (HiZ)", &occlusion_culling))
+      hiz->reset_history();
+  }
+  else
+  {
+    ImGui::BeginDisabled();
+    bool dummy = false;
+    ImGui::Checkbox("Occlusion Culling (MSAA off only)", &dummy);
+    ImGui::EndDisabled();
+  }
+
   // Global anisotropy override (non-glTF): force an elongated highlight onto
   // every material to preview the effect on assets without the extension.
   static bool ani_override = false;
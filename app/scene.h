@@ -4,6 +4,7 @@
 #include "scene_pipeline.h"
 
 #include <vkwave/core/buffer.h>
+#include <vkwave/core/dynamic_resolution.h>
 #include <vkwave/core/fence.h>
 #include <vkwave/pipeline/composite_pass.h>
 #include <vkwave/pipeline/pbr_pass.h>
@@ -31,9 +32,59 @@ struct Scene
   vkwave::PBRContext pbr_ctx{};
   vkwave::PBRPass pbr_pass{};
   vkwave::BlendPass blend_pass{};
+  vkwave::OitPass oit_pass{};
   vkwave::TransmissionPass transmission_pass{};
   vkwave::CompositePass composite_pass{};
 
+  // Two-phase HiZ occlusion culling of the opaque primitives (when available).
+  bool occlusion_culling{ true };
+
+  // Dynamic resolution: the scene renders into a sub-rectangle of the full-size
+  // targets, scaled by the controller to hold a GPU frame-time target.
+  bool dynamic_resolution{ false };
+  vkwave::DynamicResolution resolution;
+
+  // Scene submission rate in Hz (0 = every frame). Below the display rate the
+  // composite re-presents the latest scene HDR between scene frames.
+  float scene_hz{ 0.0f };
+
+  // Cascaded shadow maps for the directional light.
+  bool shadows{ true };
+
+  // Temporal anti-aliasing (single-sample only): jittered projection, resolved
+  // against reprojected history before composite. Also upscales under dynamic
+  // resolution.
+  bool taa{ false };
+  uint32_t taa_frame{ 0 }; // scene frames drawn (jitter sequence index)
+
+  // Unjittered viewProj of the scene frame drawn last: the next one's motion
+  // vectors reproject against it.
+  glm::mat4 rendered_view_projection{ 1.0f };
+
+  // Screen-space ambient occlusion (single-sample only): GTAO over the opaque
+  // depth, applied to the indirect light one frame later.
+  bool ambient_occlusion{ true };
+
+  // Ray-query shadows (in place of the cascades) and reflections, when the
+  // pipeline has ray query (ScenePipeline::ray_query()); raster otherwise.
+  bool ray_traced_shadows{ true };
+  bool ray_traced_reflections{ true };
+
+  // Debug view: primary rays through the ray tracing pipeline (its material
+  // hit groups) replace the raster HDR, when the pipeline has one
+  // (ScenePipeline::ray_tracer()).
+  bool ray_traced_preview{ false };
+
+  // Instance animation (glTF scenes): every primitive bobs about its rest
+  // transform, moving the scene graph each frame — the instance streams, TLAS
+  // refits and cascades follow (ScenePipeline::move_instances()). There are no
+  // per-object motion vectors, so TAA and AO reproject camera motion only.
+  bool animate_instances{ false };
+  std::vector<glm::mat4> rest_transforms; // [primitive], while animating
+
+  // Clustered lights: gathered from SceneData each frame, culled per slot.
+  std::vector<vkwave::GpuLight> gpu_lights;
+
   // Screenshot: captures from offscreen HDR image, fence-based polling,
   // single grow-only HOST_VISIBLE readback buffer, worker thread for PNG.
   bool screenshot_requested{ false };
@@ -81,6 +132,11 @@ struct Scene
   /// Rebuild render passes and pipelines when MSAA changes.
   void rebuild_pipeline(vk::SampleCountFlagBits new_samples);
 
+  /// True while frames must keep coming regardless of input: a held ImGui
+  /// widget, a screenshot in progress or auto-exposure still adapting
+  /// (render-on-demand keeps rendering).
+  [[nodiscard]] bool busy() const;
+
   /// Ensure HOST_VISIBLE readback buffer is large enough. Grow-only, never freed.
   void ensure_screenshot_readback(vk::DeviceSize needed);
 
@@ -92,4 +148,11 @@ private:
 
   /// Set record/post-record lambdas on execution groups.
   void wire_record_callbacks();
+
+  /// Start or stop animate_instances: keep the rest transforms, or put the
+  /// primitives back on them.
+  void set_instance_animation(bool enabled);
+
+  /// Offscreen slot holding the latest finished HDR (the composite's input).
+  [[nodiscard]] uint32_t hdr_slot() const;
 };
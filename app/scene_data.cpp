@@ -4,7 +4,9 @@
 
 #include <spdlog/spdlog.h>
 
+#include <algorithm>
 #include <filesystem>
+#include <random>
 
 const vkwave::Mesh* SceneData::active_mesh() const
 {
@@ -34,7 +36,18 @@ bool SceneData::has_transmission() const
   return false;
 }
 
-void SceneData::load_model(const vkwave::Device& device, const std::string& path)
+bool SceneData::has_blend() const
+{
+  if (!has_multi_material())
+    return false;
+  for (const auto& m : gltf_scene.materials)
+    if (m.alphaMode == vkwave::AlphaMode::Blend)
+      return true;
+  return false;
+}
+
+void SceneData::load_model(const vkwave::Device& device, const std::string& path,
+                           bool keep_geometry)
 {
   gltf_scene = {};
   gltf_model = {};
@@ -43,7 +56,7 @@ void SceneData::load_model(const vkwave::Device& device, const std::string& path
   if (!path.empty() && std::filesystem::exists(path))
   {
     spdlog::info("Loading glTF scene: {}", path);
-    gltf_scene = vkwave::load_gltf_scene(device, path);
+    gltf_scene = vkwave::load_gltf_scene(device, path, keep_geometry);
     if (!gltf_scene.mesh)
     {
       spdlog::warn("Scene load returned no mesh, falling back to single-material loader");
@@ -73,6 +86,50 @@ void SceneData::load_ibl(const vkwave::Device& device, const std::string& path)
   }
 }
 
+void SceneData::scatter_lights(uint32_t count)
+{
+  scattered_lights.clear();
+  scattered_lights.reserve(count);
+
+  vkwave::AABB bounds = gltf_scene.bounds;
+  if (!bounds.valid())
+  {
+    bounds.expand(glm::vec3(-1.0f));
+    bounds.expand(glm::vec3(1.0f));
+  }
+  const glm::vec3 extent = bounds.max - bounds.min;
+  // Radius scaled to the model so each light covers a handful of clusters
+  // whatever the asset's units.
+  const float radius = std::max(glm::length(extent) * 0.08f, 1e-3f);
+
+  std::mt19937 rng(1234u);
+  std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+  for (uint32_t i = 0; i < count; ++i)
+  {
+    glm::vec3 p = bounds.min + extent * glm::vec3(unit(rng), unit(rng), unit(rng));
+    vkwave::PointLight light(p);
+    // Saturated colours: one channel at full, the others random.
+    glm::vec3 color(unit(rng), unit(rng), unit(rng));
+    color[static_cast<int>(i % 3)] = 1.0f;
+    light.set_color(color);
+    light.set_intensity(2.0f);
+    light.set_attenuation(1.0f, 0.0f, 1.0f / (radius * radius));
+    light.set_range(radius * 3.0f);
+    scattered_lights.push_back(light);
+  }
+}
+
+void SceneData::gather_lights(std::vector<vkwave::GpuLight>& out) const
+{
+  out.clear();
+  for (const auto& l : gltf_scene.point_lights)
+    out.push_back(vkwave::to_gpu_light(l));
+  for (const auto& l : gltf_scene.spot_lights)
+    out.push_back(vkwave::to_gpu_light(l));
+  for (const auto& l : scattered_lights)
+    out.push_back(vkwave::to_gpu_light(l));
+}
+
 void SceneData::create_fallback_textures(const vkwave::Device& device)
 {
   const uint8_t white[] = { 255, 255, 255, 255 };
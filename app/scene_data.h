@@ -1,6 +1,7 @@
 #pragma once
 
 #include <vkwave/core/camera.h>
+#include <vkwave/core/light_cluster.h>
 #include <vkwave/core/mesh.h>
 #include <vkwave/core/texture.h>
 #include <vkwave/loaders/gltf_loader.h>
@@ -10,6 +11,7 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 
 namespace vkwave { class Device; }
 
@@ -33,6 +35,10 @@ struct SceneData
   std::unique_ptr<vkwave::Texture> fallback_mr;
   std::unique_ptr<vkwave::Texture> fallback_black;
 
+  // Procedural point lights scattered over the model bounds (clustered
+  // lighting stress test), in addition to the glTF KHR_lights_punctual ones.
+  std::vector<vkwave::PointLight> scattered_lights;
+
   // Indices into config path arrays for runtime switching
   int current_model_index{ -1 };
   int current_hdr_index{ 0 };
@@ -51,12 +57,26 @@ struct SceneData
   /// allocates the per-slot transmission snapshot + creates the refraction pass.
   [[nodiscard]] bool has_transmission() const;
 
+  /// True if any active material is alpha-blended (alphaMode BLEND). Drives
+  /// whether the graph allocates the OIT targets + creates the OIT pass.
+  [[nodiscard]] bool has_blend() const;
+
   /// Load a new model, replacing the current one. GPU must be drained by caller.
-  void load_model(const vkwave::Device& device, const std::string& path);
+  /// `keep_geometry` retains the CPU vertices / indices in gltf_scene (for the
+  /// reference path tracer).
+  void load_model(const vkwave::Device& device, const std::string& path,
+                  bool keep_geometry = false);
 
   /// Load a new IBL environment. GPU must be drained by caller.
   void load_ibl(const vkwave::Device& device, const std::string& path);
 
+  /// Replace scattered_lights with `count` randomly placed and coloured point
+  /// lights inside the model bounds (deterministic for a given count).
+  void scatter_lights(uint32_t count);
+
+  /// Flatten the glTF lights + scattered lights into `out` (cleared first).
+  void gather_lights(std::vector<vkwave::GpuLight>& out) const;
+
   /// Create 1x1 fallback textures for missing material slots.
   void create_fallback_textures(const vkwave::Device& device);
 };
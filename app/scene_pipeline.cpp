@@ -2,17 +2,33 @@
 #include "scene_data.h"
 #include "engine.h"
 
+#include <cassert>
 #include <cmath>
 #include <vector>
 
 #include <vkwave/core/buffer.h>
+#include <vkwave/core/deletion_queue.h>
 #include <vkwave/core/device.h>
+#include <vkwave/core/format_select.h>
 #include <vkwave/core/pbr_ubo.h>
 #include <vkwave/core/swapchain.h>
+#include <vkwave/pipeline/acceleration_structure.h>
+#include <vkwave/pipeline/ambient_occlusion.h>
+#include <vkwave/pipeline/clustered_lights.h>
+#include <vkwave/pipeline/hiz_culler.h>
+#include <vkwave/pipeline/mip_downsampler.h>
+#include <vkwave/pipeline/oit_resolve.h>
 #include <vkwave/pipeline/pipeline.h>
 #include <vkwave/pipeline/pbr_pass.h>
+#include <vkwave/pipeline/post_fx.h>
+#include <vkwave/pipeline/post_fx_passes.h>
+#include <vkwave/pipeline/raytracing_pipeline.h>
+#include <vkwave/pipeline/scene_ray_tracer.h>
+#include <vkwave/pipeline/shadow_cascades.h>
+#include <vkwave/pipeline/temporal_aa.h>
 #include <vkwave/pipeline/transmission_pass.h>
 #include <vkwave/pipeline/composite_pass.h>
+#include <vkwave/pipeline/compute_composite.h>
 
 #include <spdlog/fmt/fmt.h>
 #include <spdlog/spdlog.h>
@@ -24,6 +40,16 @@ static constexpr bool kDebug =
   false;
 #endif
 
+// A render pass replaced at runtime may still be referenced by frames in flight:
+// destroy it through the device deletion queue and null the handle.
+static void retire_renderpass(const vkwave::Device& device, vk::RenderPass& pass)
+{
+  if (!pass)
+    return;
+  device.deletion_queue().push([dev = device.device(), pass] { dev.destroyRenderPass(pass); });
+  pass = VK_NULL_HANDLE;
+}
+
 // ---------------------------------------------------------------------------
 // Construction
 // ---------------------------------------------------------------------------
@@ -33,13 +59,82 @@ ScenePipeline::ScenePipeline(Engine& engine, SceneData& data,
   : msaa_samples(msaa)
   , m_engine(&engine)
 {
+  // Target formats. The HDR target is written by the scene passes (blended),
+  // the OIT resolve and post-FX (storage) and sampled by TAA / composite /
+  // refraction; its alpha is never read, so B10G11R11 halves its bandwidth
+  // where supported.
+  // Depth is reversed-Z (see Camera), which wants the float format.
+  using FF = vk::FormatFeatureFlagBits;
+  const bool compact = engine.config.compact_formats;
+  hdr_format = vkwave::select_color_format(*engine.device, vkwave::ColorPrecision::hdr_rgb,
+    FF::eColorAttachment | FF::eColorAttachmentBlend | FF::eSampledImage
+      | FF::eSampledImageFilterLinear | FF::eStorageImage | FF::eTransferSrc | FF::eTransferDst,
+    compact);
+  depth_format = vkwave::select_depth_format(*engine.device, vkwave::DepthPrecision::reversed_z,
+    FF::eDepthStencilAttachment | FF::eSampledImage, compact);
+  taa_format = vkwave::select_color_format(*engine.device, vkwave::ColorPrecision::hdr_rgba,
+    FF::eStorageImage | FF::eSampledImage | FF::eSampledImageFilterLinear, compact);
+  const vk::Format shadow_format = vkwave::select_depth_format(*engine.device,
+    vkwave::DepthPrecision::linear,
+    FF::eDepthStencilAttachment | FF::eSampledImage | FF::eSampledImageFilterLinear, compact);
+  spdlog::info("Target formats: HDR {}, depth {}, shadows {}, TAA {}", vk::to_string(hdr_format),
+    vk::to_string(depth_format), vk::to_string(shadow_format), vk::to_string(taa_format));
+
   // Structure-independent render passes (created once, survive rebuilds):
   //  - composite: swapchain format, no MSAA.
   //  - transmission: single-sample LOAD pass over HDR + shared depth.
+  //  - disocclusion: the same LOAD pass, storing depth for a later transmission,
+  //    over the full single-sample scene framebuffer (HiZ implies e1, so the
+  //    motion vectors are always attached).
+  //  - OIT: single-sample, clears accum + revealage and LOADs the shared depth.
   composite_renderpass = vkwave::make_composite_renderpass(
     engine.device->device(), engine.swapchain->image_format(), kDebug);
   transmission_renderpass = vkwave::make_transmission_renderpass(
-    engine.device->device(), kHdrFormat, kDepthFormat, kDebug);
+    engine.device->device(), hdr_format, depth_format, kDebug);
+  disocclusion_renderpass = vkwave::make_transmission_renderpass(
+    engine.device->device(), hdr_format, depth_format, kDebug, true, kVelocityFormat);
+  oit_renderpass = vkwave::make_oit_renderpass(
+    engine.device->device(), kOitAccumFormat, kOitRevealFormat, depth_format, kDebug);
+
+  // Occlusion culler (compute pipelines only; per-slot pyramids are created
+  // with the graph).
+  m_hiz = std::make_unique<vkwave::HiZCuller>(*engine.device, kDebug);
+  m_lights = std::make_unique<vkwave::ClusteredLights>(*engine.device, kDebug);
+  m_shadows = std::make_unique<vkwave::ShadowCascades>(*engine.device, shadow_format, kDebug);
+  update_shadow_casters(data);
+  m_ray_query = engine.device->supports_ray_query();
+  if (engine.config.ray_tracing && !m_ray_query)
+    spdlog::info("No ray query support — raster shadows and reflections");
+  update_instances(data);
+  update_ray_tracing(data);
+  if (m_ray_query && engine.device->supports_ray_tracing())
+    m_ray_tracer = std::make_unique<vkwave::SceneRayTracer>(*engine.device, hdr_format);
+  else if (engine.config.ray_tracing)
+    spdlog::info("No ray tracing pipeline — no ray traced preview");
+  m_taa = std::make_unique<vkwave::TemporalAA>(*engine.device, taa_format, kDebug);
+  m_ao = std::make_unique<vkwave::AmbientOcclusion>(*engine.device, kDebug);
+  m_oit_resolve = std::make_unique<vkwave::OitResolve>(*engine.device, hdr_format, kDebug);
+
+  // Post-FX chain, in order: bloom (on), chromatic aberration and vignette
+  // (off until enabled in the UI).
+  m_post_fx = std::make_unique<vkwave::PostFxChain>(*engine.device, hdr_format, kDebug);
+  m_bloom = &m_post_fx->add(
+    std::make_unique<vkwave::BloomPass>(*engine.device, hdr_format, kDebug));
+  m_chromatic_aberration = &m_post_fx->add(
+    std::make_unique<vkwave::ChromaticAberrationPass>(*engine.device, hdr_format, kDebug));
+  m_vignette = &m_post_fx->add(
+    std::make_unique<vkwave::VignettePass>(*engine.device, hdr_format, kDebug));
+  m_async_post_fx = engine.config.async_post_fx && engine.device->has_dedicated_compute_queue();
+  if (engine.config.async_post_fx && !m_async_post_fx)
+    spdlog::info("No dedicated compute queue — post-FX on the graphics queue");
+  if (vkwave::MipDownsampler::supported(*engine.device))
+    m_snapshot_mips = std::make_unique<vkwave::MipDownsampler>(*engine.device, hdr_format, kDebug);
+  else
+    spdlog::info("No quad subgroup ops in compute — transmission snapshot without mips");
+  if (engine.swapchain->storage_images() && vkwave::ComputeComposite::supported(*engine.device))
+    m_compute_composite = std::make_unique<vkwave::ComputeComposite>(*engine.device, kDebug);
+  else
+    spdlog::info("No storage swapchain or subgroup ops — fragment composite, manual exposure");
 
   // Create sampler (persistent across resize / rebuild)
   {
@@ -68,6 +163,18 @@ ScenePipeline::ScenePipeline(Engine& engine, SceneData& data,
 
   // Overlay framebuffers reference swapchain image views -- create after build
   imgui->create_frame_resources(*engine.swapchain, engine.swapchain->image_count());
+  if (m_compute_composite)
+    m_compute_composite->create_frame_resources(*engine.swapchain);
+}
+
+void ScenePipeline::configure_compute_composite()
+{
+  if (!m_compute_composite)
+    return;
+  auto& comp = composite_group();
+  comp.set_render_pass_enabled(false);
+  comp.set_acquire_stage(
+    vk::PipelineStageFlagBits::eColorAttachmentOutput | vk::PipelineStageFlagBits::eComputeShader);
 }
 
 void ScenePipeline::build_scene_graph(SceneData& data)
@@ -77,60 +184,121 @@ void ScenePipeline::build_scene_graph(SceneData& data)
   auto& pool = engine.graph->resources();
 
   const bool has_glass = data.has_transmission();
+  const bool has_blend = data.has_blend();
   // The transmission *pass* is e1-only: a single-sample pass cannot share an MSAA
   // (multisample) depth buffer (subpass sample counts must match; depth resolve
   // is a later task). The *snapshot* pool resource is registered for any glass
   // scene regardless of MSAA, so toggling MSAA only adds/removes the group — not
   // pool resources (keeps the incremental MSAA path off the structural rebuild).
   m_graph_has_transmission = has_glass && msaa_samples == vk::SampleCountFlagBits::e1;
+  // The OIT pass tests against the same depth, so it is e1-only too (MSAA keeps
+  // the sorted BlendPass in the pbr group).
+  m_graph_has_oit = has_blend && msaa_samples == vk::SampleCountFlagBits::e1;
+  // HiZ culling builds its pyramid from the single-sample depth (same e1 limit),
+  // and its indirect draws select their instance transform by firstInstance —
+  // without drawIndirectFirstInstance the scene draws directly, unculled.
+  m_graph_has_hiz = msaa_samples == vk::SampleCountFlagBits::e1
+    && engine.device->enabled_features().drawIndirectFirstInstance;
+  // Motion vectors (and so TAA) likewise: MSAA is the alternative to TAA.
+  m_graph_has_velocity = msaa_samples == vk::SampleCountFlagBits::e1;
 
   // (Re)create the scene render pass at the current MSAA. The transmission group
-  // LOADs this depth, so the scene pass must STORE it (only when the group exists).
-  if (scene_renderpass)
-    dev.destroyRenderPass(scene_renderpass);
+  // and the HiZ pyramid build read this depth, so the scene pass must STORE it
+  // whenever either exists.
+  retire_renderpass(*m_engine->device, scene_renderpass);
   scene_renderpass = vkwave::make_scene_renderpass(
-    dev, kHdrFormat, kDepthFormat, kDebug, msaa_samples, m_graph_has_transmission);
+    dev, hdr_format, depth_format, kDebug, msaa_samples,
+    m_graph_has_transmission || m_graph_has_hiz || m_graph_has_oit,
+    m_graph_has_velocity ? kVelocityFormat : vk::Format::eUndefined);
 
   // Register the graph-owned, per-slot HDR target (eliminates the WAW hazard)
   // and depth buffer. Per-slot depth lets frames overlap on the GPU yet lets
-  // same-frame passes (opaque + transmission) share one depth buffer.
-  hdr_handle = pool.add_color("hdr_image", kHdrFormat,
+  // same-frame passes (opaque + transmission) share one depth buffer. eStorage
+  // for the OIT resolve and post-FX, which work on it in place; eTransferDst
+  // for the post-FX copy back from its scratch image.
+  hdr_handle = pool.add_color("hdr_image", hdr_format,
     vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eSampled
-      | vk::ImageUsageFlagBits::eTransferSrc);
-  depth_handle = pool.add_depth("scene_depth", kDepthFormat, msaa_samples);
+      | vk::ImageUsageFlagBits::eTransferSrc | vk::ImageUsageFlagBits::eTransferDst
+      | vk::ImageUsageFlagBits::eStorage,
+    vk::SampleCountFlagBits::e1, false, m_async_post_fx);
+  m_post_fx->register_resources(pool, m_async_post_fx);
+  depth_handle = pool.add_depth("scene_depth", depth_format, msaa_samples);
+
+  // Motion vectors + TAA and AO outputs. Registered regardless of MSAA (like
+  // the snapshot) so an MSAA toggle never changes the pool's registrations.
+  velocity_handle = pool.add_color("velocity", kVelocityFormat,
+    vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eSampled);
+  taa_handle = pool.add_color("taa_output", taa_format,
+    vk::ImageUsageFlagBits::eStorage | vk::ImageUsageFlagBits::eSampled);
+  ao_handle = pool.add_color("ao_output", kAoFormat,
+    vk::ImageUsageFlagBits::eStorage | vk::ImageUsageFlagBits::eSampled);
 
   // Per-slot sampleable snapshot of the opaque HDR for the refraction pass to
-  // read. Registered for any glass scene (single-sample, filled via copy:
-  // eSampled | eTransferDst). Per-slot so it participates in cross-frame overlap.
+  // read. Registered for any glass scene (single-sample, full mip chain written
+  // by the compute downsampler: eStorage; eTransferDst for the mip-0 copy
+  // fallback). Per-slot so it participates in cross-frame overlap.
   snapshot_handle.reset();
   if (has_glass)
   {
-    snapshot_handle = pool.add_color("transmission_snapshot", kHdrFormat,
-      vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eTransferDst);
+    snapshot_handle = pool.add_color("transmission_snapshot", hdr_format,
+      vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eStorage
+        | vk::ImageUsageFlagBits::eTransferDst,
+      vk::SampleCountFlagBits::e1, true);
   }
   if (m_graph_has_transmission)
     spdlog::info("Scene has transmissive materials — transmission pass enabled");
 
+  // Per-slot OIT targets, registered for any scene with blended materials
+  // regardless of MSAA (like the snapshot).
+  oit_accum_handle.reset();
+  oit_reveal_handle.reset();
+  if (has_blend)
+  {
+    oit_accum_handle = pool.add_color("oit_accum", kOitAccumFormat,
+      vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eSampled);
+    oit_reveal_handle = pool.add_color("oit_reveal", kOitRevealFormat,
+      vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eSampled);
+  }
+  if (m_graph_has_oit)
+    spdlog::info("Scene has blended materials — weighted-blended OIT pass enabled");
+
   // PBR opaque group: renders to the graph-owned HDR target + depth.
   auto pbr_spec = vkwave::PBRPass::pipeline_spec();
-  pbr_spec.existing_renderpass = scene_renderpass;
+  configure_pbr_spec(pbr_spec);
+  pbr_spec.existing_renderpass = scene_renderpass; // fallback without dynamic rendering
+  pbr_spec.dynamic_rendering = true;
   pbr_spec.msaa_samples = msaa_samples;
-  auto& pbr_grp = engine.graph->add_offscreen_group("pbr", pbr_spec, kHdrFormat, kDebug);
+  pbr_spec.depth_format = depth_format;
+  pbr_spec.color_attachment_count = m_graph_has_velocity ? 2 : 1;
+  pbr_spec.aux_color_format = kVelocityFormat;
+  pbr_spec.store_depth = m_graph_has_transmission || m_graph_has_hiz || m_graph_has_oit;
+  auto& pbr_grp = engine.graph->add_offscreen_group("pbr", pbr_spec, hdr_format, kDebug);
   pbr_grp.set_color_attachment(pool, hdr_handle);
   pbr_grp.set_depth_attachment(pool, depth_handle);
+  if (m_graph_has_velocity)
+    pbr_grp.set_aux_color_attachment(pool, velocity_handle);
   //   Set 0: per-frame UBO (ring-buffered) -- default
   //   Set 1: per-material textures (count = number of materials)
   //   Set 2: per-scene IBL (count = 1)
   pbr_grp.set_descriptor_count(1, data.material_count());
   pbr_grp.set_descriptor_count(2, 1);
 
-  // Transmission group: own pipeline + render pass + submission (Requirement #5).
+  // OIT group: transparent layers over the opaque result, before the glass so
+  // the refraction snapshot sees them. Then the transmission group: own
+  // pipeline + render pass + submission (Requirement #5).
+  if (m_graph_has_oit)
+    add_oit_group(data);
   if (m_graph_has_transmission)
     add_transmission_group(data);
 
+  // Post-FX group: compute over the finished HDR, after the glass (without
+  // TAA; with it the chain follows the resolve in the composite submission).
+  auto& post_grp = add_post_fx_group();
+
   // Composite present group: samples HDR, tonemaps, writes to swapchain.
   auto comp_spec = vkwave::CompositePass::pipeline_spec();
   comp_spec.existing_renderpass = composite_renderpass;
+  comp_spec.dynamic_rendering = true;
   auto& comp_grp = engine.graph->set_present_group(
     "composite", comp_spec, engine.swapchain->image_format(), kDebug);
 
@@ -147,21 +315,28 @@ void ScenePipeline::build_scene_graph(SceneData& data)
       comp_grp.set_gating(vkwave::GatingMode::wall_clock, refresh);
   }
 
-  // Pass-dependency DAG. Without glass: composite waits on pbr. With glass:
-  // pbr -> transmission -> composite (transmission samples the opaque snapshot,
-  // composite samples the HDR after glass is drawn into it).
-  if (auto* tr = transmission_group())
+  // Pass-dependency DAG, a chain: pbr (-> oit) (-> transmission) -> post_fx
+  // -> composite. The OIT pass tests against the opaque depth and resolves
+  // into the HDR; the transmission pass samples the snapshot taken after that,
+  // post-FX works on the HDR after glass is drawn into it, and composite
+  // samples the result.
+  vkwave::ExecutionGroup* last = &pbr_grp;
+  for (auto* next : { oit_group(), transmission_group() })
   {
-    tr->depends_on(pbr_grp);
-    comp_grp.depends_on(*tr);
-  }
-  else
-  {
-    comp_grp.depends_on(pbr_grp);
+    if (!next)
+      continue;
+    next->depends_on(*last);
+    last = next;
   }
+  post_grp.depends_on(*last);
+  comp_grp.depends_on(post_grp);
+  configure_compute_composite();
 
   engine.graph->build(*engine.swapchain);
 
+  // Per-slot light lists must exist before the pbr descriptors reference them.
+  m_lights->create_frame_resources(pool.slot_count());
+
   // Write descriptors (after build allocates descriptor sets). This also writes
   // the transmission group's material SSBO when present (see upload_material_buffer).
   write_pbr_descriptors(data);
@@ -170,19 +345,60 @@ void ScenePipeline::build_scene_graph(SceneData& data)
   // the correct slot each frame).
   comp_grp.write_image_descriptor(0, "hdrImage",
     pool.color_view(hdr_handle, 0), hdr_sampler);
+
+  // Culler pyramids + descriptors reference the freshly built pool depth.
+  if (m_graph_has_hiz)
+  {
+    m_hiz->create_frame_resources(pool, depth_handle);
+    update_hiz_primitives(data);
+  }
+  if (m_graph_has_velocity)
+  {
+    m_taa->create_frame_resources(pool, hdr_handle, velocity_handle, taa_handle);
+    m_ao->create_frame_resources(pool, depth_handle, velocity_handle, ao_handle);
+  }
+  if (m_snapshot_mips && m_graph_has_transmission)
+    m_snapshot_mips->create_frame_resources(pool, hdr_handle, *snapshot_handle);
+  if (m_graph_has_oit)
+    m_oit_resolve->create_frame_resources(pool, hdr_handle, *oit_accum_handle, *oit_reveal_handle);
+  m_post_fx->create_frame_resources(pool, hdr_handle);
+  if (m_ray_tracer)
+    m_ray_tracer->create_frame_resources(pool, hdr_handle);
+  bind_snapshot();
 }
 
 void ScenePipeline::rebuild_graph(SceneData& data)
 {
-  // reset_structure() drains, tears down groups + pool registrations; then we
-  // re-register and rebuild for the new scene structure.
+  // reset_structure() tears down groups + pool registrations (deferred past the
+  // frames in flight); then we re-register and rebuild for the new structure.
   m_engine->graph->reset_structure();
+  m_hiz->destroy_frame_resources();
+  m_taa->destroy_frame_resources();
+  m_ao->destroy_frame_resources();
+  m_oit_resolve->destroy_frame_resources();
+  m_post_fx->destroy_frame_resources();
+  if (m_ray_tracer)
+    m_ray_tracer->destroy_frame_resources();
+  if (m_snapshot_mips)
+    m_snapshot_mips->destroy_frame_resources();
   build_scene_graph(data);
 }
 
 ScenePipeline::~ScenePipeline()
 {
   imgui.reset();
+  m_hiz.reset();
+  m_lights.reset();
+  m_shadows.reset();
+  m_taa.reset();
+  m_ao.reset();
+  m_oit_resolve.reset();
+  m_ray_tracer.reset();
+  m_post_fx.reset();
+  m_snapshot_mips.reset();
+  m_compute_composite.reset();
+  m_tlas.reset();
+  m_blases.clear();
 
   auto dev = m_engine->device->device();
   if (hdr_sampler)
@@ -193,13 +409,17 @@ ScenePipeline::~ScenePipeline()
     dev.destroyRenderPass(composite_renderpass);
   if (transmission_renderpass)
     dev.destroyRenderPass(transmission_renderpass);
+  if (disocclusion_renderpass)
+    dev.destroyRenderPass(disocclusion_renderpass);
+  if (oit_renderpass)
+    dev.destroyRenderPass(oit_renderpass);
 }
 
 // ---------------------------------------------------------------------------
 // Descriptor writes
 // ---------------------------------------------------------------------------
 
-void ScenePipeline::write_pbr_descriptors(SceneData& data)
+void ScenePipeline::write_material_textures(vkwave::ExecutionGroup& group, SceneData& data)
 {
   auto tex_or = [](const std::unique_ptr<vkwave::Texture>& tex,
                    const std::unique_ptr<vkwave::Texture>& fallback)
@@ -208,11 +428,9 @@ void ScenePipeline::write_pbr_descriptors(SceneData& data)
     return tex ? *tex : *fallback;
   };
 
-  auto& group = pbr_group();
   const bool use_scene = data.has_multi_material();
   const uint32_t mat_count = data.material_count();
 
-  // Set 1: per-material textures (one descriptor set per material)
   for (uint32_t m = 0; m < mat_count; ++m)
   {
     // Empty handle used as the "no texture" source for single-material models,
@@ -258,14 +476,94 @@ void ScenePipeline::write_pbr_descriptors(SceneData& data)
     auto& ani = tex_or(mat_ani, data.fallback_white);
     group.write_image_descriptor(1, "anisotropyTexture", m, ani.image_view(), ani.sampler());
   }
+}
+
+void ScenePipeline::write_pbr_descriptors(SceneData& data)
+{
+  // Set 1: per-material textures (one descriptor set per material). The OIT
+  // group reflects the same shaders, so it gets every pbr write below too.
+  write_material_textures(pbr_group(), data);
+  if (auto* oit = oit_group())
+    write_material_textures(*oit, data);
+
+  // Set 0, bindings 1-3: per-slot clustered light lists
+  write_light_descriptors();
+
+  // Set 0, binding 4: the screen-space AO (bound per frame, bind_ao())
+  write_ao_descriptors(data);
 
   // Set 2: per-scene IBL textures (single descriptor set)
   write_ibl_descriptors(data);
 
+  // Set 2, binding 4: the shadow cascades (persistent, shared by all slots)
+  pbr_group().write_image_descriptor(2, "shadowMap",
+    m_shadows->array_view(), m_shadows->sampler());
+  if (auto* oit = oit_group())
+    oit->write_image_descriptor(2, "shadowMap", m_shadows->array_view(), m_shadows->sampler());
+
+  // Set 2, binding 5: the scene TLAS (ray-query builds only)
+  write_tlas_descriptor(pbr_group());
+  if (auto* oit = oit_group())
+    write_tlas_descriptor(*oit);
+
   // Set 2, binding 3: immutable per-material SSBO (shared across all frames)
   upload_material_buffer(data);
 }
 
+void ScenePipeline::write_multiview_descriptors(vkwave::ExecutionGroup& group, SceneData& data)
+{
+  // Same layout as the pbr group (both reflect pbr.vert/pbr.frag).
+  write_material_textures(group, data);
+
+  // Slot 0's light lists: a multiview draw runs with no clustered lights, but
+  // the bindings are statically used and must be valid.
+  group.write_buffer_descriptor(0, 1, m_lights->light_buffer(0), VK_WHOLE_SIZE);
+  group.write_buffer_descriptor(0, 2, m_lights->grid_buffer(0), VK_WHOLE_SIZE);
+  group.write_buffer_descriptor(0, 3, m_lights->index_buffer(0), VK_WHOLE_SIZE);
+  group.write_image_descriptor(0, "ambientOcclusion",
+    data.fallback_white->image_view(), data.fallback_white->sampler());
+
+  group.write_image_descriptor(2, "brdfLUT",
+    data.ibl->brdf_lut_view(), data.ibl->brdf_lut_sampler());
+  group.write_image_descriptor(2, "irradianceMap",
+    data.ibl->irradiance_view(), data.ibl->irradiance_sampler());
+  group.write_image_descriptor(2, "prefilterMap",
+    data.ibl->prefiltered_view(), data.ibl->prefiltered_sampler());
+  group.write_image_descriptor(2, "shadowMap",
+    m_shadows->array_view(), m_shadows->sampler());
+  group.write_buffer_descriptor(2, 3, material_buffer->buffer(), material_buffer->size());
+  write_tlas_descriptor(group);
+}
+
+void ScenePipeline::configure_pbr_spec(vkwave::PipelineSpec& spec) const
+{
+  if (m_ray_query)
+    vkwave::PBRPass::enable_ray_query(spec);
+}
+
+void ScenePipeline::write_tlas_descriptor(vkwave::ExecutionGroup& group)
+{
+  if (!m_tlas)
+    return;
+  group.write_acceleration_structure(2, "sceneTLAS", m_tlas->handle());
+  m_tlas_generation = m_tlas->generation();
+}
+
+bool ScenePipeline::tlas_descriptors_stale() const
+{
+  return m_tlas && m_tlas->generation() != m_tlas_generation;
+}
+
+uint32_t ScenePipeline::tlas_refits() const
+{
+  return m_tlas ? m_tlas->refits() : 0;
+}
+
+vk::AccelerationStructureKHR ScenePipeline::tlas_handle() const
+{
+  return m_tlas ? m_tlas->handle() : VK_NULL_HANDLE;
+}
+
 void ScenePipeline::upload_material_buffer(SceneData& data)
 {
   // KHR_texture_transform → precomputed affine (matrix = T * R * S), packed as
@@ -325,20 +623,20 @@ void ScenePipeline::upload_material_buffer(SceneData& data)
   const vk::DeviceSize bytes =
     gpu_materials.size() * sizeof(vkwave::GpuMaterial);
 
-  // (Re)create the buffer only when missing or too small. Rebuild/resize paths
-  // drain the GPU before calling this, so replacing the buffer here is safe.
-  if (!material_buffer || material_buffer->size() < bytes)
-  {
-    material_buffer = std::make_unique<vkwave::Buffer>(
-      *m_engine->device, "material_ssbo", bytes,
-      vk::BufferUsageFlagBits::eStorageBuffer,
-      vk::MemoryPropertyFlagBits::eHostVisible
-        | vk::MemoryPropertyFlagBits::eHostCoherent);
-  }
+  // Always a fresh buffer: frames in flight may still read the old one (the
+  // rebuild/resize paths no longer drain), which the deletion queue keeps alive
+  // until they finish.
+  material_buffer = std::make_unique<vkwave::Buffer>(
+    *m_engine->device, "material_ssbo", bytes,
+    vk::BufferUsageFlagBits::eStorageBuffer,
+    vk::MemoryPropertyFlagBits::eHostVisible
+      | vk::MemoryPropertyFlagBits::eHostCoherent);
   material_buffer->update(gpu_materials.data(), bytes);
 
   // Singleton set 2, binding 3 — one descriptor shared by every frame.
   pbr_group().write_buffer_descriptor(2, 3, material_buffer->buffer(), bytes);
+  if (auto* oit = oit_group())
+    oit->write_buffer_descriptor(2, 3, material_buffer->buffer(), bytes);
 
   // The transmission group has the same immutable SSBO at its own set 1, binding
   // 0 (compact layout), plus per-material transmission masks at set 2. Write both
@@ -359,17 +657,103 @@ void ScenePipeline::upload_material_buffer(SceneData& data)
       tr->write_image_descriptor(2, "transmissionMask", m, t.image_view(), t.sampler());
     }
   }
+
+  // The ray tracer reads the same materials, indexed through its primitive
+  // table (the TLAS instances' custom index); its hit shaders fetch indexed
+  // triangles, so a mesh without indices is not traced.
+  if (m_ray_tracer)
+  {
+    const vkwave::Mesh* mesh = data.active_mesh();
+    if (mesh && mesh->index_buffer())
+    {
+      const vkwave::SceneRayTracer::SceneBindings bindings{ mesh->vertex_buffer(),
+        mesh->index_buffer(), material_buffer->buffer(), data.ibl->prefiltered_view(),
+        data.ibl->prefiltered_sampler() };
+      m_ray_tracer->set_scene(bindings, data.has_multi_material()
+        ? std::span<const vkwave::ScenePrimitive>(data.gltf_scene.primitives)
+        : std::span<const vkwave::ScenePrimitive>());
+    }
+    else
+    {
+      m_ray_tracer->clear_scene();
+    }
+  }
+}
+
+void ScenePipeline::bind_snapshot()
+{
+  // Slot s of the transmission group samples slot s's snapshot (the opaque
+  // scene behind the glass), written once rather than rebound every frame.
+  if (auto* tr = transmission_group())
+    tr->bind_pool_image(0, "snapshotTex", m_engine->graph->resources(),
+      *snapshot_handle, snapshot_sampler());
+}
+
+void ScenePipeline::write_light_descriptors()
+{
+  // Set 0 is ring-buffered (auto UBO at binding 0), so slot s's allocation reads
+  // slot s's lights — written in the pre-record hook of the same submission.
+  for (auto* group : { &pbr_group(), oit_group() })
+  {
+    if (!group)
+      continue;
+    for (uint32_t s = 0; s < m_lights->slot_count(); ++s)
+    {
+      group->write_buffer_descriptor(0, 1, s, m_lights->light_buffer(s), VK_WHOLE_SIZE);
+      group->write_buffer_descriptor(0, 2, s, m_lights->grid_buffer(s), VK_WHOLE_SIZE);
+      group->write_buffer_descriptor(0, 3, s, m_lights->index_buffer(s), VK_WHOLE_SIZE);
+    }
+  }
+}
+
+void ScenePipeline::write_ao_descriptors(SceneData& data)
+{
+  // A valid descriptor for every slot; pbr.frag only reads it once bind_ao()
+  // has bound a resolved AO (PBRContext::screen_space_ao).
+  const auto& pool = m_engine->graph->resources();
+  for (auto* group : { &pbr_group(), oit_group() })
+  {
+    if (!group)
+      continue;
+    for (uint32_t s = 0; s < pool.slot_count(); ++s)
+      group->write_image_descriptor(0, "ambientOcclusion", s,
+        data.fallback_white->image_view(), data.fallback_white->sampler());
+  }
+}
+
+void ScenePipeline::bind_ao(uint32_t slot, SceneData& data)
+{
+  // The AO resolved last, however many slots ago (a gated scene skips slots).
+  // The OIT group draws after this frame's resolve, but shades with the same
+  // output as the opaque pass. The slot's sets were last used by its previous
+  // submission, which the graph waited for before reusing the slot.
+  auto* ao = ambient_occlusion();
+  const bool resolved = ao && ao->history_ready();
+  for (auto* group : { &pbr_group(), oit_group() })
+  {
+    if (!group)
+      continue;
+    if (resolved)
+      group->write_image_descriptor(0, "ambientOcclusion", slot, ao->output_view(), hdr_sampler);
+    else
+      group->write_image_descriptor(0, "ambientOcclusion", slot,
+        data.fallback_white->image_view(), data.fallback_white->sampler());
+  }
 }
 
 void ScenePipeline::write_ibl_descriptors(SceneData& data)
 {
-  auto& group = pbr_group();
-  group.write_image_descriptor(2, "brdfLUT",
-    data.ibl->brdf_lut_view(), data.ibl->brdf_lut_sampler());
-  group.write_image_descriptor(2, "irradianceMap",
-    data.ibl->irradiance_view(), data.ibl->irradiance_sampler());
-  group.write_image_descriptor(2, "prefilterMap",
-    data.ibl->prefiltered_view(), data.ibl->prefiltered_sampler());
+  for (auto* group : { &pbr_group(), oit_group() })
+  {
+    if (!group)
+      continue;
+    group->write_image_descriptor(2, "brdfLUT",
+      data.ibl->brdf_lut_view(), data.ibl->brdf_lut_sampler());
+    group->write_image_descriptor(2, "irradianceMap",
+      data.ibl->irradiance_view(), data.ibl->irradiance_sampler());
+    group->write_image_descriptor(2, "prefilterMap",
+      data.ibl->prefiltered_view(), data.ibl->prefiltered_sampler());
+  }
 
   // The transmission group reflects the same prefiltered env at its Fresnel rim
   // (set 1, binding 1). Refreshed here so an IBL switch updates the glass too.
@@ -391,8 +775,15 @@ void ScenePipeline::rebuild_pbr_descriptors(SceneData& data)
   grp.set_descriptor_count(2, 1);
   grp.create_frame_resources(extent, os_depth);
 
-  // The transmission group also has per-material descriptors (set 2 mask), so it
+  // The OIT and transmission groups also have per-material descriptors, so they
   // must be rebuilt when the material set changes (glass -> glass model switch).
+  if (auto* oit = oit_group())
+  {
+    oit->destroy_frame_resources();
+    oit->set_descriptor_count(1, data.material_count());
+    oit->set_descriptor_count(2, 1);
+    oit->create_frame_resources(extent, os_depth);
+  }
   if (auto* tr = transmission_group())
   {
     tr->destroy_frame_resources();
@@ -408,14 +799,52 @@ void ScenePipeline::rebuild_pbr_descriptors(SceneData& data)
 // MSAA rebuild
 // ---------------------------------------------------------------------------
 
+vkwave::ExecutionGroup& ScenePipeline::add_oit_group(SceneData& data)
+{
+  auto& pool = m_engine->graph->resources();
+  auto oit_spec = vkwave::OitPass::pipeline_spec();
+  configure_pbr_spec(oit_spec);
+  oit_spec.existing_renderpass = oit_renderpass;
+  oit_spec.dynamic_rendering = true;
+  oit_spec.aux_color_format = kOitRevealFormat;
+  oit_spec.msaa_samples = vk::SampleCountFlagBits::e1;
+  oit_spec.depth_format = depth_format;
+  auto& oit_grp = m_engine->graph->add_offscreen_group(
+    "oit", oit_spec, kOitAccumFormat, kDebug);
+  oit_grp.set_color_attachment(pool, *oit_accum_handle);      // premultiplied sum
+  oit_grp.set_aux_color_attachment(pool, *oit_reveal_handle); // -log revealage
+  oit_grp.set_depth_attachment(pool, depth_handle); // depth-test vs opaque depth
+  oit_grp.set_clear_values({
+    vk::ClearColorValue(std::array<float, 4>{ 0.0f, 0.0f, 0.0f, 0.0f }),
+    vk::ClearDepthStencilValue(0.0f, 0), // unused: depth is LOADed
+    vk::ClearColorValue(std::array<float, 4>{ 0.0f, 0.0f, 0.0f, 0.0f }),
+  });
+  oit_grp.set_descriptor_count(1, data.material_count()); // same layout as pbr
+  oit_grp.set_descriptor_count(2, 1);
+  return oit_grp;
+}
+
+vkwave::SubmissionGroup& ScenePipeline::add_post_fx_group()
+{
+  // Compute only (PostFxChain::record() in its record callback), so it can
+  // take the async compute queue; the pool images it touches were registered
+  // compute_shared to match.
+  auto& post_grp = m_engine->graph->add_compute_group("post_fx", kDebug);
+  post_grp.set_async_compute(m_async_post_fx);
+  return post_grp;
+}
+
 vkwave::ExecutionGroup& ScenePipeline::add_transmission_group(SceneData& data)
 {
   auto& pool = m_engine->graph->resources();
   auto tr_spec = vkwave::TransmissionPass::pipeline_spec();
   tr_spec.existing_renderpass = transmission_renderpass;
+  tr_spec.dynamic_rendering = true;
+  tr_spec.load_attachments = true; // draws over the opaque HDR + depth
   tr_spec.msaa_samples = vk::SampleCountFlagBits::e1;
+  tr_spec.depth_format = depth_format;
   auto& tr_grp = m_engine->graph->add_offscreen_group(
-    "transmission", tr_spec, kHdrFormat, kDebug);
+    "transmission", tr_spec, hdr_format, kDebug);
   tr_grp.set_color_attachment(pool, hdr_handle);   // draws glass into the HDR
   tr_grp.set_depth_attachment(pool, depth_handle); // depth-test vs opaque depth
   tr_grp.set_descriptor_count(1, 1);               // set 1: singleton material SSBO
@@ -429,39 +858,61 @@ void ScenePipeline::rebuild_for_msaa(vk::SampleCountFlagBits new_samples,
   // INCREMENTAL path (must NOT route through the structural rebuild_graph — that
   // frees+reallocates every resource and 2x-peaks GPU memory, OOMing at
   // 8x/fullscreen). Replace only the pbr group + depth; keep HDR/composite/
-  // semaphores. The transmission group is e1-only, so add/remove just that group.
+  // semaphores. The OIT and transmission groups are e1-only, so add/remove just
+  // those groups.
   msaa_samples = new_samples;
   auto& graph = *m_engine->graph;
   auto& pool = graph.resources();
   const uint32_t os_depth = graph.offscreen_depth();
   const bool want_group =
     data.has_transmission() && msaa_samples == vk::SampleCountFlagBits::e1;
-
-  // 1. Drop the transmission group BEFORE the depth becomes multisample (it is
-  //    single-sample and shares that depth).
+  const bool want_oit = data.has_blend() && msaa_samples == vk::SampleCountFlagBits::e1;
+  const bool want_hiz = msaa_samples == vk::SampleCountFlagBits::e1
+    && m_engine->device->enabled_features().drawIndirectFirstInstance;
+
+  // 1. Drop the transmission and OIT groups BEFORE the depth becomes
+  //    multisample (they are single-sample and share that depth). The post-FX
+  //    group is the last group, so it goes first (re-added last, below), then
+  //    transmission.
+  graph.remove_last_offscreen_group();
   if (m_graph_has_transmission && !want_group)
   {
     graph.remove_last_offscreen_group();
     m_graph_has_transmission = false;
   }
+  if (m_graph_has_oit && !want_oit)
+  {
+    graph.remove_last_offscreen_group();
+    m_graph_has_oit = false;
+    m_oit_resolve->destroy_frame_resources();
+  }
 
   // 2. Rebuild the pbr group at the new sample count (the proven incremental
-  //    path). storeDepth only when the transmission group will consume it.
+  //    path). storeDepth only when the transmission group or HiZ will consume it.
   auto& old_pbr = pbr_group();
   const auto extent = old_pbr.extent();
   old_pbr.destroy_frame_resources();
 
   auto dev = m_engine->device->device();
-  if (scene_renderpass)
-    dev.destroyRenderPass(scene_renderpass);
+  retire_renderpass(*m_engine->device, scene_renderpass);
+  const bool want_velocity = msaa_samples == vk::SampleCountFlagBits::e1;
   scene_renderpass = vkwave::make_scene_renderpass(
-    dev, kHdrFormat, kDepthFormat, kDebug, msaa_samples, want_group);
+    dev, hdr_format, depth_format, kDebug, msaa_samples, want_group || want_hiz || want_oit,
+    want_velocity ? kVelocityFormat : vk::Format::eUndefined);
 
   auto pbr_spec = vkwave::PBRPass::pipeline_spec();
+  configure_pbr_spec(pbr_spec);
   pbr_spec.existing_renderpass = scene_renderpass;
+  pbr_spec.dynamic_rendering = true;
   pbr_spec.msaa_samples = msaa_samples;
-  auto& new_pbr = graph.replace_offscreen_group(0, "pbr", pbr_spec, kHdrFormat, kDebug);
+  pbr_spec.depth_format = depth_format;
+  pbr_spec.color_attachment_count = want_velocity ? 2 : 1;
+  pbr_spec.aux_color_format = kVelocityFormat;
+  pbr_spec.store_depth = want_group || want_hiz || want_oit;
+  auto& new_pbr = graph.replace_offscreen_group(0, "pbr", pbr_spec, hdr_format, kDebug);
   new_pbr.set_color_attachment(pool, hdr_handle);
+  if (want_velocity)
+    new_pbr.set_aux_color_attachment(pool, velocity_handle);
 
   // Depth must match the new MSAA: update + re-allocate the pool (the snapshot
   // stays single-sample; only the depth sample count changes).
@@ -472,29 +923,87 @@ void ScenePipeline::rebuild_for_msaa(vk::SampleCountFlagBits new_samples,
   new_pbr.set_descriptor_count(2, 1);
   new_pbr.create_frame_resources(extent, os_depth);
 
-  // 3. Re-add the transmission group now that depth is single-sample again.
+  // The pool re-alloc invalidated the culler's depth descriptors; HiZ is e1-only.
+  m_graph_has_hiz = want_hiz;
+  if (m_graph_has_hiz)
+    m_hiz->create_frame_resources(pool, depth_handle);
+  else
+    m_hiz->destroy_frame_resources();
+
+  // Same for the TAA descriptors (its motion vectors are e1-only).
+  m_graph_has_velocity = want_velocity;
+  if (m_graph_has_velocity)
+  {
+    m_taa->create_frame_resources(pool, hdr_handle, velocity_handle, taa_handle);
+    m_ao->create_frame_resources(pool, depth_handle, velocity_handle, ao_handle);
+  }
+  else
+  {
+    m_taa->destroy_frame_resources();
+    m_ao->destroy_frame_resources();
+  }
+
+  // 3. Re-add the OIT, then the transmission group (group order) now that depth
+  //    is single-sample again. A surviving one gets fresh sets for the
+  //    re-allocated pool (its old ones may still be in flight). Both are e1-only,
+  //    so one is only ever re-added when the other was dropped too.
+  if (want_oit && !m_graph_has_oit)
+  {
+    auto& oit_grp = add_oit_group(data);
+    oit_grp.create_frame_resources(extent, os_depth);
+    m_graph_has_oit = true;
+  }
+  else if (auto* oit = oit_group())
+  {
+    oit->destroy_frame_resources();
+    oit->create_frame_resources(extent, os_depth);
+  }
+  if (m_graph_has_oit)
+    m_oit_resolve->create_frame_resources(pool, hdr_handle, *oit_accum_handle, *oit_reveal_handle);
+
   if (want_group && !m_graph_has_transmission)
   {
     auto& tr_grp = add_transmission_group(data);
     tr_grp.create_frame_resources(extent, os_depth);
     m_graph_has_transmission = true;
   }
+  else if (auto* tr = transmission_group())
+  {
+    tr->destroy_frame_resources();
+    tr->create_frame_resources(extent, os_depth);
+  }
 
-  // 4. Re-wire the HDR descriptor + dependency DAG (the pool re-alloc gave fresh
-  //    views; replace_offscreen_group made a new pbr group, dangling old edges).
-  auto& comp = composite_group();
-  comp.write_image_descriptor(0, "hdrImage", pool.color_view(hdr_handle, 0), hdr_sampler);
-  comp.clear_dependencies();
-  if (auto* tr = transmission_group())
+  // The snapshot chain follows the pool re-alloc too (transmission is e1-only).
+  if (m_snapshot_mips)
   {
-    tr->clear_dependencies();
-    tr->depends_on(new_pbr);
-    comp.depends_on(*tr);
+    if (m_graph_has_transmission)
+      m_snapshot_mips->create_frame_resources(pool, hdr_handle, *snapshot_handle);
+    else
+      m_snapshot_mips->destroy_frame_resources();
   }
-  else
+  bind_snapshot();
+
+  // The post-FX group goes back at the end; its chain follows the pool re-alloc.
+  auto& post_grp = add_post_fx_group();
+  post_grp.create_frame_resources(extent, os_depth);
+  m_post_fx->create_frame_resources(pool, hdr_handle);
+
+  // 4. Re-wire the dependency DAG (replace_offscreen_group made a new pbr group,
+  //    dangling old edges). The composite's HDR descriptor needs no rewrite: its
+  //    record callback binds the current slot's (fresh) view every frame.
+  auto& comp = composite_group();
+  comp.clear_dependencies();
+  vkwave::ExecutionGroup* last = &new_pbr;
+  for (auto* next : { oit_group(), transmission_group() })
   {
-    comp.depends_on(new_pbr);
+    if (!next)
+      continue;
+    next->clear_dependencies();
+    next->depends_on(*last);
+    last = next;
   }
+  post_grp.depends_on(*last);
+  comp.depends_on(post_grp);
 
   write_pbr_descriptors(data);
   spdlog::info("MSAA changed to {}x", static_cast<int>(msaa_samples));
@@ -506,11 +1015,15 @@ void ScenePipeline::rebuild_for_msaa(vk::SampleCountFlagBits new_samples,
 
 void ScenePipeline::resize(const vkwave::Swapchain& swapchain, SceneData& data)
 {
+  // No drain: the helpers' old views, sets and framebuffers are destroyed
+  // through the device deletion queue once the frames in flight finish.
   if (imgui)
   {
     imgui->destroy_frame_resources();
     imgui->create_frame_resources(swapchain, swapchain.image_count());
   }
+  if (m_compute_composite)
+    m_compute_composite->create_frame_resources(swapchain);
 
   // Update composite pass's HDR image descriptor after resize rebuilt everything
   composite_group().write_image_descriptor(
@@ -518,6 +1031,200 @@ void ScenePipeline::resize(const vkwave::Swapchain& swapchain, SceneData& data)
 
   // Re-write PBR texture descriptors (descriptor sets were recreated)
   write_pbr_descriptors(data);
+
+  // Pyramids are sized to the (resized) pool depth
+  if (m_graph_has_hiz)
+    m_hiz->create_frame_resources(m_engine->graph->resources(), depth_handle);
+  if (m_graph_has_velocity)
+  {
+    m_taa->create_frame_resources(
+      m_engine->graph->resources(), hdr_handle, velocity_handle, taa_handle);
+    m_ao->create_frame_resources(
+      m_engine->graph->resources(), depth_handle, velocity_handle, ao_handle);
+  }
+  if (m_graph_has_oit)
+    m_oit_resolve->create_frame_resources(m_engine->graph->resources(),
+      hdr_handle, *oit_accum_handle, *oit_reveal_handle);
+  m_post_fx->create_frame_resources(m_engine->graph->resources(), hdr_handle);
+  if (m_ray_tracer)
+    m_ray_tracer->create_frame_resources(m_engine->graph->resources(), hdr_handle);
+  // The snapshot's mip count (and so the sampler's maxLod) follows the extent.
+  if (m_snapshot_mips && m_graph_has_transmission)
+    m_snapshot_mips->create_frame_resources(
+      m_engine->graph->resources(), hdr_handle, *snapshot_handle);
+  // The group already rewrote the snapshot views; the sampler is new.
+  bind_snapshot();
+}
+
+void ScenePipeline::update_hiz_primitives(SceneData& data)
+{
+  // The legacy single-mesh path has no primitive list — the culler idles.
+  if (data.has_multi_material())
+    m_hiz->set_primitives(data.gltf_scene.primitives);
+  else
+    m_hiz->set_primitives({});
+}
+
+void ScenePipeline::update_shadow_casters(SceneData& data)
+{
+  // The legacy single-mesh path draws the whole mesh into every cascade.
+  if (data.has_multi_material())
+    m_shadows->set_casters(data.gltf_scene.primitives);
+  else
+    m_shadows->set_casters({});
+}
+
+void ScenePipeline::update_instances(SceneData& data)
+{
+  std::vector<glm::mat4> transforms;
+  if (data.has_multi_material())
+  {
+    transforms.reserve(data.gltf_scene.primitives.size());
+    for (const auto& prim : data.gltf_scene.primitives)
+      transforms.push_back(prim.modelMatrix);
+  }
+  else
+  {
+    transforms.push_back(glm::mat4(1.0f)); // PBRPass::model
+  }
+
+  // A fresh buffer, like the material SSBO: frames in flight still bind the
+  // old one. Every slot's region starts out current.
+  const uint32_t slots = m_engine->graph->offscreen_depth();
+  const vk::DeviceSize bytes = transforms.size() * sizeof(glm::mat4);
+  m_instance_buffer = std::make_unique<vkwave::Buffer>(
+    *m_engine->device, "instance_transforms", bytes * slots,
+    vk::BufferUsageFlagBits::eVertexBuffer,
+    vk::MemoryPropertyFlagBits::eHostVisible
+      | vk::MemoryPropertyFlagBits::eHostCoherent);
+  for (uint32_t s = 0; s < slots; ++s)
+    m_instance_buffer->update(transforms.data(), bytes, bytes * s);
+  m_instance_transforms = std::move(transforms);
+  m_slot_instance_version.assign(slots, m_instance_version);
+}
+
+vk::Buffer ScenePipeline::instance_buffer() const
+{
+  return m_instance_buffer->buffer();
+}
+
+vk::DeviceSize ScenePipeline::instance_offset(uint32_t slot) const
+{
+  return static_cast<vk::DeviceSize>(slot) * m_instance_transforms.size() * sizeof(glm::mat4);
+}
+
+void ScenePipeline::move_instances(SceneData& data)
+{
+  // The legacy single mesh has no scene graph to move.
+  if (!data.has_multi_material())
+    return;
+  const auto& primitives = data.gltf_scene.primitives;
+  assert(primitives.size() == m_instance_transforms.size());
+  for (size_t i = 0; i < primitives.size(); ++i)
+    m_instance_transforms[i] = primitives[i].modelMatrix;
+  ++m_instance_version;
+
+  // TLAS instance i is primitive i (update_ray_tracing()).
+  if (m_tlas)
+    for (uint32_t i = 0; i < m_tlas->instance_count(); ++i)
+      m_tlas->set_transform(i, primitives[i].modelMatrix);
+  update_shadow_casters(data);
+}
+
+void ScenePipeline::record_instances(vk::CommandBuffer cmd, uint32_t slot)
+{
+  // The slot's region was last read by its previous scene frame, which the
+  // graph waited for before reusing the slot.
+  if (m_slot_instance_version[slot] != m_instance_version)
+  {
+    const vk::DeviceSize bytes = m_instance_transforms.size() * sizeof(glm::mat4);
+    m_instance_buffer->update(m_instance_transforms.data(), bytes, instance_offset(slot));
+    m_slot_instance_version[slot] = m_instance_version;
+  }
+  if (m_tlas)
+    m_tlas->record(cmd, slot);
+}
+
+void ScenePipeline::update_ray_tracing(SceneData& data)
+{
+  if (!m_ray_query)
+    return;
+  auto& device = *m_engine->device;
+
+  // Frames in flight may still trace against the old model's BLASes.
+  if (!m_blases.empty())
+  {
+    auto old = std::make_shared<std::vector<vkwave::AccelerationStructure>>(std::move(m_blases));
+    device.deletion_queue().push([old]() mutable { old.reset(); });
+    m_blases.clear();
+  }
+
+  // One BLAS per unique geometry, shared by the TLAS instances of every
+  // primitive that uses it (their node transforms go on the instances).
+  // Blended and transmissive primitives are built too but masked out of the
+  // occlusion rays (pbr.frag's RAY_MASK_OCCLUDER): they should not cast hard
+  // shadows.
+  const vkwave::Mesh* mesh = data.active_mesh();
+  std::vector<vkwave::BlasGeometry> geometries;
+  std::vector<uint32_t> blas_of;   // [instance] -> BLAS index
+  std::vector<glm::mat4> transforms;
+  std::vector<uint8_t> masks;
+  std::vector<uint32_t> hit_groups; // SBT hit record of each instance's material
+  if (data.has_multi_material())
+  {
+    const auto& primitives = data.gltf_scene.primitives;
+    std::vector<uint32_t> mesh_blas(data.gltf_scene.mesh_count, UINT32_MAX);
+    for (size_t i = 0; i < primitives.size(); ++i)
+    {
+      const auto& prim = primitives[i];
+      const auto& mat = data.gltf_scene.materials[prim.materialIndex];
+      uint32_t& blas = mesh_blas[prim.meshIndex];
+      if (blas == UINT32_MAX)
+      {
+        blas = static_cast<uint32_t>(geometries.size());
+        geometries.push_back(vkwave::blas_geometry(*mesh, prim,
+          fmt::format("{} mesh {}", mesh->name(), prim.meshIndex)));
+        // Alpha-tested geometry runs the any-hit of its hit group (ray
+        // queries force opaque and are unaffected).
+        geometries.back().opaque = mat.alphaMode != vkwave::AlphaMode::Mask;
+      }
+      blas_of.push_back(blas);
+      transforms.push_back(prim.modelMatrix);
+      const bool occluder = mat.alphaMode != vkwave::AlphaMode::Blend && mat.transmissionFactor <= 0.0f;
+      masks.push_back(occluder ? 0x01 : 0x02);
+      hit_groups.push_back(static_cast<uint32_t>(vkwave::RayTracingPipeline::hit_group_of(mat)));
+    }
+  }
+  else
+  {
+    geometries.push_back(vkwave::blas_geometry(*mesh, mesh->name()));
+    blas_of.push_back(0);
+    transforms.push_back(glm::mat4(1.0f)); // PBRPass::model
+    masks.push_back(0x01);
+    hit_groups.push_back(static_cast<uint32_t>(vkwave::MaterialHitGroup::opaque));
+  }
+  m_blases = vkwave::AccelerationStructure::build_blases(device, geometries);
+
+  std::vector<vkwave::TlasInstance> instances(blas_of.size());
+  for (size_t i = 0; i < instances.size(); ++i)
+  {
+    instances[i].blas = &m_blases[blas_of[i]];
+    instances[i].transform = transforms[i];
+    instances[i].custom_index = static_cast<uint32_t>(i);
+    instances[i].mask = masks[i];
+    instances[i].sbt_offset = hit_groups[i];
+  }
+
+  // Rebuilt in place by the next scene frame's record_instances(): its
+  // barriers order the build after the frames in flight that trace the old
+  // instances. A larger instance set reallocates the structure
+  // (tlas_descriptors_stale()).
+  if (!m_tlas)
+    m_tlas = std::make_unique<vkwave::PersistentTlas>(device, "scene TLAS",
+      m_engine->graph->offscreen_depth());
+  m_tlas->set_instances(instances);
+  spdlog::info("Ray tracing: {} BLASes, TLAS of {} instances", m_blases.size(),
+    m_tlas->instance_count());
 }
 
 // ---------------------------------------------------------------------------
@@ -534,10 +1241,63 @@ vkwave::ExecutionGroup& ScenePipeline::composite_group()
   return static_cast<vkwave::ExecutionGroup&>(m_engine->graph->present_group());
 }
 
+vkwave::HiZCuller* ScenePipeline::hiz_culler()
+{
+  return m_graph_has_hiz ? m_hiz.get() : nullptr;
+}
+
+vkwave::TemporalAA* ScenePipeline::temporal_aa()
+{
+  return m_graph_has_velocity ? m_taa.get() : nullptr;
+}
+
+vkwave::AmbientOcclusion* ScenePipeline::ambient_occlusion()
+{
+  return m_graph_has_velocity ? m_ao.get() : nullptr;
+}
+
+vkwave::SceneRayTracer* ScenePipeline::ray_tracer()
+{
+  return (m_ray_tracer && m_ray_tracer->ready()) ? m_ray_tracer.get() : nullptr;
+}
+
+vkwave::MipDownsampler* ScenePipeline::snapshot_downsampler()
+{
+  return (m_snapshot_mips && m_snapshot_mips->ready()) ? m_snapshot_mips.get() : nullptr;
+}
+
+vk::Sampler ScenePipeline::snapshot_sampler()
+{
+  auto* mips = snapshot_downsampler();
+  return mips ? mips->sampler() : hdr_sampler;
+}
+
+vkwave::ExecutionGroup* ScenePipeline::oit_group()
+{
+  if (!m_graph_has_oit)
+    return nullptr;
+  // Offscreen group order: 0 = pbr, 1 = oit, then transmission.
+  return static_cast<vkwave::ExecutionGroup*>(&m_engine->graph->offscreen_group(1));
+}
+
+vkwave::OitResolve* ScenePipeline::oit_resolve()
+{
+  return m_graph_has_oit ? m_oit_resolve.get() : nullptr;
+}
+
 vkwave::ExecutionGroup* ScenePipeline::transmission_group()
 {
   if (!m_graph_has_transmission)
     return nullptr;
-  // Offscreen group order: 0 = pbr, 1 = transmission (added second).
-  return static_cast<vkwave::ExecutionGroup*>(&m_engine->graph->offscreen_group(1));
+  // Offscreen group order: 0 = pbr, (1 = oit,) then transmission (added last).
+  return static_cast<vkwave::ExecutionGroup*>(
+    &m_engine->graph->offscreen_group(m_graph_has_oit ? 2 : 1));
+}
+
+vkwave::SubmissionGroup& ScenePipeline::post_fx_group()
+{
+  // Offscreen group order: 0 = pbr, (oit,) (transmission,) then post_fx (added
+  // last).
+  const size_t index = 1 + (m_graph_has_oit ? 1 : 0) + (m_graph_has_transmission ? 1 : 0);
+  return m_engine->graph->offscreen_group(index);
 }
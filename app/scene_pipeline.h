@@ -3,21 +3,40 @@
 #include <vkwave/pipeline/frame_resource_pool.h>
 #include <vkwave/pipeline/imgui_overlay.h>
 
+#include <glm/glm.hpp>
 #include <vulkan/vulkan.hpp>
 
+#include <cstdint>
 #include <memory>
 #include <optional>
+#include <vector>
 
 struct Engine;
 struct SceneData;
-namespace vkwave { class ExecutionGroup; class Swapchain; class Buffer; }
+namespace vkwave { class ExecutionGroup; class Swapchain; class Buffer; class HiZCuller; class ClusteredLights; class ShadowCascades; class TemporalAA; class AmbientOcclusion; class MipDownsampler; class OitResolve; class ComputeComposite; class SubmissionGroup; class PostFxChain; class BloomPass; class ChromaticAberrationPass; class VignettePass; class AccelerationStructure; class PersistentTlas; class SceneRayTracer; struct PipelineSpec; }
 
 /// Pipeline infrastructure: render passes, sampler, execution group wiring,
 /// ImGui, MSAA. The HDR render target is owned by the render graph's resource
 /// pool (referenced here by handle). References SceneData for descriptor writes.
 struct ScenePipeline
 {
-  static constexpr vk::Format kHdrFormat = vk::Format::eR16G16B16A16Sfloat;
+  static constexpr vk::Format kVelocityFormat = vk::Format::eR16G16Sfloat;
+  // Screen-space AO output: visibility + view depth (the reprojection check).
+  static constexpr vk::Format kAoFormat = vk::Format::eR16G16Sfloat;
+  // Weighted-blended OIT targets: weighted premultiplied colour + weight, and
+  // the summed -log(1 - alpha).
+  static constexpr vk::Format kOitAccumFormat = vk::Format::eR16G16B16A16Sfloat;
+  static constexpr vk::Format kOitRevealFormat = vk::Format::eR16Sfloat;
+
+  // Scene HDR colour (also the snapshot and the screenshot source) and depth
+  // formats, picked at construction from the device's support and
+  // AppConfig::compact_formats (see select_color_format()).
+  vk::Format hdr_format{ vk::Format::eUndefined };
+  vk::Format depth_format{ vk::Format::eUndefined };
+  // Temporal-AA output, also the next resolve's history: HDR with the full
+  // precision of ColorPrecision::hdr_rgba, so the accumulation does not band
+  // (the scene HDR itself may be B10G11R11).
+  vk::Format taa_format{ vk::Format::eUndefined };
 
   // Graph-owned HDR color target + depth (one per slot), referenced by handle.
   vkwave::FrameResourcePool::ColorHandle hdr_handle{ 0 };
@@ -26,11 +45,26 @@ struct ScenePipeline
   // refraction. Registered only when the scene has transmissive materials
   // (engaged == has value); otherwise the graph is identical to opaque-only.
   std::optional<vkwave::FrameResourcePool::ColorHandle> snapshot_handle;
+  // Per-slot motion vectors (second scene-pass attachment, single-sample only)
+  // and temporal-AA output; the output resolved last is the TAA history.
+  vkwave::FrameResourcePool::ColorHandle velocity_handle{ 0 };
+  vkwave::FrameResourcePool::ColorHandle taa_handle{ 0 };
+  // Per-slot screen-space AO output; the output resolved last is both its
+  // history and what the next scene frame shades with (bind_ao()).
+  vkwave::FrameResourcePool::ColorHandle ao_handle{ 0 };
+  // Per-slot OIT accumulation + revealage targets. Registered only when the
+  // scene has blended materials (engaged == has value), like the snapshot.
+  std::optional<vkwave::FrameResourcePool::ColorHandle> oit_accum_handle;
+  std::optional<vkwave::FrameResourcePool::ColorHandle> oit_reveal_handle;
   vk::Sampler hdr_sampler{ VK_NULL_HANDLE };
   vk::RenderPass scene_renderpass{ VK_NULL_HANDLE };
   vk::RenderPass composite_renderpass{ VK_NULL_HANDLE };
   vk::RenderPass transmission_renderpass{ VK_NULL_HANDLE };
-  static constexpr vk::Format kDepthFormat = vk::Format::eD32Sfloat;
+  // LOAD pass over the pbr framebuffer for the HiZ disocclusion draws (stores
+  // depth for the transmission pass).
+  vk::RenderPass disocclusion_renderpass{ VK_NULL_HANDLE };
+  // Render-pass fallback of the OIT group (clears its targets, LOADs depth).
+  vk::RenderPass oit_renderpass{ VK_NULL_HANDLE };
   vk::SampleCountFlagBits msaa_samples{ vk::SampleCountFlagBits::e1 };
   std::unique_ptr<vkwave::ImGuiOverlay> imgui;
 
@@ -48,28 +82,140 @@ struct ScenePipeline
   void resize(const vkwave::Swapchain& swapchain, SceneData& data);
 
   /// Structurally rebuild the graph for the current scene — adds/removes the
-  /// transmission pass + snapshot resource depending on data.has_transmission().
+  /// transmission pass + snapshot resource depending on data.has_transmission(),
+  /// and the OIT pass + targets depending on data.has_blend().
   /// Call when the *pass set* changes (model switch crossing the glass boundary,
-  /// or MSAA change). Drains internally. Caller must re-wire record callbacks
-  /// afterwards (the group objects are new).
+  /// or MSAA change). No drain: the old groups are destroyed through the device
+  /// deletion queue. Caller must re-wire record callbacks afterwards (the group
+  /// objects are new).
   void rebuild_graph(SceneData& data);
 
   /// True if the current graph includes the transmission pass.
   [[nodiscard]] bool has_transmission_pass() const { return m_graph_has_transmission; }
 
+  /// True if the current graph includes the weighted-blended OIT pass.
+  [[nodiscard]] bool has_oit_pass() const { return m_graph_has_oit; }
+
+  /// Re-upload the active model's primitives to the occlusion culler. Call
+  /// after a model switch that keeps the graph structure.
+  void update_hiz_primitives(SceneData& data);
+
+  /// Hand the active model's primitives to the shadow cascades (caster bounds)
+  /// and redraw every cascade. Call after any model switch.
+  void update_shadow_casters(SceneData& data);
+
+  /// Upload the active model's per-instance model matrices (one per primitive,
+  /// an identity for the legacy mesh): PBRContext::instance_transforms. Call
+  /// after a model switch; the old buffer is retired through the deletion queue.
+  void update_instances(SceneData& data);
+
+  /// The instance transforms of the active model (see update_instances()), one
+  /// region per slot; slot `slot`'s starts at instance_offset(slot).
+  [[nodiscard]] vk::Buffer instance_buffer() const;
+  [[nodiscard]] vk::DeviceSize instance_offset(uint32_t slot) const;
+
+  /// The active model's primitives moved in place (modelMatrix, same
+  /// primitives): the next scene frame of each slot streams them, the TLAS
+  /// refits and the shadow cascades redraw.
+  void move_instances(SceneData& data);
+
+  /// Build the active model's BLASes and hand their instances to the scene
+  /// TLAS (no-op without ray query); the TLAS builds in the next
+  /// record_instances(). Call after a model switch, before the pbr descriptors
+  /// are rewritten; the old BLASes are retired through the deletion queue.
+  void update_ray_tracing(SceneData& data);
+
+  /// Per scene frame, from the pbr pre-record: write `slot`'s instance
+  /// transforms if they moved since its last frame, and build or refit the
+  /// TLAS if its instances changed.
+  void record_instances(vk::CommandBuffer cmd, uint32_t slot);
+
+  /// True when the TLAS was reallocated (it grew) since its descriptors were
+  /// written: rebuild the pbr descriptors before the next frame records.
+  [[nodiscard]] bool tlas_descriptors_stale() const;
+
+  /// Refits of the scene TLAS since its last full build (0 without ray query).
+  [[nodiscard]] uint32_t tlas_refits() const;
+
+  /// True when the PBR shaders trace ray queries against the scene TLAS (the
+  /// device has VK_KHR_ray_query). Without it shadows and reflections stay
+  /// raster.
+  [[nodiscard]] bool ray_query() const { return m_ray_query; }
+
+  /// The scene TLAS (null without ray query).
+  [[nodiscard]] vk::AccelerationStructureKHR tlas_handle() const;
+
+  /// Primary rays through the ray tracing pipeline into the scene HDR, or
+  /// nullptr without one (needs ray query for the TLAS and
+  /// VK_KHR_ray_tracing_pipeline) or without a traceable scene.
+  vkwave::SceneRayTracer* ray_tracer();
+
+  /// Compile a pbr.frag spec for this pipeline's ray-query mode (see
+  /// PBRPass::enable_ray_query()); groups built from it get the TLAS through
+  /// write_pbr_descriptors() / write_multiview_descriptors().
+  void configure_pbr_spec(vkwave::PipelineSpec& spec) const;
+
   /// Write per-material + IBL texture descriptors to the PBR group.
   void write_pbr_descriptors(SceneData& data);
 
+  /// Write the PBR descriptors (materials, IBL, shadow map, material SSBO) to
+  /// a group built from PBRPass::pipeline_spec() outside the graph — e.g. a
+  /// multiview turntable group. Slot 0 only; light lists are bound but unused.
+  void write_multiview_descriptors(vkwave::ExecutionGroup& group, SceneData& data);
+
   /// Destroy and recreate PBR group frame resources, then rewrite descriptors.
   void rebuild_pbr_descriptors(SceneData& data);
 
-  /// Write IBL descriptors only (set 2).
+  /// Write IBL descriptors only (set 2). Writes in place: only for sets no
+  /// frame in flight uses (an IBL switch goes through rebuild_pbr_descriptors()).
   void write_ibl_descriptors(SceneData& data);
 
   vkwave::ExecutionGroup& pbr_group();
   vkwave::ExecutionGroup& composite_group();
   /// The transmission group, or nullptr when the scene has no glass.
   vkwave::ExecutionGroup* transmission_group();
+  /// The weighted-blended OIT group, or nullptr when the scene has no blended
+  /// materials or the graph is multisampled (BlendPass sorts them instead).
+  vkwave::ExecutionGroup* oit_group();
+  /// The OIT resolve, or nullptr without the OIT group.
+  vkwave::OitResolve* oit_resolve();
+  /// The occlusion culler, or nullptr when the graph is multisampled.
+  vkwave::HiZCuller* hiz_culler();
+  /// Clustered point/spot light culling (always present).
+  vkwave::ClusteredLights& clustered_lights() { return *m_lights; }
+  /// Directional-light cascaded shadow maps (always present).
+  vkwave::ShadowCascades& shadow_cascades() { return *m_shadows; }
+  /// Temporal AA resolve, or nullptr when the graph is multisampled (no
+  /// motion vectors).
+  vkwave::TemporalAA* temporal_aa();
+  /// Screen-space ambient occlusion, or nullptr when the graph is
+  /// multisampled (it needs the single-sample depth and motion vectors).
+  vkwave::AmbientOcclusion* ambient_occlusion();
+  /// Point slot `slot`'s scene passes (pbr and OIT set 0, binding 4) at the AO
+  /// resolved last, or fallback white until there is one. Call when the scene
+  /// records in `slot`, before its own AO is resolved.
+  void bind_ao(uint32_t slot, SceneData& data);
+  /// The transmission snapshot's mip-chain generator, or nullptr when there is
+  /// no transmission pass or the device lacks quad subgroup ops (the snapshot
+  /// is then a plain mip-0 copy).
+  vkwave::MipDownsampler* snapshot_downsampler();
+  /// The compute composite (tonemap + auto-exposure straight into the
+  /// swapchain image), or nullptr when the swapchain has no storage usage or
+  /// the device lacks the subgroup ops (the fullscreen CompositePass is used).
+  vkwave::ComputeComposite* compute_composite() { return m_compute_composite.get(); }
+  /// The post-FX group: compute only, after the last scene group and before
+  /// the composite (always present; on the async compute queue when enabled).
+  vkwave::SubmissionGroup& post_fx_group();
+  /// The post-FX chain over the HDR and its passes (always present).
+  vkwave::PostFxChain& post_fx() { return *m_post_fx; }
+  vkwave::BloomPass& bloom() { return *m_bloom; }
+  vkwave::ChromaticAberrationPass& chromatic_aberration() { return *m_chromatic_aberration; }
+  vkwave::VignettePass& vignette() { return *m_vignette; }
+  /// True when the post-FX group runs on a dedicated compute queue.
+  [[nodiscard]] bool async_post_fx() const { return m_async_post_fx; }
+  /// Sampler for the snapshot: trilinear over the generated chain, or
+  /// hdr_sampler for the copy fallback.
+  [[nodiscard]] vk::Sampler snapshot_sampler();
   vkwave::ImGuiOverlay* imgui_overlay() { return imgui.get(); }
 
 private:
@@ -79,6 +225,102 @@ private:
   // present AND single-sample — phase-1 transmission is e1-only).
   bool m_graph_has_transmission{ false };
 
+  // Whether the current graph includes the OIT pass (blended materials present
+  // AND single-sample: it depth-tests against the shared scene depth, like the
+  // transmission pass).
+  bool m_graph_has_oit{ false };
+
+  // Composites the OIT targets over the HDR at the end of the OIT submission.
+  // Its descriptors follow the pool like the TAA ones, but only while the OIT
+  // pass exists.
+  std::unique_ptr<vkwave::OitResolve> m_oit_resolve;
+
+  // Hierarchical-Z occlusion culling. The culler (pipelines) lives as long as
+  // the ScenePipeline; its pyramids exist only while the scene depth is
+  // single-sample (the pyramid build samples it directly).
+  std::unique_ptr<vkwave::HiZCuller> m_hiz;
+  bool m_graph_has_hiz{ false };
+
+  // Clustered forward lighting: per-slot light SSBO + froxel light lists, bound
+  // at the pbr group's set 0. Sized by slot count only, so it is recreated with
+  // the graph, not on resize/MSAA changes.
+  std::unique_ptr<vkwave::ClusteredLights> m_lights;
+
+  // Directional-light cascaded shadow maps. Fixed-size and not per slot (cached
+  // cascades persist across frames), so they survive every graph rebuild; only
+  // the pbr set 2 descriptor is rewritten.
+  std::unique_ptr<vkwave::ShadowCascades> m_shadows;
+
+  // Temporal anti-aliasing (the MSAA alternative). Needs the motion-vector
+  // attachment, which only the single-sample scene pass has; its descriptors
+  // follow the pool like the HiZ pyramids.
+  std::unique_ptr<vkwave::TemporalAA> m_taa;
+  bool m_graph_has_velocity{ false };
+
+  // GTAO over the scene depth, present whenever TAA is (same inputs).
+  std::unique_ptr<vkwave::AmbientOcclusion> m_ao;
+
+  // Ray queries: one compacted BLAS per unique geometry of the active model
+  // (one for the legacy mesh) and a TLAS over every instance of them at pbr
+  // set 2, binding 5. The BLASes are rebuilt by update_ray_tracing(); the TLAS
+  // persists (one instance region per slot), rebuilt on a model switch and
+  // refit when the instances move (move_instances()). Both survive every
+  // graph rebuild.
+  bool m_ray_query{ false };
+  std::vector<vkwave::AccelerationStructure> m_blases;
+  std::unique_ptr<vkwave::PersistentTlas> m_tlas;
+  uint32_t m_tlas_generation{ 0 }; // PersistentTlas::generation() last written
+
+  /// Write the scene TLAS to set 2's sceneTLAS of `group` (no-op without ray query).
+  void write_tlas_descriptor(vkwave::ExecutionGroup& group);
+
+  // The ray tracing pipeline over the same TLAS (its instances' SBT offsets
+  // pick the material hit groups): created with the pipeline when the device
+  // has one, its scene set by upload_material_buffer() (the materials, IBL
+  // and mesh it reads all change through there), its per-slot sets following
+  // the pool's HDR like the OIT resolve's.
+  std::unique_ptr<vkwave::SceneRayTracer> m_ray_tracer;
+
+  // Single-pass mip chain for the transmission snapshot (roughness-blurred
+  // refraction). Null when unsupported; its views follow the pool like the
+  // TAA descriptors, but only while the transmission pass exists.
+  std::unique_ptr<vkwave::MipDownsampler> m_snapshot_mips;
+
+  // Compute composite replacing the composite group's render pass. Its sets
+  // reference the swapchain images, so they follow the swapchain (resize), not
+  // the graph; the exposure state persists.
+  std::unique_ptr<vkwave::ComputeComposite> m_compute_composite;
+
+  // Bloom, chromatic aberration and vignette over the finished HDR, recorded
+  // by the post-FX group, or after the TAA resolve (composite submission)
+  // while TAA is on. Its scratch image is a pool resource and its sets follow
+  // the pool like the TAA ones. With m_async_post_fx the group submits on the
+  // dedicated compute queue and the HDR + scratch are registered
+  // compute_shared.
+  std::unique_ptr<vkwave::PostFxChain> m_post_fx;
+  vkwave::BloomPass* m_bloom{ nullptr };
+  vkwave::ChromaticAberrationPass* m_chromatic_aberration{ nullptr };
+  vkwave::VignettePass* m_vignette{ nullptr };
+  bool m_async_post_fx{ false };
+
+  /// Switch the (new) composite group to the compute composite: no render
+  /// pass, and the acquire wait moved up to the compute stage. No-op without it.
+  void configure_compute_composite();
+
+  /// Write the per-material textures (set 1) of `group`.
+  void write_material_textures(vkwave::ExecutionGroup& group, SceneData& data);
+
+  /// Write the per-slot light buffers to pbr set 0, bindings 1-3.
+  void write_light_descriptors();
+
+  /// Write fallback white to pbr set 0, binding 4 of every slot: what the
+  /// scene pass reads until bind_ao() (always, when multisampled).
+  void write_ao_descriptors(SceneData& data);
+
+  /// Bind the per-slot snapshot to the transmission group's snapshotTex (no-op
+  /// without the group). Again whenever the snapshot sampler changes.
+  void bind_snapshot();
+
   /// (Re)create the scene render pass + register pool resources + add groups +
   /// wire the DAG + build + write descriptors, deciding the transmission pass in
   /// from data.has_transmission() and the current MSAA. Shared by the
@@ -90,6 +332,25 @@ private:
   /// already be registered. Shared by build_scene_graph() and rebuild_for_msaa().
   vkwave::ExecutionGroup& add_transmission_group(SceneData& data);
 
+  /// Add + configure the OIT offscreen group (colors = accum + revealage,
+  /// depth = shared, pbr descriptor counts). Pool resources must already be
+  /// registered. Shared by build_scene_graph() and rebuild_for_msaa().
+  vkwave::ExecutionGroup& add_oit_group(SceneData& data);
+
+  /// Add the post-FX compute group (always the last offscreen group, so the
+  /// scene groups keep their indices). Shared by build_scene_graph() and
+  /// rebuild_for_msaa().
+  vkwave::SubmissionGroup& add_post_fx_group();
+
+  // Per-instance model matrices (vertex binding 1 of the PBR pipelines), one
+  // host-written region per slot so moving instances never touches a region a
+  // frame in flight reads. The buffer is replaced per model load like the
+  // material SSBO; a slot's region is rewritten when its version falls behind.
+  std::unique_ptr<vkwave::Buffer> m_instance_buffer;
+  std::vector<glm::mat4> m_instance_transforms;
+  uint64_t m_instance_version{ 0 };
+  std::vector<uint64_t> m_slot_instance_version; // [slot]
+
   // Immutable per-material constants (GpuMaterial[]), shared across all frames.
   // Built once per model load; only the descriptor is rewritten on rebuild.
   std::unique_ptr<vkwave::Buffer> material_buffer;
@@ -1,5 +1,7 @@
 #include "screenshot.h"
 
+#include <vkwave/core/format_select.h>
+
 #include <spdlog/spdlog.h>
 
 #define STB_IMAGE_WRITE_IMPLEMENTATION
@@ -43,6 +45,24 @@ static float half_to_float(uint16_t h)
   return result;
 }
 
+// ---------------------------------------------------------------------------
+// Unsigned packed float → float (the 11- and 10-bit channels of
+// B10G11R11_UFLOAT: 5-bit exponent, bias 15, `mant_bits` of mantissa, no sign)
+// ---------------------------------------------------------------------------
+
+static float ufloat_to_float(uint32_t bits, int mant_bits)
+{
+  const uint32_t exp  = (bits >> mant_bits) & 0x1f;
+  const uint32_t mant = bits & ((1u << mant_bits) - 1);
+  const float scale = static_cast<float>(1u << mant_bits);
+
+  if (exp == 0)
+    return std::ldexp(static_cast<float>(mant) / scale, -14); // zero / denormal
+  if (exp == 31)
+    return mant == 0 ? INFINITY : NAN;
+  return std::ldexp(1.0f + static_cast<float>(mant) / scale, static_cast<int>(exp) - 15);
+}
+
 // ---------------------------------------------------------------------------
 // GPU copy: HDR image → HOST_VISIBLE buffer
 // ---------------------------------------------------------------------------
@@ -50,11 +70,14 @@ static float half_to_float(uint16_t h)
 void record_hdr_screenshot_copy(vk::CommandBuffer cmd,
                                 vk::Image hdr_image,
                                 vk::Extent2D extent,
-                                vk::Buffer readback_buf)
+                                vk::Format format,
+                                vk::Buffer readback_buf,
+                                uint32_t layers)
 {
   const uint32_t w = extent.width;
   const uint32_t h = extent.height;
-  const vk::DeviceSize byte_size = static_cast<vk::DeviceSize>(w) * h * 8; // RGBA16F = 8 bytes/pixel
+  const vk::DeviceSize layer_size = static_cast<vk::DeviceSize>(w) * h * vkwave::texel_size(format);
+  const vk::DeviceSize byte_size = layer_size * layers;
 
   // Barrier: eShaderReadOnlyOptimal → eTransferSrcOptimal
   vk::ImageMemoryBarrier to_src{};
@@ -63,20 +86,24 @@ void record_hdr_screenshot_copy(vk::CommandBuffer cmd,
   to_src.oldLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
   to_src.newLayout = vk::ImageLayout::eTransferSrcOptimal;
   to_src.image = hdr_image;
-  to_src.subresourceRange = { vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1 };
+  to_src.subresourceRange = { vk::ImageAspectFlagBits::eColor, 0, 1, 0, layers };
 
   cmd.pipelineBarrier(
     vk::PipelineStageFlagBits::eColorAttachmentOutput,
     vk::PipelineStageFlagBits::eTransfer,
     {}, {}, {}, to_src);
 
-  // Copy image → buffer
-  vk::BufferImageCopy region{};
-  region.imageSubresource = { vk::ImageAspectFlagBits::eColor, 0, 0, 1 };
-  region.imageExtent = vk::Extent3D{ w, h, 1 };
+  // Copy image → buffer (one region per layer, packed back to back)
+  std::vector<vk::BufferImageCopy> regions(layers);
+  for (uint32_t layer = 0; layer < layers; ++layer)
+  {
+    regions[layer].bufferOffset = layer * layer_size;
+    regions[layer].imageSubresource = { vk::ImageAspectFlagBits::eColor, 0, layer, 1 };
+    regions[layer].imageExtent = vk::Extent3D{ w, h, 1 };
+  }
 
   cmd.copyImageToBuffer(hdr_image, vk::ImageLayout::eTransferSrcOptimal,
-    readback_buf, region);
+    readback_buf, regions);
 
   // Barrier: eTransferSrcOptimal → eShaderReadOnlyOptimal
   // (composite pass needs to sample this image)
@@ -86,7 +113,7 @@ void record_hdr_screenshot_copy(vk::CommandBuffer cmd,
   to_shader.oldLayout = vk::ImageLayout::eTransferSrcOptimal;
   to_shader.newLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
   to_shader.image = hdr_image;
-  to_shader.subresourceRange = { vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1 };
+  to_shader.subresourceRange = { vk::ImageAspectFlagBits::eColor, 0, 1, 0, layers };
 
   // Host read barrier on the buffer
   vk::BufferMemoryBarrier host_barrier{};
@@ -116,53 +143,66 @@ static void png_write_to_vector(void* context, void* data, int size)
 // HDR → LDR conversion + PNG compression
 // ---------------------------------------------------------------------------
 
-std::vector<uint8_t> compress_screenshot(vkwave::Buffer& readback,
-                                         vk::Format format,
-                                         vk::Extent2D extent)
+// Convert `extent` pixels of `format` at `data` to RGBA8.
+static std::vector<uint8_t> to_ldr(const uint8_t* data, vk::Format format,
+                                   vk::Extent2D extent)
 {
   const uint32_t w = extent.width;
   const uint32_t h = extent.height;
 
-  readback.map();
-
   std::vector<uint8_t> ldr(w * h * 4);
 
+  // Simple Reinhard tonemap + gamma 2.2
+  auto tonemap = [](float c) {
+    c = std::pow(c / (1.0f + c), 1.0f / 2.2f);
+    return static_cast<uint8_t>(std::clamp(c, 0.0f, 1.0f) * 255.0f + 0.5f);
+  };
+
   if (format == vk::Format::eR16G16B16A16Sfloat)
   {
-    // HDR float16 → LDR uint8 with Reinhard tonemap + gamma
-    auto* f16 = static_cast<const uint16_t*>(readback.mapped_data());
+    // HDR float16 → LDR uint8
+    auto* f16 = reinterpret_cast<const uint16_t*>(data);
+    for (uint32_t i = 0; i < w * h; ++i)
+    {
+      ldr[i * 4 + 0] = tonemap(half_to_float(f16[i * 4 + 0]));
+      ldr[i * 4 + 1] = tonemap(half_to_float(f16[i * 4 + 1]));
+      ldr[i * 4 + 2] = tonemap(half_to_float(f16[i * 4 + 2]));
+      ldr[i * 4 + 3] = 255;
+    }
+  }
+  else if (format == vk::Format::eB10G11R11UfloatPack32)
+  {
+    // Packed HDR (R in the low bits despite the name) → LDR uint8
+    auto* packed = reinterpret_cast<const uint32_t*>(data);
     for (uint32_t i = 0; i < w * h; ++i)
     {
-      float r = half_to_float(f16[i * 4 + 0]);
-      float g = half_to_float(f16[i * 4 + 1]);
-      float b = half_to_float(f16[i * 4 + 2]);
-
-      // Simple Reinhard tonemap + gamma 2.2
-      r = std::pow(r / (1.0f + r), 1.0f / 2.2f);
-      g = std::pow(g / (1.0f + g), 1.0f / 2.2f);
-      b = std::pow(b / (1.0f + b), 1.0f / 2.2f);
-
-      ldr[i * 4 + 0] = static_cast<uint8_t>(std::clamp(r, 0.0f, 1.0f) * 255.0f + 0.5f);
-      ldr[i * 4 + 1] = static_cast<uint8_t>(std::clamp(g, 0.0f, 1.0f) * 255.0f + 0.5f);
-      ldr[i * 4 + 2] = static_cast<uint8_t>(std::clamp(b, 0.0f, 1.0f) * 255.0f + 0.5f);
+      const uint32_t p = packed[i];
+      ldr[i * 4 + 0] = tonemap(ufloat_to_float(p & 0x7ff, 6));
+      ldr[i * 4 + 1] = tonemap(ufloat_to_float((p >> 11) & 0x7ff, 6));
+      ldr[i * 4 + 2] = tonemap(ufloat_to_float(p >> 22, 5));
       ldr[i * 4 + 3] = 255;
     }
   }
   else
   {
     // Legacy: uint8 BGRA/RGBA swapchain format
-    auto* pixels = static_cast<uint8_t*>(readback.mapped_data());
     const bool bgra = (format == vk::Format::eB8G8R8A8Srgb
                     || format == vk::Format::eB8G8R8A8Unorm);
-    std::memcpy(ldr.data(), pixels, w * h * 4);
+    std::memcpy(ldr.data(), data, w * h * 4);
     if (bgra)
     {
       for (uint32_t i = 0; i < w * h; ++i)
         std::swap(ldr[i * 4 + 0], ldr[i * 4 + 2]);
     }
   }
+  return ldr;
+}
 
-  readback.unmap();
+static std::vector<uint8_t> compress_ldr(const std::vector<uint8_t>& ldr,
+                                         vk::Extent2D extent)
+{
+  const uint32_t w = extent.width;
+  const uint32_t h = extent.height;
 
   std::vector<uint8_t> png_data;
   png_data.reserve(w * h);
@@ -173,6 +213,25 @@ std::vector<uint8_t> compress_screenshot(vkwave::Buffer& readback,
   return png_data;
 }
 
+std::vector<uint8_t> compress_screenshot(vkwave::Buffer& readback,
+                                         vk::Format format,
+                                         vk::Extent2D extent,
+                                         vk::DeviceSize offset)
+{
+  readback.map();
+  auto ldr = to_ldr(static_cast<const uint8_t*>(readback.mapped_data()) + offset,
+    format, extent);
+  readback.unmap();
+
+  return compress_ldr(ldr, extent);
+}
+
+std::vector<uint8_t> encode_png(const void* pixels, vk::Format format,
+                                vk::Extent2D extent)
+{
+  return compress_ldr(to_ldr(static_cast<const uint8_t*>(pixels), format, extent), extent);
+}
+
 void write_screenshot(const std::vector<uint8_t>& png_data,
                       const std::string& filename)
 {
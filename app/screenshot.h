@@ -6,8 +6,8 @@
  *
  * @par Design overview
  *
- * Screenshots are captured from the offscreen R16G16B16A16_SFLOAT image that
- * the PBR pass writes to.  This image is already ring-buffered, single-sample
+ * Screenshots are captured from the offscreen HDR image (R16G16B16A16_SFLOAT,
+ * or B10G11R11_UFLOAT_PACK32 with compact formats) that the PBR pass writes to.  This image is already ring-buffered, single-sample
  * (MSAA resolves inside the render pass), and owned by us — not the swapchain.
  *
  * @par Why this is fast
@@ -59,7 +59,7 @@
  *              └───────────┬──────────────────────────┘
  *                          │  signaled
  *              ┌───────────▼──────────────────────────┐
- *   worker     │  map, half→float, Reinhard tonemap,  │
+ *   worker     │  map, decode, Reinhard tonemap,      │
  *   thread     │  gamma, PNG compress, unmap          │
  *              └───────────┬──────────────────────────┘
  *                          │
@@ -81,19 +81,32 @@
 /// The image must be in eShaderReadOnlyOptimal layout (post-render-pass).
 /// After the copy, the image is transitioned back to eShaderReadOnlyOptimal
 /// so the composite pass can sample it normally.
+/// With `layers` > 1 (a multiview target) every layer is copied in the same
+/// command, layer i at byte offset i * w * h * texel_size(format).
 void record_hdr_screenshot_copy(vk::CommandBuffer cmd,
                                 vk::Image hdr_image,
                                 vk::Extent2D extent,
-                                vk::Buffer readback_buf);
+                                vk::Format format,
+                                vk::Buffer readback_buf,
+                                uint32_t layers = 1);
 
-/// Map HOST_VISIBLE buffer, convert HDR float16 to LDR uint8 with tonemap,
-/// compress to PNG in memory, unmap.
+/// Map HOST_VISIBLE buffer, convert HDR (float16 or packed B10G11R11) to LDR
+/// uint8 with tonemap, compress to PNG in memory, unmap.
 /// CPU-heavy (tonemap + zlib) — safe to call from a background thread.
 /// Returns the PNG file contents as a byte vector.
+/// @param offset byte offset of the image in `readback` (a layer of a
+///               multi-layer copy).
 std::vector<uint8_t> compress_screenshot(vkwave::Buffer& readback,
                                          vk::Format format,
-                                         vk::Extent2D extent);
+                                         vk::Extent2D extent,
+                                         vk::DeviceSize offset = 0);
 
-/// Write pre-compressed PNG data to disk. Call from the main thread.
+/// compress_screenshot() for pixels already in host memory (e.g. copied out of
+/// the readback buffer so it can be reused). Safe to call from any thread.
+std::vector<uint8_t> encode_png(const void* pixels, vk::Format format,
+                                vk::Extent2D extent);
+
+/// Write pre-compressed PNG data to disk. The interactive capture calls it
+/// from the main thread; the batch encoders (PngEncoderPool) from theirs.
 void write_screenshot(const std::vector<uint8_t>& png_data,
                       const std::string& filename);
@@ -0,0 +1,202 @@
+#include "turntable.h"
+#include "engine.h"
+#include "png_encoder_pool.h"
+#include "scene.h"
+#include "screenshot.h"
+
+#include <vkwave/core/buffer.h>
+#include <vkwave/core/camera.h>
+#include <vkwave/core/deletion_queue.h>
+#include <vkwave/core/device.h>
+#include <vkwave/core/format_select.h>
+#include <vkwave/pipeline/execution_group.h>
+#include <vkwave/pipeline/pipeline.h>
+
+#include <spdlog/fmt/fmt.h>
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+static constexpr bool kDebug =
+#ifdef VKWAVE_DEBUG
+  true;
+#else
+  false;
+#endif
+
+TurntableRenderer::TurntableRenderer(Engine& app, Scene& scene)
+  : m_engine(&app)
+  , m_scene(&scene)
+{
+  auto& device = *app.device;
+  m_batch = std::min(vkwave::kMaxPbrViews, device.max_multiview_views());
+  if (m_batch == 0)
+  {
+    spdlog::error("Turntable: device has no multiview support");
+    return;
+  }
+  m_extent = app.swapchain->extent();
+  const vk::Format hdr_format = scene.pipeline->hdr_format;
+  const vk::Format depth_format = scene.pipeline->depth_format;
+
+  // Scene pass with a view mask: single-sample, no motion vectors (TAA needs a
+  // history per camera), depth discarded (no transmission / HiZ here).
+  m_renderpass = vkwave::make_scene_renderpass(device.device(),
+    hdr_format, depth_format, kDebug,
+    vk::SampleCountFlagBits::e1, false, vk::Format::eUndefined, (1u << m_batch) - 1u);
+
+  // One slot: batches run back to back, each drained before its readback.
+  m_hdr = m_pool.add_color("turntable_hdr", hdr_format,
+    vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eSampled
+      | vk::ImageUsageFlagBits::eTransferSrc);
+  auto depth = m_pool.add_depth("turntable_depth", depth_format);
+  m_pool.create(device, m_extent, 1, m_batch);
+
+  // Same shaders and layout as the pbr group; the pipeline is built against the
+  // multiview render pass (dynamic rendering would need the view mask in the
+  // pipeline's rendering info instead).
+  auto spec = vkwave::PBRPass::pipeline_spec();
+  scene.pipeline->configure_pbr_spec(spec);
+  spec.existing_renderpass = m_renderpass;
+  spec.dynamic_rendering = false;
+  spec.depth_format = depth_format;
+  m_group = std::make_unique<vkwave::ExecutionGroup>(
+    device, "turntable", spec, hdr_format, kDebug);
+  m_group->set_signal_present(false);
+  m_group->set_color_attachment(m_pool, m_hdr);
+  m_group->set_depth_attachment(m_pool, depth);
+
+  m_group->set_record_fn([this](vk::CommandBuffer cmd, uint32_t /*frame_index*/) {
+    m_pbr.record(cmd);
+    m_blend.record(cmd);
+  });
+  m_group->set_post_record_fn([this, hdr_format](vk::CommandBuffer cmd, uint32_t /*slot_index*/) {
+    record_hdr_screenshot_copy(cmd, m_pool.color_image(m_hdr, 0), m_extent, hdr_format,
+      m_readback->buffer(), m_batch);
+  });
+
+  // All layers of a batch in one readback, mapped for the renderer's lifetime.
+  const vk::DeviceSize layer_bytes =
+    static_cast<vk::DeviceSize>(m_extent.width) * m_extent.height * vkwave::texel_size(hdr_format);
+  m_readback = std::make_unique<vkwave::Buffer>(device, "turntable readback",
+    layer_bytes * m_batch, vk::BufferUsageFlagBits::eTransferDst,
+    vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent);
+  m_readback->map();
+
+  bind_scene();
+}
+
+TurntableRenderer::~TurntableRenderer()
+{
+  m_readback.reset();
+  m_group.reset();
+  if (m_renderpass)
+  {
+    auto dev = m_engine->device->device();
+    m_engine->device->deletion_queue().push(
+      [dev, pass = m_renderpass] { dev.destroyRenderPass(pass); });
+  }
+}
+
+void TurntableRenderer::bind_scene()
+{
+  if (!m_group)
+    return;
+  auto& data = m_scene->data;
+
+  // Fresh descriptor sets sized for the current materials (the previous ones
+  // are retired through the deletion queue, like rebuild_pbr_descriptors()).
+  m_group->destroy_frame_resources();
+  m_group->set_descriptor_count(1, data.material_count());
+  m_group->set_descriptor_count(2, 1);
+  m_group->create_frame_resources(m_extent, 1);
+  m_scene->pipeline->write_multiview_descriptors(*m_group, data);
+
+  // The scene's pass state, with everything that follows a single camera off.
+  m_ctx = m_scene->pbr_ctx;
+  m_ctx.group = m_group.get();
+  m_ctx.views = &m_views;
+  m_ctx.shadow = nullptr;
+  m_ctx.light_count = 0;
+  m_ctx.draw_commands = VK_NULL_HANDLE;
+  m_ctx.defer_transmissive = false;
+  m_ctx.weighted_oit = false; // no OIT group here: BlendPass sorts against view 0
+  m_ctx.screen_space_ao = false; // the scene's AO is of its own camera
+  // Ray-traced shadows/reflections are view-independent: kept as the scene has them.
+  m_pbr = m_scene->pbr_pass;
+  m_pbr.ctx = &m_ctx;
+  m_blend.ctx = &m_ctx;
+}
+
+void TurntableRenderer::render(std::span<const float> azimuths,
+                               const std::string& prefix, PngEncoderPool& encoder)
+{
+  if (!m_group)
+    return;
+  auto& device = *m_engine->device;
+
+  vkwave::Camera camera = m_scene->data.camera;
+  camera.set_jitter(glm::vec2(0.0f));
+  camera.set_aspect_ratio(
+    static_cast<float>(m_extent.width) / static_cast<float>(m_extent.height));
+
+  const auto total = static_cast<uint32_t>(azimuths.size());
+  const vk::Format hdr_format = m_scene->pipeline->hdr_format;
+  const size_t layer_bytes =
+    static_cast<size_t>(m_extent.width) * m_extent.height * vkwave::texel_size(hdr_format);
+  const auto* mapped = static_cast<const uint8_t*>(m_readback->mapped_data());
+
+  for (uint32_t first = 0; first < total; first += m_batch)
+  {
+    // A short last batch repeats its final camera in the unused layers (the
+    // view mask is baked into the render pass).
+    const uint32_t count = std::min(m_batch, total - first);
+    m_views.count = m_batch;
+    for (uint32_t v = 0; v < m_batch; ++v)
+    {
+      vkwave::Camera view = camera;
+      view.azimuth(azimuths[first + std::min(v, count - 1)]);
+      m_views.view_projection[v] = view.view_projection_matrix();
+      m_views.cam_position[v] = view.position();
+    }
+    // Single-camera fields: the blend pass sorts against view 0.
+    m_ctx.view_projection = m_ctx.unjittered_view_projection = m_ctx.prev_view_projection =
+      m_views.view_projection[0];
+    m_ctx.cam_position = m_views.cam_position[0];
+
+    m_group->begin_frame(0);
+    m_group->submit(0, {}, device.graphics_queue());
+    m_group->drain();
+
+    // Copy the layers out so the next batch can reuse the readback while the
+    // encoders work.
+    for (uint32_t v = 0; v < count; ++v)
+    {
+      std::vector<uint8_t> pixels(layer_bytes);
+      std::memcpy(pixels.data(), mapped + v * layer_bytes, layer_bytes);
+      encoder.submit(std::move(pixels), hdr_format, m_extent,
+        fmt::format("{}_{:03}.png", prefix, first + v));
+    }
+  }
+}
+
+bool capture_turntable(Engine& app, Scene& scene, uint32_t views,
+                       const std::string& prefix)
+{
+  TurntableRenderer renderer(app, scene);
+  if (!renderer.valid())
+    return false;
+
+  std::vector<float> azimuths(views);
+  for (uint32_t i = 0; i < views; ++i)
+    azimuths[i] = 360.0f * static_cast<float>(i) / static_cast<float>(views);
+
+  PngEncoderPool encoder;
+  spdlog::info("Turntable: {} views, {} per multiview batch, {} encoder threads",
+    views, renderer.batch_size(), encoder.thread_count());
+  renderer.render(azimuths, prefix, encoder);
+  encoder.wait();
+  return true;
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <vkwave/core/pbr_ubo.h>
+#include <vkwave/pipeline/frame_resource_pool.h>
+#include <vkwave/pipeline/pbr_pass.h>
+
+#include <vulkan/vulkan.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+
+struct Engine;
+struct Scene;
+class PngEncoderPool;
+namespace vkwave { class Buffer; class ExecutionGroup; }
+
+/// Offline multi-camera renderer: images of the scene's model orbited about
+/// the camera's focal point, for turntables and batch thumbnails.
+///
+/// Views are rendered in multiview batches (VK_KHR_multiview): one
+/// ExecutionGroup draws up to kMaxPbrViews cameras per submission into the
+/// layers of an array HDR target, so geometry, material binds and draw calls
+/// are paid once per batch instead of once per view. pbr.vert picks each
+/// layer's camera by gl_ViewIndex; all layers come back in one copy.
+///
+/// The batch renders the opaque + blend passes with IBL and the directional
+/// light. Shadows, clustered lights, the transmission pass and TAA follow a
+/// single camera and are left out.
+///
+/// Works outside the render graph and drains its own submissions; use it
+/// before (or instead of) the frame loop.
+class TurntableRenderer
+{
+public:
+  /// Builds the multiview pass and pipeline. Leaves valid() false if the
+  /// device has no multiview.
+  TurntableRenderer(Engine& app, Scene& scene);
+  ~TurntableRenderer();
+
+  TurntableRenderer(const TurntableRenderer&) = delete;
+  TurntableRenderer& operator=(const TurntableRenderer&) = delete;
+
+  [[nodiscard]] bool valid() const { return m_group != nullptr; }
+
+  /// Views per submission (min of kMaxPbrViews and the device limit).
+  [[nodiscard]] uint32_t batch_size() const { return m_batch; }
+
+  /// Re-point the descriptors at the scene's current model and environment.
+  /// Call after every model or IBL switch (the constructor binds the first).
+  void bind_scene();
+
+  /// Render one image per azimuth (degrees about the focal point, relative to
+  /// the scene camera) and queue it on `encoder` as `<prefix>_NNN.png`.
+  void render(std::span<const float> azimuths, const std::string& prefix,
+              PngEncoderPool& encoder);
+
+private:
+  Engine* m_engine;
+  Scene* m_scene;
+  uint32_t m_batch{ 0 };
+  vk::Extent2D m_extent{};
+
+  vk::RenderPass m_renderpass{ VK_NULL_HANDLE };
+  vkwave::FrameResourcePool m_pool;
+  vkwave::FrameResourcePool::ColorHandle m_hdr{ 0 };
+  std::unique_ptr<vkwave::ExecutionGroup> m_group;
+  std::unique_ptr<vkwave::Buffer> m_readback; // all layers of one batch
+
+  // The scene's pass state with the multiview cameras (see render()).
+  vkwave::PbrViews m_views{};
+  vkwave::PBRContext m_ctx{};
+  vkwave::PBRPass m_pbr{};
+  vkwave::BlendPass m_blend{};
+};
+
+/// `views` images at azimuth steps of 360 / views, written as
+/// `<prefix>_NNN.png`. Returns false if the device has no multiview.
+bool capture_turntable(Engine& app, Scene& scene, uint32_t views,
+                       const std::string& prefix);
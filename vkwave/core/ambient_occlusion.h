@@ -0,0 +1,68 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+#include <vulkan/vulkan.hpp>
+
+namespace vkwave
+{
+
+/// GTAO sample counts (gtao.comp's SLICE_COUNT / STEPS_PER_SIDE): slices
+/// around the view vector, and depth samples on each side of every slice.
+/// Fixed, so the pass costs the same per texel whatever the radius; the
+/// temporal accumulation makes up for the low count.
+inline constexpr uint32_t kGtaoSlices = 2;
+inline constexpr uint32_t kGtaoStepsPerSide = 4;
+
+/// Push constants for gtao.comp (one half-resolution dispatch per frame).
+struct GtaoPushConstants
+{
+  glm::mat4 invProjection; // 64 bytes — depth -> view space (the projection the depth was drawn with)
+  glm::vec4 renderSize;    // 16 bytes — xy=render extent, zw=1 / render extent
+  glm::vec2 projScale;     //  8 bytes — pixels per view unit at clip w = 1 (signed)
+  glm::ivec2 region;       //  8 bytes — half-resolution texels to write
+  float radius;            //  4 bytes — world-space search radius
+  float intensity;         //  4 bytes — exponent on the visibility
+  uint32_t frame;          //  4 bytes — animates the sampling noise
+  float pad;               //  4 bytes
+};
+
+static_assert(sizeof(GtaoPushConstants) == 112,
+  "GtaoPushConstants must be 112 bytes to match shader layout");
+static_assert(sizeof(GtaoPushConstants) <= 128,
+  "Push constants must fit in 128 bytes (guaranteed minimum)");
+
+/// Push constants for ao_resolve.comp (one target-sized dispatch per frame).
+struct AoResolvePushConstants
+{
+  glm::vec4 renderScale; // 16 bytes — xy=render extent / target extent, zw=1 / target extent
+  glm::vec4 depthParams; // 16 bytes — view z from depth d: (x * d + y) / (z * d + w)
+  glm::ivec2 rawRegion;  //  8 bytes — texels gtao.comp wrote
+  float feedback;        //  4 bytes — weight of the current frame (1 = no history)
+  float pad;             //  4 bytes
+};
+
+static_assert(sizeof(AoResolvePushConstants) == 48,
+  "AoResolvePushConstants must be 48 bytes to match shader layout");
+
+/// Half-resolution extent GTAO covers for `extent` (rounded up, so every
+/// full-resolution texel has a 2x2 parent).
+inline vk::Extent2D gtao_extent(vk::Extent2D extent)
+{
+  return { std::max((extent.width + 1) / 2, 1u), std::max((extent.height + 1) / 2, 1u) };
+}
+
+/// AoResolvePushConstants::depthParams for `inv_projection`: the z and w rows
+/// of the inverse projection restricted to the depth, so the resolve can
+/// linearize depth without the whole matrix. Exact for the perspective and
+/// parallel projections (and their jittered forms), whose view z and w do
+/// not depend on the screen position.
+inline glm::vec4 view_depth_params(const glm::mat4& inv_projection)
+{
+  return glm::vec4(inv_projection[2][2], inv_projection[3][2],
+    inv_projection[2][3], inv_projection[3][3]);
+}
+
+} // namespace vkwave
@@ -1,5 +1,6 @@
 #include <vkwave/core/buffer.h>
 #include <vkwave/core/commands.h>
+#include <vkwave/core/deletion_queue.h>
 #include <vkwave/core/device.h>
 
 #include <spdlog/spdlog.h>
@@ -73,19 +74,18 @@ Buffer::~Buffer()
     unmap();
   }
 
-  if (m_buffer)
-  {
-    m_device->device().destroyBuffer(m_buffer);
-    m_buffer = VK_NULL_HANDLE;
-  }
-
-  if (m_memory)
-  {
-    m_device->device().freeMemory(m_memory);
-    m_memory = VK_NULL_HANDLE;
-  }
-
-  spdlog::trace("Destroyed buffer '{}'", m_name);
+  // The GPU may still read it: destroy once the submitted work has finished.
+  m_device->deletion_queue().push(
+    [device = m_device->device(), buffer = m_buffer, memory = m_memory] {
+      if (buffer)
+        device.destroyBuffer(buffer);
+      if (memory)
+        device.freeMemory(memory);
+    });
+  m_buffer = VK_NULL_HANDLE;
+  m_memory = VK_NULL_HANDLE;
+
+  spdlog::trace("Retired buffer '{}'", m_name);
 }
 
 Buffer::Buffer(Buffer&& other) noexcept
@@ -116,14 +116,13 @@ Buffer& Buffer::operator=(Buffer&& other) noexcept
       {
         unmap();
       }
-      if (m_buffer)
-      {
-        m_device->device().destroyBuffer(m_buffer);
-      }
-      if (m_memory)
-      {
-        m_device->device().freeMemory(m_memory);
-      }
+      m_device->deletion_queue().push(
+        [device = m_device->device(), buffer = m_buffer, memory = m_memory] {
+          if (buffer)
+            device.destroyBuffer(buffer);
+          if (memory)
+            device.freeMemory(memory);
+        });
     }
 
     // Move from other
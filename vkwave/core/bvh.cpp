@@ -0,0 +1,405 @@
+#include <vkwave/core/bvh.h>
+
+#include <algorithm>
+#include <cassert>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define VKWAVE_BVH_SSE 1
+#include <emmintrin.h>
+#endif
+
+namespace vkwave
+{
+
+namespace
+{
+
+struct Box
+{
+  glm::vec3 min{ std::numeric_limits<float>::max() };
+  glm::vec3 max{ std::numeric_limits<float>::lowest() };
+
+  void expand(const glm::vec3& p)
+  {
+    min = glm::min(min, p);
+    max = glm::max(max, p);
+  }
+
+  void expand(const Box& b)
+  {
+    min = glm::min(min, b.min);
+    max = glm::max(max, b.max);
+  }
+
+  [[nodiscard]] float area() const
+  {
+    const glm::vec3 d = glm::max(max - min, glm::vec3(0.0f));
+    return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+  }
+};
+
+// SAH bins per split, and the binary depth past which splits fall back to the
+// median (bounds the tree depth, and with it the traversal stack).
+constexpr uint32_t kBins = 12;
+constexpr uint32_t kMedianDepth = 48;
+constexpr uint32_t kStackSize = 256;
+
+/// Binary SAH tree; collapsed into Bvh4::Node afterwards.
+struct BinaryBuilder
+{
+  struct Node
+  {
+    Box box;
+    uint32_t left{ 0 };
+    uint32_t right{ 0 };
+    uint32_t first{ 0 };
+    uint32_t count{ 0 }; // > 0: leaf over order[first, first + count)
+  };
+
+  std::vector<Box> boxes;          // [triangle]
+  std::vector<glm::vec3> centroids; // [triangle]
+  std::vector<uint32_t> order;     // leaf ranges index this
+  std::vector<Node> nodes;
+
+  uint32_t build(uint32_t first, uint32_t count, uint32_t depth)
+  {
+    const auto index = static_cast<uint32_t>(nodes.size());
+    nodes.emplace_back();
+
+    Box box, centroid_box;
+    for (uint32_t i = first; i < first + count; ++i)
+    {
+      box.expand(boxes[order[i]]);
+      centroid_box.expand(centroids[order[i]]);
+    }
+    nodes[index].box = box;
+
+    if (count <= Bvh4::kMaxLeafTriangles)
+    {
+      nodes[index].first = first;
+      nodes[index].count = count;
+      return index;
+    }
+
+    const glm::vec3 extent = centroid_box.max - centroid_box.min;
+    int axis = 0;
+    if (extent.y > extent[axis]) axis = 1;
+    if (extent.z > extent[axis]) axis = 2;
+
+    const auto begin = order.begin() + first;
+    const auto end = begin + count;
+    uint32_t mid = first;
+    if (extent[axis] > 0.0f && depth < kMedianDepth)
+    {
+      const float lo = centroid_box.min[axis];
+      const float scale = static_cast<float>(kBins) / extent[axis];
+      auto bin_of = [&](uint32_t t) {
+        const auto b = static_cast<uint32_t>((centroids[t][axis] - lo) * scale);
+        return std::min(b, kBins - 1);
+      };
+
+      Box bin_boxes[kBins];
+      uint32_t bin_counts[kBins]{};
+      for (auto it = begin; it != end; ++it)
+      {
+        const uint32_t b = bin_of(*it);
+        bin_boxes[b].expand(boxes[*it]);
+        ++bin_counts[b];
+      }
+
+      // Sweep: cost of splitting after bin i is the SAH of both sides.
+      float left_area[kBins - 1];
+      uint32_t left_count[kBins - 1];
+      Box acc;
+      uint32_t n = 0;
+      for (uint32_t i = 0; i < kBins - 1; ++i)
+      {
+        acc.expand(bin_boxes[i]);
+        n += bin_counts[i];
+        left_area[i] = n ? acc.area() : 0.0f;
+        left_count[i] = n;
+      }
+      float best_cost = std::numeric_limits<float>::max();
+      uint32_t best = 0;
+      acc = Box{};
+      n = 0;
+      for (uint32_t i = kBins - 1; i > 0; --i)
+      {
+        acc.expand(bin_boxes[i]);
+        n += bin_counts[i];
+        const float cost = left_count[i - 1] * left_area[i - 1] + n * (n ? acc.area() : 0.0f);
+        if (left_count[i - 1] > 0 && n > 0 && cost < best_cost)
+        {
+          best_cost = cost;
+          best = i - 1;
+        }
+      }
+
+      mid = static_cast<uint32_t>(std::partition(begin, end,
+        [&](uint32_t t) { return bin_of(t) <= best; }) - order.begin());
+    }
+    if (mid == first || mid == first + count)
+    {
+      // Coincident centroids, or past kMedianDepth: split the count in half.
+      mid = first + count / 2;
+      std::nth_element(begin, order.begin() + mid, end,
+        [&](uint32_t a, uint32_t b) { return centroids[a][axis] < centroids[b][axis]; });
+    }
+
+    const uint32_t left = build(first, mid - first, depth + 1);
+    const uint32_t right = build(mid, first + count - mid, depth + 1);
+    nodes[index].left = left;
+    nodes[index].right = right;
+    return index;
+  }
+};
+
+void set_slot(Bvh4::Node& node, uint32_t slot, const Box& box)
+{
+  node.min_x[slot] = box.min.x;
+  node.min_y[slot] = box.min.y;
+  node.min_z[slot] = box.min.z;
+  node.max_x[slot] = box.max.x;
+  node.max_y[slot] = box.max.y;
+  node.max_z[slot] = box.max.z;
+}
+
+} // anonymous namespace
+
+Bvh4::Bvh4(std::span<const glm::vec3> positions, std::span<const uint8_t> masks)
+{
+  const auto triangle_count = static_cast<uint32_t>(positions.size() / 3);
+  if (triangle_count == 0)
+    return;
+
+  BinaryBuilder builder;
+  builder.boxes.resize(triangle_count);
+  builder.centroids.resize(triangle_count);
+  builder.order.resize(triangle_count);
+  for (uint32_t t = 0; t < triangle_count; ++t)
+  {
+    Box box;
+    box.expand(positions[3 * t + 0]);
+    box.expand(positions[3 * t + 1]);
+    box.expand(positions[3 * t + 2]);
+    builder.boxes[t] = box;
+    builder.centroids[t] = 0.5f * (box.min + box.max);
+    builder.order[t] = t;
+  }
+  builder.nodes.reserve(2 * triangle_count / kMaxLeafTriangles + 1);
+  builder.build(0, triangle_count, 0);
+
+  // Leaves index the builder order, so the triangles are stored in it.
+  m_index = builder.order;
+  m_v0.resize(triangle_count);
+  m_e1.resize(triangle_count);
+  m_e2.resize(triangle_count);
+  m_masks.resize(triangle_count, 0xFF);
+  for (uint32_t i = 0; i < triangle_count; ++i)
+  {
+    const uint32_t t = m_index[i];
+    m_v0[i] = positions[3 * t + 0];
+    m_e1[i] = positions[3 * t + 1] - m_v0[i];
+    m_e2[i] = positions[3 * t + 2] - m_v0[i];
+    if (t < masks.size())
+      m_masks[i] = masks[t];
+  }
+
+  // Collapse: each wide node takes its binary node's two children, then keeps
+  // replacing the inner child of largest area by its two children while a
+  // slot is free.
+  const auto& bnodes = builder.nodes;
+  auto collapse = [&](auto&& self, uint32_t binary, uint32_t depth) -> uint32_t
+  {
+    m_depth = std::max(m_depth, depth);
+    const auto index = static_cast<uint32_t>(m_nodes.size());
+    m_nodes.emplace_back(Node{});
+
+    uint32_t kids[kWidth];
+    uint32_t n = 0;
+    if (bnodes[binary].count > 0)
+    {
+      kids[n++] = binary; // leaf root
+    }
+    else
+    {
+      kids[n++] = bnodes[binary].left;
+      kids[n++] = bnodes[binary].right;
+    }
+    while (n < kWidth)
+    {
+      uint32_t widest = UINT32_MAX;
+      float widest_area = -1.0f;
+      for (uint32_t i = 0; i < n; ++i)
+      {
+        const auto& k = bnodes[kids[i]];
+        if (k.count == 0 && k.box.area() > widest_area)
+        {
+          widest = i;
+          widest_area = k.box.area();
+        }
+      }
+      if (widest == UINT32_MAX)
+        break;
+      const uint32_t split = kids[widest];
+      kids[widest] = bnodes[split].left;
+      kids[n++] = bnodes[split].right;
+    }
+
+    m_nodes[index].slots = n;
+    for (uint32_t i = 0; i < n; ++i)
+    {
+      const auto& k = bnodes[kids[i]];
+      set_slot(m_nodes[index], i, k.box);
+      if (k.count > 0)
+      {
+        m_nodes[index].child[i] = k.first;
+        m_nodes[index].count[i] = k.count;
+      }
+      else
+      {
+        const uint32_t child = self(self, kids[i], depth + 1);
+        m_nodes[index].child[i] = child;
+        m_nodes[index].count[i] = 0;
+      }
+    }
+    return index;
+  };
+  collapse(collapse, 0, 1);
+}
+
+template <bool AnyHit>
+bool Bvh4::traverse(const BvhRay& ray, BvhHit& hit) const
+{
+  if (m_nodes.empty())
+    return false;
+
+  const glm::vec3 inv = 1.0f / ray.direction; // +-inf on axis-parallel rays
+  float t_max = ray.t_max;
+  bool found = false;
+
+#ifdef VKWAVE_BVH_SSE
+  const __m128 ox = _mm_set1_ps(ray.origin.x);
+  const __m128 oy = _mm_set1_ps(ray.origin.y);
+  const __m128 oz = _mm_set1_ps(ray.origin.z);
+  const __m128 ix = _mm_set1_ps(inv.x);
+  const __m128 iy = _mm_set1_ps(inv.y);
+  const __m128 iz = _mm_set1_ps(inv.z);
+  const __m128 t_min4 = _mm_set1_ps(ray.t_min);
+#endif
+
+  uint32_t stack[kStackSize];
+  uint32_t sp = 0;
+  stack[sp++] = 0;
+  while (sp > 0)
+  {
+    const Node& node = m_nodes[stack[--sp]];
+
+    // Slab test against the four child boxes at once.
+    alignas(16) float t_near[kWidth];
+    uint32_t hits;
+#ifdef VKWAVE_BVH_SSE
+    const __m128 tx0 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.min_x), ox), ix);
+    const __m128 tx1 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.max_x), ox), ix);
+    const __m128 ty0 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.min_y), oy), iy);
+    const __m128 ty1 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.max_y), oy), iy);
+    const __m128 tz0 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.min_z), oz), iz);
+    const __m128 tz1 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.max_z), oz), iz);
+    const __m128 t_enter = _mm_max_ps(
+      _mm_max_ps(_mm_min_ps(tx0, tx1), _mm_min_ps(ty0, ty1)),
+      _mm_max_ps(_mm_min_ps(tz0, tz1), t_min4));
+    const __m128 t_exit = _mm_min_ps(
+      _mm_min_ps(_mm_max_ps(tx0, tx1), _mm_max_ps(ty0, ty1)),
+      _mm_min_ps(_mm_max_ps(tz0, tz1), _mm_set1_ps(t_max)));
+    _mm_store_ps(t_near, t_enter);
+    hits = static_cast<uint32_t>(_mm_movemask_ps(_mm_cmple_ps(t_enter, t_exit)));
+#else
+    hits = 0;
+    for (uint32_t i = 0; i < kWidth; ++i)
+    {
+      const float tx0 = (node.min_x[i] - ray.origin.x) * inv.x;
+      const float tx1 = (node.max_x[i] - ray.origin.x) * inv.x;
+      const float ty0 = (node.min_y[i] - ray.origin.y) * inv.y;
+      const float ty1 = (node.max_y[i] - ray.origin.y) * inv.y;
+      const float tz0 = (node.min_z[i] - ray.origin.z) * inv.z;
+      const float tz1 = (node.max_z[i] - ray.origin.z) * inv.z;
+      const float t_enter = std::max(std::max(std::min(tx0, tx1), std::min(ty0, ty1)),
+        std::max(std::min(tz0, tz1), ray.t_min));
+      const float t_exit = std::min(std::min(std::max(tx0, tx1), std::max(ty0, ty1)),
+        std::min(std::max(tz0, tz1), t_max));
+      t_near[i] = t_enter;
+      if (t_enter <= t_exit)
+        hits |= 1u << i;
+    }
+#endif
+    hits &= (1u << node.slots) - 1u;
+
+    // Leaves now; inner children are pushed far to near so the nearest pops first.
+    uint32_t inner[kWidth];
+    uint32_t inner_count = 0;
+    for (uint32_t i = 0; i < kWidth; ++i)
+    {
+      if (!(hits & (1u << i)))
+        continue;
+      if (node.count[i] == 0)
+      {
+        inner[inner_count++] = i;
+        continue;
+      }
+      for (uint32_t k = node.child[i]; k < node.child[i] + node.count[i]; ++k)
+      {
+        if (!(m_masks[k] & ray.mask))
+          continue;
+        // Moller-Trumbore
+        const glm::vec3 p = glm::cross(ray.direction, m_e2[k]);
+        const float det = glm::dot(m_e1[k], p);
+        if (det == 0.0f)
+          continue;
+        const float inv_det = 1.0f / det;
+        const glm::vec3 s = ray.origin - m_v0[k];
+        const float u = glm::dot(s, p) * inv_det;
+        if (u < 0.0f || u > 1.0f)
+          continue;
+        const glm::vec3 q = glm::cross(s, m_e1[k]);
+        const float v = glm::dot(ray.direction, q) * inv_det;
+        if (v < 0.0f || u + v > 1.0f)
+          continue;
+        const float t = glm::dot(m_e2[k], q) * inv_det;
+        if (t < ray.t_min || t >= t_max)
+          continue;
+        if constexpr (AnyHit)
+          return true;
+        t_max = t;
+        hit.t = t;
+        hit.u = u;
+        hit.v = v;
+        hit.triangle = m_index[k];
+        found = true;
+      }
+    }
+
+    for (uint32_t i = 1; i < inner_count; ++i)
+      for (uint32_t j = i; j > 0 && t_near[inner[j]] < t_near[inner[j - 1]]; --j)
+        std::swap(inner[j], inner[j - 1]);
+    assert(sp + inner_count <= kStackSize);
+    for (uint32_t i = inner_count; i > 0; --i)
+      stack[sp++] = node.child[inner[i - 1]];
+  }
+  return found;
+}
+
+BvhHit Bvh4::intersect(const BvhRay& ray) const
+{
+  BvhHit hit;
+  traverse<false>(ray, hit);
+  return hit;
+}
+
+bool Bvh4::occluded(const BvhRay& ray) const
+{
+  BvhHit hit;
+  return traverse<true>(ray, hit);
+}
+
+} // namespace vkwave
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <vector>
+
+namespace vkwave
+{
+
+/// A ray for Bvh4. `direction` need not be normalized (t is in its units);
+/// only triangles whose mask shares a bit with `mask` are considered, like a
+/// TLAS instance mask.
+struct BvhRay
+{
+  glm::vec3 origin{ 0.0f };
+  glm::vec3 direction{ 0.0f, 0.0f, 1.0f };
+  float t_min{ 0.0f };
+  float t_max{ std::numeric_limits<float>::infinity() };
+  uint8_t mask{ 0xFF };
+};
+
+/// Closest hit of a ray: distance, barycentrics of vertices 1 and 2, and the
+/// triangle's index in the positions the BVH was built from.
+struct BvhHit
+{
+  float t{ std::numeric_limits<float>::infinity() };
+  float u{ 0.0f };
+  float v{ 0.0f };
+  uint32_t triangle{ UINT32_MAX };
+
+  [[nodiscard]] bool valid() const { return triangle != UINT32_MAX; }
+};
+
+/// Four-wide bounding volume hierarchy over triangles, for CPU ray tracing.
+///
+/// Built as a binary tree with binned SAH splits, then collapsed so every node
+/// holds up to four children whose boxes are stored structure-of-arrays: one
+/// traversal step tests a ray against all four with SSE (scalar loop where
+/// SSE is unavailable) and descends nearest first. Leaves hold up to
+/// kMaxLeafTriangles triangles, stored reordered with precomputed edges.
+///
+/// Immutable after construction; intersect() and occluded() may be called
+/// from any number of threads.
+class Bvh4
+{
+public:
+  static constexpr uint32_t kWidth = 4;
+  static constexpr uint32_t kMaxLeafTriangles = 4;
+
+  struct alignas(16) Node
+  {
+    float min_x[kWidth];
+    float min_y[kWidth];
+    float min_z[kWidth];
+    float max_x[kWidth];
+    float max_y[kWidth];
+    float max_z[kWidth];
+    // count == 0: child is an inner node index; count > 0: child is the
+    // first leaf triangle. Only the first `slots` entries are used.
+    uint32_t child[kWidth];
+    uint32_t count[kWidth];
+    uint32_t slots;
+  };
+
+  Bvh4() = default;
+
+  /// Build over `positions`, three per triangle. `masks` (one per triangle,
+  /// default all 0xFF) is tested against BvhRay::mask.
+  explicit Bvh4(std::span<const glm::vec3> positions, std::span<const uint8_t> masks = {});
+
+  /// Closest hit in [t_min, t_max), or an invalid hit.
+  [[nodiscard]] BvhHit intersect(const BvhRay& ray) const;
+
+  /// True if anything lies in [t_min, t_max) (stops at the first hit).
+  [[nodiscard]] bool occluded(const BvhRay& ray) const;
+
+  [[nodiscard]] size_t node_count() const { return m_nodes.size(); }
+  [[nodiscard]] size_t triangle_count() const { return m_index.size(); }
+  [[nodiscard]] bool empty() const { return m_index.empty(); }
+
+  /// Depth of the deepest leaf (root = 1), for build statistics.
+  [[nodiscard]] uint32_t depth() const { return m_depth; }
+
+private:
+  template <bool AnyHit>
+  bool traverse(const BvhRay& ray, BvhHit& hit) const;
+
+  std::vector<Node> m_nodes; // [0] is the root
+  // Reordered triangles: v0 and the edges v1 - v0, v2 - v0.
+  std::vector<glm::vec3> m_v0;
+  std::vector<glm::vec3> m_e1;
+  std::vector<glm::vec3> m_e2;
+  std::vector<uint8_t> m_masks;
+  std::vector<uint32_t> m_index; // reordered -> input triangle
+  uint32_t m_depth{ 0 };
+};
+
+} // namespace vkwave
@@ -26,6 +26,7 @@ void Camera::set_position(const glm::vec3& position)
 {
   m_position = position;
   orthogonalize_view_up();
+  ++m_revision;
 }
 
 void Camera::set_focal_point(float x, float y, float z)
@@ -37,6 +38,7 @@ void Camera::set_focal_point(const glm::vec3& focal_point)
 {
   m_focal_point = focal_point;
   orthogonalize_view_up();
+  ++m_revision;
 }
 
 void Camera::set_view_up(float x, float y, float z)
@@ -48,6 +50,7 @@ void Camera::set_view_up(const glm::vec3& view_up)
 {
   m_view_up = view_up;
   orthogonalize_view_up();
+  ++m_revision;
 }
 
 float Camera::distance() const
@@ -74,26 +77,36 @@ void Camera::set_clipping_range(float near_plane, float far_plane)
 {
   m_near_plane = std::max(near_plane, 0.0001f);
   m_far_plane = std::max(far_plane, m_near_plane + 0.0001f);
+  ++m_revision;
 }
 
 void Camera::set_view_angle(float angle_degrees)
 {
   m_view_angle = std::clamp(angle_degrees, 1.0f, 179.0f);
+  ++m_revision;
 }
 
 void Camera::set_aspect_ratio(float aspect)
 {
-  m_aspect_ratio = std::max(aspect, 0.001f);
+  // Called every frame with the current extent: only a real change counts.
+  const float clamped = std::max(aspect, 0.001f);
+  if (clamped != m_aspect_ratio)
+  {
+    m_aspect_ratio = clamped;
+    ++m_revision;
+  }
 }
 
 void Camera::set_parallel_projection(bool parallel)
 {
   m_parallel_projection = parallel;
+  ++m_revision;
 }
 
 void Camera::set_parallel_scale(float scale)
 {
   m_parallel_scale = std::max(scale, 0.0001f);
+  ++m_revision;
 }
 
 //-----------------------------------------------------------------------------
@@ -111,6 +124,7 @@ void Camera::azimuth(float angle_degrees)
 
   m_position = m_focal_point + new_offset;
   orthogonalize_view_up();
+  ++m_revision;
 }
 
 void Camera::elevation(float angle_degrees)
@@ -130,6 +144,7 @@ void Camera::elevation(float angle_degrees)
   // Also rotate view-up to maintain orientation
   m_view_up = glm::normalize(glm::vec3(rotation * glm::vec4(m_view_up, 0.0f)));
   orthogonalize_view_up();
+  ++m_revision;
 }
 
 void Camera::roll(float angle_degrees)
@@ -142,6 +157,7 @@ void Camera::roll(float angle_degrees)
 
   m_view_up = glm::normalize(glm::vec3(rotation * glm::vec4(m_view_up, 0.0f)));
   orthogonalize_view_up();
+  ++m_revision;
 }
 
 void Camera::yaw(float angle_degrees)
@@ -155,6 +171,7 @@ void Camera::yaw(float angle_degrees)
 
   m_focal_point = m_position + new_offset;
   orthogonalize_view_up();
+  ++m_revision;
 }
 
 void Camera::pitch(float angle_degrees)
@@ -174,6 +191,7 @@ void Camera::pitch(float angle_degrees)
   // Also rotate view-up to maintain orientation
   m_view_up = glm::normalize(glm::vec3(rotation * glm::vec4(m_view_up, 0.0f)));
   orthogonalize_view_up();
+  ++m_revision;
 }
 
 void Camera::dolly(float factor)
@@ -189,6 +207,7 @@ void Camera::dolly(float factor)
   float new_dist = dist / factor;
 
   m_position = m_focal_point - direction * new_dist;
+  ++m_revision;
 }
 
 void Camera::pan(float dx, float dy)
@@ -202,6 +221,7 @@ void Camera::pan(float dx, float dy)
   glm::vec3 offset = right * dx + up * dy;
   m_position += offset;
   m_focal_point += offset;
+  ++m_revision;
 }
 
 void Camera::zoom(float factor)
@@ -221,6 +241,7 @@ void Camera::zoom(float factor)
     m_view_angle /= factor;
     m_view_angle = std::clamp(m_view_angle, 1.0f, 179.0f);
   }
+  ++m_revision;
 }
 
 void Camera::reset_camera(const float bounds[6])
@@ -291,6 +312,7 @@ void Camera::reset_clipping_range(const float bounds[6])
 
   m_near_plane = std::max(0.001f, dist - radius);
   m_far_plane = std::max(m_near_plane + 0.001f, dist + radius);
+  ++m_revision;
 }
 
 //-----------------------------------------------------------------------------
@@ -306,23 +328,32 @@ glm::mat4 Camera::projection_matrix() const
 {
   glm::mat4 proj;
 
+  // Reversed-Z: the near plane maps to depth 1 and the far one to 0, so the
+  // float depth buffer's precision goes where perspective compresses it.
   if (m_parallel_projection)
   {
     float half_width = m_parallel_scale * m_aspect_ratio;
     float half_height = m_parallel_scale;
     proj = glm::ortho(-half_width, half_width, -half_height, half_height,
-                      m_near_plane, m_far_plane);
+                      m_far_plane, m_near_plane);
   }
   else
   {
-    proj = glm::perspective(glm::radians(m_view_angle), m_aspect_ratio,
-                            m_near_plane, m_far_plane);
+    // Infinite far plane: depth = near / view distance, reaching 0 only at
+    // infinity (m_far_plane still bounds shading: light clusters, cascades).
+    const float f = 1.0f / std::tan(glm::radians(m_view_angle) * 0.5f);
+    proj = glm::mat4(0.0f);
+    proj[0][0] = f / m_aspect_ratio;
+    proj[1][1] = f;
+    proj[2][3] = -1.0f;
+    proj[3][2] = m_near_plane;
   }
 
   if (m_use_vulkan_clip)
   {
     // Vulkan clip space: Y is inverted compared to OpenGL.
-    // GLM_FORCE_DEPTH_ZERO_TO_ONE (set in CMakeLists.txt) handles Z [0,1].
+    // GLM_FORCE_DEPTH_ZERO_TO_ONE (set in CMakeLists.txt) handles Z [0,1]
+    // for the parallel projection; the perspective one is built for it.
     proj[1][1] *= -1.0f;
   }
 
@@ -334,6 +365,23 @@ glm::mat4 Camera::view_projection_matrix() const
   return projection_matrix() * view_matrix();
 }
 
+glm::mat4 Camera::jittered_projection_matrix() const
+{
+  // Post-projection translate: clip.xy += jitter * clip.w, i.e. a constant NDC
+  // shift for both perspective and parallel projection.
+  glm::mat4 proj = projection_matrix();
+  proj[2][0] += m_jitter.x * proj[2][3];
+  proj[2][1] += m_jitter.y * proj[2][3];
+  proj[3][0] += m_jitter.x * proj[3][3];
+  proj[3][1] += m_jitter.y * proj[3][3];
+  return proj;
+}
+
+glm::mat4 Camera::jittered_view_projection_matrix() const
+{
+  return jittered_projection_matrix() * view_matrix();
+}
+
 //-----------------------------------------------------------------------------
 // Convenience Methods
 //-----------------------------------------------------------------------------
@@ -345,11 +393,13 @@ void Camera::set(const glm::vec3& position, const glm::vec3& focal_point,
   m_focal_point = focal_point;
   m_view_up = view_up;
   orthogonalize_view_up();
+  ++m_revision;
 }
 
 void Camera::set_use_vulkan_clip(bool use_vulkan)
 {
   m_use_vulkan_clip = use_vulkan;
+  ++m_revision;
 }
 
 //-----------------------------------------------------------------------------
@@ -3,6 +3,8 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
+#include <cstdint>
+
 namespace vkwave
 {
 
@@ -139,12 +141,25 @@ public:
   /// Transforms world coordinates to camera/view coordinates.
   [[nodiscard]] glm::mat4 view_matrix() const;
 
-  /// Get the projection matrix (perspective or orthographic).
+  /// Get the projection matrix (perspective or orthographic), reversed-Z:
+  /// depth 1 at the near plane, 0 at the far one. The perspective projection
+  /// has an infinite far plane; far_plane() bounds only the parallel one.
   [[nodiscard]] glm::mat4 projection_matrix() const;
 
   /// Get the combined view-projection matrix.
   [[nodiscard]] glm::mat4 view_projection_matrix() const;
 
+  /// Set a sub-pixel clip-space offset applied by the jittered matrices (for
+  /// temporal anti-aliasing). In NDC units: one pixel is 2 / extent.
+  void set_jitter(const glm::vec2& ndc_offset) { m_jitter = ndc_offset; }
+  [[nodiscard]] glm::vec2 jitter() const { return m_jitter; }
+
+  /// projection_matrix() translated by the jitter in clip space.
+  [[nodiscard]] glm::mat4 jittered_projection_matrix() const;
+
+  /// Combined view-projection matrix including the jitter.
+  [[nodiscard]] glm::mat4 jittered_view_projection_matrix() const;
+
   //-------------------------------------------------------------------------
   // Convenience Methods
   //-------------------------------------------------------------------------
@@ -157,6 +172,11 @@ public:
   void set_use_vulkan_clip(bool use_vulkan);
   [[nodiscard]] bool use_vulkan_clip() const { return m_use_vulkan_clip; }
 
+  /// Incremented by every mutator that changes the view or projection (the
+  /// jitter excluded). Compare against a stored value to detect a camera that
+  /// moved since the last frame.
+  [[nodiscard]] uint64_t revision() const { return m_revision; }
+
 private:
   void orthogonalize_view_up();
 
@@ -173,6 +193,10 @@ private:
   float m_parallel_scale{ 1.0f };
 
   bool m_use_vulkan_clip{ true };
+
+  glm::vec2 m_jitter{ 0.0f };
+
+  uint64_t m_revision{ 0 };
 };
 
 } // namespace vkwave
@@ -8,12 +8,13 @@
 
 namespace vkwave
 {
-vk::CommandPool make_command_pool(const Device& device0, bool debug)
+vk::CommandPool make_command_pool(const Device& device0, bool debug, bool compute)
 {
 
   const vk::Device device = device0.device();
 
-  uint32_t queueFamilyIndex = device0.m_graphics_queue_family_index;
+  uint32_t queueFamilyIndex = compute ? device0.m_compute_queue_family_index
+                                      : device0.m_graphics_queue_family_index;
 
   vk::CommandPoolCreateInfo poolInfo;
   poolInfo.flags =
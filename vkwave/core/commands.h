@@ -30,10 +30,11 @@ struct commandBufferInputChunk
         \param physicalDevice the physical device
         \param the windows surface (used for getting the queue families)
         \param debug whether the system is running in debug mode
+        \param compute allocate from the compute queue's family (async compute)
         \returns the created command pool
 */
 
-vk::CommandPool make_command_pool(const Device& device0, bool debug);
+vk::CommandPool make_command_pool(const Device& device0, bool debug, bool compute = false);
 
 /**
         Make a command buffer for each swapchain frame and return a main command buffer.
@@ -0,0 +1,111 @@
+#include <vkwave/core/deletion_queue.h>
+
+#include <iterator>
+#include <stdexcept>
+
+namespace vkwave
+{
+
+DeletionQueue::DeletionQueue(vk::Device device)
+  : m_device(device)
+{
+  vk::SemaphoreTypeCreateInfo type_info{};
+  type_info.semaphoreType = vk::SemaphoreType::eTimeline;
+  type_info.initialValue = 0;
+
+  vk::SemaphoreCreateInfo ci{};
+  ci.pNext = &type_info;
+  m_timeline = m_device.createSemaphore(ci);
+}
+
+DeletionQueue::~DeletionQueue()
+{
+  flush();
+  if (m_timeline)
+    m_device.destroySemaphore(m_timeline);
+}
+
+uint64_t DeletionQueue::poll()
+{
+  m_completed = m_device.getSemaphoreCounterValue(m_timeline);
+  return m_completed;
+}
+
+void DeletionQueue::wait(uint64_t value)
+{
+  if (value <= m_completed)
+    return;
+
+  vk::SemaphoreWaitInfo wait_info{};
+  wait_info.semaphoreCount = 1;
+  wait_info.pSemaphores = &m_timeline;
+  wait_info.pValues = &value;
+
+  if (m_device.waitSemaphores(wait_info, UINT64_MAX) != vk::Result::eSuccess)
+    throw std::runtime_error("DeletionQueue::wait failed");
+  m_completed = value;
+}
+
+void DeletionQueue::push(std::function<void()> destroy)
+{
+  // Nothing in flight (idle, or the work already retired): no need to queue.
+  if (m_submitted > m_completed)
+    poll();
+  m_retired.push(m_submitted, m_completed, std::move(destroy));
+}
+
+uint32_t DeletionQueue::collect()
+{
+  if (m_retired.size() == 0)
+    return 0;
+  return m_retired.collect(poll());
+}
+
+void DeletionQueue::flush()
+{
+  m_retired.flush();
+  m_completed = m_submitted;
+}
+
+// --- RetireList ---
+
+void RetireList::push(uint64_t after, uint64_t completed, std::function<void()> destroy)
+{
+  if (after <= completed)
+  {
+    destroy();
+    return;
+  }
+  m_entries.push_back({ after, std::move(destroy) });
+}
+
+uint32_t RetireList::collect(uint64_t reached)
+{
+  // Entries are pushed in value order: run the prefix the timeline has
+  // passed. Take it out first — a destroy may push again (a group owning
+  // Images).
+  auto end = m_entries.begin();
+  while (end != m_entries.end() && end->after <= reached)
+    ++end;
+  std::vector<Entry> ready(std::make_move_iterator(m_entries.begin()),
+    std::make_move_iterator(end));
+  m_entries.erase(m_entries.begin(), end);
+
+  for (auto& e : ready)
+    e.destroy();
+  return static_cast<uint32_t>(ready.size());
+}
+
+void RetireList::flush()
+{
+  // A destroy may retire more (a group owning Images): loop until empty.
+  while (!m_entries.empty())
+  {
+    auto entries = std::move(m_entries);
+    m_entries.clear();
+    for (auto& e : entries)
+      e.destroy();
+  }
+}
+
+} // namespace vkwave
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace vkwave
+{
+
+/// Destructions waiting for a timeline value: DeletionQueue's bookkeeping,
+/// without the semaphore. Entries are tagged with the value after which they
+/// may run and kept in push order (tags never decrease).
+class RetireList
+{
+  struct Entry
+  {
+    uint64_t after{ 0 };
+    std::function<void()> destroy;
+  };
+
+  std::vector<Entry> m_entries;
+
+public:
+  /// Run `destroy` once the timeline reaches `after`: right away when
+  /// `completed` already has.
+  void push(uint64_t after, uint64_t completed, std::function<void()> destroy);
+
+  /// Run every entry tagged at or below `reached`. A destroy may push again;
+  /// those entries wait for the next collect(). Returns the number run.
+  uint32_t collect(uint64_t reached);
+
+  /// Run every entry, including those pushed by destroys.
+  void flush();
+
+  [[nodiscard]] size_t size() const { return m_entries.size(); }
+};
+
+/// Device-wide deferred destruction.
+///
+/// Owns one timeline semaphore that every graph submission also signals, with
+/// strictly increasing values (next_signal_value()). Destroying something the
+/// GPU may still use means pushing its destruction here: the entry is tagged
+/// with the latest value handed out and run once the timeline reaches it. When
+/// everything submitted has already completed (e.g. after a drain) the entry
+/// runs right away, so RAII destructors can always defer.
+///
+/// Owned by the Device (Device::deletion_queue()) and flushed before the
+/// device is destroyed. collect() never blocks; flush() frees everything and is
+/// only valid when the GPU is idle.
+class DeletionQueue
+{
+  vk::Device m_device;
+  vk::Semaphore m_timeline{ VK_NULL_HANDLE };
+  uint64_t m_submitted{ 0 }; // last value handed out by next_signal_value()
+  uint64_t m_completed{ 0 }; // last counter value read back
+  RetireList m_retired;
+
+  // Refresh m_completed from the semaphore counter.
+  uint64_t poll();
+
+public:
+  explicit DeletionQueue(vk::Device device);
+  ~DeletionQueue();
+
+  DeletionQueue(const DeletionQueue&) = delete;
+  DeletionQueue& operator=(const DeletionQueue&) = delete;
+  DeletionQueue(DeletionQueue&&) = delete;
+  DeletionQueue& operator=(DeletionQueue&&) = delete;
+
+  /// The device timeline. Submissions signal it with next_signal_value().
+  [[nodiscard]] vk::Semaphore timeline() const { return m_timeline; }
+
+  /// Reserve the signal value for a submission about to be made. Values must
+  /// be signaled in the order they are handed out (one queue, or ordered
+  /// submits).
+  [[nodiscard]] uint64_t next_signal_value() { return ++m_submitted; }
+
+  /// Latest value handed out (0 = nothing submitted yet).
+  [[nodiscard]] uint64_t submitted_value() const { return m_submitted; }
+
+  /// Block until the device timeline reaches `value`.
+  void wait(uint64_t value);
+
+  /// Run `destroy` once the GPU has finished everything submitted so far.
+  void push(std::function<void()> destroy);
+
+  /// Free every entry the GPU has passed. Non-blocking.
+  /// Returns the number of entries freed.
+  uint32_t collect();
+
+  /// Free every entry now. The GPU must be idle.
+  void flush();
+
+  [[nodiscard]] size_t size() const { return m_retired.size(); }
+};
+
+} // namespace vkwave
@@ -1,4 +1,5 @@
 #include <vkwave/core/depth_stencil_attachment.h>
+#include <vkwave/core/deletion_queue.h>
 #include <vkwave/core/device.h>
 
 #include <spdlog/spdlog.h>
@@ -8,7 +9,7 @@
 namespace vkwave
 {
 
-static bool format_has_stencil(vk::Format fmt)
+bool format_has_stencil(vk::Format fmt)
 {
   return fmt == vk::Format::eD32SfloatS8Uint ||
          fmt == vk::Format::eD24UnormS8Uint ||
@@ -18,8 +19,9 @@ static bool format_has_stencil(vk::Format fmt)
 
 DepthStencilAttachment::DepthStencilAttachment(const Device& device, vk::Format format,
   vk::Extent2D extent, vk::SampleCountFlagBits samples,
-  vk::ImageUsageFlags extraUsage)
-  : m_vkDevice(device.device()), m_format(format), m_extent(extent)
+  vk::ImageUsageFlags extraUsage, uint32_t layers)
+  : m_vkDevice(device.device()), m_deletionQueue(&device.deletion_queue()),
+    m_format(format), m_extent(extent), m_layers(layers)
 {
   const bool stencil = format_has_stencil(format);
 
@@ -35,7 +37,7 @@ DepthStencilAttachment::DepthStencilAttachment(const Device& device, vk::Format
   imageInfo.extent.height = extent.height;
   imageInfo.extent.depth = 1;
   imageInfo.mipLevels = 1;
-  imageInfo.arrayLayers = 1;
+  imageInfo.arrayLayers = layers;
   imageInfo.format = format;
   imageInfo.tiling = vk::ImageTiling::eOptimal;
   imageInfo.initialLayout = vk::ImageLayout::eUndefined;
@@ -57,17 +59,20 @@ DepthStencilAttachment::DepthStencilAttachment(const Device& device, vk::Format
   m_memory = m_vkDevice.allocateMemory(allocInfo);
   m_vkDevice.bindImageMemory(m_image, m_memory, 0);
 
+  const vk::ImageViewType viewType = layers > 1
+    ? vk::ImageViewType::e2DArray : vk::ImageViewType::e2D;
+
   // Combined view (depth + stencil aspects)
   {
     vk::ImageViewCreateInfo viewInfo{};
     viewInfo.image = m_image;
-    viewInfo.viewType = vk::ImageViewType::e2D;
+    viewInfo.viewType = viewType;
     viewInfo.format = format;
     viewInfo.subresourceRange.aspectMask = fullAspect;
     viewInfo.subresourceRange.baseMipLevel = 0;
     viewInfo.subresourceRange.levelCount = 1;
     viewInfo.subresourceRange.baseArrayLayer = 0;
-    viewInfo.subresourceRange.layerCount = 1;
+    viewInfo.subresourceRange.layerCount = layers;
 
     m_combinedView = m_vkDevice.createImageView(viewInfo);
   }
@@ -76,13 +81,13 @@ DepthStencilAttachment::DepthStencilAttachment(const Device& device, vk::Format
   {
     vk::ImageViewCreateInfo viewInfo{};
     viewInfo.image = m_image;
-    viewInfo.viewType = vk::ImageViewType::e2D;
+    viewInfo.viewType = viewType;
     viewInfo.format = format;
     viewInfo.subresourceRange.aspectMask = vk::ImageAspectFlagBits::eDepth;
     viewInfo.subresourceRange.baseMipLevel = 0;
     viewInfo.subresourceRange.levelCount = 1;
     viewInfo.subresourceRange.baseArrayLayer = 0;
-    viewInfo.subresourceRange.layerCount = 1;
+    viewInfo.subresourceRange.layerCount = layers;
 
     m_depthView = m_vkDevice.createImageView(viewInfo);
   }
@@ -92,13 +97,13 @@ DepthStencilAttachment::DepthStencilAttachment(const Device& device, vk::Format
   {
     vk::ImageViewCreateInfo viewInfo{};
     viewInfo.image = m_image;
-    viewInfo.viewType = vk::ImageViewType::e2D;
+    viewInfo.viewType = viewType;
     viewInfo.format = format;
     viewInfo.subresourceRange.aspectMask = vk::ImageAspectFlagBits::eStencil;
     viewInfo.subresourceRange.baseMipLevel = 0;
     viewInfo.subresourceRange.levelCount = 1;
     viewInfo.subresourceRange.baseArrayLayer = 0;
-    viewInfo.subresourceRange.layerCount = 1;
+    viewInfo.subresourceRange.layerCount = layers;
 
     m_stencilView = m_vkDevice.createImageView(viewInfo);
   }
@@ -114,13 +119,15 @@ DepthStencilAttachment::~DepthStencilAttachment()
 
 DepthStencilAttachment::DepthStencilAttachment(DepthStencilAttachment&& other) noexcept
   : m_vkDevice(other.m_vkDevice),
+    m_deletionQueue(other.m_deletionQueue),
     m_image(std::exchange(other.m_image, VK_NULL_HANDLE)),
     m_memory(std::exchange(other.m_memory, VK_NULL_HANDLE)),
     m_combinedView(std::exchange(other.m_combinedView, VK_NULL_HANDLE)),
     m_depthView(std::exchange(other.m_depthView, VK_NULL_HANDLE)),
     m_stencilView(std::exchange(other.m_stencilView, VK_NULL_HANDLE)),
     m_format(other.m_format),
-    m_extent(other.m_extent)
+    m_extent(other.m_extent),
+    m_layers(other.m_layers)
 {
 }
 
@@ -130,6 +137,7 @@ DepthStencilAttachment& DepthStencilAttachment::operator=(DepthStencilAttachment
   {
     destroy();
     m_vkDevice = other.m_vkDevice;
+    m_deletionQueue = other.m_deletionQueue;
     m_image = std::exchange(other.m_image, VK_NULL_HANDLE);
     m_memory = std::exchange(other.m_memory, VK_NULL_HANDLE);
     m_combinedView = std::exchange(other.m_combinedView, VK_NULL_HANDLE);
@@ -137,6 +145,7 @@ DepthStencilAttachment& DepthStencilAttachment::operator=(DepthStencilAttachment
     m_stencilView = std::exchange(other.m_stencilView, VK_NULL_HANDLE);
     m_format = other.m_format;
     m_extent = other.m_extent;
+    m_layers = other.m_layers;
   }
   return *this;
 }
@@ -148,19 +157,23 @@ bool DepthStencilAttachment::has_stencil() const
 
 void DepthStencilAttachment::destroy()
 {
-  if (!m_vkDevice)
+  if (!m_vkDevice || !m_image)
     return;
 
-  if (m_stencilView)
-    m_vkDevice.destroyImageView(m_stencilView);
-  if (m_depthView)
-    m_vkDevice.destroyImageView(m_depthView);
-  if (m_combinedView)
-    m_vkDevice.destroyImageView(m_combinedView);
-  if (m_image)
-    m_vkDevice.destroyImage(m_image);
-  if (m_memory)
-    m_vkDevice.freeMemory(m_memory);
+  m_deletionQueue->push([device = m_vkDevice, stencilView = m_stencilView,
+                          depthView = m_depthView, combinedView = m_combinedView,
+                          image = m_image, memory = m_memory] {
+    if (stencilView)
+      device.destroyImageView(stencilView);
+    if (depthView)
+      device.destroyImageView(depthView);
+    if (combinedView)
+      device.destroyImageView(combinedView);
+    if (image)
+      device.destroyImage(image);
+    if (memory)
+      device.freeMemory(memory);
+  });
 
   m_stencilView = VK_NULL_HANDLE;
   m_depthView = VK_NULL_HANDLE;
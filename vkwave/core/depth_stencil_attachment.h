@@ -5,8 +5,12 @@
 namespace vkwave
 {
 
+class DeletionQueue;
 class Device;
 
+/// True for depth formats with a stencil component (e.g. D32SfloatS8Uint).
+[[nodiscard]] bool format_has_stencil(vk::Format fmt);
+
 /// RAII wrapper for a depth-stencil image with separate aspect views.
 ///
 /// Creates one VkImage with the requested depth(-stencil) format and up to
@@ -16,13 +20,14 @@ class Device;
 ///   - stencil_view():  stencil-only aspect (for sampling stencil in compute)
 ///
 /// The stencil view is only created when the format actually has a stencil
-/// component (e.g. D32SfloatS8Uint, D24UnormS8Uint).
+/// component (e.g. D32SfloatS8Uint, D24UnormS8Uint). With `layers` > 1 the
+/// image is a 2D array and every view spans all layers (multiview depth).
 class DepthStencilAttachment
 {
 public:
   DepthStencilAttachment(const Device& device, vk::Format format,
     vk::Extent2D extent, vk::SampleCountFlagBits samples,
-    vk::ImageUsageFlags extraUsage = {});
+    vk::ImageUsageFlags extraUsage = {}, uint32_t layers = 1);
   ~DepthStencilAttachment();
 
   DepthStencilAttachment(const DepthStencilAttachment&) = delete;
@@ -33,6 +38,7 @@ public:
   [[nodiscard]] vk::Image image() const { return m_image; }
   [[nodiscard]] vk::Format format() const { return m_format; }
   [[nodiscard]] vk::Extent2D extent() const { return m_extent; }
+  [[nodiscard]] uint32_t layers() const { return m_layers; }
   [[nodiscard]] bool has_stencil() const;
 
   [[nodiscard]] vk::ImageView combined_view() const { return m_combinedView; }
@@ -43,6 +49,7 @@ private:
   void destroy();
 
   vk::Device m_vkDevice;
+  DeletionQueue* m_deletionQueue{ nullptr };
   vk::Image m_image;
   vk::DeviceMemory m_memory;
   vk::ImageView m_combinedView;
@@ -50,6 +57,7 @@ private:
   vk::ImageView m_stencilView;
   vk::Format m_format;
   vk::Extent2D m_extent;
+  uint32_t m_layers{ 1 };
 };
 
 } // namespace vkwave
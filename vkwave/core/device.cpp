@@ -1,5 +1,6 @@
 #include <vkwave/config.h>
 
+#include <vkwave/core/deletion_queue.h>
 #include <vkwave/core/device.h>
 #include <vkwave/core/exception.h>
 #include <vkwave/core/instance.h>
@@ -331,11 +332,11 @@ Device::Device(const Instance& inst, vk::SurfaceKHR surface, bool prefer_distinc
   m_gpu_name = get_physical_device_name(m_physical_device);
   spdlog::trace("Creating device using graphics card: {}", m_gpu_name);
 
-  // Query ray tracing capabilities
-  m_ray_tracing_capabilities = query_ray_tracing_capabilities(m_physical_device);
-
-  // If ray tracing requested but not supported, disable it
-  if (enable_ray_tracing && !m_ray_tracing_capabilities.supported)
+  // Query ray tracing capabilities. Not requested: all reported unavailable,
+  // so callers do not ask for device addresses or build inputs the device was
+  // created without.
+  m_ray_tracing_capabilities = query_ray_tracing_capabilities(m_physical_device, enable_ray_tracing);
+  if (enable_ray_tracing && !m_ray_tracing_capabilities.acceleration_structure)
   {
     spdlog::warn("Ray tracing requested but not supported on this device");
   }
@@ -454,12 +455,7 @@ Device::Device(const Instance& inst, vk::SurfaceKHR surface, bool prefer_distinc
     spdlog::info("No dedicated compute queue available; compute shares the graphics queue");
   }
 
-  // TODO(Use C++)
-
-  //  VkPhysicalDeviceFeatures available_features{};
-  //  vkGetPhysicalDeviceFeatures(physical_device, &available_features);
-
-  vk::PhysicalDeviceFeatures available_features = vk::PhysicalDeviceFeatures();
+  const vk::PhysicalDeviceFeatures available_features = physical_device.getFeatures();
 
   const auto comparable_required_features = get_device_features_as_vector(required_features);
   const auto comparable_optional_features = get_device_features_as_vector(optional_features);
@@ -494,7 +490,8 @@ Device::Device(const Instance& inst, vk::SurfaceKHR surface, bool prefer_distinc
 
   spdlog::trace("Number of features enabled {}", features_to_enable.size());
 
-  std::memcpy(&m_enabled_features, features_to_enable.data(), features_to_enable.size());
+  std::memcpy(&m_enabled_features, features_to_enable.data(),
+    features_to_enable.size() * sizeof(VkBool32));
 
   spdlog::trace("Creating physical device");
 
@@ -513,20 +510,69 @@ Device::Device(const Instance& inst, vk::SurfaceKHR surface, bool prefer_distinc
   // Required for SPV_KHR_non_semantic_info (shader debug info) on Vulkan < 1.3
   extensions_to_enable.push_back(VK_KHR_SHADER_NON_SEMANTIC_INFO_EXTENSION_NAME);
 
-  // Add ray tracing extensions if supported and requested
-  if (enable_ray_tracing && m_ray_tracing_capabilities.supported)
+  // Add ray tracing extensions if supported and requested (only then are the
+  // capabilities set): acceleration structures, then the ray tracing pipeline
+  // and ray query independently on top of them.
+  const auto& rt = m_ray_tracing_capabilities;
+  if (rt.acceleration_structure)
   {
     extensions_to_enable.push_back(VK_KHR_ACCELERATION_STRUCTURE_EXTENSION_NAME);
-    extensions_to_enable.push_back(VK_KHR_RAY_TRACING_PIPELINE_EXTENSION_NAME);
     extensions_to_enable.push_back(VK_KHR_DEFERRED_HOST_OPERATIONS_EXTENSION_NAME);
     // Required by acceleration structure
     extensions_to_enable.push_back(VK_KHR_BUFFER_DEVICE_ADDRESS_EXTENSION_NAME);
-    // Required by ray tracing pipeline
+    // Required by both the ray tracing pipeline and ray query
     extensions_to_enable.push_back(VK_KHR_SPIRV_1_4_EXTENSION_NAME);
     extensions_to_enable.push_back(VK_KHR_SHADER_FLOAT_CONTROLS_EXTENSION_NAME);
+    if (rt.supported)
+      extensions_to_enable.push_back(VK_KHR_RAY_TRACING_PIPELINE_EXTENSION_NAME);
+    if (rt.ray_query)
+      extensions_to_enable.push_back(VK_KHR_RAY_QUERY_EXTENSION_NAME);
+    if (rt.pipeline_library)
+      extensions_to_enable.push_back(VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME);
+
+    spdlog::trace("Enabling ray tracing extensions (pipeline: {}, ray query: {})",
+      rt.supported, rt.ray_query);
+  }
+
+  // Dynamic rendering (render-pass-free drawing; core in 1.3, an extension on
+  // the 1.2 baseline). Optional: groups fall back to render passes without it.
+  vk::PhysicalDeviceDynamicRenderingFeaturesKHR dynamicRenderingFeatures{};
+  {
+    vk::PhysicalDeviceFeatures2 features2{};
+    features2.pNext = &dynamicRenderingFeatures;
+    bool has_extension = false;
+    for (const auto& ext : m_physical_device.enumerateDeviceExtensionProperties())
+      if (std::string(ext.extensionName.data()) == VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME)
+        has_extension = true;
+    if (has_extension)
+      m_physical_device.getFeatures2(&features2);
+    m_supports_dynamic_rendering = has_extension && dynamicRenderingFeatures.dynamicRendering;
+    dynamicRenderingFeatures.pNext = nullptr;
+  }
+  if (m_supports_dynamic_rendering)
+  {
+    extensions_to_enable.push_back(VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME);
+    spdlog::trace("Enabling dynamic rendering");
+  }
+
+  // Multiview (core in 1.1, required there): the PBR shaders index per-view
+  // cameras by gl_ViewIndex, so the feature is enabled whenever present.
+  vk::PhysicalDeviceMultiviewFeatures multiviewFeatures{};
+  {
+    vk::PhysicalDeviceFeatures2 features2{};
+    features2.pNext = &multiviewFeatures;
+    m_physical_device.getFeatures2(&features2);
+    multiviewFeatures.pNext = nullptr;
 
-    spdlog::trace("Enabling ray tracing extensions");
+    vk::PhysicalDeviceMultiviewProperties multiviewProps{};
+    vk::PhysicalDeviceProperties2 props2{};
+    props2.pNext = &multiviewProps;
+    m_physical_device.getProperties2(&props2);
+    m_max_multiview_views = multiviewFeatures.multiview ? multiviewProps.maxMultiviewViewCount : 0;
   }
+  // Only the base capability: tessellation/geometry multiview are not used.
+  multiviewFeatures.multiviewGeometryShader = VK_FALSE;
+  multiviewFeatures.multiviewTessellationShader = VK_FALSE;
 
   // Extended dynamic state features (for per-draw cull mode)
   vk::PhysicalDeviceExtendedDynamicStateFeaturesEXT extendedDynamicStateFeatures{};
@@ -545,9 +591,23 @@ Device::Device(const Instance& inst, vk::SurfaceKHR surface, bool prefer_distinc
   asFeatures.accelerationStructure = VK_TRUE;
   asFeatures.pNext = &bufferDeviceAddressFeatures;
 
+  // Each feature struct only in the chain when its extension is enabled.
+  void* rtFeatures = &asFeatures;
   vk::PhysicalDeviceRayTracingPipelineFeaturesKHR rtPipelineFeatures{};
   rtPipelineFeatures.rayTracingPipeline = VK_TRUE;
-  rtPipelineFeatures.pNext = &asFeatures;
+  if (rt.supported)
+  {
+    rtPipelineFeatures.pNext = rtFeatures;
+    rtFeatures = &rtPipelineFeatures;
+  }
+
+  vk::PhysicalDeviceRayQueryFeaturesKHR rayQueryFeatures{};
+  rayQueryFeatures.rayQuery = VK_TRUE;
+  if (rt.ray_query)
+  {
+    rayQueryFeatures.pNext = rtFeatures;
+    rtFeatures = &rayQueryFeatures;
+  }
 
   vk::DeviceCreateInfo deviceInfo = vk::DeviceCreateInfo(vk::DeviceCreateFlags(), //
     queues_to_create.size(), queues_to_create.data(),                             //
@@ -559,16 +619,22 @@ Device::Device(const Instance& inst, vk::SurfaceKHR surface, bool prefer_distinc
   vk::PhysicalDeviceTimelineSemaphoreFeatures timelineSemFeatures{};
   timelineSemFeatures.timelineSemaphore = VK_TRUE;
 
-  // Chain: deviceInfo → extendedDynamicState → timelineSem → (optional RT chain)
+  // Chain: deviceInfo → (dynamicRendering) → extendedDynamicState → timelineSem
+  //        → multiview → (optional RT chain)
   deviceInfo.pNext = &extendedDynamicStateFeatures;
   extendedDynamicStateFeatures.pNext = &timelineSemFeatures;
-
-  // Chain ray tracing features if enabled
-  if (enable_ray_tracing && m_ray_tracing_capabilities.supported)
+  timelineSemFeatures.pNext = &multiviewFeatures;
+  if (m_supports_dynamic_rendering)
   {
-    timelineSemFeatures.pNext = &rtPipelineFeatures;
+    dynamicRenderingFeatures.dynamicRendering = VK_TRUE;
+    dynamicRenderingFeatures.pNext = &extendedDynamicStateFeatures;
+    deviceInfo.pNext = &dynamicRenderingFeatures;
   }
 
+  // Chain ray tracing features if enabled
+  if (rt.acceleration_structure)
+    multiviewFeatures.pNext = rtFeatures;
+
   try
   {
     m_device = m_physical_device.createDevice(deviceInfo);
@@ -602,18 +668,22 @@ Device::Device(const Instance& inst, vk::SurfaceKHR surface, bool prefer_distinc
   m_compute_queue = m_has_dedicated_compute_queue
     ? m_device.getQueue(m_compute_queue_family_index, 0)
     : m_graphics_queue;
+
+  m_deletion_queue = std::make_unique<DeletionQueue>(m_device);
 }
 
-RayTracingCapabilities Device::query_ray_tracing_capabilities(vk::PhysicalDevice physical_device)
+RayTracingCapabilities select_ray_tracing_capabilities(
+  std::span<const vk::ExtensionProperties> extensions, bool requested)
 {
   RayTracingCapabilities caps{};
-
-  // Check for required extensions
-  auto extensions = physical_device.enumerateDeviceExtensionProperties();
+  if (!requested)
+    return caps;
 
   bool has_acceleration_structure = false;
   bool has_ray_tracing_pipeline = false;
   bool has_deferred_host_ops = false;
+  bool has_ray_query = false;
+  bool has_pipeline_library = false;
 
   for (const auto& ext : extensions)
   {
@@ -624,23 +694,43 @@ RayTracingCapabilities Device::query_ray_tracing_capabilities(vk::PhysicalDevice
       has_ray_tracing_pipeline = true;
     if (name == VK_KHR_DEFERRED_HOST_OPERATIONS_EXTENSION_NAME)
       has_deferred_host_ops = true;
+    if (name == VK_KHR_RAY_QUERY_EXTENSION_NAME)
+      has_ray_query = true;
+    if (name == VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME)
+      has_pipeline_library = true;
   }
 
-  caps.supported = has_acceleration_structure && has_ray_tracing_pipeline && has_deferred_host_ops;
+  caps.acceleration_structure = has_acceleration_structure && has_deferred_host_ops;
+  caps.supported = caps.acceleration_structure && has_ray_tracing_pipeline;
+  caps.ray_query = caps.acceleration_structure && has_ray_query;
+  caps.pipeline_library = caps.supported && has_pipeline_library;
+  return caps;
+}
+
+RayTracingCapabilities Device::query_ray_tracing_capabilities(
+  vk::PhysicalDevice physical_device, bool requested)
+{
+  const auto extensions = physical_device.enumerateDeviceExtensionProperties();
+  RayTracingCapabilities caps = select_ray_tracing_capabilities(extensions, requested);
 
-  if (!caps.supported)
+  if (!caps.acceleration_structure)
   {
     spdlog::trace("Ray tracing not supported: missing extensions");
     return caps;
   }
 
-  // Query ray tracing pipeline properties
+  // Query acceleration structure (and, with the pipeline, ray tracing
+  // pipeline) properties
   vk::PhysicalDeviceRayTracingPipelinePropertiesKHR rt_pipeline_props{};
   vk::PhysicalDeviceAccelerationStructurePropertiesKHR as_props{};
 
   vk::PhysicalDeviceProperties2 props2{};
-  props2.pNext = &rt_pipeline_props;
-  rt_pipeline_props.pNext = &as_props;
+  props2.pNext = &as_props;
+  if (caps.supported)
+  {
+    rt_pipeline_props.pNext = &as_props;
+    props2.pNext = &rt_pipeline_props;
+  }
 
   physical_device.getProperties2(&props2);
 
@@ -662,6 +752,8 @@ RayTracingCapabilities Device::query_ray_tracing_capabilities(vk::PhysicalDevice
   spdlog::trace("  - Max ray recursion depth: {}", caps.maxRayRecursionDepth);
   spdlog::trace("  - Max primitive count: {}", caps.maxPrimitiveCount);
   spdlog::trace("  - Shader group handle size: {}", caps.shaderGroupHandleSize);
+  spdlog::trace("  - Ray query: {}", caps.ray_query);
+  spdlog::trace("  - Pipeline library: {}", caps.pipeline_library);
 
   return caps;
 }
@@ -707,6 +799,8 @@ Device::Device(Device&& other) noexcept
   , m_graphics_queue(std::exchange(other.m_graphics_queue, VK_NULL_HANDLE))
   , m_present_queue(std::exchange(other.m_present_queue, VK_NULL_HANDLE))
   , m_transfer_queue(std::exchange(other.m_transfer_queue, VK_NULL_HANDLE))
+  , m_supports_dynamic_rendering(other.m_supports_dynamic_rendering)
+  , m_deletion_queue(std::move(other.m_deletion_queue))
   , m_present_queue_family_index(other.m_present_queue_family_index)
   , m_graphics_queue_family_index(other.m_graphics_queue_family_index)
   , m_transfer_queue_family_index(other.m_transfer_queue_family_index)
@@ -721,6 +815,10 @@ Device::~Device()
     return;
   std::scoped_lock locker(m_mutex);
 
+  // Run every deferred destruction while the device is still alive.
+  m_device.waitIdle();
+  m_deletion_queue.reset();
+
   // Because the device handle must be valid for the destruction of the command pools in the
   // CommandPool destructor, we must destroy the command pools manually here in order to ensure
   // the right order of destruction m_cmd_pools.clear();
@@ -16,6 +16,7 @@
 namespace vkwave
 {
 
+class DeletionQueue;
 class Instance;
 
 struct DeviceInfo
@@ -33,7 +34,16 @@ struct DeviceInfo
 /// Ray tracing capabilities and properties
 struct RayTracingCapabilities
 {
+  // VK_KHR_acceleration_structure (+ deferred host operations): BLAS/TLAS
+  // builds. The two ways to trace them below each need it, not each other.
+  bool acceleration_structure{ false };
+  // VK_KHR_ray_tracing_pipeline: ray tracing pipelines and their SBTs.
   bool supported{ false };
+  // VK_KHR_ray_query: shaders of any stage may trace against a TLAS.
+  bool ray_query{ false };
+  // VK_KHR_pipeline_library: ray tracing pipelines can be linked from
+  // separately compiled libraries (RayTracingPipeline's hit groups).
+  bool pipeline_library{ false };
 
   // Pipeline properties
   uint32_t shaderGroupHandleSize{ 0 };
@@ -50,6 +60,13 @@ struct RayTracingCapabilities
   uint32_t minAccelerationStructureScratchOffsetAlignment{ 0 };
 };
 
+/// The ray tracing capabilities (no properties) of a device with `extensions`,
+/// all false unless ray tracing is `requested`. Ray query needs only the
+/// acceleration structures, not the ray tracing pipeline (lavapipe exposes
+/// the former without the latter).
+[[nodiscard]] RayTracingCapabilities select_ray_tracing_capabilities(
+  std::span<const vk::ExtensionProperties> extensions, bool requested);
+
 /*
  * Vulkan separates the concept of physical and logical devices.
  *
@@ -104,6 +121,13 @@ public:
 
   [[nodiscard]] const std::string& gpu_name() const { return m_gpu_name; }
 
+  /// Core features actually enabled (the required ones plus the available
+  /// optional ones).
+  [[nodiscard]] const vk::PhysicalDeviceFeatures& enabled_features() const
+  {
+    return m_enabled_features;
+  }
+
   [[nodiscard]] vk::Queue graphics_queue() const { return m_graphics_queue; }
 
   [[nodiscard]] vk::Queue present_queue() const { return m_present_queue; }
@@ -144,8 +168,10 @@ public:
   [[nodiscard]] uint32_t find_memory_type(
     uint32_t type_filter, vk::MemoryPropertyFlags properties) const;
 
-  /// Check if ray tracing is supported and query capabilities
-  static RayTracingCapabilities query_ray_tracing_capabilities(vk::PhysicalDevice physical_device);
+  /// Check if ray tracing is supported and query capabilities (see
+  /// select_ray_tracing_capabilities())
+  static RayTracingCapabilities query_ray_tracing_capabilities(
+    vk::PhysicalDevice physical_device, bool requested);
 
   /// Get ray tracing capabilities (call after device creation)
   [[nodiscard]] const RayTracingCapabilities& ray_tracing_capabilities() const
@@ -153,9 +179,43 @@ public:
     return m_ray_tracing_capabilities;
   }
 
-  /// Check if ray tracing is available on this device
+  /// True when acceleration structures are enabled on this device (false when
+  /// ray tracing was not requested at creation, even if the hardware has it):
+  /// geometry buffers need device addresses and build-input usage.
+  [[nodiscard]] bool supports_acceleration_structures() const
+  {
+    return m_ray_tracing_capabilities.acceleration_structure;
+  }
+
+  /// Check if ray tracing pipelines are enabled on this device (implies
+  /// supports_acceleration_structures(); false when not requested at creation)
   [[nodiscard]] bool supports_ray_tracing() const { return m_ray_tracing_capabilities.supported; }
 
+  /// True when VK_KHR_ray_query is enabled (implies
+  /// supports_acceleration_structures(), not supports_ray_tracing()):
+  /// rasterization shaders can trace rays against an acceleration structure.
+  [[nodiscard]] bool supports_ray_query() const { return m_ray_tracing_capabilities.ray_query; }
+
+  /// True when VK_KHR_pipeline_library is enabled (implies supports_ray_tracing()).
+  [[nodiscard]] bool supports_pipeline_library() const
+  {
+    return m_ray_tracing_capabilities.pipeline_library;
+  }
+
+  /// True when VK_KHR_dynamic_rendering is enabled: graphics pipelines can be
+  /// created against attachment formats and drawn without render pass or
+  /// framebuffer objects.
+  [[nodiscard]] bool supports_dynamic_rendering() const { return m_supports_dynamic_rendering; }
+
+  /// Views one multiview render pass may broadcast to (VK_KHR_multiview, core
+  /// in 1.1): maxMultiviewViewCount, or 0 if the feature is unavailable.
+  [[nodiscard]] uint32_t max_multiview_views() const { return m_max_multiview_views; }
+
+  /// Deferred destruction for resources the GPU may still use: RAII wrappers
+  /// push their handles here instead of destroying them, and the render graph
+  /// collects once per frame. Flushed before the device is destroyed.
+  [[nodiscard]] DeletionQueue& deletion_queue() const { return *m_deletion_queue; }
+
   /// Query the maximum usable MSAA sample count (intersection of color and depth)
   [[nodiscard]] vk::SampleCountFlagBits max_usable_sample_count() const;
 
@@ -180,6 +240,10 @@ private:
   vk::Queue m_transfer_queue{ VK_NULL_HANDLE };
   vk::Queue m_compute_queue{ VK_NULL_HANDLE };
   bool m_has_dedicated_compute_queue{ false };
+  bool m_supports_dynamic_rendering{ false };
+  uint32_t m_max_multiview_views{ 0 };
+
+  std::unique_ptr<DeletionQueue> m_deletion_queue;
 
 public:
   // Find other way to expose to swapchain
@@ -0,0 +1,63 @@
+#include <vkwave/core/dynamic_resolution.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace vkwave
+{
+
+DynamicResolution::DynamicResolution(const Settings& settings)
+  : m_settings(settings)
+  , m_scale(settings.max_scale)
+{
+}
+
+float DynamicResolution::update(float gpu_ms)
+{
+  if (gpu_ms <= 0.0f)
+    return m_scale;
+
+  m_average_ms = (m_average_ms <= 0.0f)
+    ? gpu_ms
+    : m_average_ms + m_settings.smoothing * (gpu_ms - m_average_ms);
+
+  if (m_hold > 0)
+  {
+    --m_hold;
+    return m_scale;
+  }
+
+  // Inside the dead band [target * (1 - headroom), target]: hold.
+  const float target = m_settings.target_ms;
+  if (m_average_ms <= target && m_average_ms >= target * (1.0f - m_settings.headroom))
+    return m_scale;
+
+  const float wanted = m_scale * std::sqrt(target / m_average_ms);
+  const float step = std::clamp(wanted - m_scale, -m_settings.max_step, m_settings.max_step);
+  const float next = std::clamp(m_scale + step, m_settings.min_scale, m_settings.max_scale);
+  if (next == m_scale)
+    return m_scale; // pinned at min_scale / max_scale
+
+  m_scale = next;
+  m_hold = m_settings.settle_frames;
+  return m_scale;
+}
+
+void DynamicResolution::reset()
+{
+  m_scale = m_settings.max_scale;
+  m_average_ms = 0.0f;
+  m_hold = 0;
+}
+
+vk::Extent2D DynamicResolution::scaled_extent(vk::Extent2D extent, float scale)
+{
+  const float s = std::clamp(scale, 0.0f, 1.0f);
+  auto axis = [s](uint32_t n) {
+    const auto scaled = static_cast<uint32_t>(std::lround(static_cast<float>(n) * s));
+    return std::clamp(scaled, 1u, std::max(n, 1u));
+  };
+  return vk::Extent2D{ axis(extent.width), axis(extent.height) };
+}
+
+} // namespace vkwave
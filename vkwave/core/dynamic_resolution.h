@@ -0,0 +1,58 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+
+#include <cstdint>
+
+namespace vkwave
+{
+
+/// Render-scale controller for dynamic resolution.
+///
+/// Fed one GPU frame time per frame, it adjusts a linear scale factor (applied
+/// to both axes) so the frame time settles just under Settings::target_ms. GPU
+/// cost is taken to be proportional to the pixel count, i.e. to scale^2, so the
+/// step toward the target is sqrt(target / measured). Measurements are smoothed
+/// and each change is followed by Settings::settle_frames of hold, since the
+/// timestamps read back lag the CPU by the frame ring depth.
+///
+/// Pure CPU state; the render targets stay at full size and only the viewport
+/// shrinks (see SubmissionGroup::set_render_extent()).
+class DynamicResolution
+{
+public:
+  struct Settings
+  {
+    float target_ms{ 16.0f };
+    float min_scale{ 0.5f };
+    float max_scale{ 1.0f };
+    float headroom{ 0.1f };    // grow only below target * (1 - headroom)
+    float smoothing{ 0.2f };   // weight of the newest sample in the running average
+    float max_step{ 0.05f };   // largest scale change per update
+    uint32_t settle_frames{ 4 };
+  };
+
+  DynamicResolution() = default;
+  explicit DynamicResolution(const Settings& settings);
+
+  /// Feed the latest GPU frame time (<= 0 is ignored). Returns the new scale.
+  float update(float gpu_ms);
+
+  /// Back to max_scale with no history (e.g. after a resize or mode toggle).
+  void reset();
+
+  [[nodiscard]] float scale() const { return m_scale; }
+  [[nodiscard]] float average_ms() const { return m_average_ms; }
+  [[nodiscard]] Settings& settings() { return m_settings; }
+
+  /// `extent` scaled by `scale`, rounded, at least 1x1 and at most `extent`.
+  [[nodiscard]] static vk::Extent2D scaled_extent(vk::Extent2D extent, float scale);
+
+private:
+  Settings m_settings;
+  float m_scale{ 1.0f };
+  float m_average_ms{ 0.0f };
+  uint32_t m_hold{ 0 };
+};
+
+} // namespace vkwave
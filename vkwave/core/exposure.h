@@ -0,0 +1,80 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+namespace vkwave
+{
+
+/// Luminance histogram bins of composite.comp. Bin 0 counts (near-)black
+/// pixels, which auto-exposure ignores; bins 1..N-1 split the log2 luminance
+/// range evenly. One bin per thread of a workgroup.
+inline constexpr uint32_t kExposureHistogramBins = 256;
+
+/// Exposure state composite.comp keeps on the GPU (std430 storage buffer).
+/// Everything after `exposure` / `averageLog2` is cleared before each dispatch;
+/// the last workgroup of the dispatch adapts `exposure` from the histogram.
+struct ExposureState
+{
+  float exposure;          //  4 bytes — adapted exposure (scene-referred multiplier)
+  float averageLog2;       //  4 bytes — mean log2 luminance of the last histogram
+  uint32_t finishedGroups; //  4 bytes — workgroups done (the last one adapts)
+  uint32_t pad;            //  4 bytes
+  std::array<uint32_t, kExposureHistogramBins> histogram; // pixels per bin
+};
+
+static_assert(sizeof(ExposureState) == 16 + 4 * kExposureHistogramBins,
+  "ExposureState must match the shader's std430 layout");
+
+/// Push constants for composite.comp (one dispatch over the output).
+struct CompositePushConstants
+{
+  glm::vec2 uvScale;       //  8 bytes — rendered fraction of the HDR (dynamic resolution)
+  glm::ivec2 outSize;      //  8 bytes — output extent
+  float exposure;          //  4 bytes — manual exposure, or compensation on top of auto
+  int32_t tonemapMode;     //  4 bytes — applyToneMap() mode
+  int32_t autoExposure;    //  4 bytes — 1 = multiply by the adapted exposure
+  float adaptation;        //  4 bytes — fraction of the way to the target this frame
+  float minLog2;           //  4 bytes — log2 luminance of histogram bin 1
+  float log2Range;         //  4 bytes — log2 luminance span of bins 1..N-1
+  uint32_t groupCount;     //  4 bytes — workgroups in the dispatch
+  float middleGrey;        //  4 bytes — kExposureMiddleGrey
+};
+
+static_assert(sizeof(CompositePushConstants) == 48,
+  "CompositePushConstants must be 48 bytes to match shader layout");
+
+/// Exponential adaptation: the fraction of the remaining (log2) distance to the
+/// target exposure covered in `dt` seconds at `speed` (1 / time constant).
+inline float exposure_adaptation(float dt, float speed)
+{
+  return 1.0f - std::exp(-std::max(dt, 0.0f) * std::max(speed, 0.0f));
+}
+
+/// Mean scene luminance the adaptation maps to (CompositePushConstants::middleGrey).
+inline constexpr float kExposureMiddleGrey = 0.18f;
+
+/// Distance, in stops, below which the adaptation counts as settled: the
+/// remaining change is too small to see.
+inline constexpr float kExposureSettledStops = 0.02f;
+
+/// Stops between the adapted exposure in `state` and its target for the last
+/// histogram. 0 for an all-black histogram, which composite.comp does not
+/// adapt to.
+inline float exposure_error_stops(const ExposureState& state)
+{
+  uint32_t counted = 0;
+  for (uint32_t i = 1; i < kExposureHistogramBins; ++i)
+    counted += state.histogram[i];
+  if (counted == 0)
+    return 0.0f;
+  const float current = std::log2(std::max(state.exposure, 1e-8f));
+  const float target = std::log2(kExposureMiddleGrey) - state.averageLog2;
+  return std::abs(target - current);
+}
+
+} // namespace vkwave
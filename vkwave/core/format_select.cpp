@@ -0,0 +1,116 @@
+#include <vkwave/core/format_select.h>
+#include <vkwave/core/device.h>
+
+#include <spdlog/spdlog.h>
+
+#include <span>
+#include <stdexcept>
+#include <string>
+
+namespace vkwave
+{
+
+// Candidates per precision in preference order: most compact first, the last
+// one the wide format that `compact = false` picks directly. Reversed-Z is the
+// exception — it prefers the float format and only falls back to 24 bits.
+static constexpr vk::Format kHdrRgb[] = {
+  vk::Format::eB10G11R11UfloatPack32,
+  vk::Format::eR16G16B16A16Sfloat,
+};
+static constexpr vk::Format kHdrRgba[] = {
+  vk::Format::eR16G16B16A16Sfloat,
+};
+static constexpr vk::Format kReversedZ[] = {
+  vk::Format::eD32Sfloat,
+  vk::Format::eX8D24UnormPack32,
+};
+static constexpr vk::Format kLinearDepth[] = {
+  vk::Format::eD16Unorm,
+  vk::Format::eX8D24UnormPack32,
+  vk::Format::eD32Sfloat,
+};
+
+// Storage images of these formats need shaderStorageImageExtendedFormats.
+static bool is_extended_storage_format(vk::Format format)
+{
+  return format == vk::Format::eB10G11R11UfloatPack32;
+}
+
+static bool supports(const Device& device, vk::Format format, vk::FormatFeatureFlags required)
+{
+  const auto features = device.physicalDevice().getFormatProperties(format).optimalTilingFeatures;
+  if ((features & required) != required)
+    return false;
+  if ((required & vk::FormatFeatureFlagBits::eStorageImage) && is_extended_storage_format(format))
+    return device.enabled_features().shaderStorageImageExtendedFormats == VK_TRUE;
+  return true;
+}
+
+static vk::Format select(const Device& device, std::span<const vk::Format> candidates,
+                         vk::FormatFeatureFlags required, bool compact, const char* what)
+{
+  if (!compact)
+    candidates = candidates.last(1);
+  for (auto format : candidates)
+  {
+    if (supports(device, format, required))
+    {
+      spdlog::debug("{} format: {}", what, vk::to_string(format));
+      return format;
+    }
+  }
+  throw std::runtime_error(std::string("No supported ") + what + " format for "
+    + vk::to_string(required));
+}
+
+vk::Format select_color_format(const Device& device, ColorPrecision precision,
+                               vk::FormatFeatureFlags required, bool compact)
+{
+  switch (precision)
+  {
+  case ColorPrecision::hdr_rgb:  return select(device, kHdrRgb, required, compact, "HDR colour");
+  case ColorPrecision::hdr_rgba: return select(device, kHdrRgba, required, compact, "HDR colour + alpha");
+  }
+  return vk::Format::eUndefined;
+}
+
+vk::Format select_depth_format(const Device& device, DepthPrecision precision,
+                               vk::FormatFeatureFlags required, bool compact)
+{
+  switch (precision)
+  {
+  case DepthPrecision::reversed_z:
+    return select(device, kReversedZ, required, true, "reversed-Z depth");
+  case DepthPrecision::linear:
+    return select(device, kLinearDepth, required, compact, "linear depth");
+  }
+  return vk::Format::eUndefined;
+}
+
+uint32_t texel_size(vk::Format format)
+{
+  switch (format)
+  {
+  case vk::Format::eR16G16B16A16Sfloat:    return 8;
+  case vk::Format::eB10G11R11UfloatPack32:
+  case vk::Format::eR8G8B8A8Unorm:
+  case vk::Format::eR8G8B8A8Srgb:
+  case vk::Format::eB8G8R8A8Unorm:
+  case vk::Format::eB8G8R8A8Srgb:          return 4;
+  default:
+    throw std::runtime_error("texel_size: unhandled format " + vk::to_string(format));
+  }
+}
+
+const char* glsl_image_format(vk::Format format)
+{
+  switch (format)
+  {
+  case vk::Format::eR16G16B16A16Sfloat:    return "rgba16f";
+  case vk::Format::eB10G11R11UfloatPack32: return "r11f_g11f_b10f";
+  default:
+    throw std::runtime_error("glsl_image_format: unhandled format " + vk::to_string(format));
+  }
+}
+
+} // namespace vkwave
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+
+#include <cstdint>
+
+namespace vkwave
+{
+
+class Device;
+
+/// What a colour target has to hold. select_color_format() maps it to the
+/// most compact format the device supports for the target's usage.
+enum class ColorPrecision
+{
+  hdr_rgb,  ///< unsigned HDR colour, alpha unused: B10G11R11 (4 B), else RGBA16F
+  hdr_rgba, ///< HDR colour with alpha, or accumulated history: RGBA16F (8 B)
+};
+
+/// What a depth target has to hold.
+enum class DepthPrecision
+{
+  reversed_z, ///< reversed-Z perspective depth: D32F (the float exponent is what
+              ///< reversed-Z spends its precision on), else X8D24
+  linear,     ///< orthographic depth (shadow maps): D16, else X8D24, else D32F
+};
+
+/// First candidate for `precision` whose optimal-tiling features include
+/// `required`. A storage-image use of an extended format (B10G11R11) also needs
+/// shaderStorageImageExtendedFormats enabled on the device. With `compact`
+/// false the widest candidate is used, so a capture can be compared against
+/// the full-precision render (reversed-Z depth is D32F either way). Throws
+/// when no candidate fits.
+[[nodiscard]] vk::Format select_color_format(const Device& device, ColorPrecision precision,
+                                             vk::FormatFeatureFlags required, bool compact = true);
+[[nodiscard]] vk::Format select_depth_format(const Device& device, DepthPrecision precision,
+                                             vk::FormatFeatureFlags required, bool compact = true);
+
+/// Bytes per texel of a colour target format (readback sizing).
+[[nodiscard]] uint32_t texel_size(vk::Format format);
+
+/// GLSL image format qualifier for a storage view of `format` ("rgba16f",
+/// "r11f_g11f_b10f"), for a shader preamble.
+[[nodiscard]] const char* glsl_image_format(vk::Format format);
+
+} // namespace vkwave
@@ -7,7 +7,7 @@ namespace vkwave
 {
 
 std::vector<FrameResources> create_frame_resources(
-  const Device& device, const uint32_t count)
+  const Device& device, const uint32_t count, const bool compute)
 {
   std::vector<FrameResources> frames;
   frames.reserve(count);
@@ -16,7 +16,7 @@ std::vector<FrameResources> create_frame_resources(
   {
     FrameResources fr;
 
-    fr.command_pool = make_command_pool(device, false);
+    fr.command_pool = make_command_pool(device, false, compute);
 
     vk::CommandBufferAllocateInfo alloc{};
     alloc.commandPool = fr.command_pool;
@@ -22,9 +22,10 @@ struct FrameResources
   vk::Framebuffer   framebuffer{ VK_NULL_HANDLE };
 };
 
-/// Create N frame resource sets (command pool + buffer each).
+/// Create N frame resource sets (command pool + buffer each). With `compute`
+/// the pools belong to the compute queue's family (Device::compute_queue()).
 std::vector<FrameResources> create_frame_resources(
-  const Device& device, uint32_t count);
+  const Device& device, uint32_t count, bool compute = false);
 
 /// Destroy non-RAII resources (command pools, framebuffers). Clears the vector.
 void destroy_frame_resources(
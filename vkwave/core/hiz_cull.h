@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+namespace vkwave
+{
+
+/// UBO for hiz_cull.comp: this frame's and last frame's view-projection plus
+/// the scene depth extent. One copy per frame slot. Must match shader layout
+/// (std140).
+struct HiZCullParams
+{
+  glm::mat4 viewProj;     // 64 bytes — frustum test + phase-1 occlusion test
+  glm::mat4 prevViewProj; // 64 bytes — phase-0 occlusion test (last frame's pyramid)
+  glm::vec4 depthSize;    // 16 bytes — xy=scene depth extent, z=pyramid mip count
+  glm::vec4 viewportSize; // 16 bytes — xy=rendered extent this frame, zw=history pyramid's
+};
+
+static_assert(sizeof(HiZCullParams) == 160,
+  "HiZCullParams must be 160 bytes to match shader layout (std140)");
+
+/// Per-primitive cull input: world-space AABB + the indexed draw range that is
+/// copied into the VkDrawIndexedIndirectCommand. Immutable per model (std430).
+struct HiZCullPrimitive
+{
+  glm::vec4 boundsMin;   // 16 bytes — xyz=world-space min, w=unused
+  glm::vec4 boundsMax;   // 16 bytes — xyz=world-space max, w=unused
+  uint32_t indexCount;   //  4 bytes
+  uint32_t firstIndex;   //  4 bytes
+  int32_t vertexOffset;  //  4 bytes
+  uint32_t pad;          //  4 bytes
+};
+
+static_assert(sizeof(HiZCullPrimitive) == 48,
+  "HiZCullPrimitive must be 48 bytes to match shader layout (std430)");
+
+/// Push constants for hiz_cull.comp.
+struct HiZCullPushConstants
+{
+  uint32_t primitiveCount;
+  uint32_t phase;        // 0 = last-frame pyramid, 1 = disocclusion re-test
+  uint32_t useOcclusion; // phase 0: 0 when last frame's pyramid is unusable
+  uint32_t pad;
+};
+
+static_assert(sizeof(HiZCullPushConstants) == 16,
+  "HiZCullPushConstants must be 16 bytes to match shader layout");
+
+/// Push constants for hiz_build.comp (one dispatch per pyramid mip).
+struct HiZBuildPushConstants
+{
+  glm::ivec2 srcSize;
+  glm::ivec2 dstSize;
+};
+
+static_assert(sizeof(HiZBuildPushConstants) == 16,
+  "HiZBuildPushConstants must be 16 bytes to match shader layout");
+
+} // namespace vkwave
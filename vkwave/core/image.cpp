@@ -1,8 +1,10 @@
 #include <vkwave/core/image.h>
+#include <vkwave/core/deletion_queue.h>
 #include <vkwave/core/device.h>
 
 #include <spdlog/spdlog.h>
 
+#include <array>
 #include <utility>
 
 namespace vkwave
@@ -10,9 +12,11 @@ namespace vkwave
 
 Image::Image(const Device& device, vk::Format format, vk::Extent2D extent,
   vk::ImageUsageFlags usage, const std::string& name,
-  vk::SampleCountFlagBits samples, uint32_t mip_levels)
-  : m_device(device.device()), m_format(format), m_extent(extent)
-  , m_mip_levels(mip_levels)
+  vk::SampleCountFlagBits samples, uint32_t mip_levels, uint32_t array_layers,
+  bool compute_shared)
+  : m_device(device.device()), m_deletion_queue(&device.deletion_queue())
+  , m_format(format), m_extent(extent)
+  , m_mip_levels(mip_levels), m_array_layers(array_layers)
 {
   // Multisample images are transient (content discarded after resolve) and
   // cannot have mip levels.
@@ -27,13 +31,21 @@ Image::Image(const Device& device, vk::Format format, vk::Extent2D extent,
   image_info.imageType = vk::ImageType::e2D;
   image_info.extent = vk::Extent3D{ extent.width, extent.height, 1 };
   image_info.mipLevels = m_mip_levels;
-  image_info.arrayLayers = 1;
+  image_info.arrayLayers = m_array_layers;
   image_info.format = format;
   image_info.tiling = vk::ImageTiling::eOptimal;
   image_info.initialLayout = vk::ImageLayout::eUndefined;
   image_info.usage = usage;
   image_info.sharingMode = vk::SharingMode::eExclusive;
   image_info.samples = samples;
+  const std::array<uint32_t, 2> families{ device.m_graphics_queue_family_index,
+    device.m_compute_queue_family_index };
+  if (compute_shared && device.has_dedicated_compute_queue())
+  {
+    image_info.sharingMode = vk::SharingMode::eConcurrent;
+    image_info.queueFamilyIndexCount = static_cast<uint32_t>(families.size());
+    image_info.pQueueFamilyIndices = families.data();
+  }
 
   m_image = m_device.createImage(image_info);
 
@@ -50,13 +62,14 @@ Image::Image(const Device& device, vk::Format format, vk::Extent2D extent,
   // Create image view
   vk::ImageViewCreateInfo view_info{};
   view_info.image = m_image;
-  view_info.viewType = vk::ImageViewType::e2D;
+  view_info.viewType = m_array_layers > 1
+    ? vk::ImageViewType::e2DArray : vk::ImageViewType::e2D;
   view_info.format = format;
   view_info.subresourceRange.aspectMask = vk::ImageAspectFlagBits::eColor;
   view_info.subresourceRange.baseMipLevel = 0;
   view_info.subresourceRange.levelCount = m_mip_levels;
   view_info.subresourceRange.baseArrayLayer = 0;
-  view_info.subresourceRange.layerCount = 1;
+  view_info.subresourceRange.layerCount = m_array_layers;
 
   device.create_image_view(view_info, &m_view, name);
   device.set_debug_name(
@@ -74,12 +87,14 @@ Image::~Image()
 
 Image::Image(Image&& other) noexcept
   : m_device(other.m_device)
+  , m_deletion_queue(other.m_deletion_queue)
   , m_image(std::exchange(other.m_image, VK_NULL_HANDLE))
   , m_memory(std::exchange(other.m_memory, VK_NULL_HANDLE))
   , m_view(std::exchange(other.m_view, VK_NULL_HANDLE))
   , m_format(other.m_format)
   , m_extent(other.m_extent)
   , m_mip_levels(other.m_mip_levels)
+  , m_array_layers(other.m_array_layers)
 {
 }
 
@@ -89,27 +104,33 @@ Image& Image::operator=(Image&& other) noexcept
   {
     destroy();
     m_device = other.m_device;
+    m_deletion_queue = other.m_deletion_queue;
     m_image = std::exchange(other.m_image, VK_NULL_HANDLE);
     m_memory = std::exchange(other.m_memory, VK_NULL_HANDLE);
     m_view = std::exchange(other.m_view, VK_NULL_HANDLE);
     m_format = other.m_format;
     m_extent = other.m_extent;
     m_mip_levels = other.m_mip_levels;
+    m_array_layers = other.m_array_layers;
   }
   return *this;
 }
 
 void Image::destroy()
 {
-  if (!m_device)
+  if (!m_device || !m_image)
     return;
 
-  if (m_view)
-    m_device.destroyImageView(m_view);
-  if (m_image)
-    m_device.destroyImage(m_image);
-  if (m_memory)
-    m_device.freeMemory(m_memory);
+  // Frames in flight may still use it: destroy once they finish.
+  m_deletion_queue->push(
+    [device = m_device, view = m_view, image = m_image, memory = m_memory] {
+      if (view)
+        device.destroyImageView(view);
+      if (image)
+        device.destroyImage(image);
+      if (memory)
+        device.freeMemory(memory);
+    });
 
   m_view = VK_NULL_HANDLE;
   m_image = VK_NULL_HANDLE;
@@ -7,13 +7,14 @@
 namespace vkwave
 {
 
+class DeletionQueue;
 class Device;
 
 /// RAII wrapper for a device-local color image with view.
 ///
 /// Used for offscreen render targets (HDR images, intermediate buffers).
 /// Creates a VkImage + VkDeviceMemory + VkImageView and destroys them
-/// in the destructor.
+/// through the device deletion queue in the destructor.
 class Image
 {
 public:
@@ -27,10 +28,16 @@ public:
   ///                eTransientAttachment is added automatically.
   /// @param mip_levels Number of mip levels (default 1). Must be 1 for
   ///                multisample images. The created view spans all levels.
+  /// @param array_layers Number of array layers (default 1). With more than
+  ///                one the view is a 2D array spanning every layer (e.g. a
+  ///                multiview render target, one layer per view).
+  /// @param compute_shared Also used on the async compute queue: concurrent
+  ///                between the graphics and compute families when they differ
+  ///                (no ownership transfers), exclusive otherwise.
   Image(const Device& device, vk::Format format, vk::Extent2D extent,
     vk::ImageUsageFlags usage, const std::string& name,
     vk::SampleCountFlagBits samples = vk::SampleCountFlagBits::e1,
-    uint32_t mip_levels = 1);
+    uint32_t mip_levels = 1, uint32_t array_layers = 1, bool compute_shared = false);
 
   ~Image();
 
@@ -44,17 +51,20 @@ public:
   [[nodiscard]] vk::Format format() const { return m_format; }
   [[nodiscard]] vk::Extent2D extent() const { return m_extent; }
   [[nodiscard]] uint32_t mip_levels() const { return m_mip_levels; }
+  [[nodiscard]] uint32_t array_layers() const { return m_array_layers; }
 
 private:
   void destroy();
 
   vk::Device m_device;
+  DeletionQueue* m_deletion_queue{ nullptr };
   vk::Image m_image{ VK_NULL_HANDLE };
   vk::DeviceMemory m_memory{ VK_NULL_HANDLE };
   vk::ImageView m_view{ VK_NULL_HANDLE };
   vk::Format m_format{};
   vk::Extent2D m_extent{};
   uint32_t m_mip_levels{ 1 };
+  uint32_t m_array_layers{ 1 };
 };
 
 } // namespace vkwave
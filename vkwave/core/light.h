@@ -68,12 +68,12 @@ private:
   glm::vec3 m_direction{ 0.0f, 0.0f, 1.0f };
 };
 
-/// Point light - emits light in all directions from a position
-class PointLight : public Light
+/// Base class for lights with a position and distance attenuation (point, spot)
+class LocalLight : public Light
 {
 public:
-  PointLight() = default;
-  PointLight(const glm::vec3& position)
+  LocalLight() = default;
+  LocalLight(const glm::vec3& position)
     : m_position(position)
   {
   }
@@ -94,34 +94,72 @@ public:
   [[nodiscard]] float attenuation_linear() const { return m_attenuation_linear; }
   [[nodiscard]] float attenuation_quadratic() const { return m_attenuation_quadratic; }
 
-  /// Returns position with w=1 (indicates point light in shader)
-  [[nodiscard]] glm::vec4 position_or_direction() const override
+  /// Explicit influence radius (e.g. glTF KHR_lights_punctual `range`).
+  /// 0 (default) derives it from the attenuation, see range().
+  void set_range(float range) { m_range = range; }
+
+  /// Distance beyond which the light is ignored by clustered culling. Unless set
+  /// explicitly, the distance where the attenuated intensity (brightest channel)
+  /// drops below `cutoff`. The shader fades the light to zero at this radius.
+  [[nodiscard]] float range(float cutoff = 0.01f) const
   {
-    return glm::vec4(m_position, 1.0f);
+    if (m_range > 0.0f)
+      return m_range;
+
+    const float peak = m_intensity * glm::max(m_color.r, glm::max(m_color.g, m_color.b));
+    // Solve quadratic*d^2 + linear*d + constant = peak / cutoff for d.
+    const float c = m_attenuation_constant - peak / cutoff;
+    if (c >= 0.0f)
+      return 0.0f; // never brighter than the cutoff
+    if (m_attenuation_quadratic > 0.0f)
+    {
+      const float q = m_attenuation_quadratic, l = m_attenuation_linear;
+      return (-l + glm::sqrt(l * l - 4.0f * q * c)) / (2.0f * q);
+    }
+    if (m_attenuation_linear > 0.0f)
+      return -c / m_attenuation_linear;
+    return kMaxRange; // no falloff
   }
 
-private:
+  /// Upper bound for lights without distance falloff.
+  static constexpr float kMaxRange = 1.0e4f;
+
+protected:
   glm::vec3 m_position{ 0.0f, 0.0f, 0.0f };
   float m_attenuation_constant{ 1.0f };
   float m_attenuation_linear{ 0.09f };
   float m_attenuation_quadratic{ 0.032f };
+  float m_range{ 0.0f };
+};
+
+/// Point light - emits light in all directions from a position
+class PointLight : public LocalLight
+{
+public:
+  PointLight() = default;
+  PointLight(const glm::vec3& position)
+    : LocalLight(position)
+  {
+  }
+
+  /// Returns position with w=1 (indicates point light in shader)
+  [[nodiscard]] glm::vec4 position_or_direction() const override
+  {
+    return glm::vec4(m_position, 1.0f);
+  }
 };
 
 /// Spot light - emits light in a cone from a position
-class SpotLight : public Light
+class SpotLight : public LocalLight
 {
 public:
   SpotLight() = default;
   SpotLight(const glm::vec3& position, const glm::vec3& direction)
-    : m_position(position)
+    : LocalLight(position)
     , m_direction(glm::normalize(direction))
   {
   }
 
-  void set_position(const glm::vec3& position) { m_position = position; }
-  void set_position(float x, float y, float z) { m_position = glm::vec3(x, y, z); }
-  [[nodiscard]] glm::vec3 position() const { return m_position; }
-
   void set_direction(const glm::vec3& direction) { m_direction = glm::normalize(direction); }
   void set_direction(float x, float y, float z) { m_direction = glm::normalize(glm::vec3(x, y, z)); }
   [[nodiscard]] glm::vec3 direction() const { return m_direction; }
@@ -149,7 +187,6 @@ public:
   }
 
 private:
-  glm::vec3 m_position{ 0.0f, 0.0f, 0.0f };
   glm::vec3 m_direction{ 0.0f, 0.0f, -1.0f };
   float m_inner_cutoff{ glm::cos(glm::radians(12.5f)) };
   float m_outer_cutoff{ glm::cos(glm::radians(17.5f)) };
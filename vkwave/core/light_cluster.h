@@ -0,0 +1,108 @@
+#pragma once
+
+#include <vkwave/core/light.h>
+
+#include <cstdint>
+#include <cmath>
+
+#include <glm/glm.hpp>
+
+namespace vkwave
+{
+
+/// Froxel grid for clustered forward lighting: screen tiles in x/y,
+/// exponentially spaced view-depth slices in z. Fixed, independent of the
+/// render resolution (tiles scale with the extent).
+namespace LightCluster {
+  constexpr uint32_t GridX = 16;
+  constexpr uint32_t GridY = 9;
+  constexpr uint32_t GridZ = 24;
+  constexpr uint32_t Count = GridX * GridY * GridZ;
+
+  /// Per-cluster index-list capacity; lights past it are dropped for that cluster.
+  constexpr uint32_t MaxLightsPerCluster = 128;
+
+  /// Capacity of the per-slot light SSBO; the scene light array is truncated.
+  constexpr uint32_t MaxLights = 4096;
+
+  /// Light types in GpuLight::direction.w (same encoding as
+  /// Light::position_or_direction().w).
+  constexpr float TypePoint = 1.0f;
+  constexpr float TypeSpot  = 2.0f;
+}
+
+/// One punctual light in the per-slot light SSBO (cluster_lights.comp,
+/// pbr.frag). Must match the shader layout (std430).
+struct GpuLight
+{
+  glm::vec4 position;    // 16 bytes — xyz=world position, w=range (influence radius)
+  glm::vec4 color;       // 16 bytes — rgb=color, w=intensity
+  glm::vec4 direction;   // 16 bytes — xyz=spot direction, w=type (LightCluster::Type*)
+  glm::vec4 attenuation; // 16 bytes — x=constant, y=linear, z=quadratic, w=unused
+  glm::vec4 cone;        // 16 bytes — x=cos(inner), y=cos(outer), zw=unused
+};
+
+static_assert(sizeof(GpuLight) == 80,
+  "GpuLight must be 80 bytes to match shader layout (std430)");
+
+/// UBO for cluster_lights.comp: what is needed to rebuild the froxel bounds in
+/// view space. One copy per frame slot. Must match shader layout (std140).
+struct LightClusterParams
+{
+  glm::mat4 inverseProj; // 64 bytes — clip -> view, unprojects the tile corners
+  glm::mat4 view;        // 64 bytes — world -> view for the light positions
+  glm::uvec4 gridSize;   // 16 bytes — xyz=cluster counts, w=unused
+  glm::vec4 zRange;      // 16 bytes — x=near, y=far (slice distribution), zw=unused
+};
+
+static_assert(sizeof(LightClusterParams) == 160,
+  "LightClusterParams must be 160 bytes to match shader layout (std140)");
+
+/// Push constants for cluster_lights.comp.
+struct LightClusterPushConstants
+{
+  uint32_t lightCount;
+  uint32_t maxLightsPerCluster;
+  uint32_t pad0;
+  uint32_t pad1;
+};
+
+static_assert(sizeof(LightClusterPushConstants) == 16,
+  "LightClusterPushConstants must be 16 bytes to match shader layout");
+
+/// Depth-slice mapping shared by the culling pass and the fragment lookup:
+///   slice = floor(log(viewDepth) * scale - bias)
+/// so that slice k covers [near * (far/near)^(k/Z), near * (far/near)^((k+1)/Z)).
+/// Returns (scale, bias).
+inline glm::vec2 cluster_slice_params(float near_plane, float far_plane)
+{
+  const float log_ratio = std::log(far_plane / near_plane);
+  const float z = static_cast<float>(LightCluster::GridZ);
+  return { z / log_ratio, z * std::log(near_plane) / log_ratio };
+}
+
+inline GpuLight to_gpu_light(const PointLight& light)
+{
+  GpuLight g{};
+  g.position = glm::vec4(light.position(), light.range());
+  g.color = light.color_with_intensity();
+  g.direction = glm::vec4(0.0f, 0.0f, -1.0f, LightCluster::TypePoint);
+  g.attenuation = glm::vec4(light.attenuation_constant(), light.attenuation_linear(),
+    light.attenuation_quadratic(), 0.0f);
+  g.cone = glm::vec4(-1.0f, -1.0f, 0.0f, 0.0f);
+  return g;
+}
+
+inline GpuLight to_gpu_light(const SpotLight& light)
+{
+  GpuLight g{};
+  g.position = glm::vec4(light.position(), light.range());
+  g.color = light.color_with_intensity();
+  g.direction = glm::vec4(light.direction(), LightCluster::TypeSpot);
+  g.attenuation = glm::vec4(light.attenuation_constant(), light.attenuation_linear(),
+    light.attenuation_quadratic(), 0.0f);
+  g.cone = glm::vec4(light.inner_cutoff(), light.outer_cutoff(), 0.0f, 0.0f);
+  return g;
+}
+
+} // namespace vkwave
@@ -7,6 +7,24 @@
 namespace vkwave
 {
 
+namespace
+{
+
+// With acceleration structures the buffers are also their build inputs (read
+// through their device address), and with the ray tracing pipeline the hit
+// shaders read them as storage buffers (rt_geometry.glsl, SceneRayTracer).
+vk::BufferUsageFlags geometry_usage(const Device& device, vk::BufferUsageFlags usage)
+{
+  if (device.supports_acceleration_structures())
+    usage |= vk::BufferUsageFlagBits::eShaderDeviceAddress |
+      vk::BufferUsageFlagBits::eAccelerationStructureBuildInputReadOnlyKHR;
+  if (device.supports_ray_tracing())
+    usage |= vk::BufferUsageFlagBits::eStorageBuffer;
+  return usage;
+}
+
+} // namespace
+
 Mesh::Mesh(const Device& device, const std::string& name, const std::vector<Vertex>& vertices)
   : m_name(name)
   , m_vertex_count(static_cast<uint32_t>(vertices.size()))
@@ -14,7 +32,7 @@ Mesh::Mesh(const Device& device, const std::string& name, const std::vector<Vert
   vk::DeviceSize buffer_size = sizeof(Vertex) * vertices.size();
   m_vertex_buffer = Buffer::create_device_local(
     device, name + " vertex buffer", vertices.data(), buffer_size,
-    vk::BufferUsageFlagBits::eVertexBuffer);
+    geometry_usage(device, vk::BufferUsageFlagBits::eVertexBuffer));
 
   spdlog::trace("Created mesh '{}' with {} vertices", name, m_vertex_count);
 }
@@ -28,12 +46,12 @@ Mesh::Mesh(const Device& device, const std::string& name, const std::vector<Vert
   vk::DeviceSize vertex_buffer_size = sizeof(Vertex) * vertices.size();
   m_vertex_buffer = Buffer::create_device_local(
     device, name + " vertex buffer", vertices.data(), vertex_buffer_size,
-    vk::BufferUsageFlagBits::eVertexBuffer);
+    geometry_usage(device, vk::BufferUsageFlagBits::eVertexBuffer));
 
   vk::DeviceSize index_buffer_size = sizeof(uint32_t) * indices.size();
   m_index_buffer = Buffer::create_device_local(
     device, name + " index buffer", indices.data(), index_buffer_size,
-    vk::BufferUsageFlagBits::eIndexBuffer);
+    geometry_usage(device, vk::BufferUsageFlagBits::eIndexBuffer));
 
   spdlog::trace(
     "Created mesh '{}' with {} vertices, {} indices", name, m_vertex_count, m_index_count);
@@ -64,9 +82,10 @@ void Mesh::draw(vk::CommandBuffer cmd) const
 }
 
 void Mesh::draw_indexed(vk::CommandBuffer cmd, uint32_t index_count,
-  uint32_t first_index, int32_t vertex_offset) const
+  uint32_t first_index, int32_t vertex_offset,
+  uint32_t instance_count, uint32_t first_instance) const
 {
-  cmd.drawIndexed(index_count, 1, first_index, vertex_offset, 0);
+  cmd.drawIndexed(index_count, instance_count, first_index, vertex_offset, first_instance);
 }
 
 std::unique_ptr<Mesh> Mesh::create_cube(const Device& device)
@@ -51,8 +51,11 @@ public:
   void draw(vk::CommandBuffer cmd) const;
 
   /// @brief Record an indexed draw for a sub-range of the index buffer.
+  /// `instance_count` instances starting at `first_instance` (per-instance
+  /// vertex streams are indexed from it).
   void draw_indexed(vk::CommandBuffer cmd, uint32_t index_count,
-    uint32_t first_index, int32_t vertex_offset) const;
+    uint32_t first_index, int32_t vertex_offset,
+    uint32_t instance_count = 1, uint32_t first_instance = 0) const;
 
   /// @brief Get the number of vertices.
   [[nodiscard]] uint32_t vertex_count() const { return m_vertex_count; }
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+#include <vulkan/vulkan.hpp>
+
+namespace vkwave
+{
+
+/// Push constants for spd_downsample.comp (one dispatch per mip chain).
+struct SpdPushConstants
+{
+  glm::ivec2 srcSize;    //  8 bytes — readable part of the source (render extent)
+  glm::ivec2 dstSize;    //  8 bytes — mip 0 extent of the target
+  int32_t mipCount;      //  4 bytes — levels to write, <= kSpdMaxMips
+  uint32_t groupCount;   //  4 bytes — workgroups in the dispatch
+  int32_t pad[2];        //  8 bytes
+};
+
+static_assert(sizeof(SpdPushConstants) == 32,
+  "SpdPushConstants must be 32 bytes to match shader layout");
+
+/// Levels spd_downsample.comp can write: mip 0 (the copy) plus two 6-level
+/// reductions of 64x64 tiles.
+inline constexpr uint32_t kSpdMaxMips = 13;
+/// Mip 0 tile covered by one workgroup.
+inline constexpr uint32_t kSpdTileSize = 64;
+
+/// Levels written for a target of `extent` with `image_levels` mips. The
+/// second reduction runs in a single workgroup over mip 6, so it only fits a
+/// target of up to 4096 texels a side; larger ones stop after mip 6.
+inline uint32_t spd_mip_count(vk::Extent2D extent, uint32_t image_levels)
+{
+  uint32_t levels = std::min(image_levels, kSpdMaxMips);
+  if (std::max(extent.width, extent.height) > kSpdTileSize * kSpdTileSize)
+    levels = std::min(levels, 7u);
+  return levels;
+}
+
+} // namespace vkwave
@@ -1,12 +1,20 @@
 #pragma once
 
+#include <vkwave/core/shadow_cascade.h>
+
+#include <algorithm>
 #include <cstdint>
 
 #include <glm/glm.hpp>
+#include <vulkan/vulkan.hpp>
 
 namespace vkwave
 {
 
+/// Most views one multiview PBR draw renders (the shaders' array size; the
+/// spec guarantees maxMultiviewViewCount >= 6).
+inline constexpr uint32_t kMaxPbrViews = 6;
+
 /// UBO for PBR per-frame camera + lighting data.
 /// Ring-buffered by the execution group (one copy per swapchain image).
 /// Must match shader layout (std140).
@@ -16,10 +24,56 @@ struct PbrUBO
   glm::vec4 camPos;         // 16 bytes — xyz=camera position, w=unused
   glm::vec4 lightDirection; // 16 bytes — xyz=direction, w=intensity
   glm::vec4 lightColor;     // 16 bytes — rgb=color, a=unused
+
+  // Clustered lights (see light_cluster.h). clusterGrid.w == 0 skips the loop.
+  glm::mat4 view;           // 64 bytes — world -> view, for the fragment's slice depth
+  glm::vec4 clusterDepth;   // 16 bytes — x=slice scale, y=slice bias, zw=tile size (px)
+  glm::uvec4 clusterGrid;   // 16 bytes — xyz=cluster counts, w=light count
+
+  // Directional-light cascaded shadows (see shadow_cascade.h). shadow.params.x
+  // == 0 leaves the light unshadowed.
+  ShadowUniforms shadow;    // 304 bytes
+
+  // Dynamic resolution (see render_viewport_params()).
+  glm::vec4 viewport;       // 16 bytes — xy=render extent / target extent, zw=1 / target extent
+
+  // Temporal AA: viewProj carries the sub-pixel jitter; motion vectors are
+  // taken between these two unjittered matrices.
+  glm::mat4 unjitteredViewProj; // 64 bytes
+  glm::mat4 prevViewProj;       // 64 bytes — last frame's unjitteredViewProj
+
+  // Multiview (VK_KHR_multiview): views.x > 0 makes pbr.vert/pbr.frag take the
+  // camera from these arrays by gl_ViewIndex instead of viewProj/camPos.
+  glm::uvec4 views;                       //  16 bytes — x=view count
+  glm::mat4 viewProjs[kMaxPbrViews];      // 384 bytes
+  glm::vec4 viewCamPos[kMaxPbrViews];     //  96 bytes — xyz=camera position
+
+  // Ray queries (PbrFlags::RayTracedShadows / RayTracedReflections).
+  glm::vec4 rayTracing;     // 16 bytes — x=tan(sun half-angle), y=reflection roughness cutoff,
+                            //            z=max ray distance, w=frame (animates the jitter)
 };
 
-static_assert(sizeof(PbrUBO) == 112,
-  "PbrUBO must be 112 bytes to match shader layout (std140)");
+static_assert(sizeof(PbrUBO) == 1168,
+  "PbrUBO must be 1168 bytes to match shader layout (std140)");
+
+/// Cameras of a multiview draw (PBRContext::views), one per view-mask bit.
+struct PbrViews
+{
+  uint32_t count{ 0 };
+  glm::mat4 view_projection[kMaxPbrViews]{};
+  glm::vec3 cam_position[kMaxPbrViews]{};
+};
+
+/// PbrUBO::viewport for a pass drawing `render` pixels into the top-left corner
+/// of `target`-sized attachments: the screen-UV -> texture-UV scale, and the
+/// texel size for clamping reads to the rendered region.
+inline glm::vec4 render_viewport_params(vk::Extent2D target, vk::Extent2D render)
+{
+  const float w = static_cast<float>(std::max(target.width, 1u));
+  const float h = static_cast<float>(std::max(target.height, 1u));
+  return glm::vec4(static_cast<float>(render.width) / w,
+    static_cast<float>(render.height) / h, 1.0f / w, 1.0f / h);
+}
 
 /// Flags for toggling PBR features.
 ///
@@ -34,12 +88,17 @@ namespace PbrFlags {
   constexpr uint32_t Emissive           = 1u << 1;
   constexpr uint32_t Clearcoat          = 1u << 2; // apply KHR_materials_clearcoat layer
   constexpr uint32_t Anisotropy         = 1u << 4; // apply KHR_materials_anisotropy
+  constexpr uint32_t WeightedOit        = 1u << 6; // write OIT accumulation + revealage (OitPass)
+  constexpr uint32_t ScreenSpaceAO      = 1u << 7; // occlude IBL with set 0's ambientOcclusion
+  constexpr uint32_t RayTracedShadows   = 1u << 8; // directional light shadowed by ray query (RAY_QUERY builds)
+  constexpr uint32_t RayTracedReflections = 1u << 9; // specular IBL occluded by ray query (RAY_QUERY builds)
 
   // Material (SSBO) — authored per material
   constexpr uint32_t ClearcoatNormalMap = 1u << 3; // coat has a dedicated normal texture
   constexpr uint32_t AnisotropyMap      = 1u << 5; // anisotropy has a direction texture
 
-  constexpr uint32_t GlobalMask   = NormalMapping | Emissive | Clearcoat | Anisotropy;
+  constexpr uint32_t GlobalMask   = NormalMapping | Emissive | Clearcoat | Anisotropy | WeightedOit
+                                | ScreenSpaceAO | RayTracedShadows | RayTracedReflections;
   constexpr uint32_t MaterialMask = ClearcoatNormalMap | AnisotropyMap;
 }
 
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+#include <vulkan/vulkan.hpp>
+
+namespace vkwave
+{
+
+/// bloom.comp step, in dispatch order.
+inline constexpr int32_t kBloomPrefilter = 0;  ///< current image -> level 1, thresholded
+inline constexpr int32_t kBloomDownsample = 1; ///< level k-1 -> level k
+inline constexpr int32_t kBloomUpsample = 2;   ///< level k += tent(level k+1)
+inline constexpr int32_t kBloomComposite = 3;  ///< current image += intensity * tent(level 1)
+
+/// Deepest pyramid level bloom builds (mip 6: 1/64 of the image).
+inline constexpr uint32_t kBloomMaxLevels = 6;
+
+/// Push constants for bloom.comp (one dispatch per level and direction).
+struct BloomPushConstants
+{
+  glm::ivec2 dstRegion; //  8 bytes — texels of the destination level to write
+  glm::vec2 dstTexel;   //  8 bytes — 1 / destination level size
+  glm::vec2 srcTexel;   //  8 bytes — 1 / source level size
+  glm::vec2 srcUvMax;   //  8 bytes — last readable uv of the source (half a texel inside its region)
+  float srcLod;         //  4 bytes — source level in the sampled view
+  int32_t mode;         //  4 bytes — kBloomPrefilter .. kBloomComposite
+  float threshold;      //  4 bytes — prefilter: luminance where bloom starts
+  float knee;           //  4 bytes — prefilter: width of the soft threshold
+  float intensity;      //  4 bytes — composite: weight of the summed levels
+  int32_t pad[3];       // 12 bytes
+};
+
+static_assert(sizeof(BloomPushConstants) == 64,
+  "BloomPushConstants must be 64 bytes to match shader layout");
+
+/// Push constants for chromatic_aberration.comp.
+struct ChromaticAberrationPushConstants
+{
+  glm::ivec2 region;    //  8 bytes — rendered part of the image (dynamic resolution)
+  glm::vec2 texel;      //  8 bytes — 1 / image size
+  glm::vec2 uvMax;      //  8 bytes — last readable uv (half a texel inside the region)
+  float strength;       //  4 bytes — red/blue offset, as a fraction of the distance to the centre
+  float pad;            //  4 bytes
+};
+
+static_assert(sizeof(ChromaticAberrationPushConstants) == 32,
+  "ChromaticAberrationPushConstants must be 32 bytes to match shader layout");
+
+/// Push constants for vignette.comp.
+struct VignettePushConstants
+{
+  glm::ivec2 region;    //  8 bytes — rendered part of the image (dynamic resolution)
+  float intensity;      //  4 bytes — darkening at the corners (0 = none, 1 = black)
+  float radius;         //  4 bytes — where the falloff starts (0 = centre, 1 = corners)
+};
+
+static_assert(sizeof(VignettePushConstants) == 16,
+  "VignettePushConstants must be 16 bytes to match shader layout");
+
+/// Push constants for post_fx_input.comp.
+struct PostFxInputPushConstants
+{
+  glm::ivec2 region;    //  8 bytes — texels to copy, from the top-left
+};
+
+static_assert(sizeof(PostFxInputPushConstants) == 8,
+  "PostFxInputPushConstants must be 8 bytes to match shader layout");
+
+/// Pyramid levels (below mip 0) bloom builds over a `region` of an image with
+/// `image_levels` mips: at most `max_levels`, and none smaller than 2 texels
+/// along the region's short side.
+inline uint32_t bloom_levels(vk::Extent2D region, uint32_t image_levels,
+                             uint32_t max_levels = kBloomMaxLevels)
+{
+  const uint32_t short_side = std::min(region.width, region.height);
+  uint32_t levels = 0;
+  while (levels + 1 < image_levels && levels < max_levels && (short_side >> (levels + 1)) >= 2)
+    ++levels;
+  return levels;
+}
+
+} // namespace vkwave
@@ -1,5 +1,6 @@
 #include <vkwave/core/semaphore.h>
 
+#include <vkwave/core/deletion_queue.h>
 #include <vkwave/core/device.h>
 
 #include <cassert>
@@ -28,7 +29,11 @@ Semaphore::Semaphore(Semaphore&& other) noexcept
 
 Semaphore::~Semaphore()
 {
-  vkDestroySemaphore(m_device.device(), m_semaphore, nullptr);
+  // A queued submit or present may still wait on or signal it.
+  if (m_semaphore)
+    m_device.deletion_queue().push([device = m_device.device(), semaphore = m_semaphore] {
+      device.destroySemaphore(semaphore);
+    });
 }
 
 }
@@ -0,0 +1,129 @@
+#include <vkwave/core/shadow_cascade.h>
+
+#include <vkwave/core/camera.h>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace vkwave
+{
+
+namespace
+{
+
+// Squared half-diagonal of the view frustum cross-section, per unit of view
+// depth (perspective) or absolute (parallel projection).
+float cross_section_sq(const Camera& camera)
+{
+  const float aspect_sq = camera.aspect_ratio() * camera.aspect_ratio();
+  if (camera.parallel_projection())
+    return camera.parallel_scale() * camera.parallel_scale() * (1.0f + aspect_sq);
+  const float t = std::tan(glm::radians(camera.view_angle()) * 0.5f);
+  return t * t * (1.0f + aspect_sq);
+}
+
+} // namespace
+
+std::array<float, ShadowCascade::Count> cascade_split_distances(
+  float near_plane, float far_plane, float lambda)
+{
+  std::array<float, ShadowCascade::Count> splits{};
+  const float ratio = far_plane / near_plane;
+  for (uint32_t i = 0; i < ShadowCascade::Count; ++i)
+  {
+    const float p = static_cast<float>(i + 1) / static_cast<float>(ShadowCascade::Count);
+    const float log_split = near_plane * std::pow(ratio, p);
+    const float uniform_split = near_plane + (far_plane - near_plane) * p;
+    splits[i] = lambda * log_split + (1.0f - lambda) * uniform_split;
+  }
+  splits.back() = far_plane;
+  return splits;
+}
+
+glm::vec4 frustum_slice_sphere(const Camera& camera, float slice_near, float slice_far)
+{
+  const glm::vec3 eye = camera.position();
+  const glm::vec3 dir = camera.direction_of_projection();
+  const float k = cross_section_sq(camera);
+
+  if (camera.parallel_projection())
+  {
+    // Constant cross-section: the box centre, out to a far corner.
+    const float half_depth = 0.5f * (slice_far - slice_near);
+    const float centre = slice_near + half_depth;
+    return glm::vec4(eye + dir * centre, std::sqrt(half_depth * half_depth + k));
+  }
+
+  // Centre on the view axis equidistant from the near and far corners; when
+  // that falls past the far plane the far cap alone bounds the slice.
+  float centre = 0.5f * (slice_near + slice_far) * (1.0f + k);
+  float radius = 0.0f;
+  if (centre >= slice_far)
+  {
+    centre = slice_far;
+    radius = std::sqrt(k) * slice_far;
+  }
+  else
+  {
+    const float dz = slice_far - centre;
+    radius = std::sqrt(dz * dz + k * slice_far * slice_far);
+  }
+  return glm::vec4(eye + dir * centre, radius);
+}
+
+glm::vec4 camera_centered_sphere(const Camera& camera, float slice_far)
+{
+  const float k = cross_section_sq(camera);
+  const float radius = camera.parallel_projection()
+    ? std::sqrt(slice_far * slice_far + k)
+    : slice_far * std::sqrt(1.0f + k);
+  return glm::vec4(camera.position(), radius);
+}
+
+CascadeFit fit_cascade(const glm::vec4& sphere, const glm::vec3& light_direction,
+  const glm::vec3& scene_min, const glm::vec3& scene_max, uint32_t resolution)
+{
+  const glm::vec3 to_light = glm::normalize(light_direction);
+  const glm::vec3 up = std::abs(to_light.y) > 0.99f
+    ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+
+  // Rotation only (eye at the origin): the texel lattice is fixed in world
+  // space for a given light direction, so snapping to it is translation-stable.
+  const glm::mat4 light_view = glm::lookAt(glm::vec3(0.0f), -to_light, up);
+
+  const float radius = std::max(sphere.w, 1e-4f);
+  const float texel = 2.0f * radius / static_cast<float>(resolution);
+
+  glm::vec3 c = glm::vec3(light_view * glm::vec4(glm::vec3(sphere), 1.0f));
+  c.x = std::floor(c.x / texel) * texel;
+  c.y = std::floor(c.y / texel) * texel;
+
+  // Depth along the light's travel (light space looks down -z). Pull the near
+  // plane back to the scene bounds so casters between the light and the
+  // sphere still land in the map.
+  float near_plane = -c.z - radius;
+  const float far_plane = -c.z + radius;
+  if (scene_min.x <= scene_max.x)
+  {
+    for (int i = 0; i < 8; ++i)
+    {
+      const glm::vec3 corner(
+        (i & 1) ? scene_max.x : scene_min.x,
+        (i & 2) ? scene_max.y : scene_min.y,
+        (i & 4) ? scene_max.z : scene_min.z);
+      near_plane = std::min(near_plane, -(light_view * glm::vec4(corner, 1.0f)).z);
+    }
+  }
+
+  CascadeFit fit;
+  fit.view_proj = glm::ortho(c.x - radius, c.x + radius, c.y - radius, c.y + radius,
+                             near_plane, far_plane) * light_view;
+  fit.center = glm::vec3(sphere);
+  fit.radius = radius;
+  fit.texel_size = texel;
+  return fit;
+}
+
+} // namespace vkwave
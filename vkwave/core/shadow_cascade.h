@@ -0,0 +1,86 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+namespace vkwave
+{
+
+class Camera;
+
+/// Cascaded shadow maps for the directional light. The cascades partition the
+/// camera's view depth; each one is an orthographic depth map stored as a layer
+/// of one depth array image.
+namespace ShadowCascade {
+  constexpr uint32_t Count = 4;
+
+  /// Edge length of every cascade layer in texels.
+  constexpr uint32_t Resolution = 2048;
+
+  /// Blend between uniform (0) and logarithmic (1) split distances.
+  constexpr float DefaultSplitLambda = 0.75f;
+}
+
+/// Push constants for shadow.vert: one draw of one caster into one cascade.
+struct ShadowPushConstants
+{
+  glm::mat4 lightViewProj; // 64 bytes — world -> cascade clip space
+  glm::mat4 model;         // 64 bytes — caster world transform
+};
+
+static_assert(sizeof(ShadowPushConstants) == 128,
+  "ShadowPushConstants must be 128 bytes to match shader layout");
+
+/// Directional-shadow block of the PBR UBO (see PbrUBO::shadow). Must match the
+/// shader layout (std140): the cascade matrices are a mat4[Count] array.
+struct ShadowUniforms
+{
+  glm::mat4 matrices[ShadowCascade::Count]; // 256 bytes — world -> cascade clip space
+  glm::vec4 splits;                         //  16 bytes — far view depth of each cascade
+  glm::vec4 texelSize;                      //  16 bytes — world units per texel, per cascade
+  glm::vec4 params;                         //  16 bytes — x=enabled, y=normal offset (texels),
+                                            //             z=PCF radius (texels), w=1/Resolution
+};
+
+static_assert(sizeof(ShadowUniforms) == 304,
+  "ShadowUniforms must be 304 bytes to match shader layout (std140)");
+
+/// One cascade's light-space projection.
+struct CascadeFit
+{
+  glm::mat4 view_proj{ 1.0f }; // world -> cascade clip space (depth 0..1)
+  glm::vec3 center{ 0.0f };    // world-space centre of the covered sphere
+  float radius{ 0.0f };        // radius of the covered sphere
+  float texel_size{ 0.0f };    // world units per shadow texel
+};
+
+/// Far view depth of each cascade, using the practical split scheme: a
+/// `lambda`-weighted blend of logarithmic and uniform partitions of
+/// [near_plane, far_plane]. The last split is always far_plane.
+std::array<float, ShadowCascade::Count> cascade_split_distances(
+  float near_plane, float far_plane, float lambda);
+
+/// Smallest sphere around the part of the camera frustum between view depths
+/// `slice_near` and `slice_far`. The radius depends only on the projection, not
+/// on the camera orientation, so the cascade footprint does not breathe while
+/// the camera turns. Returns (world centre, radius).
+glm::vec4 frustum_slice_sphere(const Camera& camera, float slice_near, float slice_far);
+
+/// Sphere centred on the camera that contains the slice [slice_near, slice_far]
+/// for every camera orientation. Looser than frustum_slice_sphere(), but it
+/// only moves when the camera translates, which is what lets a far cascade be
+/// cached across frames.
+glm::vec4 camera_centered_sphere(const Camera& camera, float slice_far);
+
+/// Fit an orthographic light projection around `sphere` (world centre, radius)
+/// for light travelling along -`light_direction` (which points at the light).
+/// The projection window is snapped to whole texels in light space, so moving
+/// the sphere shifts the map by whole texels and the shadow edges stay put.
+/// The depth range reaches back to cover [scene_min, scene_max] so casters
+/// outside the sphere still shadow it.
+CascadeFit fit_cascade(const glm::vec4& sphere, const glm::vec3& light_direction,
+  const glm::vec3& scene_min, const glm::vec3& scene_max, uint32_t resolution);
+
+} // namespace vkwave
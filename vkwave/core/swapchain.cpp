@@ -3,6 +3,7 @@
 #include <spdlog/common.h>
 #include <spdlog/spdlog.h>
 
+#include <vkwave/core/deletion_queue.h>
 #include <vkwave/core/device.h>
 #include <vkwave/core/exception.h>
 #include <vkwave/core/representation.h>
@@ -289,6 +290,17 @@ void Swapchain::setup_swapchain(
   {
     imageUsage |= vk::ImageUsageFlagBits::eTransferSrc;
   }
+  // Storage for a compute composite. The swapchain formats have no GLSL format
+  // qualifier, so the shader writes them without one.
+  const auto format_features = m_device.physicalDevice()
+    .getFormatProperties(m_surface_format.value().format).optimalTilingFeatures;
+  m_storage_images = (caps.supportedUsageFlags & vk::ImageUsageFlagBits::eStorage)
+    && (format_features & vk::FormatFeatureFlagBits::eStorageImage)
+    && m_device.enabled_features().shaderStorageImageWriteWithoutFormat == VK_TRUE;
+  if (m_storage_images)
+  {
+    imageUsage |= vk::ImageUsageFlagBits::eStorage;
+  }
 
   vk::SwapchainCreateInfoKHR createInfo =
     vk::SwapchainCreateInfoKHR(vk::SwapchainCreateFlagsKHR(),      //
@@ -364,14 +376,20 @@ void Swapchain::setup_swapchain(
 
   if (old_swapchain != vk::SwapchainKHR(nullptr))
   {
-    for (auto const img_view : m_img_views)
+    auto destroy_old = [device = m_device.device(), old_swapchain, views = m_img_views]()
     {
-      // An image view for each frame
-      m_device.device().destroyImageView(img_view);
-    }
+      for (auto const img_view : views)
+      {
+        // An image view for each frame
+        device.destroyImageView(img_view);
+      }
+      device.destroySwapchainKHR(old_swapchain);
+    };
+    // The old swapchain is retired by the create above: its queued presents
+    // still complete, so frames in flight can finish on it.
+    m_device.deletion_queue().push(std::move(destroy_old));
     m_imgs.clear();
     m_img_views.clear();
-    m_device.device().destroySwapchainKHR(old_swapchain);
   }
 
   // Store the ACTUAL chosen extent, not the requested extent
@@ -434,6 +452,7 @@ Swapchain::Swapchain(Swapchain&& other) noexcept
   // Consider adding frame with sets of semaphores
   m_vsync_enabled = other.m_vsync_enabled;
   m_present_mode = other.m_present_mode;
+  m_storage_images = other.m_storage_images;
 }
 
 Swapchain::~Swapchain()
@@ -32,6 +32,7 @@ private:
   vk::SwapchainKHR m_swapchain{ nullptr };
   vk::PresentModeKHR m_present_mode{ vk::PresentModeKHR::eFifo };
   std::vector<vk::PresentModeKHR> m_available_present_modes;
+  bool m_storage_images{ false };
 
   //  std::unique_ptr<Semaphore> m_img_available;
   [[nodiscard]] std::vector<vk::Image> get_swapchain_images();
@@ -60,6 +61,9 @@ private:
     const std::uint32_t width, const std::uint32_t height, const bool vsync_enabled);
 
 public:
+  /// Recreate at a new size, handing the old swapchain over as oldSwapchain.
+  /// The old swapchain and its views go to the device deletion queue until the
+  /// frames still presenting from them have completed.
   void recreate(std::uint32_t width, std::uint32_t height)
   {
     setup_swapchain(width, height, m_vsync_enabled);
@@ -96,6 +100,9 @@ public:
   [[nodiscard]] const std::vector<vk::Image>& images() const { return m_imgs; }
   [[nodiscard]] const vk::SwapchainKHR* swapchain() const { return &m_swapchain; }
   [[nodiscard]] vk::PresentModeKHR present_mode() const { return m_present_mode; }
+  /// True if the images can be written as storage images (without a format
+  /// qualifier) — e.g. by a compute composite.
+  [[nodiscard]] bool storage_images() const { return m_storage_images; }
   [[nodiscard]] const std::vector<vk::PresentModeKHR>& available_present_modes() const
   {
     return m_available_present_modes;
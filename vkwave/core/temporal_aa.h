@@ -0,0 +1,53 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+#include <vulkan/vulkan.hpp>
+
+namespace vkwave
+{
+
+/// Push constants for taa.comp (one dispatch per frame over the output).
+struct TaaPushConstants
+{
+  glm::vec4 renderScale; // 16 bytes — xy=render extent / target extent, zw=1 / target extent
+  glm::vec2 jitter;      //  8 bytes — this frame's projection jitter (NDC)
+  float feedback;        //  4 bytes — weight of the current frame (1 = no history)
+  uint32_t pad;          //  4 bytes
+};
+
+static_assert(sizeof(TaaPushConstants) == 32,
+  "TaaPushConstants must be 32 bytes to match shader layout");
+
+/// Number of distinct sub-pixel positions in the jitter sequence.
+inline constexpr uint32_t kTaaJitterPhases = 8;
+
+/// Radical inverse of `index` in `base` (Halton sequence), in [0, 1).
+inline float halton(uint32_t index, uint32_t base)
+{
+  float f = 1.0f;
+  float r = 0.0f;
+  while (index > 0)
+  {
+    f /= static_cast<float>(base);
+    r += f * static_cast<float>(index % base);
+    index /= base;
+  }
+  return r;
+}
+
+/// Projection jitter for `frame`: Halton(2, 3) offsets within one pixel of an
+/// `extent`-sized render target, centred on the pixel and returned in NDC
+/// (pass to Camera::set_jitter()). Index 0 of the sequence is skipped — it is
+/// the pixel corner, not a sample inside it.
+inline glm::vec2 taa_jitter(uint32_t frame, vk::Extent2D extent)
+{
+  const uint32_t i = (frame % kTaaJitterPhases) + 1;
+  const glm::vec2 pixel(halton(i, 2) - 0.5f, halton(i, 3) - 0.5f);
+  return 2.0f * pixel / glm::vec2(static_cast<float>(std::max(extent.width, 1u)),
+    static_cast<float>(std::max(extent.height, 1u)));
+}
+
+} // namespace vkwave
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+
+namespace vkwave
+{
+
+/// Which of a temporal pass's per-slot outputs holds its history.
+///
+/// The offscreen slot advances every display frame, but a gated group records
+/// on only some of them (RenderGraph multi-rate), so the history is the output
+/// written last, not the previous slot's. A pass recording in `slot` writes
+/// target(slot) and blends with latest() when usable(slot), then calls
+/// written().
+class TemporalHistory
+{
+  uint32_t m_count{ 0 };
+  uint32_t m_latest{ UINT32_MAX };
+  bool m_valid{ false };
+
+public:
+  /// `count` outputs, one per slot, none written yet.
+  void resize(uint32_t count)
+  {
+    m_count = count;
+    m_latest = UINT32_MAX;
+    m_valid = false;
+  }
+
+  /// Drop the history (camera cut). latest() still names the output written
+  /// last: frames until the next write keep presenting it.
+  void reset() { m_valid = false; }
+
+  /// True when latest() is a history: written since the last reset.
+  [[nodiscard]] bool valid() const { return m_valid; }
+
+  /// True once an output has been written since resize().
+  [[nodiscard]] bool written_any() const { return m_latest < m_count; }
+
+  /// The output written last (only meaningful when written_any()).
+  [[nodiscard]] uint32_t latest() const { return m_latest; }
+
+  /// The output to write when recording in `slot`: the slot's own, or the
+  /// next one when the slot's still holds the latest (the group skipped a
+  /// multiple of the slot count).
+  [[nodiscard]] uint32_t target(uint32_t slot) const
+  {
+    return (slot == m_latest && m_count > 1) ? (slot + 1) % m_count : slot;
+  }
+
+  /// True when a pass recording in `slot` can blend with latest(): it is a
+  /// history (written since the last reset) and not the output being written.
+  [[nodiscard]] bool usable(uint32_t slot) const
+  {
+    return m_valid && target(slot) != m_latest;
+  }
+
+  void written(uint32_t output)
+  {
+    m_latest = output;
+    m_valid = true;
+  }
+};
+
+} // namespace vkwave
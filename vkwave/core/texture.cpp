@@ -4,6 +4,7 @@
 #include <vkwave/core/texture.h>
 #include <vkwave/core/buffer.h>
 #include <vkwave/core/commands.h>
+#include <vkwave/core/deletion_queue.h>
 #include <vkwave/core/device.h>
 
 #include <spdlog/spdlog.h>
@@ -66,33 +67,9 @@ Texture::~Texture()
     return;
   }
 
-  auto dev = m_device->device();
+  release();
 
-  if (m_sampler)
-  {
-    dev.destroySampler(m_sampler);
-    m_sampler = VK_NULL_HANDLE;
-  }
-
-  if (m_image_view)
-  {
-    dev.destroyImageView(m_image_view);
-    m_image_view = VK_NULL_HANDLE;
-  }
-
-  if (m_image)
-  {
-    dev.destroyImage(m_image);
-    m_image = VK_NULL_HANDLE;
-  }
-
-  if (m_memory)
-  {
-    dev.freeMemory(m_memory);
-    m_memory = VK_NULL_HANDLE;
-  }
-
-  spdlog::trace("Destroyed texture '{}'", m_name);
+  spdlog::trace("Retired texture '{}'", m_name);
 }
 
 Texture::Texture(Texture&& other) noexcept
@@ -115,23 +92,33 @@ Texture::Texture(Texture&& other) noexcept
   other.m_height = 0;
 }
 
+void Texture::release()
+{
+  // Defer past the frames that may still sample it.
+  m_device->deletion_queue().push([device = m_device->device(), sampler = m_sampler,
+                                    view = m_image_view, image = m_image, memory = m_memory] {
+    if (sampler)
+      device.destroySampler(sampler);
+    if (view)
+      device.destroyImageView(view);
+    if (image)
+      device.destroyImage(image);
+    if (memory)
+      device.freeMemory(memory);
+  });
+  m_sampler = VK_NULL_HANDLE;
+  m_image_view = VK_NULL_HANDLE;
+  m_image = VK_NULL_HANDLE;
+  m_memory = VK_NULL_HANDLE;
+}
+
 Texture& Texture::operator=(Texture&& other) noexcept
 {
   if (this != &other)
   {
     // Clean up existing resources
     if (m_device != nullptr)
-    {
-      auto dev = m_device->device();
-      if (m_sampler)
-        dev.destroySampler(m_sampler);
-      if (m_image_view)
-        dev.destroyImageView(m_image_view);
-      if (m_image)
-        dev.destroyImage(m_image);
-      if (m_memory)
-        dev.freeMemory(m_memory);
-    }
+      release();
 
     // Move from other
     m_device = other.m_device;
@@ -79,6 +79,8 @@ private:
   uint32_t m_mip_levels{ 1 };
   vk::Format m_format{ vk::Format::eR8G8B8A8Srgb };
 
+  // Hand the handles to the device deletion queue and null them.
+  void release();
   void create_image();
   void create_image_view();
   void create_sampler();
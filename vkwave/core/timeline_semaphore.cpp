@@ -1,5 +1,6 @@
 #include <vkwave/core/timeline_semaphore.h>
 
+#include <vkwave/core/deletion_queue.h>
 #include <vkwave/core/device.h>
 
 #include <cassert>
@@ -34,8 +35,11 @@ TimelineSemaphore::TimelineSemaphore(TimelineSemaphore&& other) noexcept
 
 TimelineSemaphore::~TimelineSemaphore()
 {
+  // A queued submit or present may still wait on or signal it.
   if (m_semaphore)
-    vkDestroySemaphore(m_device.device(), m_semaphore, nullptr);
+    m_device.deletion_queue().push([device = m_device.device(), semaphore = m_semaphore] {
+      device.destroySemaphore(semaphore);
+    });
 }
 
 void TimelineSemaphore::wait(uint64_t value, uint64_t timeout) const
@@ -68,6 +68,11 @@ void Window::poll()
   glfwPollEvents();
 }
 
+void Window::wait(double timeout_seconds)
+{
+  glfwWaitEventsTimeout(timeout_seconds);
+}
+
 void Window::set_resize_pending(std::uint32_t width, std::uint32_t height)
 {
   m_pending_width = width;
@@ -63,6 +63,9 @@ public:
 
   static void poll();
 
+  // Block until an event arrives or timeout_seconds elapse, then process it.
+  static void wait(double timeout_seconds);
+
   bool should_close() const;
 };
 }
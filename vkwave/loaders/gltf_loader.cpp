@@ -8,6 +8,7 @@
 
 #include <spdlog/spdlog.h>
 
+#include <algorithm>
 #include <filesystem>
 #include <unordered_map>
 
@@ -886,13 +887,14 @@ namespace
 
 /// @brief Generic texture extraction from a cgltf_texture_view.
 /// Works for any texture slot (base color, normal, metallic/roughness, emissive, AO).
+/// @param device Null when loading without a GPU (no texture is created).
 /// @param linear If true, create texture with UNORM format (for data textures like normal/MR/AO).
 std::unique_ptr<Texture> extract_texture(
-  const cgltf_texture_view& tex_view, const Device& device,
+  const cgltf_texture_view& tex_view, const Device* device,
   const std::filesystem::path& base_path, const std::string& slot_name,
   bool linear = false)
 {
-  if (!tex_view.texture || !tex_view.texture->image)
+  if (!device || !tex_view.texture || !tex_view.texture->image)
   {
     return nullptr;
   }
@@ -918,7 +920,7 @@ std::unique_ptr<Texture> extract_texture(
     }
 
     std::string tex_name = image->name ? image->name : ("embedded_" + slot_name);
-    auto tex = std::make_unique<Texture>(device, tex_name, pixels,
+    auto tex = std::make_unique<Texture>(*device, tex_name, pixels,
       static_cast<uint32_t>(width), static_cast<uint32_t>(height), linear);
 
     stbi_image_free(pixels);
@@ -948,7 +950,7 @@ std::unique_ptr<Texture> extract_texture(
 
     try
     {
-      auto tex = std::make_unique<Texture>(device, tex_name, tex_path.string(), linear);
+      auto tex = std::make_unique<Texture>(*device, tex_name, tex_path.string(), linear);
       spdlog::info("Loaded {} texture: {} from {}", slot_name, tex_name, tex_path.string());
       return tex;
     }
@@ -966,13 +968,15 @@ std::unique_ptr<Texture> extract_texture(
 void traverse_nodes(
   const cgltf_node* node,
   const cgltf_data* data,
-  const Device& device,
+  const Device* device,
   const std::filesystem::path& base_path,
   std::vector<Vertex>& all_vertices,
   std::vector<uint32_t>& all_indices,
   std::vector<ScenePrimitive>& primitives,
   std::vector<SceneMaterial>& materials,
   std::unordered_map<const cgltf_material*, uint32_t>& material_map,
+  std::unordered_map<const cgltf_primitive*, uint32_t>& geometry_map,
+  uint32_t& mesh_count,
   AABB& bounds)
 {
   // Compute world transform for this node
@@ -999,6 +1003,26 @@ void traverse_nodes(
         continue;
       }
 
+      // Another node instancing a mesh already uploaded: reuse its index range,
+      // material and object-space bounds under this node's transform.
+      if (auto geo = geometry_map.find(&primitive); geo != geometry_map.end())
+      {
+        ScenePrimitive scene_prim = primitives[geo->second];
+        scene_prim.modelMatrix = model_matrix;
+        if (!scene_prim.bounds.valid())
+          bounds.expand(glm::vec3(model_matrix[3]));
+        for (int c = 0; c < 8 && scene_prim.bounds.valid(); ++c)
+        {
+          glm::vec3 corner(
+            (c & 1) ? scene_prim.bounds.max.x : scene_prim.bounds.min.x,
+            (c & 2) ? scene_prim.bounds.max.y : scene_prim.bounds.min.y,
+            (c & 4) ? scene_prim.bounds.max.z : scene_prim.bounds.min.z);
+          bounds.expand(glm::vec3(model_matrix * glm::vec4(corner, 1.0f)));
+        }
+        primitives.push_back(scene_prim);
+        continue;
+      }
+
       // Resolve material index
       uint32_t mat_index = 0;
       if (primitive.material)
@@ -1317,11 +1341,15 @@ void traverse_nodes(
         }
       }
 
-      // Compute centroid (average of all vertex positions in object space)
+      // Compute centroid (average of all vertex positions in object space) and
+      // the object-space bounds used for GPU culling
       glm::vec3 centroid(0.0f);
+      AABB prim_bounds;
       for (size_t i = 0; i < num_verts; ++i)
       {
-        centroid += glm::vec3(positions[i * 3 + 0], positions[i * 3 + 1], positions[i * 3 + 2]);
+        glm::vec3 p(positions[i * 3 + 0], positions[i * 3 + 1], positions[i * 3 + 2]);
+        centroid += p;
+        prim_bounds.expand(p);
       }
       if (num_verts > 0)
       {
@@ -1335,6 +1363,9 @@ void traverse_nodes(
       scene_prim.materialIndex = mat_index;
       scene_prim.modelMatrix = model_matrix;
       scene_prim.centroid = centroid;
+      scene_prim.bounds = prim_bounds;
+      scene_prim.meshIndex = mesh_count++;
+      geometry_map[&primitive] = static_cast<uint32_t>(primitives.size());
       primitives.push_back(scene_prim);
     }
   }
@@ -1343,13 +1374,66 @@ void traverse_nodes(
   for (size_t i = 0; i < node->children_count; ++i)
   {
     traverse_nodes(node->children[i], data, device, base_path,
-      all_vertices, all_indices, primitives, materials, material_map, bounds);
+      all_vertices, all_indices, primitives, materials, material_map,
+      geometry_map, mesh_count, bounds);
   }
 }
 
-} // anonymous namespace
+/// @brief Recursively collect KHR_lights_punctual point/spot lights in world space.
+void collect_lights(const cgltf_node* node, GltfScene& scene)
+{
+  if (node->light)
+  {
+    const cgltf_light& light = *node->light;
+
+    float m[16];
+    cgltf_node_transform_world(node, m);
+    const glm::vec3 position(m[12], m[13], m[14]);
+    // Lights point down the node's local -Z axis
+    const glm::vec3 direction = -glm::vec3(m[8], m[9], m[10]);
+    const glm::vec3 color(light.color[0], light.color[1], light.color[2]);
+
+    // glTF uses inverse-square falloff; the constant term of 1 keeps the
+    // intensity finite at the light's position.
+    auto apply_common = [&](LocalLight& l) {
+      l.set_color(color);
+      l.set_intensity(light.intensity);
+      l.set_attenuation(1.0f, 0.0f, 1.0f);
+      if (light.range > 0.0f)
+        l.set_range(light.range);
+    };
+
+    switch (light.type)
+    {
+    case cgltf_light_type_point:
+    {
+      PointLight p(position);
+      apply_common(p);
+      scene.point_lights.push_back(p);
+      break;
+    }
+    case cgltf_light_type_spot:
+    {
+      SpotLight sp(position, direction);
+      apply_common(sp);
+      sp.set_cutoff_angles(glm::degrees(light.spot_inner_cone_angle),
+                           glm::degrees(light.spot_outer_cone_angle));
+      scene.spot_lights.push_back(sp);
+      break;
+    }
+    default:
+      spdlog::info("Ignoring directional glTF light '{}'", light.name ? light.name : "");
+      break;
+    }
+  }
 
-GltfScene load_gltf_scene(const Device& device, const std::string& filepath)
+  for (size_t i = 0; i < node->children_count; ++i)
+    collect_lights(node->children[i], scene);
+}
+
+// Everything but the GPU objects: the merged geometry in scene.vertices /
+// scene.indices, and material textures only with a `device`.
+GltfScene read_gltf_scene(const Device* device, const std::string& filepath)
 {
   GltfScene scene;
 
@@ -1380,9 +1464,11 @@ GltfScene load_gltf_scene(const Device& device, const std::string& filepath)
     return scene;
   }
 
-  std::vector<Vertex> all_vertices;
-  std::vector<uint32_t> all_indices;
+  auto& all_vertices = scene.vertices;
+  auto& all_indices = scene.indices;
   std::unordered_map<const cgltf_material*, uint32_t> material_map;
+  // First instance (index into scene.primitives) of each uploaded primitive.
+  std::unordered_map<const cgltf_primitive*, uint32_t> geometry_map;
 
   // Traverse all scene nodes
   for (size_t s = 0; s < data->scenes_count; ++s)
@@ -1392,34 +1478,62 @@ GltfScene load_gltf_scene(const Device& device, const std::string& filepath)
     {
       traverse_nodes(gltf_scene.nodes[n], data, device, base_path,
         all_vertices, all_indices, scene.primitives, scene.materials, material_map,
-        scene.bounds);
+        geometry_map, scene.mesh_count, scene.bounds);
+      collect_lights(gltf_scene.nodes[n], scene);
     }
   }
 
   cgltf_free(data);
 
-  if (all_vertices.empty())
+  // Adjacent instances of one geometry (and so one material) draw as a single
+  // instanced call; within a geometry the node order is kept.
+  std::stable_sort(scene.primitives.begin(), scene.primitives.end(),
+    [](const ScenePrimitive& a, const ScenePrimitive& b) { return a.meshIndex < b.meshIndex; });
+
+  spdlog::info("Loaded glTF scene '{}': {} vertices, {} indices ({} triangles), {} primitives ({} unique), {} materials",
+    file_path.stem().string(), all_vertices.size(), all_indices.size(), all_indices.size() / 3,
+    scene.primitives.size(), scene.mesh_count, scene.materials.size());
+  if (!scene.point_lights.empty() || !scene.spot_lights.empty())
+    spdlog::info("  {} point lights, {} spot lights (KHR_lights_punctual)",
+      scene.point_lights.size(), scene.spot_lights.size());
+
+  return scene;
+}
+
+} // anonymous namespace
+
+GltfScene load_gltf_scene(const Device& device, const std::string& filepath,
+  bool keep_geometry)
+{
+  GltfScene scene = read_gltf_scene(&device, filepath);
+  if (scene.vertices.empty())
   {
     spdlog::error("No vertices loaded from glTF scene: {}", filepath);
     return scene;
   }
 
-  std::string mesh_name = file_path.stem().string();
+  std::string mesh_name = std::filesystem::path(filepath).stem().string();
 
-  if (all_indices.empty())
+  if (scene.indices.empty())
   {
-    scene.mesh = std::make_unique<Mesh>(device, mesh_name, all_vertices);
+    scene.mesh = std::make_unique<Mesh>(device, mesh_name, scene.vertices);
   }
   else
   {
-    scene.mesh = std::make_unique<Mesh>(device, mesh_name, all_vertices, all_indices);
+    scene.mesh = std::make_unique<Mesh>(device, mesh_name, scene.vertices, scene.indices);
   }
 
-  spdlog::info("Loaded glTF scene '{}': {} vertices, {} indices ({} triangles), {} primitives, {} materials",
-    mesh_name, all_vertices.size(), all_indices.size(), all_indices.size() / 3,
-    scene.primitives.size(), scene.materials.size());
-
+  if (!keep_geometry)
+  {
+    scene.vertices = {};
+    scene.indices = {};
+  }
   return scene;
 }
 
+GltfScene load_gltf_scene_geometry(const std::string& filepath)
+{
+  return read_gltf_scene(nullptr, filepath);
+}
+
 } // namespace vkwave
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <vkwave/core/light.h>
 #include <vkwave/core/mesh.h>
 #include <vkwave/core/texture.h>
 
@@ -88,6 +89,8 @@ struct ScenePrimitive
   uint32_t materialIndex;
   glm::mat4 modelMatrix;  // pre-computed world transform from node hierarchy
   glm::vec3 centroid{0.0f};  // object-space centroid for depth sorting
+  AABB bounds;               // object-space bounds for GPU culling
+  uint32_t meshIndex{0};     // unique geometry; instances of one glTF primitive share it
 };
 
 /// KHR_texture_transform for one texture reference. Defaults are identity
@@ -184,18 +187,37 @@ struct GltfScene
 {
   std::unique_ptr<Mesh> mesh;              // merged vertex/index buffer
   std::vector<SceneMaterial> materials;    // one per glTF material
-  std::vector<ScenePrimitive> primitives;  // one per draw call
+  std::vector<ScenePrimitive> primitives;  // one per instance, grouped by meshIndex
+  uint32_t mesh_count{0};                  // unique geometries (meshIndex < mesh_count)
   AABB bounds;                             // world-space bounding box
+
+  // CPU copy of mesh's vertices and indices, only when loaded with
+  // keep_geometry (CPU consumers such as the reference PathTracer).
+  std::vector<Vertex> vertices;
+  std::vector<uint32_t> indices;
+
+  // KHR_lights_punctual point/spot lights, world space (directional ignored)
+  std::vector<PointLight> point_lights;
+  std::vector<SpotLight> spot_lights;
 };
 
 /// @brief Load a glTF 2.0 scene with per-primitive materials and transforms.
 ///
 /// Traverses node hierarchy, merges all geometry into a single mesh,
 /// and records per-primitive draw info (material index, model matrix).
+/// A glTF mesh referenced by several nodes is uploaded once: each node adds
+/// instances (its world transform) of the same index range and meshIndex, and
+/// the instances of one geometry are adjacent in `primitives`.
 ///
 /// @param device The Vulkan device wrapper.
 /// @param filepath Path to the glTF file.
+/// @param keep_geometry Also keep the merged vertices/indices on the CPU.
 /// @return GltfScene with mesh, materials, and primitives.
-GltfScene load_gltf_scene(const Device& device, const std::string& filepath);
+GltfScene load_gltf_scene(const Device& device, const std::string& filepath,
+  bool keep_geometry = false);
+
+/// @brief load_gltf_scene() without a GPU: no mesh and no material textures,
+/// the merged geometry always kept in `vertices` / `indices` (tools, tests).
+GltfScene load_gltf_scene_geometry(const std::string& filepath);
 
 } // namespace vkwave
@@ -1,6 +1,7 @@
 #include <vkwave/loaders/ibl.h>
 #include <vkwave/core/buffer.h>
 #include <vkwave/config.h>
+#include <vkwave/core/deletion_queue.h>
 #include <vkwave/core/device.h>
 #include <vkwave/pipeline/shader_compiler.h>
 #include <vkwave/pipeline/shaders.h>
@@ -8,6 +9,7 @@
 #include <spdlog/spdlog.h>
 #include <stb_image.h>
 
+#include <array>
 #include <cassert>
 #include <cmath>
 #include <stdexcept>
@@ -220,8 +222,8 @@ IBL::IBL(const Device& device, const std::string& hdr_path, const IBLSettings& s
   run_compute_generation();
 
   // Cleanup CPU data and HDR GPU texture
-  m_hdr_data.clear();
-  m_hdr_data.shrink_to_fit();
+  m_hdr.rgba.clear();
+  m_hdr.rgba.shrink_to_fit();
 
   auto dev = m_device.device();
   if (m_hdr_sampler)
@@ -240,52 +242,41 @@ IBL::IBL(const Device& device, const std::string& hdr_path, const IBLSettings& s
 
 IBL::~IBL()
 {
-  auto dev = m_device.device();
-
-  // BRDF LUT cleanup
-  if (m_brdf_lut_sampler)
-    dev.destroySampler(m_brdf_lut_sampler);
-  if (m_brdf_lut_view)
-    dev.destroyImageView(m_brdf_lut_view);
-  if (m_brdf_lut_image)
-    dev.destroyImage(m_brdf_lut_image);
-  if (m_brdf_lut_memory)
-    dev.freeMemory(m_brdf_lut_memory);
-
-  // Irradiance cleanup
-  if (m_irradiance_sampler)
-    dev.destroySampler(m_irradiance_sampler);
-  if (m_irradiance_view)
-    dev.destroyImageView(m_irradiance_view);
-  if (m_irradiance_image)
-    dev.destroyImage(m_irradiance_image);
-  if (m_irradiance_memory)
-    dev.freeMemory(m_irradiance_memory);
-
-  // Pre-filtered cleanup
-  if (m_prefiltered_sampler)
-    dev.destroySampler(m_prefiltered_sampler);
-  if (m_prefiltered_view)
-    dev.destroyImageView(m_prefiltered_view);
-  if (m_prefiltered_image)
-    dev.destroyImage(m_prefiltered_image);
-  if (m_prefiltered_memory)
-    dev.freeMemory(m_prefiltered_memory);
-
-  // HDR source cleanup (may already be freed)
-  if (m_hdr_sampler)
-    dev.destroySampler(m_hdr_sampler);
-  if (m_hdr_view)
-    dev.destroyImageView(m_hdr_view);
-  if (m_hdr_image)
-    dev.destroyImage(m_hdr_image);
-  if (m_hdr_memory)
-    dev.freeMemory(m_hdr_memory);
+  struct Handles
+  {
+    vk::Sampler sampler;
+    vk::ImageView view;
+    vk::Image image;
+    vk::DeviceMemory memory;
+  };
+  // BRDF LUT, irradiance, pre-filtered, HDR source (may already be freed)
+  std::array<Handles, 4> maps{ {
+    { m_brdf_lut_sampler, m_brdf_lut_view, m_brdf_lut_image, m_brdf_lut_memory },
+    { m_irradiance_sampler, m_irradiance_view, m_irradiance_image, m_irradiance_memory },
+    { m_prefiltered_sampler, m_prefiltered_view, m_prefiltered_image, m_prefiltered_memory },
+    { m_hdr_sampler, m_hdr_view, m_hdr_image, m_hdr_memory },
+  } };
+
+  // Frames in flight may still sample the maps (an IBL switch no longer
+  // drains): destroy once they finish.
+  m_device.deletion_queue().push([dev = m_device.device(), maps] {
+    for (const auto& h : maps)
+    {
+      if (h.sampler)
+        dev.destroySampler(h.sampler);
+      if (h.view)
+        dev.destroyImageView(h.view);
+      if (h.image)
+        dev.destroyImage(h.image);
+      if (h.memory)
+        dev.freeMemory(h.memory);
+    }
+  });
 
   spdlog::trace("IBL resources destroyed");
 }
 
-void IBL::load_hdr_environment(const std::string& hdr_path)
+EquirectImage load_equirect_hdr(const std::string& hdr_path)
 {
   int width, height, channels;
   float* hdr_data = stbi_loadf(hdr_path.c_str(), &width, &height, &channels, 4);
@@ -297,12 +288,19 @@ void IBL::load_hdr_environment(const std::string& hdr_path)
 
   spdlog::info("Loaded HDR: {}x{} (channels: {})", width, height, channels);
 
-  m_hdr_width = static_cast<uint32_t>(width);
-  m_hdr_height = static_cast<uint32_t>(height);
-  m_hdr_data.resize(width * height * 4);
-  std::memcpy(m_hdr_data.data(), hdr_data, width * height * 4 * sizeof(float));
+  EquirectImage image;
+  image.width = static_cast<uint32_t>(width);
+  image.height = static_cast<uint32_t>(height);
+  image.rgba.resize(width * height * 4);
+  std::memcpy(image.rgba.data(), hdr_data, width * height * 4 * sizeof(float));
 
   stbi_image_free(hdr_data);
+  return image;
+}
+
+void IBL::load_hdr_environment(const std::string& hdr_path)
+{
+  m_hdr = load_equirect_hdr(hdr_path);
 }
 
 void IBL::upload_hdr_to_gpu()
@@ -311,15 +309,15 @@ void IBL::upload_hdr_to_gpu()
 
   // Create HDR GPU texture (R32G32B32A32Sfloat, sampled)
   create_image(m_device, m_hdr_image, m_hdr_memory,
-    m_hdr_width, m_hdr_height, 1, 1,
+    m_hdr.width, m_hdr.height, 1, 1,
     vk::Format::eR32G32B32A32Sfloat,
     vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eTransferDst);
 
   // Upload via staging buffer
-  vk::DeviceSize data_size = m_hdr_width * m_hdr_height * 4 * sizeof(float);
+  vk::DeviceSize data_size = m_hdr.width * m_hdr.height * 4 * sizeof(float);
   Buffer staging(m_device, "HDR staging", data_size, vk::BufferUsageFlagBits::eTransferSrc,
     vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent);
-  staging.update(m_hdr_data.data(), data_size);
+  staging.update(m_hdr.rgba.data(), data_size);
 
   vk::CommandPoolCreateInfo pool_info{};
   pool_info.queueFamilyIndex = m_device.m_graphics_queue_family_index;
@@ -338,7 +336,7 @@ void IBL::upload_hdr_to_gpu()
   region.imageSubresource.mipLevel = 0;
   region.imageSubresource.baseArrayLayer = 0;
   region.imageSubresource.layerCount = 1;
-  region.imageExtent = vk::Extent3D{ m_hdr_width, m_hdr_height, 1 };
+  region.imageExtent = vk::Extent3D{ m_hdr.width, m_hdr.height, 1 };
 
   cmd.copyBufferToImage(staging.buffer(), m_hdr_image,
     vk::ImageLayout::eTransferDstOptimal, region);
@@ -376,7 +374,7 @@ void IBL::upload_hdr_to_gpu()
 
   m_hdr_sampler = dev.createSampler(sampler_info);
 
-  spdlog::info("Uploaded HDR to GPU ({}x{})", m_hdr_width, m_hdr_height);
+  spdlog::info("Uploaded HDR to GPU ({}x{})", m_hdr.width, m_hdr.height);
 }
 
 void IBL::create_ibl_images()
@@ -2,6 +2,7 @@
 
 #include <vulkan/vulkan.hpp>
 #include <string>
+#include <vector>
 
 namespace vkwave
 {
@@ -18,6 +19,20 @@ struct IBLSettings
   uint32_t brdf_samples{ 1024 };
 };
 
+/// @brief Equirectangular HDR environment, RGBA32F, top row first (v = 0 is
+/// the +Y pole; see equirect_to_cubemap.comp's dirToUV). What IBL bakes from,
+/// and what CPU consumers (PathTracer) sample directly.
+struct EquirectImage
+{
+  uint32_t width{ 0 };
+  uint32_t height{ 0 };
+  std::vector<float> rgba;
+};
+
+/// @brief Load an equirectangular HDR (.hdr via stb_image, expanded to 4 channels).
+/// @throws std::runtime_error if the file cannot be read.
+EquirectImage load_equirect_hdr(const std::string& hdr_path);
+
 /// @brief Image-Based Lighting (IBL) resources
 /// Contains pre-computed environment maps for PBR rendering:
 /// - BRDF LUT: 2D lookup table for split-sum approximation
@@ -93,9 +108,7 @@ private:
   vk::Sampler m_hdr_sampler{ VK_NULL_HANDLE };
 
   // CPU-side HDR data for upload
-  std::vector<float> m_hdr_data;
-  uint32_t m_hdr_width{ 0 };
-  uint32_t m_hdr_height{ 0 };
+  EquirectImage m_hdr;
 };
 
 } // namespace vkwave
@@ -1,11 +1,17 @@
 #include <vkwave/pipeline/acceleration_structure.h>
+#include <vkwave/core/commands.h>
+#include <vkwave/core/deletion_queue.h>
 #include <vkwave/core/device.h>
 #include <vkwave/core/mesh.h>
 #include <vkwave/core/vertex.h>
+#include <vkwave/loaders/gltf_loader.h>
 
 #include <spdlog/spdlog.h>
 
+#include <algorithm>
+#include <cassert>
 #include <cstring>
+#include <stdexcept>
 
 namespace vkwave
 {
@@ -17,6 +23,124 @@ vk::DeviceAddress get_buffer_device_address(vk::Device device, vk::Buffer buffer
   return device.getBufferAddress(info);
 }
 
+BlasGeometry blas_geometry(const Mesh& mesh, const std::string& name)
+{
+  BlasGeometry g{};
+  g.name = name;
+  g.vertex_buffer = mesh.vertex_buffer();
+  g.vertex_count = mesh.vertex_count();
+  g.index_buffer = mesh.index_buffer();
+  g.index_count = mesh.is_indexed() ? mesh.index_count() : mesh.vertex_count();
+  return g;
+}
+
+BlasGeometry blas_geometry(const Mesh& mesh, const ScenePrimitive& primitive,
+  const std::string& name)
+{
+  BlasGeometry g = blas_geometry(mesh, name);
+  g.first_index = primitive.firstIndex;
+  g.index_count = primitive.indexCount;
+  g.vertex_offset = primitive.vertexOffset;
+  return g;
+}
+
+std::vector<vk::DeviceSize> pack_scratch(
+  std::span<const vk::DeviceSize> sizes, vk::DeviceSize alignment)
+{
+  const vk::DeviceSize mask = std::max<vk::DeviceSize>(alignment, 1) - 1;
+  std::vector<vk::DeviceSize> offsets;
+  offsets.reserve(sizes.size() + 1);
+  vk::DeviceSize offset = 0;
+  for (const vk::DeviceSize size : sizes)
+  {
+    offsets.push_back(offset);
+    offset = (offset + size + mask) & ~mask;
+  }
+  offsets.push_back(offset);
+  return offsets;
+}
+
+namespace
+{
+
+/// A buffer with its own memory, usable through its address.
+struct AddressedBuffer
+{
+  vk::Buffer buffer{ VK_NULL_HANDLE };
+  vk::DeviceMemory memory{ VK_NULL_HANDLE };
+  vk::DeviceAddress address{ 0 };
+};
+
+AddressedBuffer create_addressed_buffer(const Device& device, vk::DeviceSize size,
+  vk::BufferUsageFlags usage,
+  vk::MemoryPropertyFlags properties = vk::MemoryPropertyFlagBits::eDeviceLocal)
+{
+  auto dev = device.device();
+  AddressedBuffer b;
+
+  vk::BufferCreateInfo bufferInfo{};
+  bufferInfo.size = size;
+  bufferInfo.usage = usage | vk::BufferUsageFlagBits::eShaderDeviceAddress;
+  bufferInfo.sharingMode = vk::SharingMode::eExclusive;
+  b.buffer = dev.createBuffer(bufferInfo);
+
+  vk::MemoryRequirements memReqs = dev.getBufferMemoryRequirements(b.buffer);
+
+  vk::MemoryAllocateFlagsInfo allocFlagsInfo{};
+  allocFlagsInfo.flags = vk::MemoryAllocateFlagBits::eDeviceAddress;
+
+  vk::MemoryAllocateInfo allocInfo{};
+  allocInfo.pNext = &allocFlagsInfo;
+  allocInfo.allocationSize = memReqs.size;
+  allocInfo.memoryTypeIndex = device.find_memory_type(memReqs.memoryTypeBits, properties);
+  b.memory = dev.allocateMemory(allocInfo);
+  dev.bindBufferMemory(b.buffer, b.memory, 0);
+
+  b.address = get_buffer_device_address(dev, b.buffer);
+  return b;
+}
+
+void destroy_addressed_buffer(vk::Device dev, AddressedBuffer& b)
+{
+  dev.destroyBuffer(b.buffer);
+  dev.freeMemory(b.memory);
+  b = {};
+}
+
+vk::AccelerationStructureInstanceKHR to_vk_instance(const AccelerationStructure& blas,
+  const glm::mat4& transform, uint32_t custom_index, uint8_t mask, uint32_t sbt_offset)
+{
+  vk::AccelerationStructureInstanceKHR instance{};
+
+  // Copy transform (row-major 3x4)
+  auto& t = instance.transform.matrix;
+  t[0][0] = transform[0][0]; t[0][1] = transform[1][0]; t[0][2] = transform[2][0]; t[0][3] = transform[3][0];
+  t[1][0] = transform[0][1]; t[1][1] = transform[1][1]; t[1][2] = transform[2][1]; t[1][3] = transform[3][1];
+  t[2][0] = transform[0][2]; t[2][1] = transform[1][2]; t[2][2] = transform[2][2]; t[2][3] = transform[3][2];
+
+  instance.instanceCustomIndex = custom_index;
+  instance.mask = mask;
+  instance.instanceShaderBindingTableRecordOffset = sbt_offset;
+  instance.flags = VK_GEOMETRY_INSTANCE_TRIANGLE_FACING_CULL_DISABLE_BIT_KHR;
+  instance.accelerationStructureReference = blas.device_address();
+  return instance;
+}
+
+/// The instances geometry of a TLAS whose instance array starts at `address`.
+vk::AccelerationStructureGeometryKHR instances_geometry(vk::DeviceAddress address)
+{
+  vk::AccelerationStructureGeometryInstancesDataKHR instancesData{};
+  instancesData.arrayOfPointers = VK_FALSE;
+  instancesData.data.deviceAddress = address;
+
+  vk::AccelerationStructureGeometryKHR geometry{};
+  geometry.geometryType = vk::GeometryTypeKHR::eInstances;
+  geometry.geometry.instances = instancesData;
+  return geometry;
+}
+
+} // namespace
+
 AccelerationStructure::AccelerationStructure(const Device& device, const std::string& name)
   : m_device(&device)
   , m_name(name)
@@ -79,6 +203,7 @@ AccelerationStructure::AccelerationStructure(AccelerationStructure&& other) noex
   , m_buffer(other.m_buffer)
   , m_memory(other.m_memory)
   , m_device_address(other.m_device_address)
+  , m_size(other.m_size)
   , m_scratch_buffer(other.m_scratch_buffer)
   , m_scratch_memory(other.m_scratch_memory)
   , m_instance_buffer(other.m_instance_buffer)
@@ -89,6 +214,7 @@ AccelerationStructure::AccelerationStructure(AccelerationStructure&& other) noex
   other.m_buffer = VK_NULL_HANDLE;
   other.m_memory = VK_NULL_HANDLE;
   other.m_device_address = 0;
+  other.m_size = 0;
   other.m_scratch_buffer = VK_NULL_HANDLE;
   other.m_scratch_memory = VK_NULL_HANDLE;
   other.m_instance_buffer = VK_NULL_HANDLE;
@@ -107,6 +233,7 @@ AccelerationStructure& AccelerationStructure::operator=(AccelerationStructure&&
     m_buffer = other.m_buffer;
     m_memory = other.m_memory;
     m_device_address = other.m_device_address;
+    m_size = other.m_size;
     m_scratch_buffer = other.m_scratch_buffer;
     m_scratch_memory = other.m_scratch_memory;
     m_instance_buffer = other.m_instance_buffer;
@@ -117,6 +244,7 @@ AccelerationStructure& AccelerationStructure::operator=(AccelerationStructure&&
     other.m_buffer = VK_NULL_HANDLE;
     other.m_memory = VK_NULL_HANDLE;
     other.m_device_address = 0;
+    other.m_size = 0;
     other.m_scratch_buffer = VK_NULL_HANDLE;
     other.m_scratch_memory = VK_NULL_HANDLE;
     other.m_instance_buffer = VK_NULL_HANDLE;
@@ -151,6 +279,26 @@ void AccelerationStructure::create_buffer(vk::DeviceSize size, vk::BufferUsageFl
   dev.bindBufferMemory(m_buffer, m_memory, 0);
 }
 
+void AccelerationStructure::create(vk::DeviceSize size, vk::AccelerationStructureTypeKHR type)
+{
+  auto dev = m_device->device();
+
+  create_buffer(size,
+    vk::BufferUsageFlagBits::eAccelerationStructureStorageKHR |
+    vk::BufferUsageFlagBits::eShaderDeviceAddress);
+  m_size = size;
+
+  vk::AccelerationStructureCreateInfoKHR createInfo{};
+  createInfo.buffer = m_buffer;
+  createInfo.size = size;
+  createInfo.type = type;
+  m_handle = dev.createAccelerationStructureKHR(createInfo);
+
+  vk::AccelerationStructureDeviceAddressInfoKHR addressInfo{};
+  addressInfo.accelerationStructure = m_handle;
+  m_device_address = dev.getAccelerationStructureAddressKHR(addressInfo);
+}
+
 void AccelerationStructure::build_blas(vk::CommandBuffer cmd, const Mesh& mesh)
 {
   auto dev = m_device->device();
@@ -196,23 +344,8 @@ void AccelerationStructure::build_blas(vk::CommandBuffer cmd, const Mesh& mesh)
     dev.getAccelerationStructureBuildSizesKHR(
       vk::AccelerationStructureBuildTypeKHR::eDevice, buildInfo, primitiveCount);
 
-  // Create acceleration structure buffer
-  create_buffer(sizeInfo.accelerationStructureSize,
-    vk::BufferUsageFlagBits::eAccelerationStructureStorageKHR |
-    vk::BufferUsageFlagBits::eShaderDeviceAddress);
-
-  // Create acceleration structure
-  vk::AccelerationStructureCreateInfoKHR createInfo{};
-  createInfo.buffer = m_buffer;
-  createInfo.size = sizeInfo.accelerationStructureSize;
-  createInfo.type = vk::AccelerationStructureTypeKHR::eBottomLevel;
-
-  m_handle = dev.createAccelerationStructureKHR(createInfo);
-
-  // Get device address
-  vk::AccelerationStructureDeviceAddressInfoKHR addressInfo{};
-  addressInfo.accelerationStructure = m_handle;
-  m_device_address = dev.getAccelerationStructureAddressKHR(addressInfo);
+  // Create acceleration structure (buffer + handle + address)
+  create(sizeInfo.accelerationStructureSize, vk::AccelerationStructureTypeKHR::eBottomLevel);
 
   // Create scratch buffer
   vk::BufferCreateInfo scratchBufferInfo{};
@@ -265,6 +398,152 @@ void AccelerationStructure::build_blas(vk::CommandBuffer cmd, const Mesh& mesh)
   spdlog::trace("Built BLAS '{}': {} triangles", m_name, primitiveCount);
 }
 
+std::vector<AccelerationStructure> AccelerationStructure::build_blases(
+  const Device& device, std::span<const BlasGeometry> geometries)
+{
+  std::vector<AccelerationStructure> result;
+  if (geometries.empty())
+    return result;
+
+  auto dev = device.device();
+  const auto count = static_cast<uint32_t>(geometries.size());
+
+  // Geometry + build info per BLAS. The vectors are sized up front: the build
+  // infos point into them.
+  std::vector<vk::AccelerationStructureGeometryKHR> geoms(count);
+  std::vector<vk::AccelerationStructureBuildGeometryInfoKHR> builds(count);
+  std::vector<vk::AccelerationStructureBuildRangeInfoKHR> ranges(count);
+  std::vector<vk::DeviceSize> scratch_sizes(count);
+  std::vector<AccelerationStructure> built;
+  built.reserve(count);
+  for (uint32_t i = 0; i < count; ++i)
+  {
+    const auto& g = geometries[i];
+
+    vk::AccelerationStructureGeometryTrianglesDataKHR triangles{};
+    triangles.vertexFormat = vk::Format::eR32G32B32Sfloat;
+    triangles.vertexData.deviceAddress = get_buffer_device_address(dev, g.vertex_buffer);
+    triangles.vertexStride = sizeof(Vertex);
+    triangles.maxVertex = g.vertex_count - 1;
+    if (g.index_buffer)
+    {
+      triangles.indexType = vk::IndexType::eUint32;
+      triangles.indexData.deviceAddress = get_buffer_device_address(dev, g.index_buffer);
+      ranges[i].primitiveOffset = g.first_index * static_cast<uint32_t>(sizeof(uint32_t));
+      ranges[i].firstVertex = static_cast<uint32_t>(g.vertex_offset);
+    }
+    else
+    {
+      triangles.indexType = vk::IndexType::eNoneKHR;
+      ranges[i].firstVertex = g.first_index;
+    }
+    ranges[i].primitiveCount = g.index_count / 3;
+
+    geoms[i].geometryType = vk::GeometryTypeKHR::eTriangles;
+    geoms[i].geometry.triangles = triangles;
+    geoms[i].flags = g.opaque ? vk::GeometryFlagBitsKHR::eOpaque : vk::GeometryFlagsKHR{};
+
+    builds[i].type = vk::AccelerationStructureTypeKHR::eBottomLevel;
+    builds[i].flags = vk::BuildAccelerationStructureFlagBitsKHR::ePreferFastTrace |
+      vk::BuildAccelerationStructureFlagBitsKHR::eAllowCompaction;
+    builds[i].mode = vk::BuildAccelerationStructureModeKHR::eBuild;
+    builds[i].geometryCount = 1;
+    builds[i].pGeometries = &geoms[i];
+
+    const auto sizeInfo = dev.getAccelerationStructureBuildSizesKHR(
+      vk::AccelerationStructureBuildTypeKHR::eDevice, builds[i], ranges[i].primitiveCount);
+    scratch_sizes[i] = sizeInfo.buildScratchSize;
+
+    built.emplace_back(device, g.name);
+    built.back().create(sizeInfo.accelerationStructureSize,
+      vk::AccelerationStructureTypeKHR::eBottomLevel);
+    builds[i].dstAccelerationStructure = built.back().handle();
+  }
+
+  // One scratch arena for every build: they run concurrently, so each gets its
+  // own aligned range. The base address is aligned by hand (the buffer's own
+  // alignment may be smaller).
+  const vk::DeviceSize alignment = std::max<vk::DeviceSize>(
+    device.ray_tracing_capabilities().minAccelerationStructureScratchOffsetAlignment, 1);
+  const auto offsets = pack_scratch(scratch_sizes, alignment);
+  AddressedBuffer scratch = create_addressed_buffer(device, offsets.back() + alignment,
+    vk::BufferUsageFlagBits::eStorageBuffer);
+  const vk::DeviceAddress base = (scratch.address + alignment - 1) & ~(alignment - 1);
+  for (uint32_t i = 0; i < count; ++i)
+    builds[i].scratchData.deviceAddress = base + offsets[i];
+
+  vk::QueryPoolCreateInfo queryInfo{};
+  queryInfo.queryType = vk::QueryType::eAccelerationStructureCompactedSizeKHR;
+  queryInfo.queryCount = count;
+  vk::QueryPool queries = dev.createQueryPool(queryInfo);
+
+  std::vector<const vk::AccelerationStructureBuildRangeInfoKHR*> range_ptrs(count);
+  std::vector<vk::AccelerationStructureKHR> handles(count);
+  for (uint32_t i = 0; i < count; ++i)
+  {
+    range_ptrs[i] = &ranges[i];
+    handles[i] = built[i].handle();
+  }
+
+  submit_one_shot(device, [&](vk::CommandBuffer cmd) {
+    cmd.resetQueryPool(queries, 0, count);
+    cmd.buildAccelerationStructuresKHR(count, builds.data(), range_ptrs.data());
+
+    // The size queries read the finished structures.
+    vk::MemoryBarrier barrier{};
+    barrier.srcAccessMask = vk::AccessFlagBits::eAccelerationStructureWriteKHR;
+    barrier.dstAccessMask = vk::AccessFlagBits::eAccelerationStructureReadKHR;
+    cmd.pipelineBarrier(
+      vk::PipelineStageFlagBits::eAccelerationStructureBuildKHR,
+      vk::PipelineStageFlagBits::eAccelerationStructureBuildKHR,
+      {}, barrier, {}, {});
+    cmd.writeAccelerationStructuresPropertiesKHR(handles,
+      vk::QueryType::eAccelerationStructureCompactedSizeKHR, queries, 0);
+  });
+
+  // The builds are done (submit_one_shot waits): the arena can go now.
+  destroy_addressed_buffer(dev, scratch);
+
+  std::vector<vk::DeviceSize> compact_sizes(count);
+  const auto query_result = dev.getQueryPoolResults(queries, 0, count,
+    compact_sizes.size() * sizeof(vk::DeviceSize), compact_sizes.data(),
+    sizeof(vk::DeviceSize), vk::QueryResultFlagBits::e64 | vk::QueryResultFlagBits::eWait);
+  dev.destroyQueryPool(queries);
+  if (query_result != vk::Result::eSuccess)
+    throw std::runtime_error("AccelerationStructure::build_blases: compacted-size query failed");
+
+  // Compacting copies into exactly-sized structures; the originals are freed
+  // when `built` goes out of scope (after the blocking submit).
+  result.reserve(count);
+  for (uint32_t i = 0; i < count; ++i)
+  {
+    result.emplace_back(device, geometries[i].name);
+    result.back().create(compact_sizes[i], vk::AccelerationStructureTypeKHR::eBottomLevel);
+  }
+  submit_one_shot(device, [&](vk::CommandBuffer cmd) {
+    for (uint32_t i = 0; i < count; ++i)
+    {
+      vk::CopyAccelerationStructureInfoKHR copy{};
+      copy.src = built[i].handle();
+      copy.dst = result[i].handle();
+      copy.mode = vk::CopyAccelerationStructureModeKHR::eCompact;
+      cmd.copyAccelerationStructureKHR(copy);
+    }
+  });
+
+  vk::DeviceSize before = 0;
+  vk::DeviceSize after = 0;
+  for (uint32_t i = 0; i < count; ++i)
+  {
+    before += built[i].size();
+    after += result[i].size();
+  }
+  spdlog::info("Built {} BLAS: {:.1f} MiB compacted to {:.1f} MiB (scratch arena {:.1f} MiB)",
+    count, before / (1024.0 * 1024.0), after / (1024.0 * 1024.0),
+    offsets.back() / (1024.0 * 1024.0));
+  return result;
+}
+
 void AccelerationStructure::build_tlas(vk::CommandBuffer cmd,
   const std::vector<std::pair<const AccelerationStructure*, glm::mat4>>& instances)
 {
@@ -277,22 +556,7 @@ void AccelerationStructure::build_tlas(vk::CommandBuffer cmd,
   for (size_t i = 0; i < instances.size(); ++i)
   {
     const auto& [blas, transform] = instances[i];
-
-    vk::AccelerationStructureInstanceKHR instance{};
-
-    // Copy transform (row-major 3x4)
-    auto& t = instance.transform.matrix;
-    t[0][0] = transform[0][0]; t[0][1] = transform[1][0]; t[0][2] = transform[2][0]; t[0][3] = transform[3][0];
-    t[1][0] = transform[0][1]; t[1][1] = transform[1][1]; t[1][2] = transform[2][1]; t[1][3] = transform[3][1];
-    t[2][0] = transform[0][2]; t[2][1] = transform[1][2]; t[2][2] = transform[2][2]; t[2][3] = transform[3][2];
-
-    instance.instanceCustomIndex = static_cast<uint32_t>(i);
-    instance.mask = 0xFF;
-    instance.instanceShaderBindingTableRecordOffset = 0;
-    instance.flags = VK_GEOMETRY_INSTANCE_TRIANGLE_FACING_CULL_DISABLE_BIT_KHR;
-    instance.accelerationStructureReference = blas->device_address();
-
-    asInstances.push_back(instance);
+    asInstances.push_back(to_vk_instance(*blas, transform, static_cast<uint32_t>(i), 0xFF, 0));
   }
 
   // Create instance buffer
@@ -340,13 +604,7 @@ void AccelerationStructure::build_tlas(vk::CommandBuffer cmd,
   vk::DeviceAddress instanceAddress = get_buffer_device_address(dev, m_instance_buffer);
 
   // Geometry description
-  vk::AccelerationStructureGeometryInstancesDataKHR instancesData{};
-  instancesData.arrayOfPointers = VK_FALSE;
-  instancesData.data.deviceAddress = instanceAddress;
-
-  vk::AccelerationStructureGeometryKHR geometry{};
-  geometry.geometryType = vk::GeometryTypeKHR::eInstances;
-  geometry.geometry.instances = instancesData;
+  vk::AccelerationStructureGeometryKHR geometry = instances_geometry(instanceAddress);
 
   // Build info
   vk::AccelerationStructureBuildGeometryInfoKHR buildInfo{};
@@ -362,23 +620,8 @@ void AccelerationStructure::build_tlas(vk::CommandBuffer cmd,
     dev.getAccelerationStructureBuildSizesKHR(
       vk::AccelerationStructureBuildTypeKHR::eDevice, buildInfo, instanceCount);
 
-  // Create acceleration structure buffer
-  create_buffer(sizeInfo.accelerationStructureSize,
-    vk::BufferUsageFlagBits::eAccelerationStructureStorageKHR |
-    vk::BufferUsageFlagBits::eShaderDeviceAddress);
-
-  // Create acceleration structure
-  vk::AccelerationStructureCreateInfoKHR createInfo{};
-  createInfo.buffer = m_buffer;
-  createInfo.size = sizeInfo.accelerationStructureSize;
-  createInfo.type = vk::AccelerationStructureTypeKHR::eTopLevel;
-
-  m_handle = dev.createAccelerationStructureKHR(createInfo);
-
-  // Get device address
-  vk::AccelerationStructureDeviceAddressInfoKHR addressInfo{};
-  addressInfo.accelerationStructure = m_handle;
-  m_device_address = dev.getAccelerationStructureAddressKHR(addressInfo);
+  // Create acceleration structure (buffer + handle + address)
+  create(sizeInfo.accelerationStructureSize, vk::AccelerationStructureTypeKHR::eTopLevel);
 
   // Create scratch buffer
   vk::BufferCreateInfo scratchBufferInfo{};
@@ -421,4 +664,229 @@ void AccelerationStructure::build_tlas(vk::CommandBuffer cmd,
   spdlog::trace("Built TLAS '{}': {} instances", m_name, instanceCount);
 }
 
+// --- PersistentTlas ---
+
+TlasBuild choose_tlas_build(bool instances_changed, bool transforms_changed,
+  uint32_t refits, uint32_t max_refits)
+{
+  if (instances_changed)
+    return TlasBuild::rebuild;
+  if (!transforms_changed)
+    return TlasBuild::none;
+  return refits >= max_refits ? TlasBuild::rebuild : TlasBuild::refit;
+}
+
+uint32_t TlasBuildState::reserve(uint32_t count)
+{
+  if (count <= m_capacity)
+    return 0;
+  m_capacity = std::max(count, 2 * m_capacity);
+  ++m_generation;
+  m_instances_dirty = true; // the new structure holds nothing yet
+  return m_capacity;
+}
+
+void TlasBuildState::set_instances(uint32_t count)
+{
+  assert(count <= m_capacity && "reserve() the instances first");
+  m_count = count;
+  m_instances_dirty = true;
+}
+
+void TlasBuildState::set_transform(uint32_t index)
+{
+  if (index >= m_count)
+    throw std::out_of_range(fmt::format(
+      "PersistentTlas::set_transform: instance {} of {}", index, m_count));
+  m_transforms_dirty = true;
+}
+
+TlasBuild TlasBuildState::next() const
+{
+  return choose_tlas_build(m_instances_dirty, m_transforms_dirty, m_refits, m_max_refits);
+}
+
+void TlasBuildState::built(TlasBuild build)
+{
+  if (build == TlasBuild::none)
+    return;
+  m_refits = build == TlasBuild::rebuild ? 0 : m_refits + 1;
+  m_instances_dirty = false;
+  m_transforms_dirty = false;
+}
+
+PersistentTlas::PersistentTlas(const Device& device, std::string name, uint32_t slot_count,
+  uint32_t max_refits)
+  : m_device(device)
+  , m_name(std::move(name))
+  , m_slot_count(std::max(slot_count, 1u))
+  , m_state(max_refits)
+{
+  allocate(m_state.reserve(1));
+}
+
+PersistentTlas::~PersistentTlas()
+{
+  release();
+}
+
+void PersistentTlas::release()
+{
+  // Deferred: earlier submissions may still build from or trace against them.
+  if (m_instance_mapped)
+    m_device.device().unmapMemory(m_instance_memory);
+  std::shared_ptr<AccelerationStructure> tlas(std::move(m_tlas));
+  m_device.deletion_queue().push([dev = m_device.device(), tlas,
+                                   scratch = m_scratch_buffer, scratch_memory = m_scratch_memory,
+                                   instances = m_instance_buffer,
+                                   instance_memory = m_instance_memory]() mutable {
+    tlas.reset();
+    dev.destroyBuffer(scratch);
+    dev.freeMemory(scratch_memory);
+    dev.destroyBuffer(instances);
+    dev.freeMemory(instance_memory);
+  });
+  m_scratch_buffer = VK_NULL_HANDLE;
+  m_scratch_memory = VK_NULL_HANDLE;
+  m_instance_buffer = VK_NULL_HANDLE;
+  m_instance_memory = VK_NULL_HANDLE;
+  m_instance_mapped = nullptr;
+  m_capacity = 0;
+}
+
+void PersistentTlas::allocate(uint32_t capacity)
+{
+  if (m_capacity > 0)
+    release();
+
+  auto dev = m_device.device();
+
+  // Size for the capacity; a build or refit of fewer instances fits in it.
+  vk::AccelerationStructureGeometryKHR geometry = instances_geometry(0);
+  vk::AccelerationStructureBuildGeometryInfoKHR buildInfo{};
+  buildInfo.type = vk::AccelerationStructureTypeKHR::eTopLevel;
+  buildInfo.flags = vk::BuildAccelerationStructureFlagBitsKHR::ePreferFastTrace |
+    vk::BuildAccelerationStructureFlagBitsKHR::eAllowUpdate;
+  buildInfo.mode = vk::BuildAccelerationStructureModeKHR::eBuild;
+  buildInfo.geometryCount = 1;
+  buildInfo.pGeometries = &geometry;
+  const auto sizeInfo = dev.getAccelerationStructureBuildSizesKHR(
+    vk::AccelerationStructureBuildTypeKHR::eDevice, buildInfo, capacity);
+
+  m_tlas = std::make_unique<AccelerationStructure>(m_device, m_name);
+  m_tlas->create(sizeInfo.accelerationStructureSize, vk::AccelerationStructureTypeKHR::eTopLevel);
+
+  // One scratch for both modes, its address aligned by hand.
+  const vk::DeviceSize alignment = std::max<vk::DeviceSize>(
+    m_device.ray_tracing_capabilities().minAccelerationStructureScratchOffsetAlignment, 1);
+  AddressedBuffer scratch = create_addressed_buffer(m_device,
+    std::max(sizeInfo.buildScratchSize, sizeInfo.updateScratchSize) + alignment,
+    vk::BufferUsageFlagBits::eStorageBuffer);
+  m_scratch_buffer = scratch.buffer;
+  m_scratch_memory = scratch.memory;
+  m_scratch_address = (scratch.address + alignment - 1) & ~(alignment - 1);
+
+  AddressedBuffer instances = create_addressed_buffer(m_device,
+    sizeof(vk::AccelerationStructureInstanceKHR) * capacity * m_slot_count,
+    vk::BufferUsageFlagBits::eAccelerationStructureBuildInputReadOnlyKHR,
+    vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent);
+  m_instance_buffer = instances.buffer;
+  m_instance_memory = instances.memory;
+  m_instance_address = instances.address;
+  m_instance_mapped = dev.mapMemory(m_instance_memory, 0, VK_WHOLE_SIZE);
+
+  m_capacity = capacity;
+  spdlog::trace("TLAS '{}': capacity {} instances ({} bytes)", m_name, capacity,
+    sizeInfo.accelerationStructureSize);
+}
+
+void PersistentTlas::set_instances(std::span<const TlasInstance> instances)
+{
+  const auto count = static_cast<uint32_t>(instances.size());
+  if (const uint32_t capacity = m_state.reserve(count))
+    allocate(capacity);
+  m_instances.assign(instances.begin(), instances.end());
+  m_state.set_instances(count);
+}
+
+void PersistentTlas::set_transform(uint32_t index, const glm::mat4& transform)
+{
+  m_state.set_transform(index); // bounds check
+  m_instances[index].transform = transform;
+}
+
+TlasBuild PersistentTlas::record(vk::CommandBuffer cmd, uint32_t slot)
+{
+  const TlasBuild build = m_state.next();
+  if (build == TlasBuild::none)
+    return build;
+
+  const auto count = m_state.instance_count();
+  assert(count <= m_capacity);
+  slot %= m_slot_count;
+
+  // The slot's ring region: its last reader was this slot's previous build,
+  // which has completed before the slot is recorded again. Written whole —
+  // it holds the state of that older frame.
+  auto* dst = static_cast<vk::AccelerationStructureInstanceKHR*>(m_instance_mapped) +
+    static_cast<size_t>(slot) * m_capacity;
+  for (uint32_t i = 0; i < count; ++i)
+  {
+    const auto& inst = m_instances[i];
+    dst[i] = to_vk_instance(*inst.blas, inst.transform, inst.custom_index, inst.mask,
+      inst.sbt_offset);
+  }
+
+  // Earlier submissions' traces (and builds, which share the scratch) finish
+  // before the structure is rewritten.
+  const vk::PipelineStageFlags readers = vk::PipelineStageFlagBits::eAccelerationStructureBuildKHR |
+    vk::PipelineStageFlagBits::eRayTracingShaderKHR | vk::PipelineStageFlagBits::eComputeShader |
+    vk::PipelineStageFlagBits::eFragmentShader;
+  vk::MemoryBarrier before{};
+  before.srcAccessMask = vk::AccessFlagBits::eAccelerationStructureWriteKHR;
+  before.dstAccessMask = vk::AccessFlagBits::eAccelerationStructureReadKHR |
+    vk::AccessFlagBits::eAccelerationStructureWriteKHR;
+  cmd.pipelineBarrier(readers, vk::PipelineStageFlagBits::eAccelerationStructureBuildKHR,
+    {}, before, {}, {});
+
+  const bool rebuild = build == TlasBuild::rebuild;
+  vk::AccelerationStructureGeometryKHR geometry = instances_geometry(
+    m_instance_address + sizeof(vk::AccelerationStructureInstanceKHR) * slot * m_capacity);
+  vk::AccelerationStructureBuildGeometryInfoKHR buildInfo{};
+  buildInfo.type = vk::AccelerationStructureTypeKHR::eTopLevel;
+  buildInfo.flags = vk::BuildAccelerationStructureFlagBitsKHR::ePreferFastTrace |
+    vk::BuildAccelerationStructureFlagBitsKHR::eAllowUpdate;
+  buildInfo.mode = rebuild ? vk::BuildAccelerationStructureModeKHR::eBuild
+                           : vk::BuildAccelerationStructureModeKHR::eUpdate;
+  buildInfo.srcAccelerationStructure = rebuild ? VK_NULL_HANDLE : m_tlas->handle();
+  buildInfo.dstAccelerationStructure = m_tlas->handle();
+  buildInfo.geometryCount = 1;
+  buildInfo.pGeometries = &geometry;
+  buildInfo.scratchData.deviceAddress = m_scratch_address;
+
+  vk::AccelerationStructureBuildRangeInfoKHR rangeInfo{};
+  rangeInfo.primitiveCount = count;
+  const vk::AccelerationStructureBuildRangeInfoKHR* pRangeInfo = &rangeInfo;
+  cmd.buildAccelerationStructuresKHR(1, &buildInfo, &pRangeInfo);
+
+  vk::MemoryBarrier after{};
+  after.srcAccessMask = vk::AccessFlagBits::eAccelerationStructureWriteKHR;
+  after.dstAccessMask = vk::AccessFlagBits::eAccelerationStructureReadKHR;
+  cmd.pipelineBarrier(vk::PipelineStageFlagBits::eAccelerationStructureBuildKHR, readers,
+    {}, after, {}, {});
+
+  m_state.built(build);
+  return build;
+}
+
+vk::AccelerationStructureKHR PersistentTlas::handle() const
+{
+  return m_tlas ? m_tlas->handle() : VK_NULL_HANDLE;
+}
+
+vk::DeviceAddress PersistentTlas::device_address() const
+{
+  return m_tlas ? m_tlas->device_address() : 0;
+}
+
 } // namespace vkwave
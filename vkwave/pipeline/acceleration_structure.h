@@ -3,6 +3,8 @@
 #include <vulkan/vulkan.hpp>
 #include <glm/glm.hpp>
 #include <memory>
+#include <span>
+#include <string>
 #include <vector>
 
 namespace vkwave
@@ -10,6 +12,35 @@ namespace vkwave
 
 class Device;
 class Mesh;
+struct ScenePrimitive;
+
+/// One BLAS input for AccelerationStructure::build_blases(): a triangle range
+/// of a vertex/index buffer pair (both need eShaderDeviceAddress and
+/// eAccelerationStructureBuildInputReadOnlyKHR usage).
+struct BlasGeometry
+{
+  std::string name;
+  vk::Buffer vertex_buffer{ VK_NULL_HANDLE };
+  uint32_t vertex_count{ 0 };                // vertices in the buffer
+  vk::Buffer index_buffer{ VK_NULL_HANDLE }; // null = non-indexed
+  uint32_t first_index{ 0 };                 // first index (or vertex) of the range
+  uint32_t index_count{ 0 };                 // indices (or vertices) in the range
+  int32_t vertex_offset{ 0 };                // added to every index
+  bool opaque{ true };                       // no any-hit (alpha-tested materials: false)
+};
+
+/// The whole mesh as one geometry.
+[[nodiscard]] BlasGeometry blas_geometry(const Mesh& mesh, const std::string& name);
+
+/// One glTF primitive of `mesh` (the scene's shared vertex/index buffers).
+[[nodiscard]] BlasGeometry blas_geometry(const Mesh& mesh, const ScenePrimitive& primitive,
+  const std::string& name);
+
+/// Offsets of `sizes` packed into one scratch buffer, each aligned to
+/// `alignment` (minAccelerationStructureScratchOffsetAlignment, a power of
+/// two); the last element is the total size.
+[[nodiscard]] std::vector<vk::DeviceSize> pack_scratch(
+  std::span<const vk::DeviceSize> sizes, vk::DeviceSize alignment);
 
 /// Wrapper for a Vulkan acceleration structure (BLAS or TLAS)
 class AccelerationStructure
@@ -30,15 +61,32 @@ public:
   [[nodiscard]] vk::DeviceAddress device_address() const { return m_device_address; }
   [[nodiscard]] vk::Buffer buffer() const { return m_buffer; }
 
-  /// Build a Bottom Level Acceleration Structure from mesh geometry
+  /// Build a Bottom Level Acceleration Structure from mesh geometry. Keeps its
+  /// scratch buffer; for more than one mesh prefer build_blases().
   void build_blas(vk::CommandBuffer cmd, const Mesh& mesh);
 
+  /// Build one compacted BLAS per geometry, blocking (load time):
+  ///   1. every build in one vkCmdBuildAccelerationStructuresKHR, with the
+  ///      scratch of all of them suballocated from one arena, followed by a
+  ///      compacted-size query per BLAS;
+  ///   2. a compacting copy of each into a BLAS of exactly the queried size.
+  /// The arena and the uncompacted structures are freed before returning.
+  [[nodiscard]] static std::vector<AccelerationStructure> build_blases(
+    const Device& device, std::span<const BlasGeometry> geometries);
+
+  /// Size of the acceleration structure's buffer.
+  [[nodiscard]] vk::DeviceSize size() const { return m_size; }
+
   /// Build a Top Level Acceleration Structure from BLAS instances
   void build_tlas(vk::CommandBuffer cmd,
     const std::vector<std::pair<const AccelerationStructure*, glm::mat4>>& instances);
 
 private:
   void create_buffer(vk::DeviceSize size, vk::BufferUsageFlags usage);
+  friend class PersistentTlas;
+
+  /// Create the buffer and handle of a `size`-byte structure (no build).
+  void create(vk::DeviceSize size, vk::AccelerationStructureTypeKHR type);
   void cleanup();
 
   const Device* m_device{ nullptr };
@@ -48,6 +96,7 @@ private:
   vk::Buffer m_buffer{ VK_NULL_HANDLE };
   vk::DeviceMemory m_memory{ VK_NULL_HANDLE };
   vk::DeviceAddress m_device_address{ 0 };
+  vk::DeviceSize m_size{ 0 };
 
   // Scratch buffer for building
   vk::Buffer m_scratch_buffer{ VK_NULL_HANDLE };
@@ -58,6 +107,149 @@ private:
   vk::DeviceMemory m_instance_memory{ VK_NULL_HANDLE };
 };
 
+/// One instance of a PersistentTlas.
+struct TlasInstance
+{
+  const AccelerationStructure* blas{ nullptr };
+  glm::mat4 transform{ 1.0f };
+  uint32_t custom_index{ 0 }; // gl_InstanceCustomIndexEXT (24 bits)
+  uint8_t mask{ 0xFF };
+  uint32_t sbt_offset{ 0 };   // hit group of its material (24 bits; RayTracingPipeline)
+};
+
+/// What a PersistentTlas does in its next record().
+enum class TlasBuild
+{
+  none,    ///< nothing changed
+  refit,   ///< transforms changed: eUpdate in place
+  rebuild, ///< instance set changed, or refits degraded the tree: full eBuild
+};
+
+/// The build a PersistentTlas needs: a changed instance set always rebuilds;
+/// changed transforms refit until `max_refits` refits have accumulated since
+/// the last build (each one widens the nodes the old topology keeps), then
+/// rebuild once.
+[[nodiscard]] TlasBuild choose_tlas_build(bool instances_changed, bool transforms_changed,
+  uint32_t refits, uint32_t max_refits);
+
+/// The bookkeeping of a PersistentTlas, without its GPU objects: the dirty
+/// state its record() builds from, and the capacity its structure is sized
+/// for.
+class TlasBuildState
+{
+public:
+  explicit TlasBuildState(uint32_t max_refits) : m_max_refits(max_refits) {}
+
+  /// Make room for `count` instances. Returns the new capacity (at least
+  /// double the old one) when the structure must be reallocated, else 0; a
+  /// reallocation advances generation() and forces a full build.
+  uint32_t reserve(uint32_t count);
+
+  /// A new set of `count` instances (the next build is a full one).
+  void set_instances(uint32_t count);
+
+  /// Instance `index` moved (the next build refits). Throws std::out_of_range
+  /// past the instance count.
+  void set_transform(uint32_t index);
+
+  void request_rebuild() { m_instances_dirty = true; }
+
+  /// What the next build does (see choose_tlas_build()).
+  [[nodiscard]] TlasBuild next() const;
+
+  /// `build` (next()) was recorded.
+  void built(TlasBuild build);
+
+  [[nodiscard]] uint32_t instance_count() const { return m_count; }
+  [[nodiscard]] uint32_t capacity() const { return m_capacity; }
+  [[nodiscard]] uint32_t generation() const { return m_generation; }
+  [[nodiscard]] uint32_t refits() const { return m_refits; }
+
+private:
+  uint32_t m_max_refits{ 0 };
+  uint32_t m_count{ 0 };
+  uint32_t m_capacity{ 0 };
+  uint32_t m_generation{ 0 };
+  uint32_t m_refits{ 0 };
+  bool m_instances_dirty{ true };
+  bool m_transforms_dirty{ false };
+};
+
+/// A TLAS kept across frames for animated instances.
+///
+/// The structure, its scratch and the instance buffer persist and only grow
+/// (to the largest instance count seen, in set_instances()). Growing replaces
+/// the structure: handle() changes and generation() advances, so descriptors
+/// holding the old handle must be rewritten (the old structure is retired
+/// through the deletion queue). The instance buffer is a host-mapped
+/// ring, one region per frame slot, so the host writes slot s's instances
+/// while other slots' builds may still read theirs. The dirty state is driven
+/// by the caller: set_instances() for a new instance set, set_transform() for
+/// moved ones; record() then does nothing, an eUpdate refit in place, or a
+/// full build (see choose_tlas_build()).
+///
+/// The TLAS is shared by all slots: record() orders its build after earlier
+/// submissions' ray tracing / ray queries and before later ones with
+/// barriers (single queue).
+class PersistentTlas
+{
+public:
+  PersistentTlas(const Device& device, std::string name, uint32_t slot_count,
+                 uint32_t max_refits = 64);
+  ~PersistentTlas();
+
+  PersistentTlas(const PersistentTlas&) = delete;
+  PersistentTlas& operator=(const PersistentTlas&) = delete;
+
+  /// Replace the instance set (the next record() rebuilds). Call outside
+  /// recording: it may grow the structure.
+  void set_instances(std::span<const TlasInstance> instances);
+
+  /// Move instance `index` (the next record() refits). Throws
+  /// std::out_of_range past instance_count().
+  void set_transform(uint32_t index, const glm::mat4& transform);
+
+  /// Force a full build in the next record() (e.g. after a teleport, where a
+  /// refit would leave very loose bounds).
+  void request_rebuild() { m_state.request_rebuild(); }
+
+  /// Build or refit for `slot`'s submission if anything changed. Record
+  /// outside any render pass, before the slot's ray tracing. Returns what was
+  /// done.
+  TlasBuild record(vk::CommandBuffer cmd, uint32_t slot);
+
+  [[nodiscard]] vk::AccelerationStructureKHR handle() const;
+  [[nodiscard]] vk::DeviceAddress device_address() const;
+  [[nodiscard]] uint32_t instance_count() const { return m_state.instance_count(); }
+  /// Advances whenever handle() changes.
+  [[nodiscard]] uint32_t generation() const { return m_state.generation(); }
+  /// Refits since the last full build.
+  [[nodiscard]] uint32_t refits() const { return m_state.refits(); }
+
+private:
+  /// (Re)allocate the structure, scratch and instance ring for `capacity`
+  /// instances (TlasBuildState::reserve()).
+  void allocate(uint32_t capacity);
+  void release();
+
+  const Device& m_device;
+  std::string m_name;
+  uint32_t m_slot_count{ 0 };
+
+  std::vector<TlasInstance> m_instances;
+  TlasBuildState m_state;
+
+  uint32_t m_capacity{ 0 }; // of the allocated objects
+  std::unique_ptr<AccelerationStructure> m_tlas;
+  vk::Buffer m_scratch_buffer{ VK_NULL_HANDLE };
+  vk::DeviceMemory m_scratch_memory{ VK_NULL_HANDLE };
+  vk::DeviceAddress m_scratch_address{ 0 };
+  vk::Buffer m_instance_buffer{ VK_NULL_HANDLE }; // [slot][capacity], host-mapped
+  vk::DeviceMemory m_instance_memory{ VK_NULL_HANDLE };
+  vk::DeviceAddress m_instance_address{ 0 };
+  void* m_instance_mapped{ nullptr };
+};
+
 /// Helper to get buffer device address
 vk::DeviceAddress get_buffer_device_address(vk::Device device, vk::Buffer buffer);
 
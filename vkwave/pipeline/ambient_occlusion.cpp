@@ -0,0 +1,334 @@
+#include <vkwave/pipeline/ambient_occlusion.h>
+
+#include <vkwave/config.h>
+#include <vkwave/core/ambient_occlusion.h>
+#include <vkwave/core/deletion_queue.h>
+#include <vkwave/core/device.h>
+
+#include <spdlog/fmt/fmt.h>
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+
+namespace vkwave
+{
+
+namespace
+{
+
+constexpr uint32_t kLocalSize = 8; // gtao.comp / ao_resolve.comp: 8x8
+// gtao.comp's output: visibility + view depth, the upsample's edge guide.
+constexpr vk::Format kRawFormat = vk::Format::eR16G16Sfloat;
+
+void image_barrier(vk::CommandBuffer cmd, vk::Image image, vk::ImageAspectFlags aspect,
+  vk::ImageLayout old_layout, vk::ImageLayout new_layout,
+  vk::PipelineStageFlags src_stage, vk::PipelineStageFlags dst_stage,
+  vk::AccessFlags src_access, vk::AccessFlags dst_access)
+{
+  vk::ImageMemoryBarrier barrier{};
+  barrier.oldLayout = old_layout;
+  barrier.newLayout = new_layout;
+  barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.image = image;
+  barrier.subresourceRange = { aspect, 0, 1, 0, 1 };
+  barrier.srcAccessMask = src_access;
+  barrier.dstAccessMask = dst_access;
+  cmd.pipelineBarrier(src_stage, dst_stage, {}, {}, {}, barrier);
+}
+
+vk::Sampler make_sampler(vk::Device dev, vk::Filter filter)
+{
+  vk::SamplerCreateInfo info{};
+  info.magFilter = filter;
+  info.minFilter = filter;
+  info.mipmapMode = vk::SamplerMipmapMode::eNearest;
+  info.addressModeU = vk::SamplerAddressMode::eClampToEdge;
+  info.addressModeV = vk::SamplerAddressMode::eClampToEdge;
+  info.addressModeW = vk::SamplerAddressMode::eClampToEdge;
+  return dev.createSampler(info);
+}
+
+} // namespace
+
+AmbientOcclusion::AmbientOcclusion(const Device& device, bool debug)
+  : m_device(device)
+{
+  m_gtao = std::make_unique<ComputePipeline>(device, SHADER_DIR "gtao.comp", debug,
+    fmt::format("#define SLICE_COUNT {}\n#define STEPS_PER_SIDE {}\n",
+      kGtaoSlices, kGtaoStepsPerSide));
+  m_resolve = std::make_unique<ComputePipeline>(device, SHADER_DIR "ao_resolve.comp", debug);
+
+  m_point_sampler = make_sampler(device.device(), vk::Filter::eNearest);
+  m_linear_sampler = make_sampler(device.device(), vk::Filter::eLinear);
+}
+
+AmbientOcclusion::~AmbientOcclusion()
+{
+  destroy_frame_resources();
+  m_device.deletion_queue().push([dev = m_device.device(), point = m_point_sampler,
+                                   linear = m_linear_sampler] {
+    dev.destroySampler(point);
+    dev.destroySampler(linear);
+  });
+}
+
+void AmbientOcclusion::create_frame_resources(const FrameResourcePool& pool,
+  FrameResourcePool::DepthHandle depth, FrameResourcePool::ColorHandle velocity,
+  FrameResourcePool::ColorHandle output)
+{
+  destroy_frame_resources();
+
+  m_pool = &pool;
+  m_depth = depth;
+  m_output = output;
+  m_slot_count = pool.slot_count();
+
+  auto dev = m_device.device();
+  const vk::Extent2D half = gtao_extent(pool.extent());
+  m_raw.reserve(m_slot_count);
+  for (uint32_t s = 0; s < m_slot_count; ++s)
+  {
+    m_raw.emplace_back(m_device, kRawFormat, half,
+      vk::ImageUsageFlagBits::eStorage | vk::ImageUsageFlagBits::eSampled,
+      fmt::format("gtao_raw_{}", s));
+  }
+
+  auto pool_sizes = m_gtao->pool_sizes(m_slot_count);
+  auto resolve_sizes = m_resolve->pool_sizes(m_slot_count);
+  pool_sizes.insert(pool_sizes.end(), resolve_sizes.begin(), resolve_sizes.end());
+  vk::DescriptorPoolCreateInfo pool_info{};
+  pool_info.maxSets = 2 * m_slot_count;
+  pool_info.poolSizeCount = static_cast<uint32_t>(pool_sizes.size());
+  pool_info.pPoolSizes = pool_sizes.data();
+  m_descriptor_pool = dev.createDescriptorPool(pool_info);
+  m_gtao_sets = m_gtao->allocate_sets(m_descriptor_pool, 0, m_slot_count);
+  m_resolve_sets = m_resolve->allocate_sets(m_descriptor_pool, 0, m_slot_count);
+
+  // Slot s reads its own depth/velocity. The history and output bindings are
+  // written per resolve (record()).
+  for (uint32_t s = 0; s < m_slot_count; ++s)
+  {
+    const vk::DescriptorImageInfo depth_info{ m_point_sampler,
+      pool.depth_sample_view(depth, s), vk::ImageLayout::eDepthStencilReadOnlyOptimal };
+    const vk::DescriptorImageInfo raw_storage{ VK_NULL_HANDLE, m_raw[s].image_view(),
+      vk::ImageLayout::eGeneral };
+    std::array<vk::DescriptorImageInfo, 3> resolve{ {
+      depth_info,
+      { m_point_sampler, m_raw[s].image_view(), vk::ImageLayout::eShaderReadOnlyOptimal },
+      { m_point_sampler, pool.color_view(velocity, s), vk::ImageLayout::eShaderReadOnlyOptimal },
+    } };
+
+    std::vector<vk::WriteDescriptorSet> writes;
+    auto write = [&](vk::DescriptorSet set, uint32_t binding, vk::DescriptorType type,
+                     const vk::DescriptorImageInfo& info) {
+      vk::WriteDescriptorSet w{};
+      w.dstSet = set;
+      w.dstBinding = binding;
+      w.descriptorCount = 1;
+      w.descriptorType = type;
+      w.pImageInfo = &info;
+      writes.push_back(w);
+    };
+    write(m_gtao_sets[s], 0, vk::DescriptorType::eCombinedImageSampler, depth_info);
+    write(m_gtao_sets[s], 1, vk::DescriptorType::eStorageImage, raw_storage);
+    for (uint32_t b = 0; b < resolve.size(); ++b)
+      write(m_resolve_sets[s], b, vk::DescriptorType::eCombinedImageSampler, resolve[b]);
+    dev.updateDescriptorSets(writes, {});
+  }
+
+  const auto limits = m_device.physicalDevice().getProperties().limits;
+  if (limits.timestampComputeAndGraphics)
+  {
+    m_timestamp_period = limits.timestampPeriod;
+    vk::QueryPoolCreateInfo info{};
+    info.queryType = vk::QueryType::eTimestamp;
+    info.queryCount = 2 * m_slot_count;
+    m_query_pool = dev.createQueryPool(info);
+  }
+  else
+  {
+    spdlog::warn("AmbientOcclusion: device cannot time compute work");
+  }
+  m_timed.assign(m_slot_count, false);
+  m_over_budget_logged = false;
+
+  m_history.resize(m_slot_count);
+}
+
+void AmbientOcclusion::destroy_frame_resources()
+{
+  // Deferred: a frame in flight may still use the sets and queries. The
+  // half-resolution images defer through their own destructors.
+  if (m_descriptor_pool || m_query_pool)
+  {
+    m_device.deletion_queue().push([dev = m_device.device(), pool = m_descriptor_pool,
+                                     query_pool = m_query_pool] {
+      if (pool)
+        dev.destroyDescriptorPool(pool);
+      if (query_pool)
+        dev.destroyQueryPool(query_pool);
+    });
+  }
+  m_descriptor_pool = VK_NULL_HANDLE;
+  m_query_pool = VK_NULL_HANDLE;
+  m_gtao_sets.clear();
+  m_resolve_sets.clear();
+  m_raw.clear();
+  m_timed.clear();
+  m_slot_count = 0;
+  m_pool = nullptr;
+}
+
+vk::ImageView AmbientOcclusion::output_view() const
+{
+  assert(m_pool && m_history.written_any() && "output_view() before record()");
+  return m_pool->color_view(m_output, m_history.latest());
+}
+
+void AmbientOcclusion::read_timings(uint32_t slot)
+{
+  // The slot's previous submission has completed (the graph waited for it
+  // before reusing the slot), so its timestamps are available.
+  if (!m_query_pool || !m_timed[slot])
+    return;
+  std::array<uint64_t, 2> ticks{};
+  const auto result = m_device.device().getQueryPoolResults(m_query_pool, 2 * slot, 2,
+    sizeof(ticks), ticks.data(), sizeof(uint64_t), vk::QueryResultFlagBits::e64);
+  if (result != vk::Result::eSuccess || ticks[1] < ticks[0])
+    return;
+  m_gpu_time_ms = static_cast<float>(
+    static_cast<double>(ticks[1] - ticks[0]) * m_timestamp_period * 1e-6);
+
+  if (m_gpu_time_ms > m_settings.budget_ms && !m_over_budget_logged)
+  {
+    const auto extent = m_pool->extent();
+    spdlog::warn("AmbientOcclusion: {:.3f} ms at {}x{} exceeds the {:.2f} ms budget",
+      m_gpu_time_ms, extent.width, extent.height, m_settings.budget_ms);
+    m_over_budget_logged = true;
+  }
+}
+
+void AmbientOcclusion::record(vk::CommandBuffer cmd, uint32_t slot,
+  vk::Extent2D render_extent, const glm::mat4& projection)
+{
+  if (slot >= m_slot_count)
+    return;
+
+  read_timings(slot);
+  if (m_query_pool)
+  {
+    cmd.resetQueryPool(m_query_pool, 2 * slot, 2);
+    cmd.writeTimestamp(vk::PipelineStageFlagBits::eTopOfPipe, m_query_pool, 2 * slot);
+  }
+
+  // The history is the output resolved last, however many slots ago. This
+  // slot's set was last used by its previous submission, which the graph
+  // waited for before reusing the slot.
+  const bool use_history = m_history.usable(slot);
+  const uint32_t written = m_history.target(slot);
+  {
+    // Without a history any view will do: the shader ignores it (feedback 1).
+    const std::array<vk::DescriptorImageInfo, 2> images{ {
+      { m_linear_sampler, m_pool->color_view(m_output, use_history ? m_history.latest() : written),
+        vk::ImageLayout::eShaderReadOnlyOptimal },
+      { VK_NULL_HANDLE, m_pool->color_view(m_output, written), vk::ImageLayout::eGeneral },
+    } };
+    std::array<vk::WriteDescriptorSet, 2> writes{};
+    for (uint32_t i = 0; i < writes.size(); ++i)
+    {
+      writes[i].dstSet = m_resolve_sets[slot];
+      writes[i].dstBinding = 3 + i;
+      writes[i].descriptorCount = 1;
+      writes[i].descriptorType = vk::DescriptorType::eCombinedImageSampler;
+      writes[i].pImageInfo = &images[i];
+    }
+    writes[1].descriptorType = vk::DescriptorType::eStorageImage;
+    m_device.device().updateDescriptorSets(writes, {});
+  }
+  const vk::Image depth = m_pool->depth_image(m_depth, slot);
+  const vk::Image raw = m_raw[slot].image();
+  const vk::Image output = m_pool->color_image(m_output, written);
+  const vk::Extent2D target = m_pool->extent();
+  const vk::Extent2D half = gtao_extent(render_extent);
+  const glm::mat4 inv_projection = glm::inverse(projection);
+
+  // Scene depth: attachment -> sampled by both dispatches. The raw AO's
+  // previous contents (this slot's last frame) are not needed.
+  image_barrier(cmd, depth, vk::ImageAspectFlagBits::eDepth,
+    vk::ImageLayout::eDepthStencilAttachmentOptimal, vk::ImageLayout::eDepthStencilReadOnlyOptimal,
+    vk::PipelineStageFlagBits::eLateFragmentTests, vk::PipelineStageFlagBits::eComputeShader,
+    vk::AccessFlagBits::eDepthStencilAttachmentWrite, vk::AccessFlagBits::eShaderRead);
+  image_barrier(cmd, raw, vk::ImageAspectFlagBits::eColor,
+    vk::ImageLayout::eUndefined, vk::ImageLayout::eGeneral,
+    vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eComputeShader,
+    {}, vk::AccessFlagBits::eShaderWrite);
+
+  GtaoPushConstants gtao{};
+  gtao.invProjection = inv_projection;
+  gtao.renderSize = glm::vec4(static_cast<float>(render_extent.width),
+    static_cast<float>(render_extent.height), 1.0f / static_cast<float>(render_extent.width),
+    1.0f / static_cast<float>(render_extent.height));
+  gtao.projScale = 0.5f * glm::vec2(gtao.renderSize) * glm::vec2(projection[0][0], projection[1][1]);
+  gtao.region = glm::ivec2(half.width, half.height);
+  gtao.radius = std::max(m_settings.radius, 1e-3f);
+  gtao.intensity = std::max(m_settings.intensity, 0.0f);
+  gtao.frame = m_frame++;
+
+  m_gtao->bind(cmd);
+  m_gtao->bind_descriptor_set(cmd, 0, m_gtao_sets[slot]);
+  m_gtao->push_constants(cmd, &gtao, sizeof(gtao));
+  cmd.dispatch(ComputePipeline::group_count(half.width, kLocalSize),
+    ComputePipeline::group_count(half.height, kLocalSize), 1);
+
+  // Raw AO -> sampled by the resolve. Discard the old output: its last
+  // readers (the scene passes that shaded with it and the resolve that took it
+  // as history) are earlier submissions.
+  image_barrier(cmd, raw, vk::ImageAspectFlagBits::eColor,
+    vk::ImageLayout::eGeneral, vk::ImageLayout::eShaderReadOnlyOptimal,
+    vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eComputeShader,
+    vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead);
+  image_barrier(cmd, output, vk::ImageAspectFlagBits::eColor,
+    vk::ImageLayout::eUndefined, vk::ImageLayout::eGeneral,
+    vk::PipelineStageFlagBits::eComputeShader | vk::PipelineStageFlagBits::eFragmentShader,
+    vk::PipelineStageFlagBits::eComputeShader, {}, vk::AccessFlagBits::eShaderWrite);
+
+  AoResolvePushConstants resolve{};
+  resolve.renderScale = glm::vec4(
+    static_cast<float>(render_extent.width) / static_cast<float>(target.width),
+    static_cast<float>(render_extent.height) / static_cast<float>(target.height),
+    1.0f / static_cast<float>(target.width), 1.0f / static_cast<float>(target.height));
+  resolve.depthParams = view_depth_params(inv_projection);
+  resolve.rawRegion = gtao.region;
+  resolve.feedback = use_history ? std::clamp(m_settings.feedback, 0.01f, 1.0f) : 1.0f;
+
+  m_resolve->bind(cmd);
+  m_resolve->bind_descriptor_set(cmd, 0, m_resolve_sets[slot]);
+  m_resolve->push_constants(cmd, &resolve, sizeof(resolve));
+  cmd.dispatch(ComputePipeline::group_count(target.width, kLocalSize),
+    ComputePipeline::group_count(target.height, kLocalSize), 1);
+
+  // Output -> sampled by the next scene frame's pass and resolve (the same
+  // barrier makes it visible to both: same queue, later submissions). Depth
+  // back to attachment for the passes that LOAD it.
+  image_barrier(cmd, output, vk::ImageAspectFlagBits::eColor,
+    vk::ImageLayout::eGeneral, vk::ImageLayout::eShaderReadOnlyOptimal,
+    vk::PipelineStageFlagBits::eComputeShader,
+    vk::PipelineStageFlagBits::eFragmentShader | vk::PipelineStageFlagBits::eComputeShader,
+    vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead);
+  image_barrier(cmd, depth, vk::ImageAspectFlagBits::eDepth,
+    vk::ImageLayout::eDepthStencilReadOnlyOptimal, vk::ImageLayout::eDepthStencilAttachmentOptimal,
+    vk::PipelineStageFlagBits::eComputeShader,
+    vk::PipelineStageFlagBits::eEarlyFragmentTests | vk::PipelineStageFlagBits::eLateFragmentTests,
+    {}, vk::AccessFlagBits::eDepthStencilAttachmentRead | vk::AccessFlagBits::eDepthStencilAttachmentWrite);
+
+  if (m_query_pool)
+    cmd.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, m_query_pool, 2 * slot + 1);
+  m_timed[slot] = m_query_pool != VK_NULL_HANDLE;
+
+  m_history.written(written);
+}
+
+} // namespace vkwave
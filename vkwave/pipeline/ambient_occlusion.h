@@ -0,0 +1,124 @@
+#pragma once
+
+#include <vkwave/core/image.h>
+#include <vkwave/core/temporal_history.h>
+#include <vkwave/pipeline/compute_pipeline.h>
+#include <vkwave/pipeline/frame_resource_pool.h>
+
+#include <glm/glm.hpp>
+#include <vulkan/vulkan.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace vkwave
+{
+
+class Device;
+
+/// Screen-space ambient occlusion: GTAO at half resolution over the scene
+/// depth, upsampled depth-aware and accumulated over frames.
+///
+///   gtao.comp        scene depth -> half-resolution (visibility, view depth),
+///                    a fixed number of samples per texel (kGtaoSlices x
+///                    2 x kGtaoStepsPerSide)
+///   ao_resolve.comp  -> target-sized (visibility, view depth): joint
+///                    bilateral upsample, blended with the output resolved
+///                    last, reprojected by the motion vectors
+///
+/// The half-resolution images are owned here (one per slot, like the HiZ
+/// pyramids); the output is a graph-owned pool resource, and like TemporalAA
+/// the output resolved last is the history, bound per resolve (a gated scene
+/// skips slots). There is no depth prepass, so the scene pass shades with the
+/// previous scene frame's output (pbr.frag reprojects it): output_view() once
+/// history_ready().
+///
+/// Both dispatches are timed with one pair of timestamps; gpu_time_ms() is
+/// the result, checked against Settings::budget_ms.
+class AmbientOcclusion
+{
+public:
+  struct Settings
+  {
+    float radius{ 0.5f };     // world-space search radius
+    float intensity{ 1.0f };  // exponent on the visibility (> 1 darkens)
+    float feedback{ 0.1f };   // weight of the current frame in the accumulation
+    float budget_ms{ 1.0f };  // GPU time both dispatches should stay under
+  };
+
+  AmbientOcclusion(const Device& device, bool debug);
+  ~AmbientOcclusion();
+
+  AmbientOcclusion(const AmbientOcclusion&) = delete;
+  AmbientOcclusion& operator=(const AmbientOcclusion&) = delete;
+
+  /// (Re)create the half-resolution images and per-slot descriptor sets for
+  /// the pool's current resources (single-sample depth only).
+  void create_frame_resources(const FrameResourcePool& pool,
+                              FrameResourcePool::DepthHandle depth,
+                              FrameResourcePool::ColorHandle velocity,
+                              FrameResourcePool::ColorHandle output);
+
+  void destroy_frame_resources();
+
+  /// Drop the history: the next resolve outputs its frame unblended, and the
+  /// frame after it is the first to shade with it.
+  void reset_history() { m_history.reset(); }
+
+  /// True when output_view() is the AO of the scene frame before the one being
+  /// recorded (not dropped by reset_history() since), so its scene pass may
+  /// shade with it.
+  [[nodiscard]] bool history_ready() const { return m_history.valid(); }
+
+  /// Compute `slot`'s AO. Record outside any render pass, after the opaque
+  /// draws: the depth is in eDepthStencilAttachmentOptimal before and after,
+  /// the velocity in eShaderReadOnlyOptimal. `render_extent` is the part of
+  /// them drawn this frame and `projection` the (jittered) projection the
+  /// depth was drawn with. The output is left in eShaderReadOnlyOptimal.
+  void record(vk::CommandBuffer cmd, uint32_t slot, vk::Extent2D render_extent,
+              const glm::mat4& projection);
+
+  /// The AO resolved last (valid when history_ready()).
+  [[nodiscard]] vk::ImageView output_view() const;
+
+  [[nodiscard]] Settings& settings() { return m_settings; }
+
+  /// GPU time of the latest completed run (0 without timestamp support).
+  [[nodiscard]] float gpu_time_ms() const { return m_gpu_time_ms; }
+
+  [[nodiscard]] bool ready() const { return m_slot_count > 0; }
+
+private:
+  void read_timings(uint32_t slot);
+
+  const Device& m_device;
+  Settings m_settings;
+
+  std::unique_ptr<ComputePipeline> m_gtao;
+  std::unique_ptr<ComputePipeline> m_resolve;
+  vk::Sampler m_point_sampler{ VK_NULL_HANDLE };  // depth, raw AO, velocity (texelFetch)
+  vk::Sampler m_linear_sampler{ VK_NULL_HANDLE }; // reprojected history
+
+  const FrameResourcePool* m_pool{ nullptr };
+  FrameResourcePool::DepthHandle m_depth{ 0 };
+  FrameResourcePool::ColorHandle m_output{ 0 };
+  uint32_t m_slot_count{ 0 };
+  std::vector<Image> m_raw; // [slot], half resolution
+
+  vk::DescriptorPool m_descriptor_pool{ VK_NULL_HANDLE };
+  std::vector<vk::DescriptorSet> m_gtao_sets;    // [slot]
+  std::vector<vk::DescriptorSet> m_resolve_sets; // [slot]
+
+  vk::QueryPool m_query_pool{ VK_NULL_HANDLE }; // 2 per slot
+  float m_timestamp_period{ 0.0f };
+  std::vector<bool> m_timed; // [slot], written last run
+  float m_gpu_time_ms{ 0.0f };
+  bool m_over_budget_logged{ false };
+
+  uint32_t m_frame{ 0 };
+  // The output resolved last is the next resolve's history.
+  TemporalHistory m_history;
+};
+
+} // namespace vkwave
@@ -0,0 +1,163 @@
+#include <vkwave/pipeline/clustered_lights.h>
+
+#include <vkwave/config.h>
+#include <vkwave/core/device.h>
+
+#include <spdlog/fmt/fmt.h>
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+
+namespace vkwave
+{
+
+namespace
+{
+
+constexpr uint32_t kCullLocalSize = 64; // cluster_lights.comp: 64x1
+
+} // namespace
+
+ClusteredLights::ClusteredLights(const Device& device, bool debug)
+  : m_device(device)
+{
+  m_cull = std::make_unique<ComputePipeline>(device, SHADER_DIR "cluster_lights.comp", debug);
+}
+
+ClusteredLights::~ClusteredLights()
+{
+  destroy_frame_resources();
+}
+
+void ClusteredLights::create_frame_resources(uint32_t slot_count)
+{
+  destroy_frame_resources();
+  m_slot_count = slot_count;
+  m_light_counts.assign(slot_count, 0);
+
+  const auto host = vk::MemoryPropertyFlagBits::eHostVisible
+                  | vk::MemoryPropertyFlagBits::eHostCoherent;
+  const vk::DeviceSize grid_bytes = LightCluster::Count * sizeof(glm::uvec2);
+  const vk::DeviceSize index_bytes =
+    static_cast<vk::DeviceSize>(LightCluster::Count) * LightCluster::MaxLightsPerCluster
+    * sizeof(uint32_t);
+
+  for (uint32_t s = 0; s < slot_count; ++s)
+  {
+    m_params.push_back(std::make_unique<Buffer>(m_device,
+      fmt::format("light_cluster_params_{}", s), sizeof(LightClusterParams),
+      vk::BufferUsageFlagBits::eUniformBuffer, host));
+    m_lights.push_back(std::make_unique<Buffer>(m_device,
+      fmt::format("light_buffer_{}", s), LightCluster::MaxLights * sizeof(GpuLight),
+      vk::BufferUsageFlagBits::eStorageBuffer, host));
+    m_grid.push_back(std::make_unique<Buffer>(m_device,
+      fmt::format("light_cluster_grid_{}", s), grid_bytes,
+      vk::BufferUsageFlagBits::eStorageBuffer, vk::MemoryPropertyFlagBits::eDeviceLocal));
+    m_indices.push_back(std::make_unique<Buffer>(m_device,
+      fmt::format("light_cluster_indices_{}", s), index_bytes,
+      vk::BufferUsageFlagBits::eStorageBuffer, vk::MemoryPropertyFlagBits::eDeviceLocal));
+  }
+
+  auto dev = m_device.device();
+  auto pool_sizes = m_cull->pool_sizes(slot_count);
+  vk::DescriptorPoolCreateInfo pool_info{};
+  pool_info.maxSets = slot_count;
+  pool_info.poolSizeCount = static_cast<uint32_t>(pool_sizes.size());
+  pool_info.pPoolSizes = pool_sizes.data();
+  m_descriptor_pool = dev.createDescriptorPool(pool_info);
+  m_sets = m_cull->allocate_sets(m_descriptor_pool, 0, slot_count);
+
+  // Every binding is per slot and fixed for the lifetime of the buffers.
+  for (uint32_t s = 0; s < slot_count; ++s)
+  {
+    std::array<vk::DescriptorBufferInfo, 4> infos{ {
+      { m_params[s]->buffer(), 0, sizeof(LightClusterParams) },
+      { m_lights[s]->buffer(), 0, VK_WHOLE_SIZE },
+      { m_grid[s]->buffer(), 0, VK_WHOLE_SIZE },
+      { m_indices[s]->buffer(), 0, VK_WHOLE_SIZE },
+    } };
+
+    std::array<vk::WriteDescriptorSet, 4> writes{};
+    for (uint32_t b = 0; b < writes.size(); ++b)
+    {
+      writes[b].dstSet = m_sets[s];
+      writes[b].dstBinding = b;
+      writes[b].descriptorCount = 1;
+      writes[b].descriptorType = (b == 0)
+        ? vk::DescriptorType::eUniformBuffer : vk::DescriptorType::eStorageBuffer;
+      writes[b].pBufferInfo = &infos[b];
+    }
+    dev.updateDescriptorSets(writes, {});
+  }
+}
+
+void ClusteredLights::destroy_frame_resources()
+{
+  if (m_descriptor_pool)
+  {
+    m_device.device().destroyDescriptorPool(m_descriptor_pool);
+    m_descriptor_pool = VK_NULL_HANDLE;
+  }
+  m_sets.clear();
+  m_params.clear();
+  m_lights.clear();
+  m_grid.clear();
+  m_indices.clear();
+  m_light_counts.clear();
+  m_slot_count = 0;
+}
+
+void ClusteredLights::update(uint32_t slot, std::span<const GpuLight> lights,
+                             const glm::mat4& view, const glm::mat4& proj,
+                             float near_plane, float far_plane)
+{
+  assert(slot < m_slot_count && "update() before create_frame_resources()");
+
+  if (lights.size() > LightCluster::MaxLights && !m_warned_truncation)
+  {
+    spdlog::warn("Clustered lighting: {} lights, only the first {} are used",
+      lights.size(), LightCluster::MaxLights);
+    m_warned_truncation = true;
+  }
+  const auto count = static_cast<uint32_t>(
+    std::min<size_t>(lights.size(), LightCluster::MaxLights));
+  if (count > 0)
+    m_lights[slot]->update(lights.data(), count * sizeof(GpuLight));
+  m_light_counts[slot] = count;
+
+  LightClusterParams params{};
+  params.inverseProj = glm::inverse(proj);
+  params.view = view;
+  params.gridSize = glm::uvec4(LightCluster::GridX, LightCluster::GridY, LightCluster::GridZ, 0);
+  params.zRange = glm::vec4(near_plane, far_plane, 0.0f, 0.0f);
+  m_params[slot]->update(&params, sizeof(params));
+}
+
+void ClusteredLights::record(vk::CommandBuffer cmd, uint32_t slot)
+{
+  if (slot >= m_slot_count)
+    return;
+
+  // No lights: the fragment shader skips the cluster lookup entirely
+  // (PbrUBO::clusterGrid.w == 0), so the stale grid is never read.
+  const uint32_t count = m_light_counts[slot];
+  if (count == 0)
+    return;
+
+  LightClusterPushConstants pc{ count, LightCluster::MaxLightsPerCluster, 0, 0 };
+  m_cull->bind(cmd);
+  m_cull->bind_descriptor_set(cmd, 0, m_sets[slot]);
+  m_cull->push_constants(cmd, &pc, sizeof(pc));
+  cmd.dispatch(ComputePipeline::group_count(LightCluster::Count, kCullLocalSize), 1, 1);
+
+  // Cluster grid + index lists -> the fragment shader's light loop.
+  vk::MemoryBarrier barrier{};
+  barrier.srcAccessMask = vk::AccessFlagBits::eShaderWrite;
+  barrier.dstAccessMask = vk::AccessFlagBits::eShaderRead;
+  cmd.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader,
+    vk::PipelineStageFlagBits::eFragmentShader, {}, barrier, {}, {});
+}
+
+} // namespace vkwave
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <vkwave/core/buffer.h>
+#include <vkwave/core/light_cluster.h>
+#include <vkwave/pipeline/compute_pipeline.h>
+
+#include <glm/glm.hpp>
+#include <vulkan/vulkan.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+namespace vkwave
+{
+
+class Device;
+
+/// Clustered forward lighting: per-frame light culling into a froxel grid.
+///
+/// Per frame slot it owns the light SSBO (host-visible, GpuLight[MaxLights]),
+/// the culling UBO, and the two device-local outputs pbr.frag reads:
+///
+///   cluster grid  — uvec2 per cluster: (first index, light count)
+///   light indices — MaxLightsPerCluster uint per cluster
+///
+/// update() writes the slot's lights + camera; record() dispatches
+/// cluster_lights.comp and makes the results visible to fragment shaders.
+/// Bind light_buffer() / grid_buffer() / index_buffer() at the fragment shader's
+/// set 0, bindings 1..3 of the same slot.
+class ClusteredLights
+{
+public:
+  ClusteredLights(const Device& device, bool debug);
+  ~ClusteredLights();
+
+  ClusteredLights(const ClusteredLights&) = delete;
+  ClusteredLights& operator=(const ClusteredLights&) = delete;
+
+  /// (Re)create the per-slot buffers and descriptor sets. The grid is
+  /// resolution-independent, so only the slot count matters. The GPU must be idle.
+  void create_frame_resources(uint32_t slot_count);
+
+  void destroy_frame_resources();
+
+  /// Upload this frame's lights (truncated to LightCluster::MaxLights) and
+  /// camera for `slot`. Call once the slot's previous submission has retired
+  /// (i.e. from the record callbacks).
+  void update(uint32_t slot, std::span<const GpuLight> lights,
+              const glm::mat4& view, const glm::mat4& proj,
+              float near_plane, float far_plane);
+
+  /// Record the culling dispatch for `slot`. Outside any render pass.
+  void record(vk::CommandBuffer cmd, uint32_t slot);
+
+  /// Lights uploaded for `slot` by the last update().
+  [[nodiscard]] uint32_t light_count(uint32_t slot) const { return m_light_counts[slot]; }
+
+  [[nodiscard]] vk::Buffer light_buffer(uint32_t slot) const { return m_lights[slot]->buffer(); }
+  [[nodiscard]] vk::Buffer grid_buffer(uint32_t slot) const { return m_grid[slot]->buffer(); }
+  [[nodiscard]] vk::Buffer index_buffer(uint32_t slot) const { return m_indices[slot]->buffer(); }
+
+  [[nodiscard]] uint32_t slot_count() const { return m_slot_count; }
+
+private:
+  const Device& m_device;
+
+  std::unique_ptr<ComputePipeline> m_cull;
+
+  uint32_t m_slot_count{ 0 };
+  std::vector<uint32_t> m_light_counts;
+  std::vector<std::unique_ptr<Buffer>> m_params;  // LightClusterParams, host-visible
+  std::vector<std::unique_ptr<Buffer>> m_lights;  // GpuLight[MaxLights], host-visible
+  std::vector<std::unique_ptr<Buffer>> m_grid;    // uvec2[Count], device-local
+  std::vector<std::unique_ptr<Buffer>> m_indices; // uint[Count * MaxLightsPerCluster]
+
+  vk::DescriptorPool m_descriptor_pool{ VK_NULL_HANDLE };
+  std::vector<vk::DescriptorSet> m_sets; // [slot]
+
+  bool m_warned_truncation{ false };
+};
+
+} // namespace vkwave
@@ -39,7 +39,8 @@ void CompositePass::record(vk::CommandBuffer cmd) const
   cmd.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, layout,
     0, 1, &ds, 0, nullptr);
 
-  struct { float exposure; int tonemapMode; } pc{ exposure, tonemap_mode };
+  struct { float exposure; int tonemapMode; glm::vec2 uvScale; } pc{
+    exposure, tonemap_mode, uv_scale };
   cmd.pushConstants(layout,
     vk::ShaderStageFlagBits::eFragment,
     0, sizeof(pc), &pc);
@@ -3,6 +3,7 @@
 #include <vkwave/core/pass.h>
 #include <vkwave/pipeline/pipeline.h>
 
+#include <glm/glm.hpp>
 #include <vulkan/vulkan.hpp>
 
 namespace vkwave
@@ -20,6 +21,10 @@ struct CompositePass : Pass<CompositePass>
   float exposure{ 1.0f };
   int tonemap_mode{ 0 };
 
+  // Dynamic resolution: the HDR source holds the scene in its top-left
+  // uv_scale fraction; the composite stretches that region over the output.
+  glm::vec2 uv_scale{ 1.0f };
+
   /// Returns the PipelineSpec (fullscreen.vert + composite.frag, no vertex input, no depth).
   /// The caller must set existing_renderpass on the returned spec before passing to add_group().
   static PipelineSpec pipeline_spec();
@@ -0,0 +1,235 @@
+#include <vkwave/pipeline/compute_composite.h>
+
+#include <vkwave/config.h>
+#include <vkwave/core/deletion_queue.h>
+#include <vkwave/core/device.h>
+#include <vkwave/core/swapchain.h>
+
+#include <spdlog/fmt/fmt.h>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstring>
+
+namespace vkwave
+{
+
+namespace
+{
+
+constexpr uint32_t kLocalSize = 16; // composite.comp: 16x16
+
+// Cleared before every dispatch: the counter and the histogram.
+constexpr vk::DeviceSize kClearOffset = offsetof(ExposureState, finishedGroups);
+constexpr vk::DeviceSize kClearSize = sizeof(ExposureState) - kClearOffset;
+
+} // namespace
+
+ComputeComposite::ComputeComposite(const Device& device, bool debug)
+  : m_device(device)
+{
+  m_composite = std::make_unique<ComputePipeline>(device, SHADER_DIR "composite.comp", debug);
+  m_state = std::make_unique<Buffer>(device, "exposure_state", sizeof(ExposureState),
+    vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst
+      | vk::BufferUsageFlagBits::eTransferSrc,
+    vk::MemoryPropertyFlagBits::eDeviceLocal);
+  m_statistics.exposure = 1.0f;
+}
+
+ComputeComposite::~ComputeComposite()
+{
+  destroy_frame_resources();
+}
+
+bool ComputeComposite::supported(const Device& device)
+{
+  vk::PhysicalDeviceSubgroupProperties subgroup{};
+  vk::PhysicalDeviceProperties2 props2{};
+  props2.pNext = &subgroup;
+  device.physicalDevice().getProperties2(&props2);
+
+  const auto ops = vk::SubgroupFeatureFlagBits::eBasic | vk::SubgroupFeatureFlagBits::eBallot
+    | vk::SubgroupFeatureFlagBits::eArithmetic;
+  return (subgroup.supportedStages & vk::ShaderStageFlagBits::eCompute)
+    && (subgroup.supportedOperations & ops) == ops;
+}
+
+void ComputeComposite::create_frame_resources(const Swapchain& swapchain)
+{
+  destroy_frame_resources();
+
+  const uint32_t count = swapchain.image_count();
+  m_images = swapchain.images();
+  m_extent = swapchain.extent();
+
+  auto dev = m_device.device();
+  auto pool_sizes = m_composite->pool_sizes(count);
+  vk::DescriptorPoolCreateInfo pool_info{};
+  pool_info.maxSets = count;
+  pool_info.poolSizeCount = static_cast<uint32_t>(pool_sizes.size());
+  pool_info.pPoolSizes = pool_sizes.data();
+  m_descriptor_pool = dev.createDescriptorPool(pool_info);
+  m_sets = m_composite->allocate_sets(m_descriptor_pool, 0, count);
+
+  // The output image and the state are fixed per set; the HDR source changes
+  // with the frame (and TAA), so record() writes it.
+  for (uint32_t i = 0; i < count; ++i)
+  {
+    vk::DescriptorImageInfo output{ VK_NULL_HANDLE, swapchain.image_views()[i],
+      vk::ImageLayout::eGeneral };
+    vk::DescriptorBufferInfo state{ m_state->buffer(), 0, sizeof(ExposureState) };
+
+    std::array<vk::WriteDescriptorSet, 2> writes{};
+    writes[0].dstSet = m_sets[i];
+    writes[0].dstBinding = 1;
+    writes[0].descriptorCount = 1;
+    writes[0].descriptorType = vk::DescriptorType::eStorageImage;
+    writes[0].pImageInfo = &output;
+    writes[1].dstSet = m_sets[i];
+    writes[1].dstBinding = 2;
+    writes[1].descriptorCount = 1;
+    writes[1].descriptorType = vk::DescriptorType::eStorageBuffer;
+    writes[1].pBufferInfo = &state;
+    dev.updateDescriptorSets(writes, {});
+
+    m_readbacks.push_back(std::make_unique<Buffer>(m_device,
+      fmt::format("exposure_readback_{}", i), sizeof(ExposureState),
+      vk::BufferUsageFlagBits::eTransferDst,
+      vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent));
+    m_readbacks.back()->map();
+  }
+  m_readback_pending.assign(count, false);
+}
+
+void ComputeComposite::destroy_frame_resources()
+{
+  // Deferred: a composite in flight may still use the sets (Buffer defers
+  // its own destruction).
+  if (m_descriptor_pool)
+  {
+    m_device.deletion_queue().push([dev = m_device.device(), pool = m_descriptor_pool] {
+      dev.destroyDescriptorPool(pool);
+    });
+    m_descriptor_pool = VK_NULL_HANDLE;
+  }
+  m_readbacks.clear();
+  m_readback_pending.clear();
+  m_sets.clear();
+  m_images.clear();
+}
+
+void ComputeComposite::record(vk::CommandBuffer cmd, uint32_t image_index,
+  vk::ImageView hdr_view, vk::Sampler sampler, glm::vec2 uv_scale, float dt)
+{
+  if (image_index >= m_sets.size())
+    return;
+
+  // This image's previous submission has retired (the caller waited for the
+  // slot), so its readback holds a complete state.
+  if (m_readback_pending[image_index])
+    std::memcpy(&m_statistics, m_readbacks[image_index]->mapped_data(), sizeof(ExposureState));
+
+  // The set belongs to this image's submission only, which has retired.
+  vk::DescriptorImageInfo hdr{ sampler, hdr_view, vk::ImageLayout::eShaderReadOnlyOptimal };
+  vk::WriteDescriptorSet write{};
+  write.dstSet = m_sets[image_index];
+  write.dstBinding = 0;
+  write.descriptorCount = 1;
+  write.descriptorType = vk::DescriptorType::eCombinedImageSampler;
+  write.pImageInfo = &hdr;
+  m_device.device().updateDescriptorSets(write, {});
+
+  const vk::Buffer state = m_state->buffer();
+
+  // The previous dispatch (an earlier submission) and its readback copy are
+  // done with the state before it is cleared. The first use also seeds the
+  // exposure.
+  vk::BufferMemoryBarrier to_clear{};
+  to_clear.srcAccessMask = vk::AccessFlagBits::eShaderWrite | vk::AccessFlagBits::eTransferRead;
+  to_clear.dstAccessMask = vk::AccessFlagBits::eTransferWrite;
+  to_clear.buffer = state;
+  to_clear.size = VK_WHOLE_SIZE;
+  cmd.pipelineBarrier(
+    vk::PipelineStageFlagBits::eComputeShader | vk::PipelineStageFlagBits::eTransfer,
+    vk::PipelineStageFlagBits::eTransfer, {}, {}, to_clear, {});
+  if (!m_state_initialized)
+  {
+    const std::array<float, 2> initial{ 1.0f, 0.0f }; // exposure, averageLog2
+    cmd.updateBuffer(state, 0, sizeof(initial), initial.data());
+    m_state_initialized = true;
+  }
+  cmd.fillBuffer(state, kClearOffset, kClearSize, 0u);
+
+  vk::BufferMemoryBarrier to_compute{};
+  to_compute.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+  to_compute.dstAccessMask = vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite;
+  to_compute.buffer = state;
+  to_compute.size = VK_WHOLE_SIZE;
+
+  // The swapchain image's old contents are not needed. The acquire wait gates
+  // compute (see SubmissionGroup::set_acquire_stage()).
+  vk::ImageMemoryBarrier to_general{};
+  to_general.srcAccessMask = {};
+  to_general.dstAccessMask = vk::AccessFlagBits::eShaderWrite;
+  to_general.oldLayout = vk::ImageLayout::eUndefined;
+  to_general.newLayout = vk::ImageLayout::eGeneral;
+  to_general.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  to_general.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  to_general.image = m_images[image_index];
+  to_general.subresourceRange = { vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1 };
+  cmd.pipelineBarrier(
+    vk::PipelineStageFlagBits::eTransfer | vk::PipelineStageFlagBits::eComputeShader,
+    vk::PipelineStageFlagBits::eComputeShader, {}, {}, to_compute, to_general);
+
+  const uint32_t groups_x = ComputePipeline::group_count(m_extent.width, kLocalSize);
+  const uint32_t groups_y = ComputePipeline::group_count(m_extent.height, kLocalSize);
+  CompositePushConstants pc{};
+  pc.uvScale = uv_scale;
+  pc.outSize = glm::ivec2(m_extent.width, m_extent.height);
+  pc.exposure = m_settings.exposure;
+  pc.tonemapMode = m_settings.tonemap_mode;
+  pc.autoExposure = m_settings.auto_exposure ? 1 : 0;
+  pc.adaptation = exposure_adaptation(dt, m_settings.adaptation_speed);
+  pc.minLog2 = m_settings.min_log2;
+  pc.log2Range = std::max(m_settings.max_log2 - m_settings.min_log2, 1.0f);
+  pc.groupCount = groups_x * groups_y;
+  pc.middleGrey = kExposureMiddleGrey;
+
+  m_composite->bind(cmd);
+  m_composite->bind_descriptor_set(cmd, 0, m_sets[image_index]);
+  m_composite->push_constants(cmd, &pc, sizeof(pc));
+  cmd.dispatch(groups_x, groups_y, 1);
+
+  // Image -> the overlay's LOAD (color attachment) or presentation; state ->
+  // the readback copy.
+  vk::ImageMemoryBarrier to_present = to_general;
+  to_present.srcAccessMask = vk::AccessFlagBits::eShaderWrite;
+  to_present.dstAccessMask =
+    vk::AccessFlagBits::eColorAttachmentRead | vk::AccessFlagBits::eColorAttachmentWrite;
+  to_present.oldLayout = vk::ImageLayout::eGeneral;
+  to_present.newLayout = vk::ImageLayout::ePresentSrcKHR;
+
+  vk::BufferMemoryBarrier to_copy{};
+  to_copy.srcAccessMask = vk::AccessFlagBits::eShaderWrite;
+  to_copy.dstAccessMask = vk::AccessFlagBits::eTransferRead;
+  to_copy.buffer = state;
+  to_copy.size = VK_WHOLE_SIZE;
+  cmd.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader,
+    vk::PipelineStageFlagBits::eColorAttachmentOutput | vk::PipelineStageFlagBits::eTransfer,
+    {}, {}, to_copy, to_present);
+
+  const vk::Buffer readback = m_readbacks[image_index]->buffer();
+  cmd.copyBuffer(state, readback, vk::BufferCopy{ 0, 0, sizeof(ExposureState) });
+
+  vk::BufferMemoryBarrier to_host{};
+  to_host.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+  to_host.dstAccessMask = vk::AccessFlagBits::eHostRead;
+  to_host.buffer = readback;
+  to_host.size = VK_WHOLE_SIZE;
+  cmd.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eHost,
+    {}, {}, to_host, {});
+  m_readback_pending[image_index] = true;
+}
+
+} // namespace vkwave
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <vkwave/core/buffer.h>
+#include <vkwave/core/exposure.h>
+#include <vkwave/pipeline/compute_pipeline.h>
+
+#include <glm/glm.hpp>
+#include <vulkan/vulkan.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace vkwave
+{
+
+class Device;
+class Swapchain;
+
+/// Compute composite: tonemaps the HDR straight into the swapchain image and
+/// builds the luminance histogram that drives auto-exposure, in one dispatch
+/// of composite.comp (see there). Replaces the fullscreen CompositePass when
+/// the swapchain images can be storage images (Swapchain::storage_images());
+/// the present group then records without a render pass and the ImGui
+/// overlay LOADs the result.
+///
+/// Owns the exposure state (device-local, persistent across frames) and, per
+/// swapchain image, a descriptor set and a host-visible copy of the state for
+/// statistics().
+class ComputeComposite
+{
+public:
+  /// Auto-exposure and presentation parameters (the CompositePass fields,
+  /// plus the adaptation).
+  struct Settings
+  {
+    float exposure{ 1.0f };        // manual exposure, or compensation with auto_exposure
+    int tonemap_mode{ 0 };
+    bool auto_exposure{ true };
+    float adaptation_speed{ 1.5f }; // 1 / time constant of the adaptation, per second
+    float min_log2{ -10.0f };       // histogram range, log2 luminance
+    float max_log2{ 6.0f };
+  };
+
+  ComputeComposite(const Device& device, bool debug);
+  ~ComputeComposite();
+
+  ComputeComposite(const ComputeComposite&) = delete;
+  ComputeComposite& operator=(const ComputeComposite&) = delete;
+
+  /// True when the device exposes the basic, ballot and arithmetic subgroup
+  /// operations to compute shaders.
+  static bool supported(const Device& device);
+
+  /// (Re)create the per-image descriptor sets and readbacks for `swapchain`
+  /// (call after every swapchain (re)creation). The previous ones are
+  /// destroyed through the device deletion queue; the exposure state survives.
+  void create_frame_resources(const Swapchain& swapchain);
+
+  void destroy_frame_resources();
+
+  /// Composite `hdr_view` (eShaderReadOnlyOptimal) into swapchain image
+  /// `image_index`, outside any render pass. The image goes from Undefined to
+  /// ePresentSrcKHR, ready for the overlay's LOAD or for presenting.
+  /// `uv_scale` is the rendered fraction of the HDR, `dt` the frame time in
+  /// seconds (adaptation).
+  void record(vk::CommandBuffer cmd, uint32_t image_index, vk::ImageView hdr_view,
+              vk::Sampler sampler, glm::vec2 uv_scale, float dt);
+
+  [[nodiscard]] Settings& settings() { return m_settings; }
+
+  /// Exposure state and histogram of the latest dispatch whose readback has
+  /// completed (a ring depth behind the frame being recorded).
+  [[nodiscard]] const ExposureState& statistics() const { return m_statistics; }
+
+  /// True while auto-exposure is still moving toward its target, as of
+  /// statistics(): render-on-demand must keep producing frames until it has
+  /// settled.
+  [[nodiscard]] bool adapting() const
+  {
+    return m_settings.auto_exposure && exposure_error_stops(m_statistics) > kExposureSettledStops;
+  }
+
+  [[nodiscard]] bool ready() const { return !m_sets.empty(); }
+
+private:
+  const Device& m_device;
+  Settings m_settings;
+
+  std::unique_ptr<ComputePipeline> m_composite;
+  std::unique_ptr<Buffer> m_state; // ExposureState, device-local
+  bool m_state_initialized{ false };
+
+  std::vector<vk::Image> m_images; // [swapchain image]
+  vk::Extent2D m_extent{};
+  vk::DescriptorPool m_descriptor_pool{ VK_NULL_HANDLE };
+  std::vector<vk::DescriptorSet> m_sets;                // [swapchain image]
+  std::vector<std::unique_ptr<Buffer>> m_readbacks;     // [swapchain image], host-visible
+  std::vector<bool> m_readback_pending;                 // [swapchain image]
+  ExposureState m_statistics{};
+};
+
+} // namespace vkwave
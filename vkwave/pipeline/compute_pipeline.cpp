@@ -0,0 +1,124 @@
+#include <vkwave/pipeline/compute_pipeline.h>
+
+#include <vkwave/core/deletion_queue.h>
+#include <vkwave/core/device.h>
+#include <vkwave/pipeline/shader_compiler.h>
+
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+
+namespace vkwave
+{
+
+ComputePipeline::ComputePipeline(
+  const Device& device, const std::string& shader_path, bool debug,
+  const std::string& preamble)
+  : m_device(device.device())
+  , m_deletion_queue(&device.deletion_queue())
+{
+  auto compiler = ShaderCompiler::get();
+  assert(compiler && "ShaderCompiler not created — call ShaderCompiler::create() first");
+  auto comp = compiler->compile(shader_path, vk::ShaderStageFlagBits::eCompute, preamble);
+
+  ShaderReflection reflection;
+  reflection.set_debug(compiler->debug_info());
+  reflection.add_stage(comp.spirv, vk::ShaderStageFlagBits::eCompute);
+  reflection.finalize();
+
+  m_reflected_sets = reflection.descriptor_set_infos();
+  m_set_layouts = reflection.create_descriptor_set_layouts(m_device);
+
+  const auto& ranges = reflection.push_constant_ranges();
+  for (auto& r : ranges)
+    m_push_constant_size = std::max(m_push_constant_size, r.offset + r.size);
+
+  vk::PipelineLayoutCreateInfo layout_info{};
+  layout_info.setLayoutCount = static_cast<uint32_t>(m_set_layouts.size());
+  layout_info.pSetLayouts = m_set_layouts.data();
+  layout_info.pushConstantRangeCount = static_cast<uint32_t>(ranges.size());
+  layout_info.pPushConstantRanges = ranges.data();
+  m_layout = m_device.createPipelineLayout(layout_info);
+
+  auto module = ShaderCompiler::create_module(m_device, comp.spirv);
+
+  vk::ComputePipelineCreateInfo ci{};
+  ci.stage.stage = vk::ShaderStageFlagBits::eCompute;
+  ci.stage.module = module;
+  ci.stage.pName = "main";
+  ci.layout = m_layout;
+
+  try
+  {
+    m_pipeline = m_device.createComputePipeline(nullptr, ci).value;
+  }
+  catch (vk::SystemError err)
+  {
+    if (debug)
+      std::cout << "Failed to create compute pipeline " << shader_path << std::endl;
+  }
+
+  m_device.destroyShaderModule(module);
+}
+
+ComputePipeline::~ComputePipeline()
+{
+  // Dispatches in flight may still reference the pipeline and its layouts.
+  m_deletion_queue->push([device = m_device, pipeline = m_pipeline, layout = m_layout,
+                           set_layouts = std::move(m_set_layouts)] {
+    if (pipeline)
+      device.destroyPipeline(pipeline);
+    if (layout)
+      device.destroyPipelineLayout(layout);
+    for (auto set_layout : set_layouts)
+      device.destroyDescriptorSetLayout(set_layout);
+  });
+}
+
+void ComputePipeline::bind(vk::CommandBuffer cmd) const
+{
+  cmd.bindPipeline(vk::PipelineBindPoint::eCompute, m_pipeline);
+}
+
+void ComputePipeline::bind_descriptor_set(
+  vk::CommandBuffer cmd, uint32_t set_index, vk::DescriptorSet set) const
+{
+  cmd.bindDescriptorSets(vk::PipelineBindPoint::eCompute, m_layout,
+    set_index, 1, &set, 0, nullptr);
+}
+
+void ComputePipeline::push_constants(
+  vk::CommandBuffer cmd, const void* data, uint32_t size) const
+{
+  assert(size == m_push_constant_size && "push constant size mismatch");
+  cmd.pushConstants(m_layout, vk::ShaderStageFlagBits::eCompute, 0, size, data);
+}
+
+std::vector<vk::DescriptorPoolSize> ComputePipeline::pool_sizes(uint32_t count) const
+{
+  std::vector<vk::DescriptorPoolSize> sizes;
+  for (auto& set_info : m_reflected_sets)
+    for (auto& b : set_info.bindings)
+      sizes.push_back({ b.type, b.count * count });
+  return sizes;
+}
+
+std::vector<vk::DescriptorSet> ComputePipeline::allocate_sets(
+  vk::DescriptorPool pool, uint32_t set_index, uint32_t count) const
+{
+  std::vector<vk::DescriptorSetLayout> layouts(count, set_layout(set_index));
+
+  vk::DescriptorSetAllocateInfo alloc_info{};
+  alloc_info.descriptorPool = pool;
+  alloc_info.descriptorSetCount = count;
+  alloc_info.pSetLayouts = layouts.data();
+  return m_device.allocateDescriptorSets(alloc_info);
+}
+
+vk::DescriptorSetLayout ComputePipeline::set_layout(uint32_t set_index) const
+{
+  assert(set_index < m_set_layouts.size() && "set index out of range");
+  return m_set_layouts[set_index];
+}
+
+} // namespace vkwave
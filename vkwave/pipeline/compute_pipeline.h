@@ -0,0 +1,77 @@
+#pragma once
+
+#include <vkwave/pipeline/shader_reflection.h>
+
+#include <vulkan/vulkan.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace vkwave
+{
+
+class DeletionQueue;
+class Device;
+
+/// Reflected compute pipeline.
+///
+/// Compiles a .comp through ShaderCompiler, derives descriptor set layouts and
+/// push-constant ranges via ShaderReflection (the same path ExecutionGroup uses
+/// for graphics), and owns the resulting pipeline, layout and set layouts.
+/// Descriptor pools/sets stay with the caller, which knows how many
+/// allocations it needs (per slot, per mip, ...).
+class ComputePipeline
+{
+public:
+  /// `preamble` is passed to ShaderCompiler::compile() (e.g. format defines).
+  ComputePipeline(const Device& device, const std::string& shader_path, bool debug,
+                  const std::string& preamble = {});
+  ~ComputePipeline();
+
+  ComputePipeline(const ComputePipeline&) = delete;
+  ComputePipeline& operator=(const ComputePipeline&) = delete;
+
+  /// Bind the pipeline to the compute bind point.
+  void bind(vk::CommandBuffer cmd) const;
+
+  /// Bind one descriptor set at `set_index` to the compute bind point.
+  void bind_descriptor_set(vk::CommandBuffer cmd, uint32_t set_index,
+                           vk::DescriptorSet set) const;
+
+  /// Push the whole reflected push-constant block (`size` must match it).
+  void push_constants(vk::CommandBuffer cmd, const void* data, uint32_t size) const;
+
+  /// Pool sizes for `count` allocations of every reflected set.
+  [[nodiscard]] std::vector<vk::DescriptorPoolSize> pool_sizes(uint32_t count) const;
+
+  /// Allocate `count` descriptor sets of layout `set_index` from `pool`.
+  [[nodiscard]] std::vector<vk::DescriptorSet> allocate_sets(
+    vk::DescriptorPool pool, uint32_t set_index, uint32_t count) const;
+
+  [[nodiscard]] vk::Pipeline pipeline() const { return m_pipeline; }
+  [[nodiscard]] vk::PipelineLayout layout() const { return m_layout; }
+  [[nodiscard]] vk::DescriptorSetLayout set_layout(uint32_t set_index) const;
+  [[nodiscard]] uint32_t set_count() const
+  {
+    return static_cast<uint32_t>(m_set_layouts.size());
+  }
+  [[nodiscard]] const std::vector<DescriptorSetInfo>& set_infos() const { return m_reflected_sets; }
+
+  /// Workgroup count covering `n` invocations with `local_size` per group.
+  [[nodiscard]] static uint32_t group_count(uint32_t n, uint32_t local_size)
+  {
+    return (n + local_size - 1) / local_size;
+  }
+
+private:
+  vk::Device m_device;
+  DeletionQueue* m_deletion_queue{ nullptr };
+  vk::Pipeline m_pipeline{ VK_NULL_HANDLE };
+  vk::PipelineLayout m_layout{ VK_NULL_HANDLE };
+  std::vector<vk::DescriptorSetLayout> m_set_layouts;
+  std::vector<DescriptorSetInfo> m_reflected_sets;
+  uint32_t m_push_constant_size{ 0 };
+};
+
+} // namespace vkwave
@@ -1,6 +1,7 @@
 #include <vkwave/pipeline/execution_group.h>
 
 #include <vkwave/core/commands.h>
+#include <vkwave/core/deletion_queue.h>
 #include <vkwave/core/device.h>
 #include <vkwave/core/swapchain.h>
 #include <vkwave/pipeline/framebuffer.h>
@@ -10,6 +11,7 @@
 #include <spdlog/fmt/fmt.h>
 #include <spdlog/spdlog.h>
 
+#include <algorithm>
 #include <cassert>
 
 namespace vkwave
@@ -40,12 +42,21 @@ ExecutionGroup::ExecutionGroup(
   , m_depth_format(spec.depth_format)
   , m_msaa_samples(spec.msaa_samples)
   , m_color_format(swapchain_format)
+  , m_dynamic_rendering(spec.dynamic_rendering && device.supports_dynamic_rendering())
+  , m_load_attachments(spec.load_attachments)
+  , m_load_depth(spec.load_depth)
+  , m_store_depth(spec.store_depth)
 {
+  if (spec.dynamic_rendering && !m_dynamic_rendering)
+    spdlog::debug("ExecutionGroup '{}': no dynamic rendering, using the render pass", name);
+
   // Compile shaders
   auto compiler = ShaderCompiler::get();
   assert(compiler && "ShaderCompiler not created — call ShaderCompiler::create() first");
-  auto vert = compiler->compile(spec.vertex_shader, vk::ShaderStageFlagBits::eVertex);
-  auto frag = compiler->compile(spec.fragment_shader, vk::ShaderStageFlagBits::eFragment);
+  auto vert = compiler->compile(spec.vertex_shader, vk::ShaderStageFlagBits::eVertex,
+    spec.vertex_preamble);
+  auto frag = compiler->compile(spec.fragment_shader, vk::ShaderStageFlagBits::eFragment,
+    spec.fragment_preamble);
 
   // Reflect layout
   ShaderReflection reflection;
@@ -56,6 +67,13 @@ ExecutionGroup::ExecutionGroup(
 
   // Store reflected descriptor set info for auto-creating UBOs later
   m_reflected_sets = reflection.descriptor_set_infos();
+  for (auto& set_info : m_reflected_sets)
+  {
+    if (m_binding_names.size() <= set_info.set)
+      m_binding_names.resize(set_info.set + 1);
+    for (auto& b : set_info.bindings)
+      m_binding_names[set_info.set].emplace(b.name, b.binding);
+  }
 
   // Register buffer specs for each UBO binding with blockSize > 0.
   // Storage buffers are intentionally excluded: they are managed manually
@@ -93,23 +111,34 @@ ExecutionGroup::ExecutionGroup(
   bundle_in.wireframe = spec.wireframe;
   bundle_in.depthTestEnabled = spec.depth_test;
   bundle_in.depthWriteEnabled = spec.depth_write;
+  bundle_in.depthReversed = spec.reversed_z;
   bundle_in.depthFormat = spec.depth_format;
   bundle_in.blendEnabled = spec.blend;
+  bundle_in.blendAdditive = spec.additive_blend;
   bundle_in.dynamicCullMode = spec.dynamic_cull_mode;
   bundle_in.dynamicDepthWrite = spec.dynamic_depth_write;
   bundle_in.msaaSamples = spec.msaa_samples;
+  bundle_in.colorAttachmentCount = spec.color_attachment_count;
   bundle_in.vertexModule = vert_mod;
   bundle_in.fragmentModule = frag_mod;
   bundle_in.reflection = &reflection;
   bundle_in.vertexBindings = spec.vertex_bindings;
   bundle_in.vertexAttributes = spec.vertex_attributes;
   bundle_in.existingRenderPass = spec.existing_renderpass;
+  bundle_in.dynamicRendering = m_dynamic_rendering;
+  if (m_dynamic_rendering)
+  {
+    assert((spec.color_attachment_count == 1 || spec.aux_color_format != vk::Format::eUndefined)
+      && "dynamic rendering with aux color attachments needs spec.aux_color_format");
+    bundle_in.colorAttachmentFormats.assign(1, swapchain_format);
+    bundle_in.colorAttachmentFormats.resize(spec.color_attachment_count, spec.aux_color_format);
+  }
 
   auto bundle_out = create_graphics_pipeline(bundle_in, debug);
   m_pipeline = bundle_out.pipeline;
   m_layout = bundle_out.layout;
   m_renderpass = bundle_out.renderpass;
-  m_owns_renderpass = !spec.existing_renderpass;
+  m_owns_renderpass = !spec.existing_renderpass && !m_dynamic_rendering;
   m_descriptor_layouts = std::move(bundle_out.descriptorSetLayouts);
 
   // Destroy shader modules (no longer needed after pipeline creation)
@@ -117,7 +146,7 @@ ExecutionGroup::ExecutionGroup(
   d.destroyShaderModule(frag_mod);
 
   // Default clear values (attachment order matches render pass)
-  // No MSAA: [color, depth]
+  // No MSAA: [color, depth(, aux color)]; depth clears to the far plane
   // MSAA:    [msaa_color, depth, resolve]
   {
     const bool msaa = m_msaa_samples != vk::SampleCountFlagBits::e1;
@@ -128,9 +157,11 @@ ExecutionGroup::ExecutionGroup(
 
     m_clear_values[0].color = std::array<float, 4>{ 0.1f, 0.1f, 0.1f, 1.0f };
     if (m_depth_enabled)
-      m_clear_values[1].depthStencil = vk::ClearDepthStencilValue{ 1.0f, 0 };
+      m_clear_values[1].depthStencil = vk::ClearDepthStencilValue{ spec.reversed_z ? 0.0f : 1.0f, 0 };
     if (msaa)
       m_clear_values[n - 1].color = std::array<float, 4>{ 0.0f, 0.0f, 0.0f, 1.0f };
+    for (uint32_t c = 1; c < spec.color_attachment_count; ++c)
+      m_clear_values.emplace_back().color = std::array<float, 4>{ 0.0f, 0.0f, 0.0f, 0.0f };
   }
 
   spdlog::debug("ExecutionGroup '{}': pipeline created, {} auto-buffered bindings",
@@ -140,18 +171,23 @@ ExecutionGroup::ExecutionGroup(
 ExecutionGroup::~ExecutionGroup()
 {
   // Frame resources must be destroyed before pipeline state,
-  // because framebuffers reference the renderpass.
+  // because framebuffers reference the renderpass. Both are deferred, and the
+  // deletion queue runs entries in push order.
   destroy_frame_resources();
 
-  auto d = m_device.device();
-  if (m_pipeline)
-    d.destroyPipeline(m_pipeline);
-  if (m_layout)
-    d.destroyPipelineLayout(m_layout);
-  if (m_renderpass && m_owns_renderpass)
-    d.destroyRenderPass(m_renderpass);
-  for (auto layout : m_descriptor_layouts)
-    d.destroyDescriptorSetLayout(layout);
+  m_device.deletion_queue().push(
+    [d = m_device.device(), pipeline = m_pipeline, layout = m_layout,
+      renderpass = m_owns_renderpass ? m_renderpass : vk::RenderPass{},
+      set_layouts = m_descriptor_layouts] {
+      if (pipeline)
+        d.destroyPipeline(pipeline);
+      if (layout)
+        d.destroyPipelineLayout(layout);
+      if (renderpass)
+        d.destroyRenderPass(renderpass);
+      for (auto set_layout : set_layouts)
+        d.destroyDescriptorSetLayout(set_layout);
+    });
 }
 
 void ExecutionGroup::set_clear_values(std::vector<vk::ClearValue> values)
@@ -178,12 +214,28 @@ void ExecutionGroup::set_depth_attachment(
   m_depth_handle = handle;
 }
 
+void ExecutionGroup::set_aux_color_attachment(
+  const FrameResourcePool& pool, FrameResourcePool::ColorHandle handle)
+{
+  assert(m_msaa_samples == vk::SampleCountFlagBits::e1
+    && "aux color attachments are single-sample only");
+  m_aux_color_pool = &pool;
+  m_aux_color_handle = handle;
+}
+
 void ExecutionGroup::create_frame_resources(
   const Swapchain& swapchain, uint32_t count)
 {
   // Base class creates command pools/buffers, present semaphores, timeline tracking
   SubmissionGroup::create_frame_resources(swapchain, count);
 
+  // Dynamic rendering transitions the attachments itself, so it needs the
+  // images behind the views.
+  assert((!m_dynamic_rendering || m_color_views.empty())
+    && "dynamic rendering needs swapchain or pool color attachments");
+  m_present_target = true;
+  m_color_images = swapchain.images();
+
   create_frame_resources_internal(swapchain.extent(), count,
     m_color_views.empty() ? swapchain.image_views() : m_color_views);
 }
@@ -196,14 +248,20 @@ void ExecutionGroup::create_frame_resources(vk::Extent2D extent, uint32_t count)
   // Prefer a graph-owned pool color resource (resolved per slot); fall back to
   // explicitly-set color views.
   std::vector<vk::ImageView> color_views;
+  m_present_target = false;
+  m_color_images.clear();
   if (m_color_pool)
   {
     color_views.reserve(count);
     for (uint32_t i = 0; i < count; ++i)
+    {
       color_views.push_back(m_color_pool->color_view(m_color_handle, i));
+      m_color_images.push_back(m_color_pool->color_image(m_color_handle, i));
+    }
   }
   else
   {
+    assert(!m_dynamic_rendering && "dynamic rendering needs a pool color attachment");
     color_views = m_color_views;
   }
 
@@ -237,10 +295,18 @@ void ExecutionGroup::create_frame_resources_internal(
     }
   }
 
+  // Dynamic rendering begins on the views directly — nothing size-dependent
+  // beyond the images themselves.
+  if (m_dynamic_rendering)
+  {
+    m_color_targets = color_views;
+    return;
+  }
+
   // Create framebuffers
   // Attachment order matches make_scene_renderpass():
   //   MSAA:     [msaa_color, depth, resolve]
-  //   No MSAA:  [color, depth]
+  //   No MSAA:  [color, depth(, aux color)]
   for (uint32_t i = 0; i < count; ++i)
   {
     // Per-slot depth from the pool when set, else the single owned buffer.
@@ -263,6 +329,8 @@ void ExecutionGroup::create_frame_resources_internal(
       attachments.push_back(color_views[i]);                 // attachment 0: color
       if (depth_view)
         attachments.push_back(depth_view);                   // attachment 1: depth
+      if (m_aux_color_pool)                                  // attachment 2: aux color
+        attachments.push_back(m_aux_color_pool->color_view(m_aux_color_handle, i));
     }
 
     vk::FramebufferCreateInfo fb_info{};
@@ -378,16 +446,24 @@ void ExecutionGroup::create_frame_resources_internal(
           m_device.device().updateDescriptorSets(write, {});
         }
       }
+
+      // Slot-indexed pool images: the pool may have been re-allocated (resize,
+      // MSAA change), so every create writes the current views.
+      for (auto& b : m_pool_image_bindings)
+        write_pool_image_binding(b);
     }
   }
 }
 
 void ExecutionGroup::destroy_frame_resources()
 {
-  // Destroy ExecutionGroup-specific resources first
+  // Destroy ExecutionGroup-specific resources first. The descriptor sets die
+  // with the pool; buffers and images defer through their destructors.
   if (m_descriptor_pool)
   {
-    m_device.device().destroyDescriptorPool(m_descriptor_pool);
+    m_device.deletion_queue().push([device = m_device.device(), pool = m_descriptor_pool] {
+      device.destroyDescriptorPool(pool);
+    });
     m_descriptor_pool = VK_NULL_HANDLE;
   }
   for (auto& group : m_descriptor_sets)
@@ -397,7 +473,7 @@ void ExecutionGroup::destroy_frame_resources()
   m_msaa_images.clear();
   m_depth_buffer.reset();
 
-  // Then base class destroys command pools, present semaphores, timeline tracking
+  // Then base class destroys command pools, present semaphores
   SubmissionGroup::destroy_frame_resources();
 }
 
@@ -458,19 +534,45 @@ void ExecutionGroup::write_image_descriptor(
 
 uint32_t ExecutionGroup::binding_index(uint32_t set, const std::string& name) const
 {
-  for (auto& set_info : m_reflected_sets)
+  if (set < m_binding_names.size())
   {
-    if (set_info.set != set) continue;
-    for (auto& b : set_info.bindings)
-    {
-      if (b.name == name)
-        return b.binding;
-    }
+    auto it = m_binding_names[set].find(name);
+    if (it != m_binding_names[set].end())
+      return it->second;
   }
   throw std::runtime_error(
     "Descriptor binding '" + name + "' not found in set " + std::to_string(set));
 }
 
+void ExecutionGroup::bind_pool_image(uint32_t set, const std::string& name,
+  const FrameResourcePool& pool, FrameResourcePool::ColorHandle handle,
+  vk::Sampler sampler, vk::ImageLayout layout)
+{
+  const PoolImageBinding b{ set, binding_index(set, name), &pool, handle, sampler, layout };
+  auto it = std::find_if(m_pool_image_bindings.begin(), m_pool_image_bindings.end(),
+    [&](const PoolImageBinding& o) { return o.set == b.set && o.binding == b.binding; });
+  if (it != m_pool_image_bindings.end())
+    *it = b;
+  else
+    m_pool_image_bindings.push_back(b);
+
+  if (set < m_descriptor_sets.size())
+    write_pool_image_binding(b);
+}
+
+void ExecutionGroup::write_pool_image_binding(const PoolImageBinding& b)
+{
+  if (b.set >= m_descriptor_sets.size())
+    return;
+  const auto& sets = m_descriptor_sets[b.set];
+  assert(sets.size() <= b.pool->slot_count() &&
+    "pool image binding needs one pool slot per descriptor set allocation");
+
+  for (size_t i = 0; i < sets.size(); ++i)
+    write_image_descriptor(b.set, b.binding, static_cast<uint32_t>(i),
+      b.pool->color_view(b.handle, static_cast<uint32_t>(i)), b.sampler, b.layout);
+}
+
 void ExecutionGroup::write_buffer_descriptor(
   uint32_t set, uint32_t binding, vk::Buffer buf, vk::DeviceSize size,
   vk::DescriptorType type)
@@ -500,6 +602,57 @@ void ExecutionGroup::write_buffer_descriptor(
   write_buffer_descriptor(set, binding_index(set, name), buf, size, type);
 }
 
+void ExecutionGroup::write_buffer_descriptor(
+  uint32_t set, uint32_t binding, uint32_t index,
+  vk::Buffer buf, vk::DeviceSize size, vk::DescriptorType type)
+{
+  assert(set < m_descriptor_sets.size() && "set index out of range");
+  assert(index < m_descriptor_sets[set].size() && "descriptor index out of range");
+
+  vk::DescriptorBufferInfo buffer_info{ buf, 0, size };
+
+  vk::WriteDescriptorSet write{};
+  write.dstSet = m_descriptor_sets[set][index];
+  write.dstBinding = binding;
+  write.dstArrayElement = 0;
+  write.descriptorCount = 1;
+  write.descriptorType = type;
+  write.pBufferInfo = &buffer_info;
+
+  m_device.device().updateDescriptorSets(write, {});
+}
+
+void ExecutionGroup::write_buffer_descriptor(
+  uint32_t set, const std::string& name, uint32_t index,
+  vk::Buffer buf, vk::DeviceSize size, vk::DescriptorType type)
+{
+  write_buffer_descriptor(set, binding_index(set, name), index, buf, size, type);
+}
+
+void ExecutionGroup::write_acceleration_structure(
+  uint32_t set, const std::string& name, vk::AccelerationStructureKHR tlas)
+{
+  assert(set < m_descriptor_sets.size() && "set index out of range");
+  const uint32_t binding = binding_index(set, name);
+
+  for (size_t i = 0; i < m_descriptor_sets[set].size(); ++i)
+  {
+    vk::WriteDescriptorSetAccelerationStructureKHR as_info{};
+    as_info.accelerationStructureCount = 1;
+    as_info.pAccelerationStructures = &tlas;
+
+    vk::WriteDescriptorSet write{};
+    write.pNext = &as_info;
+    write.dstSet = m_descriptor_sets[set][i];
+    write.dstBinding = binding;
+    write.dstArrayElement = 0;
+    write.descriptorCount = 1;
+    write.descriptorType = vk::DescriptorType::eAccelerationStructureKHR;
+
+    m_device.device().updateDescriptorSets(write, {});
+  }
+}
+
 void ExecutionGroup::write_image_descriptor(
   uint32_t set, const std::string& name,
   vk::ImageView view, vk::Sampler sampler, vk::ImageLayout layout)
@@ -517,6 +670,20 @@ void ExecutionGroup::write_image_descriptor(
 void ExecutionGroup::record_commands(
   vk::CommandBuffer cmd, uint32_t slot_index, FrameResources& frame)
 {
+  if (!m_render_pass_enabled)
+  {
+    m_record_fn(cmd, slot_index);
+    return;
+  }
+
+  if (m_dynamic_rendering)
+  {
+    begin_rendering(cmd, slot_index, m_load_attachments);
+    m_record_fn(cmd, slot_index);
+    end_rendering(cmd, slot_index);
+    return;
+  }
+
   // Begin render pass
   vk::RenderPassBeginInfo rp_info{};
   rp_info.renderPass = m_renderpass;
@@ -533,6 +700,192 @@ void ExecutionGroup::record_commands(
   cmd.endRenderPass();
 }
 
+void ExecutionGroup::begin_renderpass(
+  vk::CommandBuffer cmd, uint32_t slot, vk::RenderPass renderpass) const
+{
+  assert(slot < m_frames.size() && "begin_renderpass() before create_frame_resources()");
+  if (m_dynamic_rendering)
+  {
+    begin_rendering(cmd, slot, true);
+    return;
+  }
+
+  vk::RenderPassBeginInfo rp_info{};
+  rp_info.renderPass = renderpass;
+  rp_info.framebuffer = m_frames[slot].framebuffer;
+  rp_info.renderArea.extent = m_extent;
+
+  cmd.beginRenderPass(rp_info, vk::SubpassContents::eInline);
+}
+
+void ExecutionGroup::end_renderpass(vk::CommandBuffer cmd, uint32_t slot) const
+{
+  if (m_dynamic_rendering)
+    end_rendering(cmd, slot);
+  else
+    cmd.endRenderPass();
+}
+
+void ExecutionGroup::begin_rendering(vk::CommandBuffer cmd, uint32_t slot, bool load) const
+{
+  assert(slot < m_color_targets.size() && "begin_rendering() before create_frame_resources()");
+  const bool msaa = m_msaa_samples != vk::SampleCountFlagBits::e1;
+  const vk::ImageSubresourceRange color1{ vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1 };
+
+  // Previous readers of the attachments are earlier submissions (sampling,
+  // compute, copies) — an execution dependency covers the write-after-read. A
+  // LOAD also waits for the color writes of the pass that produced them.
+  const vk::ImageLayout kept_color = m_present_target
+    ? vk::ImageLayout::ePresentSrcKHR : vk::ImageLayout::eShaderReadOnlyOptimal;
+  std::vector<vk::ImageMemoryBarrier> barriers;
+  auto color_barrier = [&](vk::Image image, vk::ImageLayout kept) {
+    vk::ImageMemoryBarrier b{};
+    b.srcAccessMask = load ? vk::AccessFlagBits::eColorAttachmentWrite : vk::AccessFlags{};
+    b.dstAccessMask = vk::AccessFlagBits::eColorAttachmentWrite
+      | (load ? vk::AccessFlagBits::eColorAttachmentRead : vk::AccessFlags{});
+    b.oldLayout = load ? kept : vk::ImageLayout::eUndefined;
+    b.newLayout = vk::ImageLayout::eColorAttachmentOptimal;
+    b.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    b.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    b.image = image;
+    b.subresourceRange = color1;
+    barriers.push_back(b);
+  };
+  color_barrier(m_color_images[slot], kept_color);
+  if (msaa) // never leaves the attachment layout
+    color_barrier(m_msaa_images[slot].image(), vk::ImageLayout::eColorAttachmentOptimal);
+  if (m_aux_color_pool)
+    color_barrier(m_aux_color_pool->color_image(m_aux_color_handle, slot),
+      vk::ImageLayout::eShaderReadOnlyOptimal);
+
+  // Depth: cleared from Undefined, or kept in eDepthStencilAttachmentOptimal.
+  const bool load_depth = load || m_load_depth;
+  vk::ImageView depth_view = VK_NULL_HANDLE;
+  if (m_depth_enabled)
+  {
+    vk::Image depth_image;
+    if (m_depth_pool)
+    {
+      depth_view = m_depth_pool->depth_view(m_depth_handle, slot);
+      depth_image = m_depth_pool->depth_image(m_depth_handle, slot);
+    }
+    else
+    {
+      depth_view = m_depth_buffer->combined_view();
+      depth_image = m_depth_buffer->image();
+    }
+
+    vk::ImageMemoryBarrier b{};
+    b.srcAccessMask = load_depth ? vk::AccessFlagBits::eDepthStencilAttachmentWrite : vk::AccessFlags{};
+    b.dstAccessMask = vk::AccessFlagBits::eDepthStencilAttachmentRead
+      | vk::AccessFlagBits::eDepthStencilAttachmentWrite;
+    b.oldLayout = load_depth ? vk::ImageLayout::eDepthStencilAttachmentOptimal : vk::ImageLayout::eUndefined;
+    b.newLayout = vk::ImageLayout::eDepthStencilAttachmentOptimal;
+    b.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    b.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    b.image = depth_image;
+    b.subresourceRange = { vk::ImageAspectFlagBits::eDepth, 0, 1, 0, 1 };
+    if (format_has_stencil(m_depth_format))
+      b.subresourceRange.aspectMask |= vk::ImageAspectFlagBits::eStencil;
+    barriers.push_back(b);
+  }
+
+  cmd.pipelineBarrier(
+    vk::PipelineStageFlagBits::eColorAttachmentOutput | vk::PipelineStageFlagBits::eEarlyFragmentTests
+      | vk::PipelineStageFlagBits::eLateFragmentTests | vk::PipelineStageFlagBits::eFragmentShader
+      | vk::PipelineStageFlagBits::eComputeShader | vk::PipelineStageFlagBits::eTransfer,
+    vk::PipelineStageFlagBits::eColorAttachmentOutput | vk::PipelineStageFlagBits::eEarlyFragmentTests
+      | vk::PipelineStageFlagBits::eLateFragmentTests,
+    {}, {}, {}, barriers);
+
+  // Clear values keep the render-pass order (see the constructor):
+  //   [color, depth, resolve (MSAA), aux colors...]
+  const vk::AttachmentLoadOp load_op = load ? vk::AttachmentLoadOp::eLoad : vk::AttachmentLoadOp::eClear;
+  const uint32_t aux_clear = 1 + (m_depth_enabled ? 1 : 0) + (msaa ? 1 : 0);
+
+  std::vector<vk::RenderingAttachmentInfoKHR> colors(1);
+  colors[0].imageLayout = vk::ImageLayout::eColorAttachmentOptimal;
+  colors[0].loadOp = load_op;
+  colors[0].storeOp = vk::AttachmentStoreOp::eStore;
+  colors[0].clearValue = m_clear_values[0];
+  if (msaa)
+  {
+    colors[0].imageView = m_msaa_images[slot].image_view();
+    colors[0].storeOp = vk::AttachmentStoreOp::eDontCare;
+    colors[0].resolveMode = vk::ResolveModeFlagBits::eAverage;
+    colors[0].resolveImageView = m_color_targets[slot];
+    colors[0].resolveImageLayout = vk::ImageLayout::eColorAttachmentOptimal;
+  }
+  else
+  {
+    colors[0].imageView = m_color_targets[slot];
+  }
+  if (m_aux_color_pool)
+  {
+    auto& aux = colors.emplace_back();
+    aux.imageView = m_aux_color_pool->color_view(m_aux_color_handle, slot);
+    aux.imageLayout = vk::ImageLayout::eColorAttachmentOptimal;
+    aux.loadOp = load_op;
+    aux.storeOp = vk::AttachmentStoreOp::eStore;
+    if (aux_clear < m_clear_values.size())
+      aux.clearValue = m_clear_values[aux_clear];
+  }
+
+  vk::RenderingAttachmentInfoKHR depth{};
+  depth.imageView = depth_view;
+  depth.imageLayout = vk::ImageLayout::eDepthStencilAttachmentOptimal;
+  depth.loadOp = load_depth ? vk::AttachmentLoadOp::eLoad : vk::AttachmentLoadOp::eClear;
+  depth.storeOp = m_store_depth ? vk::AttachmentStoreOp::eStore : vk::AttachmentStoreOp::eDontCare;
+  if (m_depth_enabled)
+    depth.clearValue = m_clear_values[1];
+
+  vk::RenderingInfoKHR info{};
+  info.renderArea.extent = m_extent;
+  info.layerCount = 1;
+  info.colorAttachmentCount = static_cast<uint32_t>(colors.size());
+  info.pColorAttachments = colors.data();
+  if (m_depth_enabled)
+  {
+    info.pDepthAttachment = &depth;
+    if (format_has_stencil(m_depth_format))
+      info.pStencilAttachment = &depth;
+  }
+  cmd.beginRenderingKHR(info);
+}
+
+void ExecutionGroup::end_rendering(vk::CommandBuffer cmd, uint32_t slot) const
+{
+  cmd.endRenderingKHR();
+
+  // Colors -> sampled by later passes / compute, or presented. Depth stays in
+  // eDepthStencilAttachmentOptimal like after the render passes.
+  const vk::ImageSubresourceRange color1{ vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1 };
+  std::vector<vk::ImageMemoryBarrier> barriers;
+  auto color_barrier = [&](vk::Image image, vk::ImageLayout layout) {
+    vk::ImageMemoryBarrier b{};
+    b.srcAccessMask = vk::AccessFlagBits::eColorAttachmentWrite;
+    b.dstAccessMask = m_present_target ? vk::AccessFlags{} : vk::AccessFlagBits::eShaderRead;
+    b.oldLayout = vk::ImageLayout::eColorAttachmentOptimal;
+    b.newLayout = layout;
+    b.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    b.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    b.image = image;
+    b.subresourceRange = color1;
+    barriers.push_back(b);
+  };
+  color_barrier(m_color_images[slot], m_present_target
+    ? vk::ImageLayout::ePresentSrcKHR : vk::ImageLayout::eShaderReadOnlyOptimal);
+  if (m_aux_color_pool)
+    color_barrier(m_aux_color_pool->color_image(m_aux_color_handle, slot),
+      vk::ImageLayout::eShaderReadOnlyOptimal);
+
+  cmd.pipelineBarrier(vk::PipelineStageFlagBits::eColorAttachmentOutput,
+    m_present_target
+      ? vk::PipelineStageFlags(vk::PipelineStageFlagBits::eBottomOfPipe)
+      : vk::PipelineStageFlagBits::eFragmentShader | vk::PipelineStageFlagBits::eComputeShader,
+    {}, {}, {}, barriers);
+}
+
 Buffer& ExecutionGroup::buffer(BufferHandle handle)
 {
   assert(handle < m_buffers.size() && "invalid BufferHandle");
@@ -13,6 +13,7 @@
 #include <map>
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -56,6 +57,20 @@ class ExecutionGroup : public SubmissionGroup
   vk::SampleCountFlagBits m_msaa_samples{ vk::SampleCountFlagBits::e1 };
   vk::Format m_color_format{}; // format of offscreen color images (for MSAA)
 
+  // Dynamic rendering (PipelineSpec::dynamic_rendering on a supporting device):
+  // no render pass or framebuffers. record_commands() begins rendering on the
+  // slot's attachments and performs the layout transitions a render pass
+  // would: color/aux end eShaderReadOnlyOptimal (ePresentSrcKHR for the
+  // swapchain), depth stays eDepthStencilAttachmentOptimal.
+  bool m_dynamic_rendering{ false };
+  bool m_load_attachments{ false };
+  bool m_load_depth{ false };
+  bool m_store_depth{ false };
+  bool m_present_target{ false };
+  bool m_render_pass_enabled{ true };
+  std::vector<vk::Image> m_color_images;      // [slot] color (MSAA: resolve) images
+  std::vector<vk::ImageView> m_color_targets; // [slot] matching views
+
   // Reflected descriptor set info (stored at construction for auto-creating UBOs)
   std::vector<DescriptorSetInfo> m_reflected_sets;
 
@@ -72,6 +87,22 @@ class ExecutionGroup : public SubmissionGroup
   // Map from (set, binding) -> BufferHandle for reflected UBOs/SSBOs
   std::map<std::pair<uint32_t, uint32_t>, BufferHandle> m_binding_to_handle;
 
+  // GLSL name -> binding per set index, built once from reflection so that
+  // binding_index() is a hash lookup rather than a scan of m_reflected_sets.
+  std::vector<std::unordered_map<std::string, uint32_t>> m_binding_names; // [set]
+
+  // Slot-indexed pool image bindings (bind_pool_image()): allocation i of the
+  // set samples slot i of the pool resource.
+  struct PoolImageBinding {
+    uint32_t set;
+    uint32_t binding;
+    const FrameResourcePool* pool;
+    FrameResourcePool::ColorHandle handle;
+    vk::Sampler sampler;
+    vk::ImageLayout layout;
+  };
+  std::vector<PoolImageBinding> m_pool_image_bindings;
+
   // Descriptor set management
   // Per-set allocation counts: m_set_counts[set_index] = how many descriptor sets
   // to allocate. Default: all sets get `count` (ring-buffered). Override via
@@ -93,6 +124,11 @@ class ExecutionGroup : public SubmissionGroup
   const FrameResourcePool* m_depth_pool{ nullptr };
   FrameResourcePool::DepthHandle m_depth_handle{ 0 };
 
+  // Extra pool color attachment after the depth (e.g. motion vectors), single
+  // sample only. Requires spec.color_attachment_count == 2.
+  const FrameResourcePool* m_aux_color_pool{ nullptr };
+  FrameResourcePool::ColorHandle m_aux_color_handle{ 0 };
+
   // Clear values for render pass begin
   std::vector<vk::ClearValue> m_clear_values;
 
@@ -104,6 +140,16 @@ class ExecutionGroup : public SubmissionGroup
     vk::Extent2D extent, uint32_t count,
     const std::vector<vk::ImageView>& color_views);
 
+  // Write one pool image binding to every allocation of its set.
+  void write_pool_image_binding(const PoolImageBinding& b);
+
+  // Dynamic rendering: transition the slot's attachments and begin rendering
+  // (clearing, or LOADing everything when `load`; the depth alone with
+  // PipelineSpec::load_depth); end_rendering() ends it and
+  // transitions the colors for sampling / present.
+  void begin_rendering(vk::CommandBuffer cmd, uint32_t slot, bool load) const;
+  void end_rendering(vk::CommandBuffer cmd, uint32_t slot) const;
+
 protected:
   /// Record render pass begin, user commands, render pass end.
   void record_commands(vk::CommandBuffer cmd, uint32_t slot_index,
@@ -121,9 +167,16 @@ public:
   ExecutionGroup& operator=(const ExecutionGroup&) = delete;
 
   /// Set clear values for the render pass begin.
-  /// Default: dark gray color clear + depth 1.0.
+  /// Default: dark gray color clear + the far depth (0 with spec.reversed_z).
   void set_clear_values(std::vector<vk::ClearValue> values);
 
+  /// With `enabled` false, record_fn runs outside any render pass: the
+  /// pipeline and attachments go unused and record_fn owns the color target's
+  /// layout — for a present group it must leave the image in ePresentSrcKHR
+  /// (e.g. a compute pass writing the swapchain as a storage image).
+  void set_render_pass_enabled(bool enabled) { m_render_pass_enabled = enabled; }
+  [[nodiscard]] bool render_pass_enabled() const { return m_render_pass_enabled; }
+
   /// Set offscreen color views (used instead of swapchain views for framebuffers).
   /// Call before create_frame_resources().
   void set_color_views(std::vector<vk::ImageView> views);
@@ -141,16 +194,22 @@ public:
   void set_depth_attachment(const FrameResourcePool& pool,
                             FrameResourcePool::DepthHandle handle);
 
+  /// Use a graph-owned pool color resource as a second color attachment
+  /// (fragment output location 1), appended after the depth. Single-sample
+  /// only; the render pass must declare it (see make_scene_renderpass()).
+  void set_aux_color_attachment(const FrameResourcePool& pool,
+                                FrameResourcePool::ColorHandle handle);
+
   /// Create/recreate size-dependent resources (framebuffers, depth buffer, UBOs, descriptors).
   void create_frame_resources(const Swapchain& swapchain, uint32_t count) override;
 
   /// Create frame resources for offscreen groups (no swapchain needed).
-  void create_frame_resources(vk::Extent2D extent, uint32_t count);
+  void create_frame_resources(vk::Extent2D extent, uint32_t count) override;
 
   void destroy_frame_resources() override;
 
-  /// Look up a descriptor binding index by GLSL variable name.
-  /// Throws if the name is not found in the reflected set.
+  /// Look up a descriptor binding index by GLSL variable name (hashed, built
+  /// at construction). Throws if the name is not found in the reflected set.
   [[nodiscard]] uint32_t binding_index(uint32_t set, const std::string& name) const;
 
   /// Override the allocation count for a specific descriptor set index.
@@ -178,6 +237,18 @@ public:
                               vk::ImageView view, vk::Sampler sampler,
                               vk::ImageLayout layout = vk::ImageLayout::eShaderReadOnlyOptimal);
 
+  /// Bind a graph-owned pool color resource to a combined image sampler slot by
+  /// slot: allocation i of `set` samples the resource's slot-i view, so record
+  /// callbacks never rebind it. Written at every create_frame_resources() (so
+  /// it follows pool re-allocation) and immediately when frame resources
+  /// already exist; binding the same (set, name) again replaces it. The set's
+  /// allocation count must not exceed the pool's slot count — true for the
+  /// default ring depth of offscreen groups, whose slot is the pool slot.
+  void bind_pool_image(uint32_t set, const std::string& name,
+                       const FrameResourcePool& pool,
+                       FrameResourcePool::ColorHandle handle, vk::Sampler sampler,
+                       vk::ImageLayout layout = vk::ImageLayout::eShaderReadOnlyOptimal);
+
   /// Write a buffer (UBO/SSBO) to all allocations of a set, by binding index.
   /// For manually-managed buffers (e.g. the immutable per-material SSBO) that
   /// are not ring-buffered through the auto-buffer machinery.
@@ -190,6 +261,35 @@ public:
                                vk::Buffer buffer, vk::DeviceSize size,
                                vk::DescriptorType type = vk::DescriptorType::eStorageBuffer);
 
+  /// Write a buffer to one allocation of a set, by binding index. For
+  /// manually-managed per-slot buffers (e.g. the clustered light lists).
+  void write_buffer_descriptor(uint32_t set, uint32_t binding, uint32_t index,
+                               vk::Buffer buffer, vk::DeviceSize size,
+                               vk::DescriptorType type = vk::DescriptorType::eStorageBuffer);
+
+  /// Write a buffer to one allocation of a set, by GLSL name.
+  void write_buffer_descriptor(uint32_t set, const std::string& name, uint32_t index,
+                               vk::Buffer buffer, vk::DeviceSize size,
+                               vk::DescriptorType type = vk::DescriptorType::eStorageBuffer);
+
+  /// Write an acceleration structure (e.g. a TLAS for ray queries) to all
+  /// allocations of a set, by GLSL name.
+  void write_acceleration_structure(uint32_t set, const std::string& name,
+                                    vk::AccelerationStructureKHR tlas);
+
+  /// Begin `renderpass` on this group's framebuffer for `slot`, from a
+  /// post-record hook — resumes drawing into the group's attachments after
+  /// work that cannot run inside a render pass (e.g. compute between two
+  /// geometry phases). `renderpass` must be compatible with renderpass() and
+  /// LOAD every attachment (no clear values are supplied). With dynamic
+  /// rendering `renderpass` is unused: every attachment is LOADed. Close it
+  /// with end_renderpass().
+  void begin_renderpass(vk::CommandBuffer cmd, uint32_t slot,
+                        vk::RenderPass renderpass) const;
+
+  /// End a begin_renderpass() pass.
+  void end_renderpass(vk::CommandBuffer cmd, uint32_t slot) const;
+
   /// Get the UBO/SSBO buffer for a given (set, binding) at the current slot.
   /// Valid inside the record callback after begin_frame().
   Buffer& ubo(uint32_t set, uint32_t binding);
@@ -208,7 +308,9 @@ public:
 
   [[nodiscard]] vk::Pipeline pipeline() const { return m_pipeline; }
   [[nodiscard]] vk::PipelineLayout layout() const { return m_layout; }
+  /// The render pass, or VK_NULL_HANDLE with dynamic rendering.
   [[nodiscard]] vk::RenderPass renderpass() const { return m_renderpass; }
+  [[nodiscard]] bool dynamic_rendering() const { return m_dynamic_rendering; }
 };
 
 } // namespace vkwave
@@ -13,9 +13,9 @@ namespace vkwave
 
 FrameResourcePool::ColorHandle FrameResourcePool::add_color(
   std::string name, vk::Format format, vk::ImageUsageFlags usage,
-  vk::SampleCountFlagBits samples, bool full_mips)
+  vk::SampleCountFlagBits samples, bool full_mips, bool compute_shared)
 {
-  m_color_specs.push_back({ std::move(name), format, usage, samples, full_mips });
+  m_color_specs.push_back({ std::move(name), format, usage, samples, full_mips, compute_shared });
   return static_cast<ColorHandle>(m_color_specs.size() - 1);
 }
 
@@ -28,10 +28,11 @@ FrameResourcePool::DepthHandle FrameResourcePool::add_depth(
 }
 
 void FrameResourcePool::create(
-  const Device& device, vk::Extent2D extent, uint32_t count)
+  const Device& device, vk::Extent2D extent, uint32_t count, uint32_t layers)
 {
   m_extent = extent;
   m_count = count;
+  m_layers = layers;
 
   m_color.clear();
   m_color.resize(m_color_specs.size());
@@ -45,7 +46,7 @@ void FrameResourcePool::create(
     m_color[h].reserve(count);
     for (uint32_t i = 0; i < count; ++i)
       m_color[h].emplace_back(device, spec.format, extent, spec.usage,
-        fmt::format("{}_{}", spec.name, i), spec.samples, mips);
+        fmt::format("{}_{}", spec.name, i), spec.samples, mips, layers, spec.compute_shared);
   }
 
   m_depth.clear();
@@ -56,14 +57,14 @@ void FrameResourcePool::create(
     m_depth[h].reserve(count);
     for (uint32_t i = 0; i < count; ++i)
       m_depth[h].emplace_back(device, spec.format, extent, spec.samples,
-        spec.extra_usage);
+        spec.extra_usage, layers);
   }
 }
 
 void FrameResourcePool::recreate(const Device& device)
 {
   if (m_count > 0)
-    create(device, m_extent, m_count);
+    create(device, m_extent, m_count, m_layers);
 }
 
 void FrameResourcePool::set_depth_samples(
@@ -118,6 +119,18 @@ vk::ImageView FrameResourcePool::depth_view(DepthHandle handle, uint32_t slot) c
   return m_depth[handle][slot].combined_view();
 }
 
+vk::ImageView FrameResourcePool::depth_sample_view(DepthHandle handle, uint32_t slot) const
+{
+  assert(handle < m_depth.size() && slot < m_depth[handle].size());
+  return m_depth[handle][slot].depth_view();
+}
+
+vk::Image FrameResourcePool::depth_image(DepthHandle handle, uint32_t slot) const
+{
+  assert(handle < m_depth.size() && slot < m_depth[handle].size());
+  return m_depth[handle][slot].image();
+}
+
 vk::Format FrameResourcePool::depth_format(DepthHandle handle) const
 {
   assert(handle < m_depth_specs.size());
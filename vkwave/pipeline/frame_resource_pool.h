@@ -47,10 +47,12 @@ public:
   /// @param full_mips allocate a full mip chain (for roughness-blurred sampling,
   ///                  e.g. the transmission snapshot). Mip count is derived from
   ///                  the extent at create()/recreate() time.
+  /// @param compute_shared also accessed by a group on the async compute queue
+  ///                  (see Image).
   ColorHandle add_color(std::string name, vk::Format format,
     vk::ImageUsageFlags usage,
     vk::SampleCountFlagBits samples = vk::SampleCountFlagBits::e1,
-    bool full_mips = false);
+    bool full_mips = false, bool compute_shared = false);
 
   /// Register a per-slot depth(-stencil) attachment.
   DepthHandle add_depth(std::string name, vk::Format format,
@@ -58,18 +60,22 @@ public:
     vk::ImageUsageFlags extra_usage = {});
 
   /// (Re)create all registered resources at the given extent and slot count.
-  void create(const Device& device, vk::Extent2D extent, uint32_t count);
+  /// @param layers array layers per resource (> 1 for a multiview pass, one
+  ///               layer per view; views then span every layer).
+  void create(const Device& device, vk::Extent2D extent, uint32_t count,
+    uint32_t layers = 1);
 
   /// Re-allocate all resources at the current extent/slot count — e.g. after a
-  /// depth sample-count change. The GPU must be idle. No-op before create().
+  /// depth sample-count change. No-op before create().
   void recreate(const Device& device);
 
   /// Update a depth resource's MSAA sample count (must match the consuming
   /// group's MSAA). Takes effect on the next create()/recreate().
   void set_depth_samples(DepthHandle handle, vk::SampleCountFlagBits samples);
 
-  /// Destroy all per-slot resources. Registration (specs/handles) is retained
-  /// so a subsequent create() re-allocates the same set.
+  /// Destroy all per-slot resources (deferred past the frames in flight by the
+  /// images themselves). Registration (specs/handles) is retained so a
+  /// subsequent create() re-allocates the same set.
   void destroy();
 
   /// Destroy resources AND drop all registrations (specs/handles). Use when the
@@ -85,10 +91,15 @@ public:
 
   /// Depth attachment view (combined depth+stencil aspect, for framebuffers).
   [[nodiscard]] vk::ImageView depth_view(DepthHandle handle, uint32_t slot) const;
+  /// Depth-aspect-only view, for sampling the depth in a shader (e.g. building
+  /// a hierarchical-Z pyramid). Single-sample depth only.
+  [[nodiscard]] vk::ImageView depth_sample_view(DepthHandle handle, uint32_t slot) const;
+  [[nodiscard]] vk::Image depth_image(DepthHandle handle, uint32_t slot) const;
   [[nodiscard]] vk::Format depth_format(DepthHandle handle) const;
 
   [[nodiscard]] vk::Extent2D extent() const { return m_extent; }
   [[nodiscard]] uint32_t slot_count() const { return m_count; }
+  [[nodiscard]] uint32_t layer_count() const { return m_layers; }
 
 private:
   struct ColorSpec
@@ -98,6 +109,7 @@ private:
     vk::ImageUsageFlags usage;
     vk::SampleCountFlagBits samples;
     bool full_mips;
+    bool compute_shared;
   };
   struct DepthSpec
   {
@@ -115,6 +127,7 @@ private:
 
   vk::Extent2D m_extent{};
   uint32_t m_count{ 0 };
+  uint32_t m_layers{ 1 };
 };
 
 } // namespace vkwave
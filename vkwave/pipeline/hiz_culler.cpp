@@ -0,0 +1,483 @@
+#include <vkwave/pipeline/hiz_culler.h>
+
+#include <vkwave/config.h>
+#include <vkwave/core/deletion_queue.h>
+#include <vkwave/core/device.h>
+#include <vkwave/core/hiz_cull.h>
+#include <vkwave/loaders/gltf_loader.h>
+
+#include <spdlog/fmt/fmt.h>
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+
+namespace vkwave
+{
+
+namespace
+{
+
+constexpr uint32_t kBuildLocalSize = 8;  // hiz_build.comp: 8x8
+constexpr uint32_t kCullLocalSize = 64;  // hiz_cull.comp: 64x1
+
+// Shader writes -> shader reads between consecutive compute dispatches.
+void compute_to_compute_barrier(vk::CommandBuffer cmd)
+{
+  vk::MemoryBarrier barrier{};
+  barrier.srcAccessMask = vk::AccessFlagBits::eShaderWrite;
+  barrier.dstAccessMask = vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite;
+  cmd.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader,
+    vk::PipelineStageFlagBits::eComputeShader, {}, barrier, {}, {});
+}
+
+// Cull output -> vkCmdDrawIndexedIndirect parameter fetch.
+void compute_to_indirect_barrier(vk::CommandBuffer cmd)
+{
+  vk::MemoryBarrier barrier{};
+  barrier.srcAccessMask = vk::AccessFlagBits::eShaderWrite;
+  barrier.dstAccessMask = vk::AccessFlagBits::eIndirectCommandRead;
+  cmd.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader,
+    vk::PipelineStageFlagBits::eDrawIndirect, {}, barrier, {}, {});
+}
+
+void transition_depth(vk::CommandBuffer cmd, vk::Image image,
+  vk::ImageLayout old_layout, vk::ImageLayout new_layout,
+  vk::PipelineStageFlags src_stage, vk::PipelineStageFlags dst_stage,
+  vk::AccessFlags src_access, vk::AccessFlags dst_access)
+{
+  vk::ImageMemoryBarrier barrier{};
+  barrier.oldLayout = old_layout;
+  barrier.newLayout = new_layout;
+  barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.image = image;
+  barrier.subresourceRange = { vk::ImageAspectFlagBits::eDepth, 0, 1, 0, 1 };
+  barrier.srcAccessMask = src_access;
+  barrier.dstAccessMask = dst_access;
+  cmd.pipelineBarrier(src_stage, dst_stage, {}, {}, {}, barrier);
+}
+
+vk::Extent2D pyramid_base_extent(vk::Extent2D depth_extent)
+{
+  return { std::max(depth_extent.width / 2, 1u), std::max(depth_extent.height / 2, 1u) };
+}
+
+vk::Extent2D mip_extent(vk::Extent2D base, uint32_t mip)
+{
+  return { std::max(base.width >> mip, 1u), std::max(base.height >> mip, 1u) };
+}
+
+} // namespace
+
+HiZCuller::HiZCuller(const Device& device, bool debug)
+  : m_device(device)
+{
+  m_build = std::make_unique<ComputePipeline>(device, SHADER_DIR "hiz_build.comp", debug);
+  m_cull = std::make_unique<ComputePipeline>(device, SHADER_DIR "hiz_cull.comp", debug);
+
+  // Point sampling only: both shaders use texelFetch with explicit levels.
+  vk::SamplerCreateInfo info{};
+  info.magFilter = vk::Filter::eNearest;
+  info.minFilter = vk::Filter::eNearest;
+  info.mipmapMode = vk::SamplerMipmapMode::eNearest;
+  info.addressModeU = vk::SamplerAddressMode::eClampToEdge;
+  info.addressModeV = vk::SamplerAddressMode::eClampToEdge;
+  info.addressModeW = vk::SamplerAddressMode::eClampToEdge;
+  info.maxLod = VK_LOD_CLAMP_NONE;
+  m_sampler = device.device().createSampler(info);
+}
+
+HiZCuller::~HiZCuller()
+{
+  destroy_frame_resources();
+  if (m_sampler)
+    m_device.deletion_queue().push([dev = m_device.device(), sampler = m_sampler] {
+      dev.destroySampler(sampler);
+    });
+}
+
+uint32_t HiZCuller::pyramid_mip_count(vk::Extent2D depth_extent)
+{
+  const auto base = pyramid_base_extent(depth_extent);
+  return static_cast<uint32_t>(
+    std::floor(std::log2(std::max(base.width, base.height)))) + 1;
+}
+
+void HiZCuller::set_primitives(std::span<const ScenePrimitive> primitives)
+{
+  std::vector<HiZCullPrimitive> gpu;
+  gpu.reserve(primitives.size());
+  for (auto& prim : primitives)
+  {
+    // World-space AABB of the transformed object-space box. Empty primitives
+    // collapse to their origin (they draw nothing either way).
+    AABB world;
+    if (!prim.bounds.valid())
+      world.expand(glm::vec3(prim.modelMatrix[3]));
+    for (int c = 0; c < 8 && prim.bounds.valid(); ++c)
+    {
+      glm::vec3 corner(
+        (c & 1) ? prim.bounds.max.x : prim.bounds.min.x,
+        (c & 2) ? prim.bounds.max.y : prim.bounds.min.y,
+        (c & 4) ? prim.bounds.max.z : prim.bounds.min.z);
+      world.expand(glm::vec3(prim.modelMatrix * glm::vec4(corner, 1.0f)));
+    }
+
+    HiZCullPrimitive p{};
+    p.boundsMin = glm::vec4(world.min, 0.0f);
+    p.boundsMax = glm::vec4(world.max, 0.0f);
+    p.indexCount = prim.indexCount;
+    p.firstIndex = prim.firstIndex;
+    p.vertexOffset = prim.vertexOffset;
+    gpu.push_back(p);
+  }
+
+  m_primitive_count = static_cast<uint32_t>(gpu.size());
+  m_primitive_buffer.reset();
+  if (m_primitive_count > 0)
+  {
+    m_primitive_buffer = Buffer::create_device_local(m_device, "hiz_primitives",
+      gpu.data(), gpu.size() * sizeof(HiZCullPrimitive),
+      vk::BufferUsageFlagBits::eStorageBuffer);
+  }
+
+  reset_history();
+
+  // Fresh sets rather than rewriting the ones frames in flight may still
+  // use: the new draw/visibility buffers are written into them on creation.
+  if (m_pool)
+    create_frame_resources(*m_pool, m_depth);
+}
+
+void HiZCuller::create_frame_resources(
+  const FrameResourcePool& pool, FrameResourcePool::DepthHandle depth)
+{
+  destroy_frame_resources();
+
+  m_pool = &pool;
+  m_depth = depth;
+  m_slot_count = pool.slot_count();
+  m_depth_extent = pool.extent();
+
+  auto dev = m_device.device();
+  const auto base = pyramid_base_extent(m_depth_extent);
+  const uint32_t mips = pyramid_mip_count(m_depth_extent);
+
+  m_pyramids.reserve(m_slot_count);
+  m_mip_views.resize(m_slot_count);
+  m_params.resize(m_slot_count);
+  for (uint32_t s = 0; s < m_slot_count; ++s)
+  {
+    m_pyramids.emplace_back(m_device, vk::Format::eR32Sfloat, base,
+      vk::ImageUsageFlagBits::eStorage | vk::ImageUsageFlagBits::eSampled,
+      fmt::format("hiz_pyramid_{}", s), vk::SampleCountFlagBits::e1, mips);
+
+    // Single-mip views: storage target of one build dispatch and source of the next.
+    for (uint32_t m = 0; m < mips; ++m)
+    {
+      vk::ImageViewCreateInfo view_info{};
+      view_info.image = m_pyramids[s].image();
+      view_info.viewType = vk::ImageViewType::e2D;
+      view_info.format = vk::Format::eR32Sfloat;
+      view_info.subresourceRange = { vk::ImageAspectFlagBits::eColor, m, 1, 0, 1 };
+      m_mip_views[s].push_back(dev.createImageView(view_info));
+    }
+
+    m_params[s] = std::make_unique<Buffer>(m_device,
+      fmt::format("hiz_params_{}", s), sizeof(HiZCullParams),
+      vk::BufferUsageFlagBits::eUniformBuffer,
+      vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent);
+  }
+
+  // One build set per (slot, mip), two cull sets per slot (one per phase).
+  const uint32_t build_sets = m_slot_count * mips;
+  const uint32_t cull_sets = m_slot_count * 2;
+  auto pool_sizes = m_build->pool_sizes(build_sets);
+  auto cull_sizes = m_cull->pool_sizes(cull_sets);
+  pool_sizes.insert(pool_sizes.end(), cull_sizes.begin(), cull_sizes.end());
+
+  vk::DescriptorPoolCreateInfo pool_info{};
+  pool_info.maxSets = build_sets + cull_sets;
+  pool_info.poolSizeCount = static_cast<uint32_t>(pool_sizes.size());
+  pool_info.pPoolSizes = pool_sizes.data();
+  m_descriptor_pool = dev.createDescriptorPool(pool_info);
+
+  m_build_sets.resize(m_slot_count);
+  m_cull_sets.resize(m_slot_count);
+  for (uint32_t s = 0; s < m_slot_count; ++s)
+  {
+    m_build_sets[s] = m_build->allocate_sets(m_descriptor_pool, 0, mips);
+    m_cull_sets[s] = m_cull->allocate_sets(m_descriptor_pool, 0, 2);
+  }
+
+  reset_history();
+  allocate_slot_buffers();
+  write_descriptors();
+}
+
+void HiZCuller::destroy_frame_resources()
+{
+  // Deferred: frames in flight may still build or sample the pyramids. The
+  // images and buffers defer through their own destructors.
+  m_device.deletion_queue().push(
+    [dev = m_device.device(), pool = m_descriptor_pool, views = m_mip_views] {
+      if (pool)
+        dev.destroyDescriptorPool(pool);
+      for (auto& slot_views : views)
+        for (auto view : slot_views)
+          dev.destroyImageView(view);
+    });
+  m_descriptor_pool = VK_NULL_HANDLE;
+  m_build_sets.clear();
+  m_cull_sets.clear();
+  m_mip_views.clear();
+  m_pyramids.clear();
+  m_params.clear();
+  m_draws.clear();
+  m_visibility.clear();
+  m_slot_count = 0;
+  m_pool = nullptr;
+}
+
+void HiZCuller::allocate_slot_buffers()
+{
+  m_draws.clear();
+  m_visibility.clear();
+  if (m_primitive_count == 0 || m_slot_count == 0)
+    return;
+
+  const vk::DeviceSize draw_bytes = 2 * m_primitive_count * kDrawStride;
+  const vk::DeviceSize vis_bytes = m_primitive_count * sizeof(uint32_t);
+  for (uint32_t s = 0; s < m_slot_count; ++s)
+  {
+    m_draws.push_back(std::make_unique<Buffer>(m_device,
+      fmt::format("hiz_draws_{}", s), draw_bytes,
+      vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eIndirectBuffer,
+      vk::MemoryPropertyFlagBits::eDeviceLocal));
+    m_visibility.push_back(std::make_unique<Buffer>(m_device,
+      fmt::format("hiz_visibility_{}", s), vis_bytes,
+      vk::BufferUsageFlagBits::eStorageBuffer,
+      vk::MemoryPropertyFlagBits::eDeviceLocal));
+  }
+}
+
+void HiZCuller::write_descriptors()
+{
+  if (m_slot_count == 0)
+    return;
+
+  auto dev = m_device.device();
+  const uint32_t mips = pyramid_mip_count(m_depth_extent);
+
+  // Build sets: mip 0 reads the scene depth (depth aspect), mip m reads mip m-1.
+  // Written once per create — the views do not change between frames.
+  for (uint32_t s = 0; s < m_slot_count; ++s)
+  {
+    for (uint32_t m = 0; m < mips; ++m)
+    {
+      vk::DescriptorImageInfo src{};
+      src.sampler = m_sampler;
+      if (m == 0)
+      {
+        src.imageView = m_pool->depth_sample_view(m_depth, s);
+        src.imageLayout = vk::ImageLayout::eDepthStencilReadOnlyOptimal;
+      }
+      else
+      {
+        src.imageView = m_mip_views[s][m - 1];
+        src.imageLayout = vk::ImageLayout::eGeneral;
+      }
+
+      vk::DescriptorImageInfo dst{};
+      dst.imageView = m_mip_views[s][m];
+      dst.imageLayout = vk::ImageLayout::eGeneral;
+
+      std::array<vk::WriteDescriptorSet, 2> writes{};
+      writes[0].dstSet = m_build_sets[s][m];
+      writes[0].dstBinding = 0;
+      writes[0].descriptorCount = 1;
+      writes[0].descriptorType = vk::DescriptorType::eCombinedImageSampler;
+      writes[0].pImageInfo = &src;
+      writes[1].dstSet = m_build_sets[s][m];
+      writes[1].dstBinding = 1;
+      writes[1].descriptorCount = 1;
+      writes[1].descriptorType = vk::DescriptorType::eStorageImage;
+      writes[1].pImageInfo = &dst;
+      dev.updateDescriptorSets(writes, {});
+    }
+  }
+
+  if (m_primitive_count == 0)
+    return;
+
+  // Cull sets: phase 1 samples this slot's freshly built pyramid. Phase 0
+  // samples the one built last, which record_phase0() binds (a gated scene
+  // skips slots); until then it points at the slot's own.
+  for (uint32_t s = 0; s < m_slot_count; ++s)
+  {
+    for (uint32_t phase = 0; phase < 2; ++phase)
+    {
+      vk::DescriptorBufferInfo params{ m_params[s]->buffer(), 0, sizeof(HiZCullParams) };
+      vk::DescriptorBufferInfo prims{ m_primitive_buffer->buffer(), 0, VK_WHOLE_SIZE };
+      vk::DescriptorBufferInfo draws{ m_draws[s]->buffer(), 0, VK_WHOLE_SIZE };
+      vk::DescriptorBufferInfo vis{ m_visibility[s]->buffer(), 0, VK_WHOLE_SIZE };
+      vk::DescriptorImageInfo pyramid{ m_sampler, m_pyramids[s].image_view(),
+        vk::ImageLayout::eGeneral };
+
+      std::array<vk::WriteDescriptorSet, 5> writes{};
+      for (uint32_t b = 0; b < writes.size(); ++b)
+      {
+        writes[b].dstSet = m_cull_sets[s][phase];
+        writes[b].dstBinding = b;
+        writes[b].descriptorCount = 1;
+      }
+      writes[0].descriptorType = vk::DescriptorType::eUniformBuffer;
+      writes[0].pBufferInfo = &params;
+      writes[1].descriptorType = vk::DescriptorType::eStorageBuffer;
+      writes[1].pBufferInfo = &prims;
+      writes[2].descriptorType = vk::DescriptorType::eStorageBuffer;
+      writes[2].pBufferInfo = &draws;
+      writes[3].descriptorType = vk::DescriptorType::eStorageBuffer;
+      writes[3].pBufferInfo = &vis;
+      writes[4].descriptorType = vk::DescriptorType::eCombinedImageSampler;
+      writes[4].pImageInfo = &pyramid;
+      dev.updateDescriptorSets(writes, {});
+    }
+  }
+}
+
+vk::Buffer HiZCuller::draw_buffer(uint32_t slot) const
+{
+  assert(slot < m_draws.size() && "draw_buffer() before set_primitives()/create_frame_resources()");
+  return m_draws[slot]->buffer();
+}
+
+void HiZCuller::record_phase0(vk::CommandBuffer cmd, uint32_t slot,
+  const glm::mat4& view_proj, vk::Extent2D render_extent)
+{
+  if (m_primitive_count == 0 || slot >= m_slot_count)
+    return;
+
+  // Reproject the pyramid built last, however many slots ago. This slot's set
+  // was last used by its previous submission, which the graph waited for.
+  const bool use_occlusion = m_history_slot < m_slot_count;
+  {
+    vk::DescriptorImageInfo pyramid{ m_sampler,
+      m_pyramids[use_occlusion ? m_history_slot : slot].image_view(), vk::ImageLayout::eGeneral };
+    vk::WriteDescriptorSet write{};
+    write.dstSet = m_cull_sets[slot][0];
+    write.dstBinding = 4;
+    write.descriptorCount = 1;
+    write.descriptorType = vk::DescriptorType::eCombinedImageSampler;
+    write.pImageInfo = &pyramid;
+    m_device.device().updateDescriptorSets(write, {});
+  }
+
+  m_view_proj = view_proj;
+  m_render_extent = render_extent;
+  HiZCullParams params{};
+  params.viewProj = view_proj;
+  params.prevViewProj = m_history_view_proj;
+  params.depthSize = glm::vec4(
+    static_cast<float>(m_depth_extent.width), static_cast<float>(m_depth_extent.height),
+    static_cast<float>(pyramid_mip_count(m_depth_extent)), 0.0f);
+  params.viewportSize = glm::vec4(
+    static_cast<float>(render_extent.width), static_cast<float>(render_extent.height),
+    static_cast<float>(m_history_render_extent.width),
+    static_cast<float>(m_history_render_extent.height));
+  m_params[slot]->update(&params, sizeof(params));
+
+  // The latest pyramid build (same queue, earlier submission) and the
+  // last indirect read of this slot's draw buffer must complete first.
+  {
+    vk::MemoryBarrier barrier{};
+    barrier.srcAccessMask = vk::AccessFlagBits::eShaderWrite;
+    barrier.dstAccessMask = vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite;
+    cmd.pipelineBarrier(
+      vk::PipelineStageFlagBits::eComputeShader | vk::PipelineStageFlagBits::eDrawIndirect,
+      vk::PipelineStageFlagBits::eComputeShader, {}, barrier, {}, {});
+  }
+
+  HiZCullPushConstants pc{ m_primitive_count, 0, use_occlusion ? 1u : 0u, 0 };
+  m_cull->bind(cmd);
+  m_cull->bind_descriptor_set(cmd, 0, m_cull_sets[slot][0]);
+  m_cull->push_constants(cmd, &pc, sizeof(pc));
+  cmd.dispatch(ComputePipeline::group_count(m_primitive_count, kCullLocalSize), 1, 1);
+
+  compute_to_indirect_barrier(cmd);
+}
+
+void HiZCuller::record_phase1(vk::CommandBuffer cmd, uint32_t slot)
+{
+  if (m_primitive_count == 0 || slot >= m_slot_count)
+    return;
+
+  const vk::Image depth = m_pool->depth_image(m_depth, slot);
+  const vk::Image pyramid = m_pyramids[slot].image();
+  const uint32_t mips = m_pyramids[slot].mip_levels();
+
+  // Scene depth: attachment -> sampled by the mip-0 build.
+  transition_depth(cmd, depth,
+    vk::ImageLayout::eDepthStencilAttachmentOptimal,
+    vk::ImageLayout::eDepthStencilReadOnlyOptimal,
+    vk::PipelineStageFlagBits::eLateFragmentTests, vk::PipelineStageFlagBits::eComputeShader,
+    vk::AccessFlagBits::eDepthStencilAttachmentWrite, vk::AccessFlagBits::eShaderRead);
+
+  // Pyramid: discard the old contents (last read by an earlier phase 0), GENERAL
+  // for storage writes and sampled reads alike.
+  {
+    vk::ImageMemoryBarrier barrier{};
+    barrier.oldLayout = vk::ImageLayout::eUndefined;
+    barrier.newLayout = vk::ImageLayout::eGeneral;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = pyramid;
+    barrier.subresourceRange = { vk::ImageAspectFlagBits::eColor, 0, mips, 0, 1 };
+    barrier.srcAccessMask = {};
+    barrier.dstAccessMask = vk::AccessFlagBits::eShaderWrite;
+    cmd.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader,
+      vk::PipelineStageFlagBits::eComputeShader, {}, {}, {}, barrier);
+  }
+
+  // Max-reduce chain: depth -> mip 0 -> mip 1 -> ...
+  const auto base = m_pyramids[slot].extent();
+  m_build->bind(cmd);
+  vk::Extent2D src = m_depth_extent;
+  for (uint32_t m = 0; m < mips; ++m)
+  {
+    const auto dst = mip_extent(base, m);
+    HiZBuildPushConstants pc{
+      { static_cast<int32_t>(src.width), static_cast<int32_t>(src.height) },
+      { static_cast<int32_t>(dst.width), static_cast<int32_t>(dst.height) } };
+    m_build->bind_descriptor_set(cmd, 0, m_build_sets[slot][m]);
+    m_build->push_constants(cmd, &pc, sizeof(pc));
+    cmd.dispatch(ComputePipeline::group_count(dst.width, kBuildLocalSize),
+      ComputePipeline::group_count(dst.height, kBuildLocalSize), 1);
+    compute_to_compute_barrier(cmd);
+    src = dst;
+  }
+
+  // Depth back to attachment for the disocclusion pass (LOAD).
+  transition_depth(cmd, depth,
+    vk::ImageLayout::eDepthStencilReadOnlyOptimal,
+    vk::ImageLayout::eDepthStencilAttachmentOptimal,
+    vk::PipelineStageFlagBits::eComputeShader,
+    vk::PipelineStageFlagBits::eEarlyFragmentTests | vk::PipelineStageFlagBits::eLateFragmentTests,
+    {}, vk::AccessFlagBits::eDepthStencilAttachmentRead | vk::AccessFlagBits::eDepthStencilAttachmentWrite);
+
+  HiZCullPushConstants pc{ m_primitive_count, 1, 1, 0 };
+  m_cull->bind(cmd);
+  m_cull->bind_descriptor_set(cmd, 0, m_cull_sets[slot][1]);
+  m_cull->push_constants(cmd, &pc, sizeof(pc));
+  cmd.dispatch(ComputePipeline::group_count(m_primitive_count, kCullLocalSize), 1, 1);
+
+  compute_to_indirect_barrier(cmd);
+
+  m_history_slot = slot;
+  m_history_view_proj = m_view_proj;
+  m_history_render_extent = m_render_extent;
+}
+
+} // namespace vkwave
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <vkwave/core/buffer.h>
+#include <vkwave/core/image.h>
+#include <vkwave/pipeline/compute_pipeline.h>
+#include <vkwave/pipeline/frame_resource_pool.h>
+
+#include <glm/glm.hpp>
+#include <vulkan/vulkan.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+namespace vkwave
+{
+
+class Device;
+struct ScenePrimitive;
+
+/// Two-phase hierarchical-Z occlusion culling for scene primitives.
+///
+/// Per frame slot it owns a farthest-depth pyramid (R32Sfloat, full mip chain,
+/// mip 0 at half the scene-depth resolution) and an indirect draw buffer holding
+/// two VkDrawIndexedIndirectCommand runs of primitive_count() entries:
+///
+///   phase 0 (record_phase0, before the scene render pass): frustum test with
+///     this frame's viewProj, occlusion test against the pyramid built last
+///     (the previous scene frame, however many slots ago under gating)
+///     reprojected with its viewProj -> run 0.
+///   phase 1 (record_phase1, after the scene render pass): rebuild this slot's
+///     pyramid from the shared pool depth, then re-test the primitives phase 0
+///     rejected as occluded against it -> run 1 (the disoccluded set).
+///
+/// The caller draws run 0 in the scene pass and run 1 in a LOAD pass over the
+/// same attachments. Culled entries keep their draw but get instanceCount 0, so
+/// per-primitive material binds and push constants stay on the CPU.
+///
+/// The scene depth must be single-sample and stored by the scene render pass.
+/// Assumes the reversed-Z convention of Camera::projection_matrix() (1 = near,
+/// compare GREATER), so the pyramid keeps the MIN depth.
+class HiZCuller
+{
+public:
+  HiZCuller(const Device& device, bool debug);
+  ~HiZCuller();
+
+  HiZCuller(const HiZCuller&) = delete;
+  HiZCuller& operator=(const HiZCuller&) = delete;
+
+  /// Upload world-space bounds + draw ranges and (re)allocate the per-slot
+  /// draw/visibility buffers. Call on model load; the previous sets and
+  /// buffers are destroyed through the device deletion queue.
+  void set_primitives(std::span<const ScenePrimitive> primitives);
+
+  /// (Re)create the per-slot pyramids and descriptor sets for the pool's current
+  /// extent/slot count, sampling depth resource `depth`. The previous ones must
+  /// have been destroyed (destroy_frame_resources() defers past frames in flight).
+  void create_frame_resources(const FrameResourcePool& pool,
+                              FrameResourcePool::DepthHandle depth);
+
+  void destroy_frame_resources();
+
+  /// Drop the pyramid history (camera cut, resize): the next phase 0 keeps every
+  /// primitive inside the frustum.
+  void reset_history() { m_history_slot = UINT32_MAX; }
+
+  /// Phase 0. Record outside any render pass, before the scene draws.
+  /// `render_extent` is the part of the depth the scene draws this frame
+  /// (smaller than the pool extent under dynamic resolution).
+  void record_phase0(vk::CommandBuffer cmd, uint32_t slot, const glm::mat4& view_proj,
+                     vk::Extent2D render_extent);
+
+  /// Pyramid build + phase 1. Record after the scene render pass ended with the
+  /// depth in eDepthStencilAttachmentOptimal; the depth is left in that layout.
+  void record_phase1(vk::CommandBuffer cmd, uint32_t slot);
+
+  /// Indirect draw buffer for `slot`; run `phase` starts at draw_offset(phase).
+  [[nodiscard]] vk::Buffer draw_buffer(uint32_t slot) const;
+  [[nodiscard]] vk::DeviceSize draw_offset(uint32_t phase) const
+  {
+    return static_cast<vk::DeviceSize>(phase) * m_primitive_count * kDrawStride;
+  }
+
+  [[nodiscard]] uint32_t primitive_count() const { return m_primitive_count; }
+
+  /// Mip count of a pyramid built over a depth buffer of `depth_extent`.
+  [[nodiscard]] static uint32_t pyramid_mip_count(vk::Extent2D depth_extent);
+
+  static constexpr vk::DeviceSize kDrawStride = sizeof(vk::DrawIndexedIndirectCommand);
+
+private:
+  void allocate_slot_buffers();
+  void write_descriptors();
+
+  const Device& m_device;
+
+  std::unique_ptr<ComputePipeline> m_build;
+  std::unique_ptr<ComputePipeline> m_cull;
+  vk::Sampler m_sampler{ VK_NULL_HANDLE };
+
+  // Model-lifetime data
+  std::unique_ptr<Buffer> m_primitive_buffer; // HiZCullPrimitive[N], device-local
+  uint32_t m_primitive_count{ 0 };
+
+  // Per-slot resources
+  const FrameResourcePool* m_pool{ nullptr };
+  FrameResourcePool::DepthHandle m_depth{ 0 };
+  uint32_t m_slot_count{ 0 };
+  vk::Extent2D m_depth_extent{};
+  std::vector<Image> m_pyramids;
+  std::vector<std::vector<vk::ImageView>> m_mip_views;     // [slot][mip]
+  std::vector<std::unique_ptr<Buffer>> m_params;           // HiZCullParams, host-visible
+  std::vector<std::unique_ptr<Buffer>> m_draws;            // 2N draw commands
+  std::vector<std::unique_ptr<Buffer>> m_visibility;       // N phase-0 states
+
+  vk::DescriptorPool m_descriptor_pool{ VK_NULL_HANDLE };
+  std::vector<std::vector<vk::DescriptorSet>> m_build_sets; // [slot][mip]
+  std::vector<std::vector<vk::DescriptorSet>> m_cull_sets;  // [slot][phase]
+
+  // Pyramid history: the slot whose pyramid was built last and the viewProj it
+  // was rendered with (the next phase 0 reprojects through it).
+  uint32_t m_history_slot{ UINT32_MAX };
+  glm::mat4 m_view_proj{ 1.0f };
+  glm::mat4 m_history_view_proj{ 1.0f };
+  vk::Extent2D m_render_extent{};
+  vk::Extent2D m_history_render_extent{};
+};
+
+} // namespace vkwave
@@ -1,5 +1,6 @@
 #include <vkwave/pipeline/imgui_overlay.h>
 
+#include <vkwave/core/deletion_queue.h>
 #include <vkwave/core/device.h>
 #include <vkwave/core/swapchain.h>
 #include <vkwave/pipeline/framebuffer.h>
@@ -153,8 +154,11 @@ void ImGuiOverlay::create_frame_resources(
 
 void ImGuiOverlay::destroy_frame_resources()
 {
-  for (auto fb : m_framebuffers)
-    m_device.device().destroyFramebuffer(fb);
+  // Deferred: the overlay draws inside the present group's frames in flight.
+  m_device.deletion_queue().push([dev = m_device.device(), framebuffers = m_framebuffers] {
+    for (auto fb : framebuffers)
+      dev.destroyFramebuffer(fb);
+  });
   m_framebuffers.clear();
 }
 
@@ -0,0 +1,228 @@
+#include <vkwave/pipeline/mip_downsampler.h>
+
+#include <vkwave/config.h>
+#include <vkwave/core/deletion_queue.h>
+#include <vkwave/core/device.h>
+#include <vkwave/core/format_select.h>
+#include <vkwave/core/mip_downsample.h>
+
+#include <spdlog/fmt/fmt.h>
+
+#include <algorithm>
+#include <array>
+
+namespace vkwave
+{
+
+namespace
+{
+
+// Binding 1 of spd_downsample.comp: one storage view per level.
+constexpr uint32_t kDstBinding = 1;
+// Binding 2: mip 6 again, read back by the last workgroup.
+constexpr uint32_t kMidMip = 6;
+
+} // namespace
+
+MipDownsampler::MipDownsampler(const Device& device, vk::Format target_format, bool debug)
+  : m_device(device)
+{
+  m_downsample = std::make_unique<ComputePipeline>(device, SHADER_DIR "spd_downsample.comp",
+    debug, fmt::format("#define IMAGE_FORMAT {}\n", glsl_image_format(target_format)));
+}
+
+MipDownsampler::~MipDownsampler()
+{
+  destroy_frame_resources();
+}
+
+bool MipDownsampler::supported(const Device& device)
+{
+  vk::PhysicalDeviceSubgroupProperties subgroup{};
+  vk::PhysicalDeviceProperties2 props2{};
+  props2.pNext = &subgroup;
+  device.physicalDevice().getProperties2(&props2);
+
+  return (subgroup.supportedStages & vk::ShaderStageFlagBits::eCompute)
+    && (subgroup.supportedOperations & vk::SubgroupFeatureFlagBits::eQuad)
+    && subgroup.subgroupSize >= 4;
+}
+
+void MipDownsampler::create_frame_resources(const FrameResourcePool& pool,
+  FrameResourcePool::ColorHandle source, FrameResourcePool::ColorHandle target)
+{
+  destroy_frame_resources();
+
+  m_pool = &pool;
+  m_source = source;
+  m_target = target;
+  m_slot_count = pool.slot_count();
+  m_image_mips = pool.color_mip_levels(target, 0);
+  m_mip_count = spd_mip_count(pool.extent(), m_image_mips);
+
+  auto dev = m_device.device();
+
+  // Trilinear over the generated levels only: anything past mip_count() is
+  // never written.
+  vk::SamplerCreateInfo info{};
+  info.magFilter = vk::Filter::eLinear;
+  info.minFilter = vk::Filter::eLinear;
+  info.mipmapMode = vk::SamplerMipmapMode::eLinear;
+  info.addressModeU = vk::SamplerAddressMode::eClampToEdge;
+  info.addressModeV = vk::SamplerAddressMode::eClampToEdge;
+  info.addressModeW = vk::SamplerAddressMode::eClampToEdge;
+  info.maxLod = static_cast<float>(m_mip_count - 1);
+  m_sampler = dev.createSampler(info);
+
+  const vk::Format format = pool.color_format(target);
+  const uint32_t zero = 0;
+  m_mip_views.resize(m_slot_count);
+  m_counters.resize(m_slot_count);
+  for (uint32_t s = 0; s < m_slot_count; ++s)
+  {
+    for (uint32_t m = 0; m < m_image_mips; ++m)
+    {
+      vk::ImageViewCreateInfo view_info{};
+      view_info.image = pool.color_image(target, s);
+      view_info.viewType = vk::ImageViewType::e2D;
+      view_info.format = format;
+      view_info.subresourceRange = { vk::ImageAspectFlagBits::eColor, m, 1, 0, 1 };
+      m_mip_views[s].push_back(dev.createImageView(view_info));
+    }
+    m_counters[s] = Buffer::create_device_local(m_device,
+      fmt::format("spd_counter_{}", s), &zero, sizeof(zero),
+      vk::BufferUsageFlagBits::eStorageBuffer);
+  }
+
+  auto pool_sizes = m_downsample->pool_sizes(m_slot_count);
+  vk::DescriptorPoolCreateInfo pool_info{};
+  pool_info.maxSets = m_slot_count;
+  pool_info.poolSizeCount = static_cast<uint32_t>(pool_sizes.size());
+  pool_info.pPoolSizes = pool_sizes.data();
+  m_descriptor_pool = dev.createDescriptorPool(pool_info);
+  m_sets = m_downsample->allocate_sets(m_descriptor_pool, 0, m_slot_count);
+
+  // Written once — the views are fixed per create. Levels the image lacks get
+  // mip 0 (the shader never stores to a level >= mipCount).
+  for (uint32_t s = 0; s < m_slot_count; ++s)
+  {
+    const auto& views = m_mip_views[s];
+    auto level_view = [&](uint32_t m) { return views[m < views.size() ? m : 0]; };
+
+    const vk::DescriptorImageInfo src_info{ m_sampler, pool.color_view(source, s),
+      vk::ImageLayout::eShaderReadOnlyOptimal };
+    std::array<vk::DescriptorImageInfo, kSpdMaxMips> dst_infos{};
+    for (uint32_t m = 0; m < kSpdMaxMips; ++m)
+      dst_infos[m] = { VK_NULL_HANDLE, level_view(m), vk::ImageLayout::eGeneral };
+    const vk::DescriptorImageInfo mid_info{ VK_NULL_HANDLE, level_view(kMidMip),
+      vk::ImageLayout::eGeneral };
+    const vk::DescriptorBufferInfo counter_info{ m_counters[s]->buffer(), 0, VK_WHOLE_SIZE };
+
+    std::array<vk::WriteDescriptorSet, 4> writes{};
+    for (uint32_t b = 0; b < writes.size(); ++b)
+    {
+      writes[b].dstSet = m_sets[s];
+      writes[b].dstBinding = b;
+      writes[b].descriptorCount = 1;
+      writes[b].descriptorType = vk::DescriptorType::eStorageImage;
+    }
+    writes[0].descriptorType = vk::DescriptorType::eCombinedImageSampler;
+    writes[0].pImageInfo = &src_info;
+    writes[kDstBinding].descriptorCount = kSpdMaxMips;
+    writes[kDstBinding].pImageInfo = dst_infos.data();
+    writes[2].pImageInfo = &mid_info;
+    writes[3].descriptorType = vk::DescriptorType::eStorageBuffer;
+    writes[3].pBufferInfo = &counter_info;
+    dev.updateDescriptorSets(writes, {});
+  }
+}
+
+void MipDownsampler::destroy_frame_resources()
+{
+  // Deferred: a downsample in flight may still use the views and sets.
+  m_device.deletion_queue().push([dev = m_device.device(), pool = m_descriptor_pool,
+                                   views = m_mip_views, sampler = m_sampler] {
+    if (pool)
+      dev.destroyDescriptorPool(pool);
+    for (auto& slot_views : views)
+      for (auto view : slot_views)
+        dev.destroyImageView(view);
+    if (sampler)
+      dev.destroySampler(sampler);
+  });
+  m_descriptor_pool = VK_NULL_HANDLE;
+  m_sets.clear();
+  m_mip_views.clear();
+  m_counters.clear();
+  m_sampler = VK_NULL_HANDLE;
+  m_slot_count = 0;
+  m_image_mips = 0;
+  m_mip_count = 0;
+  m_pool = nullptr;
+}
+
+void MipDownsampler::record(
+  vk::CommandBuffer cmd, uint32_t slot, vk::Extent2D source_extent)
+{
+  if (slot >= m_slot_count)
+    return;
+
+  const vk::Extent2D extent = m_pool->extent();
+
+  // Source: already eShaderReadOnlyOptimal (render-pass final layout); wait for
+  // its color writes. Target: every level is rewritten, so discard it; its last
+  // reader was the refraction pass of an earlier frame on this slot.
+  std::array<vk::ImageMemoryBarrier, 2> pre{};
+  pre[0].srcAccessMask = vk::AccessFlagBits::eColorAttachmentWrite;
+  pre[0].dstAccessMask = vk::AccessFlagBits::eShaderRead;
+  pre[0].oldLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
+  pre[0].newLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
+  pre[0].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  pre[0].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  pre[0].image = m_pool->color_image(m_source, slot);
+  pre[0].subresourceRange = { vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1 };
+
+  pre[1].srcAccessMask = {};
+  pre[1].dstAccessMask = vk::AccessFlagBits::eShaderWrite | vk::AccessFlagBits::eShaderRead;
+  pre[1].oldLayout = vk::ImageLayout::eUndefined;
+  pre[1].newLayout = vk::ImageLayout::eGeneral;
+  pre[1].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  pre[1].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  pre[1].image = m_pool->color_image(m_target, slot);
+  pre[1].subresourceRange = { vk::ImageAspectFlagBits::eColor, 0, m_image_mips, 0, 1 };
+
+  // The counter reset by the previous dispatch on this slot.
+  vk::MemoryBarrier counter{};
+  counter.srcAccessMask = vk::AccessFlagBits::eShaderWrite;
+  counter.dstAccessMask = vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite;
+
+  cmd.pipelineBarrier(
+    vk::PipelineStageFlagBits::eColorAttachmentOutput
+      | vk::PipelineStageFlagBits::eFragmentShader | vk::PipelineStageFlagBits::eComputeShader,
+    vk::PipelineStageFlagBits::eComputeShader, {}, counter, {}, pre);
+
+  const uint32_t groups_x = ComputePipeline::group_count(extent.width, kSpdTileSize);
+  const uint32_t groups_y = ComputePipeline::group_count(extent.height, kSpdTileSize);
+
+  SpdPushConstants pc{};
+  pc.srcSize = glm::ivec2(std::max(source_extent.width, 1u), std::max(source_extent.height, 1u));
+  pc.dstSize = glm::ivec2(extent.width, extent.height);
+  pc.mipCount = static_cast<int32_t>(m_mip_count);
+  pc.groupCount = groups_x * groups_y;
+
+  m_downsample->bind(cmd);
+  m_downsample->bind_descriptor_set(cmd, 0, m_sets[slot]);
+  m_downsample->push_constants(cmd, &pc, sizeof(pc));
+  cmd.dispatch(groups_x, groups_y, 1);
+
+  // Whole chain -> sampled by the refraction pass.
+  vk::ImageMemoryBarrier post = pre[1];
+  post.srcAccessMask = vk::AccessFlagBits::eShaderWrite;
+  post.dstAccessMask = vk::AccessFlagBits::eShaderRead;
+  post.oldLayout = vk::ImageLayout::eGeneral;
+  post.newLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
+  cmd.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader,
+    vk::PipelineStageFlagBits::eFragmentShader, {}, {}, {}, post);
+}
+
+} // namespace vkwave
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <vkwave/core/buffer.h>
+#include <vkwave/pipeline/compute_pipeline.h>
+#include <vkwave/pipeline/frame_resource_pool.h>
+
+#include <vulkan/vulkan.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace vkwave
+{
+
+class Device;
+
+/// Single-pass mip-chain generation (spd_downsample.comp): copies a source
+/// image into mip 0 of a full-mip target and filters every further level in one
+/// dispatch — no per-level barriers or dispatches, no transfer copy.
+///
+/// Both images are graph-owned pool resources of one slot each:
+///
+///   source (sampled)            e.g. the scene's HDR, possibly rendered into a
+///                               smaller top-left sub-rectangle
+///   target (storage + sampled)  registered with full_mips; the whole chain is
+///                               rewritten each record()
+///
+/// Each slot also owns the small atomic counter the shader uses to find the
+/// last workgroup, which resets it for the next use.
+///
+/// The shader needs quad subgroup operations in compute shaders; check
+/// supported() before constructing.
+class MipDownsampler
+{
+public:
+  /// `target_format` is the target's storage format (its GLSL qualifier is
+  /// compiled in); create_frame_resources() must be given a target of it.
+  MipDownsampler(const Device& device, vk::Format target_format, bool debug);
+  ~MipDownsampler();
+
+  MipDownsampler(const MipDownsampler&) = delete;
+  MipDownsampler& operator=(const MipDownsampler&) = delete;
+
+  /// True when the device exposes quad subgroup operations to compute shaders.
+  static bool supported(const Device& device);
+
+  /// (Re)create the per-slot mip views, counters and descriptor sets for the
+  /// pool's current resources. The previous ones must have been destroyed
+  /// (deferred past frames in flight).
+  void create_frame_resources(const FrameResourcePool& pool,
+                              FrameResourcePool::ColorHandle source,
+                              FrameResourcePool::ColorHandle target);
+
+  void destroy_frame_resources();
+
+  /// Rebuild the chain of `slot`. Record outside any render pass, after the
+  /// source's writer left it in eShaderReadOnlyOptimal through the color
+  /// attachment stage. `source_extent` is the part of it to read (edges are
+  /// clamped). The target is left in eShaderReadOnlyOptimal for fragment reads.
+  void record(vk::CommandBuffer cmd, uint32_t slot, vk::Extent2D source_extent);
+
+  /// Trilinear clamp sampler whose maxLod covers the generated levels
+  /// (recreated by create_frame_resources()).
+  [[nodiscard]] vk::Sampler sampler() const { return m_sampler; }
+  /// Levels written by record() (the target may have more).
+  [[nodiscard]] uint32_t mip_count() const { return m_mip_count; }
+
+  [[nodiscard]] bool ready() const { return m_slot_count > 0; }
+
+private:
+  const Device& m_device;
+
+  std::unique_ptr<ComputePipeline> m_downsample;
+  vk::Sampler m_sampler{ VK_NULL_HANDLE };
+
+  const FrameResourcePool* m_pool{ nullptr };
+  FrameResourcePool::ColorHandle m_source{ 0 };
+  FrameResourcePool::ColorHandle m_target{ 0 };
+  uint32_t m_slot_count{ 0 };
+  uint32_t m_image_mips{ 0 };
+  uint32_t m_mip_count{ 0 };
+
+  std::vector<std::vector<vk::ImageView>> m_mip_views; // [slot][mip]
+  std::vector<std::unique_ptr<Buffer>> m_counters;     // [slot], one uint
+
+  vk::DescriptorPool m_descriptor_pool{ VK_NULL_HANDLE };
+  std::vector<vk::DescriptorSet> m_sets; // [slot]
+};
+
+} // namespace vkwave
@@ -0,0 +1,162 @@
+#include <vkwave/pipeline/oit_resolve.h>
+
+#include <vkwave/config.h>
+#include <vkwave/core/deletion_queue.h>
+#include <vkwave/core/device.h>
+#include <vkwave/core/format_select.h>
+
+#include <spdlog/fmt/fmt.h>
+
+#include <array>
+
+namespace vkwave
+{
+
+namespace
+{
+
+constexpr uint32_t kLocalSize = 8; // oit_resolve.comp: 8x8
+
+void transition_hdr(vk::CommandBuffer cmd, vk::Image image,
+  vk::ImageLayout old_layout, vk::ImageLayout new_layout,
+  vk::PipelineStageFlags src_stage, vk::PipelineStageFlags dst_stage,
+  vk::AccessFlags src_access, vk::AccessFlags dst_access)
+{
+  vk::ImageMemoryBarrier barrier{};
+  barrier.oldLayout = old_layout;
+  barrier.newLayout = new_layout;
+  barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.image = image;
+  barrier.subresourceRange = { vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1 };
+  barrier.srcAccessMask = src_access;
+  barrier.dstAccessMask = dst_access;
+  cmd.pipelineBarrier(src_stage, dst_stage, {}, {}, {}, barrier);
+}
+
+} // namespace
+
+OitResolve::OitResolve(const Device& device, vk::Format hdr_format, bool debug)
+  : m_device(device)
+{
+  m_resolve = std::make_unique<ComputePipeline>(device, SHADER_DIR "oit_resolve.comp",
+    debug, fmt::format("#define IMAGE_FORMAT {}\n", glsl_image_format(hdr_format)));
+
+  // texelFetch only; the sampler just completes the combined descriptors.
+  vk::SamplerCreateInfo info{};
+  info.magFilter = vk::Filter::eNearest;
+  info.minFilter = vk::Filter::eNearest;
+  info.mipmapMode = vk::SamplerMipmapMode::eNearest;
+  info.addressModeU = vk::SamplerAddressMode::eClampToEdge;
+  info.addressModeV = vk::SamplerAddressMode::eClampToEdge;
+  info.addressModeW = vk::SamplerAddressMode::eClampToEdge;
+  m_sampler = device.device().createSampler(info);
+}
+
+OitResolve::~OitResolve()
+{
+  destroy_frame_resources();
+  if (m_sampler)
+    m_device.deletion_queue().push([dev = m_device.device(), sampler = m_sampler] {
+      dev.destroySampler(sampler);
+    });
+}
+
+void OitResolve::create_frame_resources(const FrameResourcePool& pool,
+  FrameResourcePool::ColorHandle hdr, FrameResourcePool::ColorHandle accum,
+  FrameResourcePool::ColorHandle reveal)
+{
+  destroy_frame_resources();
+
+  m_pool = &pool;
+  m_hdr = hdr;
+  m_slot_count = pool.slot_count();
+
+  auto dev = m_device.device();
+  auto pool_sizes = m_resolve->pool_sizes(m_slot_count);
+  vk::DescriptorPoolCreateInfo pool_info{};
+  pool_info.maxSets = m_slot_count;
+  pool_info.poolSizeCount = static_cast<uint32_t>(pool_sizes.size());
+  pool_info.pPoolSizes = pool_sizes.data();
+  m_descriptor_pool = dev.createDescriptorPool(pool_info);
+  m_sets = m_resolve->allocate_sets(m_descriptor_pool, 0, m_slot_count);
+
+  // Slot s resolves its own targets into its own HDR.
+  for (uint32_t s = 0; s < m_slot_count; ++s)
+  {
+    std::array<vk::DescriptorImageInfo, 3> images{ {
+      { m_sampler, pool.color_view(accum, s), vk::ImageLayout::eShaderReadOnlyOptimal },
+      { m_sampler, pool.color_view(reveal, s), vk::ImageLayout::eShaderReadOnlyOptimal },
+      { VK_NULL_HANDLE, pool.color_view(hdr, s), vk::ImageLayout::eGeneral },
+    } };
+
+    std::array<vk::WriteDescriptorSet, kDescriptorTypes.size()> writes{};
+    for (uint32_t b = 0; b < writes.size(); ++b)
+    {
+      writes[b].dstSet = m_sets[s];
+      writes[b].dstBinding = b;
+      writes[b].descriptorCount = 1;
+      writes[b].descriptorType = kDescriptorTypes[b];
+      writes[b].pImageInfo = &images[b];
+    }
+    dev.updateDescriptorSets(writes, {});
+  }
+}
+
+void OitResolve::destroy_frame_resources()
+{
+  // Deferred: a resolve in flight may still use the sets.
+  if (m_descriptor_pool)
+  {
+    m_device.deletion_queue().push([dev = m_device.device(), pool = m_descriptor_pool] {
+      dev.destroyDescriptorPool(pool);
+    });
+    m_descriptor_pool = VK_NULL_HANDLE;
+  }
+  m_sets.clear();
+  m_slot_count = 0;
+  m_pool = nullptr;
+}
+
+void OitResolve::record(vk::CommandBuffer cmd, uint32_t slot, vk::Extent2D render_extent)
+{
+  if (slot >= m_slot_count)
+    return;
+
+  const vk::Image hdr = m_pool->color_image(m_hdr, slot);
+
+  // The HDR was last written as a color attachment (opaque pass, earlier
+  // submission) and the OIT targets just now; keep the HDR's contents.
+  vk::MemoryBarrier targets{};
+  targets.srcAccessMask = vk::AccessFlagBits::eColorAttachmentWrite;
+  targets.dstAccessMask = vk::AccessFlagBits::eShaderRead;
+  cmd.pipelineBarrier(vk::PipelineStageFlagBits::eColorAttachmentOutput,
+    vk::PipelineStageFlagBits::eComputeShader, {}, targets, {}, {});
+  transition_hdr(cmd, hdr,
+    vk::ImageLayout::eShaderReadOnlyOptimal, vk::ImageLayout::eGeneral,
+    vk::PipelineStageFlagBits::eColorAttachmentOutput | vk::PipelineStageFlagBits::eFragmentShader
+      | vk::PipelineStageFlagBits::eComputeShader | vk::PipelineStageFlagBits::eTransfer,
+    vk::PipelineStageFlagBits::eComputeShader,
+    vk::AccessFlagBits::eColorAttachmentWrite,
+    vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite);
+
+  const OitResolvePushConstants pc{ render_extent.width, render_extent.height };
+  m_resolve->bind(cmd);
+  m_resolve->bind_descriptor_set(cmd, 0, m_sets[slot]);
+  m_resolve->push_constants(cmd, &pc, sizeof(pc));
+  cmd.dispatch(ComputePipeline::group_count(render_extent.width, kLocalSize),
+    ComputePipeline::group_count(render_extent.height, kLocalSize), 1);
+
+  // HDR -> sampled by the composite / TAA, copied by the snapshot and the
+  // screenshot, or LOADed by the transmission pass.
+  transition_hdr(cmd, hdr,
+    vk::ImageLayout::eGeneral, vk::ImageLayout::eShaderReadOnlyOptimal,
+    vk::PipelineStageFlagBits::eComputeShader,
+    vk::PipelineStageFlagBits::eFragmentShader | vk::PipelineStageFlagBits::eComputeShader
+      | vk::PipelineStageFlagBits::eTransfer | vk::PipelineStageFlagBits::eColorAttachmentOutput,
+    vk::AccessFlagBits::eShaderWrite,
+    vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eTransferRead
+      | vk::AccessFlagBits::eColorAttachmentRead | vk::AccessFlagBits::eColorAttachmentWrite);
+}
+
+} // namespace vkwave
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <vkwave/pipeline/compute_pipeline.h>
+#include <vkwave/pipeline/frame_resource_pool.h>
+
+#include <vulkan/vulkan.hpp>
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace vkwave
+{
+
+class Device;
+
+/// Push constants for oit_resolve.comp.
+struct OitResolvePushConstants
+{
+  uint32_t width;  // rendered part of the targets (dynamic resolution)
+  uint32_t height;
+};
+
+static_assert(sizeof(OitResolvePushConstants) == 8,
+  "OitResolvePushConstants must be 8 bytes to match shader layout");
+
+/// Weighted-blended OIT resolve: composites the transparent layers OitPass
+/// accumulated over the opaque HDR, in place, with one compute dispatch.
+///
+/// All images are graph-owned pool resources of one slot each:
+///
+///   accum  (sampled)  sum of weighted premultiplied colour + weighted alpha
+///   reveal (sampled)  sum of -log(1 - alpha) (product of the coverages)
+///   hdr    (storage)  the scene's HDR, read-modify-written
+///
+/// Resolving into the HDR (rather than in the composite shader) means
+/// everything downstream — transmission snapshot, TAA, screenshots — sees the
+/// transparent surfaces.
+class OitResolve
+{
+public:
+  /// Set 0 of oit_resolve.comp in binding order (accum, reveal, hdr), as
+  /// create_frame_resources() writes it.
+  static constexpr std::array<vk::DescriptorType, 3> kDescriptorTypes{
+    vk::DescriptorType::eCombinedImageSampler,
+    vk::DescriptorType::eCombinedImageSampler,
+    vk::DescriptorType::eStorageImage,
+  };
+
+  /// `hdr_format` is the HDR's storage format (compiled into the shader).
+  OitResolve(const Device& device, vk::Format hdr_format, bool debug);
+  ~OitResolve();
+
+  OitResolve(const OitResolve&) = delete;
+  OitResolve& operator=(const OitResolve&) = delete;
+
+  /// (Re)create the per-slot descriptor sets for the pool's current resources.
+  /// The previous ones are destroyed through the device deletion queue.
+  void create_frame_resources(const FrameResourcePool& pool,
+                              FrameResourcePool::ColorHandle hdr,
+                              FrameResourcePool::ColorHandle accum,
+                              FrameResourcePool::ColorHandle reveal);
+
+  void destroy_frame_resources();
+
+  /// Resolve `slot`. Record outside any render pass, after the OIT pass left
+  /// accum/reveal and the HDR in eShaderReadOnlyOptimal; the HDR is left there
+  /// again. `render_extent` is the part of the targets drawn this frame.
+  void record(vk::CommandBuffer cmd, uint32_t slot, vk::Extent2D render_extent);
+
+  [[nodiscard]] bool ready() const { return m_slot_count > 0; }
+
+private:
+  const Device& m_device;
+
+  std::unique_ptr<ComputePipeline> m_resolve;
+  vk::Sampler m_sampler{ VK_NULL_HANDLE };
+
+  const FrameResourcePool* m_pool{ nullptr };
+  FrameResourcePool::ColorHandle m_hdr{ 0 };
+  uint32_t m_slot_count{ 0 };
+
+  vk::DescriptorPool m_descriptor_pool{ VK_NULL_HANDLE };
+  std::vector<vk::DescriptorSet> m_sets; // [slot]
+};
+
+} // namespace vkwave
@@ -0,0 +1,534 @@
+#include <vkwave/pipeline/path_tracer.h>
+
+#include <vkwave/core/camera.h>
+#include <vkwave/loaders/gltf_loader.h>
+#include <vkwave/loaders/ibl.h>
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <stdexcept>
+#include <thread>
+
+namespace vkwave
+{
+
+namespace
+{
+
+constexpr float kPi = 3.14159265358979f;
+// Offset of secondary ray origins along the geometric normal, relative to the
+// hit's distance from the world origin (float precision of the hit point).
+constexpr float kRayOffset = 1e-4f;
+// Bounces before Russian roulette may end a path.
+constexpr uint32_t kRouletteStart = 3;
+// Blended surfaces skipped along one segment before the path is dropped.
+constexpr uint32_t kMaxPassThrough = 64;
+
+/// PCG hash (Jarzynski & Olano 2020) as a tiny per-pixel sequence.
+struct Rng
+{
+  uint32_t state;
+
+  explicit Rng(uint32_t seed) : state(seed) {}
+
+  float next()
+  {
+    state = state * 747796405u + 2891336453u;
+    uint32_t word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+    word = (word >> 22u) ^ word;
+    return static_cast<float>(word >> 8) * (1.0f / 16777216.0f);
+  }
+};
+
+uint32_t hash(uint32_t x)
+{
+  x ^= x >> 16;
+  x *= 0x7feb352dU;
+  x ^= x >> 15;
+  x *= 0x846ca68bU;
+  x ^= x >> 16;
+  return x;
+}
+
+float max_component(const glm::vec3& v)
+{
+  return std::max(v.x, std::max(v.y, v.z));
+}
+
+/// Orthonormal basis around `n` (Duff et al. 2017).
+void basis(const glm::vec3& n, glm::vec3& t, glm::vec3& b)
+{
+  const float sign = std::copysign(1.0f, n.z);
+  const float a = -1.0f / (sign + n.z);
+  const float c = n.x * n.y * a;
+  t = glm::vec3(1.0f + sign * n.x * n.x * a, sign * c, -sign * n.x);
+  b = glm::vec3(c, sign + n.y * n.y * a, -n.y);
+}
+
+// pbr.frag's terms: D_GGX, V_GGX (height-correlated Smith), F_Schlick.
+float d_ggx(float n_dot_h, float alpha)
+{
+  const float a2 = alpha * alpha;
+  const float f = n_dot_h * n_dot_h * (a2 - 1.0f) + 1.0f;
+  return a2 / (kPi * f * f);
+}
+
+float v_ggx(float n_dot_l, float n_dot_v, float alpha)
+{
+  const float a2 = alpha * alpha;
+  const float ggx_v = n_dot_l * std::sqrt(n_dot_v * n_dot_v * (1.0f - a2) + a2);
+  const float ggx_l = n_dot_v * std::sqrt(n_dot_l * n_dot_l * (1.0f - a2) + a2);
+  const float ggx = ggx_v + ggx_l;
+  return ggx > 0.0f ? 0.5f / ggx : 0.0f;
+}
+
+/// Unpolarized Fresnel reflectance of a smooth dielectric interface; `eta` is
+/// the ratio of the indices (incident / transmitted).
+float fresnel_dielectric(float cos_i, float eta)
+{
+  const float sin2_t = eta * eta * (1.0f - cos_i * cos_i);
+  if (sin2_t >= 1.0f)
+    return 1.0f; // total internal reflection
+  const float cos_t = std::sqrt(1.0f - sin2_t);
+  const float rs = (eta * cos_i - cos_t) / (eta * cos_i + cos_t);
+  const float rp = (cos_i - eta * cos_t) / (cos_i + eta * cos_t);
+  return 0.5f * (rs * rs + rp * rp);
+}
+
+} // anonymous namespace
+
+struct PathTracer::Context
+{
+  Rng rng;
+  uint64_t rays{ 0 };
+};
+
+PathTracer::PathTracer(std::span<const Vertex> vertices, std::span<const uint32_t> indices,
+                       std::span<const ScenePrimitive> primitives,
+                       std::span<const SceneMaterial> materials)
+{
+  const auto start = std::chrono::steady_clock::now();
+
+  m_materials.reserve(materials.size() + 1);
+  for (const auto& m : materials)
+  {
+    Material mat;
+    mat.base_color = glm::vec3(m.baseColorFactor);
+    mat.alpha = m.alphaMode == AlphaMode::Opaque ? 1.0f : m.baseColorFactor.a;
+    mat.metallic = m.metallicFactor;
+    mat.roughness = m.roughnessFactor;
+    mat.transmission = m.transmissionFactor;
+    mat.ior = m.ior;
+    mat.blend = m.alphaMode == AlphaMode::Blend;
+    // Masked out entirely by the factor (no texture can bring it back here).
+    if (m.alphaMode == AlphaMode::Mask && mat.alpha < m.alphaCutoff)
+      mat.alpha = 0.0f;
+    m_materials.push_back(mat);
+  }
+  const auto fallback_material = static_cast<uint32_t>(m_materials.size());
+  m_materials.emplace_back(); // out-of-range material indices
+
+  std::vector<uint8_t> masks;
+  for (const auto& prim : primitives)
+  {
+    const uint32_t material = prim.materialIndex < materials.size()
+      ? prim.materialIndex : fallback_material;
+    const Material& mat = m_materials[material];
+    if (mat.alpha <= 0.0f && !mat.blend)
+      continue;
+    const uint8_t mask = (mat.blend || mat.transmission > 0.0f) ? 0x02 : 0x01;
+    const glm::mat3 normal_matrix = glm::transpose(glm::inverse(glm::mat3(prim.modelMatrix)));
+
+    for (uint32_t i = 0; i + 3 <= prim.indexCount; i += 3)
+    {
+      Triangle tri{};
+      tri.material = material;
+      bool valid = true;
+      glm::vec3 p[3];
+      for (uint32_t k = 0; k < 3; ++k)
+      {
+        const size_t index = prim.firstIndex + i + k;
+        const int64_t vertex = index < indices.size()
+          ? static_cast<int64_t>(indices[index]) + prim.vertexOffset : -1;
+        if (vertex < 0 || static_cast<size_t>(vertex) >= vertices.size())
+        {
+          valid = false;
+          break;
+        }
+        const Vertex& v = vertices[static_cast<size_t>(vertex)];
+        p[k] = glm::vec3(prim.modelMatrix * glm::vec4(v.position, 1.0f));
+        const glm::vec3 n = normal_matrix * v.normal;
+        const float len = glm::length(n);
+        tri.normal[k] = len > 0.0f ? n / len : glm::vec3(0.0f);
+        tri.color[k] = v.color;
+      }
+      if (!valid)
+        continue;
+      m_positions.insert(m_positions.end(), { p[0], p[1], p[2] });
+      m_triangles.push_back(tri);
+      masks.push_back(mask);
+    }
+  }
+
+  m_bvh = Bvh4(m_positions, masks);
+
+  m_stats.build_ms = std::chrono::duration<double, std::milli>(
+    std::chrono::steady_clock::now() - start).count();
+  spdlog::info("PathTracer: {} triangles, {} BVH nodes (depth {}) in {:.1f} ms",
+    m_bvh.triangle_count(), m_bvh.node_count(), m_bvh.depth(), m_stats.build_ms);
+}
+
+glm::vec3 PathTracer::environment(glm::vec3 direction) const
+{
+  if (!m_environment || m_environment->width == 0 || m_environment->height == 0)
+    return glm::vec3(0.0f);
+
+  // equirect_to_cubemap.comp's dirToUV, nearest texel.
+  const glm::vec3 d = glm::normalize(direction);
+  const float u = 0.5f + 0.5f * std::atan2(d.z, d.x) / kPi;
+  const float v = std::acos(std::clamp(d.y, -1.0f, 1.0f)) / kPi;
+  const auto w = m_environment->width;
+  const auto h = m_environment->height;
+  const auto x = std::min(static_cast<uint32_t>(u * static_cast<float>(w)), w - 1);
+  const auto y = std::min(static_cast<uint32_t>(v * static_cast<float>(h)), h - 1);
+  const float* texel = &m_environment->rgba[(static_cast<size_t>(y) * w + x) * 4];
+  return glm::vec3(texel[0], texel[1], texel[2]) * m_settings.environment_intensity;
+}
+
+glm::vec3 PathTracer::trace(Context& ctx, glm::vec3 origin, glm::vec3 direction) const
+{
+  glm::vec3 radiance(0.0f);
+  glm::vec3 throughput(1.0f);
+  const glm::vec3 sun_l = glm::normalize(m_settings.sun_direction);
+  const bool has_sun = max_component(m_settings.sun_radiance) > 0.0f;
+
+  uint32_t passes = 0;
+  for (uint32_t bounce = 0; bounce <= m_settings.max_bounces;)
+  {
+    BvhRay ray;
+    ray.origin = origin;
+    ray.direction = direction;
+    const BvhHit hit = m_bvh.intersect(ray);
+    ++ctx.rays;
+    if (!hit.valid())
+    {
+      radiance += throughput * environment(direction);
+      break;
+    }
+
+    const Triangle& tri = m_triangles[hit.triangle];
+    const Material& mat = m_materials[tri.material];
+    const glm::vec3 p = origin + direction * hit.t;
+    const float offset = kRayOffset * std::max(1.0f, max_component(glm::abs(p)));
+
+    // Blended: transmitted unchanged with probability 1 - alpha.
+    if (mat.blend && ctx.rng.next() >= mat.alpha)
+    {
+      if (++passes > kMaxPassThrough)
+        break;
+      origin = p + direction * offset;
+      continue;
+    }
+    passes = 0;
+
+    const glm::vec3* v = &m_positions[3 * static_cast<size_t>(hit.triangle)];
+    glm::vec3 ng = glm::normalize(glm::cross(v[1] - v[0], v[2] - v[0]));
+    const float w = 1.0f - hit.u - hit.v;
+    glm::vec3 n = w * tri.normal[0] + hit.u * tri.normal[1] + hit.v * tri.normal[2];
+    n = glm::dot(n, n) > 0.0f ? glm::normalize(n) : ng;
+    const bool front = glm::dot(direction, ng) < 0.0f;
+    if (!front)
+    {
+      ng = -ng;
+      n = -n;
+    }
+    if (glm::dot(n, ng) <= 0.0f)
+      n = ng;
+
+    const glm::vec3 view = -direction;
+    const glm::vec3 albedo = mat.base_color *
+      (w * tri.color[0] + hit.u * tri.color[1] + hit.v * tri.color[2]);
+
+    // Smooth dielectric: reflect or refract by the exact Fresnel term.
+    if (mat.transmission > 0.0f && ctx.rng.next() < mat.transmission)
+    {
+      const float eta = front ? 1.0f / mat.ior : mat.ior;
+      const float cos_i = std::clamp(glm::dot(view, n), 0.0f, 1.0f);
+      if (ctx.rng.next() < fresnel_dielectric(cos_i, eta))
+      {
+        direction = glm::reflect(direction, n);
+        origin = p + ng * offset;
+      }
+      else
+      {
+        direction = glm::refract(direction, n, eta);
+        origin = p - ng * offset;
+        throughput *= albedo;
+      }
+      ++bounce;
+      continue;
+    }
+
+    const float alpha = std::max(mat.roughness * mat.roughness, 1e-3f);
+    const glm::vec3 f0 = glm::mix(glm::vec3(0.04f), albedo, mat.metallic);
+    auto brdf = [&](const glm::vec3& l) {
+      const glm::vec3 h = glm::normalize(view + l);
+      const float n_dot_l = std::clamp(glm::dot(n, l), 0.0f, 1.0f);
+      const float n_dot_v = std::clamp(glm::dot(n, view), 1e-4f, 1.0f);
+      const float n_dot_h = std::clamp(glm::dot(n, h), 0.0f, 1.0f);
+      const float v_dot_h = std::clamp(glm::dot(view, h), 0.0f, 1.0f);
+      const float x = 1.0f - v_dot_h;
+      const glm::vec3 fresnel = f0 + (glm::vec3(1.0f) - f0) * (x * x * x * x * x);
+      const float specular = d_ggx(n_dot_h, alpha) * v_ggx(n_dot_l, n_dot_v, alpha);
+      // pbr.frag's addLight(): metals specular only, dielectrics mix by F.
+      const glm::vec3 dielectric = glm::mix(albedo / kPi, glm::vec3(specular), fresnel);
+      return glm::mix(dielectric, fresnel * specular, mat.metallic);
+    };
+
+    // Next-event estimation: the sun is a delta light, so only a shadow ray.
+    // Blended and transmissive surfaces do not occlude (like the TLAS mask).
+    const float sun_n_dot_l = glm::dot(n, sun_l);
+    if (has_sun && sun_n_dot_l > 0.0f && glm::dot(ng, sun_l) > 0.0f)
+    {
+      BvhRay shadow;
+      shadow.origin = p + ng * offset;
+      shadow.direction = sun_l;
+      shadow.mask = 0x01;
+      ++ctx.rays;
+      if (!m_bvh.occluded(shadow))
+        radiance += throughput * brdf(sun_l) * sun_n_dot_l * m_settings.sun_radiance;
+    }
+
+    // One-sample MIS between the GGX (visible-normal-free) and cosine lobes.
+    const float p_specular = 0.5f + 0.5f * mat.metallic;
+    glm::vec3 t, b;
+    basis(n, t, b);
+    const float xi1 = ctx.rng.next();
+    const float xi2 = ctx.rng.next();
+    const float phi = 2.0f * kPi * xi2;
+    glm::vec3 l;
+    if (ctx.rng.next() < p_specular)
+    {
+      const float cos_h = std::sqrt((1.0f - xi1) / (1.0f + (alpha * alpha - 1.0f) * xi1));
+      const float sin_h = std::sqrt(std::max(0.0f, 1.0f - cos_h * cos_h));
+      const glm::vec3 h = sin_h * std::cos(phi) * t + sin_h * std::sin(phi) * b + cos_h * n;
+      l = glm::reflect(-view, h);
+    }
+    else
+    {
+      const float r = std::sqrt(xi1);
+      l = r * std::cos(phi) * t + r * std::sin(phi) * b + std::sqrt(std::max(0.0f, 1.0f - xi1)) * n;
+    }
+    const float n_dot_l = glm::dot(n, l);
+    if (n_dot_l <= 0.0f || glm::dot(ng, l) <= 0.0f)
+      break;
+
+    const glm::vec3 h = glm::normalize(view + l);
+    const float n_dot_h = std::clamp(glm::dot(n, h), 0.0f, 1.0f);
+    const float v_dot_h = std::max(glm::dot(view, h), 1e-4f);
+    const float pdf = p_specular * d_ggx(n_dot_h, alpha) * n_dot_h / (4.0f * v_dot_h)
+                    + (1.0f - p_specular) * n_dot_l / kPi;
+    if (pdf <= 0.0f)
+      break;
+    throughput *= brdf(l) * n_dot_l / pdf;
+    origin = p + ng * offset;
+    direction = l;
+
+    if (++bounce >= kRouletteStart)
+    {
+      const float survive = std::min(max_component(throughput), 0.95f);
+      if (ctx.rng.next() >= survive)
+        break;
+      throughput /= survive;
+    }
+  }
+  return radiance;
+}
+
+std::vector<float> PathTracer::render(const Camera& camera, uint32_t width, uint32_t height,
+                                      const Settings& settings)
+{
+  m_settings = settings;
+  std::vector<float> image(static_cast<size_t>(width) * height * 4, 0.0f);
+  if (width == 0 || height == 0)
+    return image;
+
+  const auto start = std::chrono::steady_clock::now();
+
+  // Primary rays: the camera's frame and vertical field of view (or parallel
+  // scale), with the image's aspect ratio.
+  const glm::vec3 eye = camera.position();
+  const glm::vec3 forward = camera.direction_of_projection();
+  const glm::vec3 right = glm::normalize(glm::cross(forward, camera.view_up()));
+  const glm::vec3 up = glm::cross(right, forward);
+  const float aspect = static_cast<float>(width) / static_cast<float>(height);
+  const bool parallel = camera.parallel_projection();
+  const float half_height = parallel
+    ? camera.parallel_scale() : std::tan(glm::radians(camera.view_angle()) * 0.5f);
+  const float half_width = half_height * aspect;
+
+  const uint32_t tile = std::max(settings.tile_size, 1u);
+  const uint32_t tiles_x = (width + tile - 1) / tile;
+  const uint32_t tiles_y = (height + tile - 1) / tile;
+  const uint32_t tile_count = tiles_x * tiles_y;
+  const uint32_t spp = std::max(settings.samples_per_pixel, 1u);
+
+  auto render_tile = [&](uint32_t index, Context& ctx) {
+    const uint32_t x0 = (index % tiles_x) * tile;
+    const uint32_t y0 = (index / tiles_x) * tile;
+    for (uint32_t y = y0; y < std::min(y0 + tile, height); ++y)
+    {
+      for (uint32_t x = x0; x < std::min(x0 + tile, width); ++x)
+      {
+        const uint32_t pixel = y * width + x;
+        glm::vec3 sum(0.0f);
+        for (uint32_t s = 0; s < spp; ++s)
+        {
+          ctx.rng = Rng(hash(pixel * 9781u + hash(s)));
+          const float sx = (static_cast<float>(x) + ctx.rng.next()) / static_cast<float>(width);
+          const float sy = (static_cast<float>(y) + ctx.rng.next()) / static_cast<float>(height);
+          const float px = (2.0f * sx - 1.0f) * half_width;
+          const float py = (1.0f - 2.0f * sy) * half_height;
+          const glm::vec3 origin = parallel ? eye + px * right + py * up : eye;
+          const glm::vec3 direction = parallel
+            ? forward : glm::normalize(forward + px * right + py * up);
+          const glm::vec3 c = trace(ctx, origin, direction);
+          // A NaN or inf sample would poison the pixel; drop it.
+          if (std::isfinite(c.x) && std::isfinite(c.y) && std::isfinite(c.z))
+            sum += c;
+        }
+        float* out = &image[static_cast<size_t>(pixel) * 4];
+        out[0] = sum.x / static_cast<float>(spp);
+        out[1] = sum.y / static_cast<float>(spp);
+        out[2] = sum.z / static_cast<float>(spp);
+        out[3] = 1.0f;
+      }
+    }
+  };
+
+  // Tile ranges, one per worker, packed as (begin << 32 | end) so the owner's
+  // pop and a thief's split are each one compare-exchange.
+  uint32_t threads = settings.threads ? settings.threads : std::thread::hardware_concurrency();
+  threads = std::clamp(threads, 1u, tile_count);
+  struct alignas(64) Range
+  {
+    std::atomic<uint64_t> bounds{ 0 };
+  };
+  std::vector<Range> ranges(threads);
+  for (uint32_t w = 0; w < threads; ++w)
+  {
+    const uint64_t begin = static_cast<uint64_t>(tile_count) * w / threads;
+    const uint64_t end = static_cast<uint64_t>(tile_count) * (w + 1) / threads;
+    ranges[w].bounds.store(begin << 32 | end);
+  }
+  std::atomic<uint64_t> rays{ 0 };
+  std::atomic<uint32_t> steals{ 0 };
+
+  auto pop = [&](uint32_t w, uint32_t& index) {
+    uint64_t bounds = ranges[w].bounds.load();
+    while (true)
+    {
+      const auto begin = static_cast<uint32_t>(bounds >> 32);
+      const auto end = static_cast<uint32_t>(bounds);
+      if (begin >= end)
+        return false;
+      if (ranges[w].bounds.compare_exchange_weak(bounds, uint64_t(begin + 1) << 32 | end))
+      {
+        index = begin;
+        return true;
+      }
+    }
+  };
+
+  // Take the back half of the largest range into the thief's own (empty) range.
+  auto steal = [&](uint32_t thief) {
+    while (true)
+    {
+      uint32_t victim = UINT32_MAX;
+      uint32_t largest = 0;
+      for (uint32_t w = 0; w < threads; ++w)
+      {
+        const uint64_t bounds = ranges[w].bounds.load();
+        const auto size = static_cast<uint32_t>(bounds) - std::min(
+          static_cast<uint32_t>(bounds >> 32), static_cast<uint32_t>(bounds));
+        if (w != thief && size > largest)
+        {
+          victim = w;
+          largest = size;
+        }
+      }
+      if (victim == UINT32_MAX)
+        return false;
+
+      uint64_t bounds = ranges[victim].bounds.load();
+      const auto begin = static_cast<uint32_t>(bounds >> 32);
+      const auto end = static_cast<uint32_t>(bounds);
+      if (begin >= end)
+        continue;
+      const uint32_t take = (end - begin + 1) / 2;
+      if (ranges[victim].bounds.compare_exchange_strong(bounds, uint64_t(begin) << 32 | (end - take)))
+      {
+        ranges[thief].bounds.store(uint64_t(end - take) << 32 | end);
+        steals.fetch_add(1, std::memory_order_relaxed);
+        return true;
+      }
+    }
+  };
+
+  auto worker = [&](uint32_t w) {
+    Context ctx{ Rng(0) };
+    uint32_t index;
+    do
+    {
+      while (pop(w, index))
+        render_tile(index, ctx);
+    } while (steal(w));
+    rays.fetch_add(ctx.rays, std::memory_order_relaxed);
+  };
+
+  std::vector<std::thread> pool;
+  pool.reserve(threads - 1);
+  for (uint32_t w = 1; w < threads; ++w)
+    pool.emplace_back(worker, w);
+  worker(0);
+  for (auto& t : pool)
+    t.join();
+
+  m_stats.render_ms = std::chrono::duration<double, std::milli>(
+    std::chrono::steady_clock::now() - start).count();
+  m_stats.rays = rays.load();
+  m_stats.tiles = tile_count;
+  m_stats.steals = steals.load();
+  m_stats.threads = threads;
+  spdlog::info("PathTracer: {}x{} at {} spp in {:.1f} ms on {} threads ({:.2f} Mrays/s, {} steals)",
+    width, height, spp, m_stats.render_ms, threads, m_stats.mrays_per_second(), m_stats.steals);
+  return image;
+}
+
+ImageDiff compare_images(std::span<const float> a, std::span<const float> b)
+{
+  if (a.size() != b.size() || a.size() % 4 != 0)
+    throw std::runtime_error(fmt::format(
+      "compare_images: sizes {} and {} are not one RGBA image size", a.size(), b.size()));
+  ImageDiff diff;
+  const size_t n = a.size();
+  if (n == 0)
+    return diff;
+  double sum = 0.0;
+  for (size_t i = 0; i < n; ++i)
+  {
+    if (i % 4 == 3)
+      continue;
+    const float d = std::abs(a[i] - b[i]);
+    sum += static_cast<double>(d) * d;
+    diff.max_error = std::max(diff.max_error, d);
+  }
+  diff.rmse = std::sqrt(sum / static_cast<double>(n / 4 * 3));
+  return diff;
+}
+
+} // namespace vkwave
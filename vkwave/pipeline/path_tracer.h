@@ -0,0 +1,132 @@
+#pragma once
+
+#include <vkwave/core/bvh.h>
+#include <vkwave/core/vertex.h>
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace vkwave
+{
+
+class Camera;
+struct EquirectImage;
+struct ScenePrimitive;
+struct SceneMaterial;
+
+/// CPU reference path tracer over a loaded glTF scene: ground truth for
+/// pbr.frag, an image without a GPU-side renderer, and a Bvh4 benchmark.
+///
+/// The scene is flattened at construction: every primitive instance is
+/// transformed into world space and all triangles go into one Bvh4 (masked
+/// like the scene TLAS: 0x01 occluders, 0x02 blended / transmissive).
+/// Materials are the SceneMaterial factors times the vertex colour — the
+/// textures live on the GPU and are not sampled. The BRDF is pbr.frag's
+/// metallic-roughness model (GGX + Smith + Schlick, Lambert diffuse);
+/// transmissive materials refract as smooth dielectrics with their ior,
+/// blended ones are passed through with probability 1 - alpha, and masked
+/// ones whose factor alpha is below the cutoff are dropped.
+///
+/// Lighting is the equirect environment (the image IBL bakes from, sampled by
+/// escaping rays) and the directional sun (next-event estimation with a
+/// shadow ray). Unbiased apart from Russian roulette's noise; no clamping.
+///
+/// render() splits the image into tiles: each worker starts on its own
+/// contiguous range and, once empty, steals half of the largest remaining
+/// range. Every pixel seeds its own random sequence, so the image does not
+/// depend on the thread count or schedule (usable for image diffs).
+class PathTracer
+{
+public:
+  struct Settings
+  {
+    uint32_t samples_per_pixel{ 64 };
+    uint32_t max_bounces{ 6 };
+    uint32_t tile_size{ 16 };
+    uint32_t threads{ 0 };             // 0 = hardware concurrency
+    float environment_intensity{ 1.0f };
+    glm::vec3 sun_direction{ 1.0f };   // toward the sun (PBRContext::light_direction)
+    glm::vec3 sun_radiance{ 3.0f };    // colour * intensity
+  };
+
+  struct Stats
+  {
+    double build_ms{ 0.0 };   // flatten + BVH build
+    double render_ms{ 0.0 };  // last render()
+    uint64_t rays{ 0 };       // camera, bounce and shadow rays of the last render()
+    uint32_t tiles{ 0 };
+    uint32_t steals{ 0 };     // successful range steals
+    uint32_t threads{ 0 };
+
+    [[nodiscard]] double mrays_per_second() const
+    {
+      return render_ms > 0.0 ? static_cast<double>(rays) / (render_ms * 1e3) : 0.0;
+    }
+  };
+
+  /// Flatten `primitives` (ranges of `indices` into `vertices`, e.g.
+  /// GltfScene::vertices / indices) and build the BVH.
+  PathTracer(std::span<const Vertex> vertices, std::span<const uint32_t> indices,
+             std::span<const ScenePrimitive> primitives,
+             std::span<const SceneMaterial> materials);
+
+  /// Environment seen by escaping rays, or nullptr for black. Must outlive
+  /// render().
+  void set_environment(const EquirectImage* environment) { m_environment = environment; }
+
+  /// Trace `width` x `height` pixels through `camera` (its aspect ratio is
+  /// ignored: the image's is used). Returns linear RGBA32F, top row first,
+  /// alpha 1.
+  [[nodiscard]] std::vector<float> render(const Camera& camera, uint32_t width, uint32_t height,
+                                          const Settings& settings);
+
+  [[nodiscard]] const Bvh4& bvh() const { return m_bvh; }
+  [[nodiscard]] const Stats& stats() const { return m_stats; }
+
+private:
+  struct Material
+  {
+    glm::vec3 base_color{ 1.0f };
+    float alpha{ 1.0f };
+    float metallic{ 1.0f };
+    float roughness{ 1.0f };
+    float transmission{ 0.0f };
+    float ior{ 1.5f };
+    bool blend{ false };
+  };
+
+  struct Triangle
+  {
+    glm::vec3 normal[3]; // world space
+    glm::vec3 color[3];
+    uint32_t material;
+  };
+
+  struct Context;
+  glm::vec3 trace(Context& ctx, glm::vec3 origin, glm::vec3 direction) const;
+  glm::vec3 environment(glm::vec3 direction) const;
+
+  Bvh4 m_bvh;
+  std::vector<Triangle> m_triangles; // [BVH input triangle]
+  std::vector<glm::vec3> m_positions; // 3 per triangle
+  std::vector<Material> m_materials;
+  const EquirectImage* m_environment{ nullptr };
+  Settings m_settings;
+  Stats m_stats;
+};
+
+/// Per-channel difference of two RGBA32F images (alpha ignored).
+struct ImageDiff
+{
+  double rmse{ 0.0 };      // root mean square error
+  float max_error{ 0.0f }; // largest absolute channel difference
+};
+
+/// Difference of two RGBA32F images of the same size (e.g. render() results).
+/// @throws std::runtime_error if the sizes differ or are not a multiple of 4.
+[[nodiscard]] ImageDiff compare_images(std::span<const float> a, std::span<const float> b);
+
+} // namespace vkwave
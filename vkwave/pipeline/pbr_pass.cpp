@@ -2,6 +2,7 @@
 #include <vkwave/pipeline/execution_group.h>
 #include <vkwave/pipeline/pipeline.h>
 
+#include <vkwave/core/light_cluster.h>
 #include <vkwave/core/pbr_ubo.h>
 #include <vkwave/core/vertex.h>
 #include <vkwave/loaders/gltf_loader.h>
@@ -9,6 +10,7 @@
 #include <glm/gtc/matrix_transform.hpp>
 
 #include <algorithm>
+#include <cmath>
 #include <numeric>
 #include <vector>
 
@@ -32,6 +34,9 @@ PbrPushConstants fill_push_constants(
   if (ctx.enable_emissive)       pc.globalFlags |= PbrFlags::Emissive;
   if (ctx.enable_clearcoat)      pc.globalFlags |= PbrFlags::Clearcoat;
   if (ctx.enable_anisotropy)     pc.globalFlags |= PbrFlags::Anisotropy;
+  if (ctx.screen_space_ao)       pc.globalFlags |= PbrFlags::ScreenSpaceAO;
+  if (ctx.ray_traced_shadows)    pc.globalFlags |= PbrFlags::RayTracedShadows;
+  if (ctx.ray_traced_reflections) pc.globalFlags |= PbrFlags::RayTracedReflections;
 
   // Overrides: a value < 0 means "use the material's authored value".
   pc.metallicOverride            = ctx.metallic_override;
@@ -52,8 +57,15 @@ PipelineSpec PBRPass::pipeline_spec()
   PipelineSpec spec{};
   spec.vertex_shader = SHADER_DIR "pbr.vert";
   spec.fragment_shader = SHADER_DIR "pbr.frag";
+  spec.vertex_preamble = "#define INSTANCED 1\n";
   spec.vertex_bindings = { binding };
   spec.vertex_attributes = { attrs.begin(), attrs.end() };
+
+  // Binding 1: the instance's model matrix, one column per location (6-9).
+  spec.vertex_bindings.push_back({ 1, sizeof(glm::mat4), vk::VertexInputRate::eInstance });
+  for (uint32_t c = 0; c < 4; ++c)
+    spec.vertex_attributes.push_back({ 6 + c, 1, vk::Format::eR32G32B32A32Sfloat,
+      static_cast<uint32_t>(c * sizeof(glm::vec4)) });
 #if 0
   spec.wireframe = true;
 #endif
@@ -65,21 +77,56 @@ PipelineSpec PBRPass::pipeline_spec()
   return spec;
 }
 
-void PBRPass::record(vk::CommandBuffer cmd) const
+void PBRPass::enable_ray_query(PipelineSpec& spec)
 {
-  auto* group = ctx->group;
+  spec.fragment_preamble = "#define RAY_QUERY 1\n";
+}
 
+// Fill `group`'s UBO for the current slot from the context, then bind the
+// pipeline, viewport, scissor, sets 0 and 2, the mesh and the instance
+// transforms: the state every PBR draw loop below assumes.
+static void begin_pbr_draws(vk::CommandBuffer cmd, const PBRContext& ctx,
+                            ExecutionGroup& group)
+{
   // Update camera + light UBO for this slot
   PbrUBO ubo_data{};
-  ubo_data.viewProj = ctx->view_projection;
-  ubo_data.camPos = glm::vec4(ctx->cam_position, 0.0f);
-  ubo_data.lightDirection = glm::vec4(glm::normalize(ctx->light_direction), ctx->light_intensity);
-  ubo_data.lightColor = glm::vec4(ctx->light_color, 0.0f);
-  group->ubo(0, 0).update(&ubo_data, sizeof(ubo_data));
-
-  auto pipeline = group->pipeline();
-  auto layout = group->layout();
-  auto extent = group->extent();
+  ubo_data.viewProj = ctx.view_projection;
+  ubo_data.unjitteredViewProj = ctx.unjittered_view_projection;
+  ubo_data.prevViewProj = ctx.prev_view_projection;
+  ubo_data.camPos = glm::vec4(ctx.cam_position, 0.0f);
+  ubo_data.lightDirection = glm::vec4(glm::normalize(ctx.light_direction), ctx.light_intensity);
+  ubo_data.lightColor = glm::vec4(ctx.light_color, 0.0f);
+
+  auto pipeline = group.pipeline();
+  auto layout = group.layout();
+  // Dynamic resolution: draw into the render sub-rectangle of the attachments.
+  auto extent = group.render_extent();
+  ubo_data.viewport = render_viewport_params(group.extent(), extent);
+
+  // Froxel lookup: same slice distribution as cluster_lights.comp, tiles sized
+  // so the fixed grid spans the render extent.
+  const glm::vec2 slice = cluster_slice_params(ctx.z_near, ctx.z_far);
+  ubo_data.view = ctx.view;
+  ubo_data.clusterDepth = glm::vec4(slice,
+    static_cast<float>(extent.width) / static_cast<float>(LightCluster::GridX),
+    static_cast<float>(extent.height) / static_cast<float>(LightCluster::GridY));
+  ubo_data.clusterGrid = glm::uvec4(
+    LightCluster::GridX, LightCluster::GridY, LightCluster::GridZ, ctx.light_count);
+  if (ctx.shadow)
+    ubo_data.shadow = *ctx.shadow;
+  ubo_data.rayTracing = glm::vec4(std::tan(ctx.sun_angular_radius),
+    ctx.reflection_roughness_cutoff, ctx.ray_max_distance, static_cast<float>(ctx.frame_index % 64u));
+  if (ctx.views)
+  {
+    const uint32_t n = std::min(ctx.views->count, kMaxPbrViews);
+    ubo_data.views = glm::uvec4(n, 0, 0, 0);
+    for (uint32_t v = 0; v < n; ++v)
+    {
+      ubo_data.viewProjs[v] = ctx.views->view_projection[v];
+      ubo_data.viewCamPos[v] = glm::vec4(ctx.views->cam_position[v], 0.0f);
+    }
+  }
+  group.ubo(0, 0).update(&ubo_data, sizeof(ubo_data));
 
   cmd.bindPipeline(vk::PipelineBindPoint::eGraphics, pipeline);
 
@@ -94,18 +141,39 @@ void PBRPass::record(vk::CommandBuffer cmd) const
   vk::Rect2D scissor{ { 0, 0 }, extent };
   cmd.setScissor(0, scissor);
 
-  // Set 0: per-frame UBO (ring-buffered by slot)
-  auto ds0 = group->descriptor_set();
+  // Set 0: per-frame UBO + clustered light lists (ring-buffered by slot)
+  auto ds0 = group.descriptor_set();
   cmd.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, layout,
     0, 1, &ds0, 0, nullptr);
 
   // Set 2: per-scene IBL (singleton)
-  auto ds2 = group->descriptor_set(2, 0);
+  auto ds2 = group.descriptor_set(2, 0);
   cmd.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, layout,
     2, 1, &ds2, 0, nullptr);
 
-  ctx->mesh->bind(cmd);
+  ctx.mesh->bind(cmd);
+  cmd.bindVertexBuffers(1, 1, &ctx.instance_transforms, &ctx.instance_transforms_offset);
+}
+
+// End of the run of primitives starting at `first` that share its geometry:
+// the loader keeps a mesh's instances adjacent, so [first, end) is one
+// instanced draw. Same geometry means same material, so the whole run passes
+// or fails the per-material filters together.
+static uint32_t instance_run_end(const PBRContext& ctx, uint32_t first)
+{
+  uint32_t end = first + 1;
+  while (end < ctx.primitive_count &&
+         ctx.primitives[end].meshIndex == ctx.primitives[first].meshIndex)
+    ++end;
+  return end;
+}
+
+void PBRPass::record(vk::CommandBuffer cmd) const
+{
+  auto* group = ctx->group;
+  begin_pbr_draws(cmd, *ctx, *group);
 
+  auto layout = group->layout();
   const auto stages = vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment;
 
   auto make_pc = [&](const glm::mat4& m, uint32_t material_index) -> PbrPushConstants
@@ -136,8 +204,11 @@ void PBRPass::record(vk::CommandBuffer cmd) const
   cmd.setDepthWriteEnableEXT(VK_TRUE);
   uint32_t bound_material = UINT32_MAX;
 
-  for (uint32_t i = 0; i < ctx->primitive_count; ++i)
+  // GPU-culled draws stay one command per primitive (each instance is culled
+  // on its own); direct draws cover a whole run of instances.
+  for (uint32_t i = 0, next = 0; i < ctx->primitive_count; i = next)
   {
+    next = ctx->draw_commands ? i + 1 : instance_run_end(*ctx, i);
     auto& prim = ctx->primitives[i];
     if (prim.materialIndex >= ctx->material_count) continue;
     auto& mat = ctx->materials[prim.materialIndex];
@@ -158,7 +229,18 @@ void PBRPass::record(vk::CommandBuffer cmd) const
 
     auto pc = make_pc(prim.modelMatrix, prim.materialIndex);
     cmd.pushConstants(layout, stages, 0, sizeof(PbrPushConstants), &pc);
-    ctx->mesh->draw_indexed(cmd, prim.indexCount, prim.firstIndex, prim.vertexOffset);
+    if (ctx->draw_commands)
+    {
+      // GPU-culled: the command carries this primitive's range (or zero instances).
+      constexpr auto stride = static_cast<uint32_t>(sizeof(vk::DrawIndexedIndirectCommand));
+      cmd.drawIndexedIndirect(ctx->draw_commands,
+        ctx->draw_commands_offset + static_cast<vk::DeviceSize>(i) * stride, 1, stride);
+    }
+    else
+    {
+      ctx->mesh->draw_indexed(cmd, prim.indexCount, prim.firstIndex, prim.vertexOffset,
+        next - i, i);
+    }
   }
 }
 
@@ -168,7 +250,7 @@ void PBRPass::record(vk::CommandBuffer cmd) const
 
 void BlendPass::record(vk::CommandBuffer cmd) const
 {
-  if (!ctx->has_transparent) return;
+  if (!ctx->has_transparent || ctx->weighted_oit) return;
 
   auto* group = ctx->group;
   auto layout = group->layout();
@@ -182,7 +264,9 @@ void BlendPass::record(vk::CommandBuffer cmd) const
 
   auto make_pc = [&](const glm::mat4& m, uint32_t material_index) -> PbrPushConstants
   {
-    return fill_push_constants(*ctx, m, material_index);
+    auto pc = fill_push_constants(*ctx, m, material_index);
+    pc.globalFlags &= ~PbrFlags::ScreenSpaceAO;
+    return pc;
   };
 
   // Collect transparent primitive indices
@@ -230,7 +314,75 @@ void BlendPass::record(vk::CommandBuffer cmd) const
 
     auto pc = make_pc(prim.modelMatrix, prim.materialIndex);
     cmd.pushConstants(layout, stages, 0, sizeof(PbrPushConstants), &pc);
-    ctx->mesh->draw_indexed(cmd, prim.indexCount, prim.firstIndex, prim.vertexOffset);
+    ctx->mesh->draw_indexed(cmd, prim.indexCount, prim.firstIndex, prim.vertexOffset, 1, i);
+  }
+}
+
+// ---------------------------------------------------------------------------
+// OitPass — transparent primitives, weighted-blended (unsorted)
+// ---------------------------------------------------------------------------
+
+PipelineSpec OitPass::pipeline_spec()
+{
+  auto spec = PBRPass::pipeline_spec();
+  spec.additive_blend = true;
+  spec.depth_write = false;
+  spec.color_attachment_count = 2; // accumulation, revealage (aux)
+  spec.load_depth = true;
+  spec.store_depth = true; // the transmission pass LOADs it next
+  return spec;
+}
+
+void OitPass::record(vk::CommandBuffer cmd) const
+{
+  if (!ctx->has_transparent) return;
+
+  begin_pbr_draws(cmd, *ctx, *group);
+
+  auto layout = group->layout();
+  const auto stages = vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment;
+
+  cmd.setDepthWriteEnableEXT(VK_FALSE);
+  uint32_t bound_material = UINT32_MAX;
+
+  // Primitive order: the blend is commutative, so only material changes matter
+  // and direct draws can cover a whole run of instances.
+  for (uint32_t i = 0, next = 0; i < ctx->primitive_count; i = next)
+  {
+    next = draw_commands ? i + 1 : instance_run_end(*ctx, i);
+    auto& prim = ctx->primitives[i];
+    if (prim.materialIndex >= ctx->material_count) continue;
+    auto& mat = ctx->materials[prim.materialIndex];
+    if (mat.alphaMode != AlphaMode::Blend) continue;
+    // Transmissive prims belong to the transmission pass, even if also BLEND.
+    if (ctx->defer_transmissive && mat.transmissionFactor > 0.0f) continue;
+
+    if (prim.materialIndex != bound_material)
+    {
+      auto ds1 = group->descriptor_set(1, prim.materialIndex);
+      cmd.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, layout,
+        1, 1, &ds1, 0, nullptr);
+      bound_material = prim.materialIndex;
+    }
+
+    cmd.setCullModeEXT(mat.doubleSided
+      ? vk::CullModeFlagBits::eNone : vk::CullModeFlagBits::eBack);
+
+    auto pc = fill_push_constants(*ctx, prim.modelMatrix, prim.materialIndex);
+    pc.globalFlags = (pc.globalFlags | PbrFlags::WeightedOit) & ~PbrFlags::ScreenSpaceAO;
+    cmd.pushConstants(layout, stages, 0, sizeof(PbrPushConstants), &pc);
+    if (draw_commands)
+    {
+      constexpr auto stride = static_cast<uint32_t>(sizeof(vk::DrawIndexedIndirectCommand));
+      const auto entry = static_cast<vk::DeviceSize>(i) * stride;
+      cmd.drawIndexedIndirect(draw_commands, draw_commands_offset[0] + entry, 1, stride);
+      cmd.drawIndexedIndirect(draw_commands, draw_commands_offset[1] + entry, 1, stride);
+    }
+    else
+    {
+      ctx->mesh->draw_indexed(cmd, prim.indexCount, prim.firstIndex, prim.vertexOffset,
+        next - i, i);
+    }
   }
 }
 
@@ -16,7 +16,7 @@ struct SceneMaterial;
 
 /// Shared state for all PBR-related passes.
 ///
-/// Owned by Scene, read by PBRPass and BlendPass.
+/// Owned by Scene, read by PBRPass, BlendPass and OitPass.
 /// All raw pointers and POD -- trivially destructible.
 struct PBRContext
 {
@@ -30,14 +30,39 @@ struct PBRContext
   uint32_t material_count{ 0 };
   bool has_transparent{ false };
 
+  // Per-instance model matrices, one glm::mat4 per primitive in primitive
+  // order (a single identity for the legacy mesh), bound at vertex binding 1
+  // of pipelines built from PBRPass::pipeline_spec(). Draws pass the primitive
+  // index as firstInstance, so adjacent instances of one geometry (same
+  // meshIndex) go out as one instanced draw. The matrices start at
+  // instance_transforms_offset (the slot's region when they move per frame).
+  vk::Buffer instance_transforms{ VK_NULL_HANDLE };
+  vk::DeviceSize instance_transforms_offset{ 0 };
+
   // When true, the transmission pass owns transmissive primitives
   // (transmissionFactor > 0), so the opaque/blend passes skip them — they would
   // otherwise write depth and block the transmission redraw, and pollute the
   // background snapshot. Set by the app when a transmission group is present.
   bool defer_transmissive{ false };
 
-  // Camera (updated per-frame by Scene::update)
+  // When true, the OIT pass owns the blended primitives (weighted-blended OIT
+  // into its own targets), so BlendPass skips them. Set by the app when the
+  // OIT group is present.
+  bool weighted_oit{ false };
+
+  // GPU occlusion culling (HiZCuller). When set, opaque primitives are drawn
+  // with vkCmdDrawIndexedIndirect from this buffer — one command per primitive
+  // at draw_commands_offset + i * stride, instanceCount 0 when culled — instead
+  // of direct draws. Set per slot/phase by the app before each record.
+  vk::Buffer draw_commands{ VK_NULL_HANDLE };
+  vk::DeviceSize draw_commands_offset{ 0 };
+
+  // Camera (updated per-frame by Scene::update). view_projection includes the
+  // temporal-AA jitter (if any); the unjittered current/previous pair feeds the
+  // motion vectors.
   glm::mat4 view_projection{ 1.0f };
+  glm::mat4 unjittered_view_projection{ 1.0f };
+  glm::mat4 prev_view_projection{ 1.0f };
   glm::vec3 cam_position{};
 
   // Per-frame
@@ -50,6 +75,22 @@ struct PBRContext
   bool enable_clearcoat{ true };
   bool enable_anisotropy{ true };
 
+  // Occlude the IBL with set 0's ambientOcclusion (AmbientOcclusion's
+  // previous output). Set per slot by the app once that output exists; the
+  // blended passes ignore it (their surfaces are not in the depth it used).
+  bool screen_space_ao{ false };
+
+  // Ray-query shadows for the directional light (replacing the cascades) and
+  // ray-query occlusion of the specular IBL. Only for a pipeline compiled with
+  // PBRPass::enable_ray_query() and set 2's sceneTLAS written; the app leaves
+  // them off otherwise (raster fallback).
+  bool ray_traced_shadows{ false };
+  bool ray_traced_reflections{ false };
+  float sun_angular_radius{ 0.0f };          // radians; 0 = hard shadows
+  float reflection_roughness_cutoff{ 0.4f }; // perceptual roughness above which the IBL is kept
+  float ray_max_distance{ 1000.0f };         // world units
+  uint32_t frame_index{ 0 };                 // animates the per-pixel ray jitter
+
   // Optional global metallic/roughness preview overrides. When >= 0, the value
   // replaces every material's authored factor (e.g. to tweak the single-material
   // cube). When < 0 (default), materials use their authored SSBO values.
@@ -75,6 +116,24 @@ struct PBRContext
   glm::vec3 light_direction{ 1.0f, 1.0f, 1.0f };
   float light_intensity{ 3.0f };
   glm::vec3 light_color{ 1.0f };
+
+  // Clustered point/spot lights (ClusteredLights). The app culls them into the
+  // froxel grid before the scene pass and binds the per-slot lists at set 0;
+  // light_count == 0 skips the fragment shader's cluster loop.
+  glm::mat4 view{ 1.0f };
+  float z_near{ 0.1f };
+  float z_far{ 1000.0f };
+  uint32_t light_count{ 0 };
+
+  // Directional-light cascaded shadows (ShadowCascades). Copied into the UBO by
+  // PBRPass; nullptr leaves the directional light unshadowed.
+  const ShadowUniforms* shadow{ nullptr };
+
+  // Multiview: per-view cameras for a group whose render pass has a view mask
+  // (one draw renders every layer). nullptr renders the single camera above.
+  // Shadows, clustered lights and motion vectors follow the single camera, so a
+  // multiview group leaves them off.
+  const PbrViews* views{ nullptr };
 };
 
 static_assert(std::is_trivially_destructible_v<PBRContext>,
@@ -96,8 +155,15 @@ struct PBRPass : Pass<PBRPass>
   glm::mat4 model{ 1.0f };
 
   /// Returns the PipelineSpec for this pass (shader paths, vertex layout, etc.).
+  /// pbr.vert is compiled INSTANCED: the model matrix comes from the
+  /// per-instance stream (PBRContext::instance_transforms), not the push constant.
   static PipelineSpec pipeline_spec();
 
+  /// Compile `spec`'s fragment shader (pbr.frag) with RAY_QUERY: set 2 gains
+  /// the sceneTLAS binding (5), which must then be written. Needs
+  /// Device::supports_ray_query().
+  static void enable_ray_query(PipelineSpec& spec);
+
   /// Record: update UBO, bind pipeline state, draw opaque primitives.
   void record(vk::CommandBuffer cmd) const;
 };
@@ -111,7 +177,12 @@ static_assert(std::is_trivially_destructible_v<PBRPass>,
 /// Assumes PBRPass has already bound the pipeline, viewport, scissor,
 /// sets 0 and 2, and the mesh. Only binds set 1 per material change.
 ///
-/// Skipped entirely when ctx->has_transparent is false.
+/// The sort is per primitive, so intersecting transparent meshes can still
+/// composite in the wrong order. This is the fallback where OitPass cannot run
+/// (MSAA, multiview).
+///
+/// Skipped entirely when ctx->has_transparent is false or ctx->weighted_oit is
+/// set.
 struct BlendPass : Pass<BlendPass>
 {
   const PBRContext* ctx{ nullptr };
@@ -122,6 +193,41 @@ struct BlendPass : Pass<BlendPass>
 static_assert(std::is_trivially_destructible_v<BlendPass>,
   "BlendPass must be trivially destructible");
 
+/// Weighted-blended order-independent transparency (McGuire & Bavoil 2013).
+///
+/// Draws the alpha-blended primitives in primitive order (no sort) into an
+/// accumulation + revealage target pair with additive blending, depth-tested
+/// but not written against the opaque depth. OitResolve then composites them
+/// over the HDR. Blending is per fragment, so intersecting transparent meshes
+/// resolve correctly.
+///
+/// Runs in its own group (pbr.vert/pbr.frag with OitPass::pipeline_spec()),
+/// so it updates that group's UBO and binds all of its state itself.
+///
+/// Skipped entirely when ctx->has_transparent is false.
+struct OitPass : Pass<OitPass>
+{
+  const PBRContext* ctx{ nullptr };
+  ExecutionGroup* group{ nullptr };
+
+  // GPU occlusion culling: this slot's HiZ indirect commands, or null for
+  // direct draws. Both runs are drawn (phase 0 at draw_commands_offset[0], the
+  // disoccluded phase 1 at [1]); a visible primitive is live in exactly one.
+  // Set per slot by the app before each record.
+  vk::Buffer draw_commands{ VK_NULL_HANDLE };
+  vk::DeviceSize draw_commands_offset[2]{};
+
+  /// PBRPass::pipeline_spec() with additive blending, no depth writes, two
+  /// color outputs (accumulation, revealage) and a depth LOAD. The caller sets
+  /// the revealage format (aux_color_format) and the render pass fallback.
+  static PipelineSpec pipeline_spec();
+
+  void record(vk::CommandBuffer cmd) const;
+};
+
+static_assert(std::is_trivially_destructible_v<OitPass>,
+  "OitPass must be trivially destructible");
+
 /// Fill the shared PBR push constants (model transform, global UI flags/overrides)
 /// for a draw. Shared with TransmissionPass, which reuses the same push-constant
 /// block via pbr.vert.
@@ -1,8 +1,11 @@
 #include <vkwave/pipeline/pipeline.h>
 
+#include <vkwave/core/depth_stencil_attachment.h>
 #include <vkwave/pipeline/shader_reflection.h>
 #include <vkwave/pipeline/shaders.h>
 
+#include <array>
+#include <cassert>
 #include <iostream>
 
 namespace vkwave
@@ -168,9 +171,12 @@ vk::RenderPass make_renderpass(vk::Device device, vk::Format swapchainImageForma
 
 vk::RenderPass make_scene_renderpass(vk::Device device, vk::Format hdrFormat,
   vk::Format depthFormat, bool debug,
-  vk::SampleCountFlagBits msaaSamples, bool storeDepth)
+  vk::SampleCountFlagBits msaaSamples, bool storeDepth, vk::Format velocityFormat,
+  uint32_t viewMask)
 {
   const bool msaa = msaaSamples != vk::SampleCountFlagBits::e1;
+  const bool velocity = velocityFormat != vk::Format::eUndefined;
+  assert(!(msaa && velocity) && "motion vectors are single-sample only");
   std::vector<vk::AttachmentDescription> attachments;
 
   // Attachment 0: Color (MSAA or single-sample, HDR format)
@@ -216,14 +222,31 @@ vk::RenderPass make_scene_renderpass(vk::Device device, vk::Format hdrFormat,
     attachments.push_back(resolveAttachment);
   }
 
-  vk::AttachmentReference colorRef{ 0, vk::ImageLayout::eColorAttachmentOptimal };
+  // Attachment 2 (single-sample only): motion vectors, sampled by TAA.
+  if (velocity)
+  {
+    vk::AttachmentDescription velocityAttachment{};
+    velocityAttachment.format = velocityFormat;
+    velocityAttachment.samples = vk::SampleCountFlagBits::e1;
+    velocityAttachment.loadOp = vk::AttachmentLoadOp::eClear;
+    velocityAttachment.storeOp = vk::AttachmentStoreOp::eStore;
+    velocityAttachment.stencilLoadOp = vk::AttachmentLoadOp::eDontCare;
+    velocityAttachment.stencilStoreOp = vk::AttachmentStoreOp::eDontCare;
+    velocityAttachment.initialLayout = vk::ImageLayout::eUndefined;
+    velocityAttachment.finalLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
+    attachments.push_back(velocityAttachment);
+  }
+
+  const std::array<vk::AttachmentReference, 2> colorRefs{
+    vk::AttachmentReference{ 0, vk::ImageLayout::eColorAttachmentOptimal },
+    vk::AttachmentReference{ 2, vk::ImageLayout::eColorAttachmentOptimal } };
   vk::AttachmentReference depthRef{ 1, vk::ImageLayout::eDepthStencilAttachmentOptimal };
   vk::AttachmentReference resolveRef{ 2, vk::ImageLayout::eColorAttachmentOptimal };
 
   vk::SubpassDescription subpass{};
   subpass.pipelineBindPoint = vk::PipelineBindPoint::eGraphics;
-  subpass.colorAttachmentCount = 1;
-  subpass.pColorAttachments = &colorRef;
+  subpass.colorAttachmentCount = velocity ? 2 : 1;
+  subpass.pColorAttachments = colorRefs.data();
   subpass.pDepthStencilAttachment = &depthRef;
   if (msaa)
   {
@@ -249,6 +272,19 @@ vk::RenderPass make_scene_renderpass(vk::Device device, vk::Format hdrFormat,
   rpInfo.dependencyCount = 1;
   rpInfo.pDependencies = &dependency;
 
+  // Multiview: the subpass broadcasts each draw to every layer in viewMask. The
+  // views are different cameras on the same scene, so they are declared
+  // correlated (an implementation may share work between them).
+  vk::RenderPassMultiviewCreateInfo multiview{};
+  if (viewMask != 0)
+  {
+    multiview.subpassCount = 1;
+    multiview.pViewMasks = &viewMask;
+    multiview.correlationMaskCount = 1;
+    multiview.pCorrelationMasks = &viewMask;
+    rpInfo.pNext = &multiview;
+  }
+
   try
   {
     return device.createRenderPass(rpInfo);
@@ -262,8 +298,9 @@ vk::RenderPass make_scene_renderpass(vk::Device device, vk::Format hdrFormat,
 }
 
 vk::RenderPass make_transmission_renderpass(vk::Device device, vk::Format hdrFormat,
-  vk::Format depthFormat, bool debug)
+  vk::Format depthFormat, bool debug, bool storeDepth, vk::Format velocityFormat)
 {
+  const bool velocity = velocityFormat != vk::Format::eUndefined;
   std::vector<vk::AttachmentDescription> attachments;
 
   // Attachment 0: HDR color — LOAD the opaque result, draw glass on top, keep it
@@ -281,35 +318,48 @@ vk::RenderPass make_transmission_renderpass(vk::Device device, vk::Format hdrFor
   attachments.push_back(colorAttachment);
 
   // Attachment 1: shared depth — LOAD the opaque depth so glass is occluded by
-  // opaque geometry. Not stored (only used for testing within this pass).
+  // opaque geometry. Stored only when a later pass LOADs it again.
   vk::AttachmentDescription depthAttachment{};
   depthAttachment.format = depthFormat;
   depthAttachment.samples = vk::SampleCountFlagBits::e1;
   depthAttachment.loadOp = vk::AttachmentLoadOp::eLoad;
-  depthAttachment.storeOp = vk::AttachmentStoreOp::eDontCare;
+  depthAttachment.storeOp = storeDepth
+    ? vk::AttachmentStoreOp::eStore : vk::AttachmentStoreOp::eDontCare;
   depthAttachment.stencilLoadOp = vk::AttachmentLoadOp::eDontCare;
   depthAttachment.stencilStoreOp = vk::AttachmentStoreOp::eDontCare;
   depthAttachment.initialLayout = vk::ImageLayout::eDepthStencilAttachmentOptimal;
   depthAttachment.finalLayout = vk::ImageLayout::eDepthStencilAttachmentOptimal;
   attachments.push_back(depthAttachment);
 
-  vk::AttachmentReference colorRef{ 0, vk::ImageLayout::eColorAttachmentOptimal };
+  // Attachment 2 (optional): the scene pass's motion vectors, kept and extended.
+  if (velocity)
+  {
+    vk::AttachmentDescription velocityAttachment = colorAttachment;
+    velocityAttachment.format = velocityFormat;
+    attachments.push_back(velocityAttachment);
+  }
+
+  const std::array<vk::AttachmentReference, 2> colorRefs{
+    vk::AttachmentReference{ 0, vk::ImageLayout::eColorAttachmentOptimal },
+    vk::AttachmentReference{ 2, vk::ImageLayout::eColorAttachmentOptimal } };
   vk::AttachmentReference depthRef{ 1, vk::ImageLayout::eDepthStencilAttachmentOptimal };
 
   vk::SubpassDescription subpass{};
   subpass.pipelineBindPoint = vk::PipelineBindPoint::eGraphics;
-  subpass.colorAttachmentCount = 1;
-  subpass.pColorAttachments = &colorRef;
+  subpass.colorAttachmentCount = velocity ? 2 : 1;
+  subpass.pColorAttachments = colorRefs.data();
   subpass.pDepthStencilAttachment = &depthRef;
 
-  // External dependency: the snapshot copy left HDR ShaderReadOnly via a transfer
-  // write, and opaque wrote depth. Wait on both before the load/transition.
+  // External dependency: the snapshot (transfer copy, or the compute mip chain)
+  // left HDR ShaderReadOnly after reading it, and opaque wrote depth. Wait on
+  // both before the load/transition.
   vk::SubpassDependency dependency{};
   dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
   dependency.dstSubpass = 0;
   dependency.srcStageMask =
     vk::PipelineStageFlagBits::eColorAttachmentOutput |
-    vk::PipelineStageFlagBits::eEarlyFragmentTests | vk::PipelineStageFlagBits::eTransfer;
+    vk::PipelineStageFlagBits::eEarlyFragmentTests | vk::PipelineStageFlagBits::eTransfer |
+    vk::PipelineStageFlagBits::eComputeShader;
   dependency.srcAccessMask = vk::AccessFlagBits::eNone;
   dependency.dstStageMask =
     vk::PipelineStageFlagBits::eColorAttachmentOutput | vk::PipelineStageFlagBits::eEarlyFragmentTests;
@@ -340,6 +390,149 @@ vk::RenderPass make_transmission_renderpass(vk::Device device, vk::Format hdrFor
   return nullptr;
 }
 
+vk::RenderPass make_oit_renderpass(vk::Device device, vk::Format accumFormat,
+  vk::Format revealFormat, vk::Format depthFormat, bool debug)
+{
+  std::vector<vk::AttachmentDescription> attachments;
+
+  // Attachment 0: accumulation — cleared to zero, summed into by the additive
+  // blend, left sampleable for the resolve.
+  vk::AttachmentDescription accumAttachment{};
+  accumAttachment.format = accumFormat;
+  accumAttachment.samples = vk::SampleCountFlagBits::e1;
+  accumAttachment.loadOp = vk::AttachmentLoadOp::eClear;
+  accumAttachment.storeOp = vk::AttachmentStoreOp::eStore;
+  accumAttachment.stencilLoadOp = vk::AttachmentLoadOp::eDontCare;
+  accumAttachment.stencilStoreOp = vk::AttachmentStoreOp::eDontCare;
+  accumAttachment.initialLayout = vk::ImageLayout::eUndefined;
+  accumAttachment.finalLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
+  attachments.push_back(accumAttachment);
+
+  // Attachment 1: shared depth — LOADed and tested, never written (the pass
+  // disables depth writes); stored for the transmission pass after it.
+  vk::AttachmentDescription depthAttachment{};
+  depthAttachment.format = depthFormat;
+  depthAttachment.samples = vk::SampleCountFlagBits::e1;
+  depthAttachment.loadOp = vk::AttachmentLoadOp::eLoad;
+  depthAttachment.storeOp = vk::AttachmentStoreOp::eStore;
+  depthAttachment.stencilLoadOp = vk::AttachmentLoadOp::eDontCare;
+  depthAttachment.stencilStoreOp = vk::AttachmentStoreOp::eDontCare;
+  depthAttachment.initialLayout = vk::ImageLayout::eDepthStencilAttachmentOptimal;
+  depthAttachment.finalLayout = vk::ImageLayout::eDepthStencilAttachmentOptimal;
+  attachments.push_back(depthAttachment);
+
+  // Attachment 2: revealage (fragment output location 1), like the accumulation.
+  vk::AttachmentDescription revealAttachment = accumAttachment;
+  revealAttachment.format = revealFormat;
+  attachments.push_back(revealAttachment);
+
+  const std::array<vk::AttachmentReference, 2> colorRefs{
+    vk::AttachmentReference{ 0, vk::ImageLayout::eColorAttachmentOptimal },
+    vk::AttachmentReference{ 2, vk::ImageLayout::eColorAttachmentOptimal } };
+  vk::AttachmentReference depthRef{ 1, vk::ImageLayout::eDepthStencilAttachmentOptimal };
+
+  vk::SubpassDescription subpass{};
+  subpass.pipelineBindPoint = vk::PipelineBindPoint::eGraphics;
+  subpass.colorAttachmentCount = static_cast<uint32_t>(colorRefs.size());
+  subpass.pColorAttachments = colorRefs.data();
+  subpass.pDepthStencilAttachment = &depthRef;
+
+  // The opaque pass wrote the depth; the previous resolve of this slot read
+  // the colors (compute).
+  vk::SubpassDependency dependency{};
+  dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
+  dependency.dstSubpass = 0;
+  dependency.srcStageMask =
+    vk::PipelineStageFlagBits::eColorAttachmentOutput | vk::PipelineStageFlagBits::eLateFragmentTests |
+    vk::PipelineStageFlagBits::eComputeShader;
+  dependency.srcAccessMask = vk::AccessFlagBits::eDepthStencilAttachmentWrite;
+  dependency.dstStageMask =
+    vk::PipelineStageFlagBits::eColorAttachmentOutput | vk::PipelineStageFlagBits::eEarlyFragmentTests;
+  dependency.dstAccessMask =
+    vk::AccessFlagBits::eColorAttachmentWrite | vk::AccessFlagBits::eColorAttachmentRead |
+    vk::AccessFlagBits::eDepthStencilAttachmentRead;
+
+  vk::RenderPassCreateInfo rpInfo{};
+  rpInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+  rpInfo.pAttachments = attachments.data();
+  rpInfo.subpassCount = 1;
+  rpInfo.pSubpasses = &subpass;
+  rpInfo.dependencyCount = 1;
+  rpInfo.pDependencies = &dependency;
+
+  try
+  {
+    return device.createRenderPass(rpInfo);
+  }
+  catch (vk::SystemError err)
+  {
+    if (debug)
+      std::cout << "Failed to create OIT renderpass!" << std::endl;
+  }
+  return nullptr;
+}
+
+vk::RenderPass make_shadow_renderpass(vk::Device device, vk::Format depthFormat, bool debug)
+{
+  // Attachment 0: one layer of the shadow map. Cleared every time the cascade
+  // is rendered (previous content is never needed), stored, and handed back to
+  // the scene pass in eShaderReadOnlyOptimal.
+  vk::AttachmentDescription depthAttachment{};
+  depthAttachment.format = depthFormat;
+  depthAttachment.samples = vk::SampleCountFlagBits::e1;
+  depthAttachment.loadOp = vk::AttachmentLoadOp::eClear;
+  depthAttachment.storeOp = vk::AttachmentStoreOp::eStore;
+  depthAttachment.stencilLoadOp = vk::AttachmentLoadOp::eDontCare;
+  depthAttachment.stencilStoreOp = vk::AttachmentStoreOp::eDontCare;
+  depthAttachment.initialLayout = vk::ImageLayout::eUndefined;
+  depthAttachment.finalLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
+
+  vk::AttachmentReference depthRef{ 0, vk::ImageLayout::eDepthStencilAttachmentOptimal };
+
+  vk::SubpassDescription subpass{};
+  subpass.pipelineBindPoint = vk::PipelineBindPoint::eGraphics;
+  subpass.colorAttachmentCount = 0;
+  subpass.pDepthStencilAttachment = &depthRef;
+
+  // The layer is read by fragment shaders of earlier frames on the same queue
+  // (write-after-read), then by this frame's scene pass (read-after-write).
+  std::array<vk::SubpassDependency, 2> dependencies{};
+  dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+  dependencies[0].dstSubpass = 0;
+  dependencies[0].srcStageMask = vk::PipelineStageFlagBits::eFragmentShader;
+  dependencies[0].srcAccessMask = vk::AccessFlagBits::eNone;
+  dependencies[0].dstStageMask =
+    vk::PipelineStageFlagBits::eEarlyFragmentTests | vk::PipelineStageFlagBits::eLateFragmentTests;
+  dependencies[0].dstAccessMask =
+    vk::AccessFlagBits::eDepthStencilAttachmentRead | vk::AccessFlagBits::eDepthStencilAttachmentWrite;
+
+  dependencies[1].srcSubpass = 0;
+  dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+  dependencies[1].srcStageMask = vk::PipelineStageFlagBits::eLateFragmentTests;
+  dependencies[1].srcAccessMask = vk::AccessFlagBits::eDepthStencilAttachmentWrite;
+  dependencies[1].dstStageMask = vk::PipelineStageFlagBits::eFragmentShader;
+  dependencies[1].dstAccessMask = vk::AccessFlagBits::eShaderRead;
+
+  vk::RenderPassCreateInfo rpInfo{};
+  rpInfo.attachmentCount = 1;
+  rpInfo.pAttachments = &depthAttachment;
+  rpInfo.subpassCount = 1;
+  rpInfo.pSubpasses = &subpass;
+  rpInfo.dependencyCount = static_cast<uint32_t>(dependencies.size());
+  rpInfo.pDependencies = dependencies.data();
+
+  try
+  {
+    return device.createRenderPass(rpInfo);
+  }
+  catch (vk::SystemError err)
+  {
+    if (debug)
+      std::cout << "Failed to create shadow renderpass!" << std::endl;
+  }
+  return nullptr;
+}
+
 vk::RenderPass make_composite_renderpass(vk::Device device, vk::Format swapchainFormat, bool debug)
 {
   // Single color attachment (swapchain image), no depth, no MSAA
@@ -466,29 +659,34 @@ GraphicsPipelineOutBundle create_graphics_pipeline(
   rasterizer.cullMode =
     specification.backfaceCulling ? vk::CullModeFlagBits::eBack : vk::CullModeFlagBits::eNone;
   rasterizer.frontFace = vk::FrontFace::eCounterClockwise;
-  rasterizer.depthBiasEnable = VK_FALSE; // Depth bias can be useful in shadow maps.
+  // Constant + slope factors are dynamic (vkCmdSetDepthBias) when enabled.
+  rasterizer.depthBiasEnable = specification.depthBiasEnabled ? VK_TRUE : VK_FALSE;
   pipelineInfo.pRasterizationState = &rasterizer;
 
-  // Fragment Shader
+  // Fragment Shader (none for depth-only pipelines, e.g. shadow maps)
+  const bool depthOnly = !specification.fragmentModule && specification.fragmentFilepath.empty();
   bool ownsFragmentShader = false;
   vk::ShaderModule fragmentShader;
   if (specification.fragmentModule)
   {
     fragmentShader = specification.fragmentModule;
   }
-  else
+  else if (!depthOnly)
   {
     if (debug)
       std::cout << "Create fragment shader module" << std::endl;
     fragmentShader = vkwave::createModule(specification.fragmentFilepath, specification.device, debug);
     ownsFragmentShader = true;
   }
-  vk::PipelineShaderStageCreateInfo fragmentShaderInfo = {};
-  fragmentShaderInfo.flags = vk::PipelineShaderStageCreateFlags();
-  fragmentShaderInfo.stage = vk::ShaderStageFlagBits::eFragment;
-  fragmentShaderInfo.module = fragmentShader;
-  fragmentShaderInfo.pName = "main";
-  shaderStages.push_back(fragmentShaderInfo);
+  if (!depthOnly)
+  {
+    vk::PipelineShaderStageCreateInfo fragmentShaderInfo = {};
+    fragmentShaderInfo.flags = vk::PipelineShaderStageCreateFlags();
+    fragmentShaderInfo.stage = vk::ShaderStageFlagBits::eFragment;
+    fragmentShaderInfo.module = fragmentShader;
+    fragmentShaderInfo.pName = "main";
+    shaderStages.push_back(fragmentShaderInfo);
+  }
   // Now both shaders have been made, we can declare them to the pipeline info
   pipelineInfo.stageCount = shaderStages.size();
   pipelineInfo.pStages = shaderStages.data();
@@ -504,7 +702,8 @@ GraphicsPipelineOutBundle create_graphics_pipeline(
   vk::PipelineDepthStencilStateCreateInfo depthStencil = {};
   depthStencil.depthTestEnable = specification.depthTestEnabled ? VK_TRUE : VK_FALSE;
   depthStencil.depthWriteEnable = (specification.depthTestEnabled && specification.depthWriteEnabled) ? VK_TRUE : VK_FALSE;
-  depthStencil.depthCompareOp = vk::CompareOp::eLess;
+  depthStencil.depthCompareOp =
+    specification.depthReversed ? vk::CompareOp::eGreater : vk::CompareOp::eLess;
   depthStencil.depthBoundsTestEnable = VK_FALSE;
   depthStencil.stencilTestEnable = VK_FALSE;
 
@@ -529,7 +728,17 @@ GraphicsPipelineOutBundle create_graphics_pipeline(
   colorBlendAttachment.colorWriteMask = vk::ColorComponentFlagBits::eR |
     vk::ColorComponentFlagBits::eG | vk::ColorComponentFlagBits::eB |
     vk::ColorComponentFlagBits::eA;
-  if (specification.blendEnabled)
+  if (specification.blendEnabled && specification.blendAdditive)
+  {
+    colorBlendAttachment.blendEnable = VK_TRUE;
+    colorBlendAttachment.srcColorBlendFactor = vk::BlendFactor::eOne;
+    colorBlendAttachment.dstColorBlendFactor = vk::BlendFactor::eOne;
+    colorBlendAttachment.colorBlendOp = vk::BlendOp::eAdd;
+    colorBlendAttachment.srcAlphaBlendFactor = vk::BlendFactor::eOne;
+    colorBlendAttachment.dstAlphaBlendFactor = vk::BlendFactor::eOne;
+    colorBlendAttachment.alphaBlendOp = vk::BlendOp::eAdd;
+  }
+  else if (specification.blendEnabled)
   {
     colorBlendAttachment.blendEnable = VK_TRUE;
     // RGB: SRC_ALPHA / ONE_MINUS_SRC_ALPHA / ADD (matches Khronos Sample-Viewer)
@@ -549,8 +758,10 @@ GraphicsPipelineOutBundle create_graphics_pipeline(
   colorBlending.flags = vk::PipelineColorBlendStateCreateFlags();
   colorBlending.logicOpEnable = VK_FALSE;
   colorBlending.logicOp = vk::LogicOp::eCopy;
-  colorBlending.attachmentCount = 1;
-  colorBlending.pAttachments = &colorBlendAttachment;
+  const std::vector<vk::PipelineColorBlendAttachmentState> colorBlendAttachments(
+    depthOnly ? 0 : specification.colorAttachmentCount, colorBlendAttachment);
+  colorBlending.attachmentCount = static_cast<uint32_t>(colorBlendAttachments.size());
+  colorBlending.pAttachments = colorBlendAttachments.data();
   colorBlending.blendConstants[0] = 0.0f;
   colorBlending.blendConstants[1] = 0.0f;
   colorBlending.blendConstants[2] = 0.0f;
@@ -593,10 +804,40 @@ GraphicsPipelineOutBundle create_graphics_pipeline(
   }
   pipelineInfo.layout = pipelineLayout;
 
-  // Renderpass - use existing if provided, otherwise create new
+  // Dynamic rendering: attachment formats instead of a render pass
+  std::vector<vk::Format> colorFormats;
+  vk::PipelineRenderingCreateInfoKHR renderingInfo{};
+  if (specification.dynamicRendering && !depthOnly)
+  {
+    colorFormats = specification.colorAttachmentFormats;
+    if (colorFormats.empty())
+      colorFormats.assign(specification.colorAttachmentCount, specification.swapchainImageFormat);
+  }
+  if (specification.dynamicRendering)
+  {
+    renderingInfo.colorAttachmentCount = static_cast<uint32_t>(colorFormats.size());
+    renderingInfo.pColorAttachmentFormats = colorFormats.data();
+    if (specification.depthTestEnabled)
+    {
+      renderingInfo.depthAttachmentFormat = specification.depthFormat;
+      if (format_has_stencil(specification.depthFormat))
+        renderingInfo.stencilAttachmentFormat = specification.depthFormat;
+    }
+    pipelineInfo.pNext = &renderingInfo;
+  }
+
+  // Renderpass - use existing if provided, otherwise create new (none for
+  // dynamic rendering)
   vk::RenderPass renderpass;
   bool ownsRenderPass = false;
-  if (specification.existingRenderPass)
+  if (specification.dynamicRendering)
+  {
+    if (debug)
+    {
+      std::cout << "Using dynamic rendering (no RenderPass)" << std::endl;
+    }
+  }
+  else if (specification.existingRenderPass)
   {
     if (debug)
     {
@@ -634,6 +875,10 @@ GraphicsPipelineOutBundle create_graphics_pipeline(
   {
     dynamicStates.push_back(vk::DynamicState::eStencilReference);
   }
+  if (specification.depthBiasEnabled)
+  {
+    dynamicStates.push_back(vk::DynamicState::eDepthBias);
+  }
   vk::PipelineDynamicStateCreateInfo dynamicState = {};
   dynamicState.dynamicStateCount = static_cast<uint32_t>(dynamicStates.size());
   dynamicState.pDynamicStates = dynamicStates.data();
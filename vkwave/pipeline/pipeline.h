@@ -18,7 +18,7 @@ struct GraphicsPipelineInBundle
 {
   vk::Device device;
   std::string vertexFilepath;
-  std::string fragmentFilepath;
+  std::string fragmentFilepath; // empty + no fragmentModule => depth-only pipeline
   vk::Extent2D swapchainExtent;
   vk::Format swapchainImageFormat;
   vk::DescriptorSetLayout descriptorSetLayout{ VK_NULL_HANDLE }; // Optional
@@ -44,17 +44,35 @@ struct GraphicsPipelineInBundle
   // Depth testing
   bool depthTestEnabled{ false };
   bool depthWriteEnabled{ true };
+  bool depthReversed{ false }; // compare GREATER (reversed-Z) instead of LESS
   vk::Format depthFormat{ vk::Format::eD32Sfloat };
 
+  // Depth bias (shadow maps). Factors are dynamic state: vkCmdSetDepthBias.
+  bool depthBiasEnabled{ false };
+
   // Stencil write (for SSS masking — writes stencil ref per draw)
   bool stencilWriteEnabled{ false };
 
   // Blending
   bool blendEnabled{ false };
+  // ONE + ONE instead of alpha blending (order-independent accumulation).
+  bool blendAdditive{ false };
+
+  // Color attachments written by the subpass (e.g. 2 = HDR + motion vectors).
+  // All share the blend state above (no independentBlend).
+  uint32_t colorAttachmentCount{ 1 };
 
   // Optional: use existing render pass instead of creating new one
   vk::RenderPass existingRenderPass{ VK_NULL_HANDLE };
 
+  // Dynamic rendering: create the pipeline against attachment formats only
+  // (VkPipelineRenderingCreateInfo) — no render pass is used or created.
+  // colorAttachmentFormats has one entry per color attachment (empty = the
+  // swapchainImageFormat for each); depth (and stencil, if the format has one)
+  // is depthFormat when depth testing is enabled.
+  bool dynamicRendering{ false };
+  std::vector<vk::Format> colorAttachmentFormats;
+
   // Optional: use existing pipeline layout instead of creating new one
   vk::PipelineLayout existingPipelineLayout{ VK_NULL_HANDLE };
 
@@ -89,10 +107,16 @@ vk::RenderPass make_renderpass(vk::Device device, vk::Format swapchainImageForma
 /// The resolved HDR image ends in eShaderReadOnlyOptimal for sampling by the composite pass.
 /// @param storeDepth keep the depth buffer after the pass (storeOp=eStore) so a
 ///   later pass (transmission) can LOAD it; default discards it (eDontCare).
+/// @param velocityFormat when not eUndefined (single-sample only), a second
+///   color attachment (index 2, fragment output location 1) for screen-space
+///   motion vectors, cleared to zero and left in eShaderReadOnlyOptimal.
+/// @param viewMask when nonzero, a multiview pass (VK_KHR_multiview): each draw
+///   renders once per set bit, into that layer of the (array) attachments.
 vk::RenderPass make_scene_renderpass(vk::Device device, vk::Format hdrFormat,
   vk::Format depthFormat, bool debug,
   vk::SampleCountFlagBits msaaSamples = vk::SampleCountFlagBits::e1,
-  bool storeDepth = false);
+  bool storeDepth = false, vk::Format velocityFormat = vk::Format::eUndefined,
+  uint32_t viewMask = 0);
 
 /// Composite render pass: single swapchain color attachment, no depth.
 vk::RenderPass make_composite_renderpass(vk::Device device, vk::Format swapchainFormat, bool debug);
@@ -102,8 +126,28 @@ vk::RenderPass make_composite_renderpass(vk::Device device, vk::Format swapchain
 /// the composite pass. Single-sample (phase 1 renders directly into the resolved
 /// HDR; MSAA interaction is a follow-up). Color: load=LOAD, initial+final
 /// eShaderReadOnlyOptimal. Depth: load=LOAD (test against opaque), no clear.
+/// Render-pass compatible with the single-sample scene pass, so it also serves
+/// as the LOAD pass for the HiZ disocclusion draws over the scene framebuffer.
+/// @param storeDepth keep the depth (storeOp=eStore) for a later LOAD pass.
+/// @param velocityFormat when not eUndefined, also LOAD/STORE the scene pass's
+///   motion-vector attachment (index 2) — required for compatibility with a
+///   scene pass that has one.
 vk::RenderPass make_transmission_renderpass(vk::Device device, vk::Format hdrFormat,
-  vk::Format depthFormat, bool debug);
+  vk::Format depthFormat, bool debug, bool storeDepth = false,
+  vk::Format velocityFormat = vk::Format::eUndefined);
+
+/// Shadow-map render pass: a single depth attachment (one layer of the shadow
+/// array), cleared, stored, and left in eShaderReadOnlyOptimal for the scene
+/// pass to sample. Depth-only — pair it with a pipeline without a fragment shader.
+/// Weighted-blended OIT render pass: clears the accumulation (attachment 0) and
+/// revealage (attachment 2) targets and LOADs the shared depth (attachment 1)
+/// to test the transparent draws against the opaque result. Both colors end in
+/// eShaderReadOnlyOptimal for the resolve; depth is stored for a later LOAD
+/// pass (transmission). Single-sample, like the transmission pass.
+vk::RenderPass make_oit_renderpass(vk::Device device, vk::Format accumFormat,
+  vk::Format revealFormat, vk::Format depthFormat, bool debug);
+
+vk::RenderPass make_shadow_renderpass(vk::Device device, vk::Format depthFormat, bool debug);
 
 GraphicsPipelineOutBundle create_graphics_pipeline(
   GraphicsPipelineInBundle& specification, bool debug);
@@ -117,6 +161,10 @@ struct PipelineSpec
 {
   std::string vertex_shader;    // path to .vert GLSL source
   std::string fragment_shader;  // path to .frag GLSL source
+  /// Prepended to the vertex shader (e.g. "#define INSTANCED 1\n").
+  std::string vertex_preamble;
+  /// Prepended to the fragment shader (e.g. "#define RAY_QUERY 1\n").
+  std::string fragment_preamble;
 
   std::vector<vk::VertexInputBindingDescription> vertex_bindings;
   std::vector<vk::VertexInputAttributeDescription> vertex_attributes;
@@ -125,15 +173,44 @@ struct PipelineSpec
   bool wireframe{ false };
   bool depth_test{ false };
   bool depth_write{ true };
+  /// Depth convention of Camera::projection_matrix(): 1 = near, 0 = far, so
+  /// depth compares GREATER and clears to 0. Off for a [0 near, 1 far] one.
+  bool reversed_z{ true };
   vk::Format depth_format{ vk::Format::eD32Sfloat };
   bool blend{ false };
+  /// With blend: ONE + ONE on every color attachment instead of alpha
+  /// blending, e.g. the weighted-blended OIT accumulation.
+  bool additive_blend{ false };
   bool dynamic_depth_write{ false };
   bool dynamic_cull_mode{ false };
   vk::SampleCountFlagBits msaa_samples{ vk::SampleCountFlagBits::e1 };
 
+  /// Color attachments of the subpass; the extras come after the depth (see
+  /// ExecutionGroup::set_aux_color_attachment()).
+  uint32_t color_attachment_count{ 1 };
+
   /// Optional: use pre-created render pass instead of auto-creating.
   /// When set, ExecutionGroup passes it through to create_graphics_pipeline().
   vk::RenderPass existing_renderpass{ VK_NULL_HANDLE };
+
+  /// Draw with VK_KHR_dynamic_rendering when the device supports it: the
+  /// pipeline depends on attachment formats only, and the group begins
+  /// rendering on its attachments directly (no render pass or framebuffers to
+  /// rebuild on resize). existing_renderpass is then only the fallback.
+  bool dynamic_rendering{ false };
+  /// Dynamic rendering: format of the color attachments after the first (the
+  /// aux attachments, see ExecutionGroup::set_aux_color_attachment()).
+  vk::Format aux_color_format{ vk::Format::eUndefined };
+  /// Dynamic rendering: LOAD the color attachments (kept eShaderReadOnlyOptimal
+  /// between passes) instead of clearing them, e.g. a pass drawing on top of
+  /// an earlier one. Depth is LOADed too (it stays eDepthStencilAttachmentOptimal).
+  bool load_attachments{ false };
+  /// Dynamic rendering: LOAD only the depth and clear the colors, e.g. a pass
+  /// depth-testing against an earlier one into its own targets.
+  bool load_depth{ false };
+  /// Dynamic rendering: keep the depth after the pass for a later pass or
+  /// compute (storeOp=eStore); default discards it.
+  bool store_depth{ false };
 };
 
 class Pipeline
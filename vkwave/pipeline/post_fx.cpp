@@ -0,0 +1,399 @@
+#include <vkwave/pipeline/post_fx.h>
+
+#include <vkwave/config.h>
+#include <vkwave/core/deletion_queue.h>
+#include <vkwave/core/device.h>
+#include <vkwave/core/format_select.h>
+#include <vkwave/core/post_fx.h>
+
+#include <spdlog/fmt/fmt.h>
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <array>
+
+namespace vkwave
+{
+
+PostFxPlan plan_post_fx(std::span<const PostFxIo> passes)
+{
+  // The current image starts as the HDR; a ping-pong pass writes the other one.
+  PostFxPlan plan;
+  bool in_scratch = false;
+  for (const PostFxIo io : passes)
+  {
+    if (io == PostFxIo::ping_pong)
+      in_scratch = !in_scratch;
+    plan.writes_scratch.push_back(in_scratch);
+  }
+  plan.copy_back = in_scratch;
+  return plan;
+}
+
+// --- PostFxPass ---
+
+PostFxPass::PostFxPass(const Device& device, std::string name, const std::string& shader,
+  vk::Format format, bool debug)
+  : m_device(device)
+  , m_name(std::move(name))
+{
+  m_pipeline = std::make_unique<ComputePipeline>(device, SHADER_DIR + shader, debug,
+    fmt::format("#define IMAGE_FORMAT {}\n", glsl_image_format(format)));
+}
+
+PostFxPass::~PostFxPass()
+{
+  if (m_descriptor_pool)
+    m_device.deletion_queue().push([dev = m_device.device(), pool = m_descriptor_pool] {
+      dev.destroyDescriptorPool(pool);
+    });
+}
+
+void PostFxPass::create_frame_resources(const FrameResourcePool& pool,
+  FrameResourcePool::ColorHandle /*scratch*/)
+{
+  PostFxPass::destroy_frame_resources();
+
+  const uint32_t count = pool.slot_count() * sets_per_slot();
+  auto pool_sizes = m_pipeline->pool_sizes(count);
+  vk::DescriptorPoolCreateInfo pool_info{};
+  pool_info.maxSets = count;
+  pool_info.poolSizeCount = static_cast<uint32_t>(pool_sizes.size());
+  pool_info.pPoolSizes = pool_sizes.data();
+  m_descriptor_pool = m_device.device().createDescriptorPool(pool_info);
+  m_sets = m_pipeline->allocate_sets(m_descriptor_pool, 0, count);
+}
+
+void PostFxPass::destroy_frame_resources()
+{
+  // Deferred: a chain in flight may still use the sets.
+  if (m_descriptor_pool)
+  {
+    m_device.deletion_queue().push([dev = m_device.device(), pool = m_descriptor_pool] {
+      dev.destroyDescriptorPool(pool);
+    });
+    m_descriptor_pool = VK_NULL_HANDLE;
+  }
+  m_sets.clear();
+}
+
+void PostFxPass::write_sampled(vk::DescriptorSet set, uint32_t binding, vk::ImageView view,
+  vk::Sampler sampler, vk::ImageLayout layout) const
+{
+  vk::DescriptorImageInfo info{ sampler, view, layout };
+  vk::WriteDescriptorSet write{};
+  write.dstSet = set;
+  write.dstBinding = binding;
+  write.descriptorCount = 1;
+  write.descriptorType = vk::DescriptorType::eCombinedImageSampler;
+  write.pImageInfo = &info;
+  m_device.device().updateDescriptorSets(write, {});
+}
+
+void PostFxPass::write_storage(vk::DescriptorSet set, uint32_t binding, vk::ImageView view) const
+{
+  vk::DescriptorImageInfo info{ VK_NULL_HANDLE, view, vk::ImageLayout::eGeneral };
+  vk::WriteDescriptorSet write{};
+  write.dstSet = set;
+  write.dstBinding = binding;
+  write.descriptorCount = 1;
+  write.descriptorType = vk::DescriptorType::eStorageImage;
+  write.pImageInfo = &info;
+  m_device.device().updateDescriptorSets(write, {});
+}
+
+// --- PostFxChain ---
+
+namespace
+{
+
+/// The chain's start from a source image: a sampled copy of it into the HDR
+/// (post_fx_input.comp). Not one of the chain's passes: never toggled or timed.
+class InputPass : public PostFxPass
+{
+public:
+  InputPass(const Device& device, vk::Format format, bool debug)
+    : PostFxPass(device, "input", "post_fx_input.comp", format, debug)
+  {
+  }
+
+  [[nodiscard]] PostFxIo io() const override { return PostFxIo::ping_pong; }
+
+  void record(vk::CommandBuffer cmd, const PostFxContext& ctx) override
+  {
+    const vk::DescriptorSet set = this->set(ctx.slot);
+    write_sampled(set, 0, ctx.source.view, ctx.sampler, vk::ImageLayout::eShaderReadOnlyOptimal);
+    write_storage(set, 1, ctx.target.view);
+
+    PostFxInputPushConstants pc{};
+    pc.region = glm::ivec2(ctx.region.width, ctx.region.height);
+
+    m_pipeline->bind(cmd);
+    m_pipeline->bind_descriptor_set(cmd, 0, set);
+    m_pipeline->push_constants(cmd, &pc, sizeof(pc));
+    cmd.dispatch(ComputePipeline::group_count(ctx.region.width, kLocalSize),
+      ComputePipeline::group_count(ctx.region.height, kLocalSize), 1);
+  }
+
+private:
+  static constexpr uint32_t kLocalSize = 8; // post_fx_input.comp: 8x8
+};
+
+} // namespace
+
+PostFxChain::PostFxChain(const Device& device, vk::Format format, bool debug)
+  : m_device(device)
+  , m_format(format)
+  , m_input(std::make_unique<InputPass>(device, format, debug))
+{
+  // Shared by every pass: bilinear taps (bloom's tent filters, the aberration's
+  // offsets) and explicit-lod reads of the scratch pyramid.
+  vk::SamplerCreateInfo info{};
+  info.magFilter = vk::Filter::eLinear;
+  info.minFilter = vk::Filter::eLinear;
+  info.mipmapMode = vk::SamplerMipmapMode::eNearest;
+  info.addressModeU = vk::SamplerAddressMode::eClampToEdge;
+  info.addressModeV = vk::SamplerAddressMode::eClampToEdge;
+  info.addressModeW = vk::SamplerAddressMode::eClampToEdge;
+  info.maxLod = VK_LOD_CLAMP_NONE;
+  m_sampler = device.device().createSampler(info);
+}
+
+PostFxChain::~PostFxChain()
+{
+  destroy_frame_resources();
+  m_passes.clear();
+  m_input.reset();
+  if (m_sampler)
+    m_device.deletion_queue().push([dev = m_device.device(), sampler = m_sampler] {
+      dev.destroySampler(sampler);
+    });
+}
+
+void PostFxChain::register_resources(FrameResourcePool& pool, bool compute_shared)
+{
+  const bool mips = std::any_of(m_passes.begin(), m_passes.end(),
+    [](const auto& pass) { return pass->scratch_mips() > 0; });
+  m_scratch = pool.add_color("post_fx_scratch", m_format,
+    vk::ImageUsageFlagBits::eStorage | vk::ImageUsageFlagBits::eSampled
+      | vk::ImageUsageFlagBits::eTransferSrc,
+    vk::SampleCountFlagBits::e1, mips, compute_shared);
+  m_registered = true;
+}
+
+void PostFxChain::create_frame_resources(const FrameResourcePool& pool,
+  FrameResourcePool::ColorHandle hdr)
+{
+  destroy_frame_resources();
+  if (!m_registered)
+    return;
+
+  m_pool = &pool;
+  m_hdr = hdr;
+  m_slot_count = pool.slot_count();
+
+  auto dev = m_device.device();
+  for (uint32_t s = 0; s < m_slot_count; ++s)
+  {
+    vk::ImageViewCreateInfo view_info{};
+    view_info.image = pool.color_image(m_scratch, s);
+    view_info.viewType = vk::ImageViewType::e2D;
+    view_info.format = pool.color_format(m_scratch);
+    view_info.subresourceRange = { vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1 };
+    m_scratch_views.push_back(dev.createImageView(view_info));
+  }
+
+  for (auto& pass : m_passes)
+    pass->create_frame_resources(pool, m_scratch);
+  m_input->create_frame_resources(pool, m_scratch);
+  m_wrote_source.assign(m_slot_count, false);
+
+  const auto limits = m_device.physicalDevice().getProperties().limits;
+  if (limits.timestampComputeAndGraphics && !m_passes.empty())
+  {
+    m_timestamp_period = limits.timestampPeriod;
+    vk::QueryPoolCreateInfo info{};
+    info.queryType = vk::QueryType::eTimestamp;
+    info.queryCount = 2 * static_cast<uint32_t>(m_passes.size()) * m_slot_count;
+    m_query_pool = dev.createQueryPool(info);
+  }
+  else if (!m_passes.empty())
+  {
+    spdlog::warn("PostFxChain: device cannot time compute work");
+  }
+  m_timed.assign(m_slot_count, std::vector<bool>(m_passes.size(), false));
+}
+
+void PostFxChain::destroy_frame_resources()
+{
+  // Deferred: a chain in flight may still use the views and queries.
+  if (!m_scratch_views.empty() || m_query_pool)
+  {
+    m_device.deletion_queue().push([dev = m_device.device(), views = m_scratch_views,
+                                     query_pool = m_query_pool] {
+      for (auto view : views)
+        dev.destroyImageView(view);
+      if (query_pool)
+        dev.destroyQueryPool(query_pool);
+    });
+  }
+  for (auto& pass : m_passes)
+    pass->destroy_frame_resources();
+  if (m_input)
+    m_input->destroy_frame_resources();
+  m_scratch_views.clear();
+  m_wrote_source.clear();
+  m_query_pool = VK_NULL_HANDLE;
+  m_timed.clear();
+  m_slot_count = 0;
+  m_pool = nullptr;
+}
+
+void PostFxChain::read_timings(uint32_t slot)
+{
+  // The slot's previous submission has completed (the group waited for it),
+  // so the passes it timed have their results.
+  if (!m_query_pool)
+    return;
+  const uint32_t base = 2 * static_cast<uint32_t>(m_passes.size()) * slot;
+  for (size_t i = 0; i < m_passes.size(); ++i)
+  {
+    if (!m_timed[slot][i])
+    {
+      if (!m_passes[i]->enabled())
+        m_gpu_times[i] = 0.0f;
+      continue;
+    }
+    std::array<uint64_t, 2> ticks{};
+    const auto result = m_device.device().getQueryPoolResults(m_query_pool,
+      base + 2 * static_cast<uint32_t>(i), 2, sizeof(ticks), ticks.data(), sizeof(uint64_t),
+      vk::QueryResultFlagBits::e64);
+    if (result == vk::Result::eSuccess && ticks[1] >= ticks[0])
+      m_gpu_times[i] = static_cast<float>(
+        static_cast<double>(ticks[1] - ticks[0]) * m_timestamp_period * 1e-6);
+  }
+}
+
+void PostFxChain::record(vk::CommandBuffer cmd, uint32_t slot, vk::Extent2D region,
+  vk::ImageView source)
+{
+  if (slot >= m_slot_count)
+    return;
+
+  read_timings(slot);
+
+  std::vector<size_t> active;
+  std::vector<PostFxIo> io;
+  for (size_t i = 0; i < m_passes.size(); ++i)
+  {
+    m_timed[slot][i] = false;
+    if (m_passes[i]->enabled())
+    {
+      active.push_back(i);
+      io.push_back(m_passes[i]->io());
+    }
+  }
+  m_wrote_source[slot] = !active.empty() && source;
+  if (active.empty())
+    return;
+  const PostFxPlan plan = plan_post_fx(io);
+
+  const PostFxImage hdr{ m_pool->color_image(m_hdr, slot), m_pool->color_view(m_hdr, slot) };
+  const PostFxImage scratch{ m_pool->color_image(m_scratch, slot), m_scratch_views[slot] };
+  const uint32_t base = 2 * static_cast<uint32_t>(m_passes.size()) * slot;
+  if (m_query_pool)
+    cmd.resetQueryPool(m_query_pool, base, 2 * static_cast<uint32_t>(m_passes.size()));
+
+  // The HDR's last writers are in an earlier submission the group waits on,
+  // but with a source its last reader (the TAA resolve) may be a dispatch
+  // earlier in this command buffer; the scratch's previous contents are not
+  // needed.
+  std::array<vk::ImageMemoryBarrier, 2> to_general{};
+  for (auto& barrier : to_general)
+  {
+    barrier.srcAccessMask = {};
+    barrier.dstAccessMask = vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite;
+    barrier.newLayout = vk::ImageLayout::eGeneral;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  }
+  to_general[0].oldLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
+  to_general[0].image = hdr.image;
+  to_general[0].subresourceRange = { vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1 };
+  to_general[1].oldLayout = vk::ImageLayout::eUndefined;
+  to_general[1].image = scratch.image;
+  to_general[1].subresourceRange = { vk::ImageAspectFlagBits::eColor, 0, VK_REMAINING_MIP_LEVELS,
+    0, 1 };
+  cmd.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader,
+    vk::PipelineStageFlagBits::eComputeShader, {}, {}, {}, to_general);
+
+  vk::MemoryBarrier between{};
+  between.srcAccessMask = vk::AccessFlagBits::eShaderWrite;
+  between.dstAccessMask = vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite;
+
+  PostFxContext ctx{};
+  ctx.slot = slot;
+  ctx.extent = m_pool->extent();
+  ctx.region = region;
+  ctx.sampler = m_sampler;
+  if (source)
+  {
+    ctx.source = PostFxImage{ VK_NULL_HANDLE, source };
+    ctx.target = hdr;
+    m_input->record(cmd, ctx);
+  }
+  ctx.source = hdr;
+  for (size_t k = 0; k < active.size(); ++k)
+  {
+    const size_t i = active[k];
+    if (k > 0 || source)
+      cmd.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader,
+        vk::PipelineStageFlagBits::eComputeShader, {}, between, {}, {});
+
+    ctx.target = plan.writes_scratch[k] ? scratch : hdr;
+    if (m_query_pool)
+      cmd.writeTimestamp(vk::PipelineStageFlagBits::eTopOfPipe, m_query_pool,
+        base + 2 * static_cast<uint32_t>(i));
+    m_passes[i]->record(cmd, ctx);
+    if (m_query_pool)
+      cmd.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, m_query_pool,
+        base + 2 * static_cast<uint32_t>(i) + 1);
+    m_timed[slot][i] = m_query_pool != VK_NULL_HANDLE;
+    ctx.source = ctx.target;
+  }
+
+  vk::PipelineStageFlags last_stage = vk::PipelineStageFlagBits::eComputeShader;
+  vk::AccessFlags last_access = vk::AccessFlagBits::eShaderWrite;
+  if (plan.copy_back)
+  {
+    vk::MemoryBarrier to_copy{};
+    to_copy.srcAccessMask = vk::AccessFlagBits::eShaderWrite;
+    to_copy.dstAccessMask = vk::AccessFlagBits::eTransferRead | vk::AccessFlagBits::eTransferWrite;
+    cmd.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader,
+      vk::PipelineStageFlagBits::eTransfer, {}, to_copy, {}, {});
+
+    vk::ImageCopy copy{};
+    copy.srcSubresource = { vk::ImageAspectFlagBits::eColor, 0, 0, 1 };
+    copy.dstSubresource = { vk::ImageAspectFlagBits::eColor, 0, 0, 1 };
+    copy.extent = vk::Extent3D{ region.width, region.height, 1 };
+    cmd.copyImage(scratch.image, vk::ImageLayout::eGeneral, hdr.image,
+      vk::ImageLayout::eGeneral, copy);
+    last_stage = vk::PipelineStageFlagBits::eTransfer;
+    last_access = vk::AccessFlagBits::eTransferWrite;
+  }
+
+  // HDR -> sampled by TAA / the composite: later submissions, which wait on
+  // this one, or with a source the composite in this command buffer (compute
+  // or fragment; that chain is on the graphics queue).
+  vk::ImageMemoryBarrier to_read = to_general[0];
+  to_read.srcAccessMask = last_access;
+  to_read.dstAccessMask = vk::AccessFlagBits::eShaderRead;
+  to_read.oldLayout = vk::ImageLayout::eGeneral;
+  to_read.newLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
+  vk::PipelineStageFlags readers = vk::PipelineStageFlagBits::eComputeShader;
+  if (source)
+    readers |= vk::PipelineStageFlagBits::eFragmentShader;
+  cmd.pipelineBarrier(last_stage, readers, {}, {}, {}, to_read);
+}
+
+} // namespace vkwave
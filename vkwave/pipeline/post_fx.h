@@ -0,0 +1,219 @@
+#pragma once
+
+#include <vkwave/pipeline/compute_pipeline.h>
+#include <vkwave/pipeline/frame_resource_pool.h>
+
+#include <vulkan/vulkan.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace vkwave
+{
+
+class Device;
+
+/// How a post-FX pass accesses the image it processes.
+enum class PostFxIo
+{
+  in_place,  ///< read-modify-writes the current image (per texel, or reads only
+             ///< other resources while writing it)
+  ping_pong, ///< samples the current image around each texel, so it writes the
+             ///< other one (the chain's scratch image or the HDR)
+};
+
+/// Where a chain of passes writes, from their io() in order: whether each pass
+/// writes the scratch image (else the HDR), and whether the result ends in the
+/// scratch image and must be copied back into the HDR.
+struct PostFxPlan
+{
+  std::vector<bool> writes_scratch; // [pass]
+  bool copy_back{ false };
+};
+
+[[nodiscard]] PostFxPlan plan_post_fx(std::span<const PostFxIo> passes);
+
+/// One image of the chain (mip 0 view).
+struct PostFxImage
+{
+  vk::Image image{ VK_NULL_HANDLE };
+  vk::ImageView view{ VK_NULL_HANDLE };
+};
+
+/// What a pass records against. Both images are in eGeneral.
+struct PostFxContext
+{
+  uint32_t slot{ 0 };
+  vk::Extent2D extent{}; // image size (mip 0)
+  vk::Extent2D region{}; // rendered part, from the top-left (dynamic resolution)
+  PostFxImage source;    // the current image
+  PostFxImage target;    // where to write; == source for PostFxIo::in_place
+  vk::Sampler sampler{ VK_NULL_HANDLE }; // linear, clamp to edge, every level
+};
+
+/// One effect of a PostFxChain: a compute pipeline (compiled for the HDR's
+/// storage format) plus its per-slot descriptor sets.
+class PostFxPass
+{
+public:
+  virtual ~PostFxPass();
+
+  PostFxPass(const PostFxPass&) = delete;
+  PostFxPass& operator=(const PostFxPass&) = delete;
+
+  [[nodiscard]] const std::string& name() const { return m_name; }
+  [[nodiscard]] virtual PostFxIo io() const = 0;
+
+  /// Mip levels below mip 0 the pass uses in the chain's scratch image (its
+  /// own working space; mip 0 belongs to the chain).
+  [[nodiscard]] virtual uint32_t scratch_mips() const { return 0; }
+
+  /// (Re)create per-slot state for the pool's current resources. The default
+  /// allocates sets_per_slot() descriptor sets per slot.
+  virtual void create_frame_resources(const FrameResourcePool& pool,
+                                      FrameResourcePool::ColorHandle scratch);
+
+  /// Destroy it through the device deletion queue.
+  virtual void destroy_frame_resources();
+
+  /// Record the pass outside any render pass. The chain separates passes with
+  /// barriers; a pass with several dispatches orders them itself.
+  virtual void record(vk::CommandBuffer cmd, const PostFxContext& ctx) = 0;
+
+  void set_enabled(bool enabled) { m_enabled = enabled; }
+  [[nodiscard]] bool enabled() const { return m_enabled; }
+
+protected:
+  /// `shader` is a path under SHADER_DIR; `format` the HDR's format.
+  PostFxPass(const Device& device, std::string name, const std::string& shader,
+             vk::Format format, bool debug);
+
+  /// Descriptor sets each slot needs (one per dispatch in flight).
+  [[nodiscard]] virtual uint32_t sets_per_slot() const { return 1; }
+
+  /// Set `index` of `slot`. It belongs to that slot's submission only, so a
+  /// pass may rewrite it while recording.
+  [[nodiscard]] vk::DescriptorSet set(uint32_t slot, uint32_t index = 0) const
+  {
+    return m_sets[slot * sets_per_slot() + index];
+  }
+
+  void write_sampled(vk::DescriptorSet set, uint32_t binding, vk::ImageView view,
+                     vk::Sampler sampler,
+                     vk::ImageLayout layout = vk::ImageLayout::eGeneral) const;
+  void write_storage(vk::DescriptorSet set, uint32_t binding, vk::ImageView view) const;
+
+  const Device& m_device;
+  std::unique_ptr<ComputePipeline> m_pipeline;
+
+private:
+  std::string m_name;
+  bool m_enabled{ true };
+  vk::DescriptorPool m_descriptor_pool{ VK_NULL_HANDLE };
+  std::vector<vk::DescriptorSet> m_sets; // [slot * sets_per_slot() + index]
+};
+
+/// Ordered chain of compute post-effects over the scene's HDR, recorded before
+/// the composite (see Scene): by the post-FX graph group, or after the TAA
+/// resolve when there is one, so screen-locked effects (aberration, vignette)
+/// never enter the TAA history.
+///
+/// The chain owns one extra pool image, the scratch ("post_fx_scratch", the
+/// HDR's format): mip 0 is the other half of the ping-pong for PostFxIo::
+/// ping_pong passes, and the levels below it are shared working space for
+/// passes that need a pyramid (bloom). Passes run one after the other, so
+/// they alias the scratch instead of each owning targets. When the last
+/// writer leaves the result in the scratch it is copied back, so the chain
+/// always ends in the HDR.
+///
+/// A chain may also start from another image (record()'s `source`, the TAA
+/// output): post_fx_input.comp first copies it into the HDR, which the
+/// resolve has consumed, and the passes work on that copy. The source is
+/// only read, so it can stay the next frame's history.
+///
+/// record() only uses compute and transfer work, so the group may run on a
+/// dedicated compute queue (SubmissionGroup::set_async_compute()); the pool
+/// images are then registered compute_shared. Each pass is timed with its own
+/// pair of timestamps.
+class PostFxChain
+{
+public:
+  /// `format` is the HDR's (the input copy's target).
+  PostFxChain(const Device& device, vk::Format format, bool debug);
+  ~PostFxChain();
+
+  PostFxChain(const PostFxChain&) = delete;
+  PostFxChain& operator=(const PostFxChain&) = delete;
+
+  /// Append a pass; returns it for settings access.
+  template <typename T>
+  T& add(std::unique_ptr<T> pass)
+  {
+    T& ref = *pass;
+    m_passes.push_back(std::move(pass));
+    m_gpu_times.push_back(0.0f);
+    return ref;
+  }
+
+  /// Register the scratch image in `pool` (after every pass is added; the
+  /// pool's registrations are redone with the graph's).
+  void register_resources(FrameResourcePool& pool, bool compute_shared);
+
+  /// (Re)create per-slot state for the pool's current resources. `hdr` needs
+  /// eStorage and eTransferDst usage.
+  void create_frame_resources(const FrameResourcePool& pool, FrameResourcePool::ColorHandle hdr);
+
+  void destroy_frame_resources();
+
+  /// Run the enabled passes over `slot`'s HDR, outside any render pass. The
+  /// HDR is in eShaderReadOnlyOptimal before and after; `region` is the part
+  /// rendered this frame. With a `source` (eShaderReadOnlyOptimal, at least
+  /// `region` in size) the passes start from a copy of it instead of the
+  /// HDR's contents; the chain then records on the graphics queue, after the
+  /// source's writer in the same command buffer.
+  void record(vk::CommandBuffer cmd, uint32_t slot, vk::Extent2D region,
+              vk::ImageView source = VK_NULL_HANDLE);
+
+  /// True when `slot`'s latest record() started from a source and left its
+  /// result in the HDR; false when every pass was disabled (the source is
+  /// then the result) or there was no source.
+  [[nodiscard]] bool wrote_source(uint32_t slot) const
+  {
+    return slot < m_wrote_source.size() && m_wrote_source[slot];
+  }
+
+  [[nodiscard]] const std::vector<std::unique_ptr<PostFxPass>>& passes() const { return m_passes; }
+
+  /// GPU time of pass `index` in its latest completed run (0 while disabled
+  /// or without timestamp support).
+  [[nodiscard]] float gpu_time_ms(size_t index) const { return m_gpu_times[index]; }
+
+  [[nodiscard]] bool ready() const { return m_slot_count > 0; }
+
+private:
+  void read_timings(uint32_t slot);
+
+  const Device& m_device;
+  vk::Format m_format;
+  std::vector<std::unique_ptr<PostFxPass>> m_passes;
+  std::unique_ptr<PostFxPass> m_input; // source -> HDR copy
+  vk::Sampler m_sampler{ VK_NULL_HANDLE };
+
+  const FrameResourcePool* m_pool{ nullptr };
+  FrameResourcePool::ColorHandle m_hdr{ 0 };
+  FrameResourcePool::ColorHandle m_scratch{ 0 };
+  bool m_registered{ false };
+  uint32_t m_slot_count{ 0 };
+  std::vector<vk::ImageView> m_scratch_views; // [slot], mip 0
+  std::vector<bool> m_wrote_source;           // [slot]
+
+  vk::QueryPool m_query_pool{ VK_NULL_HANDLE }; // 2 per pass per slot
+  float m_timestamp_period{ 0.0f };
+  std::vector<std::vector<bool>> m_timed;     // [slot][pass], written last run
+  std::vector<float> m_gpu_times;             // [pass]
+};
+
+} // namespace vkwave
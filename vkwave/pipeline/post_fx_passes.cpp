@@ -0,0 +1,204 @@
+#include <vkwave/pipeline/post_fx_passes.h>
+
+#include <vkwave/core/deletion_queue.h>
+#include <vkwave/core/device.h>
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+
+namespace vkwave
+{
+
+namespace
+{
+
+constexpr uint32_t kLocalSize = 8; // bloom / chromatic_aberration / vignette.comp: 8x8
+
+/// Size of mip `level` of an image of `extent`.
+glm::ivec2 level_size(vk::Extent2D extent, uint32_t level)
+{
+  return glm::ivec2(std::max(extent.width >> level, 1u), std::max(extent.height >> level, 1u));
+}
+
+/// Texels of mip `level` covering `region` of mip 0 (rounded up).
+glm::ivec2 level_region(vk::Extent2D region, uint32_t level)
+{
+  const uint32_t round = (1u << level) - 1;
+  return glm::ivec2(std::max((region.width + round) >> level, 1u),
+    std::max((region.height + round) >> level, 1u));
+}
+
+void dispatch(vk::CommandBuffer cmd, glm::ivec2 region)
+{
+  cmd.dispatch(ComputePipeline::group_count(static_cast<uint32_t>(region.x), kLocalSize),
+    ComputePipeline::group_count(static_cast<uint32_t>(region.y), kLocalSize), 1);
+}
+
+} // namespace
+
+// --- BloomPass ---
+
+BloomPass::BloomPass(const Device& device, vk::Format format, bool debug)
+  : PostFxPass(device, "bloom", "bloom.comp", format, debug)
+{
+}
+
+BloomPass::~BloomPass()
+{
+  destroy_frame_resources();
+}
+
+void BloomPass::create_frame_resources(const FrameResourcePool& pool,
+  FrameResourcePool::ColorHandle scratch)
+{
+  destroy_frame_resources();
+  PostFxPass::create_frame_resources(pool, scratch);
+
+  m_pool = &pool;
+  m_scratch = scratch;
+  m_image_levels = std::min(pool.color_mip_levels(scratch, 0), kBloomMaxLevels + 1);
+
+  // Storage views of the pyramid levels; the sampled side uses the pool's
+  // full view with an explicit lod.
+  auto dev = m_device.device();
+  m_mip_views.resize(pool.slot_count());
+  for (uint32_t s = 0; s < pool.slot_count(); ++s)
+  {
+    m_mip_views[s].assign(m_image_levels, VK_NULL_HANDLE);
+    for (uint32_t level = 1; level < m_image_levels; ++level)
+    {
+      vk::ImageViewCreateInfo view_info{};
+      view_info.image = pool.color_image(scratch, s);
+      view_info.viewType = vk::ImageViewType::e2D;
+      view_info.format = pool.color_format(scratch);
+      view_info.subresourceRange = { vk::ImageAspectFlagBits::eColor, level, 1, 0, 1 };
+      m_mip_views[s][level] = dev.createImageView(view_info);
+    }
+  }
+}
+
+void BloomPass::destroy_frame_resources()
+{
+  // Deferred: a chain in flight may still use the views.
+  if (!m_mip_views.empty())
+  {
+    m_device.deletion_queue().push([dev = m_device.device(), views = m_mip_views] {
+      for (auto& slot_views : views)
+        for (auto view : slot_views)
+          if (view)
+            dev.destroyImageView(view);
+    });
+  }
+  m_mip_views.clear();
+  m_image_levels = 0;
+  m_pool = nullptr;
+  PostFxPass::destroy_frame_resources();
+}
+
+void BloomPass::record(vk::CommandBuffer cmd, const PostFxContext& ctx)
+{
+  const uint32_t levels = bloom_levels(ctx.region, m_image_levels);
+  if (levels == 0 || ctx.slot >= m_mip_views.size())
+    return;
+
+  const vk::ImageView pyramid = m_pool->color_view(m_scratch, ctx.slot);
+  const auto& mips = m_mip_views[ctx.slot];
+  uint32_t next_set = 0;
+
+  vk::MemoryBarrier between{};
+  between.srcAccessMask = vk::AccessFlagBits::eShaderWrite;
+  between.dstAccessMask = vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite;
+
+  BloomPushConstants pc{};
+  pc.threshold = m_settings.threshold;
+  pc.knee = std::max(m_settings.knee, 0.0f);
+  pc.intensity = m_settings.intensity / static_cast<float>(levels);
+
+  // One dispatch: sample `src` (level `src_level` of an image of
+  // `src_extent`), write `dst` (level `dst_level`).
+  auto step = [&](int32_t mode, vk::ImageView src, uint32_t src_level, vk::ImageView dst,
+                  uint32_t dst_level) {
+    const vk::DescriptorSet set = this->set(ctx.slot, next_set++);
+    write_sampled(set, 0, src, ctx.sampler);
+    write_storage(set, 1, dst);
+
+    const glm::ivec2 src_size = level_size(ctx.extent, src_level);
+    const glm::ivec2 src_region = level_region(ctx.region, src_level);
+    pc.dstRegion = level_region(ctx.region, dst_level);
+    pc.dstTexel = 1.0f / glm::vec2(level_size(ctx.extent, dst_level));
+    pc.srcTexel = 1.0f / glm::vec2(src_size);
+    pc.srcUvMax = (glm::vec2(src_region) - 0.5f) / glm::vec2(src_size);
+    pc.srcLod = src == pyramid ? static_cast<float>(src_level) : 0.0f;
+    pc.mode = mode;
+
+    m_pipeline->bind_descriptor_set(cmd, 0, set);
+    m_pipeline->push_constants(cmd, &pc, sizeof(pc));
+    dispatch(cmd, pc.dstRegion);
+    cmd.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader,
+      vk::PipelineStageFlagBits::eComputeShader, {}, between, {}, {});
+  };
+
+  m_pipeline->bind(cmd);
+  step(kBloomPrefilter, ctx.source.view, 0, mips[1], 1);
+  for (uint32_t level = 2; level <= levels; ++level)
+    step(kBloomDownsample, pyramid, level - 1, mips[level], level);
+  for (uint32_t level = levels - 1; level >= 1; --level)
+    step(kBloomUpsample, pyramid, level + 1, mips[level], level);
+  step(kBloomComposite, pyramid, 1, ctx.target.view, 0);
+}
+
+// --- ChromaticAberrationPass ---
+
+ChromaticAberrationPass::ChromaticAberrationPass(const Device& device, vk::Format format,
+  bool debug)
+  : PostFxPass(device, "chromatic_aberration", "chromatic_aberration.comp", format, debug)
+{
+  set_enabled(false);
+}
+
+void ChromaticAberrationPass::record(vk::CommandBuffer cmd, const PostFxContext& ctx)
+{
+  const vk::DescriptorSet set = this->set(ctx.slot);
+  write_sampled(set, 0, ctx.source.view, ctx.sampler);
+  write_storage(set, 1, ctx.target.view);
+
+  const glm::vec2 size(static_cast<float>(ctx.extent.width),
+    static_cast<float>(ctx.extent.height));
+  ChromaticAberrationPushConstants pc{};
+  pc.region = glm::ivec2(ctx.region.width, ctx.region.height);
+  pc.texel = 1.0f / size;
+  pc.uvMax = (glm::vec2(pc.region) - 0.5f) / size;
+  pc.strength = m_settings.strength;
+
+  m_pipeline->bind(cmd);
+  m_pipeline->bind_descriptor_set(cmd, 0, set);
+  m_pipeline->push_constants(cmd, &pc, sizeof(pc));
+  dispatch(cmd, pc.region);
+}
+
+// --- VignettePass ---
+
+VignettePass::VignettePass(const Device& device, vk::Format format, bool debug)
+  : PostFxPass(device, "vignette", "vignette.comp", format, debug)
+{
+  set_enabled(false);
+}
+
+void VignettePass::record(vk::CommandBuffer cmd, const PostFxContext& ctx)
+{
+  const vk::DescriptorSet set = this->set(ctx.slot);
+  write_storage(set, 0, ctx.target.view);
+
+  VignettePushConstants pc{};
+  pc.region = glm::ivec2(ctx.region.width, ctx.region.height);
+  pc.intensity = std::clamp(m_settings.intensity, 0.0f, 1.0f);
+  pc.radius = std::clamp(m_settings.radius, 0.0f, 0.99f);
+
+  m_pipeline->bind(cmd);
+  m_pipeline->bind_descriptor_set(cmd, 0, set);
+  m_pipeline->push_constants(cmd, &pc, sizeof(pc));
+  dispatch(cmd, pc.region);
+}
+
+} // namespace vkwave
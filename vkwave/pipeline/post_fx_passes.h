@@ -0,0 +1,96 @@
+#pragma once
+
+#include <vkwave/core/post_fx.h>
+#include <vkwave/pipeline/post_fx.h>
+
+#include <vulkan/vulkan.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace vkwave
+{
+
+class Device;
+
+/// Dual-filter bloom (bloom.comp): thresholds the image into scratch mip 1,
+/// downsamples to mip N, upsamples back adding each level, then adds mip 1
+/// to the image. 2N dispatches over at most kBloomMaxLevels levels.
+class BloomPass : public PostFxPass
+{
+public:
+  struct Settings
+  {
+    float intensity{ 0.1f }; // weight of the blurred levels (averaged over them)
+    float threshold{ 1.0f }; // luminance where bloom starts (0 = everything blooms)
+    float knee{ 0.5f };      // soft threshold width
+  };
+
+  BloomPass(const Device& device, vk::Format format, bool debug);
+  ~BloomPass() override;
+
+  [[nodiscard]] PostFxIo io() const override { return PostFxIo::in_place; }
+  [[nodiscard]] uint32_t scratch_mips() const override { return kBloomMaxLevels; }
+
+  void create_frame_resources(const FrameResourcePool& pool,
+                              FrameResourcePool::ColorHandle scratch) override;
+  void destroy_frame_resources() override;
+  void record(vk::CommandBuffer cmd, const PostFxContext& ctx) override;
+
+  [[nodiscard]] Settings& settings() { return m_settings; }
+
+protected:
+  [[nodiscard]] uint32_t sets_per_slot() const override { return 2 * kBloomMaxLevels; }
+
+private:
+  Settings m_settings;
+
+  const FrameResourcePool* m_pool{ nullptr };
+  FrameResourcePool::ColorHandle m_scratch{ 0 };
+  uint32_t m_image_levels{ 0 };
+  std::vector<std::vector<vk::ImageView>> m_mip_views; // [slot][level], level 0 unused
+};
+
+/// Radial chromatic aberration (chromatic_aberration.comp): red and blue are
+/// sampled pushed out from / pulled in toward the centre.
+class ChromaticAberrationPass : public PostFxPass
+{
+public:
+  struct Settings
+  {
+    float strength{ 0.006f }; // offset as a fraction of the distance to the centre
+  };
+
+  ChromaticAberrationPass(const Device& device, vk::Format format, bool debug);
+
+  [[nodiscard]] PostFxIo io() const override { return PostFxIo::ping_pong; }
+  void record(vk::CommandBuffer cmd, const PostFxContext& ctx) override;
+
+  [[nodiscard]] Settings& settings() { return m_settings; }
+
+private:
+  Settings m_settings;
+};
+
+/// Vignette (vignette.comp): darkens toward the corners.
+class VignettePass : public PostFxPass
+{
+public:
+  struct Settings
+  {
+    float intensity{ 0.35f }; // darkening at the corners (0 = none, 1 = black)
+    float radius{ 0.5f };     // where the falloff starts (0 = centre, 1 = corners)
+  };
+
+  VignettePass(const Device& device, vk::Format format, bool debug);
+
+  [[nodiscard]] PostFxIo io() const override { return PostFxIo::in_place; }
+  void record(vk::CommandBuffer cmd, const PostFxContext& ctx) override;
+
+  [[nodiscard]] Settings& settings() { return m_settings; }
+
+private:
+  Settings m_settings;
+};
+
+} // namespace vkwave
@@ -1,227 +1,479 @@
 #include <vkwave/pipeline/raytracing_pipeline.h>
+#include <vkwave/config.h>
+#include <vkwave/core/buffer.h>
+#include <vkwave/core/deletion_queue.h>
 #include <vkwave/core/device.h>
-#include <vkwave/pipeline/shaders.h>
+#include <vkwave/core/format_select.h>
+#include <vkwave/core/vertex.h>
+#include <vkwave/loaders/gltf_loader.h>
+#include <vkwave/pipeline/shader_compiler.h>
 
+#include <spdlog/fmt/fmt.h>
 #include <spdlog/spdlog.h>
 
-#include <fstream>
+#include <algorithm>
+#include <cassert>
 #include <cstring>
+#include <stdexcept>
 
 namespace vkwave
 {
 
+namespace
+{
+
+vk::DeviceSize align_up(vk::DeviceSize value, vk::DeviceSize alignment)
+{
+  const vk::DeviceSize mask = std::max<vk::DeviceSize>(alignment, 1) - 1;
+  return (value + mask) & ~mask;
+}
+
+vk::RayTracingShaderGroupCreateInfoKHR general_group(uint32_t shader)
+{
+  vk::RayTracingShaderGroupCreateInfoKHR group{};
+  group.type = vk::RayTracingShaderGroupTypeKHR::eGeneral;
+  group.generalShader = shader;
+  group.closestHitShader = VK_SHADER_UNUSED_KHR;
+  group.anyHitShader = VK_SHADER_UNUSED_KHR;
+  group.intersectionShader = VK_SHADER_UNUSED_KHR;
+  return group;
+}
+
+/// Append `group`'s stages to `stages` and return its triangles hit group.
+vk::RayTracingShaderGroupCreateInfoKHR hit_group(const RayTracingHitGroup& group,
+  std::vector<std::pair<std::string, vk::ShaderStageFlagBits>>& stages)
+{
+  vk::RayTracingShaderGroupCreateInfoKHR info{};
+  info.type = vk::RayTracingShaderGroupTypeKHR::eTrianglesHitGroup;
+  info.generalShader = VK_SHADER_UNUSED_KHR;
+  info.closestHitShader = VK_SHADER_UNUSED_KHR;
+  info.anyHitShader = VK_SHADER_UNUSED_KHR;
+  info.intersectionShader = VK_SHADER_UNUSED_KHR;
+  if (!group.closest_hit.empty())
+  {
+    info.closestHitShader = static_cast<uint32_t>(stages.size());
+    stages.emplace_back(group.closest_hit, vk::ShaderStageFlagBits::eClosestHitKHR);
+  }
+  if (!group.any_hit.empty())
+  {
+    info.anyHitShader = static_cast<uint32_t>(stages.size());
+    stages.emplace_back(group.any_hit, vk::ShaderStageFlagBits::eAnyHitKHR);
+  }
+  return info;
+}
+
+} // anonymous namespace
+
+ShaderBindingTableLayout shader_binding_table_layout(uint32_t handle_size,
+  uint32_t handle_alignment, uint32_t base_alignment, uint32_t miss_count, uint32_t hit_count)
+{
+  ShaderBindingTableLayout layout;
+  layout.record_stride = align_up(handle_size, handle_alignment);
+  layout.raygen_size = align_up(layout.record_stride, base_alignment);
+  layout.miss_offset = layout.raygen_size;
+  layout.miss_size = align_up(layout.record_stride * miss_count, base_alignment);
+  layout.hit_offset = layout.miss_offset + layout.miss_size;
+  layout.hit_size = align_up(layout.record_stride * hit_count, base_alignment);
+  layout.total_size = layout.hit_offset + layout.hit_size;
+  return layout;
+}
+
 RayTracingPipeline::RayTracingPipeline(const Device& device)
   : m_device(&device)
+  , m_deletion_queue(&device.deletion_queue())
 {
 }
 
 RayTracingPipeline::~RayTracingPipeline()
 {
-  if (m_device == nullptr)
-    return;
+  retire_pipeline();
+  retire_layout();
+}
 
-  auto dev = m_device->device();
+RayTracingPipelineSpec RayTracingPipeline::scene_spec(vk::Format output_format)
+{
+  RayTracingPipelineSpec spec;
+  spec.raygen = SHADER_DIR "rt_primary.rgen";
+  spec.miss = { SHADER_DIR "rt_environment.rmiss" };
+  spec.hit_groups = material_hit_groups();
+  spec.preamble = fmt::format("#define IMAGE_FORMAT {}\n", glsl_image_format(output_format));
+  spec.constants = { static_cast<uint32_t>(sizeof(Vertex) / sizeof(float)) };
+  spec.max_payload_size = 12;      // vec3 radiance
+  spec.max_hit_attribute_size = 8; // triangle barycentrics
+  return spec;
+}
 
-  if (m_pipeline)
-    dev.destroyPipeline(m_pipeline);
-  if (m_layout)
-    dev.destroyPipelineLayout(m_layout);
-  if (m_sbt_buffer)
-    dev.destroyBuffer(m_sbt_buffer);
-  if (m_sbt_memory)
-    dev.freeMemory(m_sbt_memory);
+std::vector<RayTracingHitGroup> RayTracingPipeline::material_hit_groups()
+{
+  std::vector<RayTracingHitGroup> groups(static_cast<size_t>(MaterialHitGroup::count));
+  groups[static_cast<size_t>(MaterialHitGroup::opaque)] =
+    { "opaque", SHADER_DIR "rt_surface.rchit", {} };
+  groups[static_cast<size_t>(MaterialHitGroup::alpha_test)] =
+    { "alpha test", SHADER_DIR "rt_surface.rchit", SHADER_DIR "rt_alpha_test.rahit" };
+  return groups;
 }
 
-vk::ShaderModule RayTracingPipeline::create_shader_module(const std::string& path)
+MaterialHitGroup RayTracingPipeline::hit_group_of(const SceneMaterial& material)
 {
-  return vkwave::createModule(path, m_device->device(), true);
+  return material.alphaMode == AlphaMode::Mask ? MaterialHitGroup::alpha_test
+                                               : MaterialHitGroup::opaque;
 }
 
-void RayTracingPipeline::create(const std::string& raygen_path, const std::string& miss_path,
-  const std::string& closesthit_path, vk::DescriptorSetLayout descriptor_set_layout,
-  uint32_t vertex_stride_floats)
+const std::vector<uint32_t>& RayTracingPipeline::compile(
+  const std::string& path, vk::ShaderStageFlagBits stage)
+{
+  auto key = std::make_pair(path, stage);
+  auto it = m_spirv.find(key);
+  if (it != m_spirv.end())
+    return it->second;
+
+  auto compiler = ShaderCompiler::get();
+  assert(compiler && "ShaderCompiler not created — call ShaderCompiler::create() first");
+  auto result = compiler->compile(path, stage, m_spec.preamble);
+  return m_spirv.emplace(std::move(key), std::move(result.spirv)).first->second;
+}
+
+void RayTracingPipeline::reflect_group(ShaderReflection& reflection, const RayTracingHitGroup& group)
+{
+  if (!group.closest_hit.empty())
+    reflection.add_stage(compile(group.closest_hit, vk::ShaderStageFlagBits::eClosestHitKHR),
+      vk::ShaderStageFlagBits::eClosestHitKHR);
+  if (!group.any_hit.empty())
+    reflection.add_stage(compile(group.any_hit, vk::ShaderStageFlagBits::eAnyHitKHR),
+      vk::ShaderStageFlagBits::eAnyHitKHR);
+}
+
+void RayTracingPipeline::create_layout()
 {
   auto dev = m_device->device();
 
-  // Create shader modules
-  vk::ShaderModule raygenModule = create_shader_module(raygen_path);
-  vk::ShaderModule missModule = create_shader_module(miss_path);
-  vk::ShaderModule chitModule = create_shader_module(closesthit_path);
+  ShaderReflection reflection;
+  reflection.set_debug(ShaderCompiler::get()->debug_info());
+  reflection.add_stage(compile(m_spec.raygen, vk::ShaderStageFlagBits::eRaygenKHR),
+    vk::ShaderStageFlagBits::eRaygenKHR);
+  for (const auto& miss : m_spec.miss)
+    reflection.add_stage(compile(miss, vk::ShaderStageFlagBits::eMissKHR),
+      vk::ShaderStageFlagBits::eMissKHR);
+  for (const auto& group : m_spec.hit_groups)
+    reflect_group(reflection, group);
+  reflection.finalize();
+
+  m_reflected_sets = reflection.descriptor_set_infos();
+  m_set_layouts = reflection.create_descriptor_set_layouts(dev);
+
+  const auto& ranges = reflection.push_constant_ranges();
+  vk::PipelineLayoutCreateInfo layoutInfo{};
+  layoutInfo.setLayoutCount = static_cast<uint32_t>(m_set_layouts.size());
+  layoutInfo.pSetLayouts = m_set_layouts.data();
+  layoutInfo.pushConstantRangeCount = static_cast<uint32_t>(ranges.size());
+  layoutInfo.pPushConstantRanges = ranges.data();
+  m_layout = dev.createPipelineLayout(layoutInfo);
+}
 
-  // Specialization constant for closesthit: vertex stride in floats
-  vk::SpecializationMapEntry specEntry{};
-  specEntry.constantID = 0;
-  specEntry.offset = 0;
-  specEntry.size = sizeof(uint32_t);
+vk::Pipeline RayTracingPipeline::create_pipeline(
+  const std::vector<std::pair<std::string, vk::ShaderStageFlagBits>>& stages,
+  const std::vector<vk::RayTracingShaderGroupCreateInfoKHR>& groups, bool library)
+{
+  auto dev = m_device->device();
 
+  // Specialization constants 0..n-1, shared by every stage (IDs a stage does
+  // not declare are ignored).
+  std::vector<vk::SpecializationMapEntry> specEntries(m_spec.constants.size());
+  for (uint32_t i = 0; i < specEntries.size(); ++i)
+  {
+    specEntries[i].constantID = i;
+    specEntries[i].offset = i * static_cast<uint32_t>(sizeof(uint32_t));
+    specEntries[i].size = sizeof(uint32_t);
+  }
   vk::SpecializationInfo specInfo{};
-  specInfo.mapEntryCount = 1;
-  specInfo.pMapEntries = &specEntry;
-  specInfo.dataSize = sizeof(uint32_t);
-  specInfo.pData = &vertex_stride_floats;
-
-  // Shader stages
-  std::vector<vk::PipelineShaderStageCreateInfo> stages(3);
-
-  stages[0].stage = vk::ShaderStageFlagBits::eRaygenKHR;
-  stages[0].module = raygenModule;
-  stages[0].pName = "main";
-
-  stages[1].stage = vk::ShaderStageFlagBits::eMissKHR;
-  stages[1].module = missModule;
-  stages[1].pName = "main";
-
-  stages[2].stage = vk::ShaderStageFlagBits::eClosestHitKHR;
-  stages[2].module = chitModule;
-  stages[2].pName = "main";
-  stages[2].pSpecializationInfo = &specInfo;
-
-  // Shader groups
-  std::vector<vk::RayTracingShaderGroupCreateInfoKHR> groups(3);
-
-  // Raygen group
-  groups[0].type = vk::RayTracingShaderGroupTypeKHR::eGeneral;
-  groups[0].generalShader = 0;
-  groups[0].closestHitShader = VK_SHADER_UNUSED_KHR;
-  groups[0].anyHitShader = VK_SHADER_UNUSED_KHR;
-  groups[0].intersectionShader = VK_SHADER_UNUSED_KHR;
-
-  // Miss group
-  groups[1].type = vk::RayTracingShaderGroupTypeKHR::eGeneral;
-  groups[1].generalShader = 1;
-  groups[1].closestHitShader = VK_SHADER_UNUSED_KHR;
-  groups[1].anyHitShader = VK_SHADER_UNUSED_KHR;
-  groups[1].intersectionShader = VK_SHADER_UNUSED_KHR;
-
-  // Closest hit group
-  groups[2].type = vk::RayTracingShaderGroupTypeKHR::eTrianglesHitGroup;
-  groups[2].generalShader = VK_SHADER_UNUSED_KHR;
-  groups[2].closestHitShader = 2;
-  groups[2].anyHitShader = VK_SHADER_UNUSED_KHR;
-  groups[2].intersectionShader = VK_SHADER_UNUSED_KHR;
-
-  // Pipeline layout
-  vk::PipelineLayoutCreateInfo layoutInfo{};
-  layoutInfo.setLayoutCount = 1;
-  layoutInfo.pSetLayouts = &descriptor_set_layout;
+  specInfo.mapEntryCount = static_cast<uint32_t>(specEntries.size());
+  specInfo.pMapEntries = specEntries.data();
+  specInfo.dataSize = m_spec.constants.size() * sizeof(uint32_t);
+  specInfo.pData = m_spec.constants.data();
 
-  m_layout = dev.createPipelineLayout(layoutInfo);
+  std::vector<vk::PipelineShaderStageCreateInfo> stageInfos(stages.size());
+  for (size_t i = 0; i < stages.size(); ++i)
+  {
+    stageInfos[i].stage = stages[i].second;
+    stageInfos[i].module = ShaderCompiler::create_module(dev, compile(stages[i].first, stages[i].second));
+    stageInfos[i].pName = "main";
+    stageInfos[i].pSpecializationInfo = m_spec.constants.empty() ? nullptr : &specInfo;
+  }
+
+  vk::RayTracingPipelineInterfaceCreateInfoKHR interfaceInfo{};
+  interfaceInfo.maxPipelineRayPayloadSize = m_spec.max_payload_size;
+  interfaceInfo.maxPipelineRayHitAttributeSize = m_spec.max_hit_attribute_size;
 
-  // Create ray tracing pipeline
   vk::RayTracingPipelineCreateInfoKHR pipelineInfo{};
-  pipelineInfo.stageCount = static_cast<uint32_t>(stages.size());
-  pipelineInfo.pStages = stages.data();
+  if (library)
+  {
+    pipelineInfo.flags = vk::PipelineCreateFlagBits::eLibraryKHR;
+    pipelineInfo.pLibraryInterface = &interfaceInfo;
+  }
+  pipelineInfo.stageCount = static_cast<uint32_t>(stageInfos.size());
+  pipelineInfo.pStages = stageInfos.data();
   pipelineInfo.groupCount = static_cast<uint32_t>(groups.size());
   pipelineInfo.pGroups = groups.data();
-  pipelineInfo.maxPipelineRayRecursionDepth = 1;
+  pipelineInfo.maxPipelineRayRecursionDepth = m_spec.max_recursion_depth;
   pipelineInfo.layout = m_layout;
 
   auto result = dev.createRayTracingPipelineKHR(nullptr, nullptr, pipelineInfo);
+
+  for (auto& stage : stageInfos)
+    dev.destroyShaderModule(stage.module);
+
   if (result.result != vk::Result::eSuccess)
   {
     throw std::runtime_error("Failed to create ray tracing pipeline");
   }
-  m_pipeline = result.value;
+  return result.value;
+}
 
-  // Cleanup shader modules
-  dev.destroyShaderModule(raygenModule);
-  dev.destroyShaderModule(missModule);
-  dev.destroyShaderModule(chitModule);
+vk::Pipeline RayTracingPipeline::create_general_library()
+{
+  std::vector<std::pair<std::string, vk::ShaderStageFlagBits>> stages;
+  std::vector<vk::RayTracingShaderGroupCreateInfoKHR> groups;
+  stages.emplace_back(m_spec.raygen, vk::ShaderStageFlagBits::eRaygenKHR);
+  groups.push_back(general_group(0));
+  for (const auto& miss : m_spec.miss)
+  {
+    groups.push_back(general_group(static_cast<uint32_t>(stages.size())));
+    stages.emplace_back(miss, vk::ShaderStageFlagBits::eMissKHR);
+  }
+  return create_pipeline(stages, groups, true);
+}
 
-  // Create shader binding table
-  create_shader_binding_table();
+vk::Pipeline RayTracingPipeline::create_hit_group_library(const RayTracingHitGroup& group)
+{
+  std::vector<std::pair<std::string, vk::ShaderStageFlagBits>> stages;
+  std::vector<vk::RayTracingShaderGroupCreateInfoKHR> groups{ hit_group(group, stages) };
+  return create_pipeline(stages, groups, true);
+}
 
-  spdlog::trace("Created ray tracing pipeline");
+vk::Pipeline RayTracingPipeline::create_monolithic()
+{
+  // Group order matches the linked pipeline: raygen, misses, hit groups.
+  std::vector<std::pair<std::string, vk::ShaderStageFlagBits>> stages;
+  std::vector<vk::RayTracingShaderGroupCreateInfoKHR> groups;
+  stages.emplace_back(m_spec.raygen, vk::ShaderStageFlagBits::eRaygenKHR);
+  groups.push_back(general_group(0));
+  for (const auto& miss : m_spec.miss)
+  {
+    groups.push_back(general_group(static_cast<uint32_t>(stages.size())));
+    stages.emplace_back(miss, vk::ShaderStageFlagBits::eMissKHR);
+  }
+  for (const auto& group : m_spec.hit_groups)
+    groups.push_back(hit_group(group, stages));
+  return create_pipeline(stages, groups, false);
 }
 
-void RayTracingPipeline::create_shader_binding_table()
+void RayTracingPipeline::link()
 {
-  auto dev = m_device->device();
-  const auto& rtCaps = m_device->ray_tracing_capabilities();
+  // The linked pipeline's groups are its libraries' groups, in library order.
+  std::vector<vk::Pipeline> libraries{ m_general_library };
+  libraries.insert(libraries.end(), m_hit_libraries.begin(), m_hit_libraries.end());
 
-  uint32_t handleSize = rtCaps.shaderGroupHandleSize;
-  uint32_t handleAlignment = rtCaps.shaderGroupHandleAlignment;
-  uint32_t baseAlignment = rtCaps.shaderGroupBaseAlignment;
+  vk::PipelineLibraryCreateInfoKHR libraryInfo{};
+  libraryInfo.libraryCount = static_cast<uint32_t>(libraries.size());
+  libraryInfo.pLibraries = libraries.data();
 
-  // Align handle size
-  uint32_t handleSizeAligned = (handleSize + handleAlignment - 1) & ~(handleAlignment - 1);
+  vk::RayTracingPipelineInterfaceCreateInfoKHR interfaceInfo{};
+  interfaceInfo.maxPipelineRayPayloadSize = m_spec.max_payload_size;
+  interfaceInfo.maxPipelineRayHitAttributeSize = m_spec.max_hit_attribute_size;
 
-  // Calculate regions
-  m_raygen_region.stride = (handleSizeAligned + baseAlignment - 1) & ~(baseAlignment - 1);
-  m_raygen_region.size = m_raygen_region.stride; // Only one raygen shader
+  vk::RayTracingPipelineCreateInfoKHR pipelineInfo{};
+  pipelineInfo.pLibraryInfo = &libraryInfo;
+  pipelineInfo.pLibraryInterface = &interfaceInfo;
+  pipelineInfo.maxPipelineRayRecursionDepth = m_spec.max_recursion_depth;
+  pipelineInfo.layout = m_layout;
 
-  m_miss_region.stride = handleSizeAligned;
-  m_miss_region.size = (handleSizeAligned + baseAlignment - 1) & ~(baseAlignment - 1);
+  auto result = m_device->device().createRayTracingPipelineKHR(nullptr, nullptr, pipelineInfo);
+  if (result.result != vk::Result::eSuccess)
+  {
+    throw std::runtime_error("Failed to link ray tracing pipeline");
+  }
+  m_pipeline = result.value;
+}
 
-  m_hit_region.stride = handleSizeAligned;
-  m_hit_region.size = (handleSizeAligned + baseAlignment - 1) & ~(baseAlignment - 1);
+void RayTracingPipeline::create(const RayTracingPipelineSpec& spec)
+{
+  retire_pipeline();
+  retire_layout();
+  m_spec = spec;
+  create_layout();
 
-  m_callable_region.stride = 0;
-  m_callable_region.size = 0;
+  if (m_device->supports_pipeline_library())
+  {
+    m_general_library = create_general_library();
+    for (const auto& group : m_spec.hit_groups)
+      m_hit_libraries.push_back(create_hit_group_library(group));
+    link();
+  }
+  else
+  {
+    m_pipeline = create_monolithic();
+  }
 
-  // Total SBT size
-  vk::DeviceSize sbtSize = m_raygen_region.size + m_miss_region.size + m_hit_region.size;
+  create_shader_binding_table();
 
-  // Get shader group handles
-  uint32_t groupCount = 3;
-  std::vector<uint8_t> handleData(handleSize * groupCount);
-  auto result = dev.getRayTracingShaderGroupHandlesKHR(
-    m_pipeline, 0, groupCount, handleData.size(), handleData.data());
-  if (result != vk::Result::eSuccess)
+  spdlog::trace("Created ray tracing pipeline: {} miss, {} hit groups{}", m_spec.miss.size(),
+    m_spec.hit_groups.size(), linked() ? " (linked from libraries)" : "");
+}
+
+uint32_t RayTracingPipeline::add_hit_group(const RayTracingHitGroup& group)
+{
+  assert(m_layout && "create() the pipeline first");
+
+  // The layout is shared by every library: the new stages must fit it.
+  ShaderReflection reflection;
+  reflect_group(reflection, group);
+  reflection.finalize();
+  for (const auto& set : reflection.descriptor_set_infos())
   {
-    throw std::runtime_error("Failed to get ray tracing shader group handles");
+    auto it = std::find_if(m_reflected_sets.begin(), m_reflected_sets.end(),
+      [&](const DescriptorSetInfo& s) { return s.set == set.set; });
+    for (const auto& b : set.bindings)
+    {
+      const bool found = it != m_reflected_sets.end() &&
+        std::any_of(it->bindings.begin(), it->bindings.end(), [&](const DescriptorBindingInfo& e) {
+          return e.binding == b.binding && e.type == b.type && (e.stageFlags & b.stageFlags);
+        });
+      if (!found)
+        throw std::runtime_error("Hit group '" + group.name + "' uses set=" +
+          std::to_string(set.set) + " binding=" + std::to_string(b.binding) +
+          " outside the ray tracing pipeline layout");
+    }
   }
 
-  // Create SBT buffer
-  vk::BufferCreateInfo bufferInfo{};
-  bufferInfo.size = sbtSize;
-  bufferInfo.usage = vk::BufferUsageFlagBits::eShaderBindingTableKHR |
-    vk::BufferUsageFlagBits::eShaderDeviceAddress;
+  const bool linked_before = linked();
+  auto general = std::exchange(m_general_library, VK_NULL_HANDLE);
+  auto hit_libraries = std::move(m_hit_libraries);
+  m_hit_libraries.clear();
+  retire_pipeline();
 
-  m_sbt_buffer = dev.createBuffer(bufferInfo);
+  m_spec.hit_groups.push_back(group);
+  if (linked_before)
+  {
+    // Only the new group is compiled; the others are relinked as they are.
+    m_general_library = general;
+    m_hit_libraries = std::move(hit_libraries);
+    m_hit_libraries.push_back(create_hit_group_library(group));
+    link();
+  }
+  else
+  {
+    m_pipeline = create_monolithic();
+  }
+  create_shader_binding_table();
 
-  vk::MemoryRequirements memReqs = dev.getBufferMemoryRequirements(m_sbt_buffer);
+  spdlog::trace("Added ray tracing hit group '{}' ({})", group.name, m_spec.hit_groups.size() - 1);
+  return static_cast<uint32_t>(m_spec.hit_groups.size() - 1);
+}
 
-  vk::MemoryAllocateFlagsInfo allocFlags{};
-  allocFlags.flags = vk::MemoryAllocateFlagBits::eDeviceAddress;
+void RayTracingPipeline::retire_pipeline()
+{
+  // Traces in flight may still reference the pipeline and read the SBT.
+  std::vector<vk::Pipeline> pipelines{ m_pipeline, m_general_library };
+  pipelines.insert(pipelines.end(), m_hit_libraries.begin(), m_hit_libraries.end());
+  pipelines.erase(std::remove(pipelines.begin(), pipelines.end(), vk::Pipeline{}), pipelines.end());
+  if (!pipelines.empty())
+  {
+    m_deletion_queue->push([device = m_device->device(), pipelines = std::move(pipelines)] {
+      for (auto pipeline : pipelines)
+        device.destroyPipeline(pipeline);
+    });
+  }
+  m_pipeline = VK_NULL_HANDLE;
+  m_general_library = VK_NULL_HANDLE;
+  m_hit_libraries.clear();
+  m_sbt.reset(); // Buffer defers its own destruction
+}
 
-  vk::MemoryAllocateInfo allocInfo{};
-  allocInfo.pNext = &allocFlags;
-  allocInfo.allocationSize = memReqs.size;
-  allocInfo.memoryTypeIndex = m_device->find_memory_type(
-    memReqs.memoryTypeBits,
-    vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent);
+void RayTracingPipeline::retire_layout()
+{
+  if (!m_layout)
+    return;
+  m_deletion_queue->push([device = m_device->device(), layout = m_layout,
+                           set_layouts = std::move(m_set_layouts)] {
+    device.destroyPipelineLayout(layout);
+    for (auto set_layout : set_layouts)
+      device.destroyDescriptorSetLayout(set_layout);
+  });
+  m_layout = VK_NULL_HANDLE;
+  m_set_layouts.clear();
+  m_reflected_sets.clear();
+  m_spirv.clear(); // a new spec may change the preamble
+}
 
-  m_sbt_memory = dev.allocateMemory(allocInfo);
-  dev.bindBufferMemory(m_sbt_buffer, m_sbt_memory, 0);
+void RayTracingPipeline::create_shader_binding_table()
+{
+  auto dev = m_device->device();
+  const auto& rtCaps = m_device->ray_tracing_capabilities();
 
-  // Get buffer device address
-  vk::BufferDeviceAddressInfo addressInfo{};
-  addressInfo.buffer = m_sbt_buffer;
-  vk::DeviceAddress sbtAddress = dev.getBufferAddress(addressInfo);
+  const uint32_t handleSize = rtCaps.shaderGroupHandleSize;
+  const auto missCount = static_cast<uint32_t>(m_spec.miss.size());
+  const auto hitCount = static_cast<uint32_t>(m_spec.hit_groups.size());
+  const auto sbt = shader_binding_table_layout(handleSize, rtCaps.shaderGroupHandleAlignment,
+    rtCaps.shaderGroupBaseAlignment, missCount, hitCount);
 
-  m_raygen_region.deviceAddress = sbtAddress;
-  m_miss_region.deviceAddress = sbtAddress + m_raygen_region.size;
-  m_hit_region.deviceAddress = sbtAddress + m_raygen_region.size + m_miss_region.size;
+  // Group handles, in group order: raygen, misses, hit groups.
+  const uint32_t groupCount = 1 + missCount + hitCount;
+  std::vector<uint8_t> handleData(static_cast<size_t>(handleSize) * groupCount);
+  auto result = dev.getRayTracingShaderGroupHandlesKHR(
+    m_pipeline, 0, groupCount, handleData.size(), handleData.data());
+  if (result != vk::Result::eSuccess)
+  {
+    throw std::runtime_error("Failed to get ray tracing shader group handles");
+  }
 
-  // Copy handles to SBT buffer
-  void* data = dev.mapMemory(m_sbt_memory, 0, sbtSize);
-  uint8_t* pData = static_cast<uint8_t*>(data);
+  std::vector<uint8_t> table(sbt.total_size, 0);
+  std::memcpy(table.data(), handleData.data(), handleSize);
+  for (uint32_t i = 0; i < missCount; ++i)
+    std::memcpy(table.data() + sbt.miss_offset + i * sbt.record_stride,
+      handleData.data() + static_cast<size_t>(1 + i) * handleSize, handleSize);
+  for (uint32_t i = 0; i < hitCount; ++i)
+    std::memcpy(table.data() + sbt.hit_offset + i * sbt.record_stride,
+      handleData.data() + static_cast<size_t>(1 + missCount + i) * handleSize, handleSize);
+
+  m_sbt = std::make_unique<Buffer>(*m_device, "shader binding table", sbt.total_size,
+    vk::BufferUsageFlagBits::eShaderBindingTableKHR | vk::BufferUsageFlagBits::eShaderDeviceAddress,
+    vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent);
+  m_sbt->update(table.data(), table.size());
 
-  // Raygen
-  std::memcpy(pData, handleData.data(), handleSize);
-  pData += m_raygen_region.size;
+  vk::BufferDeviceAddressInfo addressInfo{};
+  addressInfo.buffer = m_sbt->buffer();
+  const vk::DeviceAddress sbtAddress = dev.getBufferAddress(addressInfo);
 
-  // Miss
-  std::memcpy(pData, handleData.data() + handleSize, handleSize);
-  pData += m_miss_region.size;
+  m_raygen_region = vk::StridedDeviceAddressRegionKHR(sbtAddress, sbt.raygen_size, sbt.raygen_size);
+  m_miss_region = vk::StridedDeviceAddressRegionKHR(
+    sbtAddress + sbt.miss_offset, sbt.record_stride, sbt.miss_size);
+  m_hit_region = vk::StridedDeviceAddressRegionKHR(
+    sbtAddress + sbt.hit_offset, sbt.record_stride, sbt.hit_size);
+  m_callable_region = vk::StridedDeviceAddressRegionKHR{};
 
-  // Hit
-  std::memcpy(pData, handleData.data() + handleSize * 2, handleSize);
+  spdlog::trace("Created shader binding table: {} bytes", sbt.total_size);
+}
 
-  dev.unmapMemory(m_sbt_memory);
+std::vector<vk::DescriptorPoolSize> RayTracingPipeline::pool_sizes(uint32_t count) const
+{
+  std::vector<vk::DescriptorPoolSize> sizes;
+  for (auto& set_info : m_reflected_sets)
+    for (auto& b : set_info.bindings)
+      sizes.push_back({ b.type, b.count * count });
+  return sizes;
+}
 
-  spdlog::trace("Created shader binding table: {} bytes", sbtSize);
+std::vector<vk::DescriptorSet> RayTracingPipeline::allocate_sets(
+  vk::DescriptorPool pool, uint32_t set_index, uint32_t count) const
+{
+  assert(set_index < m_set_layouts.size() && "set index out of range");
+  std::vector<vk::DescriptorSetLayout> layouts(count, m_set_layouts[set_index]);
+
+  vk::DescriptorSetAllocateInfo alloc_info{};
+  alloc_info.descriptorPool = pool;
+  alloc_info.descriptorSetCount = count;
+  alloc_info.pSetLayouts = layouts.data();
+  return m_device->device().allocateDescriptorSets(alloc_info);
 }
 
 void RayTracingPipeline::trace_rays(vk::CommandBuffer cmd, uint32_t width, uint32_t height)
@@ -1,34 +1,116 @@
 #pragma once
 
+#include <vkwave/pipeline/shader_reflection.h>
+
 #include <vulkan/vulkan.hpp>
+
+#include <cstdint>
+#include <map>
+#include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace vkwave
 {
 
+class Buffer;
+class DeletionQueue;
 class Device;
+struct SceneMaterial;
+
+/// The shaders run for hits on one material type: one triangles hit group,
+/// one SBT hit record. A TLAS instance picks it with its SBT offset
+/// (TlasInstance::sbt_offset = the group's index).
+struct RayTracingHitGroup
+{
+  std::string name;
+  std::string closest_hit; // .rchit path, empty = none
+  std::string any_hit;     // .rahit path, empty = none (opaque geometry)
+};
+
+/// Everything RayTracingPipeline::create() compiles and links.
+struct RayTracingPipelineSpec
+{
+  std::string raygen;
+  std::vector<std::string> miss;              // miss index = position
+  std::vector<RayTracingHitGroup> hit_groups; // hit record = position
+  std::string preamble;                       // passed to every stage's compile
+  std::vector<uint32_t> constants;            // specialization constants 0..n-1, every stage
+  uint32_t max_recursion_depth{ 1 };
+  // Pipeline library interface: largest payload / hit attribute of any stage.
+  uint32_t max_payload_size{ 16 };
+  uint32_t max_hit_attribute_size{ 8 };
+};
+
+/// Where each region of a shader binding table lives: records are one group
+/// handle aligned to shaderGroupHandleAlignment, regions start on
+/// shaderGroupBaseAlignment. The raygen region is a single record whose
+/// stride equals its size.
+struct ShaderBindingTableLayout
+{
+  vk::DeviceSize record_stride{ 0 };
+  vk::DeviceSize raygen_size{ 0 };
+  vk::DeviceSize miss_offset{ 0 };
+  vk::DeviceSize miss_size{ 0 };
+  vk::DeviceSize hit_offset{ 0 };
+  vk::DeviceSize hit_size{ 0 };
+  vk::DeviceSize total_size{ 0 };
+};
+
+[[nodiscard]] ShaderBindingTableLayout shader_binding_table_layout(uint32_t handle_size,
+  uint32_t handle_alignment, uint32_t base_alignment, uint32_t miss_count, uint32_t hit_count);
 
-/// Ray tracing pipeline and shader binding table
+/// Hit groups by material type: RayTracingPipeline::material_hit_groups()
+/// order, so a value is also the SBT hit record.
+enum class MaterialHitGroup : uint32_t
+{
+  opaque,     ///< closest hit only
+  alpha_test, ///< + any hit: alphaMode MASK
+  count
+};
+
+/// Ray tracing pipeline and shader binding table.
+///
+/// Stages are compiled through ShaderCompiler (each file and stage once per
+/// pipeline, however many hit groups share it) and the layout comes from
+/// ShaderReflection over all of them, like ComputePipeline. The SBT holds one
+/// raygen record, a record per miss shader and a record per hit group.
+///
+/// With VK_KHR_pipeline_library the raygen + miss stages and every hit group
+/// are compiled as separate libraries and linked: add_hit_group() then
+/// compiles only the new group and relinks. Without it the whole pipeline is
+/// rebuilt.
 class RayTracingPipeline
 {
 public:
-  RayTracingPipeline(const Device& device);
+  explicit RayTracingPipeline(const Device& device);
   ~RayTracingPipeline();
 
   // Non-copyable
   RayTracingPipeline(const RayTracingPipeline&) = delete;
   RayTracingPipeline& operator=(const RayTracingPipeline&) = delete;
 
-  /// Create the ray tracing pipeline
-  /// @param raygen_path Path to ray generation shader SPIR-V
-  /// @param miss_path Path to miss shader SPIR-V
-  /// @param closesthit_path Path to closest hit shader SPIR-V
-  /// @param descriptor_set_layout Descriptor set layout for the pipeline
-  /// @param vertex_stride_floats Number of floats per vertex (for closesthit specialization constant)
-  void create(const std::string& raygen_path, const std::string& miss_path,
-    const std::string& closesthit_path, vk::DescriptorSetLayout descriptor_set_layout,
-    uint32_t vertex_stride_floats);
+  /// The scene pipeline: rt_primary.rgen, rt_environment.rmiss and
+  /// material_hit_groups(), with the vkwave::Vertex stride (in floats) as
+  /// constant 0. The raygen stores into an `output_format` storage image
+  /// (its IMAGE_FORMAT).
+  [[nodiscard]] static RayTracingPipelineSpec scene_spec(vk::Format output_format);
+
+  /// One hit group per MaterialHitGroup, in its order.
+  [[nodiscard]] static std::vector<RayTracingHitGroup> material_hit_groups();
+
+  /// The hit group shading `material`.
+  [[nodiscard]] static MaterialHitGroup hit_group_of(const SceneMaterial& material);
+
+  /// Compile, reflect, link and write the SBT. Throws on failure.
+  void create(const RayTracingPipelineSpec& spec);
+
+  /// Append a hit group (e.g. a new material type) and relink; returns its
+  /// SBT hit record index. Its stages may only use bindings the pipeline
+  /// layout already has (throws otherwise). The previous pipeline and SBT
+  /// are retired through the deletion queue, so frames in flight keep them.
+  uint32_t add_hit_group(const RayTracingHitGroup& group);
 
   /// Trace rays
   /// @param cmd Command buffer
@@ -36,21 +118,59 @@ public:
   /// @param height Image height
   void trace_rays(vk::CommandBuffer cmd, uint32_t width, uint32_t height);
 
+  /// Pool sizes for `count` of every reflected set.
+  [[nodiscard]] std::vector<vk::DescriptorPoolSize> pool_sizes(uint32_t count) const;
+
+  /// Allocate `count` descriptor sets of layout `set_index` from `pool`.
+  [[nodiscard]] std::vector<vk::DescriptorSet> allocate_sets(
+    vk::DescriptorPool pool, uint32_t set_index, uint32_t count) const;
+
   [[nodiscard]] vk::Pipeline pipeline() const { return m_pipeline; }
   [[nodiscard]] vk::PipelineLayout layout() const { return m_layout; }
+  [[nodiscard]] const std::vector<vk::DescriptorSetLayout>& set_layouts() const { return m_set_layouts; }
+  [[nodiscard]] const std::vector<DescriptorSetInfo>& set_infos() const { return m_reflected_sets; }
+  [[nodiscard]] uint32_t hit_group_count() const
+  {
+    return static_cast<uint32_t>(m_spec.hit_groups.size());
+  }
+  /// True when linked from pipeline libraries.
+  [[nodiscard]] bool linked() const { return m_general_library != VK_NULL_HANDLE; }
 
 private:
+  const std::vector<uint32_t>& compile(const std::string& path, vk::ShaderStageFlagBits stage);
+  void reflect_group(ShaderReflection& reflection, const RayTracingHitGroup& group);
+  void create_layout();
+
+  /// Pipeline of the given stages and groups; a library when `library`.
+  vk::Pipeline create_pipeline(
+    const std::vector<std::pair<std::string, vk::ShaderStageFlagBits>>& stages,
+    const std::vector<vk::RayTracingShaderGroupCreateInfoKHR>& groups, bool library);
+  vk::Pipeline create_general_library();
+  vk::Pipeline create_hit_group_library(const RayTracingHitGroup& group);
+  vk::Pipeline create_monolithic();
+  void link();
   void create_shader_binding_table();
-  vk::ShaderModule create_shader_module(const std::string& path);
+  void retire_pipeline();
+  void retire_layout();
 
   const Device* m_device{ nullptr };
+  DeletionQueue* m_deletion_queue{ nullptr };
+  RayTracingPipelineSpec m_spec;
+
+  // Compiled SPIR-V by (path, stage), reused by relinks and shared stages.
+  std::map<std::pair<std::string, vk::ShaderStageFlagBits>, std::vector<uint32_t>> m_spirv;
 
   vk::Pipeline m_pipeline{ VK_NULL_HANDLE };
   vk::PipelineLayout m_layout{ VK_NULL_HANDLE };
+  std::vector<vk::DescriptorSetLayout> m_set_layouts;
+  std::vector<DescriptorSetInfo> m_reflected_sets;
+
+  // Pipeline libraries: raygen + miss, then one per hit group.
+  vk::Pipeline m_general_library{ VK_NULL_HANDLE };
+  std::vector<vk::Pipeline> m_hit_libraries;
 
   // Shader binding table
-  vk::Buffer m_sbt_buffer{ VK_NULL_HANDLE };
-  vk::DeviceMemory m_sbt_memory{ VK_NULL_HANDLE };
+  std::unique_ptr<Buffer> m_sbt;
 
   vk::StridedDeviceAddressRegionKHR m_raygen_region{};
   vk::StridedDeviceAddressRegionKHR m_miss_region{};
@@ -1,6 +1,7 @@
 #include <vkwave/pipeline/render_graph.h>
 
 #include <vkwave/core/device.h>
+#include <vkwave/core/dynamic_resolution.h>
 #include <vkwave/core/swapchain.h>
 #include <vkwave/pipeline/topo_order.h>
 
@@ -9,6 +10,7 @@
 
 #include <algorithm>
 #include <cassert>
+#include <stdexcept>
 #include <unordered_map>
 
 namespace vkwave
@@ -56,6 +58,7 @@ ExecutionGroup& RenderGraph::add_offscreen_group(
   auto eg = std::make_unique<ExecutionGroup>(
     m_device, name, spec, color_format, debug);
   eg->set_signal_present(false); // offscreen groups don't need binary present semaphores
+  eg->set_gpu_timing(m_gpu_timing);
   auto& ref = *eg;
   m_offscreen_groups.push_back(std::move(eg));
   return ref;
@@ -72,11 +75,22 @@ ExecutionGroup& RenderGraph::replace_offscreen_group(
   auto eg = std::make_unique<ExecutionGroup>(
     m_device, name, spec, color_format, debug);
   eg->set_signal_present(false);
+  eg->set_gpu_timing(m_gpu_timing);
   auto& ref = *eg;
   m_offscreen_groups[index] = std::move(eg);
   return ref;
 }
 
+SubmissionGroup& RenderGraph::add_compute_group(const std::string& name, bool debug)
+{
+  auto group = std::make_unique<SubmissionGroup>(m_device, name, debug);
+  group->set_signal_present(false);
+  group->set_gpu_timing(m_gpu_timing);
+  auto& ref = *group;
+  m_offscreen_groups.push_back(std::move(group));
+  return ref;
+}
+
 ExecutionGroup& RenderGraph::set_present_group(
   const std::string& name,
   const PipelineSpec& spec,
@@ -85,9 +99,42 @@ ExecutionGroup& RenderGraph::set_present_group(
 {
   m_present_group = std::make_unique<ExecutionGroup>(
     m_device, name, spec, swapchain_format, debug);
+  m_present_group->set_gpu_timing(m_gpu_timing);
   return static_cast<ExecutionGroup&>(*m_present_group);
 }
 
+void RenderGraph::set_gpu_timing(bool enabled)
+{
+  m_gpu_timing = enabled;
+  for (auto& group : m_offscreen_groups)
+    group->set_gpu_timing(enabled);
+  if (m_present_group)
+    m_present_group->set_gpu_timing(enabled);
+}
+
+float RenderGraph::gpu_frame_time_ms() const
+{
+  float total = 0.0f;
+  for (auto& group : m_offscreen_groups)
+    total += group->gpu_time_ms();
+  if (m_present_group)
+    total += m_present_group->gpu_time_ms();
+  return total;
+}
+
+void RenderGraph::set_render_scale(float scale)
+{
+  m_render_scale = std::clamp(scale, 0.01f, 1.0f);
+  for (auto& group : m_offscreen_groups)
+    group->set_render_extent(
+      DynamicResolution::scaled_extent(group->extent(), m_render_scale));
+}
+
+vk::Extent2D RenderGraph::render_extent() const
+{
+  return DynamicResolution::scaled_extent(m_resources.extent(), m_render_scale);
+}
+
 uint32_t RenderGraph::offscreen_depth() const
 {
   // The offscreen ring depth (per-slot copies of HDR/depth/MSAA-scratch/etc.) is
@@ -114,6 +161,8 @@ void RenderGraph::build(const Swapchain& swapchain)
       m_device, fmt::format("acquire_sem_{}", i)));
   }
   m_sem_to_image.assign(m_swapchain_image_count, UINT32_MAX);
+  m_slot_values.resize(os_depth, 0);
+  m_slot_reads.resize(os_depth, 0);
 
   // Create graph-owned per-slot resources before the groups, since group
   // framebuffers reference them.
@@ -121,10 +170,8 @@ void RenderGraph::build(const Swapchain& swapchain)
 
   // Create offscreen group resources (independent of swapchain)
   for (auto& group : m_offscreen_groups)
-  {
-    auto* eg = static_cast<ExecutionGroup*>(group.get());
-    eg->create_frame_resources(swapchain.extent(), os_depth);
-  }
+    group->create_frame_resources(swapchain.extent(), os_depth);
+  set_render_scale(m_render_scale);
 
   // Create present group resources (uses swapchain views)
   if (m_present_group)
@@ -161,23 +208,27 @@ void RenderGraph::drain()
     m_present_group->drain();
 
   m_device.device().waitIdle();
+
+  // Idle: everything deferred so far can go.
+  m_device.deletion_queue().collect();
 }
 
 void RenderGraph::resize(const Swapchain& swapchain)
 {
-  drain();
-
-  // Destroy present group resources
+  // No drain: the frames in flight keep their command buffers, framebuffers,
+  // descriptor sets and images until the GPU passes them (everything below is
+  // destroyed through the device deletion queue); a slot is only reused after
+  // its last submission (begin_frame()).
+  settle_async();
   if (m_present_group)
     m_present_group->destroy_frame_resources();
-
-  // Destroy offscreen group resources
   for (auto& group : m_offscreen_groups)
     group->destroy_frame_resources();
 
-  // Destroy graph-owned resources (recreated by build() at the new extent).
+  // Graph-owned resources (recreated by build() at the new extent).
   m_resources.destroy();
 
+  // A pending acquire/submit may still reference these.
   m_acquire_semaphores.clear();
   m_sem_to_image.clear();
 
@@ -188,11 +239,36 @@ void RenderGraph::resize(const Swapchain& swapchain)
   build(swapchain);
 }
 
+void RenderGraph::order_after_async(std::vector<SemaphoreWait>& waits)
+{
+  if (!m_async_tail.semaphore)
+    return;
+  // Usually redundant (the async group's consumer waits on it anyway), but
+  // with the consumer gated off the next frame's first group carries it.
+  waits.push_back(m_async_tail);
+  m_async_tail = {};
+}
+
+void RenderGraph::settle_async()
+{
+  if (!m_async_tail.semaphore)
+    return;
+  vk::SemaphoreWaitInfo wait_info{};
+  wait_info.semaphoreCount = 1;
+  wait_info.pSemaphores = &m_async_tail.semaphore;
+  wait_info.pValues = &m_async_tail.value;
+  if (m_device.device().waitSemaphores(wait_info, UINT64_MAX) != vk::Result::eSuccess)
+    throw std::runtime_error("RenderGraph: async compute wait failed");
+  m_async_tail = {};
+}
+
 void RenderGraph::remove_last_offscreen_group()
 {
   if (m_offscreen_groups.empty())
     return;
-  drain();
+  settle_async();
+  // No drain: the group's resources and pipeline are deferred past the frames
+  // that still use them.
   m_offscreen_groups.back()->destroy_frame_resources();
   m_offscreen_groups.pop_back();
   // Size now mismatches m_submit_order, so render_frame falls back to identity
@@ -202,8 +278,9 @@ void RenderGraph::remove_last_offscreen_group()
 
 void RenderGraph::reset_structure()
 {
-  drain();
-
+  // No drain: every handle below is destroyed through the device deletion
+  // queue once the frames in flight have finished with it.
+  settle_async();
   for (auto& group : m_offscreen_groups)
     group->destroy_frame_resources();
   if (m_present_group)
@@ -235,29 +312,74 @@ bool RenderGraph::render_frame(const Swapchain& swapchain)
   m_elapsed_time = std::chrono::duration<float>(now - m_start_time).count();
   m_prev_frame_time = now;
 
+  // Free whatever the GPU is done with (resizes, structural changes, ...).
+  auto& deletion_queue = m_device.deletion_queue();
+  deletion_queue.collect();
+
   const uint32_t os_depth = offscreen_depth();
 
   // 1. Submit offscreen groups (every frame, no acquire/present)
   uint32_t offscreen_slot = static_cast<uint32_t>(m_cpu_frame % os_depth);
   m_last_offscreen_slot = offscreen_slot;
 
+  // The frame that last used this slot must be done — the groups' own waits
+  // (begin_frame()) only cover groups that survived since then.
+  deletion_queue.wait(m_slot_values[offscreen_slot]);
+
+  const bool is_fifo = (swapchain.present_mode() == vk::PresentModeKHR::eFifo);
+
   // Submit offscreen groups in topological order; each waits on the timeline
   // signals of its declared predecessors. Fall back to storage order if the
   // submit order is stale (e.g. a group added after build()).
+  // A group runs when its gating allows or a predecessor ran (fresh input).
+  // A skipped group keeps its slot bookkeeping untouched (no begin_frame()):
+  // its consumers read its latest slot, recorded in m_slot_reads below.
+  std::vector<const SubmissionGroup*> submitted;
+  std::vector<uint32_t> stale_slots;
   const bool order_valid = (m_submit_order.size() == m_offscreen_groups.size());
   for (size_t k = 0; k < m_offscreen_groups.size(); ++k)
   {
     const size_t idx = order_valid ? m_submit_order[k] : k;
     auto& group = *m_offscreen_groups[idx];
+
+    bool run = group.should_submit(m_elapsed_time, is_fifo);
+    for (auto* dep : group.dependencies())
+      run = run || std::find(submitted.begin(), submitted.end(), dep) != submitted.end();
+    if (!run)
+    {
+      if (group.latest_slot() != offscreen_slot)
+        stale_slots.push_back(group.latest_slot());
+      continue;
+    }
+
     group.begin_frame(offscreen_slot);
     auto waits = dependency_waits(group);
-    group.submit(offscreen_slot, waits, m_device.graphics_queue(), m_elapsed_time);
+    // The slot may still be sampled by a recent frame that read it as a
+    // skipped producer's output: wait on the GPU, the CPU wait above only
+    // covered the frame that last rendered it.
+    if (m_slot_reads[offscreen_slot] > m_slot_values[offscreen_slot])
+      waits.push_back({ deletion_queue.timeline(), m_slot_reads[offscreen_slot],
+        vk::PipelineStageFlagBits::eAllCommands });
+    if (group.on_compute_queue())
+    {
+      group.submit(offscreen_slot, waits, m_device.compute_queue(), m_elapsed_time);
+      m_async_tail = { group.timeline_semaphore(), group.latest_signal_value(),
+        vk::PipelineStageFlagBits::eAllCommands };
+    }
+    else
+    {
+      order_after_async(waits);
+      group.submit(offscreen_slot, waits, m_device.graphics_queue(), m_elapsed_time);
+    }
+    submitted.push_back(&group);
   }
+  m_slot_values[offscreen_slot] = deletion_queue.submitted_value();
+  for (uint32_t slot : stale_slots)
+    m_slot_reads[slot] = deletion_queue.submitted_value();
 
   // 2. Conditionally submit present group
   assert(m_present_group && "present group must be set before render_frame()");
 
-  const bool is_fifo = (swapchain.present_mode() == vk::PresentModeKHR::eFifo);
   const bool should_present = m_present_group->should_submit(m_elapsed_time, is_fifo);
 
   if (should_present)
@@ -293,7 +415,8 @@ bool RenderGraph::render_frame(const Swapchain& swapchain)
     // dependencies' timeline signals. If no dependencies were declared, fall
     // back to waiting on the last offscreen group (legacy behavior).
     std::vector<SemaphoreWait> present_waits;
-    present_waits.push_back({ *m_acquire_semaphores[sem_index]->semaphore(), 0 });
+    present_waits.push_back({ *m_acquire_semaphores[sem_index]->semaphore(), 0,
+      m_present_group->acquire_stage() });
 
     auto declared = dependency_waits(*m_present_group);
     if (!declared.empty())
@@ -309,6 +432,7 @@ bool RenderGraph::render_frame(const Swapchain& swapchain)
           vk::PipelineStageFlagBits::eAllCommands });
     }
 
+    order_after_async(present_waits);
     m_present_group->begin_frame(image_index, true);
     m_present_group->submit(image_index, present_waits,
                              m_device.graphics_queue(), m_elapsed_time);
@@ -336,6 +460,9 @@ bool RenderGraph::render_frame(const Swapchain& swapchain)
     }
   }
 
+  m_slot_values[offscreen_slot] = deletion_queue.submitted_value();
+  for (uint32_t slot : stale_slots)
+    m_slot_reads[slot] = deletion_queue.submitted_value();
   m_cpu_frame++;
   return true;
 }
@@ -32,9 +32,16 @@ concept PassInterface = requires(const T ct, T t, vk::CommandBuffer cmd)
 /// Top-level frame orchestration.
 ///
 /// Two-tier submission model:
-///   - Offscreen groups: submit every frame, no swapchain involvement.
+///   - Offscreen groups: no swapchain involvement. Each submits when its gating
+///     allows (every frame by default) or when a predecessor submitted this
+///     frame, rendering into the frame's offscreen slot.
 ///   - Present group: acquires/presents at display rate, waits on last offscreen output.
 ///
+/// Multi-rate: a gated (e.g. wall_clock) producer skips frames. Its consumers
+/// wait on its latest timeline value and sample its latest_slot(), so they see
+/// the latest completed output. A group that renders into a predecessor's
+/// attachments (rather than sampling them) must share its gating.
+///
 /// Owns all groups, acquire semaphores, and the CPU frame counter.
 class RenderGraph
 {
@@ -67,6 +74,11 @@ class RenderGraph
 
   uint32_t m_last_offscreen_slot{ 0 };
 
+  // GPU timestamps on every group (for dynamic resolution), and the render
+  // scale applied to the offscreen groups' viewports.
+  bool m_gpu_timing{ false };
+  float m_render_scale{ 1.0f };
+
   // Topological submission order of offscreen groups (indices into
   // m_offscreen_groups), derived from declared dependencies in build().
   // Storage order is never reordered, so offscreen_group(i) stays stable.
@@ -75,6 +87,31 @@ class RenderGraph
   // Resize callback — called after offscreen resources are destroyed, before rebuild
   std::function<void(vk::Extent2D)> m_resize_fn;
 
+  // Device-timeline value of the last frame that used each offscreen slot.
+  // Waited on before the slot is reused, so per-slot host data stays safe even
+  // when the groups that last used the slot were replaced (no drain).
+  std::vector<uint64_t> m_slot_values;
+
+  // Device-timeline value of the last frame that sampled each slot from a
+  // skipped producer (its latest_slot(), not the frame's own slot). A producer
+  // that renders into the slot again waits for it on the GPU.
+  std::vector<uint64_t> m_slot_reads;
+
+  // The last async-compute submission (its group's timeline) not yet waited
+  // for by a graphics one. Async submissions do not signal the device
+  // timeline (its values must rise in execution order, which two queues do
+  // not give), so deferred destruction is only safe once a graphics
+  // submission has waited for them.
+  SemaphoreWait m_async_tail{};
+
+  /// Append the wait that orders a graphics-queue submission after the last
+  /// async-compute one (see m_async_tail).
+  void order_after_async(std::vector<SemaphoreWait>& waits);
+
+  /// Host-wait for the last async-compute submission before structural
+  /// changes destroy what it uses (the device timeline does not cover it).
+  void settle_async();
+
 public:
   explicit RenderGraph(const Device& device);
   ~RenderGraph();
@@ -93,14 +130,19 @@ public:
                                            vk::Format color_format,
                                            bool debug);
 
+  /// Add an offscreen group with no pipeline or attachments: its record
+  /// callback only dispatches compute (e.g. PostFxChain). May run on the async
+  /// compute queue (SubmissionGroup::set_async_compute()).
+  SubmissionGroup& add_compute_group(const std::string& name, bool debug);
+
   /// Set the present group (renders to swapchain, does acquire/present).
   ExecutionGroup& set_present_group(const std::string& name,
                                      const PipelineSpec& spec,
                                      vk::Format swapchain_format,
                                      bool debug);
 
-  /// Remove the last offscreen group (drains, frees its frame resources, pops it
-  /// and refreshes the submit order). Used to drop the transmission group when an
+  /// Remove the last offscreen group (frees its frame resources through the
+  /// device deletion queue, pops it and refreshes the submit order). Used to drop the transmission group when an
   /// MSAA change makes it invalid — surgical, unlike reset_structure().
   void remove_last_offscreen_group();
 
@@ -108,20 +150,41 @@ public:
   /// Must be called before build(). Default: swapchain image count.
   void set_offscreen_depth(uint32_t n) { m_offscreen_depth = n; }
 
+  /// Time every group's command buffer on the GPU (see
+  /// SubmissionGroup::set_gpu_timing). Applies to groups added afterwards and,
+  /// for existing ones, from the next build()/resize().
+  void set_gpu_timing(bool enabled);
+
+  /// Sum of the groups' last measured GPU times, in milliseconds.
+  [[nodiscard]] float gpu_frame_time_ms() const;
+
+  /// Dynamic resolution: offscreen groups render into the top-left
+  /// scale x extent sub-rectangle of their (full-size) attachments. Re-applied
+  /// after build()/resize(); nothing is reallocated. Clamped to (0, 1].
+  void set_render_scale(float scale);
+  [[nodiscard]] float render_scale() const { return m_render_scale; }
+
+  /// The pool extent scaled by render_scale() — what the offscreen groups draw.
+  [[nodiscard]] vk::Extent2D render_extent() const;
+
   /// Set resize callback (for recreating offscreen images).
   void set_resize_fn(std::function<void(vk::Extent2D)> fn) { m_resize_fn = std::move(fn); }
 
   /// Allocate per-frame resources for all groups.
   void build(const Swapchain& swapchain);
 
-  /// Drain all groups (for shutdown).
+  /// Drain all groups and free everything the device deletion queue holds
+  /// (for shutdown, captures).
   void drain();
 
-  /// Drain + recreate (for resize).
+  /// Recreate the size-dependent resources (for resize) without a drain: the
+  /// groups' frame resources, the pool images and the acquire semaphores are
+  /// destroyed through the device deletion queue and re-created, so frames in
+  /// flight finish on the old ones.
   void resize(const Swapchain& swapchain);
 
-  /// Tear the graph structure all the way down: drain, destroy all group +
-  /// pool resources, and drop the groups, present group, and pool registrations.
+  /// Tear the graph structure all the way down: destroy all group + pool
+  /// resources (deferred past the frames in flight, no drain), and drop the groups, present group, and pool registrations.
   /// After this the graph is back in its pre-`add_offscreen_group()` state — the
   /// caller re-registers pool resources, re-adds groups + dependencies, and
   /// calls `build()`. Used when the pass set itself changes (e.g. a model switch
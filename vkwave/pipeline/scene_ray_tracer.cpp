@@ -0,0 +1,214 @@
+#include <vkwave/pipeline/scene_ray_tracer.h>
+
+#include <vkwave/core/buffer.h>
+#include <vkwave/core/deletion_queue.h>
+#include <vkwave/core/device.h>
+#include <vkwave/loaders/gltf_loader.h>
+
+#include <array>
+#include <bit>
+
+namespace vkwave
+{
+
+namespace
+{
+
+void transition_output(vk::CommandBuffer cmd, vk::Image image,
+  vk::ImageLayout old_layout, vk::ImageLayout new_layout,
+  vk::PipelineStageFlags src_stage, vk::PipelineStageFlags dst_stage,
+  vk::AccessFlags src_access, vk::AccessFlags dst_access)
+{
+  vk::ImageMemoryBarrier barrier{};
+  barrier.oldLayout = old_layout;
+  barrier.newLayout = new_layout;
+  barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.image = image;
+  barrier.subresourceRange = { vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1 };
+  barrier.srcAccessMask = src_access;
+  barrier.dstAccessMask = dst_access;
+  cmd.pipelineBarrier(src_stage, dst_stage, {}, {}, {}, barrier);
+}
+
+} // namespace
+
+std::vector<glm::uvec4> ray_tracing_primitive_table(std::span<const ScenePrimitive> primitives)
+{
+  if (primitives.empty())
+    return { glm::uvec4(0u) };
+
+  std::vector<glm::uvec4> table;
+  table.reserve(primitives.size());
+  for (const auto& prim : primitives)
+    table.emplace_back(prim.firstIndex, std::bit_cast<uint32_t>(prim.vertexOffset),
+      prim.materialIndex, 0u);
+  return table;
+}
+
+SceneRayTracer::SceneRayTracer(const Device& device, vk::Format output_format)
+  : m_device(device)
+  , m_pipeline(device)
+{
+  m_pipeline.create(RayTracingPipeline::scene_spec(output_format));
+}
+
+SceneRayTracer::~SceneRayTracer()
+{
+  destroy_frame_resources();
+}
+
+void SceneRayTracer::create_frame_resources(const FrameResourcePool& pool,
+  FrameResourcePool::ColorHandle output)
+{
+  destroy_frame_resources();
+
+  m_pool = &pool;
+  m_output = output;
+  m_slot_count = pool.slot_count();
+
+  auto dev = m_device.device();
+  auto pool_sizes = m_pipeline.pool_sizes(m_slot_count);
+  vk::DescriptorPoolCreateInfo pool_info{};
+  pool_info.maxSets = m_slot_count;
+  pool_info.poolSizeCount = static_cast<uint32_t>(pool_sizes.size());
+  pool_info.pPoolSizes = pool_sizes.data();
+  m_descriptor_pool = dev.createDescriptorPool(pool_info);
+  m_sets = m_pipeline.allocate_sets(m_descriptor_pool, 0, m_slot_count);
+
+  // Slot s traces into its own output; the scene and the TLAS are written by
+  // the slot's first record().
+  for (uint32_t s = 0; s < m_slot_count; ++s)
+  {
+    vk::DescriptorImageInfo image{ VK_NULL_HANDLE, pool.color_view(output, s),
+      vk::ImageLayout::eGeneral };
+    vk::WriteDescriptorSet write{};
+    write.dstSet = m_sets[s];
+    write.dstBinding = 1;
+    write.descriptorCount = 1;
+    write.descriptorType = vk::DescriptorType::eStorageImage;
+    write.pImageInfo = &image;
+    dev.updateDescriptorSets(write, {});
+  }
+  m_slot_scene_version.assign(m_slot_count, 0);
+  m_slot_tlas.assign(m_slot_count, VK_NULL_HANDLE);
+}
+
+void SceneRayTracer::destroy_frame_resources()
+{
+  // Deferred: a trace in flight may still use the sets.
+  if (m_descriptor_pool)
+  {
+    m_device.deletion_queue().push([dev = m_device.device(), pool = m_descriptor_pool] {
+      dev.destroyDescriptorPool(pool);
+    });
+    m_descriptor_pool = VK_NULL_HANDLE;
+  }
+  m_sets.clear();
+  m_slot_scene_version.clear();
+  m_slot_tlas.clear();
+  m_slot_count = 0;
+  m_pool = nullptr;
+}
+
+void SceneRayTracer::set_scene(const SceneBindings& bindings,
+  std::span<const ScenePrimitive> primitives)
+{
+  const auto table = ray_tracing_primitive_table(primitives);
+  const vk::DeviceSize bytes = table.size() * sizeof(glm::uvec4);
+
+  // Always a fresh buffer: frames in flight may still read the old one.
+  m_primitive_table = std::make_unique<Buffer>(m_device, "ray tracing primitive table", bytes,
+    vk::BufferUsageFlagBits::eStorageBuffer,
+    vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent);
+  m_primitive_table->update(table.data(), bytes);
+
+  m_scene = bindings;
+  m_has_scene = true;
+  ++m_scene_version;
+}
+
+void SceneRayTracer::write_scene(uint32_t slot)
+{
+  vk::DescriptorImageInfo environment{ m_scene.environment_sampler, m_scene.environment,
+    vk::ImageLayout::eShaderReadOnlyOptimal };
+  const std::array<vk::DescriptorBufferInfo, 4> buffers{ {
+    { m_scene.vertices, 0, VK_WHOLE_SIZE },
+    { m_scene.indices, 0, VK_WHOLE_SIZE },
+    { m_primitive_table->buffer(), 0, VK_WHOLE_SIZE },
+    { m_scene.materials, 0, VK_WHOLE_SIZE },
+  } };
+
+  std::array<vk::WriteDescriptorSet, 5> writes{};
+  writes[0].dstSet = m_sets[slot];
+  writes[0].dstBinding = 2;
+  writes[0].descriptorCount = 1;
+  writes[0].descriptorType = vk::DescriptorType::eCombinedImageSampler;
+  writes[0].pImageInfo = &environment;
+  for (uint32_t b = 0; b < buffers.size(); ++b)
+  {
+    writes[1 + b].dstSet = m_sets[slot];
+    writes[1 + b].dstBinding = 3 + b;
+    writes[1 + b].descriptorCount = 1;
+    writes[1 + b].descriptorType = vk::DescriptorType::eStorageBuffer;
+    writes[1 + b].pBufferInfo = &buffers[b];
+  }
+  m_device.device().updateDescriptorSets(writes, {});
+  m_slot_scene_version[slot] = m_scene_version;
+}
+
+void SceneRayTracer::record(vk::CommandBuffer cmd, uint32_t slot, vk::Extent2D render_extent,
+  vk::AccelerationStructureKHR tlas, const RtPrimaryPushConstants& pc)
+{
+  if (slot >= m_slot_count || !m_has_scene || !tlas)
+    return;
+
+  // The graph waited for the slot's previous use: its set is free to update.
+  if (m_slot_scene_version[slot] != m_scene_version)
+    write_scene(slot);
+  if (m_slot_tlas[slot] != tlas)
+  {
+    vk::WriteDescriptorSetAccelerationStructureKHR as_info{};
+    as_info.accelerationStructureCount = 1;
+    as_info.pAccelerationStructures = &tlas;
+    vk::WriteDescriptorSet write{};
+    write.pNext = &as_info;
+    write.dstSet = m_sets[slot];
+    write.dstBinding = 0;
+    write.descriptorCount = 1;
+    write.descriptorType = vk::DescriptorType::eAccelerationStructureKHR;
+    m_device.device().updateDescriptorSets(write, {});
+    m_slot_tlas[slot] = tlas;
+  }
+
+  // The output was last written as a color attachment (or by compute); every
+  // pixel is overwritten.
+  const vk::Image output = m_pool->color_image(m_output, slot);
+  transition_output(cmd, output,
+    vk::ImageLayout::eShaderReadOnlyOptimal, vk::ImageLayout::eGeneral,
+    vk::PipelineStageFlagBits::eColorAttachmentOutput | vk::PipelineStageFlagBits::eFragmentShader
+      | vk::PipelineStageFlagBits::eComputeShader,
+    vk::PipelineStageFlagBits::eRayTracingShaderKHR,
+    vk::AccessFlagBits::eColorAttachmentWrite | vk::AccessFlagBits::eShaderWrite,
+    vk::AccessFlagBits::eShaderWrite);
+
+  const auto layout = m_pipeline.layout();
+  cmd.bindPipeline(vk::PipelineBindPoint::eRayTracingKHR, m_pipeline.pipeline());
+  cmd.bindDescriptorSets(vk::PipelineBindPoint::eRayTracingKHR, layout, 0, 1, &m_sets[slot],
+    0, nullptr);
+  cmd.pushConstants(layout, vk::ShaderStageFlagBits::eRaygenKHR, 0, sizeof(pc), &pc);
+  m_pipeline.trace_rays(cmd, render_extent.width, render_extent.height);
+
+  // Output -> sampled by the composite / TAA, copied by the snapshot and the
+  // screenshot, or LOADed by the OIT resolve and transmission pass.
+  transition_output(cmd, output,
+    vk::ImageLayout::eGeneral, vk::ImageLayout::eShaderReadOnlyOptimal,
+    vk::PipelineStageFlagBits::eRayTracingShaderKHR,
+    vk::PipelineStageFlagBits::eFragmentShader | vk::PipelineStageFlagBits::eComputeShader
+      | vk::PipelineStageFlagBits::eTransfer | vk::PipelineStageFlagBits::eColorAttachmentOutput,
+    vk::AccessFlagBits::eShaderWrite,
+    vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eTransferRead
+      | vk::AccessFlagBits::eColorAttachmentRead | vk::AccessFlagBits::eColorAttachmentWrite);
+}
+
+} // namespace vkwave
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <vkwave/pipeline/frame_resource_pool.h>
+#include <vkwave/pipeline/raytracing_pipeline.h>
+
+#include <glm/glm.hpp>
+#include <vulkan/vulkan.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+namespace vkwave
+{
+
+class Buffer;
+class Device;
+struct ScenePrimitive;
+
+/// Push constants for rt_primary.rgen.
+struct RtPrimaryPushConstants
+{
+  glm::mat4 invViewProj; // inverse of the scene frame's (jittered) view-projection
+  glm::vec4 camPos;      // xyz = eye
+};
+
+static_assert(sizeof(RtPrimaryPushConstants) == 80,
+  "RtPrimaryPushConstants must be 80 bytes to match shader layout");
+
+/// rt_geometry.glsl's primitive table, one entry per TLAS instance (its
+/// custom index): x = first index, y = vertex offset (int bits), z =
+/// material index. An empty `primitives` is the legacy single mesh: one
+/// entry drawing it whole with material 0.
+[[nodiscard]] std::vector<glm::uvec4> ray_tracing_primitive_table(
+  std::span<const ScenePrimitive> primitives);
+
+/// Primary rays through the ray tracing pipeline (RayTracingPipeline::
+/// scene_spec()): one per pixel of the slot's output, which it replaces. A
+/// hit runs the hit group of its instance's material type (the scene TLAS
+/// instances' SBT offsets), a miss samples the environment cubemap.
+///
+/// Set 0 is one descriptor set per slot:
+///
+///   0 TLAS       written by record() when the handle changed
+///   1 output     storage image, the pool colour resource of the slot
+///   2 environment cubemap
+///   3-6          vertex / index buffers, primitive table, GpuMaterial[]
+///
+/// set_scene() keeps the scene bindings and record() rewrites a slot's set
+/// once it records with a stale one (the graph has waited for the slot), so a
+/// model switch does not disturb frames in flight.
+class SceneRayTracer
+{
+public:
+  /// The scene's buffers for bindings 2-6. The vertex and index buffers need
+  /// eStorageBuffer usage (Mesh has it on ray tracing devices).
+  struct SceneBindings
+  {
+    vk::Buffer vertices{ VK_NULL_HANDLE };
+    vk::Buffer indices{ VK_NULL_HANDLE };
+    vk::Buffer materials{ VK_NULL_HANDLE };
+    vk::ImageView environment{ VK_NULL_HANDLE };
+    vk::Sampler environment_sampler{ VK_NULL_HANDLE };
+  };
+
+  /// `output_format` is the output's storage format (compiled into the raygen).
+  SceneRayTracer(const Device& device, vk::Format output_format);
+  ~SceneRayTracer();
+
+  SceneRayTracer(const SceneRayTracer&) = delete;
+  SceneRayTracer& operator=(const SceneRayTracer&) = delete;
+
+  /// (Re)create the per-slot descriptor sets for the pool's current resources.
+  /// The previous ones are destroyed through the device deletion queue.
+  void create_frame_resources(const FrameResourcePool& pool,
+                              FrameResourcePool::ColorHandle output);
+
+  void destroy_frame_resources();
+
+  /// Upload the primitive table (see ray_tracing_primitive_table()) and keep
+  /// `bindings` for the slots' sets. The previous table stays alive for the
+  /// frames in flight.
+  void set_scene(const SceneBindings& bindings, std::span<const ScenePrimitive> primitives);
+
+  /// Drop the scene (a mesh without an index buffer): record() does nothing
+  /// until the next set_scene().
+  void clear_scene() { m_has_scene = false; }
+
+  /// Trace `slot`'s output. Record outside any render pass, after the TLAS
+  /// build and the last raster write of the output, which is in
+  /// eShaderReadOnlyOptimal before and after. `render_extent` is the part of
+  /// it drawn this frame.
+  void record(vk::CommandBuffer cmd, uint32_t slot, vk::Extent2D render_extent,
+              vk::AccelerationStructureKHR tlas, const RtPrimaryPushConstants& pc);
+
+  [[nodiscard]] RayTracingPipeline& pipeline() { return m_pipeline; }
+
+  /// True with frame resources and a scene.
+  [[nodiscard]] bool ready() const { return m_slot_count > 0 && m_has_scene; }
+
+private:
+  void write_scene(uint32_t slot);
+
+  const Device& m_device;
+  RayTracingPipeline m_pipeline;
+
+  SceneBindings m_scene;
+  std::unique_ptr<Buffer> m_primitive_table;
+  uint32_t m_scene_version{ 0 }; // bumped by set_scene()
+  bool m_has_scene{ false };
+
+  const FrameResourcePool* m_pool{ nullptr };
+  FrameResourcePool::ColorHandle m_output{ 0 };
+  uint32_t m_slot_count{ 0 };
+
+  vk::DescriptorPool m_descriptor_pool{ VK_NULL_HANDLE };
+  std::vector<vk::DescriptorSet> m_sets;                   // [slot]
+  std::vector<uint32_t> m_slot_scene_version;              // [slot], written last
+  std::vector<vk::AccelerationStructureKHR> m_slot_tlas;   // [slot], written last
+};
+
+} // namespace vkwave
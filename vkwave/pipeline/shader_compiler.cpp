@@ -48,6 +48,12 @@ static EShLanguage to_glslang_stage(vk::ShaderStageFlagBits stage)
   case vk::ShaderStageFlagBits::eGeometry:               return EShLangGeometry;
   case vk::ShaderStageFlagBits::eTessellationControl:    return EShLangTessControl;
   case vk::ShaderStageFlagBits::eTessellationEvaluation: return EShLangTessEvaluation;
+  case vk::ShaderStageFlagBits::eRaygenKHR:              return EShLangRayGen;
+  case vk::ShaderStageFlagBits::eMissKHR:                return EShLangMiss;
+  case vk::ShaderStageFlagBits::eClosestHitKHR:          return EShLangClosestHit;
+  case vk::ShaderStageFlagBits::eAnyHitKHR:              return EShLangAnyHit;
+  case vk::ShaderStageFlagBits::eIntersectionKHR:        return EShLangIntersect;
+  case vk::ShaderStageFlagBits::eCallableKHR:            return EShLangCallable;
   default:
     throw std::runtime_error("Unsupported shader stage for compilation");
   }
@@ -127,7 +133,8 @@ ShaderCompiler::~ShaderCompiler()
 }
 
 ShaderCompiler::Result ShaderCompiler::compile(
-  const std::string& filepath, vk::ShaderStageFlagBits stage) const
+  const std::string& filepath, vk::ShaderStageFlagBits stage,
+  const std::string& preamble) const
 {
   // Read GLSL source from file
   std::ifstream file(filepath);
@@ -154,6 +161,8 @@ ShaderCompiler::Result ShaderCompiler::compile(
   shader.setStringsWithLengthsAndNames(&source_cstr, &source_len, &name_cstr, 1);
   shader.setEntryPoint("main");
   shader.setSourceEntryPoint("main");
+  if (!preamble.empty())
+    shader.setPreamble(preamble.c_str());
 
   if (m_debug_info)
     shader.setDebugInfo(true);
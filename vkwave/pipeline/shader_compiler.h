@@ -29,8 +29,10 @@ public:
   void set_optimization(bool enable) { m_optimize = enable; }
 
   /// Compile GLSL file to SPIR-V. Throws on failure.
+  /// @param preamble source inserted after the #version line, e.g. `#define`s
+  ///                 that pick a storage-image format qualifier.
   Result compile(const std::string& filepath,
-    vk::ShaderStageFlagBits stage) const;
+    vk::ShaderStageFlagBits stage, const std::string& preamble = {}) const;
 
   /// Create VkShaderModule from compiled SPIR-V.
   static vk::ShaderModule create_module(vk::Device device,
@@ -35,6 +35,8 @@ static vk::DescriptorType to_vk_descriptor_type(SpvReflectDescriptorType type)
     return vk::DescriptorType::eStorageBufferDynamic;
   case SPV_REFLECT_DESCRIPTOR_TYPE_INPUT_ATTACHMENT:
     return vk::DescriptorType::eInputAttachment;
+  case SPV_REFLECT_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR:
+    return vk::DescriptorType::eAccelerationStructureKHR;
   default:
     throw std::runtime_error("Unknown SPIRV-Reflect descriptor type");
   }
@@ -0,0 +1,349 @@
+#include <vkwave/pipeline/shadow_cascades.h>
+
+#include <vkwave/config.h>
+#include <vkwave/core/camera.h>
+#include <vkwave/core/commands.h>
+#include <vkwave/core/device.h>
+#include <vkwave/core/mesh.h>
+#include <vkwave/core/vertex.h>
+#include <vkwave/loaders/gltf_loader.h>
+#include <vkwave/pipeline/pbr_pass.h>
+#include <vkwave/pipeline/pipeline.h>
+#include <vkwave/pipeline/shader_compiler.h>
+#include <vkwave/pipeline/shader_reflection.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace vkwave
+{
+
+namespace
+{
+
+// A cached cascade covers this much more than the camera needs, so small
+// camera moves stay inside it; it is refitted once it is this much too large.
+constexpr float kCacheMargin = 1.25f;
+constexpr float kCacheShrink = 2.0f;
+
+// Light turned by more than ~0.25 degrees: cached depth no longer matches.
+constexpr float kLightEpsilon = 0.99999f;
+
+} // namespace
+
+ShadowCascades::ShadowCascades(const Device& device, vk::Format depth_format, bool debug)
+  : m_device(device)
+  , m_format(depth_format)
+{
+  auto dev = device.device();
+  const vk::Extent2D extent{ ShadowCascade::Resolution, ShadowCascade::Resolution };
+
+  // Depth array image: one layer per cascade.
+  vk::ImageCreateInfo image_info{};
+  image_info.imageType = vk::ImageType::e2D;
+  image_info.extent = vk::Extent3D{ extent.width, extent.height, 1 };
+  image_info.mipLevels = 1;
+  image_info.arrayLayers = ShadowCascade::Count;
+  image_info.format = m_format;
+  image_info.tiling = vk::ImageTiling::eOptimal;
+  image_info.initialLayout = vk::ImageLayout::eUndefined;
+  image_info.usage = vk::ImageUsageFlagBits::eDepthStencilAttachment
+                   | vk::ImageUsageFlagBits::eSampled
+                   | vk::ImageUsageFlagBits::eTransferDst; // initial clear
+  image_info.samples = vk::SampleCountFlagBits::e1;
+  image_info.sharingMode = vk::SharingMode::eExclusive;
+  m_image = dev.createImage(image_info);
+
+  vk::MemoryRequirements mem_reqs = dev.getImageMemoryRequirements(m_image);
+  vk::MemoryAllocateInfo alloc_info{};
+  alloc_info.allocationSize = mem_reqs.size;
+  alloc_info.memoryTypeIndex = device.find_memory_type(
+    mem_reqs.memoryTypeBits, vk::MemoryPropertyFlagBits::eDeviceLocal);
+  m_memory = dev.allocateMemory(alloc_info);
+  dev.bindImageMemory(m_image, m_memory, 0);
+
+  vk::ImageViewCreateInfo view_info{};
+  view_info.image = m_image;
+  view_info.viewType = vk::ImageViewType::e2DArray;
+  view_info.format = m_format;
+  view_info.subresourceRange = { vk::ImageAspectFlagBits::eDepth, 0, 1, 0, ShadowCascade::Count };
+  m_array_view = dev.createImageView(view_info);
+
+  m_renderpass = make_shadow_renderpass(dev, m_format, debug);
+
+  for (uint32_t c = 0; c < ShadowCascade::Count; ++c)
+  {
+    view_info.viewType = vk::ImageViewType::e2D;
+    view_info.subresourceRange = { vk::ImageAspectFlagBits::eDepth, 0, 1, c, 1 };
+    m_layer_views[c] = dev.createImageView(view_info);
+
+    vk::FramebufferCreateInfo fb_info{};
+    fb_info.renderPass = m_renderpass;
+    fb_info.attachmentCount = 1;
+    fb_info.pAttachments = &m_layer_views[c];
+    fb_info.width = extent.width;
+    fb_info.height = extent.height;
+    fb_info.layers = 1;
+    m_framebuffers[c] = dev.createFramebuffer(fb_info);
+  }
+
+  // Depth compare in the sampler; linear filtering blends the four compare
+  // results (2x2 PCF per tap). Outside the map counts as lit.
+  vk::SamplerCreateInfo sampler_info{};
+  sampler_info.magFilter = vk::Filter::eLinear;
+  sampler_info.minFilter = vk::Filter::eLinear;
+  sampler_info.mipmapMode = vk::SamplerMipmapMode::eNearest;
+  sampler_info.addressModeU = vk::SamplerAddressMode::eClampToBorder;
+  sampler_info.addressModeV = vk::SamplerAddressMode::eClampToBorder;
+  sampler_info.addressModeW = vk::SamplerAddressMode::eClampToEdge;
+  sampler_info.borderColor = vk::BorderColor::eFloatOpaqueWhite;
+  sampler_info.compareEnable = VK_TRUE;
+  sampler_info.compareOp = vk::CompareOp::eLessOrEqual;
+  m_sampler = dev.createSampler(sampler_info);
+
+  // Depth-only pipeline: shadow.vert with the position attribute only, no
+  // fragment shader, no culling (open and double-sided meshes must cast too),
+  // dynamic depth bias.
+  auto compiler = ShaderCompiler::get();
+  assert(compiler && "ShaderCompiler not created — call ShaderCompiler::create() first");
+  auto vert = compiler->compile(SHADER_DIR "shadow.vert", vk::ShaderStageFlagBits::eVertex);
+
+  ShaderReflection reflection;
+  reflection.set_debug(compiler->debug_info());
+  reflection.add_stage(vert.spirv, vk::ShaderStageFlagBits::eVertex);
+  reflection.finalize();
+
+  auto vert_mod = ShaderCompiler::create_module(dev, vert.spirv);
+
+  GraphicsPipelineInBundle bundle_in{};
+  bundle_in.device = dev;
+  bundle_in.swapchainExtent = extent; // viewport/scissor are dynamic state
+  bundle_in.swapchainImageFormat = m_format;
+  bundle_in.vertexModule = vert_mod;
+  bundle_in.reflection = &reflection;
+  bundle_in.vertexBindings = { Vertex::binding_description() };
+  bundle_in.vertexAttributes = { Vertex::attribute_descriptions()[0] };
+  bundle_in.backfaceCulling = false;
+  bundle_in.depthTestEnabled = true;
+  bundle_in.depthWriteEnabled = true;
+  bundle_in.depthFormat = m_format;
+  bundle_in.depthBiasEnabled = true;
+  bundle_in.existingRenderPass = m_renderpass;
+
+  auto bundle_out = create_graphics_pipeline(bundle_in, debug);
+  m_pipeline = bundle_out.pipeline;
+  m_layout = bundle_out.layout;
+  dev.destroyShaderModule(vert_mod);
+
+  // Start fully lit and sampleable, so the scene pass may bind the map before
+  // (or without) any cascade being drawn.
+  submit_one_shot(device, [this](vk::CommandBuffer cmd) {
+    vk::ImageMemoryBarrier barrier{};
+    barrier.oldLayout = vk::ImageLayout::eUndefined;
+    barrier.newLayout = vk::ImageLayout::eTransferDstOptimal;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = m_image;
+    barrier.subresourceRange = { vk::ImageAspectFlagBits::eDepth, 0, 1, 0, ShadowCascade::Count };
+    barrier.dstAccessMask = vk::AccessFlagBits::eTransferWrite;
+    cmd.pipelineBarrier(vk::PipelineStageFlagBits::eTopOfPipe,
+      vk::PipelineStageFlagBits::eTransfer, {}, {}, {}, barrier);
+
+    vk::ClearDepthStencilValue clear{ 1.0f, 0 };
+    cmd.clearDepthStencilImage(m_image, vk::ImageLayout::eTransferDstOptimal,
+      clear, barrier.subresourceRange);
+
+    barrier.oldLayout = vk::ImageLayout::eTransferDstOptimal;
+    barrier.newLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
+    barrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+    barrier.dstAccessMask = vk::AccessFlagBits::eShaderRead;
+    cmd.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer,
+      vk::PipelineStageFlagBits::eFragmentShader, {}, {}, {}, barrier);
+  });
+}
+
+ShadowCascades::~ShadowCascades()
+{
+  auto dev = m_device.device();
+  if (m_pipeline)
+    dev.destroyPipeline(m_pipeline);
+  if (m_layout)
+    dev.destroyPipelineLayout(m_layout);
+  for (auto fb : m_framebuffers)
+    if (fb)
+      dev.destroyFramebuffer(fb);
+  for (auto view : m_layer_views)
+    if (view)
+      dev.destroyImageView(view);
+  if (m_renderpass)
+    dev.destroyRenderPass(m_renderpass);
+  if (m_sampler)
+    dev.destroySampler(m_sampler);
+  if (m_array_view)
+    dev.destroyImageView(m_array_view);
+  if (m_image)
+    dev.destroyImage(m_image);
+  if (m_memory)
+    dev.freeMemory(m_memory);
+}
+
+void ShadowCascades::set_casters(std::span<const ScenePrimitive> primitives)
+{
+  m_caster_spheres.clear();
+  m_caster_spheres.reserve(primitives.size());
+  AABB scene;
+  for (auto& prim : primitives)
+  {
+    AABB world;
+    if (!prim.bounds.valid())
+      world.expand(glm::vec3(prim.modelMatrix[3]));
+    for (int c = 0; c < 8 && prim.bounds.valid(); ++c)
+    {
+      glm::vec3 corner(
+        (c & 1) ? prim.bounds.max.x : prim.bounds.min.x,
+        (c & 2) ? prim.bounds.max.y : prim.bounds.min.y,
+        (c & 4) ? prim.bounds.max.z : prim.bounds.min.z);
+      world.expand(glm::vec3(prim.modelMatrix * glm::vec4(corner, 1.0f)));
+    }
+    scene.expand(world.min);
+    scene.expand(world.max);
+    m_caster_spheres.emplace_back(0.5f * (world.min + world.max),
+      0.5f * glm::length(world.max - world.min));
+  }
+
+  m_scene_min = scene.valid() ? scene.min : glm::vec3(1.0f);
+  m_scene_max = scene.valid() ? scene.max : glm::vec3(-1.0f);
+  invalidate();
+}
+
+void ShadowCascades::invalidate()
+{
+  m_valid.fill(false);
+}
+
+void ShadowCascades::update(const Camera& camera, const glm::vec3& light_direction)
+{
+  const float near_plane = camera.near_plane();
+  const float far_plane = m_settings.max_distance > 0.0f
+    ? std::min(std::max(m_settings.max_distance, near_plane * 2.0f), camera.far_plane())
+    : camera.far_plane();
+  const auto splits = cascade_split_distances(near_plane, far_plane, m_settings.split_lambda);
+
+  const glm::vec3 dir = glm::normalize(light_direction);
+  const bool light_moved = glm::dot(dir, m_light_direction) < kLightEpsilon;
+  m_light_direction = dir;
+
+  for (uint32_t c = 0; c < ShadowCascade::Count; ++c)
+  {
+    const float slice_near = (c == 0) ? near_plane : splits[c - 1];
+    const float slice_far = splits[c];
+    const bool cached = m_settings.cache_far_cascades && c >= m_settings.cached_from;
+
+    glm::vec4 sphere;
+    if (cached)
+    {
+      // Keep the cached depth while it still covers every view direction
+      // from the current camera position and is not needlessly coarse.
+      const glm::vec4 need = camera_centered_sphere(camera, slice_far);
+      const auto& fit = m_fits[c];
+      const bool covers = glm::length(glm::vec3(need) - fit.center) + need.w <= fit.radius;
+      const bool too_coarse = fit.radius > need.w * kCacheMargin * kCacheShrink;
+      if (m_valid[c] && !light_moved && covers && !too_coarse)
+        continue;
+      sphere = glm::vec4(glm::vec3(need), need.w * kCacheMargin);
+    }
+    else
+    {
+      sphere = frustum_slice_sphere(camera, slice_near, slice_far);
+    }
+
+    m_fits[c] = fit_cascade(sphere, dir, m_scene_min, m_scene_max, ShadowCascade::Resolution);
+    m_valid[c] = true;
+    m_dirty[c] = true;
+  }
+
+  for (uint32_t c = 0; c < ShadowCascade::Count; ++c)
+  {
+    m_uniforms.matrices[c] = m_fits[c].view_proj;
+    m_uniforms.splits[static_cast<int>(c)] = splits[c];
+    m_uniforms.texelSize[static_cast<int>(c)] = m_fits[c].texel_size;
+  }
+  m_uniforms.params = glm::vec4(1.0f, m_settings.normal_offset, m_settings.pcf_radius,
+    1.0f / static_cast<float>(ShadowCascade::Resolution));
+}
+
+uint32_t ShadowCascades::record(vk::CommandBuffer cmd, const PBRContext& ctx, const glm::mat4& model)
+{
+  const vk::Extent2D extent{ ShadowCascade::Resolution, ShadowCascade::Resolution };
+  const bool per_primitive = ctx.primitives && ctx.primitive_count > 0;
+  assert((!per_primitive || m_caster_spheres.size() == ctx.primitive_count)
+    && "set_casters() not called for the current primitives");
+
+  uint32_t rendered = 0;
+  for (uint32_t c = 0; c < ShadowCascade::Count; ++c)
+  {
+    if (!m_dirty[c])
+      continue;
+    m_dirty[c] = false;
+    ++rendered;
+
+    vk::ClearValue clear{};
+    clear.depthStencil = vk::ClearDepthStencilValue{ 1.0f, 0 };
+
+    vk::RenderPassBeginInfo rp_info{};
+    rp_info.renderPass = m_renderpass;
+    rp_info.framebuffer = m_framebuffers[c];
+    rp_info.renderArea.extent = extent;
+    rp_info.clearValueCount = 1;
+    rp_info.pClearValues = &clear;
+    cmd.beginRenderPass(rp_info, vk::SubpassContents::eInline);
+
+    cmd.bindPipeline(vk::PipelineBindPoint::eGraphics, m_pipeline);
+    vk::Viewport viewport{ 0.f, 0.f,
+      static_cast<float>(extent.width), static_cast<float>(extent.height), 0.f, 1.f };
+    cmd.setViewport(0, viewport);
+    cmd.setScissor(0, vk::Rect2D{ { 0, 0 }, extent });
+    cmd.setDepthBias(m_settings.depth_bias_constant, 0.0f, m_settings.depth_bias_slope);
+    ctx.mesh->bind(cmd);
+
+    ShadowPushConstants pc{};
+    pc.lightViewProj = m_fits[c].view_proj;
+
+    if (!per_primitive)
+    {
+      pc.model = model;
+      cmd.pushConstants(m_layout, vk::ShaderStageFlagBits::eVertex, 0, sizeof(pc), &pc);
+      ctx.mesh->draw(cmd);
+      cmd.endRenderPass();
+      continue;
+    }
+
+    // Opaque and masked casters whose bounding sphere overlaps the cascade's
+    // window (depth is not tested: the range already spans the scene).
+    const float inv_radius = 1.0f / m_fits[c].radius;
+    for (uint32_t i = 0; i < ctx.primitive_count; ++i)
+    {
+      auto& prim = ctx.primitives[i];
+      if (prim.materialIndex >= ctx.material_count) continue;
+      auto& mat = ctx.materials[prim.materialIndex];
+      if (mat.alphaMode == AlphaMode::Blend || mat.transmissionFactor > 0.0f) continue;
+
+      const glm::vec4& s = m_caster_spheres[i];
+      const glm::vec4 clip = pc.lightViewProj * glm::vec4(glm::vec3(s), 1.0f);
+      const float reach = 1.0f + s.w * inv_radius;
+      if (std::abs(clip.x) > reach || std::abs(clip.y) > reach) continue;
+
+      pc.model = prim.modelMatrix;
+      cmd.pushConstants(m_layout, vk::ShaderStageFlagBits::eVertex, 0, sizeof(pc), &pc);
+      ctx.mesh->draw_indexed(cmd, prim.indexCount, prim.firstIndex, prim.vertexOffset);
+    }
+
+    cmd.endRenderPass();
+  }
+
+  m_rendered_last_frame = rendered;
+  return rendered;
+}
+
+} // namespace vkwave
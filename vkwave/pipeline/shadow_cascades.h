@@ -0,0 +1,126 @@
+#pragma once
+
+#include <vkwave/core/shadow_cascade.h>
+
+#include <glm/glm.hpp>
+#include <vulkan/vulkan.hpp>
+
+#include <array>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace vkwave
+{
+
+class Camera;
+class Device;
+struct PBRContext;
+struct ScenePrimitive;
+
+/// Cascaded shadow maps for the directional light, with cached far cascades.
+///
+/// Owns one depth array image (ShadowCascade::Count layers of Resolution^2),
+/// a depth-only pipeline (shadow.vert, no fragment shader) and one framebuffer
+/// per layer. The image is persistent, not per frame slot: a cascade that is
+/// not re-rendered keeps its depth and its light matrix from the frame that
+/// drew it. Rewriting a layer is ordered after earlier frames' reads by the
+/// shadow render pass's external dependency (all work is on one queue).
+///
+/// Per frame, update() fits the cascades to the camera and decides which ones
+/// to redraw; record() draws them before the scene pass.
+///
+///   near cascades (index < Settings::cached_from): tight sphere around the
+///     frustum slice, redrawn every frame.
+///   far cascades: sphere around the camera position (orientation-independent)
+///     with a margin, redrawn only when the camera leaves it, the light turns,
+///     or invalidate() reports moved geometry.
+///
+/// Both fits are texel-snapped in light space, so the shadow edges do not
+/// shimmer while the camera moves.
+class ShadowCascades
+{
+public:
+  struct Settings
+  {
+    bool cache_far_cascades{ true };
+    uint32_t cached_from{ 1 };   // first cascade that may be cached
+    float split_lambda{ ShadowCascade::DefaultSplitLambda };
+    float max_distance{ 0.0f };  // shadow range; 0 = camera far plane
+    float depth_bias_constant{ 1.25f };
+    float depth_bias_slope{ 1.75f };
+    float normal_offset{ 1.0f }; // receiver offset along N, in cascade texels
+    float pcf_radius{ 1.0f };    // PCF kernel radius in texels (0 = single tap)
+  };
+
+  /// `depth_format`: the cascade array's depth format (orthographic depth, so
+  /// D16 is enough; see select_depth_format()).
+  ShadowCascades(const Device& device, vk::Format depth_format, bool debug);
+  ~ShadowCascades();
+
+  ShadowCascades(const ShadowCascades&) = delete;
+  ShadowCascades& operator=(const ShadowCascades&) = delete;
+
+  /// World-space bounds of the shadow casters, for per-cascade culling and to
+  /// reach the depth range back to every caster. Invalidates all cascades.
+  /// Call on model load.
+  void set_casters(std::span<const ScenePrimitive> primitives);
+
+  /// Redraw every cascade on the next update()/record() (geometry moved).
+  void invalidate();
+
+  /// Fit the cascades to `camera` for a light shining from `light_direction`
+  /// (pointing at the light, as PBRContext::light_direction) and mark the
+  /// ones that must be redrawn. Call right before record().
+  void update(const Camera& camera, const glm::vec3& light_direction);
+
+  /// Draw the cascades marked by update(), outside any render pass: the
+  /// context's opaque primitives, or its whole mesh with `model` on the
+  /// single-draw path. Returns the number of cascades drawn.
+  uint32_t record(vk::CommandBuffer cmd, const PBRContext& ctx, const glm::mat4& model);
+
+  /// Cascade matrices/splits for the scene shaders (see PbrUBO::shadow).
+  [[nodiscard]] const ShadowUniforms& uniforms() const { return m_uniforms; }
+
+  /// All cascades as one 2D-array view, in eShaderReadOnlyOptimal.
+  [[nodiscard]] vk::ImageView array_view() const { return m_array_view; }
+
+  /// Comparison sampler (LESS_OR_EQUAL, linear): hardware 2x2 PCF per tap.
+  [[nodiscard]] vk::Sampler sampler() const { return m_sampler; }
+
+  [[nodiscard]] Settings& settings() { return m_settings; }
+
+  /// Cascades drawn by the last record() (1 when only the near one moved).
+  [[nodiscard]] uint32_t rendered_last_frame() const { return m_rendered_last_frame; }
+
+private:
+  const Device& m_device;
+  vk::Format m_format;
+  Settings m_settings;
+
+  vk::Image m_image{ VK_NULL_HANDLE };
+  vk::DeviceMemory m_memory{ VK_NULL_HANDLE };
+  vk::ImageView m_array_view{ VK_NULL_HANDLE };
+  std::array<vk::ImageView, ShadowCascade::Count> m_layer_views{};
+  std::array<vk::Framebuffer, ShadowCascade::Count> m_framebuffers{};
+  vk::Sampler m_sampler{ VK_NULL_HANDLE };
+
+  vk::RenderPass m_renderpass{ VK_NULL_HANDLE };
+  vk::PipelineLayout m_layout{ VK_NULL_HANDLE };
+  vk::Pipeline m_pipeline{ VK_NULL_HANDLE };
+
+  std::array<CascadeFit, ShadowCascade::Count> m_fits{};
+  std::array<bool, ShadowCascade::Count> m_valid{};  // fit + depth usable as cache
+  std::array<bool, ShadowCascade::Count> m_dirty{};  // draw in the next record()
+  glm::vec3 m_light_direction{ 0.0f };
+  ShadowUniforms m_uniforms{};
+  uint32_t m_rendered_last_frame{ 0 };
+
+  // Caster bounding spheres (xyz = world centre, w = radius), parallel to the
+  // primitives passed to set_casters(), and their union.
+  std::vector<glm::vec4> m_caster_spheres;
+  glm::vec3 m_scene_min{ 1.0f };
+  glm::vec3 m_scene_max{ -1.0f };
+};
+
+} // namespace vkwave
@@ -1,12 +1,15 @@
 #include <vkwave/pipeline/submission_group.h>
 
 #include <vkwave/core/commands.h>
+#include <vkwave/core/deletion_queue.h>
 #include <vkwave/core/device.h>
 #include <vkwave/core/swapchain.h>
 
 #include <spdlog/fmt/fmt.h>
 #include <spdlog/spdlog.h>
 
+#include <algorithm>
+#include <array>
 #include <cassert>
 
 namespace vkwave
@@ -34,6 +37,11 @@ void SubmissionGroup::set_record_fn(RecordFn fn)
   m_record_fn = std::move(fn);
 }
 
+void SubmissionGroup::set_pre_record_fn(PreRecordFn fn)
+{
+  m_pre_record_fn = std::move(fn);
+}
+
 void SubmissionGroup::set_post_record_fn(PostRecordFn fn)
 {
   m_post_record_fn = std::move(fn);
@@ -44,6 +52,8 @@ void SubmissionGroup::create_frame_resources(
 {
   m_frames = vkwave::create_frame_resources(m_device, count);
   m_extent = swapchain.extent();
+  m_render_extent = m_extent;
+  create_timing_queries(count);
 
   // Create binary present semaphores (one per slot, for WSI)
   m_present_semaphores.clear();
@@ -55,21 +65,23 @@ void SubmissionGroup::create_frame_resources(
   }
 
   // Initialize per-slot timeline tracking.
-  // Zero means "never submitted" — begin_frame() skips the wait, which is
-  // correct because drain() was called before any resize.
+  // Zero means "never submitted" — begin_frame() skips the wait. Slots that
+  // survive a destroy_frame_resources() keep their last value, so recreating
+  // without a drain still waits before reusing a slot.
   // Do NOT reset m_next_timeline_value: the timeline semaphore persists
   // across resize and its counter is already beyond earlier values.
-  m_slot_timeline_values.assign(count, 0);
-
-  // Gating: no slot has been submitted yet after create/resize
-  m_slot_submitted.assign(count, false);
+  m_slot_timeline_values.resize(count, 0);
+  m_slot_submitted.resize(count, false);
+  m_force_submit = true;
 }
 
 void SubmissionGroup::create_frame_resources_offscreen(
   vk::Extent2D extent, uint32_t count)
 {
-  m_frames = vkwave::create_frame_resources(m_device, count);
+  m_frames = vkwave::create_frame_resources(m_device, count, m_async_compute);
   m_extent = extent;
+  m_render_extent = extent;
+  create_timing_queries(count);
 
   // Binary present semaphores — still created but only signaled if m_signal_binary_present
   m_present_semaphores.clear();
@@ -80,15 +92,55 @@ void SubmissionGroup::create_frame_resources_offscreen(
       m_device, fmt::format("{}_{}_present", m_name, i)));
   }
 
-  m_slot_timeline_values.assign(count, 0);
-  m_slot_submitted.assign(count, false);
+  m_slot_timeline_values.resize(count, 0);
+  m_slot_submitted.resize(count, false);
+  m_force_submit = true;
 }
 
 void SubmissionGroup::destroy_frame_resources()
 {
-  vkwave::destroy_frame_resources(m_frames, m_device.device());
+  // Deferred: submissions in flight finish on the old command buffers (and
+  // present semaphores, whose destructors defer as well).
+  m_device.deletion_queue().push([device = m_device.device(), frames = std::move(m_frames),
+                                   query_pool = m_query_pool]() mutable {
+    vkwave::destroy_frame_resources(frames, device);
+    if (query_pool)
+      device.destroyQueryPool(query_pool);
+  });
+  m_frames.clear();
+  m_query_pool = VK_NULL_HANDLE;
   m_present_semaphores.clear();
-  m_slot_timeline_values.clear();
+}
+
+void SubmissionGroup::create_timing_queries(uint32_t count)
+{
+  if (m_query_pool)
+  {
+    m_device.device().destroyQueryPool(m_query_pool);
+    m_query_pool = VK_NULL_HANDLE;
+  }
+  if (!m_gpu_timing)
+    return;
+
+  const auto limits = m_device.physicalDevice().getProperties().limits;
+  if (!limits.timestampComputeAndGraphics)
+  {
+    spdlog::warn("SubmissionGroup '{}': device cannot time graphics work", m_name);
+    return;
+  }
+  m_timestamp_period = limits.timestampPeriod;
+
+  vk::QueryPoolCreateInfo info{};
+  info.queryType = vk::QueryType::eTimestamp;
+  info.queryCount = 2 * count;
+  m_query_pool = m_device.device().createQueryPool(info);
+}
+
+void SubmissionGroup::set_render_extent(vk::Extent2D extent)
+{
+  m_render_extent = vk::Extent2D{
+    std::clamp(extent.width, 1u, std::max(m_extent.width, 1u)),
+    std::clamp(extent.height, 1u, std::max(m_extent.height, 1u)) };
 }
 
 void SubmissionGroup::set_gating(GatingMode mode, float hz)
@@ -99,6 +151,8 @@ void SubmissionGroup::set_gating(GatingMode mode, float hz)
 
 bool SubmissionGroup::should_submit(float elapsed_time, bool is_fifo) const
 {
+  if (m_force_submit)
+    return true;
   switch (m_gating)
   {
   case GatingMode::always:
@@ -116,8 +170,23 @@ void SubmissionGroup::begin_frame(uint32_t slot_index, bool will_submit)
   // Wait until the GPU finishes the previous submission for this slot,
   // but only if we actually submitted last time on this slot.
   if (m_slot_submitted[slot_index] && m_slot_timeline_values[slot_index] > 0)
+  {
     m_timeline->wait(m_slot_timeline_values[slot_index]);
 
+    // The slot's previous submission has completed, so its timestamps are
+    // available without waiting.
+    if (m_query_pool)
+    {
+      std::array<uint64_t, 2> ticks{};
+      const auto result = m_device.device().getQueryPoolResults(m_query_pool,
+        2 * slot_index, 2, sizeof(ticks), ticks.data(), sizeof(uint64_t),
+        vk::QueryResultFlagBits::e64);
+      if (result == vk::Result::eSuccess && ticks[1] >= ticks[0])
+        m_gpu_time_ms = static_cast<float>(
+          static_cast<double>(ticks[1] - ticks[0]) * m_timestamp_period * 1e-6);
+    }
+  }
+
   m_slot_submitted[slot_index] = will_submit;
 }
 
@@ -128,6 +197,8 @@ void SubmissionGroup::submit(
   float elapsed_time)
 {
   m_last_run_time = elapsed_time;
+  m_force_submit = false;
+  m_latest_slot = slot_index;
   auto& frame = m_frames[slot_index];
 
   // Set current slot so derived class accessors work inside the record callback
@@ -139,6 +210,17 @@ void SubmissionGroup::submit(
   vk::CommandBufferBeginInfo begin_info{};
   frame.command_buffer.begin(begin_info);
 
+  if (m_query_pool)
+  {
+    frame.command_buffer.resetQueryPool(m_query_pool, 2 * slot_index, 2);
+    frame.command_buffer.writeTimestamp(
+      vk::PipelineStageFlagBits::eTopOfPipe, m_query_pool, 2 * slot_index);
+  }
+
+  // Optional pre-record work (e.g. compute culling) — outside the render pass
+  if (m_pre_record_fn)
+    m_pre_record_fn(frame.command_buffer, slot_index);
+
   // Delegate to virtual hook for pass-specific recording
   record_commands(frame.command_buffer, slot_index, frame);
 
@@ -146,6 +228,10 @@ void SubmissionGroup::submit(
   if (m_post_record_fn)
     m_post_record_fn(frame.command_buffer, slot_index);
 
+  if (m_query_pool)
+    frame.command_buffer.writeTimestamp(
+      vk::PipelineStageFlagBits::eBottomOfPipe, m_query_pool, 2 * slot_index + 1);
+
   frame.command_buffer.end();
 
   // Assign the next timeline value to this submission
@@ -166,11 +252,20 @@ void SubmissionGroup::submit(
     wait_stages.push_back(w.stage);
   }
 
-  // Signal semaphores: always timeline, conditionally binary present
+  // Signal semaphores: always timelines, conditionally binary present
   std::vector<vk::Semaphore> signal_sems;
   std::vector<uint64_t> signal_values;
   signal_sems.push_back(m_timeline->get());
   signal_values.push_back(signal_value);
+  // The device timeline orders every graphics submission for deferred
+  // destruction; an async-compute one is covered by the graphics submission
+  // that waits for it.
+  if (!on_compute_queue())
+  {
+    auto& deletion_queue = m_device.deletion_queue();
+    signal_sems.push_back(deletion_queue.timeline());
+    signal_values.push_back(deletion_queue.next_signal_value());
+  }
   if (m_signal_binary_present)
   {
     signal_sems.push_back(*m_present_semaphores[slot_index]->semaphore());
@@ -207,6 +302,11 @@ void SubmissionGroup::drain()
   m_timeline->wait(m_next_timeline_value - 1);
 }
 
+bool SubmissionGroup::on_compute_queue() const
+{
+  return m_async_compute && m_device.has_dedicated_compute_queue();
+}
+
 vk::Semaphore SubmissionGroup::timeline_semaphore() const
 {
   return m_timeline->get();
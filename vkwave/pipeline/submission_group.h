@@ -25,6 +25,13 @@ class Swapchain;
 /// indexing into ring-buffered resources.
 using RecordFn = std::function<void(vk::CommandBuffer cmd, uint32_t frame_index)>;
 
+/// Callback type for pre-record work outside the render pass.
+///
+/// Called after cmd.begin() but before record_commands(), within the same
+/// command buffer — for work that must precede the group's render pass and
+/// cannot run inside it (e.g. compute culling feeding indirect draws).
+using PreRecordFn = std::function<void(vk::CommandBuffer cmd, uint32_t frame_index)>;
+
 /// Callback type for post-record overlay (e.g. ImGui).
 ///
 /// Called after record_commands() but before cmd.end(), within the
@@ -60,8 +67,8 @@ struct SemaphoreWait
 /// Derived classes (ExecutionGroup) add their own pipeline/resource
 /// management on top. The virtual record_commands() hook lets each
 /// derived class control what goes into the command buffer.
-/// An optional post_record_fn runs after record_commands() in the
-/// same command buffer (e.g. ImGui overlay).
+/// Optional pre_record_fn / post_record_fn run before / after
+/// record_commands() in the same command buffer (e.g. culling, ImGui overlay).
 class SubmissionGroup
 {
 public:
@@ -72,6 +79,7 @@ public:
   SubmissionGroup& operator=(const SubmissionGroup&) = delete;
 
   void set_record_fn(RecordFn fn);
+  void set_pre_record_fn(PreRecordFn fn);
   void set_post_record_fn(PostRecordFn fn);
 
   /// Create/recreate size-dependent frame resources (command pools, semaphores).
@@ -81,16 +89,53 @@ public:
   /// Create frame resources for offscreen groups (no swapchain, just extent).
   void create_frame_resources_offscreen(vk::Extent2D extent, uint32_t count);
 
-  /// Destroy frame resources. Derived classes should destroy their own first,
-  /// then call this base version.
+  /// Offscreen (re)creation as the render graph calls it. The base version is
+  /// create_frame_resources_offscreen(): a group that only records compute
+  /// (RenderGraph::add_compute_group()) has nothing else to create.
+  virtual void create_frame_resources(vk::Extent2D extent, uint32_t count)
+  {
+    create_frame_resources_offscreen(extent, count);
+  }
+
+  /// Destroy frame resources without a drain: the handles go to the device
+  /// deletion queue, so submissions in flight finish on them. The per-slot
+  /// timeline values survive, so begin_frame() still waits for a slot's last
+  /// submission before reusing it. Derived classes should destroy their own
+  /// first, then call this base version.
   virtual void destroy_frame_resources();
 
+  /// Record GPU timestamps at the start and end of every command buffer and
+  /// report the elapsed time via gpu_time_ms(). Takes effect on the next
+  /// create_frame_resources(). No-op if the device cannot time graphics work.
+  void set_gpu_timing(bool enabled) { m_gpu_timing = enabled; }
+
+  /// GPU time of the most recently completed submission, in milliseconds
+  /// (0 until one completes, or without set_gpu_timing()). Read back in
+  /// begin_frame(), so it lags the CPU by the ring depth.
+  [[nodiscard]] float gpu_time_ms() const { return m_gpu_time_ms; }
+
+  /// Dynamic resolution: the top-left sub-rectangle of extent() that passes
+  /// render into (viewport/scissor). Clamped to extent(); reset to the full
+  /// extent by create_frame_resources(). Attachments are never reallocated.
+  void set_render_extent(vk::Extent2D extent);
+  [[nodiscard]] vk::Extent2D render_extent() const { return m_render_extent; }
+
   /// Configure gating mode. For wall_clock, hz is the maximum submission rate.
   void set_gating(GatingMode mode, float hz = 0.0f);
 
-  /// Returns true if this group should be submitted this frame.
+  /// Returns true if this group should be submitted this frame. Always true
+  /// for the first submission after create_frame_resources(): until then the
+  /// group's outputs hold nothing a consumer could sample.
   [[nodiscard]] bool should_submit(float elapsed_time, bool is_fifo) const;
 
+  /// Submit on the next frame regardless of gating: a setting changed what
+  /// the group's outputs should hold.
+  void request_submit() { m_force_submit = true; }
+
+  /// Slot of the most recent submission. A consumer of a gated (lower-rate)
+  /// group samples this slot, whose completion latest_signal_value() covers.
+  [[nodiscard]] uint32_t latest_slot() const { return m_latest_slot; }
+
   /// Wait on the timeline for this slot (blocks until GPU finishes previous use).
   /// @param will_submit  Whether this group will actually submit this frame.
   void begin_frame(uint32_t slot_index, bool will_submit = true);
@@ -109,6 +154,25 @@ public:
   /// Offscreen groups should set this to false (nothing consumes them).
   void set_signal_present(bool b) { m_signal_binary_present = b; }
 
+  /// Present group: the stages that touch the swapchain image, i.e. what the
+  /// image-acquire wait gates. Color-attachment output by default; add
+  /// eComputeShader when compute writes the image.
+  void set_acquire_stage(vk::PipelineStageFlags stage) { m_acquire_stage = stage; }
+  [[nodiscard]] vk::PipelineStageFlags acquire_stage() const { return m_acquire_stage; }
+
+  /// Submit on Device::compute_queue() instead of the graphics queue, so the
+  /// group overlaps graphics work on a GPU with a dedicated compute family.
+  /// Compute-only groups: the command pools come from that family, and every
+  /// pool image the group touches must be registered compute_shared. Takes
+  /// effect on the next create_frame_resources().
+  void set_async_compute(bool enabled) { m_async_compute = enabled; }
+  [[nodiscard]] bool async_compute() const { return m_async_compute; }
+
+  /// True when submit() goes to a queue family other than graphics:
+  /// async_compute() on a device with a dedicated compute queue. Such a
+  /// submission does not signal the device timeline (see RenderGraph).
+  [[nodiscard]] bool on_compute_queue() const;
+
   /// Set a fence to be signaled on the next submit() call only.
   /// The fence is automatically cleared (reset to VK_NULL_HANDLE) after submission.
   void set_next_fence(vk::Fence fence) { m_next_fence = fence; }
@@ -150,9 +214,11 @@ protected:
 
   std::vector<FrameResources> m_frames;
   vk::Extent2D m_extent{};
+  vk::Extent2D m_render_extent{};
   uint32_t m_current_slot{0};
 
   RecordFn m_record_fn;
+  PreRecordFn m_pre_record_fn;
   PostRecordFn m_post_record_fn;
 
 private:
@@ -164,10 +230,19 @@ private:
   // Binary present semaphores (one per slot, for WSI)
   std::vector<std::unique_ptr<Semaphore>> m_present_semaphores;
   bool m_signal_binary_present{ true };
+  vk::PipelineStageFlags m_acquire_stage{ vk::PipelineStageFlagBits::eColorAttachmentOutput };
+  bool m_async_compute{ false };
 
   // Optional fence for next submit (screenshot capture, etc.)
   vk::Fence m_next_fence{ VK_NULL_HANDLE };
 
+  // GPU timing: two timestamps (begin/end) per slot.
+  void create_timing_queries(uint32_t count);
+  bool m_gpu_timing{ false };
+  vk::QueryPool m_query_pool{ VK_NULL_HANDLE };
+  float m_timestamp_period{ 0.0f }; // ns per tick
+  float m_gpu_time_ms{ 0.0f };
+
   // Declared predecessors (this group waits on their timeline signals).
   std::vector<SubmissionGroup*> m_dependencies;
 
@@ -175,6 +250,8 @@ private:
   GatingMode m_gating{ GatingMode::always };
   float m_target_interval{ 0.0f };
   float m_last_run_time{ 0.0f };
+  bool m_force_submit{ true }; // no submission since the frame resources were (re)created
+  uint32_t m_latest_slot{ 0 };
   std::vector<bool> m_slot_submitted;
 };
 
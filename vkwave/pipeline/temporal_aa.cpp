@@ -0,0 +1,198 @@
+#include <vkwave/pipeline/temporal_aa.h>
+
+#include <vkwave/config.h>
+#include <vkwave/core/deletion_queue.h>
+#include <vkwave/core/device.h>
+#include <vkwave/core/format_select.h>
+#include <vkwave/core/temporal_aa.h>
+
+#include <spdlog/fmt/fmt.h>
+
+#include <array>
+#include <cassert>
+
+namespace vkwave
+{
+
+namespace
+{
+
+constexpr uint32_t kLocalSize = 8; // taa.comp: 8x8
+
+void transition_output(vk::CommandBuffer cmd, vk::Image image,
+  vk::ImageLayout old_layout, vk::ImageLayout new_layout,
+  vk::PipelineStageFlags src_stage, vk::PipelineStageFlags dst_stage,
+  vk::AccessFlags src_access, vk::AccessFlags dst_access)
+{
+  vk::ImageMemoryBarrier barrier{};
+  barrier.oldLayout = old_layout;
+  barrier.newLayout = new_layout;
+  barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.image = image;
+  barrier.subresourceRange = { vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1 };
+  barrier.srcAccessMask = src_access;
+  barrier.dstAccessMask = dst_access;
+  cmd.pipelineBarrier(src_stage, dst_stage, {}, {}, {}, barrier);
+}
+
+} // namespace
+
+TemporalAA::TemporalAA(const Device& device, vk::Format output_format, bool debug)
+  : m_device(device)
+{
+  m_resolve = std::make_unique<ComputePipeline>(device, SHADER_DIR "taa.comp", debug,
+    fmt::format("#define IMAGE_FORMAT {}\n", glsl_image_format(output_format)));
+
+  // Bilinear: the current frame is read at jittered / upscaled positions and the
+  // history at reprojected ones. Neighbourhood bounds use texelFetch.
+  vk::SamplerCreateInfo info{};
+  info.magFilter = vk::Filter::eLinear;
+  info.minFilter = vk::Filter::eLinear;
+  info.mipmapMode = vk::SamplerMipmapMode::eNearest;
+  info.addressModeU = vk::SamplerAddressMode::eClampToEdge;
+  info.addressModeV = vk::SamplerAddressMode::eClampToEdge;
+  info.addressModeW = vk::SamplerAddressMode::eClampToEdge;
+  m_sampler = device.device().createSampler(info);
+}
+
+TemporalAA::~TemporalAA()
+{
+  destroy_frame_resources();
+  if (m_sampler)
+    m_device.deletion_queue().push([dev = m_device.device(), sampler = m_sampler] {
+      dev.destroySampler(sampler);
+    });
+}
+
+void TemporalAA::create_frame_resources(const FrameResourcePool& pool,
+  FrameResourcePool::ColorHandle color, FrameResourcePool::ColorHandle velocity,
+  FrameResourcePool::ColorHandle output)
+{
+  destroy_frame_resources();
+
+  m_pool = &pool;
+  m_output = output;
+  m_slot_count = pool.slot_count();
+
+  auto dev = m_device.device();
+  auto pool_sizes = m_resolve->pool_sizes(m_slot_count);
+  vk::DescriptorPoolCreateInfo pool_info{};
+  pool_info.maxSets = m_slot_count;
+  pool_info.poolSizeCount = static_cast<uint32_t>(pool_sizes.size());
+  pool_info.pPoolSizes = pool_sizes.data();
+  m_descriptor_pool = dev.createDescriptorPool(pool_info);
+  m_sets = m_resolve->allocate_sets(m_descriptor_pool, 0, m_slot_count);
+
+  // Slot s reads its own color/velocity. The history and output bindings are
+  // written per resolve (record()).
+  for (uint32_t s = 0; s < m_slot_count; ++s)
+  {
+    std::array<vk::DescriptorImageInfo, 2> images{ {
+      { m_sampler, pool.color_view(color, s), vk::ImageLayout::eShaderReadOnlyOptimal },
+      { m_sampler, pool.color_view(velocity, s), vk::ImageLayout::eShaderReadOnlyOptimal },
+    } };
+
+    std::array<vk::WriteDescriptorSet, 2> writes{};
+    for (uint32_t b = 0; b < writes.size(); ++b)
+    {
+      writes[b].dstSet = m_sets[s];
+      writes[b].dstBinding = b;
+      writes[b].descriptorCount = 1;
+      writes[b].descriptorType = vk::DescriptorType::eCombinedImageSampler;
+      writes[b].pImageInfo = &images[b];
+    }
+    dev.updateDescriptorSets(writes, {});
+  }
+
+  m_history.resize(m_slot_count);
+}
+
+void TemporalAA::destroy_frame_resources()
+{
+  // Deferred: a resolve in flight may still use the sets.
+  if (m_descriptor_pool)
+  {
+    m_device.deletion_queue().push([dev = m_device.device(), pool = m_descriptor_pool] {
+      dev.destroyDescriptorPool(pool);
+    });
+    m_descriptor_pool = VK_NULL_HANDLE;
+  }
+  m_sets.clear();
+  m_slot_count = 0;
+  m_pool = nullptr;
+}
+
+vk::ImageView TemporalAA::output_view() const
+{
+  assert(m_pool && resolved() && "output_view() before record()");
+  return m_pool->color_view(m_output, m_history.latest());
+}
+
+void TemporalAA::record(vk::CommandBuffer cmd, uint32_t slot,
+  vk::Extent2D render_extent, const glm::vec2& jitter)
+{
+  if (slot >= m_slot_count)
+    return;
+
+  // The history is the output resolved last, however many slots ago (a gated
+  // scene resolves on some frames only). This slot's set was last used by its
+  // previous submission, which the graph waited for before reusing the slot.
+  const bool use_history = m_history.usable(slot);
+  const uint32_t written = m_history.target(slot);
+  const vk::Image output = m_pool->color_image(m_output, written);
+  const vk::Extent2D target = m_pool->extent();
+  {
+    // Without a history any view will do: the shader ignores it (feedback 1).
+    std::array<vk::DescriptorImageInfo, 2> images{ {
+      { m_sampler, m_pool->color_view(m_output, use_history ? m_history.latest() : written),
+        vk::ImageLayout::eShaderReadOnlyOptimal },
+      { VK_NULL_HANDLE, m_pool->color_view(m_output, written), vk::ImageLayout::eGeneral },
+    } };
+    std::array<vk::WriteDescriptorSet, 2> writes{};
+    for (uint32_t i = 0; i < writes.size(); ++i)
+    {
+      writes[i].dstSet = m_sets[slot];
+      writes[i].dstBinding = 2 + i;
+      writes[i].descriptorCount = 1;
+      writes[i].descriptorType = vk::DescriptorType::eCombinedImageSampler;
+      writes[i].pImageInfo = &images[i];
+    }
+    writes[1].descriptorType = vk::DescriptorType::eStorageImage;
+    m_device.device().updateDescriptorSets(writes, {});
+  }
+
+  // Discard the old output. Its last readers: the composites that presented
+  // it and the resolve that took it as history — all earlier submissions.
+  transition_output(cmd, output,
+    vk::ImageLayout::eUndefined, vk::ImageLayout::eGeneral,
+    vk::PipelineStageFlagBits::eComputeShader | vk::PipelineStageFlagBits::eFragmentShader,
+    vk::PipelineStageFlagBits::eComputeShader,
+    {}, vk::AccessFlagBits::eShaderWrite);
+
+  TaaPushConstants pc{};
+  pc.renderScale = glm::vec4(
+    static_cast<float>(render_extent.width) / static_cast<float>(target.width),
+    static_cast<float>(render_extent.height) / static_cast<float>(target.height),
+    1.0f / static_cast<float>(target.width), 1.0f / static_cast<float>(target.height));
+  pc.jitter = jitter;
+  pc.feedback = use_history ? m_feedback : 1.0f;
+
+  m_resolve->bind(cmd);
+  m_resolve->bind_descriptor_set(cmd, 0, m_sets[slot]);
+  m_resolve->push_constants(cmd, &pc, sizeof(pc));
+  cmd.dispatch(ComputePipeline::group_count(target.width, kLocalSize),
+    ComputePipeline::group_count(target.height, kLocalSize), 1);
+
+  // Output -> sampled by composite now and by the next resolve (the history
+  // read is made visible by this same barrier: same queue, later submission).
+  transition_output(cmd, output,
+    vk::ImageLayout::eGeneral, vk::ImageLayout::eShaderReadOnlyOptimal,
+    vk::PipelineStageFlagBits::eComputeShader,
+    vk::PipelineStageFlagBits::eFragmentShader | vk::PipelineStageFlagBits::eComputeShader,
+    vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead);
+
+  m_history.written(written);
+}
+
+} // namespace vkwave
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <vkwave/core/temporal_history.h>
+#include <vkwave/pipeline/compute_pipeline.h>
+#include <vkwave/pipeline/frame_resource_pool.h>
+
+#include <glm/glm.hpp>
+#include <vulkan/vulkan.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace vkwave
+{
+
+class Device;
+
+/// Temporal anti-aliasing: resolves a jittered HDR frame against the previous
+/// frame's output, reprojected by per-pixel motion vectors.
+///
+/// All images are graph-owned pool resources of one slot each:
+///
+///   color    (sampled)  the scene's HDR, drawn with Camera jitter
+///   velocity (sampled)  screen-space motion from pbr.frag (location 1)
+///   output   (storage)  the resolved HDR; the output resolved last is this
+///                       frame's history, so no separate history copy exists
+///
+/// The output is always target-sized while color/velocity may be rendered into
+/// a smaller top-left sub-rectangle (dynamic resolution) — the resolve is also
+/// the upscaler. Resolves may skip slots (a gated scene): the history is bound
+/// per resolve (TemporalHistory). reset_history() (camera cut, resize) drops
+/// the accumulation.
+class TemporalAA
+{
+public:
+  /// `output_format` is the output's storage format (compiled into the shader).
+  TemporalAA(const Device& device, vk::Format output_format, bool debug);
+  ~TemporalAA();
+
+  TemporalAA(const TemporalAA&) = delete;
+  TemporalAA& operator=(const TemporalAA&) = delete;
+
+  /// (Re)create the per-slot descriptor sets for the pool's current resources.
+  /// The previous ones must have been destroyed (deferred past frames in flight).
+  void create_frame_resources(const FrameResourcePool& pool,
+                              FrameResourcePool::ColorHandle color,
+                              FrameResourcePool::ColorHandle velocity,
+                              FrameResourcePool::ColorHandle output);
+
+  void destroy_frame_resources();
+
+  /// Drop the history: the next resolve outputs the current frame unblended.
+  void reset_history() { m_history.reset(); }
+
+  /// Resolve `slot`. Record outside any render pass, after the scene pass left
+  /// color and velocity in eShaderReadOnlyOptimal. `render_extent` is the part
+  /// of them drawn this frame and `jitter` the projection offset it used. The
+  /// output is left in eShaderReadOnlyOptimal for the composite pass.
+  void record(vk::CommandBuffer cmd, uint32_t slot, vk::Extent2D render_extent,
+              const glm::vec2& jitter);
+
+  /// The output resolved last (valid when resolved()). Frames without a
+  /// resolve (a gated scene) keep presenting it.
+  [[nodiscard]] vk::ImageView output_view() const;
+  [[nodiscard]] bool resolved() const { return m_history.written_any(); }
+
+  /// Weight of the current frame in the blend (0.05 - 0.2 is typical: lower
+  /// is smoother but slower to converge).
+  void set_feedback(float feedback) { m_feedback = feedback; }
+  [[nodiscard]] float feedback() const { return m_feedback; }
+
+  [[nodiscard]] bool ready() const { return m_slot_count > 0; }
+
+private:
+  const Device& m_device;
+
+  std::unique_ptr<ComputePipeline> m_resolve;
+  vk::Sampler m_sampler{ VK_NULL_HANDLE };
+
+  const FrameResourcePool* m_pool{ nullptr };
+  FrameResourcePool::ColorHandle m_output{ 0 };
+  uint32_t m_slot_count{ 0 };
+
+  vk::DescriptorPool m_descriptor_pool{ VK_NULL_HANDLE };
+  std::vector<vk::DescriptorSet> m_sets; // [slot]
+
+  float m_feedback{ 0.1f };
+  // The output resolved last is the next resolve's history.
+  TemporalHistory m_history;
+};
+
+} // namespace vkwave
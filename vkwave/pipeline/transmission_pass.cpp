@@ -43,14 +43,17 @@ void TransmissionPass::record(vk::CommandBuffer cmd) const
   // Update this group's own per-frame UBO (separate from the pbr group's).
   PbrUBO ubo_data{};
   ubo_data.viewProj = ctx->view_projection;
+  ubo_data.unjitteredViewProj = ctx->unjittered_view_projection;
+  ubo_data.prevViewProj = ctx->prev_view_projection;
   ubo_data.camPos = glm::vec4(ctx->cam_position, 0.0f);
   ubo_data.lightDirection = glm::vec4(glm::normalize(ctx->light_direction), ctx->light_intensity);
   ubo_data.lightColor = glm::vec4(ctx->light_color, 0.0f);
+  auto extent = group->render_extent();
+  ubo_data.viewport = render_viewport_params(group->extent(), extent);
   group->ubo(0, 0).update(&ubo_data, sizeof(ubo_data));
 
   auto pipeline = group->pipeline();
   auto layout = group->layout();
-  auto extent = group->extent();
 
   cmd.bindPipeline(vk::PipelineBindPoint::eGraphics, pipeline);
 
@@ -9,6 +9,7 @@ layout(set = 0, binding = 0) uniform sampler2D hdrImage;
 layout(push_constant) uniform PushConstants {
     float exposure;
     int tonemapMode;
+    vec2 uvScale;      // rendered fraction of hdrImage (dynamic resolution)
 } pc;
 
 const float GAMMA = 2.2;
@@ -23,7 +24,11 @@ vec3 linearToSRGB(vec3 color)
 
 void main()
 {
-    vec3 color = texture(hdrImage, fragUV).rgb;
+    // Bilinear upscale of the rendered region, kept half a texel inside it so
+    // filtering never reads the unrendered border.
+    vec2 halfTexel = 0.5 / vec2(textureSize(hdrImage, 0));
+    vec2 uv = min(fragUV * pc.uvScale, pc.uvScale - halfTexel);
+    vec3 color = texture(hdrImage, uv).rgb;
 
     // Apply exposure
     color *= pc.exposure;
@@ -1,4 +1,8 @@
 #version 450
+#extension GL_EXT_multiview : require
+#ifdef RAY_QUERY
+#extension GL_EXT_ray_query : require
+#endif
 
 // PBR fragment shader — Cook-Torrance BRDF with IBL
 // Adapted from Vulkanstein3D's fragment.frag (iridescence, SSS, alpha modes stripped).
@@ -14,8 +18,44 @@ layout(set = 0, binding = 0) uniform PbrUBO {
   vec4 camPos;
   vec4 lightDirection;  // xyz=direction, w=intensity
   vec4 lightColor;      // rgb=color, a=unused
+  mat4 view;            // world -> view (cluster slice depth)
+  vec4 clusterDepth;    // x=slice scale, y=slice bias, zw=tile size in pixels
+  uvec4 clusterGrid;    // xyz=cluster counts, w=light count (0 = no local lights)
+  mat4 shadowMatrices[4]; // world -> cascade clip space (depth 0..1)
+  vec4 shadowSplits;    // far view depth of each cascade
+  vec4 shadowTexelSize; // world units per shadow texel, per cascade
+  vec4 shadowParams;    // x=enabled, y=normal offset (texels), z=PCF radius (texels), w=1/resolution
+  vec4 viewport;        // xy = render / target extent, zw = 1 / target extent
+  mat4 unjitteredViewProj; // viewProj without the TAA sub-pixel jitter
+  mat4 prevViewProj;       // last frame's unjittered viewProj (motion vectors)
+  uvec4 views;             // x = multiview view count (0 = the single camera above)
+  mat4 viewProjs[6];       // per-view viewProj, indexed by gl_ViewIndex
+  vec4 viewCamPos[6];      // per-view camera position
+  vec4 rayTracing;         // x = tan(sun half-angle), y = reflection roughness cutoff, z = max ray distance, w = frame
 } ubo;
 
+// Set 0, bindings 1-3: clustered punctual lights (per slot, see cluster_lights.comp).
+// Layout must match vkwave::GpuLight (std430).
+struct GpuLight {
+  vec4 position;    // xyz=world position, w=range
+  vec4 color;       // rgb=color, w=intensity
+  vec4 direction;   // xyz=spot direction, w=type (1 point, 2 spot)
+  vec4 attenuation; // x=constant, y=linear, z=quadratic
+  vec4 cone;        // x=cos(inner), y=cos(outer)
+};
+layout(set = 0, binding = 1, std430) readonly buffer LightBuffer {
+  GpuLight lights[];
+} lightbuf;
+layout(set = 0, binding = 2, std430) readonly buffer ClusterGrid {
+  uvec2 clusters[];  // x=first index into lightIndices, y=count
+} clustergrid;
+layout(set = 0, binding = 3, std430) readonly buffer LightIndexBuffer {
+  uint lightIndices[];
+} lightindex;
+// Screen-space AO of the previous frame (ao_resolve.comp: x = visibility,
+// y = view depth); read only with flags bit 7.
+layout(set = 0, binding = 4) uniform sampler2D ambientOcclusion;
+
 // Set 1: Per-material textures (bound once per material change)
 layout(set = 1, binding = 0) uniform sampler2D baseColorTexture;
 layout(set = 1, binding = 1) uniform sampler2D normalTexture;
@@ -31,6 +71,13 @@ layout(set = 1, binding = 8) uniform sampler2D anisotropyTexture;         // RG=
 layout(set = 2, binding = 0) uniform sampler2D brdfLUT;
 layout(set = 2, binding = 1) uniform samplerCube irradianceMap;
 layout(set = 2, binding = 2) uniform samplerCube prefilterMap;
+// Directional-light cascades, one layer each (comparison sampler: hardware PCF).
+layout(set = 2, binding = 4) uniform sampler2DArrayShadow shadowMap;
+#ifdef RAY_QUERY
+// The scene's TLAS. Only declared when compiled with RAY_QUERY (the device has
+// VK_KHR_ray_query); the raster path never references it.
+layout(set = 2, binding = 5) uniform accelerationStructureEXT sceneTLAS;
+#endif
 
 // Per-material constants — single immutable SSBO shared across all frames
 // (material data never changes after load). Indexed by pc.materialIndex.
@@ -85,8 +132,14 @@ layout(location = 2) in vec3 fragPos;
 layout(location = 3) in vec2 fragTexCoord;
 layout(location = 4) in mat3 fragTBN;
 layout(location = 7) in vec2 fragTexCoord1;
+layout(location = 8) in vec4 fragCurClip;
+layout(location = 9) in vec4 fragPrevClip;
 
 layout(location = 0) out vec4 outColor;
+// Screen-space motion (current - previous, in UV units) for temporal AA. Only
+// bound in the single-sample scene pass; alpha 1 so blended draws overwrite it.
+// The OIT pass binds its revealage target here instead (see writeColor).
+layout(location = 1) out vec4 outVelocity;
 
 const float PI = 3.14159265359;
 
@@ -219,10 +272,281 @@ vec3 getIBLGGXFresnel(vec3 N, vec3 V, float roughness, vec3 F0, float specularWe
   return FssEss + FmsEms;
 }
 
+// ============================================================================
+// Direct lighting
+// ============================================================================
+
+// Everything the direct lobes need about the shaded point, so the directional
+// light and every clustered light share one evaluation.
+struct Surface {
+  vec3 N;
+  vec3 V;
+  vec3 albedo;
+  vec3 F0;
+  float metallic;
+  float alphaRoughness;
+  bool anisotropic;
+  vec3 aniT;        // anisotropy tangent/bitangent and split roughness
+  vec3 aniB;
+  float at;
+  float ab;
+  bool clearcoat;
+  vec3 ccN;
+  float ccAlpha;
+};
+
+// Add one light's contribution: base BRDF into Lo, clear-coat specular into ccLo.
+// `radiance` already includes distance/cone attenuation.
+void addLight(Surface s, vec3 L, vec3 radiance, inout vec3 Lo, inout vec3 ccLo)
+{
+  vec3 H = normalize(s.V + L);
+  float NdotL = clamp(dot(s.N, L), 0.0, 1.0);
+  float NdotV = clamp(dot(s.N, s.V), 0.0, 1.0);
+  float NdotH = clamp(dot(s.N, H), 0.0, 1.0);
+  float VdotH = clamp(dot(s.V, H), 0.0, 1.0);
+
+  vec3 F = F_Schlick(s.F0, vec3(1.0), VdotH);
+
+  float specularBRDF;
+  if (s.anisotropic)
+  {
+    specularBRDF = D_GGX_anisotropic(NdotH, dot(s.aniT, H), dot(s.aniB, H), s.at, s.ab)
+                 * V_GGX_anisotropic(NdotL, NdotV, dot(s.aniT, s.V), dot(s.aniB, s.V),
+                                     dot(s.aniT, L), dot(s.aniB, L), s.at, s.ab);
+  }
+  else
+  {
+    specularBRDF = BRDF_specularGGX(s.alphaRoughness, NdotL, NdotV, NdotH);
+  }
+
+  // Metallic workflow: metals = specular only, dielectrics = diffuse + specular
+  vec3 diffuseBRDF = BRDF_lambertian(s.albedo);
+  vec3 dielectric_brdf = mix(diffuseBRDF, vec3(specularBRDF), F);
+  vec3 metal_brdf = F * specularBRDF;
+  vec3 brdf = mix(dielectric_brdf, metal_brdf, s.metallic);
+  Lo += brdf * radiance * NdotL;
+
+  if (s.clearcoat)
+  {
+    float ccNdotL = clamp(dot(s.ccN, L), 0.0, 1.0);
+    float ccNdotV = clamp(dot(s.ccN, s.V), 0.0, 1.0);
+    float ccNdotH = clamp(dot(s.ccN, H), 0.0, 1.0);
+    float ccSpec = BRDF_specularGGX(s.ccAlpha, ccNdotL, ccNdotV, ccNdotH);
+    ccLo += vec3(ccSpec) * F_Schlick(vec3(0.04), vec3(1.0), VdotH) * radiance * ccNdotL;
+  }
+}
+
+// Radiance reaching `pos` from a clustered point/spot light and its direction L.
+// Distance falloff is the light's 1/(c + l*d + q*d^2), windowed to reach zero
+// at its range so the cluster culling never cuts off visible light.
+vec3 localLightRadiance(GpuLight light, vec3 pos, out vec3 L)
+{
+  vec3 toLight = light.position.xyz - pos;
+  float d = length(toLight);
+  L = toLight / max(d, 1e-4);
+
+  float range = light.position.w;
+  float window = clamp(1.0 - pow(d / max(range, 1e-4), 4.0), 0.0, 1.0);
+  window *= window;
+  float falloff = 1.0 / max(light.attenuation.x + light.attenuation.y * d
+                            + light.attenuation.z * d * d, 1e-4);
+
+  float cone = 1.0;
+  if (light.direction.w > 1.5)
+  {
+    float cd = dot(-L, normalize(light.direction.xyz));
+    cone = smoothstep(light.cone.y, light.cone.x, cd);
+  }
+  return light.color.rgb * light.color.w * falloff * window * cone;
+}
+
+// Index of the froxel containing this fragment (must match cluster_lights.comp).
+uint clusterIndex(vec3 worldPos)
+{
+  float viewDepth = max(-(ubo.view * vec4(worldPos, 1.0)).z, 1e-4);
+  int slice = int(floor(log(viewDepth) * ubo.clusterDepth.x - ubo.clusterDepth.y));
+  uvec3 c = uvec3(
+    min(uint(gl_FragCoord.x / ubo.clusterDepth.z), ubo.clusterGrid.x - 1u),
+    min(uint(gl_FragCoord.y / ubo.clusterDepth.w), ubo.clusterGrid.y - 1u),
+    uint(clamp(slice, 0, int(ubo.clusterGrid.z) - 1)));
+  return c.x + ubo.clusterGrid.x * (c.y + ubo.clusterGrid.y * c.z);
+}
+
+// Directional-shadow cascade containing this fragment by view depth; 4 when it
+// is past the last split (unshadowed).
+int shadowCascadeIndex(vec3 worldPos)
+{
+  float viewDepth = -(ubo.view * vec4(worldPos, 1.0)).z;
+  int cascade = 0;
+  while (cascade < 4 && viewDepth > ubo.shadowSplits[cascade])
+    ++cascade;
+  return cascade;
+}
+
+// Visibility of the directional light (1 = lit). The receiver is pushed along
+// its geometric normal by a few cascade texels (slope acne), then filtered
+// with a (2r+1)^2 grid of hardware-PCF taps.
+float directionalShadow(vec3 worldPos, vec3 N)
+{
+  if (ubo.shadowParams.x == 0.0)
+    return 1.0;
+
+  int cascade = shadowCascadeIndex(worldPos);
+  if (cascade >= 4)
+    return 1.0;
+
+  vec3 offsetPos = worldPos + N * (ubo.shadowTexelSize[cascade] * ubo.shadowParams.y);
+  vec4 clip = ubo.shadowMatrices[cascade] * vec4(offsetPos, 1.0);
+  vec3 coord = clip.xyz / clip.w;
+  if (coord.z >= 1.0)
+    return 1.0;
+  vec2 uv = coord.xy * 0.5 + 0.5;
+
+  int radius = int(ubo.shadowParams.z + 0.5);
+  float sum = 0.0;
+  for (int y = -radius; y <= radius; ++y)
+  {
+    for (int x = -radius; x <= radius; ++x)
+    {
+      vec2 tap = uv + vec2(x, y) * ubo.shadowParams.w;
+      sum += texture(shadowMap, vec4(tap, float(cascade), coord.z));
+    }
+  }
+  float taps = float(2 * radius + 1);
+  return sum / (taps * taps);
+}
+
 // ============================================================================
 // Main
 // ============================================================================
 
+// Fragment output: the shaded colour with straight alpha, composited by the
+// blend state. With the WeightedOit flag (the OIT pass, additive blending) it
+// is weighted-blended OIT instead (McGuire & Bavoil 2013): location 0 sums the
+// depth-weighted premultiplied colour and location 1 the revealage as
+// -log(1 - alpha), so the draw order does not matter. oit_resolve.comp
+// composites both over the opaque HDR.
+void writeColor(vec3 color, float alpha)
+{
+  if ((pc.globalFlags & 64u) == 0u) {
+    outColor = vec4(color, alpha);
+    return;
+  }
+  // Eq. (9) of the paper on view depth, capped at 3e2 (not 3e3) so bright HDR
+  // layers stay inside the fp16 accumulator.
+  float z = -(ubo.view * vec4(fragPos, 1.0)).z;
+  float w = alpha * clamp(10.0 / (1e-5 + pow(z / 5.0, 2.0) + pow(z / 200.0, 6.0)), 1e-2, 3e2);
+  outColor = vec4(color * alpha, alpha) * w;
+  outVelocity = vec4(-log(1.0 - min(alpha, 0.999)));
+}
+
+// Screen-space ambient occlusion (flags bit 7). The AO is computed from this
+// frame's depth after the opaque draws, so shading uses the previous frame's:
+// reprojected to where this surface was then, and rejected (unoccluded) where
+// its depth there belongs to another surface.
+float screenSpaceAO()
+{
+  vec2 uv = fragPrevClip.xy / fragPrevClip.w * 0.5 + 0.5;
+  if (any(lessThan(uv, vec2(0.0))) || any(greaterThan(uv, vec2(1.0))))
+    return 1.0;
+  vec2 s = texture(ambientOcclusion, uv).rg;
+  float z = -(ubo.view * vec4(fragPos, 1.0)).z;
+  return abs(s.y - z) < 0.1 * z ? s.x : 1.0;
+}
+
+// ============================================================================
+// Ray queries (RAY_QUERY builds only)
+// ============================================================================
+
+// Instance mask bit of the geometry that blocks light (opaque and masked
+// primitives; blended and transmissive ones are left out). Matches
+// ScenePipeline::update_ray_tracing().
+const uint RAY_MASK_OCCLUDER = 0x01u;
+// Approximate albedo of whatever a reflection ray hits (its material is not
+// reachable from a ray query without the vertex data).
+const float OCCLUDER_ALBEDO = 0.5;
+
+// Jimenez 2014, animated with ubo.rayTracing.w so TAA averages the jitter.
+float interleavedGradientNoise(vec2 p)
+{
+  p += 5.588238 * mod(ubo.rayTracing.w, 64.0);
+  return fract(52.9829189 * fract(dot(p, vec2(0.06711056, 0.00583715))));
+}
+
+// A direction inside the cone of tangent `tanAngle` around the unit `axis`:
+// one jittered sample per pixel and frame, uniform over the cone's disc.
+vec3 jitterInCone(vec3 axis, float tanAngle)
+{
+  if (tanAngle <= 0.0)
+    return axis;
+  float u = interleavedGradientNoise(gl_FragCoord.xy);
+  float v = fract(u + 0.61803398875);
+  float r = tanAngle * sqrt(u);
+  float phi = 2.0 * PI * v;
+  vec3 t = normalize(abs(axis.y) < 0.99 ? cross(axis, vec3(0.0, 1.0, 0.0))
+                                        : cross(axis, vec3(1.0, 0.0, 0.0)));
+  vec3 b = cross(axis, t);
+  return normalize(axis + r * (cos(phi) * t + sin(phi) * b));
+}
+
+#ifdef RAY_QUERY
+// Distance to the first occluder along `dir`, or -1 if the ray escapes.
+// Everything in the TLAS is opaque to these rays; the origin is pushed off the
+// surface along its geometric normal so it does not hit itself.
+float traceOcclusion(vec3 origin, vec3 geomN, vec3 dir, float tMax)
+{
+  float bias = 1e-3 * max(1.0, length(origin - ubo.camPos.xyz));
+  origin += geomN * (dot(geomN, dir) >= 0.0 ? bias : -bias);
+
+  rayQueryEXT rq;
+  rayQueryInitializeEXT(rq, sceneTLAS,
+    gl_RayFlagsOpaqueEXT | gl_RayFlagsTerminateOnFirstHitEXT,
+    RAY_MASK_OCCLUDER, origin, 0.0, dir, tMax);
+  while (rayQueryProceedEXT(rq)) {}
+  if (rayQueryGetIntersectionTypeEXT(rq, true) == gl_RayQueryCommittedIntersectionNoneEXT)
+    return -1.0;
+  return rayQueryGetIntersectionTEXT(rq, true);
+}
+#endif
+
+// Directional-light visibility by ray query (flags bit 8): one ray toward the
+// sun, jittered across its disc for soft shadows (ubo.rayTracing.x = 0 is hard).
+float rayTracedShadow(vec3 worldPos, vec3 geomN, vec3 L)
+{
+#ifdef RAY_QUERY
+  vec3 dir = jitterInCone(L, ubo.rayTracing.x);
+  return traceOcclusion(worldPos, geomN, dir, ubo.rayTracing.z) < 0.0 ? 1.0 : 0.0;
+#else
+  return 1.0;
+#endif
+}
+
+// Specular reflection by ray query (flags bit 9), for surfaces smoother than
+// ubo.rayTracing.y: where the (roughness-jittered) mirror ray hits scene
+// geometry, the prefiltered environment it would have returned is replaced by
+// the occluder's diffuse response to the environment. Fades out toward the
+// cutoff, so rough surfaces keep the plain IBL.
+vec3 rayTracedReflection(vec3 specularIBL, vec3 worldPos, vec3 geomN, vec3 N, vec3 V,
+                         float perceptualRoughness)
+{
+#ifdef RAY_QUERY
+  float cutoff = ubo.rayTracing.y;
+  float weight = 1.0 - smoothstep(0.75 * cutoff, cutoff, perceptualRoughness);
+  if (weight <= 0.0)
+    return specularIBL;
+  vec3 R = jitterInCone(reflect(-V, N), perceptualRoughness * perceptualRoughness);
+  if (dot(R, geomN) <= 0.0)
+    return specularIBL;
+  float t = traceOcclusion(worldPos, geomN, R, ubo.rayTracing.z);
+  if (t < 0.0)
+    return specularIBL;
+  vec3 occluder = getIBLDiffuseLight(-R) * OCCLUDER_ALBEDO;
+  return mix(specularIBL, occluder, weight);
+#else
+  return specularIBL;
+#endif
+}
+
 // TODO: Consider adding the Disney diffuse
 //       Kulla17 energy conservation
 //       4.8.8.2 dielectrics
@@ -279,6 +603,9 @@ void main()
   if (alphaMode == 0u) alpha = 1.0;                       // opaque
   if (alphaMode == 1u && alpha < alphaCutoff) discard;  // mask
 
+  outVelocity = vec4((fragCurClip.xy / fragCurClip.w - fragPrevClip.xy / fragPrevClip.w) * 0.5,
+                     0.0, 1.0);
+
   // ---- Debug early-outs (skip BRDF/IBL when only visualizing a channel) ----
 
   if (pc.debugMode == 1) {
@@ -291,7 +618,7 @@ void main()
     } else {
       N = normalize(fragNormal);
     }
-    outColor = vec4(N * 0.5 + 0.5, alpha);
+    writeColor(N * 0.5 + 0.5, alpha);
     return;
   }
 
@@ -300,42 +627,52 @@ void main()
     if (texColor.r > 0.99 && texColor.g > 0.99 && texColor.b > 0.99 &&
         baseColorFactor.r > 0.99 && baseColorFactor.g > 0.99 && baseColorFactor.b > 0.99)
       albedo = fragColor;
-    outColor = vec4(albedo, alpha);
+    writeColor(albedo, alpha);
     return;
   }
 
   if (pc.debugMode == 3) {
     float metallic = clamp(texture(metallicRoughnessTexture, uvMR, pc.mipBias).b * metallicFactor, 0.0, 1.0);
-    outColor = vec4(vec3(metallic), alpha);
+    writeColor(vec3(metallic), alpha);
     return;
   }
 
   if (pc.debugMode == 4) {
     float roughness = clamp(texture(metallicRoughnessTexture, uvMR, pc.mipBias).g * roughnessFactor, 0.0, 1.0);
-    outColor = vec4(vec3(roughness), alpha);
+    writeColor(vec3(roughness), alpha);
     return;
   }
 
   if (pc.debugMode == 5) {
-    outColor = vec4(vec3(texture(aoTexture, uvAO, pc.mipBias).r), alpha);
+    writeColor(vec3(texture(aoTexture, uvAO, pc.mipBias).r), alpha);
     return;
   }
 
   if (pc.debugMode == 6) {
-    outColor = vec4(texture(emissiveTexture, uvEmis, pc.mipBias).rgb, alpha);
+    writeColor(texture(emissiveTexture, uvEmis, pc.mipBias).rgb, alpha);
     return;
   }
 
   if (pc.debugMode == 7) {
     float cc = clearcoatFactor * texture(clearcoatTexture, uvCC, pc.mipBias).r;
-    outColor = vec4(vec3(cc), alpha);
+    writeColor(vec3(cc), alpha);
     return;
   }
 
   if (pc.debugMode == 8) {
     float a = anisotropyStrength;
     if ((flags & 32u) != 0u) a *= texture(anisotropyTexture, uvAni, pc.mipBias).b;
-    outColor = vec4(vec3(a), alpha);
+    writeColor(vec3(a), alpha);
+    return;
+  }
+
+  if (pc.debugMode == 9) {
+    // Shadow cascades: tint per cascade (white = past the last split), darkened
+    // where the directional light is shadowed.
+    const vec3 tint[5] = vec3[](vec3(1.0, 0.3, 0.3), vec3(0.3, 1.0, 0.3),
+                                vec3(0.3, 0.3, 1.0), vec3(1.0, 1.0, 0.3), vec3(1.0));
+    float lit = directionalShadow(fragPos, normalize(fragNormal));
+    writeColor(tint[shadowCascadeIndex(fragPos)] * (0.25 + 0.75 * lit), alpha);
     return;
   }
 
@@ -366,35 +703,36 @@ void main()
 
   // AO (R channel)
   float ao = texture(aoTexture, uvAO, pc.mipBias).r;
+  // Screen-space AO (flags bit 7) occludes the indirect light only.
+  float ssao = (flags & 128u) != 0u ? screenSpaceAO() : 1.0;
 
   // Alpha roughness (squared per glTF spec)
   float alphaRoughness = perceptualRoughness * perceptualRoughness;
 
   // View direction
-  vec3 V = normalize(ubo.camPos.xyz - fragPos);
-
-  // Directional light
-  vec3 L = normalize(ubo.lightDirection.xyz);
-  float lightIntensity = ubo.lightDirection.w;
-  vec3 H = normalize(V + L);
-  vec3 radiance = ubo.lightColor.rgb * lightIntensity;
+  vec3 camPos = ubo.views.x > 0u ? ubo.viewCamPos[gl_ViewIndex].xyz : ubo.camPos.xyz;
+  vec3 V = normalize(camPos - fragPos);
 
   // F0: dielectrics ~0.04, metals use albedo
   vec3 f0_dielectric = vec3(0.04);
   vec3 F0 = mix(f0_dielectric, albedo, metallic);
   vec3 F90 = vec3(1.0);
 
-  // Dot products
-  float NdotL = clamp(dot(N, L), 0.0, 1.0);
-  float NdotV = clamp(dot(N, V), 0.0, 1.0);
-  float NdotH = clamp(dot(N, H), 0.0, 1.0);
-  float VdotH = clamp(dot(V, H), 0.0, 1.0);
-
-  // Fresnel
-  vec3 F = F_Schlick(F0, F90, VdotH);
-
-  // Specular BRDF + specular IBL — isotropic by default, anisotropic when enabled.
-  float specularBRDF;
+  Surface surf;
+  surf.N = N;
+  surf.V = V;
+  surf.albedo = albedo;
+  surf.F0 = F0;
+  surf.metallic = metallic;
+  surf.alphaRoughness = alphaRoughness;
+  surf.anisotropic = false;
+  surf.aniT = vec3(0.0);
+  surf.aniB = vec3(0.0);
+  surf.at = alphaRoughness;
+  surf.ab = alphaRoughness;
+
+  // Specular IBL — isotropic by default, anisotropic when enabled (the direct
+  // lobes follow via surf.anisotropic).
   vec3 f_specular_ibl;
   if ((flags & 16u) != 0u && anisotropyStrength > 0.0)
   {
@@ -408,37 +746,73 @@ void main()
       direction = mat2(dirBase.x, dirBase.y, -dirBase.y, dirBase.x) * normalize(direction);
       anisotropy *= aTex.b;
     }
-    vec3 aniT = normalize(fragTBN * vec3(direction, 0.0));
-    vec3 aniB = normalize(cross(N, aniT));
+    surf.anisotropic = true;
+    surf.aniT = normalize(fragTBN * vec3(direction, 0.0));
+    surf.aniB = normalize(cross(N, surf.aniT));
 
     // Split roughness: stretch along the tangent (at), keep base along bitangent (ab)
-    float at = mix(alphaRoughness, 1.0, anisotropy * anisotropy);
-    float ab = alphaRoughness;
+    surf.at = mix(alphaRoughness, 1.0, anisotropy * anisotropy);
+    surf.ab = alphaRoughness;
 
-    float TdotH = dot(aniT, H), BdotH = dot(aniB, H);
-    float TdotV = dot(aniT, V), BdotV = dot(aniB, V);
-    float TdotL = dot(aniT, L), BdotL = dot(aniB, L);
-
-    specularBRDF = D_GGX_anisotropic(NdotH, TdotH, BdotH, at, ab)
-                 * V_GGX_anisotropic(NdotL, NdotV, TdotV, BdotV, TdotL, BdotL, at, ab);
-    f_specular_ibl = getIBLRadianceAnisotropy(N, V, aniB, anisotropy, perceptualRoughness);
+    f_specular_ibl = getIBLRadianceAnisotropy(N, V, surf.aniB, anisotropy, perceptualRoughness);
   }
   else
   {
-    specularBRDF = BRDF_specularGGX(alphaRoughness, NdotL, NdotV, NdotH);
     f_specular_ibl = getIBLRadianceGGX(N, V, perceptualRoughness);
   }
+  // Ray-traced reflections (flags bit 9) occlude the environment where the
+  // scene is in the way.
+  if ((flags & 512u) != 0u)
+    f_specular_ibl = rayTracedReflection(f_specular_ibl, fragPos, normalize(fragNormal), N, V,
+                                         perceptualRoughness);
+
+  // Clear coat (KHR_materials_clearcoat, flags bit 2) parameters — its direct
+  // lobe is accumulated per light alongside the base, the layering happens below.
+  float cc = 0.0;
+  float ccPerceptualRough = 0.0;
+  surf.clearcoat = (flags & 4u) != 0u && clearcoatFactor > 0.0;
+  surf.ccN = N;
+  surf.ccAlpha = 0.0;
+  if (surf.clearcoat)
+  {
+    cc = clearcoatFactor * texture(clearcoatTexture, uvCC, pc.mipBias).r;
+    ccPerceptualRough = clamp(
+      clearcoatRoughnessFactor * texture(clearcoatRoughnessTexture, uvCCR, pc.mipBias).g,
+      0.0, 1.0);
+    surf.ccAlpha = ccPerceptualRough * ccPerceptualRough;
 
-  // Diffuse BRDF
-  vec3 diffuseBRDF = BRDF_lambertian(albedo);
-
-  // Metallic workflow: metals = specular only, dielectrics = diffuse + specular
-  vec3 dielectric_brdf = mix(diffuseBRDF, vec3(specularBRDF), F);
-  vec3 metal_brdf = F * specularBRDF;
-  vec3 brdf = mix(dielectric_brdf, metal_brdf, metallic);
+    // Coat normal: dedicated map if present (flags bit 3), else the geometric
+    // normal — the smooth coat does NOT inherit the base material's normal map.
+    if ((flags & 8u) != 0u) {
+      vec3 nm = texture(clearcoatNormalTexture, uvCCN, pc.mipBias).rgb * 2.0 - 1.0;
+      surf.ccN = normalize(fragTBN * nm);
+    } else {
+      surf.ccN = normalize(fragNormal);
+    }
+  }
 
-  // Direct lighting
-  vec3 Lo = brdf * radiance * NdotL;
+  // Direct lighting: the (shadowed) directional light, then the clustered
+  // point/spot lights of this fragment's froxel.
+  vec3 Lo = vec3(0.0);
+  vec3 ccLo = vec3(0.0);
+  // Ray-traced shadows (flags bit 8) replace the cascades.
+  vec3 sunL = normalize(ubo.lightDirection.xyz);
+  float shadow = (flags & 256u) != 0u ? rayTracedShadow(fragPos, normalize(fragNormal), sunL)
+                                      : directionalShadow(fragPos, normalize(fragNormal));
+  addLight(surf, sunL,
+           ubo.lightColor.rgb * ubo.lightDirection.w * shadow, Lo, ccLo);
+
+  if (ubo.clusterGrid.w > 0u)
+  {
+    uvec2 range = clustergrid.clusters[clusterIndex(fragPos)];
+    for (uint i = 0u; i < range.y; ++i)
+    {
+      GpuLight light = lightbuf.lights[lightindex.lightIndices[range.x + i]];
+      vec3 L;
+      vec3 radiance = localLightRadiance(light, fragPos, L);
+      addLight(surf, L, radiance, Lo, ccLo);
+    }
+  }
 
   // IBL ambient lighting (f_specular_ibl computed above, iso or aniso)
   vec3 f_diffuse_ibl = getIBLDiffuseLight(N) * albedo;
@@ -451,7 +825,7 @@ void main()
   vec3 f_dielectric_fresnel = getIBLGGXFresnel(N, V, perceptualRoughness, f0_dielectric, 1.0);
   vec3 f_dielectric_brdf = mix(f_diffuse_ibl, f_specular_ibl, f_dielectric_fresnel);
 
-  vec3 ambient = mix(f_dielectric_brdf, f_metal_brdf, metallic);
+  vec3 ambient = mix(f_dielectric_brdf, f_metal_brdf, metallic) * ssao;
 
   // Combine
   vec3 color = ambient + Lo;
@@ -467,44 +841,21 @@ void main()
   // A thin dielectric film (IOR 1.5, F0 = 0.04) layered over the base material.
   // Follows the glTF Sample Viewer layering: the base is attenuated by the coat's
   // reflectance, then the coat's own specular lobe is added on top.
-  if ((flags & 4u) != 0u && clearcoatFactor > 0.0)
+  if (surf.clearcoat)
   {
-    float cc = clearcoatFactor * texture(clearcoatTexture, uvCC, pc.mipBias).r;
-    float ccPerceptualRough = clamp(
-      clearcoatRoughnessFactor * texture(clearcoatRoughnessTexture, uvCCR, pc.mipBias).g,
-      0.0, 1.0);
-    float ccAlpha = ccPerceptualRough * ccPerceptualRough;
-
-    // Coat normal: dedicated map if present (flags bit 3), else the geometric
-    // normal — the smooth coat does NOT inherit the base material's normal map.
-    vec3 ccN;
-    if ((flags & 8u) != 0u) {
-      vec3 nm = texture(clearcoatNormalTexture, uvCCN, pc.mipBias).rgb * 2.0 - 1.0;
-      ccN = normalize(fragTBN * nm);
-    } else {
-      ccN = normalize(fragNormal);
-    }
-
-    float ccNdotL = clamp(dot(ccN, L), 0.0, 1.0);
-    float ccNdotV = clamp(dot(ccN, V), 0.0, 1.0);
-    float ccNdotH = clamp(dot(ccN, H), 0.0, 1.0);
-
     const vec3 ccF0 = vec3(0.04);
 
-    // Direct coat specular (Fresnel included, like the base specular lobe)
-    float ccSpec = BRDF_specularGGX(ccAlpha, ccNdotL, ccNdotV, ccNdotH);
-    vec3 ccLo = vec3(ccSpec) * F_Schlick(ccF0, F90, VdotH) * radiance * ccNdotL;
-
     // Indirect (IBL) coat specular, occluded by AO
-    vec3 ccIBL = getIBLRadianceGGX(ccN, V, ccPerceptualRough) * ao
-               * getIBLGGXFresnel(ccN, V, ccPerceptualRough, ccF0, 1.0);
+    vec3 ccIBL = getIBLRadianceGGX(surf.ccN, V, ccPerceptualRough) * ao * ssao
+               * getIBLGGXFresnel(surf.ccN, V, ccPerceptualRough, ccF0, 1.0);
 
     vec3 f_clearcoat = (ccLo + ccIBL) * cc;
 
     // Coat Fresnel at the viewing angle drives how much base shows through
+    float ccNdotV = clamp(dot(surf.ccN, V), 0.0, 1.0);
     float Fc = F_Schlick(ccF0, F90, ccNdotV).x;
     color = color * (1.0 - cc * Fc) + f_clearcoat;
   }
 
-  outColor = vec4(color, alpha);
+  writeColor(color, alpha);
 }
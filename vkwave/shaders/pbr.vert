@@ -1,4 +1,5 @@
 #version 450
+#extension GL_EXT_multiview : require
 
 // PBR vertex shader — adapted from Vulkanstein3D's vertex.vert
 // Computes TBN matrix for normal mapping with Gram-Schmidt re-orthogonalization.
@@ -8,6 +9,20 @@ layout(set = 0, binding = 0) uniform PbrUBO {
   vec4 camPos;
   vec4 lightDirection;
   vec4 lightColor;
+  mat4 view;
+  vec4 clusterDepth;
+  uvec4 clusterGrid;
+  mat4 shadowMatrices[4];
+  vec4 shadowSplits;
+  vec4 shadowTexelSize;
+  vec4 shadowParams;
+  vec4 viewport;        // xy = render / target extent, zw = 1 / target extent
+  mat4 unjitteredViewProj; // viewProj without the TAA sub-pixel jitter
+  mat4 prevViewProj;       // last frame's unjittered viewProj (motion vectors)
+  uvec4 views;             // x = multiview view count (0 = the single camera above)
+  mat4 viewProjs[6];       // per-view viewProj, indexed by gl_ViewIndex
+  vec4 viewCamPos[6];      // per-view camera position
+  vec4 rayTracing;         // x = tan(sun half-angle), y = reflection roughness cutoff, z = max ray distance, w = frame
 } ubo;
 
 // Vertex attributes (matches vkwave::Vertex)
@@ -18,6 +33,13 @@ layout(location = 3) in vec2 inTexCoord;
 layout(location = 4) in vec4 inTangent;  // xyz=tangent, w=handedness
 layout(location = 5) in vec2 inTexCoord1; // second UV set (glTF TEXCOORD_1)
 
+#ifdef INSTANCED
+// Per-instance world transform (vertex binding 1, PBRContext::instance_transforms)
+// replacing pc.model: the draw's firstInstance selects the primitive's entry,
+// so one draw covers every instance of a mesh.
+layout(location = 6) in mat4 inModel; // locations 6-9
+#endif
+
 // Push constant — must match PbrPushConstants (C++) and pbr.frag exactly.
 layout(push_constant) uniform PushConstants {
   mat4 model;
@@ -41,19 +63,31 @@ layout(location = 2) out vec3 fragPos;
 layout(location = 3) out vec2 fragTexCoord;
 layout(location = 4) out mat3 fragTBN;  // locations 4, 5, 6
 layout(location = 7) out vec2 fragTexCoord1;
+layout(location = 8) out vec4 fragCurClip;   // unjittered, for motion vectors
+layout(location = 9) out vec4 fragPrevClip;
 
 void main()
 {
-  vec4 worldPos = pc.model * vec4(inPosition, 1.0);
+#ifdef INSTANCED
+  mat4 model = inModel;
+#else
+  mat4 model = pc.model;
+#endif
+  vec4 worldPos = model * vec4(inPosition, 1.0);
   fragPos = worldPos.xyz;
 
-  gl_Position = ubo.viewProj * worldPos;
+  // Multiview (turntable batches): one draw covers every view of the mask.
+  gl_Position = (ubo.views.x > 0u ? ubo.viewProjs[gl_ViewIndex] : ubo.viewProj) * worldPos;
+  // Static geometry: only the camera moves between frames, so the previous
+  // position is this world position seen through last frame's camera.
+  fragCurClip = ubo.unjitteredViewProj * worldPos;
+  fragPrevClip = ubo.prevViewProj * worldPos;
   fragColor = inColor;
   fragTexCoord = inTexCoord;
   fragTexCoord1 = inTexCoord1;
 
   // Transform normal by model matrix (upper 3x3)
-  mat3 normalMatrix = mat3(pc.model);
+  mat3 normalMatrix = mat3(model);
   fragNormal = normalize(normalMatrix * inNormal);
 
   // Compute TBN matrix for normal mapping
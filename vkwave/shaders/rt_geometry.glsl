@@ -0,0 +1,79 @@
+// ============================================================================
+// Scene geometry for the ray tracing hit shaders (rt_*.rchit / .rahit).
+// Include with: #include "rt_geometry.glsl"
+//
+// The TLAS instances index the scene's shared vertex / index buffers through
+// gl_InstanceCustomIndexEXT: one primitive entry per instance.
+// ============================================================================
+
+// Floats per vertex; layout must match vkwave::Vertex (position, normal,
+// color, texCoord, tangent, texCoord1).
+layout(constant_id = 0) const uint VERTEX_STRIDE = 17;
+const uint NORMAL_OFFSET = 3;
+const uint COLOR_OFFSET = 6;
+
+// Layout must match vkwave::GpuMaterial (std430).
+struct GpuMaterial {
+  vec4 baseColorFactor;
+  float metallicFactor;
+  float roughnessFactor;
+  float clearcoatFactor;
+  float clearcoatRoughnessFactor;
+  float anisotropyStrength;
+  float anisotropyRotation;
+  float alphaCutoff;
+  uint alphaMode;
+  uint materialFlags;
+  uint uvSets;
+  float normalScale;
+  uint _pad2;
+  vec4 texXform[18];
+  float transmissionFactor;
+  float ior;
+  float thicknessFactor;
+  float _pad3;
+  vec4 attenuation;
+};
+
+layout(set = 0, binding = 3, std430) readonly buffer VertexBuffer {
+  float vertices[];
+} vbuf;
+
+layout(set = 0, binding = 4, std430) readonly buffer IndexBuffer {
+  uint indices[];
+} ibuf;
+
+// x = first index, y = vertex offset (int bits), z = material index.
+layout(set = 0, binding = 5, std430) readonly buffer PrimitiveBuffer {
+  uvec4 primitives[];
+} pbuf;
+
+layout(set = 0, binding = 6, std430) readonly buffer MaterialBuffer {
+  GpuMaterial materials[];
+} matbuf;
+
+uvec4 hitPrimitive()
+{
+  return pbuf.primitives[gl_InstanceCustomIndexEXT];
+}
+
+// Vertex indices of the hit triangle.
+uvec3 hitTriangle(uvec4 prim)
+{
+  uint base = prim.x + 3u * uint(gl_PrimitiveID);
+  ivec3 offset = ivec3(int(prim.y));
+  return uvec3(ivec3(ibuf.indices[base], ibuf.indices[base + 1u], ibuf.indices[base + 2u]) + offset);
+}
+
+vec3 vertexVec3(uint vertex, uint offset)
+{
+  uint i = vertex * VERTEX_STRIDE + offset;
+  return vec3(vbuf.vertices[i], vbuf.vertices[i + 1u], vbuf.vertices[i + 2u]);
+}
+
+vec3 interpolate(uvec3 tri, uint offset, vec3 bary)
+{
+  return vertexVec3(tri.x, offset) * bary.x +
+         vertexVec3(tri.y, offset) * bary.y +
+         vertexVec3(tri.z, offset) * bary.z;
+}
@@ -0,0 +1,18 @@
+#version 450
+
+// Shadow-map depth pass for one cascade. Depth-only: the pipeline has no
+// fragment shader, rasterization writes depth directly (with depth bias).
+
+// Vertex attributes (only the position of vkwave::Vertex is bound)
+layout(location = 0) in vec3 inPosition;
+
+// Push constant — must match ShadowPushConstants (C++).
+layout(push_constant) uniform PushConstants {
+  mat4 lightViewProj;
+  mat4 model;
+} pc;
+
+void main()
+{
+  gl_Position = pc.lightViewProj * pc.model * vec4(inPosition, 1.0);
+}
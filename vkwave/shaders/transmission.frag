@@ -1,11 +1,12 @@
 #version 450
 
-// Transmission (refraction) fragment shader — PHASE 1: sharp transmission.
+// Transmission (refraction) fragment shader — PHASE 2: roughness blur.
 //
 // Samples the opaque-scene snapshot at a screen coordinate displaced by the
 // refraction vector (Snell's law from IOR) over the volume thickness, then
-// applies Beer-Lambert absorption (KHR_materials_volume) and a Fresnel rim. No
-// roughness blur yet (that needs the snapshot mip chain — a later phase).
+// applies Beer-Lambert absorption (KHR_materials_volume) and a Fresnel rim.
+// Rough (frosted) glass reads a coarser level of the snapshot's mip chain; with
+// the copy fallback the sampler clamps to mip 0 (sharp).
 //
 // Reuses pbr.vert, so the push-constant block must match pbr.vert exactly.
 
@@ -14,6 +15,20 @@ layout(set = 0, binding = 0) uniform PbrUBO {
   vec4 camPos;
   vec4 lightDirection;
   vec4 lightColor;
+  mat4 view;            // clustered-light and shadow fields: unused here,
+  vec4 clusterDepth;    // the block must match pbr.vert (reflection takes
+  uvec4 clusterGrid;    // the first stage's block size)
+  mat4 shadowMatrices[4];
+  vec4 shadowSplits;
+  vec4 shadowTexelSize;
+  vec4 shadowParams;
+  vec4 viewport;        // xy = render / target extent, zw = 1 / target extent
+  mat4 unjitteredViewProj; // viewProj without the TAA sub-pixel jitter
+  mat4 prevViewProj;       // last frame's unjittered viewProj (motion vectors)
+  uvec4 views;             // x = multiview view count (0 = the single camera above)
+  mat4 viewProjs[6];       // per-view viewProj, indexed by gl_ViewIndex
+  vec4 viewCamPos[6];      // per-view camera position
+  vec4 rayTracing;         // x = tan(sun half-angle), y = reflection roughness cutoff, z = max ray distance, w = frame
 } ubo;
 
 // Per-slot snapshot of the opaque HDR (the scene *behind* the glass). Rebound
@@ -104,8 +119,16 @@ void main()
 
   vec4 clip = ubo.viewProj * vec4(exitPos, 1.0);
   vec2 uv = (clip.xy / clip.w) * 0.5 + 0.5;   // Vulkan NDC -> texture UV (no flip)
-  uv = clamp(uv, vec2(0.0), vec2(1.0));
-  vec3 background = texture(snapshotTex, uv).rgb;
+  // Dynamic resolution: the scene fills only the top-left viewport.xy of the
+  // snapshot. Stay half a texel inside it so filtering never reads past it.
+  uv = clamp(uv * ubo.viewport.xy, vec2(0.0), ubo.viewport.xy - 0.5 * ubo.viewport.zw);
+  // Roughness blur: LOD from the rendered width, scaled by the IOR as in the
+  // glTF sample viewer (an IOR of 1 does not bend — hence does not blur —
+  // light). The sampler's maxLod stops at the last generated level.
+  float roughness = (pc.roughnessOverride >= 0.0) ? pc.roughnessOverride : m.roughnessFactor;
+  float blur = clamp(roughness * clamp(ior * 2.0 - 2.0, 0.0, 1.0), 0.0, 1.0);
+  float width = float(textureSize(snapshotTex, 0).x) * ubo.viewport.x;
+  vec3 background = textureLod(snapshotTex, uv, log2(max(width, 1.0)) * blur).rgb;
 
   // Beer-Lambert absorption over the path length (KHR_materials_volume). The
   // attenuation colour is the transmitted colour at attenuationDistance.
@@ -1,9 +1,20 @@
 #include <catch2/catch_test_macros.hpp>
 
+#include <vkwave/core/bvh.h>
+#include <vkwave/core/camera.h>
+#include <vkwave/core/deletion_queue.h>
+#include <vkwave/core/device.h>
+#include <vkwave/core/dynamic_resolution.h>
+#include <vkwave/core/exposure.h>
 #include <vkwave/core/fence.h>
 #include <vkwave/core/semaphore.h>
+#include <vkwave/core/temporal_history.h>
 
+#include <cmath>
+#include <cstring>
+#include <initializer_list>
 #include <type_traits>
+#include <vector>
 
 // Fence and Semaphore are RAII wrappers with non-trivial destructors.
 // The render graph's compile-time ownership check (std::is_trivially_destructible)
@@ -40,3 +51,366 @@ TEST_CASE("vkwave::core::semaphore_is_movable", "[core]")
 {
   STATIC_REQUIRE(std::is_move_constructible_v<vkwave::Semaphore>);
 }
+
+// The deletion queue owns retired resources outright: a copy would free them twice.
+
+TEST_CASE("vkwave::core::deletion_queue_is_non_copyable", "[core]")
+{
+  STATIC_REQUIRE_FALSE(std::is_copy_constructible_v<vkwave::DeletionQueue>);
+  STATIC_REQUIRE_FALSE(std::is_copy_assignable_v<vkwave::DeletionQueue>);
+}
+
+// RetireList is the deletion queue's ordering without the semaphore.
+
+TEST_CASE("vkwave::core::retire_list_waits_for_its_value", "[core]")
+{
+  vkwave::RetireList list;
+  std::vector<int> ran;
+  constexpr uint64_t n = 5;
+
+  list.push(n, 3, [&] { ran.push_back(1); });
+  list.push(n + 1, 3, [&] { ran.push_back(2); });
+  REQUIRE(ran.empty());
+  REQUIRE(list.size() == 2);
+
+  // Reaching N runs exactly the first.
+  CHECK(list.collect(n) == 1);
+  CHECK(ran == std::vector<int>{ 1 });
+  CHECK(list.size() == 1);
+
+  // Nothing new reached: nothing runs.
+  CHECK(list.collect(n) == 0);
+  CHECK(ran == std::vector<int>{ 1 });
+
+  CHECK(list.collect(n + 1) == 1);
+  CHECK(ran == std::vector<int>{ 1, 2 });
+  CHECK(list.size() == 0);
+
+  // Already reached: runs right away.
+  list.push(n, n, [&] { ran.push_back(3); });
+  CHECK(ran == std::vector<int>{ 1, 2, 3 });
+  CHECK(list.size() == 0);
+}
+
+TEST_CASE("vkwave::core::retire_list_flush_runs_nested_pushes", "[core]")
+{
+  vkwave::RetireList list;
+  int ran = 0;
+
+  // A destroy retiring more (a group owning Images): collect defers the
+  // nested entry, flush runs it.
+  list.push(2, 0, [&] {
+    ++ran;
+    list.push(4, 0, [&] { ++ran; });
+  });
+  CHECK(list.collect(2) == 1);
+  CHECK(ran == 1);
+  CHECK(list.size() == 1);
+
+  list.push(4, 0, [&] {
+    ++ran;
+    list.push(4, 0, [&] { ++ran; });
+  });
+  list.flush();
+  CHECK(ran == 4);
+  CHECK(list.size() == 0);
+}
+
+TEST_CASE("vkwave::core::resize_retires_after_frames_in_flight", "[core]")
+{
+  // A resize mid-stream (RenderGraph::resize, Swapchain::recreate): frames 1-3
+  // are submitted, the GPU has finished frame 1. The old swapchain and a
+  // group's frame resources are retired at value 3; destroying the group
+  // retires its images in turn.
+  vkwave::RetireList list;
+  uint64_t submitted = 3;
+  uint64_t completed = 1;
+  bool swapchain_destroyed = false;
+  bool group_destroyed = false;
+  bool images_destroyed = false;
+
+  list.push(submitted, completed, [&] { swapchain_destroyed = true; });
+  list.push(submitted, completed, [&] {
+    group_destroyed = true;
+    list.push(submitted, completed, [&] { images_destroyed = true; });
+  });
+
+  // The first frame at the new size is submitted; the GPU reaches 2.
+  submitted = 4;
+  completed = 2;
+  CHECK(list.collect(completed) == 0);
+  CHECK_FALSE(swapchain_destroyed);
+  CHECK_FALSE(group_destroyed);
+
+  // Past the recorded value: both go; the images retired by the group wait
+  // for the frame submitted since.
+  completed = 3;
+  CHECK(list.collect(completed) == 2);
+  CHECK(swapchain_destroyed);
+  CHECK(group_destroyed);
+  CHECK_FALSE(images_destroyed);
+
+  completed = 4;
+  CHECK(list.collect(completed) == 1);
+  CHECK(images_destroyed);
+  CHECK(list.size() == 0);
+}
+
+// DynamicResolution is pure CPU state: no device needed.
+
+TEST_CASE("vkwave::core::dynamic_resolution_scaled_extent", "[core]")
+{
+  using vkwave::DynamicResolution;
+  CHECK(DynamicResolution::scaled_extent({ 1920, 1080 }, 0.5f) == vk::Extent2D{ 960, 540 });
+  CHECK(DynamicResolution::scaled_extent({ 1920, 1080 }, 1.0f) == vk::Extent2D{ 1920, 1080 });
+  CHECK(DynamicResolution::scaled_extent({ 1920, 1080 }, 2.0f) == vk::Extent2D{ 1920, 1080 });
+  CHECK(DynamicResolution::scaled_extent({ 3, 1 }, 0.01f) == vk::Extent2D{ 1, 1 });
+}
+
+TEST_CASE("vkwave::core::dynamic_resolution_tracks_target", "[core]")
+{
+  vkwave::DynamicResolution::Settings settings;
+  settings.target_ms = 16.0f;
+  settings.smoothing = 1.0f;   // no averaging
+  settings.settle_frames = 0;  // react every update
+  vkwave::DynamicResolution controller(settings);
+  REQUIRE(controller.scale() == 1.0f);
+
+  // Over budget: shrinks, at most max_step per update, down to min_scale.
+  CHECK(controller.update(32.0f) < 1.0f);
+  CHECK(controller.scale() >= 1.0f - settings.max_step);
+  for (int i = 0; i < 100; ++i)
+    controller.update(32.0f);
+  CHECK(controller.scale() == settings.min_scale);
+
+  // Inside the dead band: holds.
+  const float held = controller.update(15.0f);
+  CHECK(held == settings.min_scale);
+
+  // Under budget: grows back, up to max_scale.
+  for (int i = 0; i < 100; ++i)
+    controller.update(4.0f);
+  CHECK(controller.scale() == settings.max_scale);
+
+  // Non-positive samples (no timing yet) are ignored.
+  CHECK(controller.update(0.0f) == settings.max_scale);
+}
+
+TEST_CASE("vkwave::core::camera_revision_tracks_changes", "[core]")
+{
+  vkwave::Camera camera;
+  camera.set_aspect_ratio(2.0f);
+  const auto start = camera.revision();
+
+  // Per-frame calls that change nothing (same aspect, jitter) are not changes.
+  camera.set_aspect_ratio(2.0f);
+  camera.set_jitter({ 0.001f, 0.002f });
+  CHECK(camera.revision() == start);
+
+  camera.azimuth(10.0f);
+  CHECK(camera.revision() > start);
+
+  const auto moved = camera.revision();
+  camera.set_aspect_ratio(1.5f);
+  CHECK(camera.revision() > moved);
+}
+
+TEST_CASE("vkwave::core::camera_projection_is_reversed_infinite", "[core]")
+{
+  vkwave::Camera camera;
+  camera.set_aspect_ratio(1.0f);
+  camera.set_clipping_range(0.1f, 100.0f);
+  const glm::mat4 proj = camera.projection_matrix();
+  auto ndc_depth = [&](float view_distance) {
+    const glm::vec4 clip = proj * glm::vec4(0.0f, 0.0f, -view_distance, 1.0f);
+    return clip.z / clip.w;
+  };
+
+  // 1 at the near plane, decreasing with distance, never reaching 0: nothing
+  // behind the far plane is clipped.
+  CHECK(ndc_depth(0.1f) == 1.0f);
+  CHECK(ndc_depth(10.0f) < ndc_depth(1.0f));
+  CHECK(ndc_depth(1.0e6f) > 0.0f);
+}
+
+TEST_CASE("vkwave::core::exposure_adaptation_is_frame_rate_independent", "[core]")
+{
+  CHECK(vkwave::exposure_adaptation(0.0f, 2.0f) == 0.0f);
+  CHECK(vkwave::exposure_adaptation(-1.0f, 2.0f) == 0.0f);
+  CHECK(vkwave::exposure_adaptation(100.0f, 2.0f) > 0.999f);
+
+  // Two half steps cover what one full step does.
+  const float half = vkwave::exposure_adaptation(0.008f, 1.5f);
+  const float full = vkwave::exposure_adaptation(0.016f, 1.5f);
+  const float remaining = (1.0f - half) * (1.0f - half);
+  CHECK(std::abs((1.0f - remaining) - full) < 1e-5f);
+}
+
+TEST_CASE("vkwave::core::exposure_error_stops", "[core]")
+{
+  vkwave::ExposureState state{};
+  state.averageLog2 = std::log2(vkwave::kExposureMiddleGrey) - 2.0f; // target exposure 4
+  state.exposure = 1.0f;
+
+  // All black: nothing to adapt to.
+  CHECK(vkwave::exposure_error_stops(state) == 0.0f);
+
+  // Bin 0 (black) does not count either.
+  state.histogram[0] = 100;
+  CHECK(vkwave::exposure_error_stops(state) == 0.0f);
+
+  state.histogram[128] = 100;
+  CHECK(std::abs(vkwave::exposure_error_stops(state) - 2.0f) < 1e-5f);
+  state.exposure = 8.0f;
+  CHECK(std::abs(vkwave::exposure_error_stops(state) - 1.0f) < 1e-5f);
+  state.exposure = 4.0f;
+  CHECK(vkwave::exposure_error_stops(state) < vkwave::kExposureSettledStops);
+}
+
+TEST_CASE("vkwave::core::temporal_history_survives_gated_frames", "[core]")
+{
+  // Two slots, advanced every display frame; the scene renders on every other
+  // one, so it records in slot 0 each time — never in the slot after its
+  // history.
+  constexpr uint32_t slots = 2;
+  vkwave::TemporalHistory history;
+  history.resize(slots);
+
+  uint32_t written_before = UINT32_MAX;
+  for (uint32_t frame = 0; frame < 6; frame += 2)
+  {
+    const uint32_t slot = frame % slots;
+    REQUIRE(slot == 0);
+    const uint32_t target = history.target(slot);
+    if (frame == 0)
+    {
+      CHECK_FALSE(history.usable(slot));
+    }
+    else
+    {
+      // Both gated frames blend with the output written before, and do not
+      // overwrite it.
+      CHECK(history.usable(slot));
+      CHECK(history.latest() == written_before);
+      CHECK(target != written_before);
+    }
+    history.written(target);
+    written_before = target;
+  }
+
+  // A camera cut drops the history but keeps the output to present.
+  history.reset();
+  CHECK_FALSE(history.valid());
+  CHECK_FALSE(history.usable(0));
+  CHECK(history.written_any());
+  CHECK(history.latest() == written_before);
+
+  // The resolve after the cut is the next frame's history again (the AO the
+  // scene pass shades with).
+  history.written(history.target(0));
+  CHECK(history.valid());
+
+  // Every slot, one scene frame per display frame: each slot writes its own.
+  history.resize(3);
+  for (uint32_t frame = 0; frame < 6; ++frame)
+  {
+    const uint32_t slot = frame % 3;
+    CHECK(history.target(slot) == slot);
+    CHECK(history.usable(slot) == (frame > 0));
+    history.written(slot);
+  }
+
+  // A single slot cannot hold a history and the output being written.
+  history.resize(1);
+  history.written(history.target(0));
+  CHECK_FALSE(history.usable(0));
+}
+
+// Ray query traces acceleration structures from any shader stage: it must not
+// wait for the ray tracing pipeline, which e.g. lavapipe does not expose.
+
+static std::vector<vk::ExtensionProperties> extensions(std::initializer_list<const char*> names)
+{
+  std::vector<vk::ExtensionProperties> props;
+  for (const char* name : names)
+  {
+    vk::ExtensionProperties ext{};
+    std::strncpy(ext.extensionName.data(), name, VK_MAX_EXTENSION_NAME_SIZE - 1);
+    props.push_back(ext);
+  }
+  return props;
+}
+
+TEST_CASE("vkwave::core::ray_query_needs_no_ray_tracing_pipeline", "[core]")
+{
+  const auto ray_query_only = extensions({ VK_KHR_ACCELERATION_STRUCTURE_EXTENSION_NAME,
+    VK_KHR_DEFERRED_HOST_OPERATIONS_EXTENSION_NAME, VK_KHR_RAY_QUERY_EXTENSION_NAME });
+  auto caps = vkwave::select_ray_tracing_capabilities(ray_query_only, true);
+  CHECK(caps.acceleration_structure);
+  CHECK(caps.ray_query);
+  CHECK_FALSE(caps.supported);
+  CHECK_FALSE(caps.pipeline_library);
+
+  // Not requested: nothing, whatever the device has.
+  caps = vkwave::select_ray_tracing_capabilities(ray_query_only, false);
+  CHECK_FALSE(caps.acceleration_structure);
+  CHECK_FALSE(caps.ray_query);
+
+  // Neither way to trace without acceleration structures.
+  caps = vkwave::select_ray_tracing_capabilities(extensions({
+    VK_KHR_RAY_TRACING_PIPELINE_EXTENSION_NAME, VK_KHR_DEFERRED_HOST_OPERATIONS_EXTENSION_NAME,
+    VK_KHR_RAY_QUERY_EXTENSION_NAME }), true);
+  CHECK_FALSE(caps.acceleration_structure);
+  CHECK_FALSE(caps.supported);
+  CHECK_FALSE(caps.ray_query);
+
+  // The ray tracing pipeline without ray query, and with its libraries.
+  caps = vkwave::select_ray_tracing_capabilities(extensions({
+    VK_KHR_ACCELERATION_STRUCTURE_EXTENSION_NAME, VK_KHR_DEFERRED_HOST_OPERATIONS_EXTENSION_NAME,
+    VK_KHR_RAY_TRACING_PIPELINE_EXTENSION_NAME, VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME }), true);
+  CHECK(caps.supported);
+  CHECK(caps.pipeline_library);
+  CHECK_FALSE(caps.ray_query);
+}
+
+TEST_CASE("vkwave::core::bvh_closest_hit_and_masks", "[core]")
+{
+  // A stack of unit quads facing +z at z = 0..9; quad k is masked 1 << (k % 2).
+  std::vector<glm::vec3> positions;
+  std::vector<uint8_t> masks;
+  for (int k = 0; k < 10; ++k)
+  {
+    const auto z = static_cast<float>(k);
+    positions.insert(positions.end(), {
+      { -1.0f, -1.0f, z }, { 1.0f, -1.0f, z }, { 1.0f, 1.0f, z },
+      { -1.0f, -1.0f, z }, { 1.0f, 1.0f, z }, { -1.0f, 1.0f, z } });
+    masks.insert(masks.end(), 2, static_cast<uint8_t>(1u << (k % 2)));
+  }
+  const vkwave::Bvh4 bvh(positions, masks);
+  REQUIRE(bvh.triangle_count() == 20);
+
+  vkwave::BvhRay ray;
+  ray.origin = glm::vec3(0.25f, 0.1f, -5.0f);
+  ray.direction = glm::vec3(0.0f, 0.0f, 1.0f);
+  auto hit = bvh.intersect(ray);
+  REQUIRE(hit.valid());
+  CHECK(std::abs(hit.t - 5.0f) < 1e-5f);
+  CHECK(hit.triangle / 2 == 0);
+
+  ray.mask = 0x02;
+  hit = bvh.intersect(ray);
+  REQUIRE(hit.valid());
+  CHECK(hit.triangle / 2 == 1);
+
+  ray.mask = 0x01;
+  ray.t_max = 6.5f;
+  CHECK(bvh.occluded(ray));
+  ray.t_min = 5.5f;
+  CHECK_FALSE(bvh.occluded(ray));
+
+  // Misses beside the stack.
+  ray = {};
+  ray.origin = glm::vec3(2.0f, 0.0f, -5.0f);
+  CHECK_FALSE(bvh.intersect(ray).valid());
+  CHECK_FALSE(vkwave::Bvh4().intersect(ray).valid());
+}
@@ -1,11 +1,40 @@
 #include <catch2/catch_test_macros.hpp>
 
+#include <vkwave/core/ambient_occlusion.h>
+#include <vkwave/core/camera.h>
 #include <vkwave/core/camera_ubo.h>
+#include <vkwave/core/exposure.h>
+#include <vkwave/core/hiz_cull.h>
+#include <vkwave/core/light_cluster.h>
+#include <vkwave/core/mip_downsample.h>
+#include <vkwave/core/pbr_ubo.h>
+#include <vkwave/core/post_fx.h>
 #include <vkwave/core/push_constants.h>
+#include <vkwave/core/shadow_cascade.h>
+#include <vkwave/core/temporal_aa.h>
+#include <vkwave/loaders/gltf_loader.h>
+#include <vkwave/loaders/ibl.h>
+#include <vkwave/pipeline/acceleration_structure.h>
+#include <vkwave/pipeline/oit_resolve.h>
+#include <vkwave/pipeline/path_tracer.h>
+#include <vkwave/pipeline/pbr_pass.h>
+#include <vkwave/pipeline/post_fx.h>
+#include <vkwave/pipeline/raytracing_pipeline.h>
+#include <vkwave/pipeline/scene_ray_tracer.h>
 #include <vkwave/pipeline/shader_compiler.h>
 #include <vkwave/pipeline/shader_reflection.h>
 #include <vkwave/pipeline/topo_order.h>
 
+#include <spirv_reflect.h>
+
+#include <cmath>
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
 // Ensure a ShaderCompiler instance exists for all tests in this file.
 // The Registered<> weak_ptr keeps it alive as long as this shared_ptr does.
 static auto g_compiler = vkwave::ShaderCompiler::create();
@@ -100,6 +129,809 @@ TEST_CASE("vkwave::pipeline::reflection_extracts_cube_push_constants", "[pipelin
   reflection.validate_push_constant_size(sizeof(vkwave::CubePushConstants));
 }
 
+// --- HiZ occlusion culling reflection tests ---
+
+TEST_CASE("vkwave::pipeline::reflection_extracts_hiz_cull_layout", "[pipeline]")
+{
+  auto compiler = vkwave::ShaderCompiler::get();
+  auto comp = compiler->compile(
+    TEST_SHADER_DIR "hiz_cull.comp", vk::ShaderStageFlagBits::eCompute);
+
+  vkwave::ShaderReflection reflection;
+  reflection.set_debug(true);
+  reflection.add_stage(comp.spirv, vk::ShaderStageFlagBits::eCompute);
+  reflection.finalize();
+
+  auto& sets = reflection.descriptor_set_infos();
+  REQUIRE(sets.size() == 1);
+  REQUIRE(sets[0].bindings.size() == 5);
+  reflection.validate_ubo_size(0, 0, sizeof(vkwave::HiZCullParams));
+  reflection.validate_push_constant_size(sizeof(vkwave::HiZCullPushConstants));
+}
+
+TEST_CASE("vkwave::pipeline::reflection_extracts_hiz_build_push_constants", "[pipeline]")
+{
+  auto compiler = vkwave::ShaderCompiler::get();
+  auto comp = compiler->compile(
+    TEST_SHADER_DIR "hiz_build.comp", vk::ShaderStageFlagBits::eCompute);
+
+  vkwave::ShaderReflection reflection;
+  reflection.set_debug(true);
+  reflection.add_stage(comp.spirv, vk::ShaderStageFlagBits::eCompute);
+  reflection.finalize();
+
+  reflection.validate_push_constant_size(sizeof(vkwave::HiZBuildPushConstants));
+}
+
+// --- Clustered lighting reflection tests ---
+
+TEST_CASE("vkwave::pipeline::reflection_extracts_cluster_lights_layout", "[pipeline]")
+{
+  auto compiler = vkwave::ShaderCompiler::get();
+  auto comp = compiler->compile(
+    TEST_SHADER_DIR "cluster_lights.comp", vk::ShaderStageFlagBits::eCompute);
+
+  vkwave::ShaderReflection reflection;
+  reflection.set_debug(true);
+  reflection.add_stage(comp.spirv, vk::ShaderStageFlagBits::eCompute);
+  reflection.finalize();
+
+  auto& sets = reflection.descriptor_set_infos();
+  REQUIRE(sets.size() == 1);
+  REQUIRE(sets[0].bindings.size() == 4);
+  reflection.validate_ubo_size(0, 0, sizeof(vkwave::LightClusterParams));
+  reflection.validate_push_constant_size(sizeof(vkwave::LightClusterPushConstants));
+}
+
+TEST_CASE("vkwave::pipeline::reflection_pbr_set0_has_ubo_and_light_lists", "[pipeline]")
+{
+  auto compiler = vkwave::ShaderCompiler::get();
+  auto vert = compiler->compile(
+    TEST_SHADER_DIR "pbr.vert", vk::ShaderStageFlagBits::eVertex);
+  auto frag = compiler->compile(
+    TEST_SHADER_DIR "pbr.frag", vk::ShaderStageFlagBits::eFragment);
+
+  vkwave::ShaderReflection reflection;
+  reflection.set_debug(true);
+  reflection.add_stage(vert.spirv, vk::ShaderStageFlagBits::eVertex);
+  reflection.add_stage(frag.spirv, vk::ShaderStageFlagBits::eFragment);
+  reflection.finalize();
+
+  auto& sets = reflection.descriptor_set_infos();
+  REQUIRE(!sets.empty());
+  CHECK(sets[0].set == 0);
+  REQUIRE(sets[0].bindings.size() == 5);
+  CHECK(sets[0].bindings[0].type == vk::DescriptorType::eUniformBuffer);
+  for (uint32_t b = 1; b < 4; ++b)
+    CHECK(sets[0].bindings[b].type == vk::DescriptorType::eStorageBuffer);
+  CHECK(sets[0].bindings[4].type == vk::DescriptorType::eCombinedImageSampler);
+  reflection.validate_ubo_size(0, 0, sizeof(vkwave::PbrUBO));
+}
+
+TEST_CASE("vkwave::pipeline::reflection_pbr_ray_query_adds_tlas_binding", "[pipeline]")
+{
+  auto compiler = vkwave::ShaderCompiler::get();
+  vkwave::PipelineSpec spec = vkwave::PBRPass::pipeline_spec();
+  vkwave::PBRPass::enable_ray_query(spec);
+  auto frag = compiler->compile(
+    TEST_SHADER_DIR "pbr.frag", vk::ShaderStageFlagBits::eFragment, spec.fragment_preamble);
+
+  vkwave::ShaderReflection reflection;
+  reflection.set_debug(true);
+  reflection.add_stage(frag.spirv, vk::ShaderStageFlagBits::eFragment);
+  reflection.finalize();
+
+  auto& sets = reflection.descriptor_set_infos();
+  REQUIRE(sets.size() == 3);
+  CHECK(sets[2].set == 2);
+  REQUIRE(sets[2].bindings.size() == 6);
+  CHECK(sets[2].bindings[5].binding == 5);
+  CHECK(sets[2].bindings[5].type == vk::DescriptorType::eAccelerationStructureKHR);
+}
+
+TEST_CASE("vkwave::pipeline::reflection_composite_comp_matches_exposure_structs", "[pipeline]")
+{
+  auto compiler = vkwave::ShaderCompiler::get();
+  auto comp = compiler->compile(
+    TEST_SHADER_DIR "composite.comp", vk::ShaderStageFlagBits::eCompute);
+
+  vkwave::ShaderReflection reflection;
+  reflection.set_debug(true);
+  reflection.add_stage(comp.spirv, vk::ShaderStageFlagBits::eCompute);
+  reflection.finalize();
+
+  // What ComputeComposite writes: the HDR, the swapchain image, the state.
+  auto& sets = reflection.descriptor_set_infos();
+  REQUIRE(sets.size() == 1);
+  REQUIRE(sets[0].bindings.size() == 3);
+  CHECK(sets[0].bindings[0].type == vk::DescriptorType::eCombinedImageSampler);
+  CHECK(sets[0].bindings[1].type == vk::DescriptorType::eStorageImage);
+  CHECK(sets[0].bindings[2].type == vk::DescriptorType::eStorageBuffer);
+  CHECK(sets[0].bindings[2].blockSize == sizeof(vkwave::ExposureState));
+  reflection.validate_push_constant_size(sizeof(vkwave::CompositePushConstants));
+
+  // Middle grey is pushed from kExposureMiddleGrey, which exposure_error_stops()
+  // (Scene::busy()) measures the adaptation against.
+  SpvReflectShaderModule module{};
+  REQUIRE(spvReflectCreateShaderModule(comp.spirv.size() * sizeof(uint32_t), comp.spirv.data(),
+    &module) == SPV_REFLECT_RESULT_SUCCESS);
+  uint32_t count = 0;
+  spvReflectEnumeratePushConstantBlocks(&module, &count, nullptr);
+  REQUIRE(count == 1);
+  SpvReflectBlockVariable* block = nullptr;
+  spvReflectEnumeratePushConstantBlocks(&module, &count, &block);
+  uint32_t offset = UINT32_MAX;
+  for (uint32_t i = 0; i < block->member_count; ++i)
+  {
+    if (block->members[i].name && std::string_view(block->members[i].name) == "middleGrey")
+      offset = block->members[i].offset;
+  }
+  spvReflectDestroyShaderModule(&module);
+  CHECK(offset == offsetof(vkwave::CompositePushConstants, middleGrey));
+}
+
+TEST_CASE("vkwave::pipeline::reflection_oit_resolve_matches_written_sets", "[pipeline]")
+{
+  // OitResolve writes set 0 from kDescriptorTypes without reflecting it: the
+  // shader must declare exactly those bindings.
+  auto compiler = vkwave::ShaderCompiler::get();
+  auto comp = compiler->compile(
+    TEST_SHADER_DIR "oit_resolve.comp", vk::ShaderStageFlagBits::eCompute);
+
+  vkwave::ShaderReflection reflection;
+  reflection.set_debug(true);
+  reflection.add_stage(comp.spirv, vk::ShaderStageFlagBits::eCompute);
+  reflection.finalize();
+
+  auto& sets = reflection.descriptor_set_infos();
+  REQUIRE(sets.size() == 1);
+  CHECK(sets[0].set == 0);
+  const auto& types = vkwave::OitResolve::kDescriptorTypes;
+  REQUIRE(sets[0].bindings.size() == types.size());
+  for (uint32_t b = 0; b < types.size(); ++b)
+  {
+    CHECK(sets[0].bindings[b].binding == b);
+    CHECK(sets[0].bindings[b].type == types[b]);
+    CHECK(sets[0].bindings[b].count == 1);
+  }
+  CHECK(sets[0].bindings[0].name == "accumTex");
+  CHECK(sets[0].bindings[1].name == "revealTex");
+  CHECK(sets[0].bindings[2].name == "hdrImage");
+  reflection.validate_push_constant_size(sizeof(vkwave::OitResolvePushConstants));
+}
+
+TEST_CASE("vkwave::pipeline::pbr_spec_streams_instance_transforms", "[pipeline]")
+{
+  vkwave::PipelineSpec spec = vkwave::PBRPass::pipeline_spec();
+  REQUIRE(spec.vertex_bindings.size() == 2);
+  CHECK(spec.vertex_bindings[1].binding == 1);
+  CHECK(spec.vertex_bindings[1].inputRate == vk::VertexInputRate::eInstance);
+  CHECK(spec.vertex_bindings[1].stride == sizeof(glm::mat4));
+  REQUIRE(spec.vertex_attributes.size() == 10);
+  // Locations 6-9 are the matrix columns, streamed from binding 1.
+  for (const auto& attribute : spec.vertex_attributes)
+  {
+    const bool column = attribute.location >= 6 && attribute.location <= 9;
+    CHECK(attribute.binding == (column ? 1u : 0u));
+    if (column)
+    {
+      CHECK(attribute.format == vk::Format::eR32G32B32A32Sfloat);
+      CHECK(attribute.offset == (attribute.location - 6) * sizeof(glm::vec4));
+    }
+  }
+
+  // The shader's inputs, without built-ins: the location-6 input is a mat4.
+  auto vertex_inputs = [](const std::vector<uint32_t>& spirv) {
+    SpvReflectShaderModule module{};
+    REQUIRE(spvReflectCreateShaderModule(spirv.size() * sizeof(uint32_t), spirv.data(),
+      &module) == SPV_REFLECT_RESULT_SUCCESS);
+    uint32_t count = 0;
+    spvReflectEnumerateInputVariables(&module, &count, nullptr);
+    std::vector<SpvReflectInterfaceVariable*> variables(count);
+    spvReflectEnumerateInputVariables(&module, &count, variables.data());
+    std::vector<SpvReflectInterfaceVariable> inputs;
+    for (auto* variable : variables)
+    {
+      if (!(variable->decoration_flags & SPV_REFLECT_DECORATION_BUILT_IN))
+        inputs.push_back(*variable);
+    }
+    spvReflectDestroyShaderModule(&module);
+    return inputs;
+  };
+
+  auto compiler = vkwave::ShaderCompiler::get();
+  auto vert = compiler->compile(
+    TEST_SHADER_DIR "pbr.vert", vk::ShaderStageFlagBits::eVertex, spec.vertex_preamble);
+  uint32_t matrices = 0;
+  for (const auto& input : vertex_inputs(vert.spirv))
+  {
+    CHECK((input.location < 7 || input.location > 9));
+    if (input.location != 6) continue;
+    ++matrices;
+    CHECK(input.numeric.matrix.column_count == 4);
+    CHECK(input.numeric.matrix.row_count == 4);
+    CHECK(input.numeric.scalar.width == 32);
+  }
+  CHECK(matrices == 1);
+
+  // Without the preamble the model matrix is the push constant's.
+  auto legacy = compiler->compile(TEST_SHADER_DIR "pbr.vert", vk::ShaderStageFlagBits::eVertex);
+  for (const auto& input : vertex_inputs(legacy.spirv))
+    CHECK(input.location < 6);
+}
+
+// --- glTF loader tests ---
+
+// One embedded triangle read by two meshes: nodes 0 and 2 instance mesh 0,
+// node 1 draws mesh 1.
+static constexpr std::string_view kInstancedGltf = R"({
+  "asset": { "version": "2.0" },
+  "scene": 0,
+  "scenes": [ { "nodes": [ 0, 1, 2 ] } ],
+  "nodes": [
+    { "mesh": 0 },
+    { "mesh": 1, "translation": [ 0, 2, 0 ] },
+    { "mesh": 0, "translation": [ 4, 0, 0 ] }
+  ],
+  "meshes": [
+    { "primitives": [ { "attributes": { "POSITION": 0 }, "indices": 1 } ] },
+    { "primitives": [ { "attributes": { "POSITION": 0 }, "indices": 1 } ] }
+  ],
+  "accessors": [
+    { "bufferView": 0, "componentType": 5126, "count": 3, "type": "VEC3",
+      "min": [ 0, 0, 0 ], "max": [ 1, 1, 0 ] },
+    { "bufferView": 1, "componentType": 5123, "count": 3, "type": "SCALAR" }
+  ],
+  "bufferViews": [
+    { "buffer": 0, "byteOffset": 0, "byteLength": 36 },
+    { "buffer": 0, "byteOffset": 36, "byteLength": 6 }
+  ],
+  "buffers": [ { "byteLength": 44, "uri":
+    "data:application/octet-stream;base64,AAAAAAAAAAAAAAAAAACAPwAAAAAAAAAAAAAAAAAAgD8AAAAAAAABAAIAAAA=" } ]
+})";
+
+TEST_CASE("vkwave::pipeline::gltf_instances_share_one_upload", "[pipeline]")
+{
+  const auto path = std::filesystem::temp_directory_path() / "vkwave_instanced_mesh.gltf";
+  std::ofstream(path) << kInstancedGltf;
+  const auto scene = vkwave::load_gltf_scene_geometry(path.string());
+  std::filesystem::remove(path);
+
+  // Mesh 0's vertices go in once for both of its nodes.
+  CHECK(scene.mesh == nullptr);
+  CHECK(scene.mesh_count == 2);
+  CHECK(scene.vertices.size() == 6);
+  CHECK(scene.indices.size() == 6);
+  REQUIRE(scene.primitives.size() == 3);
+
+  // Its instances are adjacent (one instanced draw), in node order, and draw
+  // the same range under their own transforms.
+  const auto& first = scene.primitives[0];
+  const auto& second = scene.primitives[1];
+  CHECK(first.meshIndex == second.meshIndex);
+  CHECK(first.firstIndex == second.firstIndex);
+  CHECK(first.indexCount == 3);
+  CHECK(second.indexCount == 3);
+  CHECK(first.vertexOffset == second.vertexOffset);
+  CHECK(first.modelMatrix[3].x == 0.0f);
+  CHECK(second.modelMatrix[3].x == 4.0f);
+
+  const auto& other = scene.primitives[2];
+  CHECK(other.meshIndex != first.meshIndex);
+  CHECK(other.firstIndex == 3);
+  CHECK(other.vertexOffset == 3);
+  CHECK(other.modelMatrix[3].y == 2.0f);
+}
+
+// --- Cascaded shadow map tests ---
+
+TEST_CASE("vkwave::pipeline::reflection_extracts_shadow_push_constants", "[pipeline]")
+{
+  auto compiler = vkwave::ShaderCompiler::get();
+  auto vert = compiler->compile(
+    TEST_SHADER_DIR "shadow.vert", vk::ShaderStageFlagBits::eVertex);
+
+  vkwave::ShaderReflection reflection;
+  reflection.set_debug(true);
+  reflection.add_stage(vert.spirv, vk::ShaderStageFlagBits::eVertex);
+  reflection.finalize();
+
+  CHECK(reflection.descriptor_set_infos().empty());
+  reflection.validate_push_constant_size(sizeof(vkwave::ShadowPushConstants));
+}
+
+TEST_CASE("vkwave::pipeline::cascade_splits_are_increasing_and_end_at_far", "[pipeline]")
+{
+  for (float lambda : { 0.0f, 0.5f, 1.0f })
+  {
+    auto splits = vkwave::cascade_split_distances(0.1f, 100.0f, lambda);
+    float prev = 0.1f;
+    for (float split : splits)
+    {
+      CHECK(split > prev);
+      prev = split;
+    }
+    CHECK(splits.back() == 100.0f);
+  }
+}
+
+// --- Temporal AA tests ---
+
+TEST_CASE("vkwave::pipeline::reflection_extracts_taa_layout", "[pipeline]")
+{
+  auto compiler = vkwave::ShaderCompiler::get();
+  auto comp = compiler->compile(
+    TEST_SHADER_DIR "taa.comp", vk::ShaderStageFlagBits::eCompute);
+
+  vkwave::ShaderReflection reflection;
+  reflection.set_debug(true);
+  reflection.add_stage(comp.spirv, vk::ShaderStageFlagBits::eCompute);
+  reflection.finalize();
+
+  auto& sets = reflection.descriptor_set_infos();
+  REQUIRE(sets.size() == 1);
+  REQUIRE(sets[0].bindings.size() == 4);
+  for (uint32_t b = 0; b < 3; ++b)
+    CHECK(sets[0].bindings[b].type == vk::DescriptorType::eCombinedImageSampler);
+  CHECK(sets[0].bindings[3].type == vk::DescriptorType::eStorageImage);
+  reflection.validate_push_constant_size(sizeof(vkwave::TaaPushConstants));
+}
+
+TEST_CASE("vkwave::pipeline::taa_jitter_stays_inside_one_pixel", "[pipeline]")
+{
+  const vk::Extent2D extent{ 1280, 720 };
+  for (uint32_t frame = 0; frame < vkwave::kTaaJitterPhases; ++frame)
+  {
+    auto j = vkwave::taa_jitter(frame, extent);
+    CHECK(std::abs(j.x) * extent.width <= 1.0f);
+    CHECK(std::abs(j.y) * extent.height <= 1.0f);
+    CHECK(j != vkwave::taa_jitter(frame + 1, extent));
+  }
+  CHECK(vkwave::taa_jitter(0, extent) == vkwave::taa_jitter(vkwave::kTaaJitterPhases, extent));
+}
+
+// --- Ambient occlusion tests ---
+
+TEST_CASE("vkwave::pipeline::reflection_extracts_gtao_layout", "[pipeline]")
+{
+  auto compiler = vkwave::ShaderCompiler::get();
+  auto gtao = compiler->compile(
+    TEST_SHADER_DIR "gtao.comp", vk::ShaderStageFlagBits::eCompute,
+    "#define SLICE_COUNT 2\n#define STEPS_PER_SIDE 4\n");
+
+  vkwave::ShaderReflection reflection;
+  reflection.set_debug(true);
+  reflection.add_stage(gtao.spirv, vk::ShaderStageFlagBits::eCompute);
+  reflection.finalize();
+
+  auto& sets = reflection.descriptor_set_infos();
+  REQUIRE(sets.size() == 1);
+  REQUIRE(sets[0].bindings.size() == 2);
+  CHECK(sets[0].bindings[0].type == vk::DescriptorType::eCombinedImageSampler);
+  CHECK(sets[0].bindings[1].type == vk::DescriptorType::eStorageImage);
+  reflection.validate_push_constant_size(sizeof(vkwave::GtaoPushConstants));
+
+  auto resolve = compiler->compile(
+    TEST_SHADER_DIR "ao_resolve.comp", vk::ShaderStageFlagBits::eCompute);
+  vkwave::ShaderReflection resolve_reflection;
+  resolve_reflection.add_stage(resolve.spirv, vk::ShaderStageFlagBits::eCompute);
+  resolve_reflection.finalize();
+  auto& resolve_sets = resolve_reflection.descriptor_set_infos();
+  REQUIRE(resolve_sets.size() == 1);
+  REQUIRE(resolve_sets[0].bindings.size() == 5);
+  CHECK(resolve_sets[0].bindings[4].type == vk::DescriptorType::eStorageImage);
+  resolve_reflection.validate_push_constant_size(sizeof(vkwave::AoResolvePushConstants));
+}
+
+TEST_CASE("vkwave::pipeline::ao_depth_params_linearize_reversed_z", "[pipeline]")
+{
+  // Reversed-Z infinite perspective, near plane 0.1: depth = near / distance.
+  const float near = 0.1f;
+  glm::mat4 proj(0.0f);
+  proj[0][0] = 1.0f;
+  proj[1][1] = -1.0f;
+  proj[2][3] = -1.0f;
+  proj[3][2] = near;
+  const glm::vec4 p = vkwave::view_depth_params(glm::inverse(proj));
+  for (float dist : { 0.1f, 1.0f, 25.0f, 1000.0f })
+  {
+    const float d = near / dist;
+    CHECK(std::abs((p.x * d + p.y) / (p.z * d + p.w) + dist) < 1e-3f * dist);
+  }
+
+  CHECK(vkwave::gtao_extent({ 1920, 1080 }).width == 960);
+  CHECK(vkwave::gtao_extent({ 1281, 721 }).height == 361);
+  CHECK(vkwave::gtao_extent({ 1, 1 }).width == 1);
+}
+
+// --- Acceleration structure tests ---
+
+TEST_CASE("vkwave::pipeline::blas_scratch_ranges_are_aligned_and_disjoint", "[pipeline]")
+{
+  const std::vector<vk::DeviceSize> sizes{ 1000, 256, 1, 4096 };
+  const auto offsets = vkwave::pack_scratch(sizes, 256);
+  REQUIRE(offsets.size() == sizes.size() + 1);
+  for (size_t i = 0; i < sizes.size(); ++i)
+  {
+    CHECK(offsets[i] % 256 == 0);
+    CHECK(offsets[i] + sizes[i] <= offsets[i + 1]);
+  }
+  CHECK(offsets.back() == 1024 + 256 + 256 + 4096);
+  CHECK(vkwave::pack_scratch({}, 128) == std::vector<vk::DeviceSize>{ 0 });
+}
+
+TEST_CASE("vkwave::pipeline::tlas_refits_until_the_refit_budget", "[pipeline]")
+{
+  using vkwave::TlasBuild;
+  CHECK(vkwave::choose_tlas_build(false, false, 0, 8) == TlasBuild::none);
+  CHECK(vkwave::choose_tlas_build(false, true, 0, 8) == TlasBuild::refit);
+  CHECK(vkwave::choose_tlas_build(false, true, 7, 8) == TlasBuild::refit);
+  CHECK(vkwave::choose_tlas_build(false, true, 8, 8) == TlasBuild::rebuild);
+  CHECK(vkwave::choose_tlas_build(true, false, 0, 8) == TlasBuild::rebuild);
+  CHECK(vkwave::choose_tlas_build(true, true, 3, 8) == TlasBuild::rebuild);
+  CHECK(vkwave::choose_tlas_build(false, true, 0, 0) == TlasBuild::rebuild);
+}
+
+// What PersistentTlas::record() builds, frame by frame, as the scene moves its
+// instances.
+TEST_CASE("vkwave::pipeline::tlas_state_refits_moved_instances", "[pipeline]")
+{
+  using vkwave::TlasBuild;
+  vkwave::TlasBuildState state(2);
+  CHECK(state.reserve(3) == 3);
+  const uint32_t generation = state.generation();
+  state.set_instances(3);
+
+  // A new set builds once, then idles until something moves.
+  CHECK(state.next() == TlasBuild::rebuild);
+  state.built(state.next());
+  CHECK(state.next() == TlasBuild::none);
+
+  // Moved instances refit in place until the refit budget is spent.
+  state.set_transform(1);
+  CHECK(state.next() == TlasBuild::refit);
+  state.built(state.next());
+  state.set_transform(2);
+  CHECK(state.next() == TlasBuild::refit);
+  state.built(state.next());
+  CHECK(state.refits() == 2);
+  state.set_transform(0);
+  CHECK(state.next() == TlasBuild::rebuild);
+  state.built(state.next());
+  CHECK(state.refits() == 0);
+
+  // A moved instance past the set is an error, and dirties nothing.
+  CHECK_THROWS_AS(state.set_transform(3), std::out_of_range);
+  CHECK(state.next() == TlasBuild::none);
+
+  // Smaller sets fit; a larger one reallocates (new handle, new generation)
+  // and must build in full even though only transforms were set since.
+  CHECK(state.reserve(2) == 0);
+  state.set_instances(2);
+  state.built(state.next());
+  CHECK(state.generation() == generation);
+  CHECK(state.reserve(4) == 6);
+  CHECK(state.generation() == generation + 1);
+  state.set_instances(4);
+  state.built(TlasBuild::rebuild);
+  state.set_transform(3);
+  CHECK(state.next() == TlasBuild::refit);
+  CHECK(state.reserve(7) == 12);
+  CHECK(state.next() == TlasBuild::rebuild);
+}
+
+// --- Ray tracing pipeline tests ---
+
+TEST_CASE("vkwave::pipeline::sbt_regions_are_aligned", "[pipeline]")
+{
+  const auto sbt = vkwave::shader_binding_table_layout(32, 32, 64, 2, 3);
+  CHECK(sbt.record_stride == 32);
+  CHECK(sbt.raygen_size == 64);
+  CHECK(sbt.miss_offset == 64);
+  CHECK(sbt.miss_size == 64);
+  CHECK(sbt.hit_offset == 128);
+  CHECK(sbt.hit_size == 128);
+  CHECK(sbt.total_size == 256);
+
+  // Handles smaller than their alignment still take a whole record.
+  CHECK(vkwave::shader_binding_table_layout(20, 32, 64, 1, 1).record_stride == 32);
+}
+
+TEST_CASE("vkwave::pipeline::sbt_hit_records_follow_instance_offsets", "[pipeline]")
+{
+  // The scene TLAS writes hit_group_of(material) into each instance's SBT
+  // offset and rt_primary.rgen traces with stride 1: a material type's record
+  // is hit_offset + type * record_stride, aligned and inside the hit region.
+  constexpr auto count = static_cast<uint32_t>(vkwave::MaterialHitGroup::count);
+  const auto sbt = vkwave::shader_binding_table_layout(32, 32, 64, 1, count);
+  CHECK(sbt.hit_offset % 64 == 0);
+  CHECK(sbt.hit_size == count * sbt.record_stride);
+  for (uint32_t group = 0; group < count; ++group)
+  {
+    const vk::DeviceSize record = sbt.hit_offset + group * sbt.record_stride;
+    CHECK(record % 32 == 0);
+    CHECK(record >= sbt.miss_offset + sbt.miss_size);
+    CHECK(record + sbt.record_stride <= sbt.hit_offset + sbt.hit_size);
+    CHECK(record + sbt.record_stride <= sbt.total_size);
+  }
+}
+
+TEST_CASE("vkwave::pipeline::rt_primitive_table_indexes_instances", "[pipeline]")
+{
+  // Entry i is read by TLAS instance i (its custom index).
+  std::vector<vkwave::ScenePrimitive> primitives(2);
+  primitives[0].firstIndex = 0;
+  primitives[0].vertexOffset = 0;
+  primitives[0].materialIndex = 3;
+  primitives[1].firstIndex = 36;
+  primitives[1].vertexOffset = -4;
+  primitives[1].materialIndex = 1;
+
+  const auto table = vkwave::ray_tracing_primitive_table(primitives);
+  REQUIRE(table.size() == 2);
+  CHECK(table[0] == glm::uvec4(0u, 0u, 3u, 0u));
+  CHECK(table[1].x == 36u);
+  CHECK(static_cast<int32_t>(table[1].y) == -4);
+  CHECK(table[1].z == 1u);
+
+  // The legacy single mesh: one entry, drawn whole with material 0.
+  const auto legacy = vkwave::ray_tracing_primitive_table({});
+  REQUIRE(legacy.size() == 1);
+  CHECK(legacy[0] == glm::uvec4(0u));
+}
+
+TEST_CASE("vkwave::pipeline::rt_primary_output_takes_selected_format", "[pipeline]")
+{
+  // scene_spec() compiles the output format into outImage (set 0, binding 1):
+  // a compact B10G11R11 HDR must not get an rgba16f view.
+  auto compiler = vkwave::ShaderCompiler::get();
+  const auto spec = vkwave::RayTracingPipeline::scene_spec(vk::Format::eB10G11R11UfloatPack32);
+  const auto result = compiler->compile(spec.raygen, vk::ShaderStageFlagBits::eRaygenKHR,
+    spec.preamble);
+
+  SpvReflectShaderModule module{};
+  REQUIRE(spvReflectCreateShaderModule(result.spirv.size() * sizeof(uint32_t),
+    result.spirv.data(), &module) == SPV_REFLECT_RESULT_SUCCESS);
+  SpvReflectResult status = SPV_REFLECT_RESULT_SUCCESS;
+  const auto* output = spvReflectGetDescriptorBinding(&module, 1, 0, &status);
+  const SpvImageFormat format = output ? output->image.image_format : SpvImageFormatUnknown;
+  spvReflectDestroyShaderModule(&module);
+  CHECK(format == SpvImageFormatR11fG11fB10f);
+}
+
+TEST_CASE("vkwave::pipeline::reflection_merges_rt_hit_group_stages", "[pipeline]")
+{
+  auto compiler = vkwave::ShaderCompiler::get();
+  const auto spec = vkwave::RayTracingPipeline::scene_spec(vk::Format::eR16G16B16A16Sfloat);
+  REQUIRE(spec.hit_groups.size() == static_cast<size_t>(vkwave::MaterialHitGroup::count));
+  const auto& alpha_test = spec.hit_groups[static_cast<size_t>(vkwave::MaterialHitGroup::alpha_test)];
+
+  vkwave::ShaderReflection reflection;
+  reflection.add_stage(
+    compiler->compile(spec.raygen, vk::ShaderStageFlagBits::eRaygenKHR, spec.preamble).spirv,
+    vk::ShaderStageFlagBits::eRaygenKHR);
+  reflection.add_stage(compiler->compile(spec.miss[0], vk::ShaderStageFlagBits::eMissKHR).spirv,
+    vk::ShaderStageFlagBits::eMissKHR);
+  reflection.add_stage(
+    compiler->compile(alpha_test.closest_hit, vk::ShaderStageFlagBits::eClosestHitKHR).spirv,
+    vk::ShaderStageFlagBits::eClosestHitKHR);
+  reflection.add_stage(compiler->compile(alpha_test.any_hit, vk::ShaderStageFlagBits::eAnyHitKHR).spirv,
+    vk::ShaderStageFlagBits::eAnyHitKHR);
+  reflection.finalize();
+
+  auto& sets = reflection.descriptor_set_infos();
+  REQUIRE(sets.size() == 1);
+  REQUIRE(sets[0].bindings.size() == 7);
+  CHECK(sets[0].bindings[0].type == vk::DescriptorType::eAccelerationStructureKHR);
+  CHECK(sets[0].bindings[2].stageFlags == vk::ShaderStageFlagBits::eMissKHR);
+  // Both stages of the alpha-test group read the material.
+  CHECK(sets[0].bindings[6].stageFlags ==
+    (vk::ShaderStageFlagBits::eClosestHitKHR | vk::ShaderStageFlagBits::eAnyHitKHR));
+
+  auto& ranges = reflection.push_constant_ranges();
+  REQUIRE(ranges.size() == 1);
+  CHECK(ranges[0].stageFlags == vk::ShaderStageFlagBits::eRaygenKHR);
+  CHECK(ranges[0].size == sizeof(vkwave::RtPrimaryPushConstants));
+
+  vkwave::SceneMaterial masked;
+  masked.alphaMode = vkwave::AlphaMode::Mask;
+  CHECK(vkwave::RayTracingPipeline::hit_group_of(masked) == vkwave::MaterialHitGroup::alpha_test);
+  CHECK(vkwave::RayTracingPipeline::hit_group_of({}) == vkwave::MaterialHitGroup::opaque);
+}
+
+// --- Reference path tracer tests ---
+
+// A closed unit box (outward normals) around the origin, one white material.
+static vkwave::PathTracer make_white_box(const vkwave::SceneMaterial& material)
+{
+  std::vector<vkwave::Vertex> vertices;
+  std::vector<uint32_t> indices;
+  for (int axis = 0; axis < 3; ++axis)
+  {
+    for (float side : { -1.0f, 1.0f })
+    {
+      const auto base = static_cast<uint32_t>(vertices.size());
+      for (int corner = 0; corner < 4; ++corner)
+      {
+        vkwave::Vertex vertex;
+        vertex.position[axis] = 0.5f * side;
+        vertex.position[(axis + 1) % 3] = (corner & 1) ? 0.5f : -0.5f;
+        vertex.position[(axis + 2) % 3] = (corner & 2) ? 0.5f : -0.5f;
+        vertex.normal = glm::vec3(0.0f);
+        vertex.normal[axis] = side;
+        vertices.push_back(vertex);
+      }
+      indices.insert(indices.end(), { base, base + 1, base + 3, base, base + 3, base + 2 });
+    }
+  }
+  const vkwave::ScenePrimitive box{ 0, static_cast<uint32_t>(indices.size()), 0, 0,
+    glm::mat4(1.0f) };
+  return vkwave::PathTracer(vertices, indices, { &box, 1 }, { &material, 1 });
+}
+
+TEST_CASE("vkwave::pipeline::path_tracer_white_furnace", "[pipeline]")
+{
+  vkwave::SceneMaterial white;
+  white.metallicFactor = 0.0f;
+  white.roughnessFactor = 1.0f;
+  auto tracer = make_white_box(white);
+
+  vkwave::Camera camera;
+  camera.set_position(0.0f, 0.0f, 3.0f);
+  camera.set_view_angle(30.0f);
+  vkwave::PathTracer::Settings settings;
+  settings.samples_per_pixel = 64;
+  settings.threads = 2;
+  settings.tile_size = 4;
+  constexpr uint32_t kSize = 16;
+  // The centre 4x4 pixels see the box's front face, the corners the sky.
+  auto centre = [&](const std::vector<float>& image, auto&& check) {
+    for (uint32_t y = 6; y < 10; ++y)
+      for (uint32_t x = 6; x < 10; ++x)
+        for (uint32_t c = 0; c < 3; ++c)
+          check(image[(y * kSize + x) * 4 + c]);
+  };
+
+  // Lit head-on by the sun alone: the face is Lambertian (about 1/pi) and the
+  // black sky stays black.
+  settings.sun_direction = glm::vec3(0.0f, 0.0f, 1.0f);
+  settings.sun_radiance = glm::vec3(1.0f);
+  const auto lit = tracer.render(camera, kSize, kSize, settings);
+  centre(lit, [](float v) { CHECK((v > 0.25f && v < 0.35f)); });
+  CHECK(lit[0] == 0.0f);
+
+  // Under a uniform unit sky every path leaves the convex box after one
+  // bounce with albedo 1, so the box converges to the sky's radiance (less
+  // the single-scattering specular layer's loss, ~2%).
+  vkwave::EquirectImage sky;
+  sky.width = 8;
+  sky.height = 4;
+  sky.rgba.assign(sky.width * sky.height * 4, 1.0f);
+  tracer.set_environment(&sky);
+  settings.sun_radiance = glm::vec3(0.0f);
+  const auto furnace = tracer.render(camera, kSize, kSize, settings);
+  double sum = 0.0;
+  centre(furnace, [&](float v) { sum += v; });
+  const double mean = sum / (4 * 4 * 3);
+  CHECK((mean > 0.95 && mean < 1.02));
+  CHECK(furnace[0] == 1.0f);
+
+  // Every pixel seeds its own sequence: the thread count changes nothing.
+  settings.threads = 1;
+  const auto diff = vkwave::compare_images(furnace, tracer.render(camera, kSize, kSize, settings));
+  CHECK(diff.max_error == 0.0f);
+}
+
+TEST_CASE("vkwave::pipeline::compare_images_ignores_alpha", "[pipeline]")
+{
+  const std::vector<float> a = { 0.0f, 0.5f, 1.0f, 1.0f, 2.0f, 2.0f, 2.0f, 1.0f };
+  auto same = vkwave::compare_images(a, a);
+  CHECK(same.rmse == 0.0);
+  CHECK(same.max_error == 0.0f);
+
+  // Every colour channel off by 0.25, alpha by more (not compared).
+  std::vector<float> offset = a;
+  for (size_t i = 0; i < offset.size(); ++i)
+    offset[i] += (i % 4 == 3) ? 5.0f : 0.25f;
+  auto diff = vkwave::compare_images(a, offset);
+  CHECK(std::abs(diff.rmse - 0.25) < 1e-6);
+  CHECK(diff.max_error == 0.25f);
+
+  // One brighter channel: the max is that channel, the RMSE its share.
+  offset = a;
+  offset[4] += 0.6f;
+  diff = vkwave::compare_images(a, offset);
+  CHECK(std::abs(diff.rmse - std::sqrt(0.36 / 6.0)) < 1e-6);
+  CHECK(std::abs(diff.max_error - 0.6f) < 1e-6f);
+
+  const std::vector<float> smaller(a.begin(), a.begin() + 4);
+  CHECK_THROWS_AS(vkwave::compare_images(a, smaller), std::runtime_error);
+  const std::vector<float> ragged(a.begin(), a.begin() + 6);
+  CHECK_THROWS_AS(vkwave::compare_images(ragged, ragged), std::runtime_error);
+}
+
+// --- Single-pass mip downsample tests ---
+
+TEST_CASE("vkwave::pipeline::reflection_extracts_spd_layout", "[pipeline]")
+{
+  auto compiler = vkwave::ShaderCompiler::get();
+  auto comp = compiler->compile(
+    TEST_SHADER_DIR "spd_downsample.comp", vk::ShaderStageFlagBits::eCompute);
+
+  vkwave::ShaderReflection reflection;
+  reflection.set_debug(true);
+  reflection.add_stage(comp.spirv, vk::ShaderStageFlagBits::eCompute);
+  reflection.finalize();
+
+  auto& sets = reflection.descriptor_set_infos();
+  REQUIRE(sets.size() == 1);
+  REQUIRE(sets[0].bindings.size() == 4);
+  CHECK(sets[0].bindings[0].type == vk::DescriptorType::eCombinedImageSampler);
+  CHECK(sets[0].bindings[1].type == vk::DescriptorType::eStorageImage);
+  CHECK(sets[0].bindings[1].count == vkwave::kSpdMaxMips);
+  CHECK(sets[0].bindings[2].type == vk::DescriptorType::eStorageImage);
+  CHECK(sets[0].bindings[3].type == vk::DescriptorType::eStorageBuffer);
+  reflection.validate_push_constant_size(sizeof(vkwave::SpdPushConstants));
+}
+
+TEST_CASE("vkwave::pipeline::spd_mip_count_caps_large_targets", "[pipeline]")
+{
+  CHECK(vkwave::spd_mip_count({ 1920, 1080 }, 11) == 11);
+  CHECK(vkwave::spd_mip_count({ 4096, 4096 }, 13) == 13);
+  CHECK(vkwave::spd_mip_count({ 8192, 4320 }, 14) == 7);
+  CHECK(vkwave::spd_mip_count({ 32, 32 }, 6) == 6);
+}
+
+// --- Post-FX tests ---
+
+TEST_CASE("vkwave::pipeline::reflection_extracts_bloom_layout", "[pipeline]")
+{
+  auto compiler = vkwave::ShaderCompiler::get();
+  auto comp = compiler->compile(
+    TEST_SHADER_DIR "bloom.comp", vk::ShaderStageFlagBits::eCompute);
+
+  vkwave::ShaderReflection reflection;
+  reflection.add_stage(comp.spirv, vk::ShaderStageFlagBits::eCompute);
+  reflection.finalize();
+
+  auto& sets = reflection.descriptor_set_infos();
+  REQUIRE(sets.size() == 1);
+  REQUIRE(sets[0].bindings.size() == 2);
+  CHECK(sets[0].bindings[0].type == vk::DescriptorType::eCombinedImageSampler);
+  CHECK(sets[0].bindings[1].type == vk::DescriptorType::eStorageImage);
+  reflection.validate_push_constant_size(sizeof(vkwave::BloomPushConstants));
+}
+
+TEST_CASE("vkwave::pipeline::post_fx_plan_ends_in_the_hdr", "[pipeline]")
+{
+  using vkwave::PostFxIo;
+  // In-place passes never leave the HDR.
+  auto plan = vkwave::plan_post_fx(std::vector{ PostFxIo::in_place, PostFxIo::in_place });
+  CHECK(plan.writes_scratch == std::vector<bool>{ false, false });
+  CHECK_FALSE(plan.copy_back);
+
+  // One ping-pong moves the chain to the scratch; the result is copied back.
+  plan = vkwave::plan_post_fx(
+    std::vector{ PostFxIo::in_place, PostFxIo::ping_pong, PostFxIo::in_place });
+  CHECK(plan.writes_scratch == std::vector<bool>{ false, true, true });
+  CHECK(plan.copy_back);
+
+  // Two ping-pongs come back by themselves.
+  plan = vkwave::plan_post_fx(std::vector{ PostFxIo::ping_pong, PostFxIo::ping_pong });
+  CHECK(plan.writes_scratch == std::vector<bool>{ true, false });
+  CHECK_FALSE(plan.copy_back);
+
+  CHECK(vkwave::plan_post_fx({}).writes_scratch.empty());
+}
+
+TEST_CASE("vkwave::pipeline::bloom_levels_stop_at_two_texels", "[pipeline]")
+{
+  CHECK(vkwave::bloom_levels({ 1920, 1080 }, 11) == vkwave::kBloomMaxLevels);
+  CHECK(vkwave::bloom_levels({ 8, 8 }, 4) == 2);     // 4x4, 2x2
+  CHECK(vkwave::bloom_levels({ 1920, 1080 }, 3) == 2); // image mips
+  CHECK(vkwave::bloom_levels({ 3, 3 }, 2) == 0);
+}
+
 // --- Pass-dependency DAG topological ordering (F1) ---
 
 TEST_CASE("vkwave::pipeline::topo_order_no_edges_is_identity", "[pipeline]")
@@ -5,6 +5,8 @@
 #include <vkwave/pipeline/shader_compiler.h>
 #include <vkwave/pipeline/shader_reflection.h>
 
+#include <spirv_reflect.h>
+
 static auto g_compiler = vkwave::ShaderCompiler::create();
 
 // --- Compile: debug x optimization matrix ---
@@ -57,6 +59,50 @@ TEST_CASE("vkwave::shader::compile_debug_and_opt", "[shader]")
   compiler->set_optimization(false);
 }
 
+// --- Compile: preamble ---
+
+/// Storage image format of (set, binding) in `spirv`.
+static SpvImageFormat image_format(const std::vector<uint32_t>& spirv, uint32_t set,
+  uint32_t binding)
+{
+  SpvReflectShaderModule module{};
+  REQUIRE(spvReflectCreateShaderModule(spirv.size() * sizeof(uint32_t), spirv.data(), &module)
+    == SPV_REFLECT_RESULT_SUCCESS);
+  SpvReflectResult result = SPV_REFLECT_RESULT_SUCCESS;
+  const auto* info = spvReflectGetDescriptorBinding(&module, binding, set, &result);
+  const SpvImageFormat format = info ? info->image.image_format : SpvImageFormatUnknown;
+  spvReflectDestroyShaderModule(&module);
+  return format;
+}
+
+TEST_CASE("vkwave::shader::compile_with_preamble", "[shader]")
+{
+  // The storage format of a target picked at runtime (B10G11R11 HDR). The
+  // shader falls back to rgba16f without the define, so the preamble must
+  // show in the compiled hdrImage (set 0, binding 2).
+  auto compiler = vkwave::ShaderCompiler::get();
+  compiler->set_debug_info(false);
+  compiler->set_optimization(false);
+  auto plain = compiler->compile(TEST_SHADER_DIR "oit_resolve.comp",
+    vk::ShaderStageFlagBits::eCompute);
+  auto result = compiler->compile(TEST_SHADER_DIR "oit_resolve.comp",
+    vk::ShaderStageFlagBits::eCompute, "#define IMAGE_FORMAT r11f_g11f_b10f\n");
+  CHECK(image_format(plain.spirv, 0, 2) == SpvImageFormatRgba16f);
+  CHECK(image_format(result.spirv, 0, 2) == SpvImageFormatR11fG11fB10f);
+}
+
+TEST_CASE("vkwave::shader::taa_output_takes_selected_format", "[shader]")
+{
+  // TemporalAA compiles the format ScenePipeline selected for the output
+  // (ColorPrecision::hdr_rgba) into outColor (set 0, binding 3).
+  auto compiler = vkwave::ShaderCompiler::get();
+  compiler->set_debug_info(false);
+  compiler->set_optimization(false);
+  auto result = compiler->compile(TEST_SHADER_DIR "taa.comp",
+    vk::ShaderStageFlagBits::eCompute, "#define IMAGE_FORMAT r11f_g11f_b10f\n");
+  CHECK(image_format(result.spirv, 0, 3) == SpvImageFormatR11fG11fB10f);
+}
+
 // --- Reflection: validation gated by debug flag ---
 
 TEST_CASE("vkwave::shader::reflection_validate_skips_when_debug_off", "[shader]")